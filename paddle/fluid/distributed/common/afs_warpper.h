@@ -66,6 +66,14 @@ class FsReadChannel {
     return 0;
   }
 
+  // read size bytes of a binary file, -1 if the file ends before
+  inline uint32_t read(void* data, size_t size) {
+    if (fread_unlocked(data, 1, size, _file.get()) != size) {
+      return -1;
+    }
+    return 0;
+  }
+
  private:
   uint32_t _buffer_size;
   FsChannelConfig _config;
@@ -114,6 +122,14 @@ class FsWriteChannel {
     return write_line(data.c_str(), data.size());
   }
 
+  // write size bytes of a binary file, without the line break
+  inline uint32_t write(const void* data, size_t size) {
+    if (fwrite_unlocked(data, 1, size, _file.get()) != size) {
+      return -1;
+    }
+    return 0;
+  }
+
  private:
   uint32_t _buffer_size;
   FsChannelConfig _config;
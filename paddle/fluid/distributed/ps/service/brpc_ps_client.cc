@@ -78,6 +78,19 @@ DEFINE_int32(pserver_sparse_table_shard_num,
              1000,
              "sparse table shard for save & load");
 
+DEFINE_bool(pserver_push_sparse_cache,
+            false,
+            "merge the push_sparse values of the same keys across requests "
+            "on the worker before sending them");
+
+DEFINE_int32(pserver_push_sparse_cache_max_keys,
+             1000000,
+             "flush the push_sparse cache of a table at this key num");
+
+DEFINE_int32(pserver_push_sparse_cache_max_age_ms,
+             1000,
+             "flush the push_sparse cache of a table at this age");
+
 inline size_t get_sparse_shard(uint32_t shard_num,
                                uint32_t server_num,
                                uint64_t key) {
@@ -342,6 +355,11 @@ int32_t BrpcPsClient::Initialize() {
       _push_sparse_task_queue_map[table_id] =
           paddle::framework::MakeChannel<SparseAsyncTask *>();
       _push_sparse_merge_count_map[table_id] = 0;
+      if (FLAGS_pserver_push_sparse_cache) {
+        _push_sparse_cache_map[table_id].reset(new SparsePushCache(
+            GetTableAccessor(table_id), _server_channels.size()));
+        _push_sparse_cache_task_num_map[table_id] = 0;
+      }
     }
   }
 
@@ -356,6 +374,7 @@ int32_t BrpcPsClient::Initialize() {
   profiler.register_profiler("pserver_client_push_sparse");
   profiler.register_profiler("pserver_client_push_sparse_merge");
   profiler.register_profiler("pserver_client_push_sparse_rpc");
+  profiler.register_profiler("pserver_client_push_sparse_cache_flush");
   profiler.register_profiler("pserver_client_push_dense");
   profiler.register_profiler("pserver_client_push_dense_parse");
   profiler.register_profiler("push_dense_put");
@@ -679,6 +698,7 @@ std::future<int32_t> BrpcPsClient::CheckSavePrePatchDone() {
 
 std::future<int32_t> BrpcPsClient::Flush() {
   VLOG(0) << "BrpcPsClient::flush begin";
+  FlushPushSparseCaches();
   _flushing = true;
   std::promise<int> promise;
   std::future<int32_t> fut = promise.get_future();
@@ -702,6 +722,15 @@ void BrpcPsClient::PrintQueueSize() {
             << " size: " << queue_size;
   }
 
+  for (auto &cache_itr : _push_sparse_cache_map) {
+    auto *cache = cache_itr.second.get();
+    VLOG(0) << "BrpcPsClient::PrintQueueSize: push sparse cache of table "
+            << cache_itr.first << " size: " << cache->Size()
+            << " added keys: " << cache->AddedKeys()
+            << " pushed keys: " << cache->DrainedKeys()
+            << " merge ratio: " << cache->MergeRatio();
+  }
+
   for (auto &task_queue_itr : _push_dense_task_queue_map) {
     auto table_id = task_queue_itr.first;
     auto queue_size = task_queue_itr.second->Size();
@@ -745,6 +774,12 @@ std::future<int32_t> BrpcPsClient::StopProfiler() {
 
 std::future<int32_t> BrpcPsClient::Barrier(size_t table_id,
                                            uint32_t barrier_type) {
+  // the cached gradients belong to the steps before the barrier, they reach
+  // the servers before the barrier does
+  if (!_push_sparse_cache_map.empty()) {
+    FlushPushSparseCaches();
+    WaitPushSparseCaches();
+  }
   return SendCmd(table_id, PS_BARRIER, {std::to_string(barrier_type)});
 }
 
@@ -1103,6 +1138,45 @@ std::future<int32_t> BrpcPsClient::PushDenseRawGradient(
   return fut;
 }
 
+std::future<int32_t> BrpcPsClient::PushFusedDenseRawGradients(
+    const std::vector<uint32_t> &table_ids,
+    const std::vector<float *> &datas,
+    const std::vector<size_t> &sizes,
+    DenseCompressType compress_type,
+    void *done) {
+  size_t request_call_num = _server_channels.size();
+  DownpourBrpcClosure *closure = reinterpret_cast<DownpourBrpcClosure *>(done);
+  auto promise = std::make_shared<std::promise<int32_t>>();
+  closure->add_promise(promise);
+  std::future<int> fut = promise->get_future();
+  std::vector<uint32_t> num_per_shard(table_ids.size());
+  for (size_t t = 0; t < table_ids.size(); ++t) {
+    auto *accessor = GetTableAccessor(table_ids[t]);
+    num_per_shard[t] = DenseDimPerShard(accessor->GetAccessorInfo().fea_dim,
+                                        request_call_num);
+    CHECK(num_per_shard[t] * request_call_num <= sizes[t])
+        << "invalid dense size of table " << table_ids[t] << ", size["
+        << sizes[t] << "]";
+  }
+  for (size_t i = 0; i < request_call_num; ++i) {
+    closure->request(i)->set_cmd_id(PS_PUSH_DENSE_TABLES);
+    closure->request(i)->set_table_id(table_ids[0]);
+    closure->request(i)->set_client_id(_client_id);
+    // every server receives its shard of all the tables in one message
+    FusedDenseWriter writer(compress_type,
+                            closure->request(i)->mutable_data());
+    for (size_t t = 0; t < table_ids.size(); ++t) {
+      writer.Append(table_ids[t],
+                    datas[t] + i * num_per_shard[t],
+                    num_per_shard[t]);
+    }
+    PsService_Stub rpc_stub(GetDenseChannel(i));
+    rpc_stub.service(
+        closure->cntl(i), closure->request(i), closure->response(i), closure);
+  }
+  return fut;
+}
+
 std::future<int32_t> BrpcPsClient::PushGlobalStep(int table_id,
                                                   int64_t *total_send_data,
                                                   void *done) {
@@ -1259,6 +1333,62 @@ std::future<int32_t> BrpcPsClient::PullSparse(float **select_values,
   return fut;
 }
 
+std::future<int32_t> BrpcPsClient::PrefetchSparse(size_t table_id,
+                                                  const uint64_t *keys,
+                                                  size_t num) {
+  size_t request_call_num = _server_channels.size();
+  const auto &server_param = _config.server_param().downpour_server_param();
+  uint64_t shard_num = FLAGS_pserver_sparse_table_shard_num;
+  for (int i = 0; i < server_param.downpour_table_param_size(); ++i) {
+    const auto &table_param = server_param.downpour_table_param(i);
+    if (table_param.table_id() == table_id) {
+      shard_num = table_param.shard_num();
+      break;
+    }
+  }
+  std::vector<std::vector<uint64_t>> ids(request_call_num);
+  for (size_t i = 0; i < num; ++i) {
+    size_t shard_id = get_sparse_shard(shard_num, request_call_num, keys[i]);
+    ids[shard_id].push_back(keys[i]);
+  }
+
+  DownpourBrpcClosure *closure = new DownpourBrpcClosure(
+      request_call_num, [request_call_num](void *done) {
+        int ret = 0;
+        auto *closure = reinterpret_cast<DownpourBrpcClosure *>(done);
+        for (size_t i = 0; i < request_call_num; ++i) {
+          if (closure->check_response(i, PS_PREFETCH_SPARSE_TABLE) != 0) {
+            ret = -1;
+            break;
+          }
+        }
+        closure->set_promise_value(ret);
+      });
+  auto promise = std::make_shared<std::promise<int32_t>>();
+  closure->add_promise(promise);
+  std::future<int> fut = promise->get_future();
+  for (size_t shard_idx = 0; shard_idx < request_call_num; ++shard_idx) {
+    uint32_t kv_size = ids[shard_idx].size();
+    auto *request = closure->request(shard_idx);
+    request->set_cmd_id(PS_PREFETCH_SPARSE_TABLE);
+    request->set_table_id(table_id);
+    request->set_client_id(_client_id);
+    request->add_params((char *)&kv_size, sizeof(uint32_t));  // NOLINT
+    request->set_data(reinterpret_cast<char *>(ids[shard_idx].data()),
+                      kv_size * sizeof(uint64_t));
+    PsService_Stub rpc_stub(GetCmdChannel(shard_idx));
+    // promoting from ssd may take long for a whole pass of keys
+    closure->cntl(shard_idx)->set_timeout_ms(10800000);
+    closure->cntl(shard_idx)->set_request_compress_type(
+        (brpc::CompressType)FLAGS_pserver_communicate_compress_type);
+    rpc_stub.service(closure->cntl(shard_idx),
+                     closure->request(shard_idx),
+                     closure->response(shard_idx),
+                     closure);
+  }
+  return fut;
+}
+
 // for GEO
 std::future<int32_t> BrpcPsClient::PullSparseParam(float **select_values,
                                                    size_t table_id,
@@ -1561,6 +1691,24 @@ std::future<int32_t> BrpcPsClient::PushSparse(size_t table_id,
     size_t shard_id = get_sparse_shard(shard_num, request_call_num, keys[i]);
     shard_sorted_kv_list[shard_id].push_back({keys[i], update_values[i]});
   }
+
+  auto cache_itr = _push_sparse_cache_map.find(table_id);
+  if (cache_itr != _push_sparse_cache_map.end()) {
+    // merged into the cache, sent by a later flush of it
+    auto *cache = cache_itr->second.get();
+    for (size_t i = 0; i < request_call_num; ++i) {
+      cache->Add(i, shard_sorted_kv_list[i]);
+    }
+    if (cache->NeedFlush(FLAGS_pserver_push_sparse_cache_max_keys,
+                         FLAGS_pserver_push_sparse_cache_max_age_ms)) {
+      FlushPushSparseCache(table_id);
+    }
+    std::promise<int32_t> promise;
+    std::future<int32_t> fut = promise.get_future();
+    promise.set_value(0);
+    return fut;
+  }
+
   auto sparse_task_data = _sparse_task_pool.get();
   sparse_task_data->shared_data.resize(request_call_num);
   auto async_task = new SparseAsyncTask(sparse_task_data, table_id, push_timer);
@@ -1590,6 +1738,73 @@ std::future<int32_t> BrpcPsClient::PushSparse(size_t table_id,
   return fut;
 }
 
+void BrpcPsClient::FlushPushSparseCache(uint32_t table_id) {
+  auto *cache = _push_sparse_cache_map.at(table_id).get();
+  std::lock_guard<std::mutex> guard(cache->FlushMutex());
+  if (cache->Size() == 0) {
+    return;
+  }
+  CostTimer flush_timer("pserver_client_push_sparse_cache_flush");
+  auto *accessor = GetTableAccessor(table_id);
+  size_t update_dim = accessor->GetAccessorInfo().update_dim;
+  uint32_t value_size = accessor->GetAccessorInfo().update_size;
+  size_t request_call_num = _server_channels.size();
+  auto push_timer = std::make_shared<CostTimer>("pserver_client_push_sparse");
+  auto sparse_task_data = _sparse_task_pool.get();
+  sparse_task_data->shared_data.resize(request_call_num);
+  auto async_task = new SparseAsyncTask(sparse_task_data, table_id, push_timer);
+
+  thread_local std::vector<uint64_t> drained_keys;
+  thread_local std::vector<float> drained_values;
+  size_t flushed_num = 0;
+  for (size_t i = 0; i < request_call_num; ++i) {
+    size_t kv_num = cache->Drain(i, &drained_keys, &drained_values);
+    auto &shard_kv_data = async_task->data()->shared_data[i];
+    shard_kv_data.kv_num = kv_num;
+    shard_kv_data.key_list.assign(drained_keys.begin(), drained_keys.end());
+    shard_kv_data.value_list.resize(kv_num);
+    for (size_t kv_idx = 0; kv_idx < kv_num; ++kv_idx) {
+      shard_kv_data.value_list[kv_idx].assign(
+          reinterpret_cast<const char *>(drained_values.data() +
+                                         kv_idx * update_dim),
+          value_size);
+    }
+    flushed_num += kv_num;
+  }
+  cache->MarkFlushed();
+  VLOG(3) << "BrpcPsClient::FlushPushSparseCache table " << table_id
+          << " flushed keys: " << flushed_num
+          << " merge ratio: " << cache->MergeRatio();
+  std::lock_guard<std::mutex> task_guard(_push_sparse_cache_task_mutex);
+  _push_sparse_task_queue_map[table_id]->Put(std::move(async_task));
+  ++_push_sparse_cache_task_num_map[table_id];
+}
+
+void BrpcPsClient::FlushPushSparseCaches() {
+  for (auto &cache_itr : _push_sparse_cache_map) {
+    FlushPushSparseCache(cache_itr.first);
+  }
+}
+
+void BrpcPsClient::WaitPushSparseCaches() {
+  while (true) {
+    bool queued = false;
+    {
+      std::lock_guard<std::mutex> guard(_push_sparse_cache_task_mutex);
+      for (auto &num_itr : _push_sparse_cache_task_num_map) {
+        queued = queued || num_itr.second > 0;
+      }
+    }
+    // the tasks taken from the queue are counted by _async_call_num until
+    // their responses arrive
+    if (!queued && _async_call_num == 0) {
+      break;
+    }
+    VLOG(3) << "wait push sparse cache, _async_call_num:" << _async_call_num;
+    usleep(1000);
+  }
+}
+
 void BrpcPsClient::PushSparseTaskConsume() {
   uint64_t merge_size = FLAGS_pserver_push_sparse_merge_limit;
   std::vector<std::shared_ptr<SparseAsyncTask>> task_list;
@@ -1598,6 +1813,14 @@ void BrpcPsClient::PushSparseTaskConsume() {
       FLAGS_pserver_sparse_merge_thread);
   while (_running) {
     auto async_start_time_ms = butil::gettimeofday_ms();
+    // 超时的push sparse cache, 在没有新push时也需要发送
+    for (auto &cache_itr : _push_sparse_cache_map) {
+      if (cache_itr.second->NeedFlush(
+              FLAGS_pserver_push_sparse_cache_max_keys,
+              FLAGS_pserver_push_sparse_cache_max_age_ms)) {
+        FlushPushSparseCache(cache_itr.first);
+      }
+    }
     // 所有sparseTable的pushTask 进行处理
     for (auto &push_sparse_task_itr : _push_sparse_task_queue_map) {
       auto table_id = push_sparse_task_itr.first;
@@ -1607,7 +1830,16 @@ void BrpcPsClient::PushSparseTaskConsume() {
       if (queue_size == 0) {
         continue;
       }
-      if (merge_size > 0 && (queue_size <= 1 && _flushing == false)) {
+      auto cache_task_itr = _push_sparse_cache_task_num_map.find(table_id);
+      bool has_cache_task = false;
+      if (cache_task_itr != _push_sparse_cache_task_num_map.end()) {
+        std::lock_guard<std::mutex> guard(_push_sparse_cache_task_mutex);
+        has_cache_task = cache_task_itr->second > 0;
+      }
+      // a task flushed from the push sparse cache is merged already, it is
+      // sent at once
+      if (merge_size > 0 &&
+          (queue_size <= 1 && _flushing == false && !has_cache_task)) {
         continue;
       }
       ++_async_call_num;
@@ -1621,6 +1853,15 @@ void BrpcPsClient::PushSparseTaskConsume() {
       auto sparse_task_data = _sparse_task_pool.get();
 
       task_list.clear();
+      // the cache tasks are counted and put under the lock, so the ones
+      // counted here are all taken by the loop below
+      std::unique_lock<std::mutex> cache_task_lock(
+          _push_sparse_cache_task_mutex, std::defer_lock);
+      if (cache_task_itr != _push_sparse_cache_task_num_map.end()) {
+        cache_task_lock.lock();
+        has_cache_task = cache_task_itr->second > 0;
+        cache_task_itr->second = 0;
+      }
       int cur_meger_size = task_queue->Size();
 
       // task_list[0] 为一个空SparseAsyncTask, 分shard异步merge结果存入此结构。
@@ -1642,6 +1883,9 @@ void BrpcPsClient::PushSparseTaskConsume() {
         task_queue->Get(task);
         task_list.push_back(std::shared_ptr<SparseAsyncTask>(task));
       }
+      if (cache_task_lock.owns_lock()) {
+        cache_task_lock.unlock();
+      }
 
       _push_sparse_merge_count_map[table_id] += merge_count;
 
@@ -1649,7 +1893,7 @@ void BrpcPsClient::PushSparseTaskConsume() {
       std::vector<int> request_kv_num(request_call_num, 0);
 
       if (_push_sparse_merge_count_map[table_id] >= merge_size ||
-          _flushing == true) {
+          _flushing == true || has_cache_task) {
         DownpourBrpcClosure *closure = new DownpourBrpcClosure(
             request_call_num, [this, request_call_num](void *done) {
               int ret = 0;
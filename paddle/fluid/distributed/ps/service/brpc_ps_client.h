@@ -17,6 +17,7 @@
 #include <ThreadPool.h>
 
 #include <memory>
+#include <mutex>  // NOLINT
 #include <string>
 #include <vector>
 
@@ -26,6 +27,7 @@
 #include "paddle/fluid/distributed/ps/service/brpc_utils.h"
 #include "paddle/fluid/distributed/ps/service/ps_client.h"
 #include "paddle/fluid/distributed/ps/service/sendrecv.pb.h"
+#include "paddle/fluid/distributed/ps/service/sparse_push_cache.h"
 #include "paddle/fluid/framework/channel.h"
 #include "paddle/fluid/framework/lod_tensor.h"
 #include "paddle/fluid/framework/scope.h"
@@ -267,6 +269,10 @@ class BrpcPsClient : public PSClient {
                                                size_t num,
                                                bool is_training);
 
+  std::future<int32_t> PrefetchSparse(size_t table_id,
+                                      const uint64_t *keys,
+                                      size_t num) override;
+
   virtual std::future<int32_t> PrintTableStat(uint32_t table_id);
 
   virtual std::future<int32_t> Barrier(size_t table_id, uint32_t barrier_type);
@@ -360,9 +366,22 @@ class BrpcPsClient : public PSClient {
   std::unordered_map<uint32_t, paddle::framework::Channel<SparseAsyncTask *>>
       _push_sparse_task_queue_map;
   std::unordered_map<uint32_t, uint32_t> _push_sparse_merge_count_map;
+  // 跨batch合并push sparse的key, FLAGS_pserver_push_sparse_cache开启时生效
+  std::unordered_map<uint32_t, std::unique_ptr<SparsePushCache>>
+      _push_sparse_cache_map;
+  // 队列中cache flush产生的task数, 不为0时不等待merge立即发送,
+  // 与队列的取出一起由_push_sparse_cache_task_mutex保护
+  std::unordered_map<uint32_t, uint32_t> _push_sparse_cache_task_num_map;
+  std::mutex _push_sparse_cache_task_mutex;
 
   std::thread _print_thread;
 
+  // 将cache中合并后的kv作为一个push task放入队列
+  void FlushPushSparseCache(uint32_t table_id);
+  void FlushPushSparseCaches();
+  // 等待cache flush产生的task发送完成
+  void WaitPushSparseCaches();
+
   int PushSparseAsyncShardMerge(
       std::vector<std::shared_ptr<SparseAsyncTask>> &task_list,  // NOLINT
       std::vector<int> &request_kv_num,                          // NOLINT
@@ -391,6 +410,13 @@ class BrpcPsClient : public PSClient {
                                             size_t total_send_data_size,
                                             void *done) override;
 
+  std::future<int32_t> PushFusedDenseRawGradients(
+      const std::vector<uint32_t> &table_ids,
+      const std::vector<float *> &datas,
+      const std::vector<size_t> &sizes,
+      DenseCompressType compress_type,
+      void *done) override;
+
   std::future<int32_t> PushSparseRawGradient(size_t table_id,
                                              const uint64_t *keys,
                                              const float **update_values,
@@ -18,6 +18,7 @@
 
 #include "butil/object_pool.h"
 #include "paddle/fluid/distributed/common/cost_timer.h"
+#include "paddle/fluid/distributed/ps/service/dense_fusion.h"
 #include "paddle/fluid/distributed/ps/table/depends/sparse_utils.h"
 #include "paddle/fluid/distributed/ps/table/table.h"
 #include "paddle/fluid/framework/archive.h"
@@ -191,8 +192,11 @@ int32_t BrpcPsService::Initialize() {
   _service_handler_map[PS_STOP_SERVER] = &BrpcPsService::StopServer;
   _service_handler_map[PS_PULL_DENSE_TABLE] = &BrpcPsService::PullDense;
   _service_handler_map[PS_PUSH_DENSE_TABLE] = &BrpcPsService::PushDense;
+  _service_handler_map[PS_PUSH_DENSE_TABLES] = &BrpcPsService::PushFusedDense;
   _service_handler_map[PS_PULL_SPARSE_TABLE] = &BrpcPsService::PullSparse;
   _service_handler_map[PS_PUSH_SPARSE_TABLE] = &BrpcPsService::PushSparse;
+  _service_handler_map[PS_PREFETCH_SPARSE_TABLE] =
+      &BrpcPsService::PrefetchSparse;
   _service_handler_map[PS_SAVE_ONE_TABLE] = &BrpcPsService::SaveOneTable;
   _service_handler_map[PS_SAVE_ALL_TABLE] = &BrpcPsService::SaveAllTable;
   _service_handler_map[PS_SHRINK_TABLE] = &BrpcPsService::ShrinkTable;
@@ -399,6 +403,47 @@ int32_t BrpcPsService::PushDense(Table *table,
   return 0;
 }
 
+int32_t BrpcPsService::PushFusedDense(Table *table,
+                                      const PsRequestMessage &request,
+                                      PsResponseMessage &response,
+                                      brpc::Controller *cntl) {
+  platform::RecordEvent record_event("PsService->PushFusedDense",
+                                     platform::TracerEventType::Communication,
+                                     1);
+  CHECK_TABLE_EXIST(table, request, response)
+  if (request.data().size() < 1) {
+    return 0;
+  }
+
+  CostTimer timer("pserver_server_push_dense");
+  // The gradients of several dense tables, see FusedDenseWriter
+  int32_t ret = ForEachFusedDenseTable(
+      request.data().data(),
+      request.data().size(),
+      [this, &response](uint32_t table_id, const float *values, uint32_t num) {
+        auto *fused_table = _server->GetTable(table_id);
+        if (fused_table == NULL) {
+          std::string err_msg("table not found with table_id:");
+          err_msg.append(std::to_string(table_id));
+          set_response_code(response, -1, err_msg.c_str());
+          return -1;
+        }
+        TableContext table_context;
+        table_context.value_type = Dense;
+        table_context.push_context.values = values;
+        table_context.num = num;
+        if (fused_table->Push(table_context) != 0) {
+          set_response_code(response, -1, "PushFusedDense failed");
+          return -1;
+        }
+        return 0;
+      });
+  if (ret != 0 && response.err_code() == 0) {
+    set_response_code(response, -1, "invalid fused dense data");
+  }
+  return 0;
+}
+
 int32_t BrpcPsService::Barrier(Table *table,
                                const PsRequestMessage &request,
                                PsResponseMessage &response,
@@ -549,6 +594,47 @@ int32_t BrpcPsService::PullSparse(Table *table,
   return 0;
 }
 
+int32_t BrpcPsService::PrefetchSparse(Table *table,
+                                      const PsRequestMessage &request,
+                                      PsResponseMessage &response,
+                                      brpc::Controller *cntl) {
+  platform::RecordEvent record_event("PsService->PrefetchSparse",
+                                     platform::TracerEventType::Communication,
+                                     1);
+  CHECK_TABLE_EXIST(table, request, response)
+  auto &prefetch_data = request.data();
+  if (prefetch_data.size() < 1) {
+    return 0;
+  }
+  if (request.params_size() < 1) {
+    set_response_code(response,
+                      -1,
+                      "PsRequestMessage.params is requeired at "
+                      "least 1 for num of sparse_key");
+    return 0;
+  }
+  if (request.params(0).size() < sizeof(uint32_t)) {
+    set_response_code(
+        response, -1, "PsRequestMessage.params[0] is not a num of sparse_key");
+    return 0;
+  }
+  const uint32_t num =
+      *(reinterpret_cast<const uint32_t *>(request.params(0).c_str()));
+  if (num * sizeof(uint64_t) > prefetch_data.size()) {
+    set_response_code(response,
+                      -1,
+                      "PsRequestMessage.data is shorter than the num of "
+                      "sparse_key");
+    return 0;
+  }
+  const uint64_t *keys =
+      reinterpret_cast<const uint64_t *>(prefetch_data.data());
+  if (table->Prefetch(keys, num) != 0) {
+    set_response_code(response, -1, "PrefetchSparse error");
+  }
+  return 0;
+}
+
 int32_t BrpcPsService::PushSparse(Table *table,
                                   const PsRequestMessage &request,
                                   PsResponseMessage &response,
@@ -97,6 +97,10 @@ class BrpcPsService : public PsBaseService {
                     const PsRequestMessage &request,
                     PsResponseMessage &response,  // NOLINT
                     brpc::Controller *cntl);
+  int32_t PushFusedDense(Table *table,
+                         const PsRequestMessage &request,
+                         PsResponseMessage &response,  // NOLINT
+                         brpc::Controller *cntl);
   int32_t PushDenseParam(Table *table,
                          const PsRequestMessage &request,
                          PsResponseMessage &response,  // NOLINT
@@ -109,6 +113,10 @@ class BrpcPsService : public PsBaseService {
                      const PsRequestMessage &request,
                      PsResponseMessage &response,  // NOLINT
                      brpc::Controller *cntl);
+  int32_t PrefetchSparse(Table *table,
+                         const PsRequestMessage &request,
+                         PsResponseMessage &response,  // NOLINT
+                         brpc::Controller *cntl);
   int32_t PullGeoParam(Table *table,
                        const PsRequestMessage &request,
                        PsResponseMessage &response,  // NOLINT
@@ -187,14 +187,10 @@ void Communicator::RpcSendDenseParam(const std::vector<std::string> &varnames,
   return;
 }
 
-void Communicator::RpcSendDense(const CommContext &ctx,
-                                const Scope &scope) {  // delta_scope_
-  platform::RecordEvent record_event("Communicator->RpcSendDense",
-                                     platform::TracerEventType::Communication,
-                                     1);
+void Communicator::FillDenseData(const CommContext &ctx,
+                                 const Scope &scope,
+                                 std::vector<float> *dense_data) {
   auto &var_names = ctx.origin_varnames;
-  auto &table_id = ctx.table_id;
-  auto dense_data = std::make_shared<std::vector<float>>();
   size_t request_call_num = _worker_ptr->GetServerNums();
   uint32_t num_per_shard =
       DenseDimPerShard(ctx.height_sections[0], request_call_num);
@@ -212,6 +208,18 @@ void Communicator::RpcSendDense(const CommContext &ctx,
     memcpy(data + pos, g, count * sizeof(float));
     pos += count;
   }
+}
+
+void Communicator::RpcSendDense(const CommContext &ctx,
+                                const Scope &scope) {  // delta_scope_
+  platform::RecordEvent record_event("Communicator->RpcSendDense",
+                                     platform::TracerEventType::Communication,
+                                     1);
+  auto &table_id = ctx.table_id;
+  auto dense_data = std::make_shared<std::vector<float>>();
+  size_t request_call_num = _worker_ptr->GetServerNums();
+  FillDenseData(ctx, scope, dense_data.get());
+  float *data = dense_data->data();
 
   ++_async_call_num;
   DownpourBrpcClosure *closure = new DownpourBrpcClosure(
@@ -491,11 +499,14 @@ void AsyncCommunicator::RecvNoBarrier() {
 void AsyncCommunicator::SendByCommunicator() {
   std::vector<std::future<void>> tasks;
   tasks.reserve(send_varname_to_ctx_.size());
+  // the dense tables to push together if fuse_dense_
+  std::vector<const CommContext *> dense_ctxs;
+  std::mutex dense_mutex;
 
   for (auto &iter : send_varname_to_ctx_) {
     auto &ctx = iter.second;
 
-    auto send_recv_task = [this, &ctx] {
+    auto send_recv_task = [this, &ctx, &dense_ctxs, &dense_mutex] {
       auto &varnames = ctx.origin_varnames;
       auto &table_id = ctx.table_id;
       size_t var_nums = varnames.size();
@@ -543,6 +554,9 @@ void AsyncCommunicator::SendByCommunicator() {
             platform::errors::InvalidArgument(
                 "sparse variables can only be merged by one variables"));
         RpcSendSparse(varnames[0], table_id, *send_scope_);
+      } else if (fuse_dense_) {
+        std::lock_guard<std::mutex> guard(dense_mutex);
+        dense_ctxs.push_back(&ctx);
       } else {
         RpcSendDense(ctx, *send_scope_);
         if (!independent_recv_ &&
@@ -560,9 +574,91 @@ void AsyncCommunicator::SendByCommunicator() {
   for (auto &task : tasks) {
     task.wait();
   }
+  if (!dense_ctxs.empty()) {
+    RpcSendDenseFused(dense_ctxs, *send_scope_);
+    if (!independent_recv_) {
+      for (auto *ctx : dense_ctxs) {
+        if (recv_varname_to_ctx_.find(ctx->table_id) !=
+            recv_varname_to_ctx_.end()) {
+          auto recv_varnames = recv_varname_to_ctx_.at(ctx->table_id);
+          RpcRecvDense(recv_varnames, ctx->table_id, recv_scope_);
+        }
+      }
+    }
+  }
   return;
 }
 
+void AsyncCommunicator::RpcSendDenseFused(
+    const std::vector<const CommContext *> &ctxs, const Scope &scope) {
+  platform::RecordEvent record_event("Communicator->RpcSendDenseFused",
+                                     platform::TracerEventType::Communication,
+                                     1);
+  size_t request_call_num = _worker_ptr->GetServerNums();
+  std::vector<std::vector<float>> dense_datas(ctxs.size());
+  std::vector<std::future<int32_t>> statuses;
+  std::vector<uint32_t> table_ids;
+  std::vector<float *> datas;
+  std::vector<size_t> sizes;
+  size_t bucket_bytes = 0;
+
+  auto send_bucket = [&] {
+    ++_async_call_num;
+    DownpourBrpcClosure *closure = new DownpourBrpcClosure(
+        request_call_num, [this, request_call_num](void *done) {
+          int ret = 0;
+          auto *closure = (DownpourBrpcClosure *)done;  // NOLINT
+          for (size_t i = 0; i < request_call_num; ++i) {
+            if (closure->check_response(i, PS_PUSH_DENSE_TABLES) != 0) {
+              ret = -1;
+              break;
+            }
+          }
+          closure->set_promise_value(ret);
+          --_async_call_num;
+        });
+    statuses.push_back(_worker_ptr->PushFusedDenseRawGradients(
+        table_ids, datas, sizes, dense_compress_type_, closure));
+    table_ids.clear();
+    datas.clear();
+    sizes.clear();
+    bucket_bytes = 0;
+  };
+
+  for (size_t i = 0; i < ctxs.size(); ++i) {
+    auto &dense_data = dense_datas[i];
+    FillDenseData(*ctxs[i], scope, &dense_data);
+    if (dense_compress_type_ != DenseCompressType::kFP32) {
+      auto &residual = dense_residuals_[ctxs[i]->table_id];
+      residual.resize(dense_data.size(), 0);
+      ApplyErrorFeedback(dense_data.data(),
+                         dense_data.size(),
+                         dense_compress_type_,
+                         residual.data());
+    }
+    size_t bytes =
+        dense_data.size() * DenseCompressTypeSize(dense_compress_type_);
+    if (!table_ids.empty() && bucket_bytes + bytes > fuse_dense_bytes_) {
+      send_bucket();
+    }
+    table_ids.push_back(ctxs[i]->table_id);
+    datas.push_back(dense_data.data());
+    sizes.push_back(dense_data.size());
+    bucket_bytes += bytes;
+  }
+  if (!table_ids.empty()) {
+    send_bucket();
+  }
+  for (auto &status : statuses) {
+    auto ret = status.get();
+    if (ret != 0) {
+      LOG(ERROR) << "push fused dense tables failed, status[" << ret << "]";
+    }
+  }
+  VLOG(4) << "RPC Send " << ctxs.size() << " Fused Dense Tables in "
+          << statuses.size() << " Buckets done!";
+}
+
 void AsyncCommunicator::PushDensePostProcessing() {
   if (independent_recv_) {
     grad_num_.fetch_add(1, std::memory_order_relaxed);
@@ -960,10 +1056,12 @@ void HalfAsyncCommunicator::SendByCommunicator() {
 
   std::vector<std::future<void>> tasks;
   tasks.reserve(send_varname_to_ctx_.size());
+  std::vector<const CommContext *> dense_ctxs;
+  std::mutex dense_mutex;
 
   for (auto &iter : send_varname_to_ctx_) {
     auto &ctx = iter.second;
-    auto send_recv_task = [this, &ctx, batches] {
+    auto send_recv_task = [this, &ctx, batches, &dense_ctxs, &dense_mutex] {
       auto &varnames = ctx.origin_varnames;
       auto &table_id = ctx.table_id;
       size_t var_nums = varnames.size();
@@ -984,6 +1082,9 @@ void HalfAsyncCommunicator::SendByCommunicator() {
             platform::errors::InvalidArgument(
                 "sparse variables can only be merged by one variables"));
         RpcSendSparse(varnames[0], table_id, *send_scope_);
+      } else if (fuse_dense_) {
+        std::lock_guard<std::mutex> guard(dense_mutex);
+        dense_ctxs.push_back(&ctx);
       } else {
         RpcSendDense(ctx, *send_scope_);
       }
@@ -993,6 +1094,9 @@ void HalfAsyncCommunicator::SendByCommunicator() {
   for (auto &task : tasks) {
     task.wait();
   }
+  if (!dense_ctxs.empty()) {
+    RpcSendDenseFused(dense_ctxs, *send_scope_);
+  }
   return;
 }
 
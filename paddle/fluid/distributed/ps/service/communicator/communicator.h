@@ -32,6 +32,7 @@ limitations under the License. */
 #include "gflags/gflags.h"
 #include "paddle/fluid/distributed/ps/service/communicator/communicator_common.h"
 #include "paddle/fluid/distributed/ps/service/coordinator_client.h"
+#include "paddle/fluid/distributed/ps/service/dense_fusion.h"
 #include "paddle/fluid/distributed/ps/service/ps_client.h"
 #include "paddle/fluid/framework/channel.h"
 #include "paddle/fluid/framework/scope.h"
@@ -408,6 +409,11 @@ class Communicator {
     return dense_dim_total / shard_num + 1;
   }
 
+  // Copy the merged vars of a dense table to the send buffer of the servers
+  void FillDenseData(const CommContext &ctx,
+                     const Scope &scope,
+                     std::vector<float> *dense_data);
+
   void InitGFlag(const std::string &gflags);
   paddle::distributed::PSParameter _ps_param;
   paddle::distributed::PaddlePSEnvironment _ps_env;
@@ -443,6 +449,22 @@ class AsyncCommunicator : public Communicator {
     send_queue_size_ = std::stoi(envs.at("communicator_send_queue_size"));
     need_global_step_ =
         static_cast<bool>(std::stoi(envs.at("need_global_step")));
+    InitDenseFusionEnvs();
+  }
+
+  // The dense fusion is optional, it is off without the envs.
+  void InitDenseFusionEnvs() {
+    if (envs.find("communicator_fuse_dense") != envs.end()) {
+      fuse_dense_ =
+          static_cast<bool>(std::stoi(envs.at("communicator_fuse_dense")));
+    }
+    if (envs.find("communicator_dense_compress_type") != envs.end()) {
+      dense_compress_type_ = StringToDenseCompressType(
+          envs.at("communicator_dense_compress_type"));
+    }
+    if (envs.find("communicator_fuse_dense_bytes") != envs.end()) {
+      fuse_dense_bytes_ = std::stoull(envs.at("communicator_fuse_dense_bytes"));
+    }
   }
 
   void Start() override;
@@ -464,6 +486,11 @@ class AsyncCommunicator : public Communicator {
 
   virtual void SendByCommunicator();
 
+  // Push the dense tables merged by one SendByCommunicator together, one
+  // request per server for every fuse_dense_bytes_ of gradients.
+  virtual void RpcSendDenseFused(const std::vector<const CommContext *> &ctxs,
+                                 const Scope &scope);
+
   virtual void RecvByCommunicator();
 
   virtual void RecvNoBarrier();
@@ -511,6 +538,13 @@ class AsyncCommunicator : public Communicator {
   bool need_global_step_ = false;
   bool independent_recv_ = true;
   int parallel_task_nums_ = 0;
+
+  bool fuse_dense_ = false;
+  DenseCompressType dense_compress_type_ = DenseCompressType::kFP32;
+  size_t fuse_dense_bytes_ = 64 << 20;
+  // the rounding errors of the compressed dense gradients by table_id, only
+  // used by the main thread
+  std::unordered_map<int, std::vector<float>> dense_residuals_;
   int32_t sleep_seconds_before_fail_exit_;
 
   std::unique_ptr<std::thread> main_thread_{nullptr};
@@ -537,6 +571,7 @@ class HalfAsyncCommunicator : public AsyncCommunicator {
     send_queue_size_ = std::stoi(envs.at("communicator_send_queue_size"));
     need_global_step_ =
         static_cast<bool>(std::stoi(envs.at("need_global_step")));
+    InitDenseFusionEnvs();
 
     VLOG(1) << "HalfAsyncCommunicator Initialized";
   }
@@ -582,6 +617,7 @@ class SyncCommunicator : public HalfAsyncCommunicator {
     send_queue_size_ = std::stoi(envs.at("communicator_send_queue_size"));
     need_global_step_ =
         static_cast<bool>(std::stoi(envs.at("need_global_step")));
+    InitDenseFusionEnvs();
 
     VLOG(1) << "SyncCommunicator Initialized";
   }
@@ -0,0 +1,182 @@
+// Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/distributed/ps/service/dense_fusion.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+#include "paddle/fluid/platform/enforce.h"
+#include "paddle/phi/common/bfloat16.h"
+#include "paddle/phi/common/float16.h"
+
+namespace paddle {
+namespace distributed {
+
+namespace {
+
+template <typename T>
+void Compress(const float *values, uint32_t num, char *out) {
+  T *dst = reinterpret_cast<T *>(out);
+  for (uint32_t i = 0; i < num; ++i) {
+    T v(values[i]);
+    memcpy(dst + i, &v, sizeof(T));
+  }
+}
+
+template <typename T>
+void Decompress(const char *data, uint32_t num, float *out) {
+  for (uint32_t i = 0; i < num; ++i) {
+    T v;
+    memcpy(&v, data + i * sizeof(T), sizeof(T));
+    out[i] = static_cast<float>(v);
+  }
+}
+
+// The values out of the finite range of T are rounded to its max, whose
+// excess is kept in the residual, instead of inf whose residual is -inf and
+// turns the later pushes to nan. A residual of nan or inf, e.g. of a nan
+// gradient, is reset.
+template <typename T>
+void ErrorFeedback(float *values, size_t num, float *residual) {
+  const float max_value = static_cast<float>((std::numeric_limits<T>::max)());
+  for (size_t i = 0; i < num; ++i) {
+    float v = values[i] + residual[i];
+    float clamped = std::min(std::max(v, -max_value), max_value);
+    float q = static_cast<float>(T(clamped));
+    residual[i] = std::isfinite(v - q) ? v - q : 0.0f;
+    values[i] = q;
+  }
+}
+
+}  // namespace
+
+DenseCompressType StringToDenseCompressType(const std::string &type) {
+  if (type == "fp32") {
+    return DenseCompressType::kFP32;
+  } else if (type == "fp16") {
+    return DenseCompressType::kFP16;
+  } else if (type == "bf16") {
+    return DenseCompressType::kBF16;
+  }
+  PADDLE_THROW(platform::errors::InvalidArgument(
+      "The dense compress type must be fp32, fp16 or bf16, but got %s.",
+      type));
+}
+
+size_t DenseCompressTypeSize(DenseCompressType type) {
+  return type == DenseCompressType::kFP32 ? sizeof(float) : sizeof(uint16_t);
+}
+
+void ApplyErrorFeedback(float *values,
+                        size_t num,
+                        DenseCompressType type,
+                        float *residual) {
+  switch (type) {
+    case DenseCompressType::kFP16:
+      ErrorFeedback<phi::dtype::float16>(values, num, residual);
+      break;
+    case DenseCompressType::kBF16:
+      ErrorFeedback<phi::dtype::bfloat16>(values, num, residual);
+      break;
+    default:
+      break;
+  }
+}
+
+FusedDenseWriter::FusedDenseWriter(DenseCompressType type, std::string *buffer)
+    : type_(type), buffer_(buffer) {
+  uint32_t header[2] = {0, static_cast<uint32_t>(type)};
+  buffer_->clear();
+  buffer_->append(reinterpret_cast<const char *>(header), sizeof(header));
+}
+
+void FusedDenseWriter::Append(uint32_t table_id,
+                              const float *values,
+                              uint32_t num) {
+  uint32_t meta[2] = {table_id, num};
+  size_t offset = buffer_->size();
+  buffer_->resize(offset + sizeof(meta) + num * DenseCompressTypeSize(type_));
+  char *ptr = const_cast<char *>(buffer_->data()) + offset;
+  memcpy(ptr, meta, sizeof(meta));
+  ptr += sizeof(meta);
+  switch (type_) {
+    case DenseCompressType::kFP16:
+      Compress<phi::dtype::float16>(values, num, ptr);
+      break;
+    case DenseCompressType::kBF16:
+      Compress<phi::dtype::bfloat16>(values, num, ptr);
+      break;
+    default:
+      memcpy(ptr, values, num * sizeof(float));
+      break;
+  }
+  ++table_num_;
+  memcpy(const_cast<char *>(buffer_->data()), &table_num_, sizeof(uint32_t));
+}
+
+int32_t ForEachFusedDenseTable(
+    const char *data,
+    size_t size,
+    const std::function<int32_t(uint32_t, const float *, uint32_t)> &fn) {
+  uint32_t header[2];
+  if (size < sizeof(header)) {
+    return -1;
+  }
+  memcpy(header, data, sizeof(header));
+  if (header[1] > static_cast<uint32_t>(DenseCompressType::kBF16)) {
+    return -1;
+  }
+  auto type = static_cast<DenseCompressType>(header[1]);
+  size_t value_size = DenseCompressTypeSize(type);
+  size_t pos = sizeof(header);
+  std::vector<float> values;
+  for (uint32_t i = 0; i < header[0]; ++i) {
+    uint32_t meta[2];
+    if (size - pos < sizeof(meta)) {
+      return -1;
+    }
+    memcpy(meta, data + pos, sizeof(meta));
+    pos += sizeof(meta);
+    if ((size - pos) / value_size < meta[1]) {
+      return -1;
+    }
+    const char *ptr = data + pos;
+    pos += meta[1] * value_size;
+    const float *table_values = nullptr;
+    if (type == DenseCompressType::kFP32) {
+      // Every section starts at a multiple of 4B, so fp32 is used in place
+      table_values = reinterpret_cast<const float *>(ptr);
+    } else {
+      values.resize(meta[1]);
+      if (type == DenseCompressType::kFP16) {
+        Decompress<phi::dtype::float16>(ptr, meta[1], values.data());
+      } else {
+        Decompress<phi::dtype::bfloat16>(ptr, meta[1], values.data());
+      }
+      table_values = values.data();
+    }
+    int32_t ret = fn(meta[0], table_values, meta[1]);
+    if (ret != 0) {
+      return ret;
+    }
+  }
+  return 0;
+}
+
+}  // namespace distributed
+}  // namespace paddle
@@ -0,0 +1,71 @@
+// Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <stdint.h>
+
+#include <functional>
+#include <string>
+
+namespace paddle {
+namespace distributed {
+
+// The element type of the dense gradients on the wire. The gradients are
+// always fp32 on the worker and on the server.
+enum class DenseCompressType : uint32_t { kFP32 = 0, kFP16 = 1, kBF16 = 2 };
+
+// "fp32", "fp16" or "bf16"
+DenseCompressType StringToDenseCompressType(const std::string &type);
+
+size_t DenseCompressTypeSize(DenseCompressType type);
+
+// Error feedback of the compression: adds the residual of the last push to
+// the values, rounds them to the compressed type and keeps the rounding error
+// in residual for the next push, so no part of the gradients is lost.
+void ApplyErrorFeedback(float *values,
+                        size_t num,
+                        DenseCompressType type,
+                        float *residual);
+
+/*
+Fused Dense Push Content:
+|--table_num--|--compress_type--|--table_id--|--num--|---values---|...
+|-----4B------|-------4B--------|-----4B-----|--4B---|--num * ?B--|...
+*/
+class FusedDenseWriter {
+ public:
+  FusedDenseWriter(DenseCompressType type, std::string *buffer);
+
+  // Appends the fp32 values of a table, compressed to the type.
+  void Append(uint32_t table_id, const float *values, uint32_t num);
+
+  uint32_t TableNum() const { return table_num_; }
+
+ private:
+  DenseCompressType type_;
+  std::string *buffer_;
+  uint32_t table_num_ = 0;
+};
+
+// Calls fn(table_id, values, num) with the fp32 values of every table of a
+// fused push, stops at the first non zero return of fn. Returns -1 if the
+// content is malformed.
+int32_t ForEachFusedDenseTable(
+    const char *data,
+    size_t size,
+    const std::function<int32_t(uint32_t, const float *, uint32_t)> &fn);
+
+}  // namespace distributed
+}  // namespace paddle
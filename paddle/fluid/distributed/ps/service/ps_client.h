@@ -22,6 +22,7 @@
 #include <vector>
 
 #include "paddle/fluid/distributed/common/cost_timer.h"
+#include "paddle/fluid/distributed/ps/service/dense_fusion.h"
 #include "paddle/fluid/distributed/ps/service/env.h"
 #include "paddle/fluid/distributed/ps/service/sendrecv.pb.h"
 #include "paddle/fluid/distributed/ps/table/accessor.h"
@@ -233,6 +234,21 @@ class PSClient {
                                                     size_t total_send_data_size,
                                                     void *done) = 0;
 
+  // 将多个dense表的梯度合并为一个请求发送到每个server, 可压缩为fp16/bf16
+  // datas[i]的布局与PushDenseRawGradient的total_send_data相同
+  virtual std::future<int32_t> PushFusedDenseRawGradients(
+      const std::vector<uint32_t> &table_ids,
+      const std::vector<float *> &datas,
+      const std::vector<size_t> &sizes,
+      DenseCompressType compress_type,
+      void *done) {
+    VLOG(0) << "Did not implement";
+    std::promise<int32_t> promise;
+    std::future<int> fut = promise.get_future();
+    promise.set_value(-1);
+    return fut;
+  }
+
   virtual std::future<int32_t> PushSparseRawGradient(
       size_t table_id,
       const uint64_t *keys,
@@ -293,6 +309,18 @@ class PSClient {
     return fut;
   }
 
+  // 通知server即将访问的keys(如下一个pass的feasign)，
+  // server提前将其从ssd加载到内存，future结束前keys缓冲区不能再次使用
+  virtual std::future<int32_t> PrefetchSparse(size_t table_id,
+                                              const uint64_t *keys,
+                                              size_t num) {
+    VLOG(0) << "Did not implement";
+    std::promise<int32_t> promise;
+    std::future<int> fut = promise.get_future();
+    promise.set_value(-1);
+    return fut;
+  }
+
   virtual std::future<int32_t> GetCacheThreshold(
       uint32_t table_id,
       double &cache_threshold) {  // NOLINT
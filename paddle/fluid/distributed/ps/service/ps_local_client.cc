@@ -196,6 +196,38 @@ int32_t PsLocalClient::Initialize() {
   return done();
 }
 
+::std::future<int32_t> PsLocalClient::PushFusedDenseRawGradients(
+    const std::vector<uint32_t>& table_ids,
+    const std::vector<float*>& datas,
+    const std::vector<size_t>& sizes,
+    DenseCompressType compress_type,
+    void* callback) {
+  PSClientClosure* closure = reinterpret_cast<PSClientClosure*>(callback);
+
+  // Encoded as the brpc client does, so that the tables see the same values
+  std::string buffer;
+  FusedDenseWriter writer(compress_type, &buffer);
+  for (size_t i = 0; i < table_ids.size(); ++i) {
+    writer.Append(table_ids[i], datas[i], sizes[i]);
+  }
+  int32_t ret = ForEachFusedDenseTable(
+      buffer.data(),
+      buffer.size(),
+      [this](uint32_t table_id, const float* values, uint32_t num) {
+        TableContext table_context;
+        table_context.value_type = Dense;
+        table_context.push_context.values = values;
+        table_context.num = num;
+        return GetTable(table_id)->Push(table_context);
+      });
+
+  delete closure;
+  std::promise<int32_t> prom;
+  std::future<int32_t> fut = prom.get_future();
+  prom.set_value(ret);
+  return fut;
+}
+
 ::std::future<int32_t> PsLocalClient::PushDense(const Region* regions,
                                                 size_t region_num,
                                                 size_t table_id) {
@@ -285,6 +317,14 @@ int32_t PsLocalClient::Initialize() {
   return done();
 }
 
+std::future<int32_t> PsLocalClient::PrefetchSparse(size_t table_id,
+                                                   const uint64_t* keys,
+                                                   size_t num) {
+  auto* table_ptr = GetTable(table_id);
+  table_ptr->Prefetch(keys, num);
+  return done();
+}
+
 ::std::future<int32_t> PsLocalClient::PushSparseRawGradient(
     size_t table_id,
     const uint64_t* keys,
@@ -76,6 +76,10 @@ class PsLocalClient : public PSClient {
     return fut;
   }
 
+  std::future<int32_t> PrefetchSparse(size_t table_id,
+                                      const uint64_t* keys,
+                                      size_t num) override;
+
   virtual ::std::future<int32_t> PullSparsePtr(char** select_values,
                                                size_t table_id,
                                                const uint64_t* keys,
@@ -161,6 +165,13 @@ class PsLocalClient : public PSClient {
                                                     size_t total_send_data_size,
                                                     void* callback) override;
 
+  virtual std::future<int32_t> PushFusedDenseRawGradients(
+      const std::vector<uint32_t>& table_ids,
+      const std::vector<float*>& datas,
+      const std::vector<size_t>& sizes,
+      DenseCompressType compress_type,
+      void* callback) override;
+
   virtual std::future<int32_t> PushSparseRawGradient(
       size_t table_id,
       const uint64_t* keys,
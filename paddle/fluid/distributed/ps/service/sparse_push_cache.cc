@@ -0,0 +1,123 @@
+// Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/distributed/ps/service/sparse_push_cache.h"
+
+#include <chrono>  // NOLINT
+#include <cstring>
+
+#include "paddle/fluid/distributed/ps/table/accessor.h"
+
+namespace paddle {
+namespace distributed {
+
+static int64_t NowMs() {
+  return std::chrono::duration_cast<std::chrono::milliseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+SparsePushCache::SparsePushCache(ValueAccessor *accessor, size_t shard_num)
+    : accessor_(accessor),
+      update_dim_(accessor->GetAccessorInfo().update_dim) {
+  shards_.resize(shard_num);
+  for (auto &shard : shards_) {
+    shard.reset(new Shard());
+  }
+}
+
+void SparsePushCache::Add(
+    size_t shard_idx,
+    const std::vector<std::pair<uint64_t, const float *>> &kvs) {
+  if (kvs.empty()) {
+    return;
+  }
+  auto &shard = *shards_[shard_idx];
+  size_t new_keys = 0;
+  {
+    std::lock_guard<std::mutex> guard(shard.mutex);
+    for (auto &kv : kvs) {
+      auto it = shard.index.find(kv.first);
+      if (it == shard.index.end()) {
+        size_t row = shard.keys.size();
+        shard.index.emplace(kv.first, row);
+        shard.keys.push_back(kv.first);
+        shard.values.insert(
+            shard.values.end(), kv.second, kv.second + update_dim_);
+        ++new_keys;
+      } else {
+        float *merged = shard.values.data() + it->second * update_dim_;
+        const float *other = kv.second;
+        accessor_->Merge(&merged, &other, 1);
+      }
+    }
+    // under the lock of the shard, so a Drain never takes the keys before
+    // they are counted
+    size_.fetch_add(new_keys, std::memory_order_relaxed);
+  }
+  added_keys_.fetch_add(kvs.size(), std::memory_order_relaxed);
+  if (new_keys > 0) {
+    int64_t empty = 0;
+    first_add_ms_.compare_exchange_strong(empty, NowMs());
+  }
+}
+
+size_t SparsePushCache::Drain(size_t shard_idx,
+                              std::vector<uint64_t> *keys,
+                              std::vector<float> *values) {
+  auto &shard = *shards_[shard_idx];
+  keys->clear();
+  values->clear();
+  {
+    std::lock_guard<std::mutex> guard(shard.mutex);
+    keys->swap(shard.keys);
+    values->swap(shard.values);
+    shard.index.clear();
+    size_.fetch_sub(keys->size(), std::memory_order_relaxed);
+  }
+  drained_keys_.fetch_add(keys->size(), std::memory_order_relaxed);
+  return keys->size();
+}
+
+bool SparsePushCache::NeedFlush(size_t max_keys, int64_t max_age_ms) const {
+  if (Size() == 0) {
+    return false;
+  }
+  if (Size() >= max_keys) {
+    return true;
+  }
+  int64_t first_add_ms = first_add_ms_.load();
+  return first_add_ms > 0 && NowMs() - first_add_ms >= max_age_ms;
+}
+
+void SparsePushCache::MarkFlushed() {
+  // keys added during the drain make the cache non-empty, keep their age
+  if (Size() == 0) {
+    first_add_ms_.store(0);
+  } else {
+    first_add_ms_.store(NowMs());
+  }
+}
+
+double SparsePushCache::MergeRatio() const {
+  uint64_t added = AddedKeys();
+  if (added == 0) {
+    return 0;
+  }
+  // the keys still in the cache are not merged yet
+  return 1.0 - static_cast<double>(DrainedKeys() + Size()) / added;
+}
+
+}  // namespace distributed
+}  // namespace paddle
@@ -0,0 +1,91 @@
+// Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <stdint.h>
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace paddle {
+namespace distributed {
+
+class ValueAccessor;
+
+// Accumulates the push values of a sparse table on the worker across
+// PushSparse calls, so that a hot key is pushed once per flush instead of
+// once per minibatch and thread. The values of the same key are merged by
+// ValueAccessor::Merge, e.g. CtrCommonAccessor sums show, click and the
+// gradients and keeps the slot of the first push.
+// Keys are kept by the server shard they are sent to, every shard has its own
+// lock so the threads pushing different shards do not contend.
+class SparsePushCache {
+ public:
+  SparsePushCache(ValueAccessor *accessor, size_t shard_num);
+
+  // Merges the update values of the keys sent to shard_idx.
+  void Add(size_t shard_idx,
+           const std::vector<std::pair<uint64_t, const float *>> &kvs);
+
+  // Moves the merged keys and values of a shard out of the cache, the values
+  // are update_dim floats per key.
+  size_t Drain(size_t shard_idx,
+               std::vector<uint64_t> *keys,
+               std::vector<float> *values);
+
+  // Whether the cache holds max_keys keys, or its oldest value is older than
+  // max_age_ms.
+  bool NeedFlush(size_t max_keys, int64_t max_age_ms) const;
+
+  // Called after all the shards are drained.
+  void MarkFlushed();
+
+  size_t Size() const { return size_.load(std::memory_order_relaxed); }
+  size_t ShardNum() const { return shards_.size(); }
+
+  // The keys added and the keys drained since the creation, the merge ratio
+  // is 1 - drained / added.
+  uint64_t AddedKeys() const { return added_keys_.load(); }
+  uint64_t DrainedKeys() const { return drained_keys_.load(); }
+  double MergeRatio() const;
+
+  // Serializes the flushes of several threads.
+  std::mutex &FlushMutex() { return flush_mutex_; }
+
+ private:
+  struct Shard {
+    std::mutex mutex;
+    std::unordered_map<uint64_t, size_t> index;  // key -> row of values
+    std::vector<uint64_t> keys;
+    std::vector<float> values;
+  };
+
+  ValueAccessor *accessor_;
+  size_t update_dim_;
+  std::vector<std::unique_ptr<Shard>> shards_;
+  std::atomic<size_t> size_{0};
+  // ms of the first Add after the last flush, 0 if empty
+  std::atomic<int64_t> first_add_ms_{0};
+  std::atomic<uint64_t> added_keys_{0};
+  std::atomic<uint64_t> drained_keys_{0};
+  std::mutex flush_mutex_;
+};
+
+}  // namespace distributed
+}  // namespace paddle
@@ -24,6 +24,7 @@
 #include "paddle/fluid/distributed/common/utils.h"
 #include "paddle/fluid/distributed/ps/table/graph/graph_node.h"
 #include "paddle/fluid/framework/generator.h"
+#include "paddle/fluid/platform/enforce.h"
 #include "paddle/fluid/string/printf.h"
 #include "paddle/fluid/string/string_helper.h"
 
@@ -64,7 +65,18 @@ paddle::framework::GpuPsCommGraph GraphTable::make_gpu_ps_graph(
         for (size_t j = 0; j < bags[i].size(); j++) {
           Node *v = find_node(0, idx, bags[i][j]);
           x.node_id = bags[i][j];
-          if (v == NULL) {
+          int64_t csr_pos = -1;
+          GraphCsr *csr = v == NULL && use_csr_storage
+                              ? find_csr_node(idx, bags[i][j], &csr_pos)
+                              : nullptr;
+          if (csr != nullptr) {
+            x.neighbor_size = csr->get_neighbor_size(csr_pos);
+            x.neighbor_offset = edge_array[i].size();
+            node_array[i].push_back(x);
+            for (size_t k = 0; k < x.neighbor_size; k++) {
+              edge_array[i].push_back(csr->get_neighbor_id(csr_pos, k));
+            }
+          } else if (v == NULL) {
             x.neighbor_size = 0;
             x.neighbor_offset = 0;
             node_array[i].push_back(x);
@@ -838,7 +850,21 @@ std::vector<Node *> GraphShard::get_batch(int start, int end, int step) {
   return res;
 }
 
-size_t GraphShard::get_size() { return bucket.size(); }
+size_t GraphShard::get_size() { return bucket.size() + csr.get_size(); }
+
+std::vector<int64_t> GraphShard::get_csr_batch(int start, int end, int step) {
+  if (start < 0) start = 0;
+  int bucket_size = bucket.size();
+  int pos = start;
+  if (pos < bucket_size) {
+    pos += (bucket_size - pos + step - 1) / step * step;
+  }
+  std::vector<int64_t> res;
+  for (; pos < std::min(end, (int)get_size()); pos += step) {
+    res.push_back(csr.get_id(pos - bucket_size));
+  }
+  return res;
+}
 
 int32_t GraphTable::add_comm_edge(int idx, int64_t src_id, int64_t dst_id) {
   size_t src_shard_id = src_id % shard_num;
@@ -912,6 +938,7 @@ void GraphShard::clear() {
   }
   bucket.clear();
   node_location.clear();
+  csr.clear();
 }
 
 GraphShard::~GraphShard() { clear(); }
@@ -1099,6 +1126,8 @@ int32_t GraphTable::load_nodes(const std::string &path, std::string node_type) {
   return 0;
 }
 
+// The nodes in the csr storage are sampled over its arrays and need no
+// sampler.
 int32_t GraphTable::build_sampler(int idx, std::string sample_type) {
   for (auto &shard : edge_shards[idx]) {
     auto bucket = shard->get_bucket();
@@ -1128,6 +1157,9 @@ int32_t GraphTable::load_edges(const std::string &path,
     }
     idx = edge_to_id[edge_type];
   }
+  if (use_csr_storage) {
+    return load_edges_to_csr(path, reverse_edge, idx);
+  }
 
   auto paths = paddle::string::split_string<std::string>(path, ";");
   int64_t count = 0;
@@ -1207,6 +1239,92 @@ int32_t GraphTable::load_edges(const std::string &path,
   return 0;
 }
 
+int32_t GraphTable::load_edges_to_csr(const std::string &path,
+                                      bool reverse_edge,
+                                      int idx) {
+  auto paths = paddle::string::split_string<std::string>(path, ";");
+  std::vector<std::vector<GraphCsrEdges>> file_edges(
+      paths.size(), std::vector<GraphCsrEdges>(shard_num_per_server));
+  std::vector<int64_t> counts(paths.size(), 0), valid_counts(paths.size(), 0);
+  std::vector<int> weighted(paths.size(), 0);
+  std::vector<std::future<int>> tasks;
+  for (size_t i = 0; i < paths.size(); i++) {
+    tasks.push_back(
+        _shards_task_pool[i % task_pool_size_]->enqueue([&, i, this]() -> int {
+          std::ifstream file(paths[i]);
+          std::string line;
+          auto &edges = file_edges[i];
+          while (std::getline(file, line)) {
+            auto values =
+                paddle::string::split_string<std::string>(line, "\t");
+            counts[i]++;
+            if (values.size() < 2) continue;
+            auto src_id = std::stoull(values[0]);
+            auto dst_id = std::stoull(values[1]);
+            if (reverse_edge) {
+              std::swap(src_id, dst_id);
+            }
+            float weight = 1;
+            if (values.size() == 3) {
+              weight = std::stof(values[2]);
+              weighted[i] = 1;
+            }
+            size_t src_shard_id = src_id % shard_num;
+            if (src_shard_id >= shard_end || src_shard_id < shard_start) {
+              VLOG(4) << "will not load " << src_id << " from " << paths[i]
+                      << ", please check id distribution";
+              continue;
+            }
+            edges[src_shard_id - shard_start].add_edge(src_id, dst_id, weight);
+            valid_counts[i]++;
+          }
+          return 0;
+        }));
+  }
+  for (auto &t : tasks) t.get();
+  tasks.clear();
+
+  bool is_weighted =
+      std::find(weighted.begin(), weighted.end(), 1) != weighted.end();
+  auto &shards = edge_shards[idx];
+  for (size_t i = 0; i < shards.size(); i++) {
+    tasks.push_back(
+        _shards_task_pool[i % task_pool_size_]->enqueue([&, i]() -> int {
+          GraphCsr &csr = shards[i]->get_csr();
+          GraphCsrEdges edges;
+          csr.export_edges(&edges);
+          bool shard_weighted = is_weighted || csr.is_weighted();
+          for (auto &f : file_edges) {
+            edges.append(&f[i]);
+          }
+          csr.build(&edges, shard_weighted);
+          return 0;
+        }));
+  }
+  for (auto &t : tasks) t.get();
+
+  int64_t count = std::accumulate(counts.begin(), counts.end(), int64_t(0));
+  int64_t valid_count =
+      std::accumulate(valid_counts.begin(), valid_counts.end(), int64_t(0));
+  size_t memory_size = 0;
+  for (auto &shard : shards) {
+    memory_size += shard->get_csr().memory_size();
+  }
+  VLOG(0) << valid_count << "/" << count << " edges are loaded successfully in "
+          << path << ", csr storage costs " << memory_size << " bytes";
+  return 0;
+}
+
+GraphCsr *GraphTable::find_csr_node(int idx, int64_t id, int64_t *pos) {
+  size_t shard_id = id % shard_num;
+  if (shard_id >= shard_end || shard_id < shard_start) {
+    return nullptr;
+  }
+  GraphCsr &csr = edge_shards[idx][shard_id - shard_start]->get_csr();
+  *pos = csr.find(id);
+  return *pos < 0 ? nullptr : &csr;
+}
+
 Node *GraphTable::find_node(int type_id, int idx, int64_t id) {
   size_t shard_id = id % shard_num;
   if (shard_id >= shard_end || shard_id < shard_start) {
@@ -1343,10 +1461,13 @@ int32_t GraphTable::random_sample_neighbors(
           index++;
         } else {
           node_id = id_list[i][k].node_key;
-          Node *node = find_node(0, idx, node_id);
+          int64_t csr_pos = -1;
+          GraphCsr *csr =
+              use_csr_storage ? find_csr_node(idx, node_id, &csr_pos) : nullptr;
+          Node *node = csr == nullptr ? find_node(0, idx, node_id) : nullptr;
           int idy = seq_id[i][k];
           int &actual_size = actual_sizes[idy];
-          if (node == nullptr) {
+          if (node == nullptr && csr == nullptr) {
 #ifdef PADDLE_WITH_HETERPS
             if (search_level == 2) {
               VLOG(2) << "enter sample from ssd for node_id " << node_id;
@@ -1364,7 +1485,9 @@ int32_t GraphTable::random_sample_neighbors(
             continue;
           }
           std::shared_ptr<char> &buffer = buffers[idy];
-          std::vector<int> res = node->sample_k(sample_size, rng);
+          std::vector<int> res = csr != nullptr
+                                     ? csr->sample_k(csr_pos, sample_size, rng)
+                                     : node->sample_k(sample_size, rng);
           actual_size =
               res.size() * (need_weight ? (Node::id_size + Node::weight_size)
                                         : Node::id_size);
@@ -1380,11 +1503,13 @@ int32_t GraphTable::random_sample_neighbors(
             buffer.reset(buffer_addr, char_del);
           }
           for (int &x : res) {
-            id = node->get_neighbor_id(x);
+            id = csr != nullptr ? csr->get_neighbor_id(csr_pos, x)
+                                : node->get_neighbor_id(x);
             memcpy(buffer_addr + offset, &id, Node::id_size);
             offset += Node::id_size;
             if (need_weight) {
-              weight = node->get_neighbor_weight(x);
+              weight = csr != nullptr ? csr->get_neighbor_weight(csr_pos, x)
+                                      : node->get_neighbor_weight(x);
               memcpy(buffer_addr + offset, &weight, Node::weight_size);
               offset += Node::weight_size;
             }
@@ -1534,7 +1659,9 @@ int32_t GraphTable::pull_graph_list(int type_id,
   if (start < 0) start = 0;
   int size = 0, cur_size;
   auto &search_shards = type_id == 0 ? edge_shards[idx] : feature_shards[idx];
-  std::vector<std::future<std::vector<Node *>>> tasks;
+  // the nodes in the csr storage have no feature and are returned as ids
+  std::vector<std::future<std::pair<std::vector<Node *>, std::vector<int64_t>>>>
+      tasks;
   for (size_t i = 0; i < search_shards.size() && total_size > 0; i++) {
     cur_size = search_shards[i]->get_size();
     if (size + cur_size <= start) {
@@ -1545,8 +1672,11 @@ int32_t GraphTable::pull_graph_list(int type_id,
     int end = start + (count - 1) * step + 1;
     tasks.push_back(_shards_task_pool[i % task_pool_size_]->enqueue(
         [&search_shards, this, i, start, end, step, size]()
-            -> std::vector<Node *> {
-          return search_shards[i]->get_batch(start - size, end - size, step);
+            -> std::pair<std::vector<Node *>, std::vector<int64_t>> {
+          return std::make_pair(
+              search_shards[i]->get_batch(start - size, end - size, step),
+              search_shards[i]->get_csr_batch(
+                  start - size, end - size, step));
         }));
     start += count * step;
     total_size -= count;
@@ -1557,11 +1687,15 @@ int32_t GraphTable::pull_graph_list(int type_id,
   }
   size = 0;
   std::vector<std::vector<Node *>> res;
+  std::vector<std::vector<int64_t>> csr_res;
   for (size_t i = 0; i < tasks.size(); i++) {
-    res.push_back(tasks[i].get());
+    auto batch = tasks[i].get();
+    res.push_back(std::move(batch.first));
+    csr_res.push_back(std::move(batch.second));
     for (size_t j = 0; j < res.back().size(); j++) {
       size += res.back()[j]->get_size(need_feature);
     }
+    size += csr_res.back().size() * (Node::id_size + Node::int_size);
   }
   char *buffer_addr = new char[size];
   buffer.reset(buffer_addr);
@@ -1571,6 +1705,11 @@ int32_t GraphTable::pull_graph_list(int type_id,
       res[i][j]->to_buffer(buffer_addr + index, need_feature);
       index += res[i][j]->get_size(need_feature);
     }
+    for (size_t j = 0; j < csr_res[i].size(); j++) {
+      Node node(csr_res[i][j]);
+      node.to_buffer(buffer_addr + index, need_feature);
+      index += node.get_size(need_feature);
+    }
   }
   actual_size = size;
   return 0;
@@ -1641,6 +1780,18 @@ int32_t GraphTable::Initialize(const GraphParameter &graph) {
     shard_num = graph.shard_num();
   }
   use_cache = graph.use_cache();
+  use_csr_storage = graph.use_csr_storage();
+#ifdef PADDLE_WITH_HETERPS
+  // The edges on ssd, make_complementary_graph and dump_edges_to_ssd work on
+  // the GraphNode buckets only.
+  PADDLE_ENFORCE_EQ(
+      use_csr_storage && search_level >= 2,
+      false,
+      paddle::platform::errors::InvalidArgument(
+          "use_csr_storage is not supported with search_level %d, which keeps "
+          "the edges on ssd. Please set search_level to 1.",
+          search_level));
+#endif
   if (use_cache) {
     cache_size_limit = graph.cache_size_limit();
     cache_ttl = graph.cache_ttl();
@@ -41,6 +41,7 @@
 #include "paddle/fluid/distributed/ps/table/accessor.h"
 #include "paddle/fluid/distributed/ps/table/common_table.h"
 #include "paddle/fluid/distributed/ps/table/graph/class_macro.h"
+#include "paddle/fluid/distributed/ps/table/graph/graph_csr.h"
 #include "paddle/fluid/distributed/ps/table/graph/graph_node.h"
 #include "paddle/fluid/string/string_helper.h"
 #include "paddle/phi/core/utils/rw_lock.h"
@@ -58,11 +59,17 @@ class GraphShard {
   ~GraphShard();
   std::vector<Node *> &get_bucket() { return bucket; }
   std::vector<Node *> get_batch(int start, int end, int step);
+  // The nodes of the csr storage are placed after the nodes of bucket.
   std::vector<int64_t> get_ids_by_range(int start, int end) {
     std::vector<int64_t> res;
     for (int i = start; i < end && i < (int)bucket.size(); i++) {
       res.push_back(bucket[i]->get_id());
     }
+    for (int i = std::max(start, (int)bucket.size());
+         i < end && i < (int)get_size();
+         i++) {
+      res.push_back(csr.get_id(i - bucket.size()));
+    }
     return res;
   }
   std::vector<int64_t> get_all_id() {
@@ -70,8 +77,10 @@ class GraphShard {
     for (int i = 0; i < (int)bucket.size(); i++) {
       res.push_back(bucket[i]->get_id());
     }
+    res.insert(res.end(), csr.get_ids().begin(), csr.get_ids().end());
     return res;
   }
+  std::vector<int64_t> get_csr_batch(int start, int end, int step);
   GraphNode *add_graph_node(int64_t id);
   GraphNode *add_graph_node(Node *node);
   FeatureNode *add_feature_node(int64_t id);
@@ -82,10 +91,12 @@ class GraphShard {
   std::unordered_map<int64_t, int> &get_node_location() {
     return node_location;
   }
+  GraphCsr &get_csr() { return csr; }
 
  private:
   std::unordered_map<int64_t, int> node_location;
   std::vector<Node *> bucket;
+  GraphCsr csr;
 };
 
 enum LRUResponse { ok = 0, blocked = 1, err = 2 };
@@ -430,6 +441,7 @@ class GraphTable : public Table {
  public:
   GraphTable() {
     use_cache = false;
+    use_csr_storage = false;
     shard_num = 0;
     rw_lock.reset(new pthread_rwlock_t());
 #ifdef PADDLE_WITH_HETERPS
@@ -493,6 +505,9 @@ class GraphTable : public Table {
   int32_t load_edges(const std::string &path,
                      bool reverse,
                      const std::string &edge_type);
+  // Parse the edge files in parallel and build the csr storage of every
+  // shard in parallel, the edges already in the storage are kept.
+  int32_t load_edges_to_csr(const std::string &path, bool reverse, int idx);
 
   std::vector<std::vector<int64_t>> get_all_id(int type,
                                                int idx,
@@ -507,6 +522,9 @@ class GraphTable : public Table {
 
   int32_t get_server_index_by_id(int64_t id);
   Node *find_node(int type_id, int idx, int64_t id);
+  // Return the csr storage holding the edges of id and its position in it,
+  // or nullptr when id is not in the csr storage.
+  GraphCsr *find_csr_node(int idx, int64_t id, int64_t *pos);
 
   virtual int32_t Pull(TableContext &context) { return 0; }
   virtual int32_t Push(TableContext &context) { return 0; }
@@ -628,7 +646,7 @@ class GraphTable : public Table {
   std::shared_ptr<ScaledLRU<SampleKey, SampleResult>> scaled_lru;
   std::unordered_set<int64_t> extra_nodes;
   std::unordered_map<int64_t, size_t> extra_nodes_to_thread_index;
-  bool use_cache, use_duplicate_nodes;
+  bool use_cache, use_duplicate_nodes, use_csr_storage;
   int cache_size_limit;
   int cache_ttl;
   mutable std::mutex mutex_;
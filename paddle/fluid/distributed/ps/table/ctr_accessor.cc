@@ -245,6 +245,7 @@ int32_t CtrCommonAccessor::Merge(float** update_values,
 int32_t CtrCommonAccessor::Update(float** update_values,
                                   const float** push_values,
                                   size_t num) {
+  std::vector<float> push_shows(num);
   for (size_t value_item = 0; value_item < num; ++value_item) {
     float* update_value = update_values[value_item];
     const float* push_value = push_values[value_item];
@@ -264,17 +265,23 @@ int32_t CtrCommonAccessor::Update(float** update_values,
     }
     VLOG(3) << "accessor show scale:" << _show_scale
             << ", push_show:" << push_show;
-    _embed_sgd_rule->UpdateValue(
-        update_value + common_feature_value.EmbedWIndex(),
-        update_value + common_feature_value.EmbedG2SumIndex(),
-        push_value + CtrCommonPushValue::EmbedGIndex(),
-        push_show);
-    _embedx_sgd_rule->UpdateValue(
-        update_value + common_feature_value.EmbedxWIndex(),
-        update_value + common_feature_value.EmbedxG2SumIndex(),
-        push_value + CtrCommonPushValue::EmbedxGIndex(),
-        push_show);
+    push_shows[value_item] = push_show;
   }
+  // the sgd rules update all the keys in a batch
+  _embed_sgd_rule->UpdateValue(num,
+                               update_values,
+                               common_feature_value.EmbedWIndex(),
+                               common_feature_value.EmbedG2SumIndex(),
+                               push_values,
+                               CtrCommonPushValue::EmbedGIndex(),
+                               push_shows.data());
+  _embedx_sgd_rule->UpdateValue(num,
+                                update_values,
+                                common_feature_value.EmbedxWIndex(),
+                                common_feature_value.EmbedxG2SumIndex(),
+                                push_values,
+                                CtrCommonPushValue::EmbedxGIndex(),
+                                push_shows.data());
   return 0;
 }
 
@@ -198,12 +198,16 @@ class CtrDoubleAccessor : public ValueAccessor {
   virtual std::string ParseToString(const float* value, int param) override;
   virtual int32_t ParseFromString(const std::string& str, float* v) override;
   virtual bool CreateValue(int type, const float* value);
-  //这个接口目前只用来取show
+  //这个接口目前只用来取show和show_click_score
   virtual float GetField(float* value, const std::string& name) override {
-    CHECK(name == "show");
+    CHECK(name == "show" || name == "show_click_score");
     if (name == "show") {
       return (float)CtrDoubleFeatureValue::Show(value);
     }
+    if (name == "show_click_score") {
+      return (float)ShowClickScore(CtrDoubleFeatureValue::Show(value),
+                                   CtrDoubleFeatureValue::Click(value));
+    }
     return 0.0;
   }
   // DEFINE_GET_INDEX(CtrDoubleFeatureValue, show)
@@ -14,7 +14,10 @@
 
 #pragma once
 
+#include <cstdlib>
+#include <cstring>
 #include <mct/hash-map.hpp>
+#include <utility>
 #include <vector>
 
 #include "gflags/gflags.h"
@@ -29,15 +32,230 @@ static const size_t CTR_SPARSE_SHARD_BUCKET_NUM =
 
 class FixedFeatureValue {
  public:
-  FixedFeatureValue() {}
-  ~FixedFeatureValue() {}
-  float* data() { return _data.data(); }
-  size_t size() { return _data.size(); }
-  void resize(size_t size) { _data.resize(size); }
-  void shrink_to_fit() { _data.shrink_to_fit(); }
+  FixedFeatureValue() : _size(0), _capacity(0), _inline(0), _dirty(0) {}
+  // A value of the flat value store, its inline_capacity floats directly
+  // follow the value in the same slab block.
+  explicit FixedFeatureValue(uint32_t inline_capacity)
+      : _size(0), _capacity(inline_capacity), _inline(1), _dirty(0) {}
+  FixedFeatureValue(const FixedFeatureValue& other) : FixedFeatureValue() {
+    *this = other;
+  }
+  FixedFeatureValue& operator=(const FixedFeatureValue& other) {
+    if (this != &other) {
+      resize(other._size);
+      memcpy(data(), other.data(), other._size * sizeof(float));
+    }
+    return *this;
+  }
+  ~FixedFeatureValue() {
+    if (!_inline) {
+      free(_data);
+    }
+  }
+  float* data() {
+    return _inline ? reinterpret_cast<float*>(this + 1) : _data;
+  }
+  const float* data() const {
+    return _inline ? reinterpret_cast<const float*>(this + 1) : _data;
+  }
+  size_t size() const { return _size; }
+  void resize(size_t size) {
+    if (size > _capacity) {
+      reserve(size);
+    }
+    if (size > _size) {
+      memset(data() + _size, 0, (size - _size) * sizeof(float));
+    }
+    _size = size;
+  }
+  void shrink_to_fit() {
+    if (_inline || _capacity == _size) {
+      return;
+    }
+    float* buf = NULL;
+    if (_size > 0) {
+      buf = static_cast<float*>(malloc(_size * sizeof(float)));
+      memcpy(buf, _data, _size * sizeof(float));
+    }
+    free(_data);
+    _data = buf;
+    _capacity = _size;
+  }
+  // whether the value is created or updated since the last checkpoint save,
+  // a delta save only writes the dirty values.
+  bool dirty() const { return _dirty; }
+  void set_dirty(bool dirty) { _dirty = dirty ? 1 : 0; }
 
  private:
-  std::vector<float> _data;
+  // a value of the flat value store spills to the heap when it grows beyond
+  // the stride, which only happens when the accessor dim is exceeded.
+  void reserve(size_t capacity) {
+    float* buf = static_cast<float*>(malloc(capacity * sizeof(float)));
+    if (_size > 0) {
+      memcpy(buf, data(), _size * sizeof(float));
+    }
+    if (!_inline) {
+      free(_data);
+    }
+    _data = buf;
+    _capacity = static_cast<uint32_t>(capacity);
+    _inline = 0;
+  }
+
+  float* _data = NULL;
+  uint32_t _size;
+  uint32_t _capacity : 30;
+  uint32_t _inline : 1;
+  uint32_t _dirty : 1;
+};
+static_assert(sizeof(FixedFeatureValue) % sizeof(float) == 0,
+              "the inline floats should follow FixedFeatureValue directly");
+
+// Allocates the FixedFeatureValue of a SparseTableShard. By default the values
+// come from a ChunkAllocator and keep their floats in a separate heap block.
+// After set_value_stride(n) the values are fixed-stride blocks carved from
+// large slabs, with the n floats inlined right after the value header, which
+// saves the heap block per key and the pointer chasing on every access.
+class FixedFeatureValueAllocator {
+ public:
+  FixedFeatureValueAllocator() {}
+  FixedFeatureValueAllocator(const FixedFeatureValueAllocator&) = delete;
+  ~FixedFeatureValueAllocator() { free_slabs(); }
+
+  void set_value_stride(size_t stride) {
+    CHECK(size() == 0) << "value stride should be set on an empty shard";
+    free_slabs();
+    _stride = stride;
+    _block_size = sizeof(FixedFeatureValue) + stride * sizeof(float);
+    _block_size = (_block_size + alignof(FixedFeatureValue) - 1) /
+                  alignof(FixedFeatureValue) * alignof(FixedFeatureValue);
+    _next_slab_blocks = kMinSlabBlocks;
+  }
+  size_t value_stride() const { return _stride; }
+
+  template <class... ARGS>
+  FixedFeatureValue* acquire(ARGS&&... args) {
+    if (_stride == 0) {
+      return _chunk.acquire(std::forward<ARGS>(args)...);
+    }
+    FixedFeatureValue* x =
+        new (pop_block()) FixedFeatureValue(static_cast<uint32_t>(_stride));
+    assign(x, std::forward<ARGS>(args)...);
+    _counter++;
+    return x;
+  }
+  void release(FixedFeatureValue* x) {
+    if (_stride == 0) {
+      _chunk.release(x);
+      return;
+    }
+    x->~FixedFeatureValue();
+    push_block(x);
+    _counter--;
+  }
+  size_t size() const { return _stride == 0 ? _chunk.size() : _counter; }
+  // how many slab blocks are not used by any value
+  size_t free_blocks() const { return _capacity - _counter; }
+
+  // Allocates one slab for n more values, so that a compaction gets dense.
+  void reserve(size_t n) {
+    if (_stride > 0 && n > free_blocks()) {
+      create_new_slab(n - free_blocks());
+    }
+  }
+  // Moves x of another allocator with the same stride into this allocator.
+  // x is moved bitwise, the source block should be dropped without calling
+  // the destructor.
+  FixedFeatureValue* relocate(FixedFeatureValue* x) {
+    void* block = pop_block();
+    memcpy(block, x, _block_size);
+    _counter++;
+    return reinterpret_cast<FixedFeatureValue*>(block);
+  }
+  void swap(FixedFeatureValueAllocator& other) {
+    CHECK(_stride == other._stride);
+    std::swap(_slabs, other._slabs);
+    std::swap(_free_blocks, other._free_blocks);
+    std::swap(_counter, other._counter);
+    std::swap(_capacity, other._capacity);
+    std::swap(_next_slab_blocks, other._next_slab_blocks);
+  }
+
+ private:
+  static const size_t kMinSlabBlocks = 64;
+  static const size_t kMaxSlabBlocks = 16384;
+  struct FreeBlock {
+    FreeBlock* next;
+  };
+  struct alignas(FixedFeatureValue) Slab {
+    Slab* next;
+  };
+
+  static void assign(FixedFeatureValue* x) {}
+  static void assign(FixedFeatureValue* x, const FixedFeatureValue& val) {
+    *x = val;
+  }
+
+  void* pop_block() {
+    if (_free_blocks == NULL) {
+      create_new_slab(_next_slab_blocks);
+      if (_next_slab_blocks < kMaxSlabBlocks) {
+        _next_slab_blocks *= 2;
+      }
+    }
+    FreeBlock* block = _free_blocks;
+    _free_blocks = block->next;
+    return block;
+  }
+  void push_block(void* x) {
+    FreeBlock* block = reinterpret_cast<FreeBlock*>(x);
+    block->next = _free_blocks;
+    _free_blocks = block;
+  }
+  void create_new_slab(size_t block_num) {
+    Slab* slab = reinterpret_cast<Slab*>(
+        malloc(sizeof(Slab) + _block_size * block_num));
+    CHECK(slab != NULL) << "failed to allocate a slab of " << block_num
+                        << " values";
+    slab->next = _slabs;
+    _slabs = slab;
+    // push in reverse order so that the blocks are handed out in address order
+    char* blocks = reinterpret_cast<char*>(slab + 1);
+    for (size_t i = block_num; i > 0; --i) {
+      push_block(blocks + (i - 1) * _block_size);
+    }
+    _capacity += block_num;
+  }
+  // frees the memory only, the values should have been released or relocated
+  void free_slabs() {
+    while (_slabs != NULL) {
+      Slab* x = _slabs;
+      _slabs = _slabs->next;
+      free(x);
+    }
+    _free_blocks = NULL;
+    _counter = 0;
+    _capacity = 0;
+  }
+
+  ChunkAllocator<FixedFeatureValue> _chunk;
+  size_t _stride = 0;  // 0 means the values come from _chunk
+  size_t _block_size = 0;
+  size_t _next_slab_blocks = kMinSlabBlocks;
+  Slab* _slabs = NULL;
+  FreeBlock* _free_blocks = NULL;
+  size_t _counter = 0;   // how many values are acquired from the slabs
+  size_t _capacity = 0;  // how many blocks the slabs hold
+};
+
+template <class VALUE>
+struct SparseValueAllocator {
+  typedef ChunkAllocator<VALUE> type;
+};
+
+template <>
+struct SparseValueAllocator<FixedFeatureValue> {
+  typedef FixedFeatureValueAllocator type;
 };
 
 template <class KEY, class VALUE>
@@ -184,6 +402,31 @@ struct alignas(64) SparseTableShard {
     quick_erase(it);
     return 1;
   }
+  // Stores the values in fixed-stride slab blocks of stride floats, only
+  // valid for FixedFeatureValue and should be called on an empty shard.
+  void set_value_stride(size_t stride) { _alloc.set_value_stride(stride); }
+  size_t value_stride() { return _alloc.value_stride(); }
+  // Moves the values of the flat value store into a dense slab bucket by
+  // bucket, which gives back the blocks freed by erase. Returns the number of
+  // blocks given back.
+  size_t compact() {
+    if (_alloc.value_stride() == 0 || _alloc.free_blocks() == 0) {
+      return 0;
+    }
+    size_t free_blocks = _alloc.free_blocks();
+    typename SparseValueAllocator<VALUE>::type alloc;
+    alloc.set_value_stride(_alloc.value_stride());
+    alloc.reserve(_alloc.size());
+    for (size_t bucket = 0; bucket < CTR_SPARSE_SHARD_BUCKET_NUM; bucket++) {
+      map_type& data = _buckets[bucket];
+      for (auto it = data.begin(); it != data.end(); ++it) {
+        it->second = alloc.relocate((VALUE*)(void*)it->second);  // NOLINT
+      }
+    }
+    // the old slabs are freed with alloc, without destructing the values
+    _alloc.swap(alloc);
+    return free_blocks;
+  }
   size_t compute_bucket(size_t hash) {
     if (CTR_SPARSE_SHARD_BUCKET_NUM == 1) {
       return 0;
@@ -194,7 +437,7 @@ struct alignas(64) SparseTableShard {
 
  private:
   map_type _buckets[CTR_SPARSE_SHARD_BUCKET_NUM];
-  ChunkAllocator<VALUE> _alloc;
+  typename SparseValueAllocator<VALUE>::type _alloc;
   std::hash<KEY> _hasher;
 };
 
@@ -23,6 +23,8 @@
 
 #include <iostream>
 #include <string>
+#include <utility>
+#include <vector>
 
 namespace paddle {
 namespace distributed {
@@ -37,13 +39,21 @@ class RocksDBHandler {
     return &handler;
   }
 
-  int initialize(const std::string& db_path, const int colnum) {
-    VLOG(3) << "db path: " << db_path << " colnum: " << colnum;
+  int initialize(const std::string& db_path,
+                 const int colnum,
+                 const size_t block_cache_mb = 64,
+                 const bool enable_compression = false) {
+    VLOG(3) << "db path: " << db_path << " colnum: " << colnum
+            << " block_cache_mb: " << block_cache_mb
+            << " enable_compression: " << enable_compression;
     rocksdb::Options options;
     rocksdb::BlockBasedTableOptions bbto;
     bbto.block_size = 4 * 1024;
-    bbto.block_cache = rocksdb::NewLRUCache(64 * 1024 * 1024);
-    bbto.block_cache_compressed = rocksdb::NewLRUCache(64 * 1024 * 1024);
+    bbto.block_cache = rocksdb::NewLRUCache(block_cache_mb * 1024 * 1024);
+    if (enable_compression) {
+      bbto.block_cache_compressed =
+          rocksdb::NewLRUCache(block_cache_mb * 1024 * 1024);
+    }
     bbto.cache_index_and_filter_blocks = false;
     bbto.filter_policy.reset(rocksdb::NewBloomFilterPolicy(20, false));
     bbto.whole_key_filtering = true;
@@ -66,7 +76,12 @@ class RocksDBHandler {
     options.num_levels = 4;
     options.max_open_files = -1;
 
+    // the values of the top levels are hot and rewritten frequently, only
+    // compress the bottommost level which holds most of the cold values
     options.compression = rocksdb::kNoCompression;
+    if (enable_compression) {
+      options.bottommost_compression = rocksdb::kSnappyCompression;
+    }
     options.level0_file_num_compaction_trigger = 8;
     options.level0_slowdown_writes_trigger =
         1.8 * options.level0_file_num_compaction_trigger;
@@ -115,7 +130,11 @@ class RocksDBHandler {
                 rocksdb::Slice(ssd_values[i].first, ssd_values[i].second));
     }
     rocksdb::Status s = _db->Write(options, &batch);
-    assert(s.ok());
+    if (!s.ok()) {
+      LOG(ERROR) << "rocksdb put_batch of shard " << id
+                 << " failed: " << s.ToString();
+      return -1;
+    }
     return 0;
   }
 
@@ -131,6 +150,55 @@ class RocksDBHandler {
     return 0;
   }
 
+  // Gets the values of ssd_keys by one MultiGet, (*status)[i] is 0 if
+  // ssd_keys[i] is found, 1 if not and -1 if the read fails. Returns -1 if
+  // any read fails.
+  int multi_get(int id,
+                const std::vector<std::pair<char*, int>>& ssd_keys,
+                std::vector<std::string>* values,
+                std::vector<int>* status) {
+    std::vector<rocksdb::Slice> keys;
+    keys.reserve(ssd_keys.size());
+    for (auto& key : ssd_keys) {
+      keys.emplace_back(key.first, key.second);
+    }
+    std::vector<rocksdb::ColumnFamilyHandle*> handles(ssd_keys.size(),
+                                                      _handles[id]);
+    std::vector<rocksdb::Status> s =
+        _db->MultiGet(rocksdb::ReadOptions(), handles, keys, values);
+    int ret = 0;
+    status->resize(s.size());
+    for (size_t i = 0; i < s.size(); ++i) {
+      if (s[i].ok()) {
+        (*status)[i] = 0;
+      } else if (s[i].IsNotFound()) {
+        (*status)[i] = 1;
+      } else {
+        LOG(ERROR) << "rocksdb multi_get of shard " << id
+                   << " failed: " << s[i].ToString();
+        (*status)[i] = -1;
+        ret = -1;
+      }
+    }
+    return ret;
+  }
+
+  int del_batch(int id, const std::vector<std::pair<char*, int>>& ssd_keys) {
+    rocksdb::WriteOptions options;
+    options.disableWAL = true;
+    rocksdb::WriteBatch batch(ssd_keys.size() * 32);
+    for (auto& key : ssd_keys) {
+      batch.Delete(_handles[id], rocksdb::Slice(key.first, key.second));
+    }
+    rocksdb::Status s = _db->Write(options, &batch);
+    if (!s.ok()) {
+      LOG(ERROR) << "rocksdb del_batch of shard " << id
+                 << " failed: " << s.ToString();
+      return -1;
+    }
+    return 0;
+  }
+
   int del_data(int id, const char* key, int key_len) {
     rocksdb::WriteOptions options;
     options.disableWAL = true;
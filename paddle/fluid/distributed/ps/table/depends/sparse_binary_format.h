@@ -0,0 +1,198 @@
+// Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <xxhash.h>
+
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <vector>
+
+#include "paddle/fluid/distributed/common/afs_warpper.h"
+
+namespace paddle {
+namespace distributed {
+
+// The binary part file of a sparse table checkpoint:
+//   SparseBinaryFileHeader
+//   { SparseBinaryBlockHeader, uint64_t keys[key_num],
+//     float values[key_num * value_size] } ...
+//   SparseBinaryBlockHeader with key_num 0, which marks the end of the file
+// The values of a block have the same size, so that a block is copied into
+// the shard without parsing, and every block carries the XXH64 of its keys and
+// values to find the corrupted files.
+static const char kSparseBinaryMagic[8] = {
+    'P', 'D', 'S', 'P', 'A', 'R', 'S', 'E'};
+static const uint32_t kSparseBinaryVersion = 1;
+static const size_t kSparseBinaryBlockKeys = 4096;
+// the max bytes of a block, larger ones are taken as corrupted
+static const size_t kSparseBinaryMaxBlockBytes = 1UL << 30;
+
+struct SparseBinaryFileHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t value_dim;  // the max float num of a value
+};
+
+struct SparseBinaryBlockHeader {
+  uint32_t key_num;
+  uint32_t value_size;  // the float num of every value of the block
+  uint64_t checksum;
+};
+
+inline uint64_t SparseBinaryChecksum(const uint64_t* keys,
+                                     const float* values,
+                                     size_t key_num,
+                                     size_t value_size) {
+  uint64_t hash = XXH64(keys, key_num * sizeof(uint64_t), 0);
+  return XXH64(values, key_num * value_size * sizeof(float), hash);
+}
+
+class SparseBinaryWriter {
+ public:
+  SparseBinaryWriter(FsWriteChannel* channel,
+                     uint32_t value_dim,
+                     size_t block_keys = kSparseBinaryBlockKeys)
+      : _channel(channel), _value_dim(value_dim), _block_keys(block_keys) {}
+
+  // all the methods return 0 on success, -1 if the channel fails to write
+  int WriteHeader() {
+    SparseBinaryFileHeader header;
+    memcpy(header.magic, kSparseBinaryMagic, sizeof(header.magic));
+    header.version = kSparseBinaryVersion;
+    header.value_dim = _value_dim;
+    return _channel->write(&header, sizeof(header)) == 0 ? 0 : -1;
+  }
+
+  // the value is buffered in the block of its size, which is written out
+  // once it holds block_keys values
+  int Write(uint64_t key, const float* value, uint32_t size) {
+    auto& block = _blocks[size];
+    block.keys.push_back(key);
+    block.values.insert(block.values.end(), value, value + size);
+    if (block.keys.size() >= _block_keys) {
+      return WriteBlock(size, &block);
+    }
+    return 0;
+  }
+
+  // writes the pending blocks and the end mark
+  int Finish() {
+    for (auto& it : _blocks) {
+      if (!it.second.keys.empty() && WriteBlock(it.first, &it.second) != 0) {
+        return -1;
+      }
+    }
+    SparseBinaryBlockHeader end = {0, 0, 0};
+    return _channel->write(&end, sizeof(end)) == 0 ? 0 : -1;
+  }
+
+ private:
+  struct Block {
+    std::vector<uint64_t> keys;
+    std::vector<float> values;
+  };
+
+  int WriteBlock(uint32_t value_size, Block* block) {
+    SparseBinaryBlockHeader header;
+    header.key_num = static_cast<uint32_t>(block->keys.size());
+    header.value_size = value_size;
+    header.checksum = SparseBinaryChecksum(block->keys.data(),
+                                           block->values.data(),
+                                           block->keys.size(),
+                                           value_size);
+    if (_channel->write(&header, sizeof(header)) != 0 ||
+        _channel->write(block->keys.data(),
+                        block->keys.size() * sizeof(uint64_t)) != 0 ||
+        _channel->write(block->values.data(),
+                        block->values.size() * sizeof(float)) != 0) {
+      return -1;
+    }
+    block->keys.clear();
+    block->values.clear();
+    return 0;
+  }
+
+  FsWriteChannel* _channel;
+  uint32_t _value_dim;
+  size_t _block_keys;
+  std::map<uint32_t, Block> _blocks;
+};
+
+class SparseBinaryReader {
+ public:
+  explicit SparseBinaryReader(FsReadChannel* channel) : _channel(channel) {}
+
+  // -1 if the file is not a binary part file of this version
+  int ReadHeader() {
+    SparseBinaryFileHeader header;
+    if (_channel->read(&header, sizeof(header)) != 0 ||
+        memcmp(header.magic, kSparseBinaryMagic, sizeof(header.magic)) != 0 ||
+        header.version != kSparseBinaryVersion) {
+      return -1;
+    }
+    _value_dim = header.value_dim;
+    return 0;
+  }
+
+  // 1 if a block is read, 0 at the end of the file, -1 if the file is
+  // truncated or the checksum of the block mismatches
+  int NextBlock() {
+    SparseBinaryBlockHeader header;
+    if (_channel->read(&header, sizeof(header)) != 0) {
+      return -1;
+    }
+    if (header.key_num == 0) {
+      return 0;
+    }
+    if (header.value_size > _value_dim ||
+        header.key_num * (sizeof(uint64_t) + header.value_size *
+                                                 sizeof(float)) >
+            kSparseBinaryMaxBlockBytes) {
+      return -1;
+    }
+    _value_size = header.value_size;
+    _keys.resize(header.key_num);
+    _values.resize(static_cast<size_t>(header.key_num) * _value_size);
+    if (_channel->read(_keys.data(), _keys.size() * sizeof(uint64_t)) != 0 ||
+        _channel->read(_values.data(), _values.size() * sizeof(float)) != 0) {
+      return -1;
+    }
+    if (SparseBinaryChecksum(
+            _keys.data(), _values.data(), _keys.size(), _value_size) !=
+        header.checksum) {
+      return -1;
+    }
+    return 1;
+  }
+
+  uint32_t value_dim() const { return _value_dim; }
+  // the keys and the values of the last block
+  size_t key_num() const { return _keys.size(); }
+  uint32_t value_size() const { return _value_size; }
+  const uint64_t* keys() const { return _keys.data(); }
+  const float* value(size_t i) const { return _values.data() + i * _value_size; }
+
+ private:
+  FsReadChannel* _channel;
+  uint32_t _value_dim = 0;
+  uint32_t _value_size = 0;
+  std::vector<uint64_t> _keys;
+  std::vector<float> _values;
+};
+
+}  // namespace distributed
+}  // namespace paddle
@@ -0,0 +1,209 @@
+// Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/distributed/ps/table/graph/graph_csr.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <unordered_set>
+#include <utility>
+
+#include "gflags/gflags.h"
+
+DECLARE_int32(graph_alias_sampler_min_degree);
+
+namespace paddle {
+namespace distributed {
+
+void GraphCsrEdges::append(GraphCsrEdges *other) {
+  src.insert(src.end(), other->src.begin(), other->src.end());
+  dst.insert(dst.end(), other->dst.begin(), other->dst.end());
+  weight.insert(weight.end(), other->weight.begin(), other->weight.end());
+  other->clear();
+}
+
+void GraphCsrEdges::clear() {
+  std::vector<int64_t>().swap(src);
+  std::vector<int64_t>().swap(dst);
+  std::vector<float>().swap(weight);
+}
+
+void GraphCsr::build(GraphCsrEdges *edges, bool is_weighted) {
+  clear();
+  is_weighted_ = is_weighted;
+  size_t edge_num = edges->size();
+  ids_ = edges->src;
+  std::sort(ids_.begin(), ids_.end());
+  ids_.erase(std::unique(ids_.begin(), ids_.end()), ids_.end());
+  ids_.shrink_to_fit();
+
+  // count the degrees, then scatter the edges in their original order
+  offsets_.assign(ids_.size() + 1, 0);
+  std::vector<size_t> edge_pos(edge_num);
+  for (size_t i = 0; i < edge_num; i++) {
+    edge_pos[i] =
+        std::lower_bound(ids_.begin(), ids_.end(), edges->src[i]) - ids_.begin();
+    offsets_[edge_pos[i] + 1]++;
+  }
+  for (size_t i = 0; i < ids_.size(); i++) {
+    offsets_[i + 1] += offsets_[i];
+  }
+  std::vector<int64_t> cursor(offsets_.begin(), offsets_.end() - 1);
+  neighbors_.resize(edge_num);
+  if (is_weighted_) {
+    weights_.resize(edge_num);
+  }
+  for (size_t i = 0; i < edge_num; i++) {
+    int64_t dst_pos = cursor[edge_pos[i]]++;
+    neighbors_[dst_pos] = edges->dst[i];
+    if (is_weighted_) {
+      weights_[dst_pos] = edges->weight[i];
+    }
+  }
+  edges->clear();
+
+  if (is_weighted_) {
+    for (size_t pos = 0; pos < ids_.size(); pos++) {
+      if (static_cast<int64_t>(get_neighbor_size(pos)) >=
+          FLAGS_graph_alias_sampler_min_degree) {
+        alias_tables_[pos].build(
+            std::vector<float>(weights_.begin() + offsets_[pos],
+                               weights_.begin() + offsets_[pos + 1]));
+      }
+    }
+  }
+}
+
+void GraphCsr::export_edges(GraphCsrEdges *edges) const {
+  edges->src.reserve(edges->src.size() + neighbors_.size());
+  edges->dst.reserve(edges->dst.size() + neighbors_.size());
+  edges->weight.reserve(edges->weight.size() + neighbors_.size());
+  for (size_t pos = 0; pos < ids_.size(); pos++) {
+    for (int64_t k = offsets_[pos]; k < offsets_[pos + 1]; k++) {
+      edges->add_edge(
+          ids_[pos], neighbors_[k], is_weighted_ ? weights_[k] : 1.0);
+    }
+  }
+}
+
+void GraphCsr::clear() {
+  std::vector<int64_t>().swap(ids_);
+  std::vector<int64_t>().swap(offsets_);
+  std::vector<int64_t>().swap(neighbors_);
+  std::vector<float>().swap(weights_);
+  is_weighted_ = false;
+  std::unordered_map<size_t, AliasTable>().swap(alias_tables_);
+}
+
+int64_t GraphCsr::find(int64_t id) const {
+  auto iter = std::lower_bound(ids_.begin(), ids_.end(), id);
+  if (iter == ids_.end() || *iter != id) {
+    return -1;
+  }
+  return iter - ids_.begin();
+}
+
+size_t GraphCsr::memory_size() const {
+  size_t alias_size = 0;
+  for (auto &item : alias_tables_) {
+    alias_size += item.second.size() * (sizeof(float) + sizeof(int));
+  }
+  return (ids_.capacity() + offsets_.capacity() + neighbors_.capacity()) *
+             sizeof(int64_t) +
+         weights_.capacity() * sizeof(float) + alias_size;
+}
+
+std::vector<int> GraphCsr::sample_k(
+    size_t pos, int k, const std::shared_ptr<std::mt19937_64> rng) const {
+  int n = get_neighbor_size(pos);
+  if (k >= n) {
+    std::vector<int> sample_result(n);
+    for (int i = 0; i < n; i++) {
+      sample_result[i] = i;
+    }
+    return sample_result;
+  }
+  return is_weighted_ ? weighted_sample_k(pos, k, rng)
+                      : random_sample_k(pos, k, rng);
+}
+
+std::vector<int> GraphCsr::random_sample_k(
+    size_t pos, int k, const std::shared_ptr<std::mt19937_64> rng) const {
+  // Floyd's algorithm draws k distinct indices with k random numbers, the
+  // duplicate check is a linear scan for the small k used in sampling.
+  const int kLinearCheckLimit = 64;
+  int n = get_neighbor_size(pos);
+  std::vector<int> sample_result;
+  sample_result.reserve(k);
+  std::unordered_set<int> chosen;
+  for (int j = n - k; j < n; j++) {
+    std::uniform_int_distribution<int> distrib(0, j);
+    int rand_int = distrib(*rng);
+    bool exist = false;
+    if (k <= kLinearCheckLimit) {
+      exist = std::find(sample_result.begin(),
+                        sample_result.end(),
+                        rand_int) != sample_result.end();
+    } else {
+      exist = !chosen.insert(rand_int).second;
+      if (exist) {
+        chosen.insert(j);
+      }
+    }
+    sample_result.push_back(exist ? j : rand_int);
+  }
+  return sample_result;
+}
+
+std::vector<int> GraphCsr::weighted_sample_k(
+    size_t pos, int k, const std::shared_ptr<std::mt19937_64> rng) const {
+  int n = get_neighbor_size(pos);
+  const float *weights = weights_.data() + offsets_[pos];
+  const AliasTable *alias_table = get_alias_table(pos);
+  if (alias_table != nullptr) {
+    return alias_table->sample_k(
+        k, rng.get(), [weights](int idx) { return weights[idx]; });
+  }
+  // Every neighbor gets the key log(u) / w, and the k largest keys are a
+  // weighted sample without replacement.
+  std::uniform_real_distribution<float> distrib(0, 1.0);
+  std::vector<std::pair<float, int>> keys(n);
+  for (int i = 0; i < n; i++) {
+    float u = 1.0 - distrib(*rng);
+    keys[i].first = weights[i] > 0 ? std::log(u) / weights[i]
+                                   : -std::numeric_limits<float>::infinity();
+    keys[i].second = i;
+  }
+  std::nth_element(keys.begin(),
+                   keys.begin() + k,
+                   keys.end(),
+                   [](const std::pair<float, int> &a,
+                      const std::pair<float, int> &b) {
+                     return a.first > b.first;
+                   });
+  std::vector<int> sample_result(k);
+  for (int i = 0; i < k; i++) {
+    sample_result[i] = keys[i].second;
+  }
+  return sample_result;
+}
+
+const AliasTable *GraphCsr::get_alias_table(size_t pos) const {
+  auto iter = alias_tables_.find(pos);
+  return iter == alias_tables_.end() ? nullptr : &iter->second;
+}
+
+}  // namespace distributed
+}  // namespace paddle
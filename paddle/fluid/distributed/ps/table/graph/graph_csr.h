@@ -0,0 +1,105 @@
+// Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+#include "paddle/fluid/distributed/ps/table/graph/graph_weighted_sampler.h"
+
+namespace paddle {
+namespace distributed {
+
+// The edges of one shard collected by load_edges, in file order.
+struct GraphCsrEdges {
+  std::vector<int64_t> src;
+  std::vector<int64_t> dst;
+  std::vector<float> weight;
+
+  void add_edge(int64_t src_id, int64_t dst_id, float w) {
+    src.push_back(src_id);
+    dst.push_back(dst_id);
+    weight.push_back(w);
+  }
+  size_t size() const { return src.size(); }
+  void append(GraphCsrEdges *other);
+  void clear();
+};
+
+// Immutable compressed sparse row storage of the out edges of a shard.
+// Node ids are kept sorted and indexed by binary search, the neighbors of
+// ids_[pos] are neighbors_[offsets_[pos], offsets_[pos + 1]), so the sampling
+// only touches contiguous memory and there is no per node heap object.
+class GraphCsr {
+ public:
+  GraphCsr() : is_weighted_(false) {}
+
+  // Build from the edges, the neighbors of a node keep the order of edges.
+  // The weights are dropped when is_weighted is false, otherwise the alias
+  // tables of the nodes of FLAGS_graph_alias_sampler_min_degree neighbors
+  // or more are built as well.
+  void build(GraphCsrEdges *edges, bool is_weighted);
+  // Dump the edges back, used to merge a new load into a built storage.
+  void export_edges(GraphCsrEdges *edges) const;
+  void clear();
+
+  // Return the position of id, or -1 when id has no out edge.
+  int64_t find(int64_t id) const;
+  size_t get_size() const { return ids_.size(); }
+  size_t get_edge_size() const { return neighbors_.size(); }
+  bool is_weighted() const { return is_weighted_; }
+  int64_t get_id(size_t pos) const { return ids_[pos]; }
+  const std::vector<int64_t> &get_ids() const { return ids_; }
+  size_t get_neighbor_size(size_t pos) const {
+    return offsets_[pos + 1] - offsets_[pos];
+  }
+  int64_t get_neighbor_id(size_t pos, int k) const {
+    return neighbors_[offsets_[pos] + k];
+  }
+  float get_neighbor_weight(size_t pos, int k) const {
+    return is_weighted_ ? weights_[offsets_[pos] + k] : 1.0;
+  }
+  size_t memory_size() const;
+
+  // Sample k distinct neighbors of the node at pos and return their index
+  // in the neighbor list, the same as Node::sample_k. Weighted storage
+  // samples proportional to the weights (alias table for the high degree
+  // nodes, Efraimidis-Spirakis for the others), otherwise uniformly (Floyd).
+  std::vector<int> sample_k(size_t pos,
+                            int k,
+                            const std::shared_ptr<std::mt19937_64> rng) const;
+
+ private:
+  std::vector<int> random_sample_k(
+      size_t pos, int k, const std::shared_ptr<std::mt19937_64> rng) const;
+  std::vector<int> weighted_sample_k(
+      size_t pos, int k, const std::shared_ptr<std::mt19937_64> rng) const;
+  // Return the alias table of the node at pos, or nullptr for a low degree
+  // node which is sampled by the weight keys.
+  const AliasTable *get_alias_table(size_t pos) const;
+
+  std::vector<int64_t> ids_;
+  std::vector<int64_t> offsets_;
+  std::vector<int64_t> neighbors_;
+  std::vector<float> weights_;
+  bool is_weighted_;
+  // built with the storage for the high degree nodes, read without a lock
+  std::unordered_map<size_t, AliasTable> alias_tables_;
+};
+
+}  // namespace distributed
+}  // namespace paddle
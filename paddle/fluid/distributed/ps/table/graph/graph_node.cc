@@ -15,6 +15,11 @@
 #include "paddle/fluid/distributed/ps/table/graph/graph_node.h"
 
 #include <cstring>
+
+#include "gflags/gflags.h"
+
+DECLARE_int32(graph_alias_sampler_min_degree);
+
 namespace paddle {
 namespace distributed {
 
@@ -72,7 +77,11 @@ void GraphNode::build_sampler(std::string sample_type) {
   if (sample_type == "random") {
     sampler = new RandomSampler();
   } else if (sample_type == "weighted") {
-    sampler = new WeightedSampler();
+    if ((int64_t)edges->size() >= FLAGS_graph_alias_sampler_min_degree) {
+      sampler = new AliasSampler();
+    } else {
+      sampler = new WeightedSampler();
+    }
   }
   sampler->build(edges);
 }
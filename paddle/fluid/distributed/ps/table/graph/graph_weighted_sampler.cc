@@ -18,7 +18,14 @@
 #include <memory>
 #include <unordered_map>
 
+#include "gflags/gflags.h"
 #include "paddle/fluid/framework/generator.h"
+
+DEFINE_int32(graph_alias_sampler_min_degree,
+             32,
+             "The weighted nodes with at least this many neighbors are "
+             "sampled by the alias table instead of the weight tree.");
+
 namespace paddle {
 namespace distributed {
 
@@ -160,5 +167,77 @@ int WeightedSampler::sample(
   subtract_count_map[this]++;
   return return_idx;
 }
+
+void AliasTable::build(const std::vector<float> &weights) {
+  int n = weights.size();
+  prob_.assign(n, 0);
+  alias_.assign(n, 0);
+  if (n == 0) return;
+  double sum = 0;
+  for (float w : weights) {
+    sum += std::max(w, 0.0f);
+  }
+  std::vector<double> scaled(n);
+  std::vector<int> small, large;
+  for (int i = 0; i < n; i++) {
+    scaled[i] = sum > 0 ? std::max(weights[i], 0.0f) * n / sum : 1.0;
+    alias_[i] = i;
+    if (scaled[i] < 1.0) {
+      small.push_back(i);
+    } else {
+      large.push_back(i);
+    }
+  }
+  while (!small.empty() && !large.empty()) {
+    int s = small.back();
+    int l = large.back();
+    small.pop_back();
+    prob_[s] = scaled[s];
+    alias_[s] = l;
+    scaled[l] -= 1.0 - scaled[s];
+    if (scaled[l] < 1.0) {
+      large.pop_back();
+      small.push_back(l);
+    }
+  }
+  // the rest are 1 up to the rounding error
+  for (int i : large) prob_[i] = 1.0;
+  for (int i : small) prob_[i] = 1.0;
+}
+
+void AliasTable::sample_batch(int num, std::mt19937_64 *rng, int *out) const {
+  const int kChunk = 64;
+  uint64_t rand_buf[kChunk];
+  uint64_t n = prob_.size();
+  const float *prob = prob_.data();
+  const int *alias = alias_.data();
+  for (int start = 0; start < num; start += kChunk) {
+    int len = std::min(kChunk, num - start);
+    for (int i = 0; i < len; i++) {
+      rand_buf[i] = (*rng)();
+    }
+    // the high 32 bits pick the column and the low 32 bits toss the coin
+    for (int i = 0; i < len; i++) {
+      uint64_t col = ((rand_buf[i] >> 32) * n) >> 32;
+      float coin = (rand_buf[i] & 0xFFFFFFFFULL) * (1.0f / 4294967296.0f);
+      out[start + i] = coin < prob[col] ? col : alias[col];
+    }
+  }
+}
+
+void AliasSampler::build(GraphEdgeBlob *edges) { this->edges = edges; }
+
+std::vector<int> AliasSampler::sample_k(
+    int k, const std::shared_ptr<std::mt19937_64> rng) {
+  std::call_once(build_flag_, [this]() {
+    std::vector<float> weights(edges->size());
+    for (size_t i = 0; i < weights.size(); i++) {
+      weights[i] = edges->get_weight(i);
+    }
+    table_.build(weights);
+  });
+  return table_.sample_k(
+      k, rng.get(), [this](int idx) { return edges->get_weight(idx); });
+}
 }  // namespace distributed
 }  // namespace paddle
@@ -13,10 +13,17 @@
 // limitations under the License.
 
 #pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
 #include <ctime>
+#include <limits>
 #include <memory>
+#include <mutex>  // NOLINT
 #include <random>
 #include <unordered_map>
+#include <unordered_set>
+#include <utility>
 #include <vector>
 
 #include "paddle/fluid/distributed/ps/table/graph/graph_edge.h"
@@ -60,5 +67,108 @@ class WeightedSampler : public Sampler {
              std::unordered_map<WeightedSampler *, int> &subtract_count_map,
              float &subtract);
 };
+
+// Vose's alias table, every draw costs one random number and one table
+// lookup no matter how skewed the weights are.
+class AliasTable {
+ public:
+  AliasTable() {}
+  void build(const std::vector<float> &weights);
+  int size() const { return prob_.size(); }
+  // Draw num samples with replacement into out. The random numbers are
+  // generated before the lookups, so the lookup loop has no dependency and
+  // can be vectorized.
+  void sample_batch(int num, std::mt19937_64 *rng, int *out) const;
+  // Draw k distinct indexes, the same distribution as drawing one by one
+  // proportional to the remaining weights. Duplicates are rejected, and the
+  // remaining indexes are drawn by the weight keys when the rejections
+  // exceed the budget. get_weight(i) returns the weight of index i.
+  template <typename WeightFunc>
+  std::vector<int> sample_k(int k,
+                            std::mt19937_64 *rng,
+                            WeightFunc get_weight) const;
+
+ private:
+  std::vector<float> prob_;
+  std::vector<int> alias_;
+};
+
+template <typename WeightFunc>
+std::vector<int> AliasTable::sample_k(int k,
+                                      std::mt19937_64 *rng,
+                                      WeightFunc get_weight) const {
+  const int kLinearCheckLimit = 64;
+  int n = size();
+  std::vector<int> sample_result;
+  if (k >= n) {
+    for (int i = 0; i < n; i++) {
+      sample_result.push_back(i);
+    }
+    return sample_result;
+  }
+  sample_result.reserve(k);
+  std::unordered_set<int> chosen;
+  std::vector<int> draws(k);
+  int budget = 4 * k + 16;
+  while ((int)sample_result.size() < k && budget > 0) {
+    int num = std::min(k - (int)sample_result.size(), budget);
+    budget -= num;
+    sample_batch(num, rng, draws.data());
+    for (int i = 0; i < num && (int)sample_result.size() < k; i++) {
+      bool exist = k <= kLinearCheckLimit
+                       ? std::find(sample_result.begin(),
+                                   sample_result.end(),
+                                   draws[i]) != sample_result.end()
+                       : !chosen.insert(draws[i]).second;
+      if (!exist) {
+        sample_result.push_back(draws[i]);
+      }
+    }
+  }
+  if ((int)sample_result.size() < k) {
+    // a few heavy indexes take most of the weight, draw the rest by the
+    // keys log(u) / w of the indexes not chosen yet
+    std::unordered_set<int> used(sample_result.begin(), sample_result.end());
+    std::uniform_real_distribution<float> distrib(0, 1.0);
+    std::vector<std::pair<float, int>> keys;
+    keys.reserve(n - used.size());
+    for (int i = 0; i < n; i++) {
+      if (used.count(i)) continue;
+      float w = get_weight(i);
+      float u = 1.0 - distrib(*rng);
+      keys.emplace_back(
+          w > 0 ? std::log(u) / w : -std::numeric_limits<float>::infinity(),
+          i);
+    }
+    int remain = k - sample_result.size();
+    std::nth_element(keys.begin(),
+                     keys.begin() + remain,
+                     keys.end(),
+                     [](const std::pair<float, int> &a,
+                        const std::pair<float, int> &b) {
+                       return a.first > b.first;
+                     });
+    for (int i = 0; i < remain; i++) {
+      sample_result.push_back(keys[i].second);
+    }
+  }
+  return sample_result;
+}
+
+// Weighted sampler for the high degree nodes, the alias table is built by
+// the first sample_k and then shared by all the sampling threads.
+class AliasSampler : public Sampler {
+ public:
+  AliasSampler() : edges(nullptr) {}
+  virtual ~AliasSampler() {}
+  virtual void build(GraphEdgeBlob *edges);
+  virtual std::vector<int> sample_k(int k,
+                                    const std::shared_ptr<std::mt19937_64> rng);
+  GraphEdgeBlob *edges;
+
+ private:
+  std::once_flag build_flag_;
+  AliasTable table_;
+};
 }  // namespace distributed
 }  // namespace paddle
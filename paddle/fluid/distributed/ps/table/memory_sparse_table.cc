@@ -13,6 +13,8 @@
 // limitations under the License.
 
 #include <omp.h>
+
+#include <algorithm>
 #include <sstream>
 
 #include "glog/logging.h"
@@ -69,7 +71,7 @@ int32_t MemorySparseTable::InitializeValue() {
           << _avg_local_shard_num
           << " _real_local_shard_num: " << _real_local_shard_num;
 
-  _local_shards.reset(new shard_type[_real_local_shard_num]);
+  _local_shards.reset(CreateShards(_real_local_shard_num));
 
   if (_config.enable_revert()) {
     // calculate merged shard number based on config param;
@@ -93,11 +95,22 @@ int32_t MemorySparseTable::InitializeValue() {
     LOG(INFO) << "merged shard info: [" << _m_sparse_table_shard_num << "|"
               << _m_avg_local_shard_num << "|" << _m_real_local_shard_num
               << "]";
-    _local_shards_new.reset(new shard_type[_real_local_shard_num]);
+    _local_shards_new.reset(CreateShards(_real_local_shard_num));
   }
   return 0;
 }
 
+MemorySparseTable::shard_type* MemorySparseTable::CreateShards(int shard_num) {
+  shard_type* shards = new shard_type[shard_num];
+  if (_config.enable_flat_value_store()) {
+    size_t value_stride = _value_accesor->GetAccessorInfo().dim;
+    for (int i = 0; i < shard_num; ++i) {
+      shards[i].set_value_stride(value_stride);
+    }
+  }
+  return shards;
+}
+
 int32_t MemorySparseTable::Load(const std::string& path,
                                 const std::string& param) {
   std::string table_path = TableDir(path);
@@ -141,9 +154,13 @@ int32_t MemorySparseTable::Load(const std::string& path,
     channel_config.path = file_list[file_start_idx + i];
     VLOG(1) << "MemorySparseTable::load begin load " << channel_config.path
             << " into local shard " << i;
-    channel_config.converter = _value_accesor->Converter(load_param).converter;
-    channel_config.deconverter =
-        _value_accesor->Converter(load_param).deconverter;
+    bool is_binary = IsBinaryPartFile(channel_config.path);
+    if (!is_binary) {
+      channel_config.converter =
+          _value_accesor->Converter(load_param).converter;
+      channel_config.deconverter =
+          _value_accesor->Converter(load_param).deconverter;
+    }
 
     bool is_read_failed = false;
     int retry_num = 0;
@@ -156,18 +173,26 @@ int32_t MemorySparseTable::Load(const std::string& path,
       char* end = NULL;
       auto& shard = _local_shards[i];
       try {
-        while (read_channel->read_line(line_data) == 0 &&
-               line_data.size() > 1) {
-          uint64_t key = std::strtoul(line_data.data(), &end, 10);
-          auto& value = shard[key];
-          value.resize(feature_value_size);
-          int parse_size = _value_accesor->ParseFromString(++end, value.data());
-          value.resize(parse_size);
-
-          // for debug
-          for (int ii = 0; ii < parse_size; ++ii) {
-            VLOG(2) << "MemorySparseTable::load key: " << key << " value " << ii
-                    << ": " << value.data()[ii] << " local_shard: " << i;
+        if (is_binary) {
+          if (LoadBinaryShard(read_channel.get(), &shard) != 0) {
+            err_no = -1;
+          }
+        } else {
+          while (read_channel->read_line(line_data) == 0 &&
+                 line_data.size() > 1) {
+            uint64_t key = std::strtoul(line_data.data(), &end, 10);
+            auto& value = shard[key];
+            value.resize(feature_value_size);
+            int parse_size =
+                _value_accesor->ParseFromString(++end, value.data());
+            value.resize(parse_size);
+
+            // for debug
+            for (int ii = 0; ii < parse_size; ++ii) {
+              VLOG(2) << "MemorySparseTable::load key: " << key << " value "
+                      << ii << ": " << value.data()[ii]
+                      << " local_shard: " << i;
+            }
           }
         }
         read_channel->close();
@@ -196,6 +221,44 @@ int32_t MemorySparseTable::Load(const std::string& path,
   return 0;
 }
 
+bool MemorySparseTable::IsBinaryPartFile(const std::string& path) {
+  const std::string suffix = PSERVER_BINARY_SUFFIX;
+  return path.size() >= suffix.size() &&
+         path.compare(path.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+int32_t MemorySparseTable::LoadBinaryShard(FsReadChannel* read_channel,
+                                           shard_type* shard) {
+  SparseBinaryReader reader(read_channel);
+  if (reader.ReadHeader() != 0) {
+    LOG(ERROR) << "MemorySparseTable binary part file has a bad header";
+    return -1;
+  }
+  size_t feature_value_size =
+      _value_accesor->GetAccessorInfo().size / sizeof(float);
+  if (reader.value_dim() > feature_value_size) {
+    LOG(ERROR) << "MemorySparseTable binary part file value dim "
+               << reader.value_dim() << " exceeds the accessor value size "
+               << feature_value_size;
+    return -1;
+  }
+  int ret = 0;
+  while ((ret = reader.NextBlock()) > 0) {
+    size_t value_bytes = reader.value_size() * sizeof(float);
+    for (size_t k = 0; k < reader.key_num(); ++k) {
+      auto& value = (*shard)[reader.keys()[k]];
+      value.resize(reader.value_size());
+      memcpy(value.data(), reader.value(k), value_bytes);
+    }
+  }
+  if (ret < 0) {
+    LOG(ERROR) << "MemorySparseTable binary part file is truncated or "
+               << "mismatches the checksum";
+    return -1;
+  }
+  return 0;
+}
+
 int32_t MemorySparseTable::LoadPatch(const std::vector<std::string>& file_list,
                                      int load_param) {
   if (!_config.enable_revert()) {
@@ -313,13 +376,25 @@ int32_t MemorySparseTable::Save(const std::string& dirname,
   }
 
   VLOG(0) << "MemorySparseTable::save dirname: " << dirname;
-  int save_param =
-      atoi(param.c_str());  // checkpoint:0  xbox delta:1  xbox base:2
+  // checkpoint:0  xbox delta:1  xbox base:2  batch model:3  patch:5
+  // checkpoint delta:6, only the values dirty since the last checkpoint
+  int save_param = atoi(param.c_str());
+  bool is_checkpoint = save_param == 0 || save_param == 3 || save_param == 6;
+  // a delta has no record of the erased keys, they stay in base + delta
+  if (save_param == 6 && _shrinked_since_checkpoint) {
+    LOG(WARNING) << "MemorySparseTable delta save after a shrink, the "
+                 << "shrinked keys are not removed by loading the delta";
+  }
+  if (save_param == 0 || save_param == 3) {
+    _shrinked_since_checkpoint = false;
+  }
+  bool save_binary = _config.save_binary() && is_checkpoint;
+  uint32_t value_dim = _value_accesor->GetAccessorInfo().size / sizeof(float);
 
   // patch model
   if (save_param == 5) {
     _local_shards_patch_model.reset(_local_shards_new.release());
-    _local_shards_new.reset(new shard_type[_real_local_shard_num]);
+    _local_shards_new.reset(CreateShards(_real_local_shard_num));
     _save_patch_model_thread = std::thread(std::bind(
         &MemorySparseTable::SavePatch, this, std::string(dirname), save_param));
     return 0;
@@ -341,7 +416,14 @@ int32_t MemorySparseTable::Save(const std::string& dirname,
 #pragma omp parallel for schedule(dynamic)
   for (int i = 0; i < _real_local_shard_num; ++i) {
     FsChannelConfig channel_config;
-    if (_config.compress_in_save() && (save_param == 0 || save_param == 3)) {
+    if (save_binary) {
+      channel_config.path =
+          paddle::string::format_string("%s/part-%03d-%05d%s",
+                                        table_path.c_str(),
+                                        _shard_idx,
+                                        file_start_idx + i,
+                                        PSERVER_BINARY_SUFFIX);
+    } else if (_config.compress_in_save() && is_checkpoint) {
       channel_config.path =
           paddle::string::format_string("%s/part-%03d-%05d.gz",
                                         table_path.c_str(),
@@ -353,9 +435,13 @@ int32_t MemorySparseTable::Save(const std::string& dirname,
                                                           _shard_idx,
                                                           file_start_idx + i);
     }
-    channel_config.converter = _value_accesor->Converter(save_param).converter;
-    channel_config.deconverter =
-        _value_accesor->Converter(save_param).deconverter;
+    // the converters of the accessor work on the text lines
+    if (!save_binary) {
+      channel_config.converter =
+          _value_accesor->Converter(save_param).converter;
+      channel_config.deconverter =
+          _value_accesor->Converter(save_param).deconverter;
+    }
     bool is_write_failed = false;
     int feasign_size = 0;
     int retry_num = 0;
@@ -367,29 +453,41 @@ int32_t MemorySparseTable::Save(const std::string& dirname,
       is_write_failed = false;
       auto write_channel =
           _afs_client.open_w(channel_config, 1024 * 1024 * 40, &err_no);
-      for (auto it = shard.begin(); it != shard.end(); ++it) {
+      SparseBinaryWriter binary_writer(write_channel.get(), value_dim);
+      int ret = save_binary ? binary_writer.WriteHeader() : 0;
+      for (auto it = shard.begin(); ret == 0 && it != shard.end(); ++it) {
         if (_config.enable_sparse_table_cache() &&
             (save_param == 1 || save_param == 2) &&
             _value_accesor->Save(it.value().data(), 4)) {
           CostTimer timer10("sprase table top push");
           tk.push(i, _value_accesor->GetField(it.value().data(), "show"));
         }
+        if (save_param == 6 && !it.value().dirty()) {
+          continue;
+        }
 
         if (_value_accesor->Save(it.value().data(), save_param)) {
-          std::string format_value = _value_accesor->ParseToString(
-              it.value().data(), it.value().size());
-          if (0 != write_channel->write_line(paddle::string::format_string(
-                       "%lu %s", it.key(), format_value.c_str()))) {
-            ++retry_num;
-            is_write_failed = true;
-            LOG(ERROR)
-                << "MemorySparseTable save prefix failed, retry it! path:"
-                << channel_config.path << " , retry_num=" << retry_num;
-            break;
+          if (save_binary) {
+            ret = binary_writer.Write(
+                it.key(), it.value().data(), it.value().size());
+          } else {
+            std::string format_value = _value_accesor->ParseToString(
+                it.value().data(), it.value().size());
+            ret = write_channel->write_line(paddle::string::format_string(
+                "%lu %s", it.key(), format_value.c_str()));
           }
           ++feasign_size;
         }
       }
+      if (ret == 0 && save_binary) {
+        ret = binary_writer.Finish();
+      }
+      if (0 != ret) {
+        ++retry_num;
+        is_write_failed = true;
+        LOG(ERROR) << "MemorySparseTable save prefix failed, retry it! path:"
+                   << channel_config.path << " , retry_num=" << retry_num;
+      }
       write_channel->close();
       if (err_no == -1) {
         ++retry_num;
@@ -409,6 +507,9 @@ int32_t MemorySparseTable::Save(const std::string& dirname,
     feasign_size_all += feasign_size;
     for (auto it = shard.begin(); it != shard.end(); ++it) {
       _value_accesor->UpdateStatAfterSave(it.value().data(), save_param);
+      if (is_checkpoint) {
+        it.value().set_dirty(false);
+      }
     }
     LOG(INFO) << "MemorySparseTable save prefix success, path: "
               << channel_config.path << " feasign_size: " << feasign_size;
@@ -784,6 +885,7 @@ int32_t MemorySparseTable::PullSparse(float* pull_values,
                   } else {
                     auto& feature_value = local_shard[key];
                     feature_value.resize(data_size);
+                    feature_value.set_dirty(true);
                     float* data_ptr = feature_value.data();
                     _value_accesor->Create(&data_buffer_ptr, 1);
                     memcpy(
@@ -859,6 +961,8 @@ int32_t MemorySparseTable::PullSparsePtr(char** pull_values,
                 } else {
                   ret = itr.value_ptr();
                 }
+                // the caller updates the value through the pointer
+                ret->set_dirty(true);
                 int pull_data_idx = keys[i].second;
                 pull_values[pull_data_idx] = reinterpret_cast<char*>(ret);
               }
@@ -871,6 +975,115 @@ int32_t MemorySparseTable::PullSparsePtr(char** pull_values,
   return 0;
 }
 
+// the keys updated by an Update call of the accessor in PushSparse, so that
+// the sgd rules run their SIMD kernels on many keys at a time
+static const size_t kPushSparseBatch = 64;
+
+template <typename PushValueFunc>
+int32_t MemorySparseTable::PushSparseShard(
+    int shard_id,
+    const std::vector<std::pair<uint64_t, int>>& keys,
+    PushValueFunc push_value,
+    bool enable_revert) {
+  const size_t value_col =
+      _value_accesor->GetAccessorInfo().size / sizeof(float);
+  const size_t mf_value_col =
+      _value_accesor->GetAccessorInfo().mf_size / sizeof(float);
+  auto& local_shard = _local_shards[shard_id];
+  std::vector<float> create_buffer(value_col);
+  float* create_buffer_ptr = create_buffer.data();
+  // the values not extended to value_col are updated in the buffers, the mf
+  // not needed is dropped when they are copied back
+  std::vector<float> data_buffers(kPushSparseBatch * value_col);
+  std::vector<uint64_t> batch_keys;
+  std::vector<FixedFeatureValue*> batch_features;
+  std::vector<float*> update_values;
+  std::vector<const float*> push_values;
+  batch_keys.reserve(kPushSparseBatch);
+  batch_features.reserve(kPushSparseBatch);
+  update_values.reserve(kPushSparseBatch);
+  push_values.reserve(kPushSparseBatch);
+
+  auto flush = [&]() {
+    _value_accesor->Update(
+        update_values.data(), push_values.data(), update_values.size());
+    for (size_t k = 0; k < batch_features.size(); ++k) {
+      auto* feature_value = batch_features[k];
+      float* value_data = feature_value->data();
+      size_t value_size = feature_value->size();
+      if (value_size != value_col) {
+        if (_value_accesor->NeedExtendMF(update_values[k])) {
+          feature_value->resize(value_col);
+          value_data = feature_value->data();
+          _value_accesor->Create(&value_data, 1);
+        }
+        memcpy(value_data, update_values[k], value_size * sizeof(float));
+      }
+      if (enable_revert) {
+        FixedFeatureValue* feature_value_new =
+            &(_local_shards_new[shard_id][batch_keys[k]]);
+        auto new_size = feature_value->size();
+        feature_value_new->resize(new_size);
+        memcpy(feature_value_new->data(),
+               feature_value->data(),
+               new_size * sizeof(float));
+      }
+    }
+    batch_keys.clear();
+    batch_features.clear();
+    update_values.clear();
+    push_values.clear();
+  };
+
+  for (size_t i = 0; i < keys.size(); ++i) {
+    uint64_t key = keys[i].first;
+    const float* update_data = push_value(keys[i].second);
+    auto itr = local_shard.find(key);
+    if (itr == local_shard.end()) {
+      if (FLAGS_pserver_enable_create_feasign_randomly &&
+          !_value_accesor->CreateValue(1, update_data)) {
+        continue;
+      }
+      auto value_size = value_col - mf_value_col;
+      auto& feature_value = local_shard[key];
+      feature_value.resize(value_size);
+      _value_accesor->Create(&create_buffer_ptr, 1);
+      memcpy(
+          feature_value.data(), create_buffer_ptr, value_size * sizeof(float));
+      itr = local_shard.find(key);
+    }
+    // a key pushed twice is updated in order
+    if (std::find(batch_keys.begin(), batch_keys.end(), key) !=
+        batch_keys.end()) {
+      flush();
+    }
+
+    auto& feature_value = itr.value();
+    feature_value.set_dirty(true);
+    float* value_data = feature_value.data();
+    size_t value_size = feature_value.size();
+    if (value_size != value_col) {
+      float* data_buffer = data_buffers.data() + batch_keys.size() * value_col;
+      memcpy(data_buffer, value_data, value_size * sizeof(float));
+      memset(data_buffer + value_size,
+             0,
+             (value_col - value_size) * sizeof(float));
+      value_data = data_buffer;
+    }
+    batch_keys.push_back(key);
+    batch_features.push_back(&feature_value);
+    update_values.push_back(value_data);
+    push_values.push_back(update_data);
+    if (batch_keys.size() == kPushSparseBatch) {
+      flush();
+    }
+  }
+  if (!batch_keys.empty()) {
+    flush();
+  }
+  return 0;
+}
+
 int32_t MemorySparseTable::PushSparse(const uint64_t* keys,
                                       const float* values,
                                       size_t num) {
@@ -883,76 +1096,19 @@ int32_t MemorySparseTable::PushSparse(const uint64_t* keys,
     task_keys[shard_id].push_back({keys[i], i});
   }
 
-  const size_t value_col =
-      _value_accesor->GetAccessorInfo().size / sizeof(float);
-  size_t mf_value_col =
-      _value_accesor->GetAccessorInfo().mf_size / sizeof(float);
   size_t update_value_col =
       _value_accesor->GetAccessorInfo().update_size / sizeof(float);
 
   for (int shard_id = 0; shard_id < _real_local_shard_num; ++shard_id) {
     tasks[shard_id] = _shards_task_pool[shard_id % _task_pool_size]->enqueue(
-        [this,
-         shard_id,
-         value_col,
-         mf_value_col,
-         update_value_col,
-         values,
-         &task_keys]() -> int {
-          auto& keys = task_keys[shard_id];
-          auto& local_shard = _local_shards[shard_id];
-          auto& local_shard_new = _local_shards_new[shard_id];
-          float data_buffer[value_col];  // NOLINT
-          float* data_buffer_ptr = data_buffer;
-          for (size_t i = 0; i < keys.size(); ++i) {
-            uint64_t key = keys[i].first;
-            uint64_t push_data_idx = keys[i].second;
-            const float* update_data =
-                values + push_data_idx * update_value_col;
-            auto itr = local_shard.find(key);
-            if (itr == local_shard.end()) {
-              if (FLAGS_pserver_enable_create_feasign_randomly &&
-                  !_value_accesor->CreateValue(1, update_data)) {
-                continue;
-              }
-              auto value_size = value_col - mf_value_col;
-              auto& feature_value = local_shard[key];
-              feature_value.resize(value_size);
-              _value_accesor->Create(&data_buffer_ptr, 1);
-              memcpy(feature_value.data(),
-                     data_buffer_ptr,
-                     value_size * sizeof(float));
-              itr = local_shard.find(key);
-            }
-
-            auto& feature_value = itr.value();
-            float* value_data = feature_value.data();
-            size_t value_size = feature_value.size();
-
-            if (value_size == value_col) {  // 已拓展到最大size, 则就地update
-              _value_accesor->Update(&value_data, &update_data, 1);
-            } else {
-              // 拷入buffer区进行update，然后再回填，不需要的mf则回填时抛弃了
-              memcpy(data_buffer_ptr, value_data, value_size * sizeof(float));
-              _value_accesor->Update(&data_buffer_ptr, &update_data, 1);
-
-              if (_value_accesor->NeedExtendMF(data_buffer)) {
-                feature_value.resize(value_col);
-                value_data = feature_value.data();
-                _value_accesor->Create(&value_data, 1);
-              }
-              memcpy(value_data, data_buffer_ptr, value_size * sizeof(float));
-            }
-            if (_config.enable_revert()) {
-              FixedFeatureValue* feature_value_new = &(local_shard_new[key]);
-              auto new_size = feature_value.size();
-              feature_value_new->resize(new_size);
-              memcpy(feature_value_new->data(),
-                     value_data,
-                     new_size * sizeof(float));
-            }
-          }
-          return 0;
+        [this, shard_id, update_value_col, values, &task_keys]() -> int {
+          return PushSparseShard(
+              shard_id,
+              task_keys[shard_id],
+              [values, update_value_col](uint64_t push_data_idx) {
+                return values + push_data_idx * update_value_col;
+              },
+              _config.enable_revert());
         });
   }
 
@@ -973,62 +1129,16 @@ int32_t MemorySparseTable::PushSparse(const uint64_t* keys,
     task_keys[shard_id].push_back({keys[i], i});
   }
 
-  size_t value_col = _value_accesor->GetAccessorInfo().size / sizeof(float);
-  size_t mf_value_col =
-      _value_accesor->GetAccessorInfo().mf_size / sizeof(float);
-  size_t update_value_col =
-      _value_accesor->GetAccessorInfo().update_size / sizeof(float);
-
   for (int shard_id = 0; shard_id < _real_local_shard_num; ++shard_id) {
     tasks[shard_id] = _shards_task_pool[shard_id % _task_pool_size]->enqueue(
-        [this,
-         shard_id,
-         value_col,
-         mf_value_col,
-         update_value_col,
-         values,
-         &task_keys]() -> int {
-          auto& keys = task_keys[shard_id];
-          auto& local_shard = _local_shards[shard_id];
-          float data_buffer[value_col];  // NOLINT
-          float* data_buffer_ptr = data_buffer;
-          for (size_t i = 0; i < keys.size(); ++i) {
-            uint64_t key = keys[i].first;
-            uint64_t push_data_idx = keys[i].second;
-            const float* update_data = values[push_data_idx];
-            auto itr = local_shard.find(key);
-            if (itr == local_shard.end()) {
-              if (FLAGS_pserver_enable_create_feasign_randomly &&
-                  !_value_accesor->CreateValue(1, update_data)) {
-                continue;
-              }
-              auto value_size = value_col - mf_value_col;
-              auto& feature_value = local_shard[key];
-              feature_value.resize(value_size);
-              _value_accesor->Create(&data_buffer_ptr, 1);
-              memcpy(feature_value.data(),
-                     data_buffer_ptr,
-                     value_size * sizeof(float));
-              itr = local_shard.find(key);
-            }
-            auto& feature_value = itr.value();
-            float* value_data = feature_value.data();
-            size_t value_size = feature_value.size();
-            if (value_size == value_col) {  // 已拓展到最大size, 则就地update
-              _value_accesor->Update(&value_data, &update_data, 1);
-            } else {
-              // 拷入buffer区进行update，然后再回填，不需要的mf则回填时抛弃了
-              memcpy(data_buffer_ptr, value_data, value_size * sizeof(float));
-              _value_accesor->Update(&data_buffer_ptr, &update_data, 1);
-              if (_value_accesor->NeedExtendMF(data_buffer)) {
-                feature_value.resize(value_col);
-                value_data = feature_value.data();
-                _value_accesor->Create(&value_data, 1);
-              }
-              memcpy(value_data, data_buffer_ptr, value_size * sizeof(float));
-            }
-          }
-          return 0;
+        [this, shard_id, values, &task_keys]() -> int {
+          return PushSparseShard(
+              shard_id,
+              task_keys[shard_id],
+              [values](uint64_t push_data_idx) {
+                return values[push_data_idx];
+              },
+              false);
         });
   }
 
@@ -1049,10 +1159,19 @@ int32_t MemorySparseTable::Shrink(const std::string& param) {
     for (auto it = shard.begin(); it != shard.end();) {
       if (_value_accesor->Shrink(it.value().data())) {
         it = shard.erase(it);
+        _shrinked_since_checkpoint = true;
       } else {
+        // the decayed value goes to the next delta
+        it.value().set_dirty(true);
         ++it;
       }
     }
+    // give back the slab blocks of the shrinked values
+    if (shard.value_stride() > 0) {
+      size_t freed = shard.compact();
+      VLOG(1) << "MemorySparseTable::Shrink compact shard " << shard_id
+              << ", freed value blocks: " << freed;
+    }
   }
   return 0;
 }
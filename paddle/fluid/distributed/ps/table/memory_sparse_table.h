@@ -29,9 +29,11 @@
 #include "paddle/fluid/distributed/ps/table/accessor.h"
 #include "paddle/fluid/distributed/ps/table/common_table.h"
 #include "paddle/fluid/distributed/ps/table/depends/feature_value.h"
+#include "paddle/fluid/distributed/ps/table/depends/sparse_binary_format.h"
 #include "paddle/fluid/string/string_helper.h"
 
 #define PSERVER_SAVE_SUFFIX ".shard"
+#define PSERVER_BINARY_SUFFIX ".bin"
 
 namespace paddle {
 namespace distributed {
@@ -108,6 +110,18 @@ class MemorySparseTable : public Table {
   virtual void CheckSavePrePatchDone();
 
  protected:
+  shard_type* CreateShards(int shard_num);
+  static bool IsBinaryPartFile(const std::string& path);
+  // loads a part file of SparseBinaryWriter into the shard, -1 if the file
+  // is broken
+  int32_t LoadBinaryShard(FsReadChannel* read_channel, shard_type* shard);
+  // updates the pushed keys of a shard, kPushSparseBatch keys per Update of
+  // the accessor, push_value(idx) gives the push value of the idx-th key
+  template <typename PushValueFunc>
+  int32_t PushSparseShard(int shard_id,
+                          const std::vector<std::pair<uint64_t, int>>& keys,
+                          PushValueFunc push_value,
+                          bool enable_revert);
   virtual int32_t SavePatch(const std::string& path, int save_param);
   virtual int32_t LoadPatch(const std::vector<std::string>& file_list,
                             int save_param);
@@ -125,6 +139,8 @@ class MemorySparseTable : public Table {
   int _m_sparse_table_shard_num;
   float _shard_merge_rate{1.0f};
   double _local_show_threshold{0.0};
+  // set by Shrink when it erases keys, a delta can not record the erasure
+  bool _shrinked_since_checkpoint{false};
 
   std::unique_ptr<shard_type[]> _local_shards_new;
   std::unique_ptr<shard_type[]> _local_shards_patch_model;
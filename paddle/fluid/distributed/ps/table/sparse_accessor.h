@@ -166,12 +166,16 @@ class SparseAccessor : public ValueAccessor {
   int32_t ParseFromString(const std::string& str, float* v) override;
   virtual bool CreateValue(int type, const float* value);
 
-  // 这个接口目前只用来取show
+  // 这个接口目前只用来取show和show_click_score
   float GetField(float* value, const std::string& name) override {
     // CHECK(name == "show");
     if (name == "show") {
       return sparse_feature_value.Show(value);
     }
+    if (name == "show_click_score") {
+      return ShowClickScore(sparse_feature_value.Show(value),
+                            sparse_feature_value.Click(value));
+    }
     return 0.0;
   }
 
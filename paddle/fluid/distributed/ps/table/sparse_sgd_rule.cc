@@ -15,6 +15,9 @@
 #include "paddle/fluid/distributed/ps/table/sparse_sgd_rule.h"
 
 #include <gflags/gflags.h>
+#ifdef __AVX__
+#include <immintrin.h>
+#endif
 
 #include "glog/logging.h"
 
@@ -23,6 +26,151 @@ DEFINE_bool(enable_show_scale_gradient, true, "enable show scale gradient");
 namespace paddle {
 namespace distributed {
 
+namespace {
+
+// The float vectors of the batched kernels. Only the isas compiled in get a
+// specialization, SGDKernelIsa() never selects the others.
+template <platform::cpu_isa_t isa>
+struct SGDVec;
+
+#ifdef __AVX__
+template <>
+struct SGDVec<platform::avx> {
+  typedef __m256 Reg;
+  static const size_t kWidth = 8;
+  static Reg Load(const float* x) { return _mm256_loadu_ps(x); }
+  static void Store(float* x, Reg v) { _mm256_storeu_ps(x, v); }
+  static Reg Set1(float x) { return _mm256_set1_ps(x); }
+  static Reg Add(Reg a, Reg b) { return _mm256_add_ps(a, b); }
+  static Reg Mul(Reg a, Reg b) { return _mm256_mul_ps(a, b); }
+  static Reg Div(Reg a, Reg b) { return _mm256_div_ps(a, b); }
+  static Reg Sqrt(Reg a) { return _mm256_sqrt_ps(a); }
+  // a * b + c
+  static Reg MulAdd(Reg a, Reg b, Reg c) { return Add(Mul(a, b), c); }
+  // c - a * b
+  static Reg NMulAdd(Reg a, Reg b, Reg c) {
+    return _mm256_sub_ps(c, Mul(a, b));
+  }
+  // the same as BoundValue, max_ps returns the bound for a NaN
+  static Reg Bound(Reg x, Reg min_bound, Reg max_bound) {
+    return _mm256_min_ps(_mm256_max_ps(x, min_bound), max_bound);
+  }
+  static float Sum(Reg v) {
+    __m128 x =
+        _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+    x = _mm_hadd_ps(x, x);
+    x = _mm_hadd_ps(x, x);
+    return _mm_cvtss_f32(x);
+  }
+};
+#endif
+
+#if defined(__AVX2__) && defined(__FMA__)
+template <>
+struct SGDVec<platform::avx2> : public SGDVec<platform::avx> {
+  static Reg MulAdd(Reg a, Reg b, Reg c) { return _mm256_fmadd_ps(a, b, c); }
+  static Reg NMulAdd(Reg a, Reg b, Reg c) {
+    return _mm256_fnmadd_ps(a, b, c);
+  }
+};
+#endif
+
+#ifdef __AVX512F__
+template <>
+struct SGDVec<platform::avx512f> {
+  typedef __m512 Reg;
+  static const size_t kWidth = 16;
+  static Reg Load(const float* x) { return _mm512_loadu_ps(x); }
+  static void Store(float* x, Reg v) { _mm512_storeu_ps(x, v); }
+  static Reg Set1(float x) { return _mm512_set1_ps(x); }
+  static Reg Add(Reg a, Reg b) { return _mm512_add_ps(a, b); }
+  static Reg Mul(Reg a, Reg b) { return _mm512_mul_ps(a, b); }
+  static Reg Div(Reg a, Reg b) { return _mm512_div_ps(a, b); }
+  static Reg Sqrt(Reg a) { return _mm512_sqrt_ps(a); }
+  static Reg MulAdd(Reg a, Reg b, Reg c) { return _mm512_fmadd_ps(a, b, c); }
+  static Reg NMulAdd(Reg a, Reg b, Reg c) {
+    return _mm512_fnmadd_ps(a, b, c);
+  }
+  static Reg Bound(Reg x, Reg min_bound, Reg max_bound) {
+    return _mm512_min_ps(_mm512_max_ps(x, min_bound), max_bound);
+  }
+  static float Sum(Reg v) { return _mm512_reduce_add_ps(v); }
+};
+#endif
+
+platform::cpu_isa_t SGDKernelIsa() {
+#ifdef __AVX512F__
+  if (platform::MayIUse(platform::avx512f)) {
+    return platform::avx512f;
+  }
+#endif
+#if defined(__AVX2__) && defined(__FMA__)
+  if (platform::MayIUse(platform::avx2)) {
+    return platform::avx2;
+  }
+#endif
+#ifdef __AVX__
+  if (platform::MayIUse(platform::avx)) {
+    return platform::avx;
+  }
+#endif
+  return platform::isa_any;
+}
+
+}  // namespace
+
+// runs the UpdateValueBatch<SGDVec<isa>> of the rule, or the scalar
+// UpdateValueWork per key without SIMD
+#ifdef __AVX512F__
+#define SGD_CASE_AVX512F(...)                                    \
+  case platform::avx512f:                                        \
+    UpdateValueBatch<SGDVec<platform::avx512f>>(__VA_ARGS__);    \
+    return;
+#else
+#define SGD_CASE_AVX512F(...)
+#endif
+#if defined(__AVX2__) && defined(__FMA__)
+#define SGD_CASE_AVX2(...)                                       \
+  case platform::avx2:                                           \
+    UpdateValueBatch<SGDVec<platform::avx2>>(__VA_ARGS__);       \
+    return;
+#else
+#define SGD_CASE_AVX2(...)
+#endif
+#ifdef __AVX__
+#define SGD_CASE_AVX(...)                                        \
+  case platform::avx:                                            \
+    UpdateValueBatch<SGDVec<platform::avx>>(__VA_ARGS__);        \
+    return;
+#else
+#define SGD_CASE_AVX(...)
+#endif
+#define SGD_BATCH_DISPATCH(...)                                 \
+  switch (_isa) {                                               \
+    SGD_CASE_AVX512F(__VA_ARGS__)                               \
+    SGD_CASE_AVX2(__VA_ARGS__)                                  \
+    SGD_CASE_AVX(__VA_ARGS__)                                   \
+    default:                                                    \
+      SparseValueSGDRule::UpdateValueBatchWork(__VA_ARGS__);    \
+  }
+
+SparseValueSGDRule::SparseValueSGDRule() : _isa(SGDKernelIsa()) {}
+
+void SparseValueSGDRule::UpdateValueBatchWork(size_t num,
+                                              float** values,
+                                              size_t w_offset,
+                                              size_t sgd_offset,
+                                              const float** push_values,
+                                              size_t grad_offset,
+                                              const float* scales) {
+  for (size_t k = 0; k < num; ++k) {
+    UpdateValueWork(values[k] + w_offset,
+                    values[k] + sgd_offset,
+                    push_values[k] + grad_offset,
+                    scales[k]);
+  }
+}
+
 void SparseNaiveSGDRule::LoadConfig(const SparseCommonSGDRuleParameter& param,
                                     size_t emb_dim) {
   _embedding_dim = emb_dim;
@@ -106,6 +254,56 @@ void SparseAdaGradSGDRule::UpdateValueWork(float* w,
   g2sum += add_g2sum / _embedding_dim;
 }
 
+void SparseAdaGradSGDRule::UpdateValueBatchWork(size_t num,
+                                                float** values,
+                                                size_t w_offset,
+                                                size_t sgd_offset,
+                                                const float** push_values,
+                                                size_t grad_offset,
+                                                const float* scales) {
+  SGD_BATCH_DISPATCH(
+      num, values, w_offset, sgd_offset, push_values, grad_offset, scales);
+}
+
+template <class V>
+void SparseAdaGradSGDRule::UpdateValueBatch(size_t num,
+                                            float** values,
+                                            size_t w_offset,
+                                            size_t sgd_offset,
+                                            const float** push_values,
+                                            size_t grad_offset,
+                                            const float* scales) {
+  const size_t end = _embedding_dim - _embedding_dim % V::kWidth;
+  const auto min_bound = V::Set1(_min_bound);
+  const auto max_bound = V::Set1(_max_bound);
+  for (size_t k = 0; k < num; ++k) {
+    float* w = values[k] + w_offset;
+    float& g2sum = values[k][sgd_offset + G2SumIndex()];
+    const float* grad = push_values[k] + grad_offset;
+    float scale = scales[k];
+    double ratio = sqrt(_initial_g2sum / (_initial_g2sum + g2sum));
+    const auto lr = V::Set1(learning_rate_ * ratio / scale);
+    const auto inv_scale = V::Set1(1.0f / scale);
+    auto sum = V::Set1(0.0f);
+    for (size_t i = 0; i < end; i += V::kWidth) {
+      auto g = V::Load(grad + i);
+      V::Store(w + i,
+               V::Bound(V::NMulAdd(lr, g, V::Load(w + i)), min_bound,
+                        max_bound));
+      auto scaled_grad = V::Mul(g, inv_scale);
+      sum = V::MulAdd(scaled_grad, scaled_grad, sum);
+    }
+    double add_g2sum = V::Sum(sum);
+    for (size_t i = end; i < _embedding_dim; i++) {
+      double scaled_grad = grad[i] / scale;
+      w[i] -= learning_rate_ * scaled_grad * ratio;
+      BoundValue(w[i]);
+      add_g2sum += scaled_grad * scaled_grad;
+    }
+    g2sum += add_g2sum / _embedding_dim;
+  }
+}
+
 void SparseAdaGradSGDRule::InitValueWork(float* value,
                                          float* sgd,
                                          bool zero_init) {
@@ -159,6 +357,58 @@ void StdAdaGradSGDRule::UpdateValueWork(float* w,
   }
 }
 
+void StdAdaGradSGDRule::UpdateValueBatchWork(size_t num,
+                                             float** values,
+                                             size_t w_offset,
+                                             size_t sgd_offset,
+                                             const float** push_values,
+                                             size_t grad_offset,
+                                             const float* scales) {
+  SGD_BATCH_DISPATCH(
+      num, values, w_offset, sgd_offset, push_values, grad_offset, scales);
+}
+
+template <class V>
+void StdAdaGradSGDRule::UpdateValueBatch(size_t num,
+                                         float** values,
+                                         size_t w_offset,
+                                         size_t sgd_offset,
+                                         const float** push_values,
+                                         size_t grad_offset,
+                                         const float* scales) {
+  const size_t end = _embedding_dim - _embedding_dim % V::kWidth;
+  const auto min_bound = V::Set1(_min_bound);
+  const auto max_bound = V::Set1(_max_bound);
+  const auto lr = V::Set1(learning_rate_);
+  const auto initial_g2sum = V::Set1(_initial_g2sum);
+  for (size_t k = 0; k < num; ++k) {
+    float* w = values[k] + w_offset;
+    float* g2sum = values[k] + sgd_offset + G2SumIndex();
+    const float* grad = push_values[k] + grad_offset;
+    float scale = scales[k];
+    const auto inv_scale = V::Set1(1.0f / scale);
+    for (size_t i = 0; i < end; i += V::kWidth) {
+      auto scaled_grad = V::Mul(V::Load(grad + i), inv_scale);
+      auto g2 = V::Load(g2sum + i);
+      auto ratio = V::Sqrt(V::Div(initial_g2sum, V::Add(initial_g2sum, g2)));
+      V::Store(w + i,
+               V::Bound(V::NMulAdd(V::Mul(lr, scaled_grad),
+                                   ratio,
+                                   V::Load(w + i)),
+                        min_bound,
+                        max_bound));
+      V::Store(g2sum + i, V::MulAdd(scaled_grad, scaled_grad, g2));
+    }
+    for (size_t i = end; i < _embedding_dim; i++) {
+      double scaled_grad = grad[i] / scale;
+      w[i] -= learning_rate_ * scaled_grad *
+              sqrt(_initial_g2sum / (_initial_g2sum + g2sum[i]));
+      BoundValue(w[i]);
+      g2sum[i] += scaled_grad * scaled_grad;
+    }
+  }
+}
+
 void StdAdaGradSGDRule::InitValueWork(float* value,
                                       float* sgd,
                                       bool zero_init) {
@@ -227,6 +477,72 @@ void SparseAdamSGDRule::UpdateValueWork(float* w,
   (*beta2_pow) *= _beta2_decay_rate;
 }
 
+void SparseAdamSGDRule::UpdateValueBatchWork(size_t num,
+                                             float** values,
+                                             size_t w_offset,
+                                             size_t sgd_offset,
+                                             const float** push_values,
+                                             size_t grad_offset,
+                                             const float* scales) {
+  SGD_BATCH_DISPATCH(
+      num, values, w_offset, sgd_offset, push_values, grad_offset, scales);
+}
+
+template <class V>
+void SparseAdamSGDRule::UpdateValueBatch(size_t num,
+                                         float** values,
+                                         size_t w_offset,
+                                         size_t sgd_offset,
+                                         const float** push_values,
+                                         size_t grad_offset,
+                                         const float* scales) {
+  const size_t end = _embedding_dim - _embedding_dim % V::kWidth;
+  const auto min_bound = V::Set1(_min_bound);
+  const auto max_bound = V::Set1(_max_bound);
+  const auto beta1 = V::Set1(_beta1_decay_rate);
+  const auto beta2 = V::Set1(_beta2_decay_rate);
+  const auto one_minus_beta1 = V::Set1(1 - _beta1_decay_rate);
+  const auto one_minus_beta2 = V::Set1(1 - _beta2_decay_rate);
+  const auto epsilon = V::Set1(_ada_epsilon);
+  for (size_t k = 0; k < num; ++k) {
+    float* w = values[k] + w_offset;
+    float* sgd = values[k] + sgd_offset;
+    float* gsum = sgd + GSumIndex();
+    float* g2sum = sgd + G2SumIndex();
+    float* beta1_pow = sgd + Beta1PowIndex();
+    float* beta2_pow = sgd + Beta2PowIndex();
+    const float* g = push_values[k] + grad_offset;
+
+    float lr = learning_rate_;
+    lr *= sqrt(1 - *beta2_pow) / (1 - *beta1_pow);
+    const auto lr_vec = V::Set1(lr);
+    for (size_t i = 0; i < end; i += V::kWidth) {
+      auto grad = V::Load(g + i);
+      auto new_gsum =
+          V::MulAdd(beta1, V::Load(gsum + i), V::Mul(one_minus_beta1, grad));
+      auto new_g2sum = V::MulAdd(beta2,
+                                 V::Load(g2sum + i),
+                                 V::Mul(V::Mul(one_minus_beta2, grad), grad));
+      V::Store(gsum + i, new_gsum);
+      V::Store(g2sum + i, new_g2sum);
+      auto delta = V::Div(new_gsum, V::Add(V::Sqrt(new_g2sum), epsilon));
+      V::Store(w + i,
+               V::Bound(V::NMulAdd(lr_vec, delta, V::Load(w + i)),
+                        min_bound,
+                        max_bound));
+    }
+    for (size_t i = end; i < _embedding_dim; i++) {
+      gsum[i] = _beta1_decay_rate * gsum[i] + (1 - _beta1_decay_rate) * g[i];
+      g2sum[i] =
+          _beta2_decay_rate * g2sum[i] + (1 - _beta2_decay_rate) * g[i] * g[i];
+      w[i] = w[i] - lr * (gsum[i] / (sqrt(g2sum[i]) + _ada_epsilon));
+      BoundValue(w[i]);
+    }
+    (*beta1_pow) *= _beta1_decay_rate;
+    (*beta2_pow) *= _beta2_decay_rate;
+  }
+}
+
 void SparseAdamSGDRule::InitValueWork(float* value,
                                       float* sgd,
                                       bool zero_init) {
@@ -310,6 +626,81 @@ void SparseSharedAdamSGDRule::UpdateValueWork(float* w,
   (*beta2_pow) *= _beta2_decay_rate;
 }
 
+void SparseSharedAdamSGDRule::UpdateValueBatchWork(size_t num,
+                                                   float** values,
+                                                   size_t w_offset,
+                                                   size_t sgd_offset,
+                                                   const float** push_values,
+                                                   size_t grad_offset,
+                                                   const float* scales) {
+  SGD_BATCH_DISPATCH(
+      num, values, w_offset, sgd_offset, push_values, grad_offset, scales);
+}
+
+template <class V>
+void SparseSharedAdamSGDRule::UpdateValueBatch(size_t num,
+                                               float** values,
+                                               size_t w_offset,
+                                               size_t sgd_offset,
+                                               const float** push_values,
+                                               size_t grad_offset,
+                                               const float* scales) {
+  const size_t end = _embedding_dim - _embedding_dim % V::kWidth;
+  const auto min_bound = V::Set1(_min_bound);
+  const auto max_bound = V::Set1(_max_bound);
+  const auto one_minus_beta1 = V::Set1(1 - _beta1_decay_rate);
+  const auto one_minus_beta2 = V::Set1(1 - _beta2_decay_rate);
+  const auto epsilon = V::Set1(_ada_epsilon);
+  for (size_t k = 0; k < num; ++k) {
+    float* w = values[k] + w_offset;
+    float* sgd = values[k] + sgd_offset;
+    float* gsum = sgd + GSumIndex();
+    float* g2sum = sgd + G2SumIndex();
+    float* beta1_pow = sgd + Beta1PowIndex();
+    float* beta2_pow = sgd + Beta2PowIndex();
+    const float* g = push_values[k] + grad_offset;
+
+    float lr = learning_rate_;
+    float gsum_ = *gsum;
+    float g2sum_ = *g2sum;
+    lr *= sqrt(1 - *beta2_pow) / (1 - *beta1_pow);
+    const auto lr_vec = V::Set1(lr);
+    const auto decayed_gsum = V::Set1(_beta1_decay_rate * gsum_);
+    const auto decayed_g2sum = V::Set1(_beta2_decay_rate * g2sum_);
+    auto sum_gsum_vec = V::Set1(0.0f);
+    auto sum_g2sum_vec = V::Set1(0.0f);
+    for (size_t i = 0; i < end; i += V::kWidth) {
+      auto grad = V::Load(g + i);
+      auto new_gsum = V::MulAdd(one_minus_beta1, grad, decayed_gsum);
+      auto new_g2sum =
+          V::MulAdd(V::Mul(one_minus_beta2, grad), grad, decayed_g2sum);
+      auto delta = V::Div(new_gsum, V::Add(V::Sqrt(new_g2sum), epsilon));
+      V::Store(w + i,
+               V::Bound(V::NMulAdd(lr_vec, delta, V::Load(w + i)),
+                        min_bound,
+                        max_bound));
+      sum_gsum_vec = V::Add(sum_gsum_vec, new_gsum);
+      sum_g2sum_vec = V::Add(sum_g2sum_vec, new_g2sum);
+    }
+    double sum_gsum = V::Sum(sum_gsum_vec);
+    double sum_g2sum = V::Sum(sum_g2sum_vec);
+    for (size_t i = end; i < _embedding_dim; i++) {
+      double new_gsum =
+          _beta1_decay_rate * gsum_ + (1 - _beta1_decay_rate) * g[i];
+      double new_g2sum =
+          _beta2_decay_rate * g2sum_ + (1 - _beta2_decay_rate) * g[i] * g[i];
+      w[i] = w[i] - lr * (new_gsum / (sqrt(new_g2sum) + _ada_epsilon));
+      BoundValue(w[i]);
+      sum_gsum += new_gsum;
+      sum_g2sum += new_g2sum;
+    }
+    (*gsum) = sum_gsum / _embedding_dim;
+    (*g2sum) = sum_g2sum / _embedding_dim;
+    (*beta1_pow) *= _beta1_decay_rate;
+    (*beta2_pow) *= _beta2_decay_rate;
+  }
+}
+
 void SparseSharedAdamSGDRule::InitValueWork(float* value,
                                             float* sgd,
                                             bool zero_init) {
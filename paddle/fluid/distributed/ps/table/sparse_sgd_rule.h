@@ -22,13 +22,14 @@
 #include "paddle/fluid/distributed/common/local_random.h"  // for local_uniform_real_distribution
 #include "paddle/fluid/distributed/common/registerer.h"
 #include "paddle/fluid/distributed/the_one_ps.pb.h"
+#include "paddle/fluid/platform/cpu_info.h"
 
 namespace paddle {
 namespace distributed {
 
 class SparseValueSGDRule {
  public:
-  SparseValueSGDRule() {}
+  SparseValueSGDRule();
   virtual ~SparseValueSGDRule() {}
   virtual void LoadConfig(const SparseCommonSGDRuleParameter& param,
                           size_t emb_dim) {
@@ -39,6 +40,17 @@ class SparseValueSGDRule {
                                float* sgd,
                                const float* push_value,
                                float scale) = 0;
+  // updates num keys, the weights and the sgd states of the i-th key are at
+  // values[i] + w_offset and values[i] + sgd_offset, its gradients are at
+  // push_values[i] + grad_offset. The rules vectorize the dims of every key
+  // with the widest SIMD of the cpu.
+  virtual void UpdateValueBatchWork(size_t num,
+                                    float** values,
+                                    size_t w_offset,
+                                    size_t sgd_offset,
+                                    const float** push_values,
+                                    size_t grad_offset,
+                                    const float* scales);
   virtual void InitValueWork(float* value, float* sgd, bool zero_init) = 0;
   virtual size_t Dim() = 0;
   const std::string& GetName() const { return _name; }
@@ -51,6 +63,16 @@ class SparseValueSGDRule {
                    float scale = 1) {
     UpdateValueWork(w, sgd, push_value, scale);
   }
+  void UpdateValue(size_t num,
+                   float** values,
+                   size_t w_offset,
+                   size_t sgd_offset,
+                   const float** push_values,
+                   size_t grad_offset,
+                   const float* scales) {
+    UpdateValueBatchWork(
+        num, values, w_offset, sgd_offset, push_values, grad_offset, scales);
+  }
   template <class T>
   void BoundValue(T& w) {  // NOLINT
     if (!(w >= _min_bound)) {
@@ -67,6 +89,8 @@ class SparseValueSGDRule {
   float _max_bound;
   float _initial_range;
   size_t _embedding_dim;
+  // the isa of the batched kernels, isa_any runs UpdateValueWork per key
+  platform::cpu_isa_t _isa;
 
  private:
   std::string _name;
@@ -97,11 +121,27 @@ class SparseAdaGradSGDRule : public SparseValueSGDRule {
                                float* sgd,
                                const float* push_value,
                                float scale);
+  virtual void UpdateValueBatchWork(size_t num,
+                                    float** values,
+                                    size_t w_offset,
+                                    size_t sgd_offset,
+                                    const float** push_values,
+                                    size_t grad_offset,
+                                    const float* scales);
   virtual void InitValueWork(float* value, float* sgd, bool zero_init);
   virtual size_t Dim() { return 1; }
   size_t G2SumIndex() { return 0; }
 
  private:
+  template <class V>
+  void UpdateValueBatch(size_t num,
+                        float** values,
+                        size_t w_offset,
+                        size_t sgd_offset,
+                        const float** push_values,
+                        size_t grad_offset,
+                        const float* scales);
+
   float learning_rate_;
   float _initial_g2sum;
 };
@@ -114,11 +154,27 @@ class StdAdaGradSGDRule : public SparseValueSGDRule {
                                float* sgd,
                                const float* push_value,
                                float scale);
+  virtual void UpdateValueBatchWork(size_t num,
+                                    float** values,
+                                    size_t w_offset,
+                                    size_t sgd_offset,
+                                    const float** push_values,
+                                    size_t grad_offset,
+                                    const float* scales);
   virtual void InitValueWork(float* value, float* sgd, bool zero_init);
   virtual size_t Dim() { return _embedding_dim; }
   size_t G2SumIndex() { return 0; }
 
  private:
+  template <class V>
+  void UpdateValueBatch(size_t num,
+                        float** values,
+                        size_t w_offset,
+                        size_t sgd_offset,
+                        const float** push_values,
+                        size_t grad_offset,
+                        const float* scales);
+
   float learning_rate_;
   float _initial_g2sum;
 };
@@ -131,6 +187,13 @@ class SparseAdamSGDRule : public SparseValueSGDRule {
                                float* sgd,
                                const float* push_value,
                                float scale);
+  virtual void UpdateValueBatchWork(size_t num,
+                                    float** values,
+                                    size_t w_offset,
+                                    size_t sgd_offset,
+                                    const float** push_values,
+                                    size_t grad_offset,
+                                    const float* scales);
   virtual void InitValueWork(float* value, float* sgd, bool zero_init);
   virtual size_t Dim() { return _embedding_dim * 2 + 2; }
   size_t GSumIndex() { return 0; }
@@ -139,6 +202,15 @@ class SparseAdamSGDRule : public SparseValueSGDRule {
   size_t Beta2PowIndex() { return Beta1PowIndex() + 1; }
 
  protected:
+  template <class V>
+  void UpdateValueBatch(size_t num,
+                        float** values,
+                        size_t w_offset,
+                        size_t sgd_offset,
+                        const float** push_values,
+                        size_t grad_offset,
+                        const float* scales);
+
   float learning_rate_;
   float _beta1_decay_rate;
   float _beta2_decay_rate;
@@ -153,6 +225,13 @@ class SparseSharedAdamSGDRule : public SparseValueSGDRule {
                                float* sgd,
                                const float* push_value,
                                float scale);
+  virtual void UpdateValueBatchWork(size_t num,
+                                    float** values,
+                                    size_t w_offset,
+                                    size_t sgd_offset,
+                                    const float** push_values,
+                                    size_t grad_offset,
+                                    const float* scales);
   virtual void InitValueWork(float* value, float* sgd, bool zero_init);
   virtual size_t Dim() { return 4; }
   size_t GSumIndex() { return 0; }
@@ -161,6 +240,15 @@ class SparseSharedAdamSGDRule : public SparseValueSGDRule {
   size_t Beta2PowIndex() { return Beta1PowIndex() + 1; }
 
  protected:
+  template <class V>
+  void UpdateValueBatch(size_t num,
+                        float** values,
+                        size_t w_offset,
+                        size_t sgd_offset,
+                        const float** push_values,
+                        size_t grad_offset,
+                        const float* scales);
+
   float learning_rate_;
   float _beta1_decay_rate;
   float _beta2_decay_rate;
@@ -14,6 +14,9 @@
 
 #include "paddle/fluid/distributed/ps/table/ssd_sparse_table.h"
 
+#include <algorithm>
+#include <functional>
+
 #include "paddle/fluid/distributed/common/cost_timer.h"
 #include "paddle/fluid/distributed/common/local_random.h"
 #include "paddle/fluid/distributed/common/topk_calculator.h"
@@ -26,6 +29,16 @@ DECLARE_bool(pserver_enable_create_feasign_randomly);
 DEFINE_bool(pserver_open_strict_check, false, "pserver_open_strict_check");
 DEFINE_string(rocksdb_path, "database", "path of sparse table rocksdb file");
 DEFINE_int32(pserver_load_batch_size, 5000, "load batch size for ssd");
+DEFINE_int32(pserver_rocksdb_block_cache_mb,
+             64,
+             "the size of rocksdb block cache in MB");
+DEFINE_bool(pserver_rocksdb_enable_compression,
+            false,
+            "compress the bottommost level of rocksdb with snappy");
+DEFINE_double(pserver_ssd_cache_evict_rate,
+              0.1,
+              "the rate of capacity evicted to rocksdb when the memory of "
+              "ssd sparse table is full");
 
 namespace paddle {
 namespace distributed {
@@ -33,7 +46,15 @@ namespace distributed {
 int32_t SSDSparseTable::Initialize() {
   MemorySparseTable::Initialize();
   _db = paddle::distributed::RocksDBHandler::GetInstance();
-  _db->initialize(FLAGS_rocksdb_path, _real_local_shard_num);
+  _db->initialize(FLAGS_rocksdb_path,
+                  _real_local_shard_num,
+                  FLAGS_pserver_rocksdb_block_cache_mb,
+                  FLAGS_pserver_rocksdb_enable_compression);
+  if (_config.ssd_dram_cache_capacity() > 0 && _real_local_shard_num > 0) {
+    _shard_cache_capacity =
+        (_config.ssd_dram_cache_capacity() + _real_local_shard_num - 1) /
+        _real_local_shard_num;
+  }
   return 0;
 }
 
@@ -102,49 +123,39 @@ int32_t SSDSparseTable::PullSparse(float* pull_values,
                 auto& local_shard = _local_shards[shard_id];
                 float data_buffer[value_size];  // NOLINT
                 float* data_buffer_ptr = data_buffer;
+                // the pulled values are copied out, so the cold values can
+                // be evicted here, but not in PullSparsePtr
+                EvictColdValues(shard_id);
+                std::vector<FixedFeatureValue*> values;
+                LoadValues(shard_id, keys, &values);
                 for (size_t i = 0; i < keys.size(); ++i) {
                   uint64_t key = keys[i].first;
-                  auto itr = local_shard.find(key);
+                  FixedFeatureValue* value = values[i];
+                  if (value == NULL) {
+                    // created by the same key earlier in this batch
+                    auto itr = local_shard.find(key);
+                    if (itr != local_shard.end()) {
+                      value = itr.value_ptr();
+                    }
+                  }
                   size_t data_size = value_size - mf_value_size;
-                  if (itr == local_shard.end()) {
-                    // pull rocksdb
-                    std::string tmp_string("");
-                    if (_db->get(shard_id,
-                                 reinterpret_cast<char*>(&key),
-                                 sizeof(uint64_t),
-                                 tmp_string) > 0) {
-                      ++missed_keys;
-                      if (FLAGS_pserver_create_value_when_push) {
-                        memset(data_buffer, 0, sizeof(float) * data_size);
-                      } else {
-                        auto& feature_value = local_shard[key];
-                        feature_value.resize(data_size);
-                        float* data_ptr =
-                            const_cast<float*>(feature_value.data());
-                        _value_accesor->Create(&data_buffer_ptr, 1);
-                        memcpy(data_ptr,
-                               data_buffer_ptr,
-                               data_size * sizeof(float));
-                      }
+                  if (value == NULL) {
+                    ++missed_keys;
+                    if (FLAGS_pserver_create_value_when_push) {
+                      memset(data_buffer, 0, sizeof(float) * data_size);
                     } else {
-                      data_size = tmp_string.size() / sizeof(float);
-                      memcpy(data_buffer_ptr,
-                             paddle::string::str_to_float(tmp_string),
-                             data_size * sizeof(float));
-                      // from rocksdb to mem
                       auto& feature_value = local_shard[key];
                       feature_value.resize(data_size);
-                      memcpy(const_cast<float*>(feature_value.data()),
-                             data_buffer_ptr,
-                             data_size * sizeof(float));
-                      _db->del_data(shard_id,
-                                    reinterpret_cast<char*>(&key),
-                                    sizeof(uint64_t));
+                      float* data_ptr =
+                          const_cast<float*>(feature_value.data());
+                      _value_accesor->Create(&data_buffer_ptr, 1);
+                      memcpy(
+                          data_ptr, data_buffer_ptr, data_size * sizeof(float));
                     }
                   } else {
-                    data_size = itr.value().size();
+                    data_size = value->size();
                     memcpy(data_buffer_ptr,
-                           itr.value().data(),
+                           value->data(),
                            data_size * sizeof(float));
                   }
                   for (size_t mf_idx = data_size; mf_idx < value_size;
@@ -203,45 +214,27 @@ int32_t SSDSparseTable::PullSparsePtr(char** pull_values,
                 auto& local_shard = _local_shards[shard_id];
                 float data_buffer[value_size];  // NOLINT
                 float* data_buffer_ptr = data_buffer;
+                std::vector<FixedFeatureValue*> values;
+                LoadValues(shard_id, keys, &values);
                 for (size_t i = 0; i < keys.size(); ++i) {
                   uint64_t key = keys[i].first;
-                  auto itr = local_shard.find(key);
                   size_t data_size = value_size - mf_value_size;
-                  FixedFeatureValue* ret = NULL;
-                  if (itr == local_shard.end()) {
-                    // pull rocksdb
-                    std::string tmp_string("");
-                    if (_db->get(shard_id,
-                                 reinterpret_cast<char*>(&key),
-                                 sizeof(uint64_t),
-                                 tmp_string) > 0) {
-                      ++missed_keys;
-                      auto& feature_value = local_shard[key];
-                      feature_value.resize(data_size);
-                      float* data_ptr =
-                          const_cast<float*>(feature_value.data());
-                      _value_accesor->Create(&data_buffer_ptr, 1);
-                      memcpy(
-                          data_ptr, data_buffer_ptr, data_size * sizeof(float));
-                      ret = &feature_value;
-                    } else {
-                      data_size = tmp_string.size() / sizeof(float);
-                      memcpy(data_buffer_ptr,
-                             paddle::string::str_to_float(tmp_string),
-                             data_size * sizeof(float));
-                      // from rocksdb to mem
-                      auto& feature_value = local_shard[key];
-                      feature_value.resize(data_size);
-                      memcpy(const_cast<float*>(feature_value.data()),
-                             data_buffer_ptr,
-                             data_size * sizeof(float));
-                      _db->del_data(shard_id,
-                                    reinterpret_cast<char*>(&key),
-                                    sizeof(uint64_t));
-                      ret = &feature_value;
+                  FixedFeatureValue* ret = values[i];
+                  if (ret == NULL) {
+                    auto itr = local_shard.find(key);
+                    if (itr != local_shard.end()) {
+                      ret = itr.value_ptr();
                     }
-                  } else {
-                    ret = itr.value_ptr();
+                  }
+                  if (ret == NULL) {
+                    ++missed_keys;
+                    auto& feature_value = local_shard[key];
+                    feature_value.resize(data_size);
+                    float* data_ptr = const_cast<float*>(feature_value.data());
+                    _value_accesor->Create(&data_buffer_ptr, 1);
+                    memcpy(
+                        data_ptr, data_buffer_ptr, data_size * sizeof(float));
+                    ret = &feature_value;
                   }
                   int pull_data_idx = keys[i].second;
                   pull_values[pull_data_idx] = reinterpret_cast<char*>(ret);
@@ -292,27 +285,36 @@ int32_t SSDSparseTable::PushSparse(const uint64_t* keys,
                 auto& local_shard = _local_shards[shard_id];
                 float data_buffer[value_col];  // NOLINT
                 float* data_buffer_ptr = data_buffer;
+                // the values evicted to rocksdb are read back before update
+                std::vector<FixedFeatureValue*> values_in_table;
+                LoadValues(shard_id, keys, &values_in_table);
                 for (size_t i = 0; i < keys.size(); ++i) {
                   uint64_t key = keys[i].first;
                   uint64_t push_data_idx = keys[i].second;
                   const float* update_data =
                       values + push_data_idx * update_value_col;
-                  auto itr = local_shard.find(key);
-                  if (itr == local_shard.end()) {
+                  FixedFeatureValue* value = values_in_table[i];
+                  if (value == NULL) {
+                    // created by the same key earlier in this batch
+                    auto itr = local_shard.find(key);
+                    if (itr != local_shard.end()) {
+                      value = itr.value_ptr();
+                    }
+                  }
+                  if (value == NULL) {
                     if (FLAGS_pserver_enable_create_feasign_randomly &&
                         !_value_accesor->CreateValue(1, update_data)) {
                       continue;
                     }
                     auto value_size = value_col - mf_value_col;
-                    auto& feature_value = local_shard[key];
-                    feature_value.resize(value_size);
+                    value = &local_shard[key];
+                    value->resize(value_size);
                     _value_accesor->Create(&data_buffer_ptr, 1);
-                    memcpy(const_cast<float*>(feature_value.data()),
+                    memcpy(value->data(),
                            data_buffer_ptr,
                            value_size * sizeof(float));
-                    itr = local_shard.find(key);
                   }
-                  auto& feature_value = itr.value();
+                  auto& feature_value = *value;
                   float* value_data = const_cast<float*>(feature_value.data());
                   size_t value_size = feature_value.size();
 
@@ -398,26 +400,35 @@ int32_t SSDSparseTable::PushSparse(const uint64_t* keys,
                 auto& local_shard = _local_shards[shard_id];
                 float data_buffer[value_col];  // NOLINT
                 float* data_buffer_ptr = data_buffer;
+                // the values evicted to rocksdb are read back before update
+                std::vector<FixedFeatureValue*> values_in_table;
+                LoadValues(shard_id, keys, &values_in_table);
                 for (size_t i = 0; i < keys.size(); ++i) {
                   uint64_t key = keys[i].first;
                   uint64_t push_data_idx = keys[i].second;
                   const float* update_data = values[push_data_idx];
-                  auto itr = local_shard.find(key);
-                  if (itr == local_shard.end()) {
+                  FixedFeatureValue* value = values_in_table[i];
+                  if (value == NULL) {
+                    // created by the same key earlier in this batch
+                    auto itr = local_shard.find(key);
+                    if (itr != local_shard.end()) {
+                      value = itr.value_ptr();
+                    }
+                  }
+                  if (value == NULL) {
                     if (FLAGS_pserver_enable_create_feasign_randomly &&
                         !_value_accesor->CreateValue(1, update_data)) {
                       continue;
                     }
                     auto value_size = value_col - mf_value_col;
-                    auto& feature_value = local_shard[key];
-                    feature_value.resize(value_size);
+                    value = &local_shard[key];
+                    value->resize(value_size);
                     _value_accesor->Create(&data_buffer_ptr, 1);
-                    memcpy(const_cast<float*>(feature_value.data()),
+                    memcpy(value->data(),
                            data_buffer_ptr,
                            value_size * sizeof(float));
-                    itr = local_shard.find(key);
                   }
-                  auto& feature_value = itr.value();
+                  auto& feature_value = *value;
                   float* value_data = const_cast<float*>(feature_value.data());
                   size_t value_size = feature_value.size();
 
@@ -450,6 +461,201 @@ int32_t SSDSparseTable::PushSparse(const uint64_t* keys,
   return 0;
 }
 
+int32_t SSDSparseTable::Prefetch(const uint64_t* keys, size_t num) {
+  CostTimer timer("pserver_ssd_sparse_prefetch");
+  std::vector<std::future<int>> tasks(_real_local_shard_num);
+  std::vector<std::vector<uint64_t>> task_keys(_real_local_shard_num);
+  for (size_t i = 0; i < num; ++i) {
+    int shard_id = (keys[i] % _sparse_table_shard_num) % _avg_local_shard_num;
+    task_keys[shard_id].push_back(keys[i]);
+  }
+  std::atomic<uint32_t> promoted_keys{0};
+  for (int shard_id = 0; shard_id < _real_local_shard_num; ++shard_id) {
+    tasks[shard_id] =
+        _shards_task_pool[shard_id % _shards_task_pool.size()]->enqueue(
+            [this, shard_id, &task_keys, &promoted_keys]() -> int {
+              auto& keys = task_keys[shard_id];
+              auto& local_shard = _local_shards[shard_id];
+              std::vector<std::pair<char*, int>> ssd_keys;
+              for (auto& key : keys) {
+                if (local_shard.find(key) == local_shard.end()) {
+                  ssd_keys.emplace_back(reinterpret_cast<char*>(&key),
+                                        sizeof(uint64_t));
+                }
+              }
+              if (ssd_keys.empty()) {
+                return 0;
+              }
+              std::vector<std::string> ssd_values;
+              std::vector<int> status;
+              if (_db->multi_get(shard_id, ssd_keys, &ssd_values, &status) !=
+                  0) {
+                // only a hint, the keys are loaded by the pull instead
+                return -1;
+              }
+              // admit the hottest keys when memory can not hold all of them
+              std::vector<std::pair<float, size_t>> found;
+              for (size_t i = 0; i < ssd_keys.size(); ++i) {
+                if (status[i] == 0) {
+                  found.emplace_back(
+                      _value_accesor->GetField(
+                          paddle::string::str_to_float(ssd_values[i]),
+                          "show_click_score"),
+                      i);
+                }
+              }
+              size_t room = found.size();
+              if (_shard_cache_capacity > 0) {
+                room = _shard_cache_capacity > local_shard.size()
+                           ? _shard_cache_capacity - local_shard.size()
+                           : 0;
+              }
+              if (found.size() > room) {
+                std::nth_element(found.begin(),
+                                 found.begin() + room,
+                                 found.end(),
+                                 std::greater<std::pair<float, size_t>>());
+                found.resize(room);
+              }
+              std::vector<std::pair<char*, int>> promoted;
+              for (auto& item : found) {
+                size_t i = item.second;
+                uint64_t key = *reinterpret_cast<uint64_t*>(ssd_keys[i].first);
+                size_t data_size = ssd_values[i].size() / sizeof(float);
+                auto& feature_value = local_shard[key];
+                feature_value.resize(data_size);
+                memcpy(feature_value.data(),
+                       paddle::string::str_to_float(ssd_values[i]),
+                       data_size * sizeof(float));
+                promoted.push_back(ssd_keys[i]);
+              }
+              if (!promoted.empty() &&
+                  _db->del_batch(shard_id, promoted) != 0) {
+                // drop the copies in memory, the values stay in rocksdb
+                for (auto& key : promoted) {
+                  local_shard.erase(*reinterpret_cast<uint64_t*>(key.first));
+                }
+                return -1;
+              }
+              promoted_keys += promoted.size();
+              return 0;
+            });
+  }
+  for (int i = 0; i < _real_local_shard_num; ++i) {
+    if (tasks[i].get() != 0) {
+      LOG(WARNING) << "SSDSparseTable prefetch of shard " << i
+                   << " failed, the keys are loaded by the pull";
+    }
+  }
+  VLOG(1) << "SSDSparseTable prefetch keys: " << num
+          << " promoted from rocksdb: " << promoted_keys.load();
+  return 0;
+}
+
+void SSDSparseTable::LoadValues(
+    int shard_id,
+    const std::vector<std::pair<uint64_t, int>>& keys,
+    std::vector<FixedFeatureValue*>* values) {
+  auto& local_shard = _local_shards[shard_id];
+  values->assign(keys.size(), NULL);
+  std::vector<std::pair<char*, int>> ssd_keys;
+  std::vector<size_t> ssd_key_idx;
+  for (size_t i = 0; i < keys.size(); ++i) {
+    auto itr = local_shard.find(keys[i].first);
+    if (itr != local_shard.end()) {
+      (*values)[i] = itr.value_ptr();
+    } else {
+      ssd_keys.emplace_back(
+          reinterpret_cast<char*>(const_cast<uint64_t*>(&keys[i].first)),
+          sizeof(uint64_t));
+      ssd_key_idx.push_back(i);
+    }
+  }
+  if (ssd_keys.empty()) {
+    return;
+  }
+  std::vector<std::string> ssd_values;
+  std::vector<int> status;
+  // a value missed by a failed read would be created again and overwrite
+  // the one in rocksdb later
+  CHECK_EQ(_db->multi_get(shard_id, ssd_keys, &ssd_values, &status), 0)
+      << "SSDSparseTable read rocksdb of shard " << shard_id << " failed";
+  std::vector<std::pair<char*, int>> promoted;
+  for (size_t i = 0; i < ssd_keys.size(); ++i) {
+    if (status[i] != 0) {
+      continue;
+    }
+    // from rocksdb to mem
+    uint64_t key = keys[ssd_key_idx[i]].first;
+    size_t data_size = ssd_values[i].size() / sizeof(float);
+    auto& feature_value = local_shard[key];
+    feature_value.resize(data_size);
+    memcpy(feature_value.data(),
+           paddle::string::str_to_float(ssd_values[i]),
+           data_size * sizeof(float));
+    (*values)[ssd_key_idx[i]] = &feature_value;
+    promoted.push_back(ssd_keys[i]);
+  }
+  // the stale values left in rocksdb would be saved besides the ones in memory
+  if (!promoted.empty()) {
+    CHECK_EQ(_db->del_batch(shard_id, promoted), 0)
+        << "SSDSparseTable delete promoted keys of shard " << shard_id
+        << " from rocksdb failed";
+  }
+}
+
+void SSDSparseTable::EvictColdValues(int shard_id) {
+  auto& shard = _local_shards[shard_id];
+  if (_shard_cache_capacity == 0 || shard.size() <= _shard_cache_capacity) {
+    return;
+  }
+  // evict more than the overflow, so that the scan is amortized
+  size_t evict_num = shard.size() - _shard_cache_capacity +
+                     static_cast<size_t>(_shard_cache_capacity *
+                                         FLAGS_pserver_ssd_cache_evict_rate);
+  evict_num = std::min(evict_num, shard.size());
+  std::vector<float> scores;
+  scores.reserve(shard.size());
+  for (auto it = shard.begin(); it != shard.end(); ++it) {
+    scores.push_back(
+        _value_accesor->GetField(it.value().data(), "show_click_score"));
+  }
+  std::vector<float> sorted_scores(scores);
+  std::nth_element(sorted_scores.begin(),
+                   sorted_scores.begin() + evict_num - 1,
+                   sorted_scores.end());
+  float threshold = sorted_scores[evict_num - 1];
+
+  std::vector<uint64_t> keys;
+  std::vector<std::pair<char*, int>> ssd_keys;
+  std::vector<std::pair<char*, int>> ssd_values;
+  keys.reserve(evict_num);
+  size_t idx = 0;
+  for (auto it = shard.begin(); it != shard.end() && keys.size() < evict_num;
+       ++it, ++idx) {
+    if (scores[idx] <= threshold) {
+      keys.push_back(it.key());
+      ssd_values.emplace_back(reinterpret_cast<char*>(it.value().data()),
+                              it.value().size() * sizeof(float));
+    }
+  }
+  for (auto& key : keys) {
+    ssd_keys.emplace_back(reinterpret_cast<char*>(&key), sizeof(uint64_t));
+  }
+  if (_db->put_batch(shard_id, ssd_keys, ssd_values, ssd_keys.size()) != 0) {
+    // keep the values in memory, the shard stays over the capacity until the
+    // next eviction
+    LOG(WARNING) << "SSDSparseTable failed to evict " << keys.size()
+                 << " values of shard " << shard_id << " to rocksdb";
+    return;
+  }
+  for (auto key : keys) {
+    shard.erase(key);
+  }
+  VLOG(1) << "SSDSparseTable evict " << keys.size() << " values of shard "
+          << shard_id << " to rocksdb, score threshold " << threshold;
+}
+
 int32_t SSDSparseTable::Shrink(const std::string& param) {
   int thread_num = _real_local_shard_num < 20 ? _real_local_shard_num : 20;
   omp_set_num_threads(thread_num);
@@ -38,9 +38,15 @@ class SSDSparseTable : public MemorySparseTable {
   int32_t Push(TableContext& context) override;
 
   int32_t PullSparse(float* pull_values, const uint64_t* keys, size_t num);
+  // The pointers returned are valid until the next PullSparse, which may
+  // evict the values to rocksdb and free them. PullSparsePtr never evicts, so
+  // a pass keeping the pointers, e.g. the building of the GPU PS, must not
+  // be mixed with PullSparse.
   int32_t PullSparsePtr(char** pull_values, const uint64_t* keys, size_t num);
   int32_t PushSparse(const uint64_t* keys, const float* values, size_t num);
   int32_t PushSparse(const uint64_t* keys, const float** values, size_t num);
+  // promote the keys of the next pass from rocksdb into memory
+  int32_t Prefetch(const uint64_t* keys, size_t num) override;
 
   int32_t Flush() override { return 0; }
   virtual int32_t Shrink(const std::string& param) override;
@@ -78,7 +84,19 @@ class SSDSparseTable : public MemorySparseTable {
   int64_t LocalSize();
 
  private:
+  // Finds the values of keys in memory, the missed keys are read from rocksdb
+  // by one MultiGet and moved into memory. (*values)[i] is NULL if keys[i]
+  // is neither in memory nor in rocksdb.
+  void LoadValues(int shard_id,
+                  const std::vector<std::pair<uint64_t, int>>& keys,
+                  std::vector<FixedFeatureValue*>* values);
+  // Moves the values with the lowest show click score to rocksdb when the
+  // shard holds more values than its share of ssd_dram_cache_capacity. The
+  // values moved are freed, see PullSparsePtr.
+  void EvictColdValues(int shard_id);
+
   RocksDBHandler* _db;
+  size_t _shard_cache_capacity{0};  // 0 means no limit
   int64_t _cache_tk_size;
   double _local_show_threshold{0.0};
 };
@@ -147,6 +147,8 @@ class Table {
 
   virtual void *GetShard(size_t shard_idx) = 0;
   virtual std::pair<int64_t, int64_t> PrintTableStat() { return {0, 0}; }
+  // load the keys to be accessed soon into the fast storage
+  virtual int32_t Prefetch(const uint64_t *keys, size_t num) { return 0; }
 
   // for patch model
   virtual void Revert() {}
@@ -887,6 +887,15 @@ int32_t FleetWrapper::SaveCache(int table_id,
   return feasign_cnt;
 }
 
+void FleetWrapper::PrefetchSparse(int table_id,
+                                  const std::vector<uint64_t>& keys) {
+  auto ret = worker_ptr_->PrefetchSparse(table_id, keys.data(), keys.size());
+  ret.wait();
+  if (ret.get() != 0) {
+    LOG(ERROR) << "prefetch sparse table " << table_id << " failed";
+  }
+}
+
 void FleetWrapper::Revert() {
   auto ret = worker_ptr_->Revert();
   ret.wait();
@@ -302,6 +302,8 @@ class FleetWrapper {
                     const int mode,
                     const double cache_threshold);
   int32_t SaveCache(int table_id, const std::string& path, const int mode);
+  // load the keys of the next pass into the memory of pservers
+  void PrefetchSparse(int table_id, const std::vector<uint64_t>& keys);
   void Revert();
   void CheckSavePrePatchDone();
 
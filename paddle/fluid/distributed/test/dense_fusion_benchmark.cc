@@ -0,0 +1,172 @@
+// Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Compare the step time of pushing many small dense tables one by one with
+// the fused push of the Communicator in fp32, fp16 and bf16, on a
+// PsLocalClient so that no network is involved. The request num and bytes
+// are those a BrpcPsClient sends to every server, e.g.
+//   dense_fusion_benchmark --table_num=200 --table_dim=4096 --steps=100 \
+//       --fuse_bytes=67108864
+
+#include <map>
+#include <random>
+
+#include "gflags/gflags.h"
+#include "glog/logging.h"
+#include "paddle/fluid/distributed/ps/service/brpc_ps_client.h"
+#include "paddle/fluid/distributed/ps/service/dense_fusion.h"
+#include "paddle/fluid/distributed/ps/service/env.h"
+#include "paddle/fluid/distributed/ps/service/ps_client.h"
+#include "paddle/fluid/distributed/the_one_ps.pb.h"
+#include "paddle/fluid/platform/timer.h"
+
+DEFINE_int32(table_num, 200, "The number of dense tables.");
+DEFINE_int32(table_dim, 4096, "The param num of every dense table.");
+DEFINE_int32(steps, 100, "The number of pushes of every table.");
+DEFINE_int64(fuse_bytes, 64 << 20, "The max bytes of a fused request.");
+
+namespace paddle {
+namespace distributed {
+
+static void AddDenseTable(DownpourServerParameter* server_param, int table_id) {
+  auto* table = server_param->add_downpour_table_param();
+  table->set_table_id(table_id);
+  table->set_table_class("MemoryDenseTable");
+  table->set_shard_num(256);
+  table->set_type(PS_DENSE_TABLE);
+  auto* accessor = table->mutable_accessor();
+  accessor->set_accessor_class("CommMergeAccessor");
+  accessor->set_fea_dim(FLAGS_table_dim);
+  accessor->set_embedx_dim(1);
+  auto* common = table->mutable_common();
+  common->set_name("sgd");
+  common->set_table_name("MergedDense");
+  common->set_trainer_num(1);
+  common->set_sync(false);
+  common->add_params("Param");
+  common->add_dims(FLAGS_table_dim);
+  common->add_initializers("fill_constant&1.0");
+  common->add_params("LearningRate");
+  common->add_dims(1);
+  common->add_initializers("fill_constant&1.0");
+}
+
+static DownpourBrpcClosure* NewClosure() {
+  return new DownpourBrpcClosure(1, [](void* done) {});
+}
+
+static int BenchmarkMain() {
+  PSParameter ps_param;
+  auto* server_param =
+      ps_param.mutable_server_param()->mutable_downpour_server_param();
+  auto* service_param = server_param->mutable_service_param();
+  service_param->set_server_class("PsLocalServer");
+  service_param->set_client_class("PsLocalClient");
+  for (int i = 0; i < FLAGS_table_num; ++i) {
+    AddDenseTable(server_param, i);
+  }
+  std::vector<std::string> host_sign_list;
+  PaddlePSEnvironment ps_env;
+  ps_env.SetPsServers(&host_sign_list, 0);
+  std::unique_ptr<PSClient> client(PSClientFactory::Create(ps_param));
+  std::map<uint64_t, std::vector<Region>> regions;
+  client->Configure(ps_param, regions, ps_env, 0);
+
+  // the send buffers of the Communicator, one server
+  size_t dense_num = FLAGS_table_dim + 1;
+  std::mt19937 rng(0);
+  std::uniform_real_distribution<float> distrib(-1e-3, 1e-3);
+  std::vector<std::vector<float>> grads(FLAGS_table_num);
+  for (auto& grad : grads) {
+    grad.resize(dense_num);
+    for (auto& g : grad) {
+      g = distrib(rng);
+    }
+  }
+
+  platform::Timer timer;
+  timer.Start();
+  for (int step = 0; step < FLAGS_steps; ++step) {
+    for (int i = 0; i < FLAGS_table_num; ++i) {
+      client->PushDenseRawGradient(i, grads[i].data(), dense_num, NewClosure())
+          .wait();
+    }
+  }
+  timer.Pause();
+  LOG(INFO) << "per table: " << timer.ElapsedMS() / FLAGS_steps
+            << " ms/step, " << FLAGS_table_num << " requests and "
+            << FLAGS_table_num * (4 + dense_num * 4) << " bytes per server";
+
+  for (const std::string type_name : {"fp32", "fp16", "bf16"}) {
+    auto type = StringToDenseCompressType(type_name);
+    std::vector<std::vector<float>> residuals(
+        FLAGS_table_num, std::vector<float>(dense_num, 0));
+    std::vector<std::vector<float>> datas = grads;
+    size_t requests = 0;
+    size_t bytes = 0;
+    timer.Reset();
+    timer.Start();
+    for (int step = 0; step < FLAGS_steps; ++step) {
+      // the same bucketing as AsyncCommunicator::RpcSendDenseFused
+      std::vector<uint32_t> table_ids;
+      std::vector<float*> bucket_datas;
+      std::vector<size_t> sizes;
+      size_t bucket_bytes = 0;
+      auto send_bucket = [&] {
+        client
+            ->PushFusedDenseRawGradients(
+                table_ids, bucket_datas, sizes, type, NewClosure())
+            .wait();
+        requests += 1;
+        bytes += 8 + bucket_bytes + table_ids.size() * 8;
+        table_ids.clear();
+        bucket_datas.clear();
+        sizes.clear();
+        bucket_bytes = 0;
+      };
+      for (int i = 0; i < FLAGS_table_num; ++i) {
+        datas[i] = grads[i];
+        if (type != DenseCompressType::kFP32) {
+          ApplyErrorFeedback(
+              datas[i].data(), dense_num, type, residuals[i].data());
+        }
+        size_t table_bytes = dense_num * DenseCompressTypeSize(type);
+        if (!table_ids.empty() && bucket_bytes + table_bytes >
+                                      static_cast<size_t>(FLAGS_fuse_bytes)) {
+          send_bucket();
+        }
+        table_ids.push_back(i);
+        bucket_datas.push_back(datas[i].data());
+        sizes.push_back(dense_num);
+        bucket_bytes += table_bytes;
+      }
+      send_bucket();
+    }
+    timer.Pause();
+    LOG(INFO) << "fused " << type_name << ": "
+              << timer.ElapsedMS() / FLAGS_steps << " ms/step, "
+              << requests / FLAGS_steps << " requests and "
+              << bytes / FLAGS_steps << " bytes per server";
+  }
+  return 0;
+}
+
+}  // namespace distributed
+}  // namespace paddle
+
+int main(int argc, char* argv[]) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  google::InitGoogleLogging(argv[0]);
+  return paddle::distributed::BenchmarkMain();
+}
@@ -0,0 +1,164 @@
+/* Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/fluid/distributed/ps/service/dense_fusion.h"
+
+#include <cmath>
+#include <map>
+#include <random>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace paddle {
+namespace distributed {
+
+static std::vector<float> RandomValues(size_t num, int seed) {
+  std::mt19937 rng(seed);
+  std::uniform_real_distribution<float> distrib(-1.0, 1.0);
+  std::vector<float> values(num);
+  for (auto& v : values) {
+    v = distrib(rng) * 1e-3;
+  }
+  return values;
+}
+
+static std::map<uint32_t, std::vector<float>> Decode(const std::string& buf) {
+  std::map<uint32_t, std::vector<float>> tables;
+  int32_t ret = ForEachFusedDenseTable(
+      buf.data(),
+      buf.size(),
+      [&](uint32_t table_id, const float* values, uint32_t num) {
+        tables[table_id].assign(values, values + num);
+        return 0;
+      });
+  EXPECT_EQ(ret, 0);
+  return tables;
+}
+
+TEST(DenseFusion, fp32_round_trip) {
+  std::vector<std::vector<float>> grads = {
+      RandomValues(101, 0), RandomValues(1, 1), RandomValues(3000, 2)};
+  std::string buf;
+  FusedDenseWriter writer(DenseCompressType::kFP32, &buf);
+  for (size_t i = 0; i < grads.size(); ++i) {
+    writer.Append(i + 5, grads[i].data(), grads[i].size());
+  }
+  ASSERT_EQ(writer.TableNum(), 3u);
+
+  auto tables = Decode(buf);
+  ASSERT_EQ(tables.size(), 3u);
+  for (size_t i = 0; i < grads.size(); ++i) {
+    ASSERT_EQ(tables[i + 5], grads[i]);
+  }
+}
+
+TEST(DenseFusion, compressed_round_trip) {
+  for (auto type : {DenseCompressType::kFP16, DenseCompressType::kBF16}) {
+    std::vector<float> grad = RandomValues(1023, 3);
+    std::string buf;
+    FusedDenseWriter writer(type, &buf);
+    writer.Append(0, grad.data(), grad.size());
+    writer.Append(1, grad.data(), grad.size());
+    // 2 bytes per value
+    ASSERT_EQ(buf.size(), 8u + 2 * (8u + 2 * grad.size()));
+
+    auto tables = Decode(buf);
+    // relative, but absolute for the subnormals of fp16 below 6.1e-5, whose
+    // step 6e-8 is the error of the truncation
+    float tolerance = type == DenseCompressType::kFP16 ? 1e-3 : 1e-2;
+    for (size_t i = 0; i < grad.size(); ++i) {
+      ASSERT_NEAR(
+          tables[0][i], grad[i], std::fabs(grad[i]) * tolerance + 6e-8);
+      ASSERT_EQ(tables[0][i], tables[1][i]);
+    }
+  }
+}
+
+TEST(DenseFusion, error_feedback) {
+  // The sum of the compressed pushes follows the sum of the gradients, the
+  // difference is the last residual only.
+  for (auto type : {DenseCompressType::kFP16, DenseCompressType::kBF16}) {
+    const size_t num = 256;
+    std::vector<float> residual(num, 0);
+    std::vector<double> grad_sum(num, 0), push_sum(num, 0);
+    for (int step = 0; step < 100; ++step) {
+      std::vector<float> grad = RandomValues(num, step);
+      for (size_t i = 0; i < num; ++i) {
+        grad_sum[i] += grad[i];
+      }
+      ApplyErrorFeedback(grad.data(), num, type, residual.data());
+      std::string buf;
+      FusedDenseWriter writer(type, &buf);
+      writer.Append(0, grad.data(), num);
+      auto tables = Decode(buf);
+      for (size_t i = 0; i < num; ++i) {
+        // rounded already, the compression is exact
+        ASSERT_EQ(tables[0][i], grad[i]);
+        push_sum[i] += tables[0][i];
+      }
+    }
+    for (size_t i = 0; i < num; ++i) {
+      ASSERT_NEAR(push_sum[i] + residual[i], grad_sum[i], 1e-5);
+    }
+  }
+}
+
+TEST(DenseFusion, error_feedback_overflow) {
+  // 1e5 is out of the range of fp16, pushed as 65504 with the excess kept in
+  // the residual, which never turns to inf or nan.
+  const float max_value = 65504;
+  std::vector<float> residual(2, 0);
+  double grad_sum = 0, push_sum = 0;
+  for (int step = 0; step < 10; ++step) {
+    std::vector<float> grad = {1e5, -1e5};
+    grad_sum += grad[0];
+    ApplyErrorFeedback(
+        grad.data(), grad.size(), DenseCompressType::kFP16, residual.data());
+    ASSERT_EQ(grad[0], max_value);
+    ASSERT_EQ(grad[1], -max_value);
+    ASSERT_TRUE(std::isfinite(residual[0]));
+    ASSERT_EQ(residual[1], -residual[0]);
+    push_sum += grad[0];
+  }
+  ASSERT_NEAR(push_sum + residual[0], grad_sum, 1e-2);
+
+  // A nan gradient is pushed as nan once, and its residual is reset.
+  std::vector<float> grad = {std::nanf(""), 1};
+  ApplyErrorFeedback(
+      grad.data(), grad.size(), DenseCompressType::kFP16, residual.data());
+  ASSERT_TRUE(std::isnan(grad[0]));
+  ASSERT_EQ(residual[0], 0);
+  grad = {1, 1};
+  ApplyErrorFeedback(
+      grad.data(), grad.size(), DenseCompressType::kFP16, residual.data());
+  ASSERT_EQ(grad[0], 1);
+}
+
+TEST(DenseFusion, malformed) {
+  std::vector<float> grad = RandomValues(10, 4);
+  std::string buf;
+  FusedDenseWriter writer(DenseCompressType::kFP16, &buf);
+  writer.Append(0, grad.data(), grad.size());
+  auto fn = [](uint32_t table_id, const float* values, uint32_t num) {
+    return 0;
+  };
+  ASSERT_EQ(ForEachFusedDenseTable(buf.data(), buf.size() - 1, fn), -1);
+  ASSERT_EQ(ForEachFusedDenseTable(buf.data(), 4, fn), -1);
+  buf[4] = 7;  // unknown compress type
+  ASSERT_EQ(ForEachFusedDenseTable(buf.data(), buf.size(), fn), -1);
+}
+
+}  // namespace distributed
+}  // namespace paddle
@@ -14,6 +14,7 @@ limitations under the License. */
 
 #include "paddle/fluid/distributed/ps/table/depends/feature_value.h"
 
+#include <algorithm>
 #include <vector>
 
 #include "gtest/gtest.h"
@@ -46,5 +47,60 @@ TEST(BENCHMARK, LargeScaleKV) {
   ASSERT_FLOAT_EQ(value_data[3], 0.3);
 }
 
+TEST(SparseTableShard, FlatValueStore) {
+  typedef SparseTableShard<uint64_t, FixedFeatureValue> shard_type;
+  const size_t stride = 6;
+  const uint64_t key_num = 1000;
+  shard_type shard;
+  shard.set_value_stride(stride);
+  ASSERT_EQ(shard.value_stride(), stride);
+
+  for (uint64_t key = 0; key < key_num; ++key) {
+    auto& feature_value = shard[key];
+    // the values grow like the accessor values with mf
+    size_t value_size = key % 2 == 0 ? stride - 2 : stride;
+    feature_value.resize(value_size);
+    for (size_t i = 0; i < value_size; ++i) {
+      feature_value.data()[i] = key * 10 + i;
+    }
+  }
+  // grows beyond the stride and spills to the heap
+  shard[7].resize(stride * 2);
+  shard[7].data()[stride * 2 - 1] = 1.5;
+  ASSERT_EQ(shard.size(), key_num);
+
+  for (auto it = shard.begin(); it != shard.end();) {
+    if (it.key() % 3 != 1) {
+      it = shard.erase(it);
+    } else {
+      ++it;
+    }
+  }
+  ASSERT_GT(shard.compact(), 0UL);
+  ASSERT_EQ(shard.compact(), 0UL);
+
+  size_t count = 0;
+  for (auto it = shard.begin(); it != shard.end(); ++it) {
+    uint64_t key = it.key();
+    ASSERT_EQ(key % 3, 1UL);
+    auto& feature_value = it.value();
+    size_t value_size = key == 7 ? stride * 2
+                                 : (key % 2 == 0 ? stride - 2 : stride);
+    ASSERT_EQ(feature_value.size(), value_size);
+    for (size_t i = 0; i < std::min(value_size, stride); ++i) {
+      ASSERT_FLOAT_EQ(feature_value.data()[i], key * 10 + i);
+    }
+    ++count;
+  }
+  ASSERT_EQ(count, shard.size());
+  ASSERT_FLOAT_EQ(shard[7].data()[stride * 2 - 1], 1.5);
+
+  // values copied out of the flat store own their data
+  FixedFeatureValue copied = shard[4];
+  shard.erase(4);
+  ASSERT_EQ(copied.size(), stride - 2);
+  ASSERT_FLOAT_EQ(copied.data()[1], 41);
+}
+
 }  // namespace distributed
 }  // namespace paddle
@@ -0,0 +1,152 @@
+// Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Compare the load time, the memory and the neighbor sampling throughput of
+// the GraphNode storage and the csr storage of GraphTable on a synthetic
+// power-law graph, e.g.
+//   graph_csr_benchmark --node_num=1000000 --alpha=2.1 --file_num=8 \
+//       --sample_size=10 --weighted=true
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cmath>
+#include <fstream>
+#include <random>
+
+#include "gflags/gflags.h"
+#include "glog/logging.h"
+#include "paddle/fluid/distributed/ps/table/common_graph_table.h"
+#include "paddle/fluid/distributed/the_one_ps.pb.h"
+#include "paddle/fluid/platform/timer.h"
+
+DEFINE_string(work_dir, "./graph_csr_bench", "The directory of edge files.");
+DEFINE_int32(node_num, 1000000, "The number of source nodes.");
+DEFINE_double(alpha, 2.1, "The exponent of the power-law degree.");
+DEFINE_int32(min_degree, 2, "The min out degree of a node.");
+DEFINE_int32(max_degree, 100000, "The max out degree of a node.");
+DEFINE_int32(file_num, 8, "The number of generated edge files.");
+DEFINE_bool(weighted, false, "Whether the edges have weights.");
+DEFINE_int32(task_pool_size, 24, "The task pool size of GraphTable.");
+DEFINE_int32(shard_num, 127, "The shard num of GraphTable.");
+DEFINE_int32(sample_size, 10, "The sampled neighbor num of every node.");
+DEFINE_int32(batch_size, 1024, "The node num of every sampling call.");
+DEFINE_int32(batch_num, 1000, "The number of sampling calls.");
+
+namespace paddle {
+namespace distributed {
+
+static std::string GenerateEdgeFiles() {
+  std::string paths;
+  int64_t edge_num = 0;
+  for (int f = 0; f < FLAGS_file_num; ++f) {
+    std::string path = FLAGS_work_dir + "/part-" + std::to_string(f);
+    std::ofstream ofs(path);
+    std::mt19937_64 rng(f);
+    std::uniform_real_distribution<double> distrib(0, 1.0);
+    for (int64_t src = f; src < FLAGS_node_num; src += FLAGS_file_num) {
+      // the pareto distributed degree gives the power-law tail
+      double degree = FLAGS_min_degree *
+                      std::pow(1.0 - distrib(rng), -1.0 / (FLAGS_alpha - 1));
+      int64_t num = std::min<double>(degree, FLAGS_max_degree);
+      for (int64_t k = 0; k < num; ++k) {
+        ofs << src << "\t" << rng() % FLAGS_node_num;
+        if (FLAGS_weighted) {
+          ofs << "\t" << distrib(rng);
+        }
+        ofs << "\n";
+      }
+      edge_num += num;
+    }
+    paths += (f == 0 ? "" : ";") + path;
+  }
+  LOG(INFO) << "generate " << FLAGS_node_num << " nodes and " << edge_num
+            << " edges, alpha " << FLAGS_alpha;
+  return paths;
+}
+
+static double ResidentMB() {
+  int64_t pages = 0;
+  int64_t resident = 0;
+  std::ifstream statm("/proc/self/statm");
+  statm >> pages >> resident;
+  return resident * sysconf(_SC_PAGESIZE) / 1024.0 / 1024.0;
+}
+
+static void RunOnce(const std::string& paths, bool use_csr_storage) {
+  GraphParameter param;
+  param.add_edge_types("edge");
+  param.set_task_pool_size(FLAGS_task_pool_size);
+  param.set_shard_num(FLAGS_shard_num);
+  param.set_use_csr_storage(use_csr_storage);
+  double base_mb = ResidentMB();
+  std::unique_ptr<GraphTable> table(new GraphTable());
+  table->Initialize(param);
+
+  platform::Timer timeline;
+  timeline.Start();
+  table->Load(paths, "e>edge");
+  timeline.Pause();
+  double load_sec = timeline.ElapsedSec();
+  double memory_mb = ResidentMB() - base_mb;
+
+  std::mt19937_64 rng(2022);
+  std::vector<int64_t> ids(FLAGS_batch_size);
+  std::vector<std::shared_ptr<char>> buffers(FLAGS_batch_size);
+  std::vector<int> actual_sizes(FLAGS_batch_size);
+  int64_t sampled = 0;
+  timeline.Reset();
+  for (int b = 0; b < FLAGS_batch_num; ++b) {
+    for (auto& id : ids) {
+      id = rng() % FLAGS_node_num;
+    }
+    timeline.Resume();
+    table->random_sample_neighbors(0,
+                                   ids.data(),
+                                   FLAGS_sample_size,
+                                   buffers,
+                                   actual_sizes,
+                                   FLAGS_weighted);
+    timeline.Pause();
+    for (int size : actual_sizes) {
+      sampled += size;
+    }
+  }
+  double sample_sec = timeline.ElapsedSec();
+  LOG(INFO) << (use_csr_storage ? "csr storage" : "node storage") << ": load "
+            << load_sec << "s, resident memory " << memory_mb
+            << "MB, sample "
+            << static_cast<double>(FLAGS_batch_size) * FLAGS_batch_num /
+                   sample_sec
+            << " nodes/s, sampled bytes " << sampled;
+}
+
+static int BenchmarkMain() {
+  mkdir(FLAGS_work_dir.c_str(), 0755);
+  std::string paths = GenerateEdgeFiles();
+  // the csr storage runs first, so the memory released by the node storage
+  // does not hide its resident growth
+  RunOnce(paths, true);
+  RunOnce(paths, false);
+  return 0;
+}
+
+}  // namespace distributed
+}  // namespace paddle
+
+int main(int argc, char* argv[]) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  google::InitGoogleLogging(argv[0]);
+  return paddle::distributed::BenchmarkMain();
+}
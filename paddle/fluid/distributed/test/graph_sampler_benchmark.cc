@@ -0,0 +1,117 @@
+// Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Compare the weighted neighbor sampling throughput of the weight tree
+// sampler and the alias sampler on a graph with power-law degrees and
+// skewed edge weights, e.g.
+//   graph_sampler_benchmark --node_num=100000 --alpha=2.1 --sample_size=10
+
+#include <cmath>
+#include <memory>
+#include <random>
+
+#include "gflags/gflags.h"
+#include "glog/logging.h"
+#include "paddle/fluid/distributed/ps/table/graph/graph_edge.h"
+#include "paddle/fluid/distributed/ps/table/graph/graph_weighted_sampler.h"
+#include "paddle/fluid/platform/timer.h"
+
+DEFINE_int32(node_num, 100000, "The number of nodes.");
+DEFINE_double(alpha, 2.1, "The exponent of the power-law degree.");
+DEFINE_int32(min_degree, 2, "The min degree of a node.");
+DEFINE_int32(max_degree, 100000, "The max degree of a node.");
+DEFINE_double(weight_alpha, 1.5, "The exponent of the power-law weights.");
+DEFINE_int32(sample_size, 10, "The sampled neighbor num of every node.");
+DEFINE_int32(sample_num, 1000000, "The number of sample_k calls.");
+
+namespace paddle {
+namespace distributed {
+
+static double RunSampler(const std::vector<std::unique_ptr<Sampler>>& samplers,
+                         const std::vector<int>& nodes,
+                         int64_t* sampled) {
+  auto rng = std::make_shared<std::mt19937_64>(2022);
+  platform::Timer timeline;
+  timeline.Start();
+  for (int node : nodes) {
+    *sampled += samplers[node]->sample_k(FLAGS_sample_size, rng).size();
+  }
+  timeline.Pause();
+  return timeline.ElapsedSec();
+}
+
+static int BenchmarkMain() {
+  std::mt19937_64 rng(0);
+  std::uniform_real_distribution<double> distrib(0, 1.0);
+  std::vector<std::unique_ptr<WeightedGraphEdgeBlob>> edges(FLAGS_node_num);
+  int64_t edge_num = 0;
+  for (auto& blob : edges) {
+    blob.reset(new WeightedGraphEdgeBlob());
+    double degree = FLAGS_min_degree *
+                    std::pow(1.0 - distrib(rng), -1.0 / (FLAGS_alpha - 1));
+    int64_t num = std::min<double>(degree, FLAGS_max_degree);
+    for (int64_t k = 0; k < num; ++k) {
+      float weight =
+          std::pow(1.0 - distrib(rng), -1.0 / (FLAGS_weight_alpha - 1));
+      blob->add_edge(rng() % FLAGS_node_num, weight);
+    }
+    edge_num += num;
+  }
+  LOG(INFO) << "generate " << FLAGS_node_num << " nodes and " << edge_num
+            << " edges, alpha " << FLAGS_alpha;
+
+  platform::Timer timeline;
+  std::vector<std::unique_ptr<Sampler>> tree_samplers, alias_samplers;
+  timeline.Start();
+  for (auto& blob : edges) {
+    tree_samplers.emplace_back(new WeightedSampler());
+    tree_samplers.back()->build(blob.get());
+  }
+  timeline.Pause();
+  LOG(INFO) << "build weight tree samplers " << timeline.ElapsedSec() << "s";
+  for (auto& blob : edges) {
+    alias_samplers.emplace_back(new AliasSampler());
+    alias_samplers.back()->build(blob.get());
+  }
+
+  // the nodes are drawn proportional to their degrees, as the neighbors of
+  // a random walk are
+  std::vector<int> nodes(FLAGS_sample_num);
+  for (auto& node : nodes) {
+    node = edges[rng() % FLAGS_node_num]->get_id(0) % FLAGS_node_num;
+  }
+  int64_t tree_sampled = 0;
+  int64_t alias_sampled = 0;
+  // the first pass of the alias samplers builds the tables lazily
+  double alias_first_sec = RunSampler(alias_samplers, nodes, &alias_sampled);
+  alias_sampled = 0;
+  double tree_sec = RunSampler(tree_samplers, nodes, &tree_sampled);
+  double alias_sec = RunSampler(alias_samplers, nodes, &alias_sampled);
+  LOG(INFO) << "sample_size " << FLAGS_sample_size << ": weight tree "
+            << tree_sampled / tree_sec / 1e6 << " M samples/s, alias "
+            << alias_sampled / alias_sec / 1e6
+            << " M samples/s (first pass with lazy build "
+            << alias_sampled / alias_first_sec / 1e6 << " M samples/s), speedup "
+            << tree_sec / alias_sec;
+  return 0;
+}
+
+}  // namespace distributed
+}  // namespace paddle
+
+int main(int argc, char* argv[]) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  google::InitGoogleLogging(argv[0]);
+  return paddle::distributed::BenchmarkMain();
+}
@@ -18,15 +18,21 @@
 #include <condition_variable>  // NOLINT
 #include <fstream>
 #include <iomanip>
+#include <random>
 #include <string>
 #include <thread>  // NOLINT
 #include <unordered_set>
 #include <vector>
 
+#include "gflags/gflags.h"
 #include "google/protobuf/text_format.h"
 #include "gtest/gtest.h"
 #include "paddle/fluid/distributed/ps/table/common_graph_table.h"
+#include "paddle/fluid/distributed/ps/table/graph/graph_csr.h"
+#include "paddle/fluid/distributed/ps/table/graph/graph_weighted_sampler.h"
 #include "paddle/fluid/distributed/the_one_ps.pb.h"
+DECLARE_int32(graph_alias_sampler_min_degree);
+
 namespace framework = paddle::framework;
 namespace platform = paddle::platform;
 namespace operators = paddle::operators;
@@ -86,3 +92,186 @@ void testGraphSample() {
 }
 
 TEST(testGraphSample, Run) { testGraphSample(); }
+
+TEST(GraphCsr, BuildAndSample) {
+  distributed::GraphCsrEdges edges;
+  edges.add_edge(9, 3, 0.5);
+  edges.add_edge(2, 7, 1.0);
+  edges.add_edge(9, 1, 0.0);
+  edges.add_edge(9, 4, 2.0);
+  distributed::GraphCsr csr;
+  csr.build(&edges, true);
+  ASSERT_EQ(csr.get_size(), 2UL);
+  ASSERT_EQ(csr.get_edge_size(), 4UL);
+  ASSERT_EQ(csr.find(5), -1);
+  int64_t pos = csr.find(9);
+  ASSERT_EQ(csr.get_id(pos), 9);
+  ASSERT_EQ(csr.get_neighbor_size(pos), 3UL);
+  // the neighbors keep the order of edges
+  ASSERT_EQ(csr.get_neighbor_id(pos, 0), 3);
+  ASSERT_EQ(csr.get_neighbor_id(pos, 2), 4);
+  ASSERT_FLOAT_EQ(csr.get_neighbor_weight(pos, 2), 2.0);
+
+  auto rng = std::make_shared<std::mt19937_64>(2022);
+  for (int i = 0; i < 100; i++) {
+    // the neighbor with zero weight is never sampled
+    auto res = csr.sample_k(pos, 2, rng);
+    ASSERT_EQ(res.size(), 2UL);
+    std::sort(res.begin(), res.end());
+    ASSERT_EQ(res[0], 0);
+    ASSERT_EQ(res[1], 2);
+  }
+  ASSERT_EQ(csr.sample_k(pos, 5, rng).size(), 3UL);
+
+  distributed::GraphCsrEdges more;
+  csr.export_edges(&more);
+  more.add_edge(1, 9, 1.0);
+  csr.build(&more, false);
+  ASSERT_EQ(csr.get_size(), 3UL);
+  ASSERT_FALSE(csr.is_weighted());
+  pos = csr.find(9);
+  for (int i = 0; i < 100; i++) {
+    auto res = csr.sample_k(pos, 2, rng);
+    std::unordered_set<int> uniq(res.begin(), res.end());
+    ASSERT_EQ(uniq.size(), 2UL);
+    for (int x : res) {
+      ASSERT_TRUE(x >= 0 && x < 3);
+    }
+  }
+}
+
+TEST(GraphCsr, ConcurrentAliasSample) {
+  // the alias table of the high degree node is built with the storage and
+  // shared by the sampling threads
+  int min_degree = FLAGS_graph_alias_sampler_min_degree;
+  FLAGS_graph_alias_sampler_min_degree = 8;
+  distributed::GraphCsrEdges edges;
+  for (int i = 0; i < 100; i++) {
+    edges.add_edge(1, i, i % 2 == 0 ? 0.0 : 1.0 + i);
+  }
+  distributed::GraphCsr csr;
+  csr.build(&edges, true);
+  FLAGS_graph_alias_sampler_min_degree = min_degree;
+
+  int64_t pos = csr.find(1);
+  std::vector<std::thread> threads;
+  std::vector<int> failures(4, 0);
+  for (int t = 0; t < 4; t++) {
+    threads.emplace_back([&csr, &failures, pos, t]() {
+      auto rng = std::make_shared<std::mt19937_64>(t);
+      for (int i = 0; i < 1000; i++) {
+        auto res = csr.sample_k(pos, 10, rng);
+        std::unordered_set<int> uniq(res.begin(), res.end());
+        bool ok = res.size() == 10 && uniq.size() == 10;
+        for (int x : res) {
+          // the neighbors with zero weight are never sampled
+          ok = ok && x % 2 == 1;
+        }
+        failures[t] += ok ? 0 : 1;
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  ASSERT_EQ(failures, std::vector<int>(4, 0));
+}
+
+TEST(AliasSampler, SampleK) {
+  distributed::WeightedGraphEdgeBlob edges;
+  std::vector<float> weights = {1, 0, 3, 6, 0.5, 9.5};
+  for (size_t i = 0; i < weights.size(); i++) {
+    edges.add_edge(100 + i, weights[i]);
+  }
+  distributed::AliasSampler sampler;
+  sampler.build(&edges);
+  auto rng = std::make_shared<std::mt19937_64>(2022);
+  std::vector<int> first_count(weights.size(), 0);
+  const int sample_num = 200000;
+  for (int i = 0; i < sample_num; i++) {
+    auto res = sampler.sample_k(3, rng);
+    ASSERT_EQ(res.size(), 3UL);
+    std::unordered_set<int> uniq(res.begin(), res.end());
+    ASSERT_EQ(uniq.size(), 3UL);
+    ASSERT_EQ(uniq.count(1), 0UL);
+    first_count[res[0]]++;
+  }
+  // the first draw is proportional to the weights
+  for (size_t i = 0; i < weights.size(); i++) {
+    ASSERT_NEAR(1.0 * first_count[i] / sample_num, weights[i] / 20, 0.01);
+  }
+  ASSERT_EQ(sampler.sample_k(10, rng).size(), weights.size());
+
+  // only one neighbor has weight, the rest are drawn after the rejections
+  distributed::WeightedGraphEdgeBlob skewed;
+  for (int i = 0; i < 100; i++) {
+    skewed.add_edge(i, i == 7 ? 1e6 : 0);
+  }
+  distributed::AliasSampler skewed_sampler;
+  skewed_sampler.build(&skewed);
+  auto res = skewed_sampler.sample_k(90, rng);
+  std::unordered_set<int> uniq(res.begin(), res.end());
+  ASSERT_EQ(uniq.size(), 90UL);
+  ASSERT_EQ(uniq.count(7), 1UL);
+}
+
+void testGraphCsrStorage() {
+  prepare_file(edge_file_name, edges);
+  ::paddle::distributed::GraphParameter table_proto;
+  table_proto.add_edge_types("user2item");
+  table_proto.set_shard_num(7);
+  table_proto.set_task_pool_size(4);
+  distributed::GraphTable node_table, csr_table;
+  node_table.Initialize(table_proto);
+  table_proto.set_use_csr_storage(true);
+  csr_table.Initialize(table_proto);
+  node_table.Load(std::string(edge_file_name), std::string("e>user2item"));
+  csr_table.Load(std::string(edge_file_name), std::string("e>user2item"));
+
+  std::vector<int64_t> ids = {37, 96, 59, 97, 45};
+  std::vector<std::shared_ptr<char>> node_buffers(ids.size()),
+      csr_buffers(ids.size());
+  std::vector<int> node_sizes(ids.size()), csr_sizes(ids.size());
+  // all the neighbors are returned in the same order
+  node_table.random_sample_neighbors(
+      0, ids.data(), 10, node_buffers, node_sizes, true);
+  csr_table.random_sample_neighbors(
+      0, ids.data(), 10, csr_buffers, csr_sizes, true);
+  for (size_t i = 0; i < ids.size(); i++) {
+    ASSERT_EQ(node_sizes[i], csr_sizes[i]);
+    ASSERT_EQ(memcmp(node_buffers[i].get(), csr_buffers[i].get(), csr_sizes[i]),
+              0);
+  }
+  ASSERT_EQ(csr_sizes[0], 3 * (int)(sizeof(int64_t) + sizeof(float)));
+  ASSERT_EQ(csr_sizes[4], 0);
+
+  csr_table.random_sample_neighbors(
+      0, ids.data(), 2, csr_buffers, csr_sizes, false);
+  ASSERT_EQ(csr_sizes[1], 2 * (int)sizeof(int64_t));
+  int64_t *sampled = reinterpret_cast<int64_t *>(csr_buffers[1].get());
+  std::unordered_set<int64_t> neighbors = {48, 247, 111};
+  ASSERT_TRUE(neighbors.count(sampled[0]) && neighbors.count(sampled[1]));
+  ASSERT_NE(sampled[0], sampled[1]);
+
+  auto all_ids = csr_table.get_all_id(0, 0, 1);
+  std::sort(all_ids[0].begin(), all_ids[0].end());
+  ASSERT_EQ(all_ids[0], std::vector<int64_t>({37, 59, 96, 97}));
+  std::unique_ptr<char[]> buffer;
+  int actual_size = 0;
+  csr_table.random_sample_nodes(0, 0, 3, buffer, actual_size);
+  ASSERT_EQ(actual_size, 3 * (int)sizeof(int64_t));
+  csr_table.pull_graph_list(0, 0, 0, 10, buffer, actual_size, false, 1);
+  ASSERT_EQ(actual_size, 4 * (int)(sizeof(int64_t) + sizeof(int)));
+
+  // a second load is merged into the csr storage
+  prepare_file(edge_file_name, {std::string("45\t37\t0.5")});
+  csr_table.Load(std::string(edge_file_name), std::string("e>user2item"));
+  csr_table.random_sample_neighbors(
+      0, ids.data(), 10, csr_buffers, csr_sizes, false);
+  ASSERT_EQ(csr_sizes[0], 3 * (int)sizeof(int64_t));
+  ASSERT_EQ(csr_sizes[4], (int)sizeof(int64_t));
+  ASSERT_EQ(*reinterpret_cast<int64_t *>(csr_buffers[4].get()), 37);
+  unlink(edge_file_name);
+}
+
+TEST(testGraphSample, CsrStorage) { testGraphCsrStorage(); }
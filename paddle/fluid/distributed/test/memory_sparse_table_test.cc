@@ -17,6 +17,7 @@ limitations under the License. */
 #include <ThreadPool.h>
 #include <unistd.h>
 
+#include <cstdio>
 #include <string>
 #include <thread>  // NOLINT
 
@@ -152,5 +153,163 @@ TEST(MemorySparseTable, SGD) {
   }
 }
 
+static MemorySparseTable *CreateCtrTable(bool save_binary) {
+  TableParameter table_config;
+  table_config.set_table_class("MemorySparseTable");
+  table_config.set_shard_num(4);
+  table_config.set_save_binary(save_binary);
+  TableAccessorParameter *accessor_config = table_config.mutable_accessor();
+  accessor_config->set_accessor_class("CtrCommonAccessor");
+  accessor_config->set_fea_dim(11);
+  accessor_config->set_embedx_dim(8);
+  accessor_config->set_embedx_threshold(5);
+  accessor_config->mutable_embed_sgd_param()->set_name("SparseNaiveSGDRule");
+  accessor_config->mutable_embedx_sgd_param()->set_name("SparseNaiveSGDRule");
+  for (auto *sgd_param : {accessor_config->mutable_embed_sgd_param(),
+                          accessor_config->mutable_embedx_sgd_param()}) {
+    auto *naive_param = sgd_param->mutable_naive();
+    naive_param->set_learning_rate(0.1);
+    naive_param->set_initial_range(0.3);
+    naive_param->add_weight_bounds(-10.0);
+    naive_param->add_weight_bounds(10.0);
+  }
+  FsClientParameter fs_config;
+  Table *table = new MemorySparseTable();
+  table->SetShard(0, 1);
+  EXPECT_EQ(table->Initialize(table_config, fs_config), 0);
+  return static_cast<MemorySparseTable *>(table);
+}
+
+// pushes a show, a click and the gradients of embed and embedx, the keys
+// pushed with a large show extend to the embedx
+static void PushKeys(MemorySparseTable *table,
+                     const std::vector<uint64_t> &keys,
+                     float show) {
+  std::vector<float> values;
+  for (auto key : keys) {
+    values.push_back(0);  // slot
+    values.push_back(show);
+    values.push_back(1);  // click
+    for (int k = 0; k < 9; ++k) {
+      values.push_back(0.01 * (key % 7 + k));
+    }
+  }
+  table->PushSparse(keys.data(), values.data(), keys.size());
+}
+
+static void ExpectTableEqual(MemorySparseTable *expect,
+                             MemorySparseTable *actual) {
+  ASSERT_EQ(expect->LocalSize(), actual->LocalSize());
+  for (size_t i = 0; i < 4; ++i) {
+    auto *expect_shard =
+        static_cast<MemorySparseTable::shard_type *>(expect->GetShard(i));
+    auto *actual_shard =
+        static_cast<MemorySparseTable::shard_type *>(actual->GetShard(i));
+    for (auto it = expect_shard->begin(); it != expect_shard->end(); ++it) {
+      auto actual_it = actual_shard->find(it.key());
+      ASSERT_TRUE(actual_it != actual_shard->end());
+      ASSERT_EQ(it.value().size(), actual_it.value().size());
+      for (size_t k = 0; k < it.value().size(); ++k) {
+        ASSERT_EQ(it.value().data()[k], actual_it.value().data()[k]);
+      }
+    }
+  }
+}
+
+TEST(MemorySparseTable, SaveBinaryAndDelta) {
+  const std::string base_dir = "./memory_sparse_table_test_base";
+  const std::string delta_dir = "./memory_sparse_table_test_delta";
+  std::unique_ptr<MemorySparseTable> table(CreateCtrTable(true));
+  std::vector<uint64_t> keys;
+  for (uint64_t key = 0; key < 1000; ++key) {
+    keys.push_back(key * 13);
+  }
+  // half of the keys extend to the embedx
+  PushKeys(table.get(), keys, 1);
+  PushKeys(table.get(),
+           std::vector<uint64_t>(keys.begin(), keys.begin() + 500),
+           100);
+  ASSERT_EQ(table->Save(base_dir, "0"), 0);
+
+  std::unique_ptr<MemorySparseTable> loaded(CreateCtrTable(true));
+  ASSERT_EQ(loaded->Load(base_dir, "0"), 0);
+  ExpectTableEqual(table.get(), loaded.get());
+
+  // the delta saves the updated and the created keys only
+  std::vector<uint64_t> delta_keys = {13, 26, 130, 777, 100001, 100002};
+  PushKeys(table.get(), delta_keys, 100);
+  ASSERT_EQ(table->Save(delta_dir, "6"), 0);
+  std::unique_ptr<MemorySparseTable> delta(CreateCtrTable(true));
+  ASSERT_EQ(delta->Load(delta_dir, "6"), 0);
+  ASSERT_EQ(delta->LocalSize(), static_cast<int64_t>(delta_keys.size()));
+
+  // base + delta restores the table
+  ASSERT_EQ(loaded->Load(delta_dir, "6"), 0);
+  ExpectTableEqual(table.get(), loaded.get());
+
+  // nothing is dirty after the delta
+  ASSERT_EQ(table->Save(delta_dir, "6"), 0);
+  std::unique_ptr<MemorySparseTable> empty_delta(CreateCtrTable(true));
+  ASSERT_EQ(empty_delta->Load(delta_dir, "6"), 0);
+  ASSERT_EQ(empty_delta->LocalSize(), 0);
+
+  // the values decayed by a shrink go to the next delta
+  ASSERT_EQ(table->Shrink(""), 0);
+  ASSERT_EQ(table->Save(delta_dir, "6"), 0);
+  std::unique_ptr<MemorySparseTable> shrink_delta(CreateCtrTable(true));
+  ASSERT_EQ(shrink_delta->Load(delta_dir, "6"), 0);
+  ASSERT_EQ(shrink_delta->LocalSize(), table->LocalSize());
+  ASSERT_EQ(loaded->Load(delta_dir, "6"), 0);
+  ExpectTableEqual(table.get(), loaded.get());
+}
+
+TEST(MemorySparseTable, BinaryFormatChecksum) {
+  const std::string path = "./memory_sparse_table_test.bin";
+  AfsClient afs_client;
+  FsChannelConfig channel_config;
+  channel_config.path = path;
+  {
+    auto write_channel = afs_client.open_w(channel_config);
+    SparseBinaryWriter writer(write_channel.get(), 4, 3);
+    ASSERT_EQ(writer.WriteHeader(), 0);
+    for (uint64_t key = 0; key < 10; ++key) {
+      std::vector<float> value(key % 2 == 0 ? 4 : 2, key * 0.5);
+      ASSERT_EQ(writer.Write(key, value.data(), value.size()), 0);
+    }
+    ASSERT_EQ(writer.Finish(), 0);
+    write_channel->close();
+  }
+  {
+    auto read_channel = afs_client.open_r(channel_config);
+    SparseBinaryReader reader(read_channel.get());
+    ASSERT_EQ(reader.ReadHeader(), 0);
+    ASSERT_EQ(reader.value_dim(), 4U);
+    size_t key_num = 0;
+    while (reader.NextBlock() > 0) {
+      ASSERT_LE(reader.key_num(), 3U);
+      for (size_t k = 0; k < reader.key_num(); ++k) {
+        uint64_t key = reader.keys()[k];
+        ASSERT_EQ(reader.value_size(), key % 2 == 0 ? 4U : 2U);
+        ASSERT_EQ(reader.value(k)[reader.value_size() - 1], key * 0.5);
+      }
+      key_num += reader.key_num();
+    }
+    ASSERT_EQ(key_num, 10U);
+  }
+
+  // flip a byte of the first block
+  FILE *fp = fopen(path.c_str(), "r+b");
+  ASSERT_NE(fp, nullptr);
+  fseek(fp,
+        sizeof(SparseBinaryFileHeader) + sizeof(SparseBinaryBlockHeader) + 1,
+        SEEK_SET);
+  fputc(0x7f, fp);
+  fclose(fp);
+  auto read_channel = afs_client.open_r(channel_config);
+  SparseBinaryReader reader(read_channel.get());
+  ASSERT_EQ(reader.ReadHeader(), 0);
+  ASSERT_EQ(reader.NextBlock(), -1);
+}
+
 }  // namespace distributed
 }  // namespace paddle
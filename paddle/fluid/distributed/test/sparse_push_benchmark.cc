@@ -0,0 +1,144 @@
+// Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Measure the push throughput of a MemorySparseTable with CtrCommonAccessor
+// for every sparse sgd rule, e.g.
+//   sparse_push_benchmark --key_num=1000000 --embedx_dim=64 --batch=100000
+// All the keys are extended to the embedx before the measured pushes, so that
+// the numbers are dominated by the sgd rules.
+
+#include <algorithm>
+#include <random>
+#include <sstream>
+
+#include "gflags/gflags.h"
+#include "glog/logging.h"
+#include "paddle/fluid/distributed/ps/table/memory_sparse_table.h"
+#include "paddle/fluid/distributed/the_one_ps.pb.h"
+#include "paddle/fluid/platform/timer.h"
+
+DEFINE_int64(key_num, 1000000, "The number of keys of the table.");
+DEFINE_int32(shard_num, 24, "The shard num of the table.");
+DEFINE_int32(embedx_dim, 64, "The embedx dim of CtrCommonAccessor.");
+DEFINE_int32(batch, 100000, "The keys of every PushSparse.");
+DEFINE_int32(rounds, 20, "The number of measured pushes.");
+DEFINE_string(rules,
+              "SparseAdaGradSGDRule,StdAdaGradSGDRule,SparseAdamSGDRule,"
+              "SparseSharedAdamSGDRule",
+              "The sgd rules to measure, split by comma.");
+
+namespace paddle {
+namespace distributed {
+
+static MemorySparseTable* CreateTable(const std::string& rule) {
+  TableParameter table_config;
+  table_config.set_table_class("MemorySparseTable");
+  table_config.set_shard_num(FLAGS_shard_num);
+  table_config.set_enable_sparse_table_cache(false);
+  auto* accessor = table_config.mutable_accessor();
+  accessor->set_accessor_class("CtrCommonAccessor");
+  accessor->set_fea_dim(FLAGS_embedx_dim + 3);
+  accessor->set_embedx_dim(FLAGS_embedx_dim);
+  accessor->set_embedx_threshold(5);
+  for (auto* sgd_param : {accessor->mutable_embed_sgd_param(),
+                          accessor->mutable_embedx_sgd_param()}) {
+    sgd_param->set_name(rule);
+    auto* adagrad = sgd_param->mutable_adagrad();
+    adagrad->set_learning_rate(0.05);
+    adagrad->set_initial_g2sum(3.0);
+    adagrad->set_initial_range(0.0001);
+    adagrad->add_weight_bounds(-10.0);
+    adagrad->add_weight_bounds(10.0);
+    auto* adam = sgd_param->mutable_adam();
+    adam->set_learning_rate(0.001);
+    adam->set_initial_range(0.0001);
+    adam->set_beta1_decay_rate(0.9);
+    adam->set_beta2_decay_rate(0.999);
+    adam->set_ada_epsilon(1e-08);
+    adam->add_weight_bounds(-10.0);
+    adam->add_weight_bounds(10.0);
+  }
+  FsClientParameter fs_config;
+  Table* table = new MemorySparseTable();
+  table->SetShard(0, 1);
+  CHECK_EQ(table->Initialize(table_config, fs_config), 0);
+  return static_cast<MemorySparseTable*>(table);
+}
+
+// fills a push of FLAGS_batch random keys, [slot, show, click, grads...]
+static void MakePush(std::mt19937_64* rng,
+                     float show,
+                     std::vector<uint64_t>* keys,
+                     std::vector<float>* values) {
+  size_t push_dim = FLAGS_embedx_dim + 4;
+  std::uniform_real_distribution<float> grad(-1.0, 1.0);
+  keys->clear();
+  values->clear();
+  for (int i = 0; i < FLAGS_batch; ++i) {
+    keys->push_back((*rng)() % FLAGS_key_num);
+    values->push_back(0);
+    values->push_back(show);
+    values->push_back(0);
+    for (size_t k = 3; k < push_dim; ++k) {
+      values->push_back(grad(*rng));
+    }
+  }
+}
+
+static int BenchmarkMain() {
+  std::stringstream ss(FLAGS_rules);
+  std::string rule;
+  while (std::getline(ss, rule, ',')) {
+    std::unique_ptr<MemorySparseTable> table(CreateTable(rule));
+    std::mt19937_64 rng(0);
+    std::vector<uint64_t> keys;
+    std::vector<float> values;
+    // creates and extends all the keys
+    for (int64_t start = 0; start < FLAGS_key_num; start += FLAGS_batch) {
+      keys.clear();
+      values.clear();
+      size_t push_dim = FLAGS_embedx_dim + 4;
+      for (int64_t key = start;
+           key < std::min<int64_t>(start + FLAGS_batch, FLAGS_key_num);
+           ++key) {
+        keys.push_back(key);
+        values.resize(values.size() + push_dim, 0);
+        values[values.size() - push_dim + 1] = 100;
+      }
+      table->PushSparse(keys.data(), values.data(), keys.size());
+    }
+
+    platform::Timer timer;
+    for (int round = 0; round < FLAGS_rounds; ++round) {
+      MakePush(&rng, 1, &keys, &values);
+      timer.Start();
+      table->PushSparse(keys.data(), values.data(), keys.size());
+      timer.Pause();
+    }
+    double ms = timer.ElapsedMS();
+    LOG(INFO) << rule << ": " << ms / FLAGS_rounds << " ms per push, "
+              << static_cast<double>(FLAGS_batch) * FLAGS_rounds / ms * 1000
+              << " keys/s";
+  }
+  return 0;
+}
+
+}  // namespace distributed
+}  // namespace paddle
+
+int main(int argc, char* argv[]) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  google::InitGoogleLogging(argv[0]);
+  return paddle::distributed::BenchmarkMain();
+}
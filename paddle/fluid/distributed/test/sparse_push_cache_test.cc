@@ -0,0 +1,195 @@
+/* Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/fluid/distributed/ps/service/sparse_push_cache.h"
+
+#include <atomic>
+#include <thread>  // NOLINT
+
+#include "gtest/gtest.h"
+#include "paddle/fluid/distributed/common/registerer.h"
+#include "paddle/fluid/distributed/ps/table/ctr_accessor.h"
+#include "paddle/fluid/distributed/ps/table/sparse_sgd_rule.h"
+#include "paddle/fluid/distributed/the_one_ps.pb.h"
+
+namespace paddle {
+namespace distributed {
+REGISTER_PSCORE_CLASS(SparseValueSGDRule, SparseAdaGradSGDRule);
+REGISTER_PSCORE_CLASS(SparseValueSGDRule, SparseNaiveSGDRule);
+
+static std::unique_ptr<CtrCommonAccessor> CreateAccessor() {
+  TableAccessorParameter param;
+  param.set_accessor_class("CtrCommonAccessor");
+  param.set_fea_dim(11);
+  param.set_embedx_dim(8);
+  param.mutable_embed_sgd_param()->set_name("SparseAdaGradSGDRule");
+  auto* adagrad_param = param.mutable_embed_sgd_param()->mutable_adagrad();
+  adagrad_param->set_learning_rate(0.1);
+  adagrad_param->set_initial_range(0.3);
+  adagrad_param->add_weight_bounds(-10.0);
+  adagrad_param->add_weight_bounds(10.0);
+  param.mutable_embedx_sgd_param()->set_name("SparseNaiveSGDRule");
+  auto* naive_param = param.mutable_embedx_sgd_param()->mutable_naive();
+  naive_param->set_learning_rate(0.1);
+  naive_param->set_initial_range(0.3);
+  naive_param->add_weight_bounds(-10.0);
+  naive_param->add_weight_bounds(10.0);
+
+  std::unique_ptr<CtrCommonAccessor> acc(new CtrCommonAccessor());
+  EXPECT_EQ(acc->Configure(param), 0);
+  EXPECT_EQ(acc->Initialize(), 0);
+  return acc;
+}
+
+TEST(SparsePushCache, merge_by_accessor) {
+  auto acc = CreateAccessor();
+  size_t dim = acc->GetAccessorInfo().update_dim;
+  SparsePushCache cache(acc.get(), 2);
+
+  // slot show click embed_g embedx_g...
+  std::vector<float> v1(dim, 1.0), v2(dim, 2.0);
+  v1[0] = 5;
+  v2[0] = 7;
+  cache.Add(0, {{10, v1.data()}, {12, v2.data()}});
+  cache.Add(0, {{10, v2.data()}});
+  cache.Add(1, {{11, v1.data()}});
+  ASSERT_EQ(cache.Size(), 3u);
+  ASSERT_EQ(cache.AddedKeys(), 4u);
+
+  std::vector<uint64_t> keys;
+  std::vector<float> values;
+  ASSERT_EQ(cache.Drain(0, &keys, &values), 2u);
+  ASSERT_EQ(keys, std::vector<uint64_t>({10, 12}));
+  // the slot of the first push is kept, the others are summed
+  ASSERT_FLOAT_EQ(values[0], 5);
+  for (size_t i = 1; i < dim; ++i) {
+    ASSERT_FLOAT_EQ(values[i], 3.0);
+  }
+  ASSERT_FLOAT_EQ(values[dim], 7);
+  ASSERT_FLOAT_EQ(values[dim + 1], 2.0);
+
+  ASSERT_EQ(cache.Drain(1, &keys, &values), 1u);
+  ASSERT_EQ(keys[0], 11u);
+  ASSERT_EQ(cache.Size(), 0u);
+  ASSERT_EQ(cache.Drain(0, &keys, &values), 0u);
+  ASSERT_DOUBLE_EQ(cache.MergeRatio(), 0.25);
+}
+
+TEST(SparsePushCache, flush_condition) {
+  auto acc = CreateAccessor();
+  size_t dim = acc->GetAccessorInfo().update_dim;
+  SparsePushCache cache(acc.get(), 1);
+  std::vector<float> v(dim, 1.0);
+
+  ASSERT_FALSE(cache.NeedFlush(1, 0));
+  cache.Add(0, {{1, v.data()}, {2, v.data()}});
+  ASSERT_TRUE(cache.NeedFlush(2, 1000000));
+  ASSERT_FALSE(cache.NeedFlush(3, 1000000));
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  ASSERT_TRUE(cache.NeedFlush(3, 10));
+
+  std::vector<uint64_t> keys;
+  std::vector<float> values;
+  cache.Drain(0, &keys, &values);
+  cache.MarkFlushed();
+  ASSERT_FALSE(cache.NeedFlush(1, 0));
+}
+
+TEST(SparsePushCache, concurrent_add) {
+  auto acc = CreateAccessor();
+  size_t dim = acc->GetAccessorInfo().update_dim;
+  const size_t shard_num = 4, thread_num = 8, key_num = 1000, rounds = 10;
+  SparsePushCache cache(acc.get(), shard_num);
+  std::vector<float> v(dim, 1.0);
+
+  std::vector<std::thread> threads;
+  for (size_t t = 0; t < thread_num; ++t) {
+    threads.emplace_back([&] {
+      for (size_t r = 0; r < rounds; ++r) {
+        std::vector<std::vector<std::pair<uint64_t, const float*>>> kvs(
+            shard_num);
+        for (uint64_t key = 0; key < key_num; ++key) {
+          kvs[key % shard_num].push_back({key, v.data()});
+        }
+        for (size_t i = 0; i < shard_num; ++i) {
+          cache.Add(i, kvs[i]);
+        }
+      }
+    });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+  ASSERT_EQ(cache.Size(), key_num);
+
+  std::vector<uint64_t> keys;
+  std::vector<float> values;
+  for (size_t i = 0; i < shard_num; ++i) {
+    size_t num = cache.Drain(i, &keys, &values);
+    for (size_t k = 0; k < num; ++k) {
+      // show of every key is summed over all the pushes
+      ASSERT_FLOAT_EQ(values[k * dim + 1], thread_num * rounds);
+    }
+  }
+  ASSERT_DOUBLE_EQ(cache.MergeRatio(),
+                   1.0 - 1.0 / static_cast<double>(thread_num * rounds));
+}
+
+TEST(SparsePushCache, concurrent_add_and_drain) {
+  auto acc = CreateAccessor();
+  size_t dim = acc->GetAccessorInfo().update_dim;
+  const size_t shard_num = 4, thread_num = 4, key_num = 1000, rounds = 100;
+  SparsePushCache cache(acc.get(), shard_num);
+  std::vector<float> v(dim, 1.0);
+
+  std::atomic<bool> done{false};
+  std::atomic<size_t> drained{0};
+  std::thread drainer([&] {
+    std::vector<uint64_t> keys;
+    std::vector<float> values;
+    while (!done) {
+      for (size_t i = 0; i < shard_num; ++i) {
+        drained += cache.Drain(i, &keys, &values);
+        // the size never wraps around below 0
+        ASSERT_LE(cache.Size(), key_num);
+      }
+    }
+  });
+  std::vector<std::thread> threads;
+  for (size_t t = 0; t < thread_num; ++t) {
+    threads.emplace_back([&] {
+      for (size_t r = 0; r < rounds; ++r) {
+        for (uint64_t key = 0; key < key_num; ++key) {
+          cache.Add(key % shard_num, {{key, v.data()}});
+        }
+      }
+    });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+  done = true;
+  drainer.join();
+
+  std::vector<uint64_t> keys;
+  std::vector<float> values;
+  for (size_t i = 0; i < shard_num; ++i) {
+    drained += cache.Drain(i, &keys, &values);
+  }
+  ASSERT_EQ(cache.Size(), 0u);
+  ASSERT_EQ(drained.load(), cache.DrainedKeys());
+}
+
+}  // namespace distributed
+}  // namespace paddle
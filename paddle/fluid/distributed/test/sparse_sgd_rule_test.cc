@@ -16,6 +16,7 @@ limitations under the License. */
 
 #include <cmath>
 #include <iostream>
+#include <vector>
 
 #include "gtest/gtest.h"
 #include "paddle/fluid/distributed/the_one_ps.pb.h"
@@ -205,5 +206,77 @@ TEST(downpour_sparse_adam_test, test_init_and_update) {
     ASSERT_FLOAT_EQ(value[i], label[i]) << "i is " << i;
   }
 }
+
+// the batched UpdateValue runs the SIMD kernels, check it against the update
+// of every key alone for the dims with and without the scalar tail
+template <class Rule>
+void CheckBatchUpdate(const SparseCommonSGDRuleParameter& param) {
+  const size_t kKeyNum = 37;
+  for (size_t embed_dim : {1, 8, 13, 64}) {
+    Rule rule;
+    rule.LoadConfig(param, embed_dim);
+    // the push values are [show, grad...], the values are [w..., sgd...]
+    size_t value_dim = embed_dim + rule.Dim();
+    size_t push_dim = embed_dim + 1;
+    std::vector<float> values(kKeyNum * value_dim);
+    std::vector<float> push(kKeyNum * push_dim);
+    std::vector<float> scales(kKeyNum);
+    for (size_t k = 0; k < kKeyNum; ++k) {
+      rule.InitValue(&values[k * value_dim], &values[k * value_dim + embed_dim]);
+      scales[k] = push[k * push_dim] = k % 5 + 1;
+      for (size_t i = 0; i < embed_dim; ++i) {
+        push[k * push_dim + 1 + i] = std::sin(k * 7.0 + i) * 3.0;
+      }
+    }
+    std::vector<float> expect = values;
+    for (int round = 0; round < 3; ++round) {
+      std::vector<float*> value_ptrs;
+      std::vector<const float*> push_ptrs;
+      for (size_t k = 0; k < kKeyNum; ++k) {
+        rule.UpdateValue(&expect[k * value_dim],
+                         &expect[k * value_dim + embed_dim],
+                         &push[k * push_dim + 1],
+                         scales[k]);
+        value_ptrs.push_back(&values[k * value_dim]);
+        push_ptrs.push_back(&push[k * push_dim]);
+      }
+      rule.UpdateValue(kKeyNum,
+                       value_ptrs.data(),
+                       0,
+                       embed_dim,
+                       push_ptrs.data(),
+                       1,
+                       scales.data());
+    }
+    for (size_t i = 0; i < values.size(); ++i) {
+      ASSERT_NEAR(values[i], expect[i], 1e-4 * (1 + std::fabs(expect[i])))
+          << "dim " << embed_dim << " i " << i;
+    }
+  }
+}
+
+TEST(sparse_sgd_rule_batch_test, test_batch_update) {
+  SparseCommonSGDRuleParameter adagrad;
+  auto* adagrad_param = adagrad.mutable_adagrad();
+  adagrad_param->set_learning_rate(0.1);
+  adagrad_param->set_initial_g2sum(0.2);
+  adagrad_param->set_initial_range(0.3);
+  adagrad_param->add_weight_bounds(-1.0);
+  adagrad_param->add_weight_bounds(1.0);
+  CheckBatchUpdate<SparseAdaGradSGDRule>(adagrad);
+  CheckBatchUpdate<StdAdaGradSGDRule>(adagrad);
+
+  SparseCommonSGDRuleParameter adam;
+  auto* adam_param = adam.mutable_adam();
+  adam_param->set_learning_rate(0.1);
+  adam_param->set_initial_range(0.3);
+  adam_param->set_beta1_decay_rate(0.9);
+  adam_param->set_beta2_decay_rate(0.999);
+  adam_param->set_ada_epsilon(1e-08);
+  adam_param->add_weight_bounds(-1.0);
+  adam_param->add_weight_bounds(1.0);
+  CheckBatchUpdate<SparseAdamSGDRule>(adam);
+  CheckBatchUpdate<SparseSharedAdamSGDRule>(adam);
+}
 }  // namespace distributed
 }  // namespace paddle
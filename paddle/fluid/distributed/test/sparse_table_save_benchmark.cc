@@ -0,0 +1,162 @@
+// Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Compare the save and the load throughput of a MemorySparseTable checkpoint
+// in the text format and in the binary format, and the size of a delta
+// checkpoint after --delta_rate of the keys are pushed again, e.g.
+//   sparse_table_save_benchmark --key_num=10000000 --shard_num=64 \
+//       --dir=/tmp/sparse_table_save_benchmark
+
+#include <algorithm>
+#include <fstream>
+#include <random>
+
+#include "gflags/gflags.h"
+#include "glog/logging.h"
+#include "paddle/fluid/distributed/ps/table/memory_sparse_table.h"
+#include "paddle/fluid/distributed/the_one_ps.pb.h"
+#include "paddle/fluid/framework/io/fs.h"
+#include "paddle/fluid/platform/timer.h"
+
+DEFINE_int64(key_num, 10000000, "The number of keys of the table.");
+DEFINE_int32(shard_num, 64, "The shard num of the table.");
+DEFINE_int32(embedx_dim, 8, "The embedx dim of CtrCommonAccessor.");
+DEFINE_double(mf_rate, 0.5, "The rate of the keys having the embedx.");
+DEFINE_double(delta_rate, 0.05, "The rate of the keys pushed after saving.");
+DEFINE_bool(compress, false, "Whether the text checkpoint is gzipped.");
+DEFINE_string(dir, "/tmp/sparse_table_save_benchmark", "The checkpoint dir.");
+
+namespace paddle {
+namespace distributed {
+
+static MemorySparseTable* CreateTable(bool save_binary) {
+  TableParameter table_config;
+  table_config.set_table_class("MemorySparseTable");
+  table_config.set_shard_num(FLAGS_shard_num);
+  table_config.set_compress_in_save(FLAGS_compress);
+  table_config.set_enable_sparse_table_cache(false);
+  table_config.set_save_binary(save_binary);
+  auto* accessor = table_config.mutable_accessor();
+  accessor->set_accessor_class("CtrCommonAccessor");
+  accessor->set_fea_dim(FLAGS_embedx_dim + 3);
+  accessor->set_embedx_dim(FLAGS_embedx_dim);
+  accessor->set_embedx_threshold(5);
+  for (auto* sgd_param : {accessor->mutable_embed_sgd_param(),
+                          accessor->mutable_embedx_sgd_param()}) {
+    sgd_param->set_name("SparseAdaGradSGDRule");
+    auto* adagrad = sgd_param->mutable_adagrad();
+    adagrad->set_learning_rate(0.05);
+    adagrad->set_initial_g2sum(3.0);
+    adagrad->set_initial_range(0.0001);
+    adagrad->add_weight_bounds(-10.0);
+    adagrad->add_weight_bounds(10.0);
+  }
+  FsClientParameter fs_config;
+  Table* table = new MemorySparseTable();
+  table->SetShard(0, 1);
+  CHECK_EQ(table->Initialize(table_config, fs_config), 0);
+  return static_cast<MemorySparseTable*>(table);
+}
+
+// pushes the keys [begin, end) in batches, the keys pushed with a large show
+// extend to the embedx
+static void PushKeys(MemorySparseTable* table,
+                     int64_t begin,
+                     int64_t end,
+                     std::mt19937_64* rng) {
+  const int64_t batch = 100000;
+  size_t push_dim = FLAGS_embedx_dim + 4;
+  std::uniform_real_distribution<float> grad(-1.0, 1.0);
+  std::uniform_real_distribution<float> rate(0.0, 1.0);
+  std::vector<uint64_t> keys;
+  std::vector<float> values;
+  for (int64_t start = begin; start < end; start += batch) {
+    keys.clear();
+    values.clear();
+    for (int64_t key = start; key < std::min(start + batch, end); ++key) {
+      keys.push_back(key);
+      values.push_back(0);                                      // slot
+      values.push_back(rate(*rng) < FLAGS_mf_rate ? 100 : 1);  // show
+      values.push_back(1);                                      // click
+      for (size_t k = 3; k < push_dim; ++k) {
+        values.push_back(grad(*rng));
+      }
+    }
+    table->PushSparse(keys.data(), values.data(), keys.size());
+  }
+}
+
+static double DirMB(const std::string& dir) {
+  double bytes = 0;
+  for (const auto& file : framework::fs_list(dir)) {
+    std::ifstream fin(file, std::ios::binary | std::ios::ate);
+    bytes += fin.tellg();
+  }
+  return bytes / (1 << 20);
+}
+
+static void Report(const std::string& title,
+                   double ms,
+                   int64_t key_num,
+                   const std::string& dir) {
+  LOG(INFO) << title << ": " << ms << " ms, " << key_num / ms * 1000
+            << " keys/s, " << DirMB(dir + "/000") << " MB";
+}
+
+static int BenchmarkMain() {
+  platform::Timer timer;
+  std::unique_ptr<MemorySparseTable> binary_table;
+  for (bool save_binary : {false, true}) {
+    std::string format = save_binary ? "binary" : "text";
+    std::string dir = FLAGS_dir + "/" + format;
+    // the same values in both formats
+    std::mt19937_64 rng(0);
+    std::unique_ptr<MemorySparseTable> table(CreateTable(save_binary));
+    PushKeys(table.get(), 0, FLAGS_key_num, &rng);
+    timer.Reset();
+    timer.Start();
+    CHECK_EQ(table->Save(dir, "0"), 0);
+    timer.Pause();
+    Report(format + " save", timer.ElapsedMS(), table->LocalSize(), dir);
+
+    std::unique_ptr<MemorySparseTable> loaded(CreateTable(save_binary));
+    timer.Reset();
+    timer.Start();
+    CHECK_EQ(loaded->Load(dir, "0"), 0);
+    timer.Pause();
+    Report(format + " load", timer.ElapsedMS(), loaded->LocalSize(), dir);
+    binary_table = std::move(table);
+  }
+
+  // only the keys pushed after the checkpoint are dirty
+  std::mt19937_64 rng(1);
+  int64_t delta_num = FLAGS_key_num * FLAGS_delta_rate;
+  PushKeys(binary_table.get(), 0, delta_num, &rng);
+  std::string delta_dir = FLAGS_dir + "/delta";
+  timer.Reset();
+  timer.Start();
+  CHECK_EQ(binary_table->Save(delta_dir, "6"), 0);
+  timer.Pause();
+  Report("binary delta save", timer.ElapsedMS(), delta_num, delta_dir);
+  return 0;
+}
+
+}  // namespace distributed
+}  // namespace paddle
+
+int main(int argc, char* argv[]) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  google::InitGoogleLogging(argv[0]);
+  return paddle::distributed::BenchmarkMain();
+}
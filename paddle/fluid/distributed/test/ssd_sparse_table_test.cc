@@ -0,0 +1,143 @@
+/* Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/fluid/distributed/ps/table/ssd_sparse_table.h"
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "gflags/gflags.h"
+#include "gtest/gtest.h"
+#include "paddle/fluid/distributed/the_one_ps.pb.h"
+
+DECLARE_string(rocksdb_path);
+
+namespace paddle {
+namespace distributed {
+
+// 4 shards of 50 keys, each shard holds 10 values in memory
+static SSDSparseTable *CreateSSDTable() {
+  FLAGS_rocksdb_path = "./ssd_sparse_table_test_db";
+  TableParameter table_config;
+  table_config.set_table_class("SSDSparseTable");
+  table_config.set_shard_num(4);
+  table_config.set_ssd_dram_cache_capacity(40);
+  TableAccessorParameter *accessor_config = table_config.mutable_accessor();
+  accessor_config->set_accessor_class("CtrCommonAccessor");
+  accessor_config->set_fea_dim(11);
+  accessor_config->set_embedx_dim(8);
+  accessor_config->set_embedx_threshold(5);
+  accessor_config->mutable_ctr_accessor_param()->set_nonclk_coeff(0.2);
+  accessor_config->mutable_ctr_accessor_param()->set_click_coeff(1);
+  accessor_config->mutable_embed_sgd_param()->set_name("SparseNaiveSGDRule");
+  accessor_config->mutable_embedx_sgd_param()->set_name("SparseNaiveSGDRule");
+  for (auto *sgd_param : {accessor_config->mutable_embed_sgd_param(),
+                          accessor_config->mutable_embedx_sgd_param()}) {
+    auto *naive_param = sgd_param->mutable_naive();
+    naive_param->set_learning_rate(0.1);
+    naive_param->set_initial_range(0.3);
+    naive_param->add_weight_bounds(-10.0);
+    naive_param->add_weight_bounds(10.0);
+  }
+  FsClientParameter fs_config;
+  Table *table = new SSDSparseTable();
+  table->SetShard(0, 1);
+  EXPECT_EQ(table->Initialize(table_config, fs_config), 0);
+  return static_cast<SSDSparseTable *>(table);
+}
+
+// pushes the key with a show of key + 1, so the larger keys are hotter
+static void PushKeys(SSDSparseTable *table, const std::vector<uint64_t> &keys) {
+  std::vector<float> values;
+  for (auto key : keys) {
+    values.push_back(0);  // slot
+    values.push_back(key + 1);
+    values.push_back(1);  // click
+    for (int k = 0; k < 9; ++k) {
+      values.push_back(0.01 * (key % 7 + k));
+    }
+  }
+  table->PushSparse(keys.data(), values.data(), keys.size());
+}
+
+// copies the values, the pointers are freed by the next eviction
+static std::map<uint64_t, std::vector<float>> PullValues(
+    SSDSparseTable *table, const std::vector<uint64_t> &keys) {
+  std::vector<char *> ptrs(keys.size());
+  table->PullSparsePtr(ptrs.data(), keys.data(), keys.size());
+  std::map<uint64_t, std::vector<float>> values;
+  for (size_t i = 0; i < keys.size(); ++i) {
+    auto *value = reinterpret_cast<FixedFeatureValue *>(ptrs[i]);
+    values[keys[i]].assign(value->data(), value->data() + value->size());
+  }
+  return values;
+}
+
+static void Evict(SSDSparseTable *table) {
+  // every shard evicts before a pull, even of no key
+  table->PullSparse(nullptr, nullptr, 0);
+}
+
+// A single test, the rocksdb of the tables is a singleton.
+TEST(SSDSparseTable, EvictAndPrefetch) {
+  std::unique_ptr<SSDSparseTable> table(CreateSSDTable());
+  std::vector<uint64_t> keys;
+  for (uint64_t key = 0; key < 200; ++key) {
+    keys.push_back(key);
+  }
+  PushKeys(table.get(), keys);
+  ASSERT_EQ(table->LocalSize(), 200);
+  auto expect = PullValues(table.get(), keys);
+
+  // 41 values of each shard are moved to rocksdb, the overflow and 10% of
+  // the capacity
+  Evict(table.get());
+  ASSERT_EQ(table->LocalSize(), 36);
+  // the hottest key of each shard stays in memory
+  std::vector<uint64_t> hot_keys = {196, 197, 198, 199};
+  for (auto &item : PullValues(table.get(), hot_keys)) {
+    ASSERT_EQ(item.second, expect[item.first]);
+  }
+  ASSERT_EQ(table->LocalSize(), 36);
+
+  // the prefetch fills the room of each shard by the hottest keys in rocksdb
+  ASSERT_EQ(table->Prefetch(keys.data(), keys.size()), 0);
+  ASSERT_EQ(table->LocalSize(), 40);
+  std::vector<uint64_t> prefetched_keys = {160, 161, 162, 163};
+  for (auto &item : PullValues(table.get(), prefetched_keys)) {
+    ASSERT_EQ(item.second, expect[item.first]);
+  }
+  ASSERT_EQ(table->LocalSize(), 40);
+
+  // the others are loaded back from rocksdb by the pull
+  auto actual = PullValues(table.get(), keys);
+  ASSERT_EQ(table->LocalSize(), 200);
+  ASSERT_EQ(actual, expect);
+
+  // the push updates the values loaded from rocksdb instead of creating them
+  Evict(table.get());
+  ASSERT_EQ(table->LocalSize(), 36);
+  PushKeys(table.get(), keys);
+  ASSERT_EQ(table->LocalSize(), 200);
+  auto accessor = table->ValueAccesor();
+  for (auto &item : PullValues(table.get(), keys)) {
+    ASSERT_EQ(accessor->GetField(item.second.data(), "show"),
+              static_cast<float>(2 * (item.first + 1)));
+  }
+}
+
+}  // namespace distributed
+}  // namespace paddle
@@ -55,6 +55,10 @@ class Controller {
   paddle::imperative::AmpLevel GetAMPLevel() const {
     return tracer_->GetAmpLevel();
   }
+  void SetAMPDtype(const std::string& amp_dtype) {
+    tracer_->SetAmpDtype(amp_dtype);
+  }
+  std::string GetAMPDtype() const { return tracer_->GetAmpDtype(); }
   bool HasGrad() const { return tracer_->HasGrad(); }
   void SetHasGrad(bool has_grad) { tracer_->SetHasGrad(has_grad); }
   std::string GenerateUniqueName(std::string key = "eager_in_tmp") {
@@ -14,20 +14,43 @@
 
 #include "paddle/fluid/eager/backward.h"
 
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>  // NOLINT
 #include <deque>
+#include <exception>
+#include <mutex>  // NOLINT
+#include <string>
+#include <tuple>
 
 #include "glog/logging.h"
 #include "paddle/fluid/eager/accumulation/accumulation_node.h"
+#include "paddle/fluid/eager/api/utils/global_utils.h"
 #include "paddle/fluid/eager/autograd_meta.h"
 #include "paddle/fluid/eager/grad_node_info.h"
 #include "paddle/fluid/eager/grad_tensor_holder.h"
 #include "paddle/fluid/eager/utils.h"
+#include "paddle/fluid/framework/new_executor/workqueue/workqueue.h"
 #include "paddle/fluid/platform/enforce.h"
 #include "paddle/fluid/platform/errors.h"
+#include "paddle/fluid/platform/flags.h"
 #include "paddle/fluid/platform/profiler.h"
 #include "paddle/fluid/platform/profiler/event_tracing.h"
 #include "paddle/phi/kernels/autotune/switch_autotune.h"
 
+PADDLE_DEFINE_EXPORTED_int32(
+    eager_backward_thread_num,
+    0,
+    "The thread num of the eager backward. If it is larger than 1, the grad "
+    "nodes of a CPU backward graph run in parallel once their inputs are "
+    "ready, otherwise they run one by one on the calling thread.");
+PADDLE_DEFINE_EXPORTED_bool(
+    eager_backward_deterministic,
+    true,
+    "Whether the parallel eager backward sums the grads that reach a grad "
+    "node in a fixed order, so that the result does not depend on which "
+    "thread finishes first.");
+
 namespace egr {
 
 /*
@@ -553,6 +576,320 @@ void DuplicateCheck(const std::vector<paddle::experimental::Tensor>& inputs,
 
 GeneralGrad* GeneralGrad::general_grad_ = new GeneralGrad();
 
+/*
+ * The parallel backward runs the grad nodes of a backward graph on a work
+ * stealing thread pool. A grad node is scheduled once all the grad nodes
+ * that send grads to it have run, that is when its in-degree drops to zero,
+ * so the independent branches of a graph run at the same time.
+ *
+ * **/
+namespace {
+
+// Whether the current thread is a worker of the parallel backward, a
+// backward issued by a hook on a worker runs serially instead of waiting
+// for the pool it is running on.
+thread_local bool is_parallel_backward_worker = false;
+
+// The pools are kept once created, a backward running on the pool of the
+// previous thread num is not affected by a change of the flag.
+paddle::framework::WorkQueue* GetBackwardWorkQueue(int thread_num) {
+  static std::mutex mutex;
+  static std::unordered_map<int, std::unique_ptr<paddle::framework::WorkQueue>>
+      work_queues;
+  std::lock_guard<std::mutex> guard(mutex);
+  auto& work_queue = work_queues[thread_num];
+  if (!work_queue) {
+    paddle::framework::WorkQueueOptions options(
+        "EagerBackward",
+        thread_num,
+        /*allow_spinning=*/true,
+        /*track_task=*/false);
+    work_queue = paddle::framework::CreateMultiThreadedWorkQueue(options);
+  }
+  return work_queue.get();
+}
+
+// A grad sent to a grad node through the edge (producer_slot,
+// producer_rank) of the producer.
+struct PendingGrad {
+  size_t producer_order;
+  size_t producer_slot;
+  size_t producer_rank;
+  size_t slot;
+  size_t rank;
+  paddle::experimental::Tensor grad;
+
+  bool operator<(const PendingGrad& other) const {
+    return std::tie(producer_order, producer_slot, producer_rank) <
+           std::tie(other.producer_order,
+                    other.producer_slot,
+                    other.producer_rank);
+  }
+};
+
+struct GradNodeState {
+  // Guards in_degree, buffer and pending while the producers are running.
+  std::mutex mutex;
+  int in_degree{0};
+  // The position of the node in the breadth first traversal from the
+  // startup nodes, which orders the pending grads.
+  size_t order{0};
+  std::unique_ptr<GradTensorHolder> buffer;
+  std::vector<PendingGrad> pending;
+};
+
+class ParallelBackward {
+ public:
+  ParallelBackward(bool retain_graph, bool deterministic)
+      : retain_graph_(retain_graph),
+        deterministic_(deterministic),
+        has_grad_(Controller::Instance().HasGrad()),
+        amp_level_(Controller::Instance().GetAMPLevel()),
+        amp_dtype_(Controller::Instance().GetAMPDtype()) {}
+
+  void Run(const std::deque<GradNodeBase*>& startup_nodes,
+           std::unordered_map<GradNodeBase*, std::unique_ptr<GradTensorHolder>>*
+               node_input_buffers_dict,
+           const std::unordered_map<GradNodeBase*, int>& node_in_degree_map,
+           int thread_num) {
+    work_queue_ = GetBackwardWorkQueue(thread_num);
+    PrepareStates(startup_nodes, node_input_buffers_dict, node_in_degree_map);
+
+    std::vector<GradNodeBase*> ready;
+    for (GradNodeBase* node : startup_nodes) {
+      GradNodeState* state = states_.at(node).get();
+      if (state->in_degree == 0 &&
+          std::find(ready.begin(), ready.end(), node) == ready.end()) {
+        ready.push_back(node);
+      }
+    }
+    for (GradNodeBase* node : ready) {
+      Schedule(node);
+    }
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    cv_.wait(lock, [this] { return running_ == 0; });
+    if (error_) {
+      std::rethrow_exception(error_);
+    }
+  }
+
+ private:
+  void PrepareStates(
+      const std::deque<GradNodeBase*>& startup_nodes,
+      std::unordered_map<GradNodeBase*, std::unique_ptr<GradTensorHolder>>*
+          node_input_buffers_dict,
+      const std::unordered_map<GradNodeBase*, int>& node_in_degree_map) {
+    std::deque<GradNodeBase*> queue = startup_nodes;
+    while (!queue.empty()) {
+      GradNodeBase* node = queue.front();
+      queue.pop_front();
+      if (states_.count(node)) {
+        continue;
+      }
+      auto state = std::make_unique<GradNodeState>();
+      state->order = states_.size();
+      auto in_degree_iter = node_in_degree_map.find(node);
+      if (in_degree_iter != node_in_degree_map.end()) {
+        state->in_degree = in_degree_iter->second;
+      }
+      auto buffer_iter = node_input_buffers_dict->find(node);
+      if (buffer_iter != node_input_buffers_dict->end()) {
+        state->buffer = std::move(buffer_iter->second);
+      } else {
+        state->buffer = std::make_unique<GradTensorHolder>(node->InputMeta());
+      }
+      states_[node] = std::move(state);
+
+      for (const auto& meta_list : node->OutputMeta()) {
+        for (const GradSlotMeta& meta : meta_list) {
+          GradNodeBase* next_node = meta.GetEdge().GetMutableGradNode().get();
+          if (next_node) queue.push_back(next_node);
+        }
+      }
+    }
+    node_input_buffers_dict->clear();
+  }
+
+  void Schedule(GradNodeBase* node) {
+    {
+      std::lock_guard<std::mutex> guard(mutex_);
+      running_++;
+    }
+    work_queue_->AddTask([this, node] { RunTask(node); });
+  }
+
+  void RunTask(GradNodeBase* node) {
+    is_parallel_backward_worker = true;
+    Controller::Instance().SetHasGrad(has_grad_);
+    Controller::Instance().SetAMPLevel(amp_level_);
+    Controller::Instance().SetAMPDtype(amp_dtype_);
+    // Run one of the ready next nodes on this thread and leave the others to
+    // the pool, which keeps a chain of grad nodes on the same thread.
+    std::vector<GradNodeBase*> ready;
+    while (node && !failed_.load()) {
+      try {
+        RunNode(node, &ready);
+      } catch (...) {
+        std::lock_guard<std::mutex> guard(mutex_);
+        if (!error_) error_ = std::current_exception();
+        failed_.store(true);
+        break;
+      }
+      node = nullptr;
+      for (GradNodeBase* next_node : ready) {
+        if (!node) {
+          node = next_node;
+        } else {
+          Schedule(next_node);
+        }
+      }
+      ready.clear();
+    }
+    is_parallel_backward_worker = false;
+
+    std::lock_guard<std::mutex> guard(mutex_);
+    if (--running_ == 0) {
+      cv_.notify_all();
+    }
+  }
+
+  void RunNode(GradNodeBase* node, std::vector<GradNodeBase*>* ready) {
+    VLOG(6) << "Running GradNode:" << node->name();
+    paddle::platform::RecordEvent node_record_event(
+        std::string((*node).name()),
+        paddle::platform::TracerEventType::Operator,
+        1);
+
+    // All the producers of the node have run, no one else touches its state
+    GradNodeState* state = states_.at(node).get();
+    std::unique_ptr<GradTensorHolder> node_input_buffer =
+        std::move(state->buffer);
+    std::vector<PendingGrad> pending = std::move(state->pending);
+    std::sort(pending.begin(), pending.end());
+    for (const PendingGrad& pending_grad : pending) {
+      node_input_buffer->add(pending_grad.slot,
+                             pending_grad.rank,
+                             pending_grad.grad,
+                             /*create_graph=*/false);
+    }
+    pending.clear();
+
+    EnforceGradNodeHasInput(node);
+
+    paddle::small_vector<std::vector<paddle::experimental::Tensor>,
+                         kSlotSmallVectorSize>
+        grad_output_tensors =
+            (*node)(node_input_buffer->Buffers(), false, false);
+
+    if (!retain_graph_) {
+      node->ClearTensorWrappers();
+    }
+    node_input_buffer.reset();
+
+    const paddle::small_vector<std::vector<GradSlotMeta>, kSlotSmallVectorSize>&
+        metas = node->OutputMeta();
+    PADDLE_ENFORCE(metas.size() == grad_output_tensors.size() || metas.empty(),
+                   paddle::platform::errors::Fatal(
+                       "Number of edges should be either empty ( for leaf node "
+                       ") or the same as number of output grad tensors, but we "
+                       "got edges size is: %d, grad_output size is: %d",
+                       metas.size(),
+                       grad_output_tensors.size()));
+
+    for (size_t i = 0; i < metas.size(); i++) {
+      for (size_t j = 0; j < metas[i].size(); j++) {
+        const Edge& edge = metas[i][j].GetEdge();
+        if (!edge.IsInitialized()) {
+          continue;
+        }
+        auto edge_rank = edge.GetEdgeRankInfo();
+        GradNodeBase* next_node = edge.GetMutableGradNode().get();
+        if (!next_node || grad_output_tensors[i].empty()) {
+          continue;
+        }
+        PADDLE_ENFORCE_LT(
+            j,
+            grad_output_tensors[i].size(),
+            paddle::platform::errors::Fatal(
+                "Rank of grad_output_tensors should be less than "
+                "grad_output_tensors[i].size(), which is: %d. This error may "
+                "indicate autoprune or autograd api error. ",
+                grad_output_tensors.size()));
+        paddle::experimental::Tensor& grad_output_tensor =
+            grad_output_tensors[i][j];
+
+        GradNodeState* next_state = states_.at(next_node).get();
+        std::lock_guard<std::mutex> guard(next_state->mutex);
+        if (deterministic_) {
+          next_state->pending.push_back(PendingGrad{state->order,
+                                                    i,
+                                                    j,
+                                                    edge_rank.first,
+                                                    edge_rank.second,
+                                                    grad_output_tensor});
+        } else {
+          next_state->buffer->add(edge_rank.first,
+                                  edge_rank.second,
+                                  grad_output_tensor,
+                                  /*create_graph=*/false);
+        }
+        next_state->in_degree--;
+        PADDLE_ENFORCE(
+            next_state->in_degree >= 0,
+            paddle::platform::errors::Fatal(
+                "Detected in-degree value smaller than zero. For Node: %s"
+                "Node's in-degree cannot be negative.",
+                next_node->name()));
+        if (next_state->in_degree == 0) {
+          // Run the accumulation nodes first as the serial backward does
+          if (dynamic_cast<egr::GradNodeAccumulation*>(next_node)) {
+            ready->insert(ready->begin(), next_node);
+          } else {
+            ready->push_back(next_node);
+          }
+        }
+      }
+    }
+  }
+
+  bool retain_graph_;
+  bool deterministic_;
+  bool has_grad_;
+  paddle::imperative::AmpLevel amp_level_;
+  std::string amp_dtype_;
+  paddle::framework::WorkQueue* work_queue_{nullptr};
+  // Built before the first task starts and only read by the tasks.
+  std::unordered_map<GradNodeBase*, std::unique_ptr<GradNodeState>> states_;
+
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  int64_t running_{0};
+  std::exception_ptr error_;
+  std::atomic<bool> failed_{false};
+};
+
+// The parallel backward only covers the plain backward of CPU tensors, the
+// kernels of the other places are queued on one stream by the device
+// context and gain little from more host threads.
+bool UseParallelBackward(
+    const std::vector<paddle::experimental::Tensor>& tensors,
+    bool create_graph,
+    bool is_general_grad) {
+  if (FLAGS_eager_backward_thread_num <= 1 || create_graph || is_general_grad ||
+      is_parallel_backward_worker) {
+    return false;
+  }
+  for (const auto& tensor : tensors) {
+    if (tensor.defined() && !tensor.is_cpu()) {
+      return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace
+
 std::vector<paddle::experimental::Tensor> RunBackward(
     const std::vector<paddle::experimental::Tensor>& tensors,  // output
     const std::vector<paddle::experimental::Tensor>& grad_tensors,
@@ -675,6 +1012,18 @@ std::vector<paddle::experimental::Tensor> RunBackward(
 
   VLOG(6) << " startup_ops' size is :" << queue.size();
 
+  if (UseParallelBackward(tensors, create_graph, is_general_grad)) {
+    VLOG(3) << "Run Backward with " << FLAGS_eager_backward_thread_num
+            << " threads";
+    ParallelBackward parallel_backward(retain_graph,
+                                       FLAGS_eager_backward_deterministic);
+    parallel_backward.Run(queue,
+                          &node_input_buffers_dict,
+                          node_in_degree_map,
+                          FLAGS_eager_backward_thread_num);
+    return {};
+  }
+
   /* --- Topological Visit --- */
   // 1. Pop queue
   // 2. Run node
@@ -41,6 +41,8 @@ PD_DECLARE_KERNEL(add_grad, CPU, ALL_LAYOUT);
 PD_DECLARE_KERNEL(sum, CPU, ALL_LAYOUT);
 PD_DECLARE_KERNEL(sum_grad, CPU, ALL_LAYOUT);
 
+DECLARE_int32(eager_backward_thread_num);
+
 using namespace egr;            // NOLINT
 using namespace egr_utils_api;  // NOLINT
 
@@ -254,6 +256,74 @@ TEST(Benchmark, EagerIntermediateMLPCPU) {
   }
 }
 
+TEST(Benchmark, EagerMultiTowerMLPCPU) {
+  // Prepare Device Contexts
+  eager_test::InitEnv(paddle::platform::CPUPlace());
+
+  auto tracer = std::make_shared<paddle::imperative::Tracer>();
+  paddle::imperative::SetCurrentTracer(tracer);
+
+  // The towers are independent until the accumulation of X, so the backward
+  // runs them in parallel with more than one thread
+  for (int thread_num : {0, 2, 4, 8}) {
+    FLAGS_eager_backward_thread_num = thread_num;
+    for (const std::string& mode : {"Accuracy", "Performance"}) {
+      paddle::framework::DDim ddimX =
+          phi::make_ddim({MULTI_TOWER_M, MULTI_TOWER_N});
+      paddle::experimental::Tensor X =
+          CreateTensorWithValue(ddimX,
+                                paddle::platform::CPUPlace(),
+                                phi::DataType::FLOAT32,
+                                phi::DataLayout::NCHW,
+                                MLP_X_VAL,
+                                true);
+      RetainGradForTensor(X);
+
+      std::vector<paddle::experimental::Tensor> Ws;
+      std::vector<paddle::experimental::Tensor> Bs;
+      for (size_t i = 0; i < MULTI_TOWER_NUM * MULTI_TOWER_NUM_LINEAR; i++) {
+        paddle::framework::DDim ddimW =
+            phi::make_ddim({MULTI_TOWER_N, MULTI_TOWER_N});
+        paddle::experimental::Tensor W =
+            CreateTensorWithValue(ddimW,
+                                  paddle::platform::CPUPlace(),
+                                  phi::DataType::FLOAT32,
+                                  phi::DataLayout::NCHW,
+                                  MLP_W_VAL,
+                                  true);
+        RetainGradForTensor(W);
+
+        paddle::framework::DDim ddimB = phi::make_ddim({MULTI_TOWER_N});
+        paddle::experimental::Tensor B =
+            CreateTensorWithValue(ddimB,
+                                  paddle::platform::CPUPlace(),
+                                  phi::DataType::FLOAT32,
+                                  phi::DataLayout::NCHW,
+                                  MLP_B_VAL,
+                                  true);
+        RetainGradForTensor(B);
+
+        Ws.emplace_back(std::move(W));
+        Bs.emplace_back(std::move(B));
+      }
+
+      if (mode == "Accuracy") {
+        benchmark_eager_multi_tower_mlp(X, Ws, Bs, true /* accuracy_check */);
+
+      } else if (mode == "Performance") {
+        double elapsed_time_ms = benchmark_eager_multi_tower_mlp(X, Ws, Bs);
+        std::cout << "Backward threads: " << thread_num
+                  << ", Duration: " << elapsed_time_ms << " ms" << std::endl;
+
+      } else {
+        PADDLE_THROW(
+            paddle::platform::errors::Fatal("Unknown benchmark mode"));
+      }
+    }
+  }
+  FLAGS_eager_backward_thread_num = 0;
+}
+
 USE_OP_ITSELF(scale);
 USE_OP_ITSELF(elementwise_add);
 USE_OP_ITSELF(matmul_v2);
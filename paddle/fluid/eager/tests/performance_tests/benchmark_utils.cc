@@ -14,6 +14,7 @@
 
 #include "paddle/fluid/eager/tests/performance_tests/benchmark_utils.h"
 
+#include <chrono>
 #include <iostream>
 #include <memory>
 #include <set>
@@ -155,6 +156,42 @@ void benchmark_eager_intermediate_mlp(
   }
 }
 
+double benchmark_eager_multi_tower_mlp(
+    const paddle::experimental::Tensor& X,
+    const std::vector<paddle::experimental::Tensor>& Ws,
+    const std::vector<paddle::experimental::Tensor>& Bs,
+    bool accuracy_check) {
+  std::vector<paddle::experimental::Tensor> target_tensors;
+  for (size_t t = 0; t < MULTI_TOWER_NUM; t++) {
+    paddle::experimental::Tensor input0 = X;
+    for (size_t i = 0; i < MULTI_TOWER_NUM_LINEAR; i++) {
+      size_t index = t * MULTI_TOWER_NUM_LINEAR + i;
+      paddle::experimental::Tensor Out = matmul_v2_dygraph_function(
+          input0, Ws[index], {{"trans_x", false}, {"trans_y", false}});
+
+      input0 = elementwise_add_dygraph_function(Out, Bs[index], {});
+    }
+    target_tensors.emplace_back(
+        reduce_sum_dygraph_function(input0, {{"reduce_all", true}}));
+  }
+
+  auto t_start = std::chrono::high_resolution_clock::now();
+  Backward(target_tensors, {});
+  auto t_end = std::chrono::high_resolution_clock::now();
+
+  if (accuracy_check) {
+    std::unordered_map<std::string, float> result =
+        compute_multi_tower_expected_results();
+
+    eager_test::CompareGradTensorWithValue<float>(X, result["GradX"]);
+    for (size_t t = 0; t < MULTI_TOWER_NUM; t++) {
+      eager_test::CompareGradTensorWithValue<float>(
+          Ws[t * MULTI_TOWER_NUM_LINEAR], result["GradW"]);
+    }
+  }
+  return std::chrono::duration<double, std::milli>(t_end - t_start).count();
+}
+
 }  // namespace egr
 
 namespace paddle {
@@ -32,6 +32,14 @@
 #define MLP_B_VAL 3.0
 #define MLP_NUM_LINEAR 1000
 
+/* Multi-Tower MLP Configurations */
+// Out_t = ReduceSum(MLP_t(X)) for t in [0, MULTI_TOWER_NUM)
+// every MLP_t has MULTI_TOWER_NUM_LINEAR linears of W[N, N] + B[N]
+#define MULTI_TOWER_M 128
+#define MULTI_TOWER_N 128
+#define MULTI_TOWER_NUM 8
+#define MULTI_TOWER_NUM_LINEAR 4
+
 namespace egr {
 
 inline std::unordered_map<std::string, float> compute_mlp_expected_results() {
@@ -47,6 +55,16 @@ inline std::unordered_map<std::string, float> compute_mlp_expected_results() {
   return {{"Out", Out}, {"GradX", GradX}, {"GradW", GradW0}};
 }
 
+inline std::unordered_map<std::string, float>
+compute_multi_tower_expected_results() {
+  float GradX = MULTI_TOWER_NUM * MLP_X_VAL *
+                pow((MLP_W_VAL * MULTI_TOWER_N), MULTI_TOWER_NUM_LINEAR);
+  float GradW0 =
+      1.0 * pow((MLP_W_VAL * MULTI_TOWER_N), (MULTI_TOWER_NUM_LINEAR - 1)) *
+      MLP_X_VAL * MULTI_TOWER_M;
+  return {{"GradX", GradX}, {"GradW", GradW0}};
+}
+
 /* ---- Eager Scale ---- */
 void benchmark_eager_scale(const paddle::experimental::Tensor& tensor,
                            bool accuracy_check = false);
@@ -66,6 +84,13 @@ void benchmark_eager_intermediate_mlp(
     const std::vector<paddle::experimental::Tensor>& Bs,
     bool accuracy_check = false);
 
+// Returns the duration of the backward in ms
+double benchmark_eager_multi_tower_mlp(
+    const paddle::experimental::Tensor& X,
+    const std::vector<paddle::experimental::Tensor>& Ws,
+    const std::vector<paddle::experimental::Tensor>& Bs,
+    bool accuracy_check = false);
+
 }  // namespace egr
 
 namespace paddle {
@@ -14,17 +14,22 @@
 
 #include "paddle/fluid/eager/backward.h"
 
+#include <atomic>
 #include <sstream>
+#include <string>
 
+#include "gflags/gflags.h"
 #include "glog/logging.h"
 #include "gtest/gtest.h"
 #include "paddle/fluid/eager/accumulation/accumulation_node.h"
 #include "paddle/fluid/eager/api/all.h"
 #include "paddle/fluid/eager/api/generated/eager_generated/backwards/scale_node.h"
+#include "paddle/fluid/eager/api/utils/global_utils.h"
 #include "paddle/fluid/eager/api/utils/tensor_utils.h"
 #include "paddle/fluid/eager/autograd_meta.h"
 #include "paddle/fluid/eager/grad_node_info.h"
 #include "paddle/fluid/eager/tests/test_utils.h"
+#include "paddle/fluid/imperative/amp_auto_cast.h"
 #include "paddle/phi/core/dense_tensor.h"
 #include "paddle/phi/core/kernel_registry.h"
 #include "paddle/phi/core/tensor_meta.h"
@@ -32,6 +37,9 @@
 PD_DECLARE_KERNEL(full, CPU, ALL_LAYOUT);
 PD_DECLARE_KERNEL(add, CPU, ALL_LAYOUT);
 
+DECLARE_int32(eager_backward_thread_num);
+DECLARE_bool(eager_backward_deterministic);
+
 namespace egr {
 
 TEST(Backward, SingleNodeEmptyGrad) {
@@ -343,4 +351,151 @@ TEST(Backward, WithAccumulation) {
   eager_test::CompareGradTensorWithValue<float>(leaf_tensor, 2500.0);
 }
 
+/*
+              NodeSum
+      |        |        |
+  NodeB_0  NodeB_1 ... NodeB_n
+      |        |        |
+  NodeA_0  NodeA_1 ... NodeA_n
+      |        |        |
+    inp0     inp1  ... inpn
+*/
+// A scale node that counts the runs seeing another amp state than the one
+// of the caller of Backward.
+class GradNodeAmpCheck : public GradNodeScale {
+ public:
+  GradNodeAmpCheck(size_t bwd_in_slot_num, size_t bwd_out_slot_num)
+      : GradNodeScale(bwd_in_slot_num, bwd_out_slot_num),
+        amp_level_(Controller::Instance().GetAMPLevel()),
+        amp_dtype_(Controller::Instance().GetAMPDtype()) {}
+
+  paddle::small_vector<std::vector<paddle::experimental::Tensor>,
+                       kSlotSmallVectorSize>
+  operator()(paddle::small_vector<std::vector<paddle::experimental::Tensor>,
+                                  kSlotSmallVectorSize>& grads,  // NOLINT
+             bool create_graph = false,
+             bool is_new_grad = false) override {
+    if (Controller::Instance().GetAMPLevel() != amp_level_ ||
+        Controller::Instance().GetAMPDtype() != amp_dtype_) {
+      mismatch_num++;
+    }
+    return GradNodeScale::operator()(grads, create_graph, is_new_grad);
+  }
+
+  static std::atomic<int> mismatch_num;
+
+ private:
+  paddle::imperative::AmpLevel amp_level_;
+  std::string amp_dtype_;
+};
+
+std::atomic<int> GradNodeAmpCheck::mismatch_num{0};
+
+static paddle::experimental::Tensor RunMultiBranchBackward(size_t branch_num) {
+  paddle::framework::DDim ddim = phi::make_ddim({4, 16, 16, 32});
+
+  std::vector<paddle::experimental::Tensor> target_tensors;
+  for (size_t i = 0; i < branch_num; i++) {
+    target_tensors.emplace_back(
+        egr_utils_api::CreateTensorWithValue(ddim,
+                                             paddle::platform::CPUPlace(),
+                                             phi::DataType::FLOAT32,
+                                             phi::DataLayout::NCHW,
+                                             1.0 /*value*/,
+                                             false /*is_leaf*/));
+  }
+
+  paddle::experimental::Tensor leaf_tensor;
+  {
+    auto node_sum_ptr = std::make_shared<GradNodeScale>(1, 1);
+    node_sum_ptr->SetAttributes_scale(3.0 /*scale*/);
+    node_sum_ptr->SetDefaultGradInOutMeta();
+
+    for (size_t i = 0; i < branch_num; i++) {
+      auto node_a_ptr = std::make_shared<GradNodeScale>(1, 1);
+      node_a_ptr->SetAttributes_scale(i + 1.0 /*scale*/);
+      node_a_ptr->SetDefaultGradInOutMeta();
+      auto node_b_ptr = std::make_shared<GradNodeAmpCheck>(1, 1);
+      node_b_ptr->SetAttributes_scale(2.0 /*scale*/);
+      node_b_ptr->SetDefaultGradInOutMeta();
+
+      // Connect Inp_i and NodeA_i via AutoGradMeta
+      AutogradMeta* auto_grad_meta =
+          EagerUtils::autograd_meta(&(target_tensors[i]));
+      auto_grad_meta->SetGradNode(
+          std::dynamic_pointer_cast<GradNodeBase>(node_a_ptr));
+      auto_grad_meta->SetSingleOutRankWithSlot(0, 0);
+      auto_grad_meta->SetStopGradient(false);
+
+      // Connect NodeA_i -> NodeB_i via Edge
+      auto tmp_tensor_a = paddle::experimental::Tensor();
+      auto* meta_a = EagerUtils::autograd_meta(&tmp_tensor_a);
+      meta_a->SetStopGradient(false);
+      meta_a->SetSingleOutRankWithSlot(0, 0);
+      meta_a->SetGradNode(node_b_ptr);
+      node_a_ptr->SetGradOutMeta(tmp_tensor_a, 0);
+
+      // Connect NodeB_i -> NodeSum via Edge
+      auto tmp_tensor_b = paddle::experimental::Tensor();
+      auto* meta_b = EagerUtils::autograd_meta(&tmp_tensor_b);
+      meta_b->SetStopGradient(false);
+      meta_b->SetSingleOutRankWithSlot(0, 0);
+      meta_b->SetGradNode(node_sum_ptr);
+      node_b_ptr->SetGradOutMeta(tmp_tensor_b, 0);
+    }
+
+    // Connect NodeSum and AccumulationNode via AutoGradMeta
+    AutogradMeta* auto_grad_meta_leaf =
+        EagerUtils::autograd_meta(&leaf_tensor);
+    auto acc_node_ptr =
+        std::make_shared<egr::GradNodeAccumulation>(auto_grad_meta_leaf);
+    auto_grad_meta_leaf->SetGradNode(
+        std::dynamic_pointer_cast<GradNodeBase>(acc_node_ptr));
+    auto_grad_meta_leaf->SetSingleOutRankWithSlot(0, 0);
+    auto_grad_meta_leaf->SetStopGradient(false);
+    node_sum_ptr->SetGradOutMeta(leaf_tensor, 0);
+  }
+
+  Backward(target_tensors, {});
+  return leaf_tensor;
+}
+
+TEST(Backward, ParallelMultiBranch) {
+  // Prepare Device Contexts
+  eager_test::InitEnv(paddle::platform::CPUPlace());
+
+  // sum((i + 1) * 2 * 3) of 16 branches
+  const float expected = 816.0;
+  eager_test::CompareGradTensorWithValue<float>(RunMultiBranchBackward(16),
+                                                expected);
+
+  FLAGS_eager_backward_thread_num = 4;
+  for (bool deterministic : {true, false}) {
+    FLAGS_eager_backward_deterministic = deterministic;
+    for (int repeat = 0; repeat < 10; repeat++) {
+      eager_test::CompareGradTensorWithValue<float>(RunMultiBranchBackward(16),
+                                                    expected);
+    }
+  }
+  FLAGS_eager_backward_deterministic = true;
+  FLAGS_eager_backward_thread_num = 0;
+}
+
+TEST(Backward, ParallelAmpState) {
+  eager_test::InitEnv(paddle::platform::CPUPlace());
+
+  // The workers run the grad nodes with the amp state of the caller.
+  Controller::Instance().SetAMPLevel(paddle::imperative::AmpLevel::O1);
+  Controller::Instance().SetAMPDtype("bfloat16");
+  FLAGS_eager_backward_thread_num = 4;
+  GradNodeAmpCheck::mismatch_num = 0;
+  eager_test::CompareGradTensorWithValue<float>(RunMultiBranchBackward(16),
+                                                816.0);
+  ASSERT_EQ(GradNodeAmpCheck::mismatch_num, 0);
+
+  FLAGS_eager_backward_thread_num = 0;
+  Controller::Instance().SetAMPLevel(paddle::imperative::AmpLevel::O0);
+  Controller::Instance().SetAMPDtype("float32");
+}
+
 }  // namespace egr
@@ -22,6 +22,7 @@
 #include <glog/logging.h>
 
 #include <algorithm>
+#include <atomic>
 #include <condition_variable>  // NOLINT
 #include <deque>
 #include <limits>
@@ -45,11 +46,32 @@ class ChannelObject {
     capacity_ = (std::min)(MaxCapacity(), capacity);
   }
 
-  const std::deque<T>& GetData() const { return data_; }
+  // only valid when the channel is not sharded
+  const std::deque<T>& GetData() const {
+    CHECK(shards_.empty()) << "GetData() is not supported by sharded channel";
+    return data_;
+  }
+  // the data of shard i in [0, ShardNum()), the same as GetData() when the
+  // channel is not sharded. Only valid when no thread reads or writes.
+  const std::deque<T>& GetShardData(size_t i) const {
+    if (shards_.empty()) {
+      CHECK(i == 0) << "shard index out of range";
+      return data_;
+    }
+    CHECK(i < shards_.size()) << "shard index out of range";
+    return shards_[i]->data;
+  }
   void Clear() {
     std::unique_lock<std::mutex> lock(mutex_);
     data_.clear();
     data_.shrink_to_fit();
+    for (auto& shard : shards_) {
+      std::lock_guard<std::mutex> shard_lock(shard->mutex);
+      shard_size_ -= shard->data.size();
+      shard_occupied_ -= shard->data.size();
+      shard->data.clear();
+      shard->data.shrink_to_fit();
+    }
   }
 
   size_t Capacity() {
@@ -72,11 +94,36 @@ class ChannelObject {
     block_size_ = x;
   }
 
+  size_t ShardNum() {
+    return shards_.empty() ? 1 : shards_.size();  // set before use
+  }
+
+  // Split the buffered data into x shards, each of them is guarded by its own
+  // lock, so that the readers and writers of a channel shared by many threads
+  // seldom contend with each other. Every thread writes to and reads from its
+  // own shard first, a reader steals from the other shards when its shard is
+  // empty. The blocking, capacity and close semantics are kept, but the data
+  // order is only kept within a shard. The channel should be empty and not in
+  // use by other threads when calling it, x <= 1 disables sharding.
+  void SetShardNum(size_t x) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    CHECK(data_.empty() && shard_size_ == 0)
+        << "channel must be empty when setting shard num";
+    CHECK(x <= 1 || capacity_ > 0) << "sharded channel capacity must be > 0";
+    shards_.clear();
+    if (x > 1) {
+      shards_.reserve(x);
+      for (size_t i = 0; i < x; ++i) {
+        shards_.emplace_back(new Shard());
+      }
+    }
+  }
+
   template <class U>
   void InheritFrom(const std::shared_ptr<ChannelObject<U>>& other) {
-    std::lock_guard<std::mutex> lock(mutex_);
     capacity_ = other->Capacity();
     block_size_ = other->BlockSize();
+    SetShardNum(other->ShardNum());
   }
 
   bool Closed() {
@@ -98,11 +145,17 @@ class ChannelObject {
   }
 
   size_t Size() {
+    if (!shards_.empty()) {
+      return shard_size_;
+    }
     std::lock_guard<std::mutex> lock(mutex_);
     return data_.size();
   }
 
   bool Empty() {
+    if (!shards_.empty()) {
+      return shard_size_ == 0;
+    }
     std::lock_guard<std::mutex> lock(mutex_);
     return EmptyUnlocked();
   }
@@ -116,6 +169,9 @@ class ChannelObject {
     if (n == 0) {
       return 0;
     }
+    if (!shards_.empty()) {
+      return ShardedRead(n, p, false);
+    }
 
     std::unique_lock<std::mutex> lock(mutex_);
     size_t finished = Read(n, p, lock);
@@ -135,6 +191,9 @@ class ChannelObject {
     if (n == 0) {
       return 0;
     }
+    if (!shards_.empty()) {
+      return ShardedWrite(n, p);
+    }
     std::unique_lock<std::mutex> lock(mutex_);
     size_t finished = Write(n, p, lock);
     Notify();
@@ -146,6 +205,9 @@ class ChannelObject {
     if (n == 0) {
       return 0;
     }
+    if (!shards_.empty()) {
+      return ShardedWrite(n, p);
+    }
     std::unique_lock<std::mutex> lock(mutex_);
     size_t finished = WriteMove(n, p, lock);
     Notify();
@@ -164,6 +226,12 @@ class ChannelObject {
     if (size == 0) {
       return 0;
     }
+    if (!shards_.empty()) {
+      p.resize(size);
+      size_t finished = ShardedRead(size, &p[0], true);
+      p.resize(finished);
+      return finished;
+    }
     std::unique_lock<std::mutex> lock(mutex_);
     p.resize(size);
     size_t finished = Read(size, &p[0], lock, true);
@@ -194,9 +262,14 @@ class ChannelObject {
   size_t Write(std::vector<T>&& p) { return WriteMove(p.size(), &p[0]); }
 
  private:
-  size_t capacity_ = MaxCapacity();
-  size_t block_size_ = 1024;
-  bool closed_ = false;
+  struct Shard {
+    std::mutex mutex;
+    std::deque<T> data;
+  };
+
+  std::atomic<size_t> capacity_{MaxCapacity()};
+  std::atomic<size_t> block_size_{1024};
+  std::atomic<bool> closed_{false};
   std::mutex mutex_;
   // use deque to store data
   std::deque<T> data_;
@@ -205,12 +278,25 @@ class ChannelObject {
   int full_waiters_ = 0;
   std::condition_variable empty_cond_;
   std::condition_variable full_cond_;
+  // sharded mode: shard_size_ counts the data visible to readers, and
+  // shard_occupied_ counts the data reserved by writers against capacity.
+  // mutex_ and the conditions are only used to sleep on empty/full.
+  std::vector<std::unique_ptr<Shard>> shards_;
+  std::atomic<size_t> shard_size_{0};
+  std::atomic<size_t> shard_occupied_{0};
+  std::atomic<int> shard_empty_waiters_{0};
+  std::atomic<int> shard_full_waiters_{0};
 
   static constexpr size_t MaxCapacity() {
     return (std::numeric_limits<size_t>::max)() / 2;
   }
 
   void Notify() {
+    if (!shards_.empty()) {
+      empty_cond_.notify_all();
+      full_cond_.notify_all();
+      return;
+    }
     if (empty_waiters_ != 0 && (!EmptyUnlocked() || closed_)) {
       empty_cond_.notify_one();
     }
@@ -304,6 +390,123 @@ class ChannelObject {
     }
     return finished;
   }
+
+  static size_t ThreadShardSeed() {
+    static std::atomic<size_t> thread_count{0};
+    thread_local size_t seed = thread_count++;
+    return seed;
+  }
+
+  static const T& TakeItem(const T& val) { return val; }
+  static T&& TakeItem(T& val) { return std::move(val); }  // NOLINT
+
+  // reserve at most n slots against capacity, blocks if the channel is full,
+  // returns 0 if the channel is closed
+  size_t ReserveForWrite(size_t n) {
+    size_t occupied = shard_occupied_;
+    while (!closed_) {
+      size_t capacity = capacity_;
+      if (occupied < capacity) {
+        size_t m = (std::min)(n, capacity - occupied);
+        if (shard_occupied_.compare_exchange_weak(occupied, occupied + m)) {
+          return m;
+        }
+        continue;
+      }
+      std::unique_lock<std::mutex> lock(mutex_);
+      shard_full_waiters_++;
+      while (shard_occupied_ >= capacity_ && !closed_) {
+        full_cond_.wait(lock);
+      }
+      shard_full_waiters_--;
+      occupied = shard_occupied_;
+    }
+    return 0;
+  }
+
+  // claim at most n written data, returns 0 if there is no data
+  size_t ClaimForRead(size_t n) {
+    size_t size = shard_size_;
+    while (size > 0) {
+      size_t m = (std::min)(n, size);
+      if (shard_size_.compare_exchange_weak(size, size - m)) {
+        return m;
+      }
+    }
+    return 0;
+  }
+
+  template <class Ptr>
+  size_t ShardedWrite(size_t n, Ptr p) {
+    size_t finished = 0;
+    Shard* shard = shards_[ThreadShardSeed() % shards_.size()].get();
+    while (finished < n) {
+      size_t m = ReserveForWrite(n - finished);
+      if (m == 0) {
+        break;
+      }
+      {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        for (size_t i = 0; i < m; ++i) {
+          shard->data.push_back(TakeItem(p[finished++]));
+        }
+      }
+      // publish after the data is in the shard, so that the claimed data of
+      // readers always exist in some shard
+      shard_size_ += m;
+      if (shard_empty_waiters_ != 0) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        empty_cond_.notify_all();
+      }
+    }
+    return finished;
+  }
+
+  size_t ShardedRead(size_t n, T* p, bool once) {
+    size_t finished = 0;
+    size_t shard_id = ThreadShardSeed();
+    while (finished < n) {
+      size_t m = ClaimForRead(n - finished);
+      if (m == 0) {
+        if (once && finished > 0) {
+          break;
+        }
+        std::unique_lock<std::mutex> lock(mutex_);
+        shard_empty_waiters_++;
+        while (shard_size_ == 0 && !closed_) {
+          empty_cond_.wait(lock);
+        }
+        shard_empty_waiters_--;
+        if (shard_size_ == 0 && closed_) {
+          break;
+        }
+        continue;
+      }
+      // steal from the other shards when the own shard has not enough data
+      for (size_t got = 0; got < m; ++shard_id) {
+        Shard* shard = shards_[shard_id % shards_.size()].get();
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        size_t k = (std::min)(m - got, shard->data.size());
+        for (size_t i = 0; i < k; ++i) {
+          p[finished++] = std::move(shard->data.front());
+          shard->data.pop_front();
+        }
+        got += k;
+        if (got == m) {
+          break;
+        }
+      }
+      shard_occupied_ -= m;
+      if (shard_full_waiters_ != 0) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        full_cond_.notify_all();
+      }
+      if (once) {
+        break;
+      }
+    }
+    return finished;
+  }
 };  // NOLINT
 
 template <class T>
@@ -0,0 +1,104 @@
+// Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Sweep the producer and consumer num of a ChannelObject, and compare the
+// throughput of the single lock channel with the sharded channel, e.g.
+//   channel_benchmark --max_threads=64 --batch=16 --shard_num=0
+
+#include <thread>  // NOLINT
+
+#include "gflags/gflags.h"
+#include "glog/logging.h"
+#include "paddle/fluid/framework/channel.h"
+#include "paddle/fluid/platform/timer.h"
+
+DEFINE_int32(max_threads, 32, "The max producer/consumer num to sweep.");
+DEFINE_int32(items_per_producer, 1000000, "The items written per producer.");
+DEFINE_int32(batch, 16, "The item num of every Write/Read call.");
+DEFINE_int32(capacity, 0, "The capacity of channel, 0 means unlimited.");
+DEFINE_int32(shard_num,
+             0,
+             "The shard num of the sharded channel, 0 means the producer "
+             "num.");
+
+namespace paddle {
+namespace framework {
+
+static double RunOnce(size_t shard_num, int producer_num, int consumer_num) {
+  auto chan = FLAGS_capacity > 0 ? MakeChannel<uint64_t>(FLAGS_capacity)
+                                 : MakeChannel<uint64_t>();
+  chan->SetShardNum(shard_num);
+  platform::Timer timeline;
+  timeline.Start();
+  std::vector<std::thread> producers;
+  for (int i = 0; i < producer_num; ++i) {
+    producers.emplace_back([&chan]() {
+      std::vector<uint64_t> batch(FLAGS_batch);
+      for (int j = 0; j + FLAGS_batch <= FLAGS_items_per_producer;
+           j += FLAGS_batch) {
+        for (int k = 0; k < FLAGS_batch; ++k) {
+          batch[k] = j + k;
+        }
+        chan->Write(FLAGS_batch, &batch[0]);
+      }
+    });
+  }
+  std::vector<std::thread> consumers;
+  for (int i = 0; i < consumer_num; ++i) {
+    consumers.emplace_back([&chan]() {
+      std::vector<uint64_t> batch(FLAGS_batch);
+      while (chan->Read(FLAGS_batch, &batch[0]) > 0) {
+      }
+    });
+  }
+  for (auto& t : producers) {
+    t.join();
+  }
+  chan->Close();
+  for (auto& t : consumers) {
+    t.join();
+  }
+  timeline.Pause();
+  return timeline.ElapsedSec();
+}
+
+static int BenchmarkMain() {
+  for (int producer_num = 1; producer_num <= FLAGS_max_threads;
+       producer_num *= 2) {
+    for (int consumer_num = 1; consumer_num <= FLAGS_max_threads;
+         consumer_num *= 2) {
+      size_t shard_num = FLAGS_shard_num > 0 ? FLAGS_shard_num : producer_num;
+      double items = static_cast<double>(producer_num) *
+                     (FLAGS_items_per_producer / FLAGS_batch * FLAGS_batch);
+      double locked_sec = RunOnce(1, producer_num, consumer_num);
+      double sharded_sec = RunOnce(shard_num, producer_num, consumer_num);
+      LOG(INFO) << "producers " << producer_num << ", consumers "
+                << consumer_num << ", batch " << FLAGS_batch
+                << ": single lock " << items / locked_sec / 1e6
+                << " M items/s, " << shard_num << " shards "
+                << items / sharded_sec / 1e6 << " M items/s, speedup "
+                << locked_sec / sharded_sec;
+    }
+  }
+  return 0;
+}
+
+}  // namespace framework
+}  // namespace paddle
+
+int main(int argc, char* argv[]) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  google::InitGoogleLogging(argv[0]);
+  return paddle::framework::BenchmarkMain();
+}
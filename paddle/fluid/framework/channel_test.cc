@@ -0,0 +1,168 @@
+// Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/framework/channel.h"
+
+#include <gtest/gtest.h>
+
+#include <numeric>
+#include <thread>  // NOLINT
+
+namespace paddle {
+namespace framework {
+
+static void ProduceAndConsume(size_t shard_num,
+                              size_t capacity,
+                              int producer_num,
+                              int consumer_num) {
+  const int kItemsPerProducer = 20000;
+  const int kBatch = 64;
+  auto chan = MakeChannel<int64_t>(capacity);
+  chan->SetShardNum(shard_num);
+
+  std::vector<std::thread> producers;
+  for (int i = 0; i < producer_num; ++i) {
+    producers.emplace_back([&chan, i]() {
+      std::vector<int64_t> batch;
+      for (int j = 0; j < kItemsPerProducer; ++j) {
+        batch.push_back(static_cast<int64_t>(i) * kItemsPerProducer + j);
+        if (batch.size() == kBatch) {
+          EXPECT_EQ(chan->Write(std::move(batch)), size_t(kBatch));
+          batch.clear();
+        }
+      }
+      chan->Write(std::move(batch));
+    });
+  }
+  std::vector<int64_t> sums(consumer_num, 0);
+  std::vector<size_t> counts(consumer_num, 0);
+  std::vector<std::thread> consumers;
+  for (int i = 0; i < consumer_num; ++i) {
+    consumers.emplace_back([&chan, &sums, &counts, i]() {
+      std::vector<int64_t> batch(kBatch);
+      size_t n = 0;
+      while ((n = chan->Read(kBatch, &batch[0])) > 0) {
+        counts[i] += n;
+        sums[i] = std::accumulate(batch.begin(), batch.begin() + n, sums[i]);
+      }
+    });
+  }
+  for (auto& t : producers) {
+    t.join();
+  }
+  chan->Close();
+  for (auto& t : consumers) {
+    t.join();
+  }
+
+  int64_t total = static_cast<int64_t>(producer_num) * kItemsPerProducer;
+  EXPECT_EQ(std::accumulate(counts.begin(), counts.end(), size_t(0)),
+            static_cast<size_t>(total));
+  EXPECT_EQ(std::accumulate(sums.begin(), sums.end(), int64_t(0)),
+            total * (total - 1) / 2);
+  EXPECT_TRUE(chan->Empty());
+}
+
+TEST(Channel, MultiProducerMultiConsumer) {
+  ProduceAndConsume(1, std::numeric_limits<size_t>::max(), 4, 4);
+}
+
+TEST(Channel, ShardedMultiProducerMultiConsumer) {
+  ProduceAndConsume(8, std::numeric_limits<size_t>::max(), 8, 4);
+  ProduceAndConsume(4, std::numeric_limits<size_t>::max(), 2, 8);
+}
+
+TEST(Channel, ShardedBoundedCapacity) {
+  ProduceAndConsume(4, 100, 6, 3);
+  ProduceAndConsume(4, 1, 3, 3);
+}
+
+TEST(Channel, ShardedCloseAndReadAll) {
+  auto chan = MakeChannel<int>();
+  chan->SetShardNum(4);
+  chan->SetBlockSize(3);
+  std::vector<int> data = {0, 1, 2, 3, 4, 5, 6};
+  EXPECT_EQ(chan->Write(data), data.size());
+  EXPECT_EQ(chan->Size(), data.size());
+
+  std::vector<int> out;
+  EXPECT_EQ(chan->Read(out), 3UL);
+  EXPECT_EQ(chan->ReadOnce(out, 10), 4UL);
+  EXPECT_TRUE(chan->Empty());
+
+  EXPECT_EQ(chan->Write(data), data.size());
+  chan->Close();
+  // no more data can be written into a closed channel
+  EXPECT_EQ(chan->Write(data), 0UL);
+  EXPECT_EQ(chan->ReadAll(out), data.size());
+  std::sort(out.begin(), out.end());
+  EXPECT_EQ(out, data);
+  int val = 0;
+  EXPECT_FALSE(chan->Get(val));
+
+  chan->Open();
+  EXPECT_TRUE(chan->Put(7));
+  chan->Clear();
+  EXPECT_EQ(chan->Size(), 0UL);
+}
+
+TEST(Channel, ShardedGetShardData) {
+  auto chan = MakeChannel<int>();
+  chan->SetShardNum(3);
+  std::vector<std::thread> writers;
+  for (int i = 0; i < 4; ++i) {
+    writers.emplace_back([&chan, i]() {
+      std::vector<int> data(100);
+      std::iota(data.begin(), data.end(), i * 100);
+      chan->Write(data);
+    });
+  }
+  for (auto& t : writers) {
+    t.join();
+  }
+
+  // the shards together hold all the data
+  std::vector<int> out;
+  for (size_t i = 0; i < chan->ShardNum(); ++i) {
+    const std::deque<int>& data = chan->GetShardData(i);
+    out.insert(out.end(), data.begin(), data.end());
+  }
+  std::sort(out.begin(), out.end());
+  std::vector<int> expected(400);
+  std::iota(expected.begin(), expected.end(), 0);
+  EXPECT_EQ(out, expected);
+
+  auto single = MakeChannel<int>();
+  single->Put(1);
+  EXPECT_EQ(single->GetShardData(0).size(), 1UL);
+}
+
+TEST(Channel, ShardedBlockedReaderIsWoken) {
+  auto chan = MakeChannel<int>();
+  chan->SetShardNum(2);
+  std::thread reader([&chan]() {
+    int val = 0;
+    EXPECT_TRUE(chan->Get(val));
+    EXPECT_EQ(val, 42);
+    EXPECT_FALSE(chan->Get(val));
+  });
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  chan->Put(42);
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  chan->Close();
+  reader.join();
+}
+
+}  // namespace framework
+}  // namespace paddle
@@ -20,6 +20,7 @@ limitations under the License. */
 #include "paddle/fluid/framework/data_feed.h"
 
 #include "paddle/fluid/framework/fleet/ps_gpu_wrapper.h"
+#include "paddle/fluid/framework/slot_record_binary.h"
 #ifdef _LINUX
 #include <stdio_ext.h>
 #include <sys/mman.h>
@@ -2094,6 +2095,7 @@ void SlotRecordInMemoryDataFeed::Init(const DataFeedDesc& data_feed_desc) {
   pipe_command_ = data_feed_desc.pipe_command();
   finish_init_ = true;
   input_type_ = data_feed_desc.input_type();
+  binary_slot_record_ = data_feed_desc.binary_slot_record();
   size_t pos = pipe_command_.find(".so");
   if (pos != std::string::npos) {
     pos = pipe_command_.rfind('|');
@@ -2112,7 +2114,9 @@ void SlotRecordInMemoryDataFeed::Init(const DataFeedDesc& data_feed_desc) {
 
 void SlotRecordInMemoryDataFeed::LoadIntoMemory() {
   VLOG(3) << "SlotRecord LoadIntoMemory() begin, thread_id=" << thread_id_;
-  if (!so_parser_name_.empty()) {
+  if (binary_slot_record_) {
+    LoadIntoMemoryByBinary();
+  } else if (!so_parser_name_.empty()) {
     LoadIntoMemoryByLib();
   } else {
     LoadIntoMemoryByCommand();
@@ -2361,6 +2365,198 @@ void SlotRecordInMemoryDataFeed::LoadIntoMemoryByCommand(void) {
 #endif
 }
 
+static SlotRecordBinaryHeader MakeSlotRecordBinaryHeader(
+    const std::vector<UsedSlotInfo>& used_slots_info,
+    bool parse_ins_id,
+    bool parse_logkey) {
+  SlotRecordBinaryHeader header;
+  if (parse_ins_id || parse_logkey) {
+    header.flags |= SlotRecordBinaryHeader::kHasInsId;
+  }
+  if (parse_logkey) {
+    header.flags |= SlotRecordBinaryHeader::kHasLogKey;
+  }
+  // used slots are stored in the order of slot_value_idx, the same order as
+  // the SlotValues of SlotRecord
+  for (auto& info : used_slots_info) {
+    if (info.type[0] == 'u') {
+      header.uint64_slots.push_back(info.slot);
+    } else if (info.type[0] == 'f') {
+      header.float_slots.push_back(info.slot);
+    }
+  }
+  return header;
+}
+
+void SlotRecordInMemoryDataFeed::LoadIntoMemoryByBinary(void) {
+#ifdef _LINUX
+  const SlotRecordBinaryHeader expect_header = MakeSlotRecordBinaryHeader(
+      used_slots_info_, parse_ins_id_, parse_logkey_);
+  // the same sampling and retry as BufferedLineFileReader of the text files
+  const bool need_sample = std::abs(sample_rate_ - 1.0f) >= 1e-5f;
+  const int max_retry_num = 10;
+  std::default_random_engine random_engine(std::random_device()());
+  std::uniform_real_distribution<float> uniform_distribution(0.0f, 1.0f);
+  std::string filename;
+  uint64_t total_bytes = 0;
+
+  while (this->PickOneFile(&filename)) {
+    VLOG(3) << "PickOneFile, filename=" << filename
+            << ", thread_id=" << thread_id_;
+    platform::Timer timeline;
+    timeline.Start();
+    size_t lines = 0;
+    size_t sample_lines = 0;
+    // the blocks loaded before a read error are skipped after the file is
+    // opened again
+    int loaded_blocks = 0;
+    std::vector<SlotRecord> record_vec;
+    bool slots_match = true;
+    bool flags_match = true;
+    for (int retry_num = 0;; ++retry_num) {
+      int err_no = 0;
+      // the pipe command generates text instances, it does not apply to the
+      // binary file which is read as it is
+      this->fp_ = fs_open_read(filename, &err_no, "", true);
+      CHECK(this->fp_ != nullptr);
+      __fsetlocking(&*(this->fp_), FSETLOCKING_BYCALLER);
+      try {
+        SlotRecordBinaryReader reader(this->fp_);
+        const auto& header = reader.header();
+        // a mismatch is a config error, it is reported below without retry
+        slots_match = header.uint64_slots == expect_header.uint64_slots &&
+                      header.float_slots == expect_header.float_slots;
+        flags_match =
+            (header.flags & expect_header.flags) == expect_header.flags;
+        if (!slots_match || !flags_match) {
+          break;
+        }
+
+        int block_id = 0;
+        int ins_num = 0;
+        while ((ins_num = reader.NextBlock()) > 0) {
+          if (block_id++ < loaded_blocks) {
+            continue;
+          }
+          SlotRecordPool().get(&record_vec, ins_num);
+          reader.DecodeBlock(&record_vec[0], ins_num);
+          int keep_num = ins_num;
+          if (need_sample) {
+            keep_num = 0;
+            for (int i = 0; i < ins_num; ++i) {
+              if (uniform_distribution(random_engine) < sample_rate_) {
+                std::swap(record_vec[keep_num++], record_vec[i]);
+              }
+            }
+          }
+          if (keep_num > 0) {
+            input_channel_->WriteMove(keep_num, &record_vec[0]);
+          }
+          if (keep_num < ins_num) {
+            SlotRecordPool().put(&record_vec[keep_num], ins_num - keep_num);
+          }
+          record_vec.clear();
+          ++loaded_blocks;
+          lines += ins_num;
+          sample_lines += keep_num;
+        }
+        total_bytes += reader.bytes();
+        break;
+      } catch (platform::EnforceNotMet& e) {
+        // the records of the block failed to decode
+        SlotRecordPool().put(&record_vec);
+        if (retry_num >= max_retry_num) {
+          throw;
+        }
+        LOG(WARNING) << "read binary file:[" << filename
+                     << "] error, open it again, retry_num=" << retry_num + 1
+                     << ", loaded blocks=" << loaded_blocks
+                     << ", error: " << e.what();
+      }
+    }
+    PADDLE_ENFORCE_EQ(
+        slots_match,
+        true,
+        platform::errors::InvalidArgument(
+            "The used slots of binary file [%s] do not match the used slots "
+            "of data feed, please convert it with the same slot config.",
+            filename));
+    PADDLE_ENFORCE_EQ(
+        flags_match,
+        true,
+        platform::errors::InvalidArgument(
+            "The binary file [%s] does not contain ins_id or log key, which "
+            "is required by the data feed.",
+            filename));
+    timeline.Pause();
+    VLOG(3) << "LoadIntoMemoryByBinary() read all blocks, file=" << filename
+            << ", lines=" << lines << ", sample lines=" << sample_lines
+            << ", cost time=" << timeline.ElapsedSec()
+            << " seconds, thread_id=" << thread_id_;
+  }
+  VLOG(3) << "LoadIntoMemoryByBinary() end, thread_id=" << thread_id_
+          << ", total size: " << total_bytes;
+#endif
+}
+
+size_t SlotRecordInMemoryDataFeed::ConvertTextToBinary(
+    const std::string& text_file, const std::string& binary_file) {
+  size_t ins_num = 0;
+#ifdef _LINUX
+  int err_no = 0;
+  auto out = fs_open_write(binary_file, &err_no, "");
+  PADDLE_ENFORCE_NOT_NULL(
+      out.get(),
+      platform::errors::Unavailable("Failed to open binary file [%s].",
+                                    binary_file));
+  SlotRecordBinaryWriter writer(
+      out,
+      MakeSlotRecordBinaryHeader(
+          used_slots_info_, parse_ins_id_, parse_logkey_));
+  BufferedLineFileReader line_reader;
+  std::vector<SlotRecord> record_vec;
+  SlotRecordPool().get(&record_vec, OBJPOOL_BLOCK_SIZE);
+  int offset = 0;
+  int lines = 0;
+
+  auto fp = fs_open_read(text_file, &err_no, this->pipe_command_, true);
+  CHECK(fp != nullptr);
+  __fsetlocking(&*fp, FSETLOCKING_BYCALLER);
+  lines = line_reader.read_file(
+      fp.get(),
+      [this, &record_vec, &offset, &writer, &text_file](
+          const std::string& line) {
+        record_vec[offset]->reset();
+        if (!ParseOneInstance(line, &record_vec[offset])) {
+          LOG(WARNING) << "convert file:[" << text_file
+                       << "] item error, line:[" << line << "]";
+          return false;
+        }
+        if (++offset >= OBJPOOL_BLOCK_SIZE) {
+          writer.Write(&record_vec[0], offset);
+          offset = 0;
+        }
+        return true;
+      },
+      lines);
+  PADDLE_ENFORCE_EQ(line_reader.is_error(),
+                    false,
+                    platform::errors::InvalidArgument(
+                        "Too many error lines in file [%s].", text_file));
+  if (offset > 0) {
+    writer.Write(&record_vec[0], offset);
+  }
+  writer.Finish();
+  ins_num = writer.ins_num();
+  SlotRecordPool().put(&record_vec);
+  VLOG(3) << "ConvertTextToBinary() file=" << text_file << ", lines=" << lines
+          << ", ins num=" << ins_num
+          << ", text size=" << line_reader.file_size()
+          << ", binary size=" << writer.bytes();
+#endif
+  return ins_num;
+}
+
 static void parser_log_key(const std::string& log_key,
                            uint64_t* search_id,
                            uint32_t* cmatch,
@@ -1414,6 +1414,11 @@ class SlotRecordInMemoryDataFeed : public InMemoryDataFeed<SlotRecord> {
   virtual void Init(const DataFeedDesc& data_feed_desc);
   virtual void LoadIntoMemory();
   void ExpandSlotRecord(SlotRecord* ins);
+  // Parse a text file with the configured pipe command and write the
+  // instances into a slot record binary file, which can be loaded by
+  // LoadIntoMemoryByBinary() without text parsing. Returns the ins num.
+  size_t ConvertTextToBinary(const std::string& text_file,
+                             const std::string& binary_file);
 
  protected:
   virtual bool Start();
@@ -1428,6 +1433,7 @@ class SlotRecordInMemoryDataFeed : public InMemoryDataFeed<SlotRecord> {
   virtual void LoadIntoMemoryByLib(void);
   virtual void LoadIntoMemoryByLine(void);
   virtual void LoadIntoMemoryByFile(void);
+  virtual void LoadIntoMemoryByBinary(void);
   virtual void SetInputChannel(void* channel) {
     input_channel_ = static_cast<ChannelObject<SlotRecord>*>(channel);
   }
@@ -1459,6 +1465,7 @@ class SlotRecordInMemoryDataFeed : public InMemoryDataFeed<SlotRecord> {
                      const UsedSlotGpuType* used_slots);
 #endif
   float sample_rate_ = 1.0f;
+  bool binary_slot_record_ = false;
   int use_slot_size_ = 0;
   int float_use_slot_size_ = 0;
   int uint64_use_slot_size_ = 0;
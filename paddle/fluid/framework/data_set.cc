@@ -34,6 +34,7 @@
 #endif
 
 USE_INT_STAT(STAT_total_feasign_num_in_mem);
+DECLARE_int32(dataset_channel_shard_num);
 namespace paddle {
 namespace framework {
 
@@ -210,6 +211,7 @@ template <typename T>
 void DatasetImpl<T>::CreateChannel() {
   if (input_channel_ == nullptr) {
     input_channel_ = paddle::framework::MakeChannel<T>();
+    input_channel_->SetShardNum(FLAGS_dataset_channel_shard_num);
   }
   if (multi_output_channel_.size() == 0) {
     multi_output_channel_.reserve(channel_num_);
@@ -1658,6 +1660,7 @@ template class DatasetImpl<SlotRecord>;
 void SlotRecordDataset::CreateChannel() {
   if (input_channel_ == nullptr) {
     input_channel_ = paddle::framework::MakeChannel<SlotRecord>();
+    input_channel_->SetShardNum(FLAGS_dataset_channel_shard_num);
   }
 }
 void SlotRecordDataset::CreateReaders() {
@@ -1096,7 +1096,6 @@ class BoxHelper {
     auto box_ptr = BoxWrapper::GetInstance();
     auto input_channel_ =
         dynamic_cast<MultiSlotDataset*>(dataset_)->GetInputChannel();
-    const std::deque<Record>& pass_data = input_channel_->GetData();
 
     // get feasigns that FeedPass doesn't need
     const std::unordered_set<std::string>& slot_name_omited_in_feedpass_ =
@@ -1119,24 +1118,29 @@ class BoxHelper {
     VLOG(3) << "Begin call BeginFeedPass in BoxPS";
     box_ptr->BeginFeedPass(x / 86400, &p_agent);
 
-    std::vector<std::thread> threads;
-    size_t len = pass_data.size();
-    size_t len_per_thread = len / tnum;
-    auto remain = len % tnum;
-    size_t begin = 0;
-    for (size_t i = 0; i < tnum; i++) {
-      threads.push_back(
-          std::thread(FeedPassThread,
-                      std::ref(pass_data),
-                      begin,
-                      begin + len_per_thread + (i < remain ? 1 : 0),
-                      p_agent,
-                      std::ref(slot_id_omited_in_feedpass_),
-                      i));
-      begin += len_per_thread + (i < remain ? 1 : 0);
-    }
-    for (size_t i = 0; i < tnum; ++i) {
-      threads[i].join();
+    // a sharded channel is fed shard by shard
+    for (size_t shard = 0; shard < input_channel_->ShardNum(); ++shard) {
+      const std::deque<Record>& pass_data =
+          input_channel_->GetShardData(shard);
+      std::vector<std::thread> threads;
+      size_t len = pass_data.size();
+      size_t len_per_thread = len / tnum;
+      auto remain = len % tnum;
+      size_t begin = 0;
+      for (size_t i = 0; i < tnum; i++) {
+        threads.push_back(
+            std::thread(FeedPassThread,
+                        std::ref(pass_data),
+                        begin,
+                        begin + len_per_thread + (i < remain ? 1 : 0),
+                        p_agent,
+                        std::ref(slot_id_omited_in_feedpass_),
+                        i));
+        begin += len_per_thread + (i < remain ? 1 : 0);
+      }
+      for (size_t i = 0; i < tnum; ++i) {
+        threads[i].join();
+      }
     }
 
     if (box_ptr->Mode() == 1) {
@@ -139,11 +139,6 @@ void PSGPUWrapper::PreBuildTask(std::shared_ptr<HeterContext> gpu_task) {
     SlotRecordDataset* dataset = (SlotRecordDataset*)(dataset_);
     auto input_channel = dataset->GetInputChannel();
     VLOG(0) << "psgpu wrapperinputslotchannle size: " << input_channel->Size();
-    const std::deque<SlotRecord>& vec_data = input_channel->GetData();
-    total_len = vec_data.size();
-    len_per_thread = total_len / thread_keys_thread_num_;
-    remain = total_len % thread_keys_thread_num_;
-    VLOG(0) << "total len: " << total_len;
     auto gen_dynamic_mf_func = [this](const std::deque<SlotRecord>& total_data,
                                       int begin_index,
                                       int end_index,
@@ -168,18 +163,30 @@ void PSGPUWrapper::PreBuildTask(std::shared_ptr<HeterContext> gpu_task) {
         }
       }
     };
-    for (int i = 0; i < thread_keys_thread_num_; i++) {
-      threads.push_back(
-          std::thread(gen_dynamic_mf_func,
-                      std::ref(vec_data),
-                      begin,
-                      begin + len_per_thread + (i < remain ? 1 : 0),
-                      i));
-
-      begin += len_per_thread + (i < remain ? 1 : 0);
-    }
-    for (std::thread& t : threads) {
-      t.join();
+    // A sharded channel is split among the threads shard by shard, so that
+    // thread i is still the only writer of thread_dim_keys_[i].
+    for (size_t shard = 0; shard < input_channel->ShardNum(); ++shard) {
+      const std::deque<SlotRecord>& vec_data =
+          input_channel->GetShardData(shard);
+      total_len = vec_data.size();
+      len_per_thread = total_len / thread_keys_thread_num_;
+      remain = total_len % thread_keys_thread_num_;
+      begin = 0;
+      VLOG(0) << "shard " << shard << " total len: " << total_len;
+      threads.clear();
+      for (int i = 0; i < thread_keys_thread_num_; i++) {
+        threads.push_back(
+            std::thread(gen_dynamic_mf_func,
+                        std::ref(vec_data),
+                        begin,
+                        begin + len_per_thread + (i < remain ? 1 : 0),
+                        i));
+
+        begin += len_per_thread + (i < remain ? 1 : 0);
+      }
+      for (std::thread& t : threads) {
+        t.join();
+      }
     }
     timeline.Pause();
     VLOG(0) << "GpuPs build task cost " << timeline.ElapsedSec() << " seconds.";
@@ -189,10 +196,6 @@ void PSGPUWrapper::PreBuildTask(std::shared_ptr<HeterContext> gpu_task) {
     MultiSlotDataset* dataset = (MultiSlotDataset*)(dataset_);
     auto input_channel = dataset->GetInputChannel();
 
-    const std::deque<Record>& vec_data = input_channel->GetData();
-    total_len = vec_data.size();
-    len_per_thread = total_len / thread_keys_thread_num_;
-    remain = total_len % thread_keys_thread_num_;
     auto gen_func = [this](const std::deque<Record>& total_data,
                            int begin_index,
                            int end_index,
@@ -209,17 +212,25 @@ void PSGPUWrapper::PreBuildTask(std::shared_ptr<HeterContext> gpu_task) {
         }
       }
     };
-    for (int i = 0; i < thread_keys_thread_num_; i++) {
-      threads.push_back(
-          std::thread(gen_func,
-                      std::ref(vec_data),
-                      begin,
-                      begin + len_per_thread + (i < remain ? 1 : 0),
-                      i));
-      begin += len_per_thread + (i < remain ? 1 : 0);
-    }
-    for (std::thread& t : threads) {
-      t.join();
+    for (size_t shard = 0; shard < input_channel->ShardNum(); ++shard) {
+      const std::deque<Record>& vec_data = input_channel->GetShardData(shard);
+      total_len = vec_data.size();
+      len_per_thread = total_len / thread_keys_thread_num_;
+      remain = total_len % thread_keys_thread_num_;
+      begin = 0;
+      threads.clear();
+      for (int i = 0; i < thread_keys_thread_num_; i++) {
+        threads.push_back(
+            std::thread(gen_func,
+                        std::ref(vec_data),
+                        begin,
+                        begin + len_per_thread + (i < remain ? 1 : 0),
+                        i));
+        begin += len_per_thread + (i < remain ? 1 : 0);
+      }
+      for (std::thread& t : threads) {
+        t.join();
+      }
     }
     timeline.Pause();
     VLOG(0) << "GpuPs build task cost " << timeline.ElapsedSec() << " seconds.";
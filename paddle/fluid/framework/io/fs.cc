@@ -19,6 +19,7 @@ limitations under the License. */
 #include <memory>
 
 #include "glog/logging.h"
+#include "paddle/fluid/framework/io/native_file.h"
 #include "paddle/fluid/platform/enforce.h"
 
 namespace paddle {
@@ -56,6 +57,21 @@ static void fs_add_write_converter_internal(std::string& path,  // NOLINT
   }
 }
 
+static std::shared_ptr<FILE> fs_buffer_internal(std::shared_ptr<FILE> fp,
+                                                size_t buffer_size) {
+  if (buffer_size > 0) {
+    char* buffer = new char[buffer_size];
+    CHECK_EQ(0, setvbuf(&*fp, buffer, _IOFBF, buffer_size));
+    fp = {&*fp, [fp, buffer](FILE*) mutable {  // NOLINT
+            CHECK(fp.unique());                // NOLINT
+            fp = nullptr;
+            delete[] buffer;
+          }};
+  }
+
+  return fp;
+}
+
 static std::shared_ptr<FILE> fs_open_internal(const std::string& path,
                                               bool is_pipe,
                                               const std::string& mode,
@@ -69,17 +85,7 @@ static std::shared_ptr<FILE> fs_open_internal(const std::string& path,
     fp = shell_popen(path, mode, err_no);
   }
 
-  if (buffer_size > 0) {
-    char* buffer = new char[buffer_size];
-    CHECK_EQ(0, setvbuf(&*fp, buffer, _IOFBF, buffer_size));
-    fp = {&*fp, [fp, buffer](FILE*) mutable {  // NOLINT
-            CHECK(fp.unique());                // NOLINT
-            fp = nullptr;
-            delete[] buffer;
-          }};
-  }
-
-  return fp;
+  return fs_buffer_internal(fp, buffer_size);
 }
 
 static bool fs_begin_with_internal(const std::string& path,
@@ -104,8 +110,43 @@ size_t localfs_buffer_size() { return localfs_buffer_size_internal(); }
 
 void localfs_set_buffer_size(size_t x) { localfs_buffer_size_internal() = x; }
 
+static bool& localfs_native_io_internal() {
+  static bool x = true;
+  return x;
+}
+
+bool localfs_native_io() { return localfs_native_io_internal(); }
+
+void localfs_set_native_io(bool x) { localfs_native_io_internal() = x; }
+
+static int& localfs_native_io_threads_internal() {
+  static int x = 2;
+  return x;
+}
+
+int localfs_native_io_threads() { return localfs_native_io_threads_internal(); }
+
+void localfs_set_native_io_threads(int x) {
+  localfs_native_io_threads_internal() = x;
+}
+
+static bool localfs_identity_converter_internal(const std::string& converter) {
+  std::string x = string::trim_spaces(converter);
+  return x == "" || x == "cat";
+}
+
 std::shared_ptr<FILE> localfs_open_read(std::string path,
                                         const std::string& converter) {
+  // the .gz files, and the plain ones piped through cat, are read in the
+  // process, the shell pipe remains if they can not be opened so
+  if (localfs_native_io() && localfs_identity_converter_internal(converter) &&
+      (fs_end_with_internal(path, ".gz") || converter != "")) {
+    auto fp = native_fopen_read(path, localfs_native_io_threads());
+    if (fp) {
+      return fs_buffer_internal(fp, localfs_buffer_size());
+    }
+  }
+
   bool is_pipe = false;
 
   if (fs_end_with_internal(path, ".gz")) {
@@ -121,6 +162,14 @@ std::shared_ptr<FILE> localfs_open_write(std::string path,
   shell_execute(
       string::format_string("mkdir -p $(dirname \"%s\")", path.c_str()));
 
+  if (localfs_native_io() && localfs_identity_converter_internal(converter) &&
+      fs_end_with_internal(path, ".gz")) {
+    auto fp = native_fopen_write(path, localfs_native_io_threads());
+    if (fp) {
+      return fs_buffer_internal(fp, localfs_buffer_size());
+    }
+  }
+
   bool is_pipe = false;
 
   if (fs_end_with_internal(path, ".gz")) {
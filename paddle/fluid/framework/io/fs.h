@@ -35,6 +35,17 @@ extern size_t localfs_buffer_size();
 
 extern void localfs_set_buffer_size(size_t x);
 
+// whether the .gz files, and the plain ones read through cat, are opened in
+// the process instead of a shell pipe, see native_file.h
+extern bool localfs_native_io();
+
+extern void localfs_set_native_io(bool x);
+
+// the threads (de)compressing a file opened in the process
+extern int localfs_native_io_threads();
+
+extern void localfs_set_native_io_threads(int x);
+
 extern std::shared_ptr<FILE> localfs_open_read(std::string path,
                                                const std::string& converter);
 
@@ -0,0 +1,104 @@
+// Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Compare the MB/s of writing and reading a .gz file in the process with the
+// gzip and zcat pipes, e.g.
+//   fs_benchmark --mb=1024 --threads=4 --dir=/tmp/fs_benchmark
+// The uncompressed MB are counted, and the lines are read by LineFileReader
+// as DataFeed does.
+
+#include <random>
+#include <string>
+
+#include "gflags/gflags.h"
+#include "glog/logging.h"
+#include "paddle/fluid/framework/io/fs.h"
+#include "paddle/fluid/platform/timer.h"
+
+DEFINE_int32(mb, 512, "The uncompressed MB of the file.");
+DEFINE_int32(threads, 2, "The threads (de)compressing the file in process.");
+DEFINE_string(dir, "/tmp/fs_benchmark", "The dir of the files.");
+
+namespace paddle {
+namespace framework {
+
+// the lines of a slot file, "slot:feasign" ones with a label
+static std::string MakeLines(size_t bytes) {
+  std::mt19937_64 rng(0);
+  std::string lines;
+  lines.reserve(bytes + 1024);
+  while (lines.size() < bytes) {
+    lines += std::to_string(rng() % 2);
+    for (int i = 0; i < 50; ++i) {
+      lines += " " + std::to_string(i) + ":" + std::to_string(rng() % 1000000);
+    }
+    lines += "\n";
+  }
+  return lines;
+}
+
+static double Write(const std::string& path, const std::string& lines) {
+  platform::Timer timer;
+  timer.Start();
+  {
+    auto fp = fs_open_write(path, nullptr, "");
+    CHECK_EQ(fwrite(lines.data(), 1, lines.size(), &*fp), lines.size());
+  }
+  timer.Pause();
+  return lines.size() / timer.ElapsedSec() / (1 << 20);
+}
+
+static double Read(const std::string& path, size_t bytes) {
+  platform::Timer timer;
+  timer.Start();
+  size_t read_bytes = 0;
+  {
+    int err_no = 0;
+    auto fp = fs_open_read(path, &err_no, "cat", true);
+    string::LineFileReader reader;
+    while (reader.getline(&*fp)) {
+      read_bytes += reader.length() + 1;
+    }
+  }
+  timer.Pause();
+  CHECK_EQ(read_bytes, bytes);
+  return bytes / timer.ElapsedSec() / (1 << 20);
+}
+
+static int BenchmarkMain() {
+  std::string lines = MakeLines(static_cast<size_t>(FLAGS_mb) << 20);
+  localfs_set_native_io_threads(FLAGS_threads);
+  for (bool native_io : {false, true}) {
+    localfs_set_native_io(native_io);
+    std::string title = native_io ? "in process" : "shell pipe";
+    std::string path = FLAGS_dir + "/" + (native_io ? "native" : "shell") +
+                       ".gz";
+    LOG(INFO) << title << " write: " << Write(path, lines) << " MB/s, "
+              << localfs_file_size(path) / (1 << 20) << " MB";
+    LOG(INFO) << title << " read: " << Read(path, lines.size()) << " MB/s";
+  }
+  // the file of gzip is inflated sequentially in the process
+  LOG(INFO) << "in process read of gzip: "
+            << Read(FLAGS_dir + "/shell.gz", lines.size()) << " MB/s";
+  return 0;
+}
+
+}  // namespace framework
+}  // namespace paddle
+
+int main(int argc, char* argv[]) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  google::InitGoogleLogging(argv[0]);
+  return paddle::framework::BenchmarkMain();
+}
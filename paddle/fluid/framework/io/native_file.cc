@@ -0,0 +1,767 @@
+// Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/framework/io/native_file.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+#include <zlib.h>
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "glog/logging.h"
+#include "paddle/fluid/framework/io/shell.h"
+#include "paddle/fluid/platform/enforce.h"
+
+namespace paddle {
+namespace framework {
+
+#if defined(_WIN32) || defined(__APPLE__) || defined(PADDLE_ARM)
+
+std::shared_ptr<FILE> native_fopen_read(const std::string& path,
+                                        int threads) {
+  return nullptr;
+}
+
+std::shared_ptr<FILE> native_fopen_write(const std::string& path,
+                                         int threads) {
+  return nullptr;
+}
+
+#else
+
+namespace {
+
+const size_t kAlignment = 4096;
+// the bytes of a read(2) of the compressed files
+const size_t kReadChunkSize = 1UL << 20;
+// the bytes the kernel is advised to read ahead of the reader
+const size_t kReadaheadSize = 16UL << 20;
+// the larger members are taken as corrupted
+const size_t kMaxMemberSize = 1UL << 30;
+// the blocks (de)compressed ahead of the reader or the writer per thread
+const size_t kBlocksPerThread = 2;
+
+// id1 id2 cm flg(FEXTRA) mtime(4) xfl os xlen(2), and the "PD" subfield of 4
+// bytes, which holds the size of the whole member
+const size_t kGzipHeaderSize = 20;
+const size_t kGzipTrailerSize = 8;
+const unsigned char kGzipHeader[16] = {
+    0x1f, 0x8b, 8, 4, 0, 0, 0, 0, 0, 0xff, 8, 0, 'P', 'D', 4, 0};
+
+void PutUint32(unsigned char* p, uint32_t x) {
+  for (int i = 0; i < 4; ++i) {
+    p[i] = static_cast<unsigned char>(x >> (8 * i));
+  }
+}
+
+uint32_t GetUint32(const unsigned char* p) {
+  return p[0] | (p[1] << 8) | (p[2] << 16) |
+         (static_cast<uint32_t>(p[3]) << 24);
+}
+
+bool EndsWith(const std::string& path, const std::string& str) {
+  return path.size() >= str.size() &&
+         path.compare(path.size() - str.size(), str.size(), str) == 0;
+}
+
+struct AlignedFree {
+  void operator()(char* p) const { free(p); }
+};
+
+std::unique_ptr<char, AlignedFree> NewAlignedBuffer(size_t size) {
+  void* p = nullptr;
+  PADDLE_ENFORCE_EQ(posix_memalign(&p, kAlignment, size),
+                    0,
+                    platform::errors::ResourceExhausted(
+                        "Failed to allocate %d bytes.", size));
+  return std::unique_ptr<char, AlignedFree>(static_cast<char*>(p));
+}
+
+// the sequential reads of a file, which advise the kernel to read ahead
+class FdInput {
+ public:
+  FdInput(int fd, const std::string& path) : _fd(fd), _path(path) {
+    posix_fadvise(_fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+    Advise();
+  }
+
+  ~FdInput() { close(_fd); }
+
+  // reads size bytes, fewer only at the end of the file, -1 on errors
+  ssize_t Read(void* data, size_t size) {
+    size_t done = 0;
+    while (done < size) {
+      ssize_t n = read(_fd, static_cast<char*>(data) + done, size - done);
+      if (n < 0 && errno == EINTR) {
+        continue;
+      }
+      if (n < 0) {
+        LOG(WARNING) << "Failed to read file[" << _path
+                     << "]: " << strerror(errno);
+        return -1;
+      }
+      if (n == 0) {
+        break;
+      }
+      done += n;
+    }
+    _offset += done;
+    if (_offset + static_cast<off_t>(kReadaheadSize / 2) >= _advised) {
+      Advise();
+    }
+    return done;
+  }
+
+  const std::string& path() const { return _path; }
+
+ private:
+  void Advise() {
+    _advised = std::max(_advised, _offset);
+    posix_fadvise(_fd, _advised, kReadaheadSize, POSIX_FADV_WILLNEED);
+    _advised += kReadaheadSize;
+  }
+
+  int _fd;
+  std::string _path;
+  off_t _offset = 0;
+  off_t _advised = 0;
+};
+
+// the blocks (de)compressed by the threads, which are taken in their order
+class OrderedBlocks {
+ public:
+  explicit OrderedBlocks(size_t capacity) : _capacity(capacity) {}
+
+  // waits until the block seq is within the capacity ahead of the taker,
+  // false if the blocks are closed
+  bool WaitSlot(size_t seq) {
+    std::unique_lock<std::mutex> lock(_mutex);
+    _cond.wait(lock, [&] { return _closed || seq < _next + _capacity; });
+    return !_closed;
+  }
+
+  void Put(size_t seq, std::string block) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _blocks[seq] = std::move(block);
+    _cond.notify_all();
+  }
+
+  // the blocks before seq are all of the blocks
+  void Finish(size_t seq) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _total = std::min(_total, seq);
+    _cond.notify_all();
+  }
+
+  void Fail() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _failed = true;
+    _cond.notify_all();
+  }
+
+  // the taker stops, and wakes the threads waiting for a slot
+  void Close() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _closed = true;
+    _cond.notify_all();
+  }
+
+  // 1 if the next block is taken, 0 after the last one, -1 if a block failed
+  int Take(std::string* block) {
+    std::unique_lock<std::mutex> lock(_mutex);
+    _cond.wait(lock, [&] {
+      return _failed || _next >= _total || _blocks.count(_next) > 0;
+    });
+    if (_failed) {
+      return -1;
+    }
+    if (_next >= _total) {
+      return 0;
+    }
+    auto it = _blocks.find(_next);
+    *block = std::move(it->second);
+    _blocks.erase(it);
+    ++_next;
+    _cond.notify_all();
+    return 1;
+  }
+
+ private:
+  std::mutex _mutex;
+  std::condition_variable _cond;
+  std::map<size_t, std::string> _blocks;
+  size_t _capacity;
+  size_t _next = 0;
+  size_t _total = static_cast<size_t>(-1);
+  bool _failed = false;
+  bool _closed = false;
+};
+
+// Reads a gzip file. The files of native_fopen_write are inflated by the
+// threads a member each, the others are inflated by a thread ahead of the
+// reader, or by the reader itself without the threads.
+class GzipReader {
+ public:
+  GzipReader(int fd, const std::string& path, int threads)
+      : _input(fd, path),
+        _blocks(std::max(threads, 1) * kBlocksPerThread),
+        _in(NewAlignedBuffer(kReadChunkSize)) {
+    unsigned char header[kGzipHeaderSize];
+    _parallel = pread(fd, header, sizeof(header), 0) == sizeof(header) &&
+                memcmp(header, kGzipHeader, sizeof(kGzipHeader)) == 0;
+    memset(&_stream, 0, sizeof(_stream));
+    _stream_init = inflateInit2(&_stream, MAX_WBITS + 16) == Z_OK;
+    int thread_num = _parallel ? threads : std::min(threads, 1);
+    for (int i = 0; i < thread_num; ++i) {
+      _threads.emplace_back([this] {
+        if (_parallel) {
+          InflateMembers();
+        } else {
+          InflateStream();
+        }
+      });
+    }
+  }
+
+  ~GzipReader() {
+    _blocks.Close();
+    for (auto& t : _threads) {
+      t.join();
+    }
+    if (_stream_init) {
+      inflateEnd(&_stream);
+    }
+  }
+
+  ssize_t Read(char* buf, size_t size) {
+    size_t done = 0;
+    while (done < size && !_error) {
+      if (_pos == _block.size()) {
+        int ret = _threads.empty() ? NextBlock(&_block) : _blocks.Take(&_block);
+        _pos = 0;
+        if (ret <= 0) {
+          _block.clear();
+        }
+        if (ret < 0) {
+          LOG(WARNING) << "Failed to inflate file[" << _input.path() << "]";
+          _error = true;
+          break;
+        }
+        if (ret == 0) {
+          break;
+        }
+        continue;
+      }
+      size_t n = std::min(size - done, _block.size() - _pos);
+      memcpy(buf + done, &_block[_pos], n);
+      _pos += n;
+      done += n;
+    }
+    // the bytes before an error are still returned
+    return done == 0 && _error ? -1 : done;
+  }
+
+  // whether the file is truncated or corrupted, which fails the close so
+  // that the reader does not take a short read for the end of the file
+  bool Failed() const { return _error; }
+
+ private:
+  // 1 if a block is inflated, 0 at the end of the file, -1 on errors
+  int NextBlock(std::string* block) {
+    if (_parallel) {
+      std::string member;
+      int ret = NextMember(&member);
+      if (ret == 1) {
+        return InflateMember(member, block) ? 1 : -1;
+      }
+      if (ret != 2) {
+        return ret;
+      }
+      _parallel = false;
+    }
+    return StreamBlock(block);
+  }
+
+  // the threads read the members in turn and inflate them in parallel
+  void InflateMembers() {
+    std::string member;
+    std::string block;
+    while (true) {
+      size_t seq = 0;
+      int ret = 0;
+      {
+        std::lock_guard<std::mutex> lock(_input_mutex);
+        if (_input_done) {
+          return;
+        }
+        seq = _next_seq++;
+        if (!_blocks.WaitSlot(seq)) {
+          _input_done = true;
+          return;
+        }
+        ret = NextMember(&member);
+        _input_done = ret != 1;
+        if (ret == 2) {
+          // the rest of the file, e.g. another gzip file appended to it, is
+          // inflated sequentially by this thread
+          InflateStream(seq);
+          return;
+        }
+      }
+      if (ret == 0) {
+        _blocks.Finish(seq);
+        return;
+      }
+      if (ret < 0 || !InflateMember(member, &block)) {
+        _blocks.Fail();
+        return;
+      }
+      _blocks.Put(seq, std::move(block));
+    }
+  }
+
+  void InflateStream(size_t seq = 0) {
+    for (;; ++seq) {
+      if (!_blocks.WaitSlot(seq)) {
+        return;
+      }
+      std::string block;
+      int ret = StreamBlock(&block);
+      if (ret < 0) {
+        _blocks.Fail();
+        return;
+      }
+      if (ret == 0) {
+        _blocks.Finish(seq);
+        return;
+      }
+      _blocks.Put(seq, std::move(block));
+    }
+  }
+
+  // the member without its header, 1 if it is read, 0 at the end of the
+  // file, -1 on errors, and 2 if the member is not written by
+  // native_fopen_write, whose bytes read are left to StreamBlock
+  int NextMember(std::string* member) {
+    unsigned char header[kGzipHeaderSize];
+    ssize_t n = _input.Read(header, sizeof(header));
+    if (n <= 0) {
+      return n;
+    }
+    if (n != sizeof(header) ||
+        memcmp(header, kGzipHeader, sizeof(kGzipHeader)) != 0) {
+      memcpy(_in.get(), header, n);
+      _stream.next_in = reinterpret_cast<Bytef*>(_in.get());
+      _stream.avail_in = n;
+      return 2;
+    }
+    size_t size = GetUint32(header + 16);
+    if (size < kGzipHeaderSize + kGzipTrailerSize || size > kMaxMemberSize) {
+      return -1;
+    }
+    member->resize(size - kGzipHeaderSize);
+    n = _input.Read(&(*member)[0], member->size());
+    return n == static_cast<ssize_t>(member->size()) ? 1 : -1;
+  }
+
+  static bool InflateMember(const std::string& member, std::string* block) {
+    auto* trailer = reinterpret_cast<const unsigned char*>(member.data()) +
+                    member.size() - kGzipTrailerSize;
+    uint32_t crc = GetUint32(trailer);
+    uint32_t size = GetUint32(trailer + 4);
+    if (size > kMaxMemberSize) {
+      return false;
+    }
+    block->resize(size);
+    z_stream stream;
+    memset(&stream, 0, sizeof(stream));
+    if (inflateInit2(&stream, -MAX_WBITS) != Z_OK) {
+      return false;
+    }
+    stream.next_in =
+        reinterpret_cast<Bytef*>(const_cast<char*>(member.data()));
+    stream.avail_in = member.size() - kGzipTrailerSize;
+    stream.next_out = reinterpret_cast<Bytef*>(&(*block)[0]);
+    stream.avail_out = size;
+    int ret = inflate(&stream, Z_FINISH);
+    bool ok = ret == Z_STREAM_END && stream.avail_in == 0 &&
+              stream.avail_out == 0;
+    inflateEnd(&stream);
+    return ok && crc32(0, reinterpret_cast<const Bytef*>(block->data()),
+                       size) == crc;
+  }
+
+  // inflates the next block of a gzip file of any layout, the concatenated
+  // members are read one after another as zcat does
+  int StreamBlock(std::string* block) {
+    if (!_stream_init) {
+      return -1;
+    }
+    block->resize(kNativeGzipBlockSize);
+    _stream.next_out = reinterpret_cast<Bytef*>(&(*block)[0]);
+    _stream.avail_out = block->size();
+    while (_stream.avail_out > 0) {
+      if (_stream.avail_in == 0) {
+        ssize_t n = _input.Read(_in.get(), kReadChunkSize);
+        if (n < 0) {
+          return -1;
+        }
+        if (n == 0) {
+          break;
+        }
+        _stream.next_in = reinterpret_cast<Bytef*>(_in.get());
+        _stream.avail_in = n;
+      }
+      if (_member_end) {
+        inflateReset(&_stream);
+        _member_end = false;
+      }
+      int ret = inflate(&_stream, Z_NO_FLUSH);
+      if (ret == Z_STREAM_END) {
+        _member_end = true;
+      } else if (ret != Z_OK && ret != Z_BUF_ERROR) {
+        LOG(WARNING) << "Failed to inflate file[" << _input.path()
+                     << "]: " << (_stream.msg ? _stream.msg : "");
+        return -1;
+      }
+    }
+    block->resize(block->size() - _stream.avail_out);
+    if (block->empty()) {
+      // a truncated member
+      return _member_end ? 0 : -1;
+    }
+    return 1;
+  }
+
+  FdInput _input;
+  OrderedBlocks _blocks;
+  std::vector<std::thread> _threads;
+  bool _parallel = false;
+  // the block being read
+  std::string _block;
+  size_t _pos = 0;
+  bool _error = false;
+  // the input of the threads inflating the members
+  std::mutex _input_mutex;
+  size_t _next_seq = 0;
+  bool _input_done = false;
+  // the sequential inflation, an empty file is taken as an empty member
+  std::unique_ptr<char, AlignedFree> _in;
+  z_stream _stream;
+  bool _stream_init = false;
+  bool _member_end = true;
+};
+
+// Writes a gzip file as the members of kNativeGzipBlockSize bytes, which are
+// deflated by the threads and written by another one in their order, or by
+// the writer itself without the threads.
+class GzipWriter {
+ public:
+  GzipWriter(int fd, const std::string& path, int threads)
+      : _fd(fd), _path(path), _blocks(std::max(threads, 1) * kBlocksPerThread) {
+    _block.reserve(kNativeGzipBlockSize);
+    for (int i = 0; i < threads; ++i) {
+      _workers.emplace_back([this] { DeflateBlocks(); });
+    }
+    if (threads > 0) {
+      _output = std::thread([this] { WriteMembers(); });
+    }
+  }
+
+  ssize_t Write(const char* buf, size_t size) {
+    size_t done = 0;
+    while (done < size && !_error) {
+      size_t n = std::min(size - done, kNativeGzipBlockSize - _block.size());
+      _block.append(buf + done, n);
+      done += n;
+      if (_block.size() == kNativeGzipBlockSize) {
+        Submit();
+      }
+    }
+    return _error ? 0 : size;
+  }
+
+  // writes the pending block, and an empty member for an empty file, then
+  // waits for the threads and closes the file, 0 on success
+  int Close() {
+    if (!_block.empty() || _seq == 0) {
+      Submit();
+    }
+    {
+      std::lock_guard<std::mutex> lock(_task_mutex);
+      _task_done = true;
+    }
+    _task_cond.notify_all();
+    for (auto& t : _workers) {
+      t.join();
+    }
+    _blocks.Finish(_seq);
+    if (_output.joinable()) {
+      _output.join();
+    }
+    if (close(_fd) != 0) {
+      LOG(WARNING) << "Failed to close file[" << _path
+                   << "]: " << strerror(errno);
+      _error = true;
+    }
+    return _error ? -1 : 0;
+  }
+
+ private:
+  void Submit() {
+    if (_error) {
+      return;
+    }
+    if (_workers.empty()) {
+      std::string member;
+      if (!DeflateMember(_block, &member)) {
+        _error = true;
+      } else {
+        WriteAll(member);
+      }
+      ++_seq;
+      _block.clear();
+      return;
+    }
+    if (!_blocks.WaitSlot(_seq)) {
+      return;
+    }
+    {
+      std::lock_guard<std::mutex> lock(_task_mutex);
+      _tasks.emplace_back(_seq++, std::move(_block));
+    }
+    _task_cond.notify_one();
+    _block = std::string();
+    _block.reserve(kNativeGzipBlockSize);
+  }
+
+  void DeflateBlocks() {
+    while (true) {
+      std::pair<size_t, std::string> task;
+      {
+        std::unique_lock<std::mutex> lock(_task_mutex);
+        _task_cond.wait(lock, [&] { return _task_done || !_tasks.empty(); });
+        if (_tasks.empty()) {
+          return;
+        }
+        task = std::move(_tasks.front());
+        _tasks.pop_front();
+      }
+      std::string member;
+      if (!DeflateMember(task.second, &member)) {
+        _blocks.Fail();
+        return;
+      }
+      _blocks.Put(task.first, std::move(member));
+    }
+  }
+
+  void WriteMembers() {
+    std::string member;
+    int ret = 0;
+    while ((ret = _blocks.Take(&member)) > 0 && WriteAll(member)) {
+    }
+    if (ret < 0) {
+      _error = true;
+    }
+    if (_error) {
+      // the writer stops submitting
+      _blocks.Close();
+    }
+  }
+
+  static bool DeflateMember(const std::string& block, std::string* member) {
+    z_stream stream;
+    memset(&stream, 0, sizeof(stream));
+    if (deflateInit2(&stream,
+                     Z_DEFAULT_COMPRESSION,
+                     Z_DEFLATED,
+                     -MAX_WBITS,
+                     8,
+                     Z_DEFAULT_STRATEGY) != Z_OK) {
+      return false;
+    }
+    size_t bound = deflateBound(&stream, block.size());
+    member->resize(kGzipHeaderSize + bound + kGzipTrailerSize);
+    auto* out = reinterpret_cast<unsigned char*>(&(*member)[0]);
+    stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(block.data()));
+    stream.avail_in = block.size();
+    stream.next_out = out + kGzipHeaderSize;
+    stream.avail_out = bound;
+    int ret = deflate(&stream, Z_FINISH);
+    size_t size = kGzipHeaderSize + stream.total_out + kGzipTrailerSize;
+    deflateEnd(&stream);
+    if (ret != Z_STREAM_END) {
+      return false;
+    }
+    memcpy(out, kGzipHeader, sizeof(kGzipHeader));
+    PutUint32(out + 16, size);
+    PutUint32(out + size - 8,
+              crc32(0,
+                    reinterpret_cast<const Bytef*>(block.data()),
+                    block.size()));
+    PutUint32(out + size - 4, block.size());
+    member->resize(size);
+    return true;
+  }
+
+  bool WriteAll(const std::string& data) {
+    size_t done = 0;
+    while (done < data.size()) {
+      ssize_t n = write(_fd, data.data() + done, data.size() - done);
+      if (n < 0 && errno == EINTR) {
+        continue;
+      }
+      if (n < 0) {
+        LOG(WARNING) << "Failed to write file[" << _path
+                     << "]: " << strerror(errno);
+        _error = true;
+        return false;
+      }
+      done += n;
+    }
+    return true;
+  }
+
+  int _fd;
+  std::string _path;
+  OrderedBlocks _blocks;
+  std::string _block;
+  size_t _seq = 0;
+  std::atomic<bool> _error{false};
+  std::vector<std::thread> _workers;
+  std::thread _output;
+  std::mutex _task_mutex;
+  std::condition_variable _task_cond;
+  std::deque<std::pair<size_t, std::string>> _tasks;
+  bool _task_done = false;
+};
+
+ssize_t ReadGzip(void* cookie, char* buf, size_t size) {
+  return static_cast<GzipReader*>(cookie)->Read(buf, size);
+}
+
+int CloseGzipReader(void* cookie) {
+  auto* reader = static_cast<GzipReader*>(cookie);
+  int ret = reader->Failed() ? -1 : 0;
+  delete reader;
+  return ret;
+}
+
+ssize_t ReadInput(void* cookie, char* buf, size_t size) {
+  return static_cast<FdInput*>(cookie)->Read(buf, size);
+}
+
+int CloseInput(void* cookie) {
+  delete static_cast<FdInput*>(cookie);
+  return 0;
+}
+
+ssize_t WriteGzip(void* cookie, const char* buf, size_t size) {
+  return static_cast<GzipWriter*>(cookie)->Write(buf, size);
+}
+
+int CloseGzipWriter(void* cookie) {
+  auto* writer = static_cast<GzipWriter*>(cookie);
+  int ret = writer->Close();
+  delete writer;
+  return ret;
+}
+
+std::shared_ptr<FILE> NativeFile(FILE* fp, const std::string& path) {
+  if (fp == nullptr) {
+    return nullptr;
+  }
+  if (shell_verbose()) {
+    LOG(INFO) << "Opening file[" << path << "] in process";
+  }
+  return {fp, [path](FILE* fp) {
+            if (shell_verbose()) {
+              LOG(INFO) << "Closing file[" << path << "]";
+            }
+            if (0 != fclose(fp)) {
+              PADDLE_THROW(platform::errors::Unavailable(
+                  "Failed to close file, path[%s].", path));
+            }
+          }};
+}
+
+}  // namespace
+
+std::shared_ptr<FILE> native_fopen_read(const std::string& path,
+                                        int threads) {
+  int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    return nullptr;
+  }
+  FILE* fp = nullptr;
+  if (EndsWith(path, ".gz")) {
+    auto* reader = new GzipReader(fd, path, threads);
+    fp = fopencookie(
+        reader, "r", {ReadGzip, nullptr, nullptr, CloseGzipReader});
+    if (fp == nullptr) {
+      delete reader;
+    }
+  } else {
+    auto* input = new FdInput(fd, path);
+    fp = fopencookie(input, "r", {ReadInput, nullptr, nullptr, CloseInput});
+    if (fp == nullptr) {
+      delete input;
+    }
+  }
+  return NativeFile(fp, path);
+}
+
+std::shared_ptr<FILE> native_fopen_write(const std::string& path,
+                                         int threads) {
+  int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0666);
+  if (fd < 0) {
+    return nullptr;
+  }
+  FILE* fp = nullptr;
+  if (EndsWith(path, ".gz")) {
+    auto* writer = new GzipWriter(fd, path, threads);
+    fp = fopencookie(
+        writer, "w", {nullptr, WriteGzip, nullptr, CloseGzipWriter});
+    if (fp == nullptr) {
+      writer->Close();
+      delete writer;
+    }
+  } else {
+    fp = fdopen(fd, "w");
+    if (fp == nullptr) {
+      close(fd);
+    }
+  }
+  return NativeFile(fp, path);
+}
+
+#endif
+
+}  // namespace framework
+}  // namespace paddle
@@ -0,0 +1,48 @@
+// Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <stdio.h>
+
+#include <memory>
+#include <string>
+
+namespace paddle {
+namespace framework {
+
+// The local files opened in the process instead of a shell pipe. The .gz
+// files are (de)compressed with zlib, and the plain files are read with the
+// sequential readahead of the kernel.
+//
+// The .gz files are written as gzip members of kNativeGzipBlockSize bytes
+// each, which carry their compressed size in the "PD" extra field, so that
+// zcat reads them as usual and native_fopen_read inflates the members in
+// parallel. The other .gz files are inflated sequentially ahead of the reader.
+// A truncated or corrupted .gz file fails the fclose of the reader.
+//
+// `threads` is the number of the threads (de)compressing a file besides the
+// caller, 0 for the caller only. Both return nullptr if the file can not be
+// opened or the platform is not supported, and the caller falls back to the
+// shell pipe.
+static const size_t kNativeGzipBlockSize = 4UL << 20;
+
+extern std::shared_ptr<FILE> native_fopen_read(const std::string& path,
+                                               int threads);
+
+extern std::shared_ptr<FILE> native_fopen_write(const std::string& path,
+                                                int threads);
+
+}  // namespace framework
+}  // namespace paddle
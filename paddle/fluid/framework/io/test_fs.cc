@@ -60,3 +60,79 @@ TEST(FS, mv) {
 
 #endif
 }
+
+TEST(FS, native_gzip) {
+#ifdef _LINUX
+  std::string data;
+  for (int i = 0; i < 2000000; ++i) {
+    data += std::to_string(i * 7919L % 100003) + (i % 10 ? " " : "\n");
+  }
+  auto write = [&](const std::string& path) {
+    auto fp = paddle::framework::fs_open_write(path, nullptr, "");
+    ASSERT_EQ(fwrite(data.data(), 1, data.size(), &*fp), data.size());
+  };
+  auto read = [](const std::string& path, const std::string& converter) {
+    int err_no = 0;
+    auto fp = paddle::framework::fs_open_read(path, &err_no, converter);
+    std::string out;
+    char buf[65536];
+    size_t n = 0;
+    while ((n = fread(buf, 1, sizeof(buf), &*fp)) > 0) {
+      out.append(buf, n);
+    }
+    return out;
+  };
+
+  // the members of kNativeGzipBlockSize bytes are inflated in parallel, or
+  // one by one without the threads
+  write("native.gz");
+  EXPECT_TRUE(read("native.gz", "") == data);
+  paddle::framework::localfs_set_native_io_threads(0);
+  EXPECT_TRUE(read("native.gz", "cat") == data);
+  paddle::framework::localfs_set_native_io_threads(2);
+
+  // they are readable by zcat, and the files of gzip by the native reader
+  paddle::framework::localfs_set_native_io(false);
+  EXPECT_TRUE(read("native.gz", "") == data);
+  write("shell.gz");
+  paddle::framework::localfs_set_native_io(true);
+  EXPECT_TRUE(read("shell.gz", "") == data);
+  paddle::framework::localfs_set_native_io_threads(0);
+  EXPECT_TRUE(read("shell.gz", "") == data);
+  paddle::framework::localfs_set_native_io_threads(2);
+
+  // the concatenated gzip files and the plain files
+  paddle::framework::shell_execute("cat native.gz shell.gz > concat.gz");
+  EXPECT_TRUE(read("concat.gz", "") == data + data);
+  std::ofstream("plain.txt") << data;
+  EXPECT_TRUE(read("plain.txt", "cat") == data);
+
+  // a truncated file fails at close instead of ending early, both of the
+  // members and of the other gzip files
+  paddle::framework::shell_execute("head -c 100000 native.gz > truncated.gz");
+  EXPECT_DEATH(read("truncated.gz", ""), "Failed to close file");
+  paddle::framework::localfs_set_native_io_threads(0);
+  EXPECT_DEATH(read("truncated.gz", ""), "Failed to close file");
+  paddle::framework::localfs_set_native_io_threads(2);
+  paddle::framework::shell_execute("head -c 100000 shell.gz > truncated.gz");
+  EXPECT_DEATH(read("truncated.gz", ""), "Failed to close file");
+
+  // a corrupted byte fails the crc check or the inflation
+  paddle::framework::shell_execute(
+      "cp native.gz corrupted.gz && printf x | "
+      "dd of=corrupted.gz bs=1 seek=100000 conv=notrunc 2>/dev/null");
+  EXPECT_DEATH(read("corrupted.gz", ""), "Failed to close file");
+
+  // an empty file is read as empty
+  data.clear();
+  write("empty.gz");
+  EXPECT_TRUE(read("empty.gz", "").empty());
+  paddle::framework::localfs_remove("native.gz");
+  paddle::framework::localfs_remove("shell.gz");
+  paddle::framework::localfs_remove("concat.gz");
+  paddle::framework::localfs_remove("plain.txt");
+  paddle::framework::localfs_remove("empty.gz");
+  paddle::framework::localfs_remove("truncated.gz");
+  paddle::framework::localfs_remove("corrupted.gz");
+#endif
+}
@@ -32,7 +32,8 @@ class SubGraph;
 
 class CodeGenerator {
  public:
-  CodeGenerator();
+  // Generate the CUDA kernels, or the C++ ones for CPUDeviceCode if is_cpu.
+  explicit CodeGenerator(bool is_cpu = false);
 
   std::string Generate(std::string func_name,
                        const std::vector<OperationExpression>& expressions);
@@ -69,6 +70,7 @@ class CodeGenerator {
   std::unordered_map<Node*, int> EncodeVarNodes(SubGraph* subgraph);
 
  private:
+  bool is_cpu_{false};
   std::vector<CodeTemplate> code_templates_;
 };
 
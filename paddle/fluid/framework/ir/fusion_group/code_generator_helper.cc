@@ -171,8 +171,12 @@ std::string OperationExpression::GetRHS(std::unordered_set<int>* used,
         length++;
       }
       std::string number_str = rhs.substr(pos + 2, length);
+      // Cast the double literals, so that the float expressions are not
+      // promoted to double.
       if (rhs_type_ == "__half")
         number_str = "__float2half(" + number_str + ")";
+      else if (rhs_type_ == "float")
+        number_str = "static_cast<float>(" + number_str + ")";
       rhs.replace(pos, length + 3, number_str);
       pos = pos + number_str.length();
     }
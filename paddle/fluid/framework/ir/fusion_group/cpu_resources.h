@@ -0,0 +1,90 @@
+/* Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#pragma once
+
+namespace paddle {
+namespace framework {
+namespace ir {
+namespace fusion_group {
+
+static constexpr char predefined_cpu_headers[] = R"(
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+
+)";
+
+// Exp of float is vectorized without -ffast-math, which would enable FTZ/DAZ
+// in the process loading the shared object. It is within 2 ulp of expf, and
+// the same as expf for inf, nan and the denormal results:
+//   exp(x) = 2^k * exp(r), r = x - k * ln2
+// where exp(r) is the polynomial of Cephes, and 2^k is split into two factors
+// of the normal range.
+static constexpr char predefined_cpu_functions_fp32[] = R"(
+static inline float Max(float x, float y) { return fmaxf(x, y); }
+static inline float Exp(float x) {
+  float xc = x == x ? x : 0.0f;
+  xc = xc < -104.0f ? -104.0f : xc;
+  xc = xc > 89.0f ? 89.0f : xc;
+  // rounds to the nearest integer by the addition of 1.5 * 2^23
+  float fk = xc * 1.44269504088896341f + 12582912.0f;
+  fk -= 12582912.0f;
+  int32_t k = static_cast<int32_t>(fk);
+  float r = xc - fk * 0.693359375f + fk * 2.12194440e-4f;
+  float p = 1.9875691500e-4f;
+  p = p * r + 1.3981999507e-3f;
+  p = p * r + 8.3334519073e-3f;
+  p = p * r + 4.1665795894e-2f;
+  p = p * r + 1.6666665459e-1f;
+  p = p * r + 5.0000001201e-1f;
+  p = p * r * r + r + 1.0f;
+  int32_t k1 = k >> 1;
+  int32_t bits1 = (k1 + 127) << 23;
+  int32_t bits2 = (k - k1 + 127) << 23;
+  float s1, s2;
+  memcpy(&s1, &bits1, sizeof(s1));
+  memcpy(&s2, &bits2, sizeof(s2));
+  float y = p * s1 * s2;
+  return x == x ? y : x;
+}
+static inline float Log(float x) { return logf(x); }
+static inline float Sqrt(float x) { return sqrtf(x); }
+
+)";
+
+static constexpr char predefined_cpu_functions_fp64[] = R"(
+static inline double Max(double x, double y) { return fmax(x, y); }
+static inline double Exp(double x) { return exp(x); }
+static inline double Log(double x) { return log(x); }
+static inline double Sqrt(double x) { return sqrt(x); }
+
+)";
+
+// The elements in [begin, end) are computed in a loop vectorized by the
+// compiler, and the range is split among the threads by CPUDeviceCode.
+static constexpr char cpu_kernel_template_1d[] = R"(
+extern "C" void $func_name(int64_t begin, int64_t end, void** args) {
+  $parameters
+#pragma omp simd
+  for (int64_t idx = begin; idx < end; ++idx) {
+    $compute_body
+  }
+}
+)";
+
+}  // namespace fusion_group
+}  // namespace ir
+}  // namespace framework
+}  // namespace paddle
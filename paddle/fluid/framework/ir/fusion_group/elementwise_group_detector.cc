@@ -74,7 +74,7 @@ bool GroupDetector::CheckPrecondition(const Node* n) {
         proto::VarType::Type data_type_i = n->Var()->GetDataType();
         if (data_type_i == proto::VarType::FP32 ||
             data_type_i == proto::VarType::FP64 ||
-            data_type_i == proto::VarType::FP16) {
+            (data_type_i == proto::VarType::FP16 && !is_cpu_)) {
           if (is_first) {
             data_type_0 = data_type_i;
             is_first = false;
@@ -105,7 +105,7 @@ bool GroupDetector::CheckPrecondition(const Node* n) {
     return false;
   };
 
-  return n && n->IsOp() && n->Op() && !check_running_on_cpu(n) &&
+  return n && n->IsOp() && n->Op() && (is_cpu_ || !check_running_on_cpu(n)) &&
          check_data_type(n->inputs) && check_data_type(n->outputs);
 }
 
@@ -35,10 +35,15 @@ namespace fusion_group {
 class GroupDetector {
  protected:
   bool CheckPrecondition(const Node* n);
+
+  // Detect the groups for CPUDeviceCode, which does not support FP16.
+  bool is_cpu_{false};
 };
 
 class ElementwiseGroupDetector : GroupDetector {
  public:
+  explicit ElementwiseGroupDetector(bool is_cpu = false) { is_cpu_ = is_cpu; }
+
   std::vector<std::vector<Node*>> operator()(Graph* graph);
 
  private:
@@ -34,7 +34,9 @@ class Node;
 
 void FusionGroupPass::ApplyImpl(ir::Graph* graph) const {
   FusePassBase::Init("fusion_group_pass", graph);
+  platform::Place place = platform::CPUPlace();
   if (Get<bool>("use_gpu")) {
+#if defined(PADDLE_WITH_CUDA) || defined(PADDLE_WITH_HIP)
     // TODO(liuyiqun): open this check.
     // if (!platform::CUDADeviceCode::IsAvailable()) {
     //   LOG(WARNING)
@@ -42,22 +44,34 @@ void FusionGroupPass::ApplyImpl(ir::Graph* graph) const {
     //       avaiable.";
     //   return 0;
     // }
-
-    fusion_group::OperationMap::Init();
-    int num_elementwise_groups = DetectFusionGroup(graph, 0);
-    AddStatis(num_elementwise_groups);
-    LOG(INFO) << "Detect " << num_elementwise_groups
-              << " elementwise fusion groups.";
+    place = platform::CUDAPlace(0);
+#else
+    return;
+#endif
+  } else {
+    platform::DeviceCodePool::Init({place});
+    if (!platform::CPUDeviceCode::IsAvailable()) {
+      LOG(WARNING) << "Disable fusion_group on CPU because the compiler is "
+                      "not available.";
+      return;
+    }
   }
+
+  fusion_group::OperationMap::Init();
+  int num_elementwise_groups = DetectFusionGroup(graph, place, 0);
+  AddStatis(num_elementwise_groups);
+  LOG(INFO) << "Detect " << num_elementwise_groups
+            << " elementwise fusion groups.";
 }
 
-int FusionGroupPass::DetectFusionGroup(Graph* graph, int type) const {
-  // TODO(liuyiqun): supported different places
-  platform::CUDAPlace place = platform::CUDAPlace(0);
+int FusionGroupPass::DetectFusionGroup(Graph* graph,
+                                       const platform::Place& place,
+                                       int type) const {
   int index = platform::DeviceCodePool::Init({place}).size(place);
 
   std::vector<std::vector<Node*>> subgraphs =
-      fusion_group::ElementwiseGroupDetector()(graph);
+      fusion_group::ElementwiseGroupDetector(platform::is_cpu_place(place))(
+          graph);
 
   int num_subgraphs = 0;
   size_t min_subgraph_size = 2;
@@ -72,7 +86,7 @@ int FusionGroupPass::DetectFusionGroup(Graph* graph, int type) const {
 
     if (subgraph.IsValid(min_subgraph_size)) {
       subgraph.SetFuncName("fused_elementwise_" + std::to_string(index++));
-      if (GenerateCode(&subgraph)) {
+      if (GenerateCode(&subgraph, place)) {
         InsertFusionGroupOp(graph, &subgraph);
         num_subgraphs++;
       }
@@ -81,16 +95,24 @@ int FusionGroupPass::DetectFusionGroup(Graph* graph, int type) const {
   return num_subgraphs;
 }
 
-bool FusionGroupPass::GenerateCode(fusion_group::SubGraph* subgraph) const {
-  fusion_group::CodeGenerator code_generator;
+bool FusionGroupPass::GenerateCode(fusion_group::SubGraph* subgraph,
+                                   const platform::Place& place) const {
+  bool is_cpu = platform::is_cpu_place(place);
+  fusion_group::CodeGenerator code_generator(is_cpu);
   std::string code_str = code_generator.Generate(subgraph);
   VLOG(4) << code_str;
 
-  // TODO(liuyiqun): supported different places
-  platform::CUDAPlace place = platform::CUDAPlace(0);
-  std::unique_ptr<platform::CUDADeviceCode> device_code(
-      new platform::CUDADeviceCode(place, subgraph->GetFuncName(), code_str));
-  bool is_compiled = device_code->Compile();
+  std::unique_ptr<platform::DeviceCode> device_code;
+  if (is_cpu) {
+    device_code.reset(new platform::CPUDeviceCode(
+        place, subgraph->GetFuncName(), code_str));
+  } else {
+#if defined(PADDLE_WITH_CUDA) || defined(PADDLE_WITH_HIP)
+    device_code.reset(new platform::CUDADeviceCode(
+        place, subgraph->GetFuncName(), code_str));
+#endif
+  }
+  bool is_compiled = device_code && device_code->Compile();
   if (is_compiled) {
     platform::DeviceCodePool& pool = platform::DeviceCodePool::Init({place});
     pool.Set(std::move(device_code));
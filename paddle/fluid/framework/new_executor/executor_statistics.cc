@@ -14,6 +14,7 @@
 
 #include "paddle/fluid/framework/new_executor/executor_statistics.h"
 
+#include <atomic>
 #include <fstream>
 #include <functional>
 #include <map>
@@ -24,6 +25,7 @@
 #include <vector>
 
 #include "glog/logging.h"
+#include "paddle/fluid/framework/new_executor/workqueue/thread_data_registry.h"
 #include "paddle/fluid/platform/flags.h"
 #include "paddle/fluid/platform/os_info.h"
 #include "paddle/fluid/platform/profiler/utils.h"
@@ -611,6 +613,22 @@ void StatisticsEngine::Log(const std::string& filepath) {
                                    evt_stat.count,
                                    evt_stat.normalization_time);
   }
+  uint64_t hit_num = 0;
+  uint64_t miss_num = 0;
+  GetInferShapeCacheStatistics(&hit_num, &miss_num);
+  if (hit_num + miss_num > 0) {
+    ofs << platform::string_format(std::string(R"JSON(
+  {
+    "statistical item" : "InferShapeCache",
+    "hit number" : %llu,
+    "miss number" : %llu,
+    "hit rate" : %.4f
+  },)JSON"),
+                                   hit_num,
+                                   miss_num,
+                                   static_cast<double>(hit_num) /
+                                       (hit_num + miss_num));
+  }
   ofs.seekp(-1, std::ios_base::end);
   ofs << "]";
   if (ofs) {
@@ -619,6 +637,40 @@ void StatisticsEngine::Log(const std::string& filepath) {
   ofs.close();
 }
 
+struct InferShapeCacheCounter {
+  std::atomic<uint64_t> hit_num{0};
+  std::atomic<uint64_t> miss_num{0};
+};
+
+using InferShapeCacheCounterRegistry =
+    ThreadDataRegistry<InferShapeCacheCounter>;
+
+void RecordInferShapeCacheLookup(bool hit) {
+  auto* counter = InferShapeCacheCounterRegistry::GetInstance()
+                      .GetMutableCurrentThreadData();
+  auto& num = hit ? counter->hit_num : counter->miss_num;
+  num.store(num.load(std::memory_order_relaxed) + 1,
+            std::memory_order_relaxed);
+}
+
+void GetInferShapeCacheStatistics(uint64_t* hit_num, uint64_t* miss_num) {
+  *hit_num = 0;
+  *miss_num = 0;
+  for (auto& kv : InferShapeCacheCounterRegistry::GetInstance()
+                      .GetAllThreadDataByRef()) {
+    *hit_num += kv.second.get().hit_num.load(std::memory_order_relaxed);
+    *miss_num += kv.second.get().miss_num.load(std::memory_order_relaxed);
+  }
+}
+
+void ResetInferShapeCacheStatistics() {
+  for (auto& kv : InferShapeCacheCounterRegistry::GetInstance()
+                      .GetAllThreadDataByRef()) {
+    kv.second.get().hit_num = 0;
+    kv.second.get().miss_num = 0;
+  }
+}
+
 void StaticGraphExecutorPerfStatistics(
     std::shared_ptr<const platform::NodeTrees> profiling_data) {
   if (FLAGS_static_executor_perfstat_filepath.size() == 0) {
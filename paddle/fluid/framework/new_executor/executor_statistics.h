@@ -14,6 +14,7 @@
 
 #pragma once
 
+#include <cstdint>
 #include <memory>
 
 #include "paddle/fluid/platform/profiler/event_node.h"
@@ -24,5 +25,14 @@ namespace framework {
 void StaticGraphExecutorPerfStatistics(
     std::shared_ptr<const platform::NodeTrees> profiling_data);
 
+// The hit and miss numbers of the infer shape cache of the standalone
+// executor, see FLAGS_new_executor_use_infer_shape_cache. They are counted by
+// thread and summed up when read.
+void RecordInferShapeCacheLookup(bool hit);
+
+void GetInferShapeCacheStatistics(uint64_t* hit_num, uint64_t* miss_num);
+
+void ResetInferShapeCacheStatistics();
+
 }  // namespace framework
 }  // namespace paddle
@@ -14,10 +14,15 @@
 
 #include "paddle/fluid/framework/new_executor/interpretercore.h"
 
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <thread>  // NOLINT
+#include <unordered_map>
 #include <unordered_set>
 
 #include "paddle/fluid/framework/details/nan_inf_utils.h"
 #include "paddle/fluid/framework/details/share_tensor_buffer_functor.h"
+#include "paddle/fluid/framework/new_executor/executor_statistics.h"
 #include "paddle/fluid/framework/new_executor/garbage_collector/event_garbage_collector.h"
 #include "paddle/fluid/framework/new_executor/garbage_collector/fast_garbage_collector.h"
 #include "paddle/fluid/framework/new_executor/interpretercore_util.h"
@@ -38,6 +43,29 @@ PADDLE_DEFINE_EXPORTED_bool(new_executor_use_local_scope,
                             true,
                             "Use local_scope in new executor(especially used "
                             "in UT), can turn off for better performance");
+PADDLE_DEFINE_EXPORTED_bool(
+    new_executor_use_priority_schedule,
+    false,
+    "Dispatch the ready ops of new executor by the length of their critical "
+    "path (weighted by the op time measured in the first step) instead of "
+    "the dependency order, helps the wide graphs like multi-tower models.");
+PADDLE_DEFINE_EXPORTED_bool(
+    new_executor_use_infer_shape_cache,
+    false,
+    "Cache the output shapes of InferShape by the input shapes in new "
+    "executor, and skip InferShape when the input shapes are the same as "
+    "a cached one.");
+PADDLE_DEFINE_EXPORTED_bool(
+    new_executor_use_frozen_plan,
+    false,
+    "Freeze the run order of every thread and the kernel contexts of new "
+    "executor after the feed shapes keep unchanged for "
+    "new_executor_frozen_plan_warmup_steps steps, then replay them with "
+    "less synchronization. It falls back when the feed shapes change.");
+PADDLE_DEFINE_EXPORTED_int32(new_executor_frozen_plan_warmup_steps,
+                             3,
+                             "The steps with unchanged feed shapes before "
+                             "new executor freezes the plan.");
 
 DECLARE_bool(check_nan_inf);
 DECLARE_bool(benchmark);
@@ -152,7 +180,7 @@ paddle::framework::FetchList InterpreterCore::Run(
     // create work_queue, so the async_work_queue_ is created
     // until the second step run.
     async_work_queue_ = GetWorkQueue();
-    ExecuteInstructionList(vec_instruction_);
+    ExecuteStep(feed_names);
 #ifdef PADDLE_WITH_ASCEND_CL
     platform::DeviceContextPool::Instance().Get(place_)->Wait();
 #endif
@@ -196,7 +224,7 @@ paddle::framework::FetchList InterpreterCore::Run(
     // until the second step run.
     async_work_queue_ = GetWorkQueue();
 
-    ExecuteInstructionList(vec_instruction_);
+    ExecuteStep(feed_names);
 #ifdef PADDLE_WITH_ASCEND_CL
     platform::DeviceContextPool::Instance().Get(place_)->Wait();
 #endif
@@ -344,6 +372,10 @@ void InterpreterCore::BuildOperatorDependences() {
       dependecy_count_[inst_id]++;
     }
   }
+
+  // every op costs 1 before the op time is measured
+  instr_priority_ = interpreter::build_op_critical_path_priority(
+      vec_instruction_, std::vector<double>(op_nums, 1.0));
 }
 
 // At the end of each step, the holder of Tensor in LoDTensorArray is null.
@@ -471,6 +503,11 @@ void InterpreterCore::Convert(
 
   for (size_t i = 0; i < vec_instruction_.size(); ++i) {
     BuildAndCacheInstructionCtx(&vec_instruction_[i]);
+    if (dynamic_cast<const framework::OperatorWithKernel*>(
+            vec_instruction_[i].OpBase()) != nullptr) {
+      vec_instruction_[i].SetInferShapeCache(
+          std::make_shared<InferShapeCache>());
+    }
   }
 
   BuildSkipShareLoDInfo();
@@ -560,8 +597,21 @@ void InterpreterCore::RunInstruction(const Instruction& instr_node) {
       // see OperatorWithKernel::RunImpl in operator.cc for why
       if (!(op_with_kernel->HasAttr(kAllKernelsMustComputeRuntimeShape) &&
             op_with_kernel->Attr<bool>(kAllKernelsMustComputeRuntimeShape))) {
-        op_with_kernel->Info().infer_shape_(
-            instr_node.InnerInferShapeContext().get());
+        auto* infer_shape_cache = FLAGS_new_executor_use_infer_shape_cache
+                                      ? instr_node.GetInferShapeCache()
+                                      : nullptr;
+        bool hit = false;
+        if (infer_shape_cache != nullptr && !infer_shape_cache->Disabled()) {
+          hit = infer_shape_cache->Lookup(*instr_node.InnerRuntimeContext());
+          RecordInferShapeCacheLookup(hit);
+        }
+        if (!hit) {
+          op_with_kernel->Info().infer_shape_(
+              instr_node.InnerInferShapeContext().get());
+          if (infer_shape_cache != nullptr) {
+            infer_shape_cache->Insert(*instr_node.InnerRuntimeContext());
+          }
+        }
       }
       infershape_event.End();
       platform::RecordOpInfoSupplement(op->Type(),
@@ -593,7 +643,10 @@ void InterpreterCore::RunInstruction(const Instruction& instr_node) {
       instr_node.OpBase()->Run(*local_scope, place_);
     } else {
       // fit for phi
-      if (instr_node.PhiKernel() && instr_node.PhiKernel()->IsValid()) {
+      if (instr_node.FrozenKernelContext() != nullptr) {
+        VLOG(4) << "Run phi kernel with bound context: " << op->Type();
+        (*instr_node.PhiKernel())(instr_node.FrozenKernelContext());
+      } else if (instr_node.PhiKernel() && instr_node.PhiKernel()->IsValid()) {
         VLOG(4) << "Run phi kernel: " << op->Type();
         VLOG(4) << instr_node.InnerRuntimeContext().get() << " "
                 << &instr_node.DeviceContext();
@@ -672,16 +725,27 @@ void InterpreterCore::ExecuteInstructionList(
 
   exception_holder_.Clear();
 
+  use_priority_schedule_ = FLAGS_new_executor_use_priority_schedule;
+  if (measure_instr_cost_) {
+    // the op time of last step is measured, all the ops have finished so it
+    // is safe to rebuild the priorities here
+    measure_instr_cost_ = false;
+    instr_cost_measured_ = true;
+    instr_priority_ = interpreter::build_op_critical_path_priority(
+        vec_instruction_, instr_cost_);
+    VLOG(4) << "Rebuild the critical path priority by the measured op time, "
+               "the longest path costs "
+            << *std::max_element(instr_priority_.begin(),
+                                 instr_priority_.end())
+            << "us";
+  } else if (use_priority_schedule_ && !instr_cost_measured_) {
+    measure_instr_cost_ = true;
+    instr_cost_.assign(vec_instr.size(), 0.0);
+  }
+
   for (size_t i = 0; i < dependecy_count_.size(); ++i) {
     if (dependecy_count_[i] == 0) {
-      async_work_queue_->AddTask(vec_instr.at(i).KernelType(),
-                                 [this,
-                                  i,
-                                  atomic_deps = atomic_deps.get(),
-                                  atomic_var_ref = atomic_var_ref.get()] {
-                                   RunInstructionAsync(
-                                       i, atomic_deps, atomic_var_ref);
-                                 });
+      AddInstructionTask(i, atomic_deps.get(), atomic_var_ref.get());
     }
   }
 
@@ -707,6 +771,23 @@ void InterpreterCore::ExecuteInstructionList(
   }
 }
 
+void InterpreterCore::AddInstructionTask(
+    size_t instr_id,
+    std::vector<std::atomic<size_t>>* atomic_deps,
+    std::vector<std::atomic<size_t>>* atomic_var_ref) {
+  auto fn = [this, instr_id, atomic_deps, atomic_var_ref]() {
+    RunInstructionAsync(instr_id, atomic_deps, atomic_var_ref);
+  };
+  if (use_priority_schedule_) {
+    async_work_queue_->AddPriorityTask(vec_instruction_[instr_id].KernelType(),
+                                       instr_priority_[instr_id],
+                                       std::move(fn));
+  } else {
+    async_work_queue_->AddTask(vec_instruction_[instr_id].KernelType(),
+                               std::move(fn));
+  }
+}
+
 void InterpreterCore::RunNextInstructions(
     const Instruction& instr,
     std::queue<size_t>* reserved_next_ops,
@@ -722,59 +803,108 @@ void InterpreterCore::RunNextInstructions(
             << ", remain deps: " << (*atomic_deps)[next_id];
     return (*atomic_deps)[next_id].fetch_sub(1, std::memory_order_relaxed) == 1;
   };
+  // the ops run in current thread are taken by the critical path priority
+  auto SortByPriority = [this](std::vector<size_t>* ready_ops) {
+    if (use_priority_schedule_ && ready_ops->size() > 1) {
+      std::stable_sort(ready_ops->begin(),
+                       ready_ops->end(),
+                       [this](size_t a, size_t b) {
+                         return instr_priority_[a] > instr_priority_[b];
+                       });
+    }
+  };
 
   if (instr.KernelType() == OpFuncType::kQueueAsync) {
     // move all sync_ops into other threads
     for (auto next_id : next_instr.SyncRunIds()) {
       if (IsReady(next_id)) {
-        async_work_queue_->AddTask(
-            vec_instruction_[next_id].KernelType(),
-            [this, next_id, atomic_deps, atomic_var_ref]() {
-              RunInstructionAsync(next_id, atomic_deps, atomic_var_ref);
-            });
+        AddInstructionTask(next_id, atomic_deps, atomic_var_ref);
       }
     }
     // keep all async_ops running in current thread
+    std::vector<size_t> ready_ops;
     for (auto next_id : next_instr.DirectRunIds()) {
       if (IsReady(next_id)) {
-        reserved_next_ops->push(next_id);
+        ready_ops.push_back(next_id);
       }
     }
     for (auto next_id : next_instr.EventRunIds()) {
       if (IsReady(next_id)) {
-        reserved_next_ops->push(next_id);
+        ready_ops.push_back(next_id);
       }
     }
+    SortByPriority(&ready_ops);
+    for (auto next_id : ready_ops) {
+      reserved_next_ops->push(next_id);
+    }
   } else {
     // move async_ops into async_thread
     for (auto next_id : next_instr.EventRunIds()) {
       if (IsReady(next_id)) {
-        async_work_queue_->AddTask(
-            vec_instruction_[next_id].KernelType(),
-            [this, next_id, atomic_deps, atomic_var_ref] {
-              RunInstructionAsync(next_id, atomic_deps, atomic_var_ref);
-            });
+        AddInstructionTask(next_id, atomic_deps, atomic_var_ref);
       }
     }
     auto direct_run_ops = interpreter::merge_vector(next_instr.SyncRunIds(),
                                                     next_instr.DirectRunIds());
-    size_t first_op = 0;
+    std::vector<size_t> ready_ops;
     for (auto next_id : direct_run_ops) {
       if (IsReady(next_id)) {
-        // only keep one op running in current thread
-        if (first_op == 0) {
-          first_op = next_id;
-          continue;
-        }
-        // move rest ops into other threads
-        async_work_queue_->AddTask(
-            vec_instruction_[next_id].KernelType(),
-            [this, next_id, atomic_deps, atomic_var_ref] {
-              RunInstructionAsync(next_id, atomic_deps, atomic_var_ref);
-            });
+        ready_ops.push_back(next_id);
       }
     }
-    if (first_op != 0) reserved_next_ops->push(first_op);
+    SortByPriority(&ready_ops);
+    // only keep one op running in current thread, move rest ops into other
+    // threads
+    for (size_t i = 1; i < ready_ops.size(); ++i) {
+      AddInstructionTask(ready_ops[i], atomic_deps, atomic_var_ref);
+    }
+    if (!ready_ops.empty()) reserved_next_ops->push(ready_ops[0]);
+  }
+}
+
+void InterpreterCore::RunInstructionWithGuard(
+    const Instruction& instr_node,
+    std::vector<std::atomic<size_t>>* atomic_var_ref) {
+  size_t instr_id = instr_node.Id();
+  auto* op = instr_node.OpBase();
+  platform::RecordEvent instruction_event(
+      op->Type(), platform::TracerEventType::Operator, 1);
+
+  try {
+    std::chrono::steady_clock::time_point start;
+    if (UNLIKELY(measure_instr_cost_)) {
+      start = std::chrono::steady_clock::now();
+    }
+    interpreter::WaitEvent(instr_node, place_);
+
+    RunInstruction(instr_node);
+    if (UNLIKELY(measure_instr_cost_)) {
+      // each op writes its own slot
+      instr_cost_[instr_id] =
+          std::chrono::duration<double, std::micro>(
+              std::chrono::steady_clock::now() - start)
+              .count();
+    }
+
+#if defined(PADDLE_WITH_CUDA) || defined(PADDLE_WITH_HIP)
+    RecordStreamForGC(instr_node);
+#endif
+    CheckGC(instr_node, atomic_var_ref);
+
+    interpreter::RecordEvent(instr_node, place_);
+  } catch (platform::EnforceNotMet& ex) {
+    framework::InsertCallStackInfo(op->Type(), op->Attrs(), &ex);
+    exception_holder_.Catch(std::make_exception_ptr(std::move(ex)));
+  } catch (platform::EOFException&) {
+    exception_holder_.Catch(std::current_exception());
+  } catch (std::exception& ex) {
+    LOG(WARNING) << op->Type() << " raises an exception "
+                 << platform::demangle(typeid(ex).name()) << ", "
+                 << ex.what();
+    exception_holder_.Catch(std::current_exception());
+  } catch (...) {
+    LOG(WARNING) << op->Type() << " raises an unknown exception";
+    exception_holder_.Catch(std::current_exception());
   }
 }
 
@@ -795,36 +925,13 @@ void InterpreterCore::RunInstructionAsync(
                     : "kQueueAsync")
             << " runs on " << platform::GetCurrentThreadName();
 
-    auto* op = instr_node.OpBase();
-    platform::RecordEvent instruction_event(
-        op->Type(), platform::TracerEventType::Operator, 1);
-
-    try {
-      interpreter::WaitEvent(instr_node, place_);
-
-      RunInstruction(instr_node);
-
-#if defined(PADDLE_WITH_CUDA) || defined(PADDLE_WITH_HIP)
-      RecordStreamForGC(instr_node);
-#endif
-      CheckGC(instr_node, atomic_var_ref);
-
-      interpreter::RecordEvent(instr_node, place_);
-    } catch (platform::EnforceNotMet& ex) {
-      framework::InsertCallStackInfo(op->Type(), op->Attrs(), &ex);
-      exception_holder_.Catch(std::make_exception_ptr(std::move(ex)));
-    } catch (platform::EOFException&) {
-      exception_holder_.Catch(std::current_exception());
-    } catch (std::exception& ex) {
-      LOG(WARNING) << op->Type() << " raises an exception "
-                   << platform::demangle(typeid(ex).name()) << ", "
-                   << ex.what();
-      exception_holder_.Catch(std::current_exception());
-    } catch (...) {
-      LOG(WARNING) << op->Type() << " raises an unknown exception";
-      exception_holder_.Catch(std::current_exception());
+    if (UNLIKELY(record_run_order_)) {
+      instr_run_seq_[instr_id] = run_seq_.fetch_add(1);
+      instr_run_thread_[instr_id] = std::this_thread::get_id();
     }
 
+    RunInstructionWithGuard(instr_node, atomic_var_ref);
+
     if (UNLIKELY(exception_holder_.IsCaught())) {
       VLOG(4) << "Exception caught";
       if (exception_notifier_ != nullptr) {
@@ -845,6 +952,305 @@ void InterpreterCore::RunInstructionAsync(
   }
 }
 
+// the dims and the lod level sizes of the feeds, the lod offsets are left
+// out since InferShape still runs on every step of the frozen plan
+std::vector<int64_t> InterpreterCore::FeedSignature(
+    const std::vector<std::string>& feed_names) const {
+  std::vector<int64_t> signature;
+  for (auto& feed_name : feed_names) {
+    signature.push_back(
+        static_cast<int64_t>(std::hash<std::string>()(feed_name)));
+    auto* feed_var = local_scope_->FindVar(feed_name);
+    if (feed_var != nullptr && feed_var->IsType<LoDTensor>()) {
+      auto& feed_tensor = feed_var->Get<LoDTensor>();
+      auto dims = feed_tensor.dims();
+      signature.push_back(dims.size());
+      for (int i = 0; i < dims.size(); ++i) {
+        signature.push_back(dims[i]);
+      }
+      signature.push_back(feed_tensor.lod().size());
+      for (auto& level : feed_tensor.lod()) {
+        signature.push_back(level.size());
+      }
+    } else {
+      signature.push_back(-1);
+    }
+  }
+  return signature;
+}
+
+void InterpreterCore::ExecuteStep(const std::vector<std::string>& feed_names) {
+  if (!FLAGS_new_executor_use_frozen_plan) {
+    if (!frozen_lanes_.empty()) {
+      UnfreezePlan();
+    }
+    ExecuteInstructionList(vec_instruction_);
+    return;
+  }
+
+  auto signature = FeedSignature(feed_names);
+  if (!frozen_lanes_.empty()) {
+    if (signature == plan_feed_signature_) {
+      RunFrozenPlan();
+      return;
+    }
+    VLOG(1) << "The feed shapes change, fall back from the frozen plan.";
+    UnfreezePlan();
+  }
+  if (signature != plan_feed_signature_) {
+    plan_feed_signature_ = signature;
+    plan_stable_steps_ = 0;
+  }
+  // the last warm-up step records the run order of every thread
+  record_run_order_ =
+      ++plan_stable_steps_ >=
+      static_cast<size_t>(FLAGS_new_executor_frozen_plan_warmup_steps);
+  if (record_run_order_) {
+    instr_run_seq_.assign(vec_instruction_.size(), 0);
+    instr_run_thread_.assign(vec_instruction_.size(), std::thread::id());
+    run_seq_ = 0;
+  }
+  ExecuteInstructionList(vec_instruction_);
+  if (record_run_order_) {
+    record_run_order_ = false;
+    FreezePlan();
+  }
+}
+
+// The phi kernel context only holds the pointers of tensors, so it is bound
+// once when the variables are all LoDTensor or SelectedRows, and no attribute
+// is read from the input tensors.
+static bool CanBindKernelContext(const Instruction& instr) {
+  auto* op_with_kernel =
+      dynamic_cast<const framework::OperatorWithKernel*>(instr.OpBase());
+  if (op_with_kernel == nullptr || instr.PhiKernel() == nullptr ||
+      !instr.PhiKernel()->IsValid() ||
+      op_with_kernel->PhiKernelSignature() == nullptr) {
+    return false;
+  }
+  auto IsBindable = [](const VariableValueMap& var_map, bool allow_null) {
+    for (auto& item : var_map) {
+      for (auto* var : item.second) {
+        if (var == nullptr) {
+          if (!allow_null) return false;
+          continue;
+        }
+        if (!var->IsInitialized() ||
+            !(var->IsType<LoDTensor>() || var->IsType<phi::SelectedRows>())) {
+          return false;
+        }
+      }
+    }
+    return true;
+  };
+  if (!IsBindable(instr.InnerRuntimeContext()->inputs, false) ||
+      !IsBindable(instr.InnerRuntimeContext()->outputs, true)) {
+    return false;
+  }
+  for (auto& attr_name : op_with_kernel->PhiKernelSignature()->attr_names) {
+    if (!op_with_kernel->HasAttr(attr_name)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void InterpreterCore::FreezePlan() {
+  size_t op_num = vec_instruction_.size();
+  // the ops run by the same thread form a lane, in the order they started
+  std::unordered_map<std::thread::id, size_t> thread2lane;
+  frozen_lanes_.clear();
+  for (size_t i = 0; i < op_num; ++i) {
+    auto iter = thread2lane.emplace(instr_run_thread_[i], frozen_lanes_.size());
+    if (iter.second) {
+      frozen_lanes_.emplace_back();
+    }
+    frozen_lanes_[iter.first->second].push_back(i);
+  }
+  auto RunBefore = [this](size_t a, size_t b) {
+    return instr_run_seq_[a] < instr_run_seq_[b];
+  };
+  for (auto& lane : frozen_lanes_) {
+    std::sort(lane.begin(), lane.end(), RunBefore);
+  }
+  auto Longer = [](const std::vector<size_t>& a, const std::vector<size_t>& b) {
+    return a.size() > b.size();
+  };
+  // Every lane needs its own thread since it spins on the other lanes, so
+  // the shortest lanes are merged when they are more than the host threads
+  // plus the calling thread. A merged lane keeps the recorded order, then
+  // the op started first among the unfinished ones can always run and the
+  // replay never deadlocks.
+  while (frozen_lanes_.size() > kHostNumThreads + 1) {
+    std::sort(frozen_lanes_.begin(), frozen_lanes_.end(), Longer);
+    auto& last = frozen_lanes_[frozen_lanes_.size() - 1];
+    auto& second = frozen_lanes_[frozen_lanes_.size() - 2];
+    std::vector<size_t> merged(last.size() + second.size());
+    std::merge(second.begin(),
+               second.end(),
+               last.begin(),
+               last.end(),
+               merged.begin(),
+               RunBefore);
+    second.swap(merged);
+    frozen_lanes_.pop_back();
+  }
+  // the calling thread runs the longest lane
+  std::sort(frozen_lanes_.begin(), frozen_lanes_.end(), Longer);
+  std::vector<size_t> instr_lane(op_num);
+  for (size_t lane = 0; lane < frozen_lanes_.size(); ++lane) {
+    for (auto instr_id : frozen_lanes_[lane]) {
+      instr_lane[instr_id] = lane;
+    }
+  }
+
+  // an op only waits for its upstream ops in the other lanes, those in the
+  // same lane have run before it
+  frozen_wait_ops_.assign(op_num, std::vector<size_t>());
+  for (size_t i = 0; i < op_num; ++i) {
+    const auto& next_instr = vec_instruction_[i].NextInstructions();
+    for (auto* next_ids : {&next_instr.DirectRunIds(),
+                           &next_instr.EventRunIds(),
+                           &next_instr.SyncRunIds()}) {
+      for (auto next_id : *next_ids) {
+        if (instr_lane[next_id] != instr_lane[i]) {
+          frozen_wait_ops_[next_id].push_back(i);
+        }
+      }
+    }
+  }
+  instr_done_step_ = std::vector<std::atomic<uint64_t>>(op_num);
+  frozen_step_ = 0;
+
+  size_t bound_num = 0;
+  for (auto& instr : vec_instruction_) {
+    if (CanBindKernelContext(instr)) {
+      auto kernel_context = std::make_shared<phi::KernelContext>();
+      static_cast<const framework::OperatorWithKernel*>(instr.OpBase())
+          ->BuildPhiKernelContext(
+              *instr.InnerRuntimeContext(),
+              const_cast<platform::DeviceContext*>(&instr.DeviceContext()),
+              kernel_context.get());
+      instr.SetFrozenKernelContext(kernel_context);
+      ++bound_num;
+    }
+  }
+  VLOG(1) << "Freeze the plan of " << op_num << " ops into "
+          << frozen_lanes_.size() << " lanes, " << bound_num
+          << " kernel contexts are bound.";
+}
+
+void InterpreterCore::UnfreezePlan() {
+  frozen_lanes_.clear();
+  frozen_wait_ops_.clear();
+  for (auto& instr : vec_instruction_) {
+    instr.SetFrozenKernelContext(nullptr);
+  }
+  plan_stable_steps_ = 0;
+}
+
+void InterpreterCore::RunFrozenPlan() {
+  platform::RecordEvent record_prepare(
+      "PrepareAtomic", platform::TracerEventType::UserDefined, 1);
+  // the dependencies are kept by the lanes, only the var refs are needed
+  auto atomic_var_ref = atomic_var_ref_.get();
+  atomic_var_ref_ =
+      async_work_queue_->PrepareAtomicVarRef(var_scope_.VecMetaInfo());
+  record_prepare.End();
+
+  exception_holder_.Clear();
+  uint64_t step = ++frozen_step_;
+  unfinished_lane_num_ = frozen_lanes_.size();
+  for (size_t lane = 1; lane < frozen_lanes_.size(); ++lane) {
+    async_work_queue_->AddTask(
+        OpFuncType::kQueueSync,
+        [this, lane, step, atomic_var_ref = atomic_var_ref.get()]() {
+          RunFrozenLane(lane, step, atomic_var_ref);
+        });
+  }
+  RunFrozenLane(0, step, atomic_var_ref.get());
+
+  // every lane exits on exception, so nothing is running after the wait
+  auto event_name = main_thread_blocker_.WaitEvent();
+  VLOG(4) << "main_thread_blocker_(" << &main_thread_blocker_
+          << ") got event_name: " << event_name;
+  if (UNLIKELY(exception_holder_.IsCaught())) {
+    VLOG(1) << "Exception caught " << exception_holder_.Type()
+            << ", fall back from the frozen plan.";
+    UnfreezePlan();
+    exception_holder_.ReThrow();
+  }
+}
+
+void InterpreterCore::RunFrozenLane(
+    size_t lane,
+    uint64_t step,
+    std::vector<std::atomic<size_t>>* atomic_var_ref) {
+  bool caught = false;
+  for (auto instr_id : frozen_lanes_[lane]) {
+    for (auto wait_id : frozen_wait_ops_[instr_id]) {
+      if (!WaitFrozenInstr(wait_id, step)) {
+        caught = true;
+        break;
+      }
+    }
+    if (caught || UNLIKELY(exception_holder_.IsCaught())) {
+      break;
+    }
+    RunInstructionWithGuard(vec_instruction_[instr_id], atomic_var_ref);
+    // seq_cst pairs with frozen_waiter_num_, see WaitFrozenInstr
+    instr_done_step_[instr_id].store(step);
+    if (frozen_waiter_num_.load() > 0) {
+      NotifyFrozenWaiters();
+    }
+  }
+  // wake up the lanes blocked on the ops this lane will not run
+  if (UNLIKELY(exception_holder_.IsCaught())) {
+    NotifyFrozenWaiters();
+  }
+  if (unfinished_lane_num_.fetch_sub(1) == 1) {
+    completion_notifier_->NotifyEvent();
+  }
+}
+
+bool InterpreterCore::WaitFrozenInstr(size_t instr_id, uint64_t step) {
+  // most upstream ops are done within a few yields, so spin before blocking
+  constexpr int kMaxSpinNum = 64;
+  auto& done_step = instr_done_step_[instr_id];
+  for (int i = 0; i < kMaxSpinNum; ++i) {
+    if (done_step.load(std::memory_order_acquire) == step) {
+      return true;
+    }
+    if (UNLIKELY(exception_holder_.IsCaught())) {
+      return false;
+    }
+    std::this_thread::yield();
+  }
+  // the waiter is counted before the check, so a lane storing done_step
+  // either sees the waiter and notifies or is seen by the check
+  frozen_waiter_num_.fetch_add(1);
+  bool caught = false;
+  {
+    std::unique_lock<std::mutex> lock(frozen_mutex_);
+    frozen_cv_.wait(lock, [&] {
+      if (done_step.load() == step) {
+        return true;
+      }
+      caught = exception_holder_.IsCaught();
+      return caught;
+    });
+  }
+  frozen_waiter_num_.fetch_sub(1);
+  return !caught;
+}
+
+void InterpreterCore::NotifyFrozenWaiters() {
+  {
+    std::lock_guard<std::mutex> lock(frozen_mutex_);
+  }
+  frozen_cv_.notify_all();
+}
+
 #if defined(PADDLE_WITH_CUDA) || defined(PADDLE_WITH_HIP)
 void InterpreterCore::RecordStreamForGC(const Instruction& instr) {
   if (!IsInterpretercoreFastGCEnabled() ||
@@ -13,9 +13,12 @@
 // limitations under the License.
 #pragma once
 
+#include <condition_variable>  // NOLINT
 #include <map>
+#include <mutex>  // NOLINT
 #include <queue>
 #include <string>
+#include <thread>  // NOLINT
 #include <unordered_map>
 #include <vector>
 
@@ -58,6 +61,9 @@ class InterpreterCore {
 
   void SetCopyProgram(std::shared_ptr<ProgramDesc> prog);
 
+  // whether the steps run by the frozen plan, for the tests
+  bool IsPlanFrozen() const { return !frozen_lanes_.empty(); }
+
  private:
   bool BuildInplaceCheckVarIsOnlyInput(size_t var_index);
 
@@ -91,11 +97,33 @@ class InterpreterCore {
   void RunInstructionAsync(size_t instr_id,
                            std::vector<std::atomic<size_t>>* atomic_deps,
                            std::vector<std::atomic<size_t>>* atomic_var_ref);
+  void AddInstructionTask(size_t instr_id,
+                          std::vector<std::atomic<size_t>>* atomic_deps,
+                          std::vector<std::atomic<size_t>>* atomic_var_ref);
   void RunNextInstructions(const Instruction& instr_id,
                            std::queue<size_t>* reserved_next_ops,
                            std::vector<std::atomic<size_t>>* atomic_deps,
                            std::vector<std::atomic<size_t>>* atomic_var_ref);
 
+  void RunInstructionWithGuard(
+      const Instruction& instr_node,
+      std::vector<std::atomic<size_t>>* atomic_var_ref);
+
+  // run a step by the frozen plan when it is valid, see
+  // FLAGS_new_executor_use_frozen_plan
+  void ExecuteStep(const std::vector<std::string>& feed_names);
+  std::vector<int64_t> FeedSignature(
+      const std::vector<std::string>& feed_names) const;
+  void FreezePlan();
+  void UnfreezePlan();
+  void RunFrozenPlan();
+  void RunFrozenLane(size_t lane,
+                     uint64_t step,
+                     std::vector<std::atomic<size_t>>* atomic_var_ref);
+  // false if an exception is caught while waiting
+  bool WaitFrozenInstr(size_t instr_id, uint64_t step);
+  void NotifyFrozenWaiters();
+
   void BuildSkipShareLoDInfo();
 
   void SetFeedVarsInplaceSkip(const std::vector<std::string>& feed_names);
@@ -125,6 +153,35 @@ class InterpreterCore {
   std::map<size_t, std::set<size_t>> last_live_ops_;
 
   std::vector<size_t> dependecy_count_;
+  // the critical path priority of instructions, see
+  // interpreter::build_op_critical_path_priority
+  std::vector<double> instr_priority_;
+  // the host time (us) of instructions measured in the first step that uses
+  // the priority schedule, then instr_priority_ is rebuilt by them
+  std::vector<double> instr_cost_;
+  bool use_priority_schedule_{false};
+  bool measure_instr_cost_{false};
+  bool instr_cost_measured_{false};
+
+  // the frozen plan, every lane is the run order of a thread recorded in the
+  // last warm-up step, and an op of a lane waits for its upstream ops of the
+  // other lanes by instr_done_step_
+  std::vector<std::vector<size_t>> frozen_lanes_;
+  std::vector<std::vector<size_t>> frozen_wait_ops_;
+  std::vector<std::atomic<uint64_t>> instr_done_step_;
+  uint64_t frozen_step_{0};
+  std::atomic<size_t> unfinished_lane_num_{0};
+  // a lane blocks on frozen_cv_ after spinning for an upstream op a while
+  std::mutex frozen_mutex_;
+  std::condition_variable frozen_cv_;
+  std::atomic<size_t> frozen_waiter_num_{0};
+  std::vector<int64_t> plan_feed_signature_;
+  size_t plan_stable_steps_{0};
+  bool record_run_order_{false};
+  std::vector<size_t> instr_run_seq_;
+  std::vector<std::thread::id> instr_run_thread_;
+  std::atomic<size_t> run_seq_{0};
+
   std::atomic<size_t> unfinished_op_numer_{0};
   std::vector<std::vector<size_t>> input_var2op_info_;
 
@@ -0,0 +1,154 @@
+// Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <random>
+#include <string>
+#include <vector>
+
+#include "gflags/gflags.h"
+#include "paddle/fluid/framework/new_executor/interpretercore.h"
+#include "paddle/fluid/framework/op_registry.h"
+#include "paddle/phi/core/kernel_registry.h"
+
+DECLARE_bool(new_executor_use_frozen_plan);
+DECLARE_int32(new_executor_frozen_plan_warmup_steps);
+
+USE_OP_ITSELF(fill_constant);
+USE_OP_ITSELF(matmul_v2);
+USE_OP_ITSELF(elementwise_add);
+USE_OP_ITSELF(fetch_v2);
+
+PD_DECLARE_KERNEL(full, CPU, ALL_LAYOUT);
+PD_DECLARE_KERNEL(matmul, CPU, ALL_LAYOUT);
+PD_DECLARE_KERNEL(add, CPU, ALL_LAYOUT);
+
+namespace paddle {
+namespace framework {
+
+static const int64_t kDim = 16;
+
+static void AppendBinary(BlockDesc* block,
+                         const std::string& type,
+                         const std::string& x,
+                         const std::string& y,
+                         const std::string& out) {
+  block->Var(out)->SetType(proto::VarType::LOD_TENSOR);
+  auto* op = block->AppendOp();
+  op->SetType(type);
+  op->SetInput("X", {x});
+  op->SetInput("Y", {y});
+  op->SetOutput("Out", {out});
+}
+
+// Two towers of matmul on the feed x of [batch, kDim], which may run on two
+// threads:
+//   out = (x * w0 * w0) + (x * w1 + x)
+static ProgramDesc BuildProgram() {
+  ProgramDesc program;
+  auto* block = program.MutableBlock(0);
+  block->Var("x")->SetType(proto::VarType::LOD_TENSOR);
+  for (int i = 0; i < 2; ++i) {
+    std::string w = "w" + std::to_string(i);
+    block->Var(w)->SetType(proto::VarType::LOD_TENSOR);
+    auto* op = block->AppendOp();
+    op->SetType("fill_constant");
+    op->SetOutput("Out", {w});
+    op->SetAttr("shape", std::vector<int64_t>{kDim, kDim});
+    op->SetAttr("dtype", static_cast<int>(proto::VarType::FP32));
+    op->SetAttr("value", 0.5f + i);
+  }
+  AppendBinary(block, "matmul_v2", "x", "w0", "a0");
+  AppendBinary(block, "matmul_v2", "a0", "w0", "a1");
+  AppendBinary(block, "matmul_v2", "x", "w1", "b0");
+  AppendBinary(block, "elementwise_add", "b0", "x", "b1");
+  AppendBinary(block, "elementwise_add", "a1", "b1", "out");
+  return program;
+}
+
+static LoDTensor RandomFeed(int64_t batch, std::mt19937* rng) {
+  std::uniform_real_distribution<float> dist(-1, 1);
+  LoDTensor tensor;
+  float* data = tensor.mutable_data<float>(phi::make_ddim({batch, kDim}),
+                                           platform::CPUPlace());
+  for (int64_t i = 0; i < batch * kDim; ++i) {
+    data[i] = dist(*rng);
+  }
+  return tensor;
+}
+
+static std::vector<float> Run(InterpreterCore* core,
+                              bool use_frozen_plan,
+                              const LoDTensor& x) {
+  FLAGS_new_executor_use_frozen_plan = use_frozen_plan;
+  auto fetch_list = core->Run({"x"}, {x});
+  auto& out = PADDLE_GET_CONST(LoDTensor, fetch_list[0]);
+  EXPECT_EQ(out.dims(), x.dims());
+  return std::vector<float>(out.data<float>(),
+                            out.data<float>() + out.numel());
+}
+
+TEST(InterpreterCore, frozen_plan) {
+  bool use_frozen_plan = FLAGS_new_executor_use_frozen_plan;
+  int warmup_steps = FLAGS_new_executor_frozen_plan_warmup_steps;
+  FLAGS_new_executor_frozen_plan_warmup_steps = 2;
+
+  auto program = BuildProgram();
+  platform::CPUPlace place;
+  Scope scope;
+  auto core = CreateInterpreterCore(place, program, &scope, {"out"});
+  Scope expect_scope;
+  auto expect_core =
+      CreateInterpreterCore(place, program, &expect_scope, {"out"});
+
+  // the batch of every step, the plan freezes after 2 steps of the same batch,
+  // not counting the first run which builds the instructions, and is dropped
+  // when the batch changes
+  std::vector<int64_t> batches = {4, 4, 4, 4, 4, 7, 7, 7, 7, 4, 4, 4};
+  std::vector<int> frozen = {0, 0, 1, 1, 1, 0, 1, 1, 1, 0, 1, 1};
+  std::mt19937 rng(0);
+  for (size_t step = 0; step < batches.size(); ++step) {
+    auto x = RandomFeed(batches[step], &rng);
+    auto expect = Run(expect_core.get(), false, x);
+    auto actual = Run(core.get(), true, x);
+    ASSERT_EQ(actual.size(), expect.size());
+    for (size_t i = 0; i < expect.size(); ++i) {
+      ASSERT_NEAR(actual[i], expect[i], 1e-5) << "step " << step;
+    }
+    ASSERT_EQ(core->IsPlanFrozen(), frozen[step] == 1) << "step " << step;
+  }
+
+  // the plan is kept when only the lod offsets of the feed change
+  std::vector<LoD> lods = {{{0, 1, 4}}, {{0, 3, 4}}, {{0, 2, 4}}};
+  std::vector<int> lod_frozen = {0, 1, 1};
+  for (size_t step = 0; step < lods.size(); ++step) {
+    auto x = RandomFeed(4, &rng);
+    x.set_lod(lods[step]);
+    auto expect = Run(expect_core.get(), false, x);
+    auto actual = Run(core.get(), true, x);
+    ASSERT_EQ(actual.size(), expect.size());
+    for (size_t i = 0; i < expect.size(); ++i) {
+      ASSERT_NEAR(actual[i], expect[i], 1e-5) << "lod step " << step;
+    }
+    ASSERT_EQ(core->IsPlanFrozen(), lod_frozen[step] == 1)
+        << "lod step " << step;
+  }
+
+  FLAGS_new_executor_use_frozen_plan = use_frozen_plan;
+  FLAGS_new_executor_frozen_plan_warmup_steps = warmup_steps;
+}
+
+}  // namespace framework
+}  // namespace paddle
@@ -0,0 +1,159 @@
+// Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Compare the step latency of InterpreterCore with the dependency order
+// schedule, the critical path priority schedule and the frozen plan on a
+// multi-tower program, which has one long tower and many short towers of
+// matmul, e.g.
+//   interpretercore_schedule_benchmark --tower_num=16 --long_depth=32 \
+//       --short_depth=4 --dim=256
+
+#include <algorithm>
+#include <string>
+
+#include "gflags/gflags.h"
+#include "glog/logging.h"
+#include "paddle/fluid/framework/new_executor/interpretercore.h"
+#include "paddle/fluid/framework/op_registry.h"
+#include "paddle/fluid/platform/timer.h"
+#include "paddle/phi/core/kernel_registry.h"
+
+DEFINE_int32(tower_num, 16, "The number of towers.");
+DEFINE_int32(long_depth, 32, "The matmul num of the long tower.");
+DEFINE_int32(short_depth, 4, "The matmul num of the short towers.");
+DEFINE_int32(dim, 256, "The dim of the square matrices.");
+DEFINE_int32(warmup_steps, 5, "The steps before timing.");
+DEFINE_int32(steps, 100, "The timed steps.");
+
+DECLARE_bool(new_executor_use_priority_schedule);
+DECLARE_bool(new_executor_use_frozen_plan);
+DECLARE_int32(new_executor_frozen_plan_warmup_steps);
+
+USE_OP_ITSELF(fill_constant);
+USE_OP_ITSELF(matmul_v2);
+USE_OP_ITSELF(elementwise_add);
+USE_OP_ITSELF(fetch_v2);
+
+PD_DECLARE_KERNEL(full, CPU, ALL_LAYOUT);
+PD_DECLARE_KERNEL(matmul, CPU, ALL_LAYOUT);
+PD_DECLARE_KERNEL(add, CPU, ALL_LAYOUT);
+
+namespace paddle {
+namespace framework {
+
+static void AppendFillConstant(BlockDesc* block, const std::string& out) {
+  block->Var(out)->SetType(proto::VarType::LOD_TENSOR);
+  auto* op = block->AppendOp();
+  op->SetType("fill_constant");
+  op->SetOutput("Out", {out});
+  op->SetAttr("shape", std::vector<int64_t>{FLAGS_dim, FLAGS_dim});
+  op->SetAttr("dtype", static_cast<int>(proto::VarType::FP32));
+  op->SetAttr("value", 1.0f / FLAGS_dim);
+}
+
+static void AppendBinary(BlockDesc* block,
+                         const std::string& type,
+                         const std::string& x,
+                         const std::string& y,
+                         const std::string& out) {
+  block->Var(out)->SetType(proto::VarType::LOD_TENSOR);
+  auto* op = block->AppendOp();
+  op->SetType(type);
+  op->SetInput("X", {x});
+  op->SetInput("Y", {y});
+  op->SetOutput("Out", {out});
+}
+
+// The towers are appended one by one, so the long tower at the end is the
+// last in the dependency order.
+static ProgramDesc BuildMultiTowerProgram() {
+  ProgramDesc program;
+  auto* block = program.MutableBlock(0);
+  std::string sum;
+  for (int t = 0; t < FLAGS_tower_num; ++t) {
+    std::string prefix = "tower_" + std::to_string(t);
+    int depth = t == FLAGS_tower_num - 1 ? FLAGS_long_depth : FLAGS_short_depth;
+    AppendFillConstant(block, prefix + "_w");
+    AppendFillConstant(block, prefix + "_x0");
+    for (int d = 0; d < depth; ++d) {
+      AppendBinary(block,
+                   "matmul_v2",
+                   prefix + "_x" + std::to_string(d),
+                   prefix + "_w",
+                   prefix + "_x" + std::to_string(d + 1));
+    }
+    std::string out = prefix + "_x" + std::to_string(depth);
+    if (sum.empty()) {
+      sum = out;
+    } else {
+      AppendBinary(block, "elementwise_add", sum, out, prefix + "_sum");
+      sum = prefix + "_sum";
+    }
+  }
+  block->Var("out")->SetType(proto::VarType::LOD_TENSOR);
+  auto* op = block->AppendOp();
+  op->SetType("elementwise_add");
+  op->SetInput("X", {sum});
+  op->SetInput("Y", {sum});
+  op->SetOutput("Out", {"out"});
+  return program;
+}
+
+static double RunOnce(const ProgramDesc& program,
+                      bool use_priority,
+                      bool use_frozen_plan) {
+  FLAGS_new_executor_use_priority_schedule = use_priority;
+  FLAGS_new_executor_use_frozen_plan = use_frozen_plan;
+  platform::CPUPlace place;
+  Scope scope;
+  auto core = CreateInterpreterCore(place, program, &scope, {"out"});
+  // the first run builds the instructions, the second measures the op time
+  // for the priority schedule, and the plan freezes after its warm-up steps
+  int warmup_steps =
+      std::max(FLAGS_warmup_steps, FLAGS_new_executor_frozen_plan_warmup_steps);
+  for (int i = 0; i < warmup_steps + 2; ++i) {
+    core->Run({});
+  }
+  platform::Timer timeline;
+  timeline.Start();
+  for (int i = 0; i < FLAGS_steps; ++i) {
+    core->Run({});
+  }
+  timeline.Pause();
+  return timeline.ElapsedMS() / FLAGS_steps;
+}
+
+static int BenchmarkMain() {
+  auto program = BuildMultiTowerProgram();
+  LOG(INFO) << "program with " << program.Block(0).OpSize() << " ops, "
+            << FLAGS_tower_num << " towers";
+  double fifo_ms = RunOnce(program, false, false);
+  double priority_ms = RunOnce(program, true, false);
+  double frozen_ms = RunOnce(program, true, true);
+  LOG(INFO) << "step latency: dependency order " << fifo_ms
+            << " ms, critical path priority " << priority_ms
+            << " ms (speedup " << fifo_ms / priority_ms
+            << "), frozen plan " << frozen_ms << " ms (speedup "
+            << fifo_ms / frozen_ms << ")";
+  return 0;
+}
+
+}  // namespace framework
+}  // namespace paddle
+
+int main(int argc, char* argv[]) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  google::InitGoogleLogging(argv[0]);
+  return paddle::framework::BenchmarkMain();
+}
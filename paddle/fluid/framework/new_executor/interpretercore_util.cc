@@ -105,6 +105,21 @@ void AsyncWorkQueue::AddTask(const OpFuncType& op_func_type,
   }
 }
 
+void AsyncWorkQueue::AddPriorityTask(const OpFuncType& op_func_type,
+                                     double priority,
+                                     std::function<void()> fn) {
+  VLOG(4) << "Add priority task: " << static_cast<size_t>(op_func_type) << " "
+          << priority;
+  if (FLAGS_new_executor_serial_run) {
+    queue_group_->AddPriorityTask(static_cast<size_t>(OpFuncType::kQueueAsync),
+                                  priority,
+                                  std::move(fn));
+  } else {
+    queue_group_->AddPriorityTask(
+        static_cast<size_t>(op_func_type), priority, std::move(fn));
+  }
+}
+
 std::future<std::unique_ptr<AtomicVectorSizeT>>
 AsyncWorkQueue::PrepareAtomicDeps(const std::vector<size_t>& dependecy_count) {
   VLOG(4) << "PrepareAtomicDeps";
@@ -718,6 +733,63 @@ std::vector<size_t> merge_vector(const std::vector<size_t>& first,
   return out;
 }
 
+std::vector<double> build_op_critical_path_priority(
+    const std::vector<Instruction>& vec_instruction,
+    const std::vector<double>& op_costs) {
+  size_t op_num = vec_instruction.size();
+  PADDLE_ENFORCE_EQ(
+      op_costs.size(),
+      op_num,
+      platform::errors::InvalidArgument(
+          "The size of op_costs (%d) must be equal to the number of "
+          "instructions (%d).",
+          op_costs.size(),
+          op_num));
+  auto next_ops = [&vec_instruction](size_t op) {
+    const auto& next_instr = vec_instruction[op].NextInstructions();
+    return merge_vector(
+        merge_vector(next_instr.DirectRunIds(), next_instr.EventRunIds()),
+        next_instr.SyncRunIds());
+  };
+
+  // topological order, the downstream of an op is not always behind it in
+  // the program, e.g. the dependencies added for the read op
+  std::vector<size_t> deps(op_num, 0);
+  for (size_t op = 0; op < op_num; ++op) {
+    for (auto next : next_ops(op)) {
+      ++deps[next];
+    }
+  }
+  std::vector<size_t> order;
+  order.reserve(op_num);
+  for (size_t op = 0; op < op_num; ++op) {
+    if (deps[op] == 0) {
+      order.push_back(op);
+    }
+  }
+  for (size_t i = 0; i < order.size(); ++i) {
+    for (auto next : next_ops(order[i])) {
+      if (--deps[next] == 0) {
+        order.push_back(next);
+      }
+    }
+  }
+  PADDLE_ENFORCE_EQ(order.size(),
+                    op_num,
+                    platform::errors::PreconditionNotMet(
+                        "The dependencies of instructions contain a cycle."));
+
+  std::vector<double> priority(op_num, 0.0);
+  for (auto it = order.rbegin(); it != order.rend(); ++it) {
+    double max_next = 0.0;
+    for (auto next : next_ops(*it)) {
+      max_next = std::max(max_next, priority[next]);
+    }
+    priority[*it] = op_costs[*it] + max_next;
+  }
+  return priority;
+}
+
 void update_var_min_rw_op(const std::map<int, std::set<int>>& op2dependences,
                           std::map<int, std::list<int>>* var2min_rw_op,
                           int cur_op,
@@ -59,6 +59,11 @@ class AsyncWorkQueue {
 
   void AddTask(const OpFuncType& op_func_type, std::function<void()> fn);
 
+  // Tasks of the same queue are dispatched by priority, the higher first.
+  void AddPriorityTask(const OpFuncType& op_func_type,
+                       double priority,
+                       std::function<void()> fn);
+
   void Cancel() { queue_group_->Cancel(); }
 
  private:
@@ -92,6 +97,13 @@ void add_fetch(const std::vector<std::string>& fetch_names,
 std::vector<size_t> merge_vector(const std::vector<size_t>& first,
                                  const std::vector<size_t>& second);
 
+// The priority of an instruction is the cost of the longest path from it to
+// the end of the graph, i.e. its own cost plus the max priority of its next
+// instructions, so the ops on the critical path get the highest priorities.
+std::vector<double> build_op_critical_path_priority(
+    const std::vector<Instruction>& vec_instruction,
+    const std::vector<double>& op_costs);
+
 }  // namespace interpreter
 }  // namespace framework
 }  // namespace paddle
@@ -14,6 +14,7 @@
 
 #include "paddle/fluid/framework/new_executor/new_executor_defs.h"
 
+#include <cstring>
 #include <map>
 #include <string>
 #include <unordered_map>
@@ -677,6 +678,112 @@ void VariableScope::CheckExist(const std::string& name) const {
       platform::errors::NotFound("%s not in VariableScope.", name));
 }
 
+bool InferShapeCache::BuildKey(const RuntimeContext& ctx) {
+  key_.clear();
+  for (auto& item : ctx.inputs) {
+    key_.push_back(item.second.size());
+    for (auto* var : item.second) {
+      if (var == nullptr) {
+        key_.push_back(-1);
+        continue;
+      }
+      if (!var->IsType<LoDTensor>()) {
+        disabled_ = true;
+        return false;
+      }
+      auto& tensor = var->Get<LoDTensor>();
+      auto& dims = tensor.dims();
+      key_.push_back(dims.size());
+      for (int i = 0; i < dims.size(); ++i) {
+        key_.push_back(dims[i]);
+      }
+      key_.push_back(static_cast<int64_t>(tensor.dtype()));
+      key_.push_back(tensor.lod().size());
+      for (auto& level : tensor.lod()) {
+        key_.push_back(level.size());
+        key_.insert(key_.end(), level.begin(), level.end());
+      }
+      if (!tensor.IsInitialized() || tensor.numel() > kMaxKeyedValueNumel) {
+        continue;
+      }
+      if (!platform::is_cpu_place(tensor.place())) {
+        if (tensor.dtype() == phi::DataType::INT32 ||
+            tensor.dtype() == phi::DataType::INT64) {
+          // may be a shape tensor whose value is not cheap to read
+          disabled_ = true;
+          return false;
+        }
+        continue;
+      }
+      size_t bytes = tensor.numel() * experimental::SizeOf(tensor.dtype());
+      size_t offset = key_.size();
+      key_.resize(offset + (bytes + sizeof(int64_t) - 1) / sizeof(int64_t), 0);
+      std::memcpy(key_.data() + offset, tensor.data(), bytes);
+    }
+  }
+  return true;
+}
+
+bool InferShapeCache::Lookup(const RuntimeContext& ctx) {
+  if (disabled_ || !BuildKey(ctx)) {
+    return false;
+  }
+  for (auto& entry : entries_) {
+    if (entry.key != key_) {
+      continue;
+    }
+    size_t idx = 0;
+    for (auto& item : ctx.outputs) {
+      for (auto* var : item.second) {
+        auto& meta = entry.metas[idx++];
+        if (meta.is_null) {
+          continue;
+        }
+        auto* tensor = var->GetMutable<LoDTensor>();
+        tensor->Resize(meta.dims);
+        tensor->set_type(meta.dtype);
+        tensor->set_layout(meta.layout);
+        tensor->set_lod(meta.lod);
+      }
+    }
+    return true;
+  }
+  return false;
+}
+
+void InferShapeCache::Insert(const RuntimeContext& ctx) {
+  if (disabled_) {
+    return;
+  }
+  Entry entry;
+  for (auto& item : ctx.outputs) {
+    for (auto* var : item.second) {
+      if (var == nullptr) {
+        entry.metas.push_back(OutputMeta{true,
+                                          DDim(),
+                                          phi::DataType::UNDEFINED,
+                                          phi::DataLayout::UNDEFINED,
+                                          LoD()});
+        continue;
+      }
+      if (!var->IsType<LoDTensor>()) {
+        disabled_ = true;
+        return;
+      }
+      auto& tensor = var->Get<LoDTensor>();
+      entry.metas.push_back(OutputMeta{
+          false, tensor.dims(), tensor.dtype(), tensor.layout(), tensor.lod()});
+    }
+  }
+  entry.key = key_;
+  if (entries_.size() < kCapacity) {
+    entries_.push_back(std::move(entry));
+  } else {
+    entries_[next_replace_] = std::move(entry);
+    next_replace_ = (next_replace_ + 1) % kCapacity;
+  }
+}
+
 Instruction::Instruction(size_t id,
                          OpFuncNode&& op_func_node,
                          const platform::DeviceContext& dev_ctx)
@@ -777,6 +884,23 @@ const std::vector<std::pair<Variable*, Variable*>>& Instruction::InplaceInfo()
   return vec_inplace_in_to_out_;
 }
 
+InferShapeCache* Instruction::GetInferShapeCache() const {
+  return infer_shape_cache_.get();
+}
+
+void Instruction::SetInferShapeCache(std::shared_ptr<InferShapeCache> cache) {
+  infer_shape_cache_ = cache;
+}
+
+phi::KernelContext* Instruction::FrozenKernelContext() const {
+  return frozen_kernel_ctx_.get();
+}
+
+void Instruction::SetFrozenKernelContext(
+    std::shared_ptr<phi::KernelContext> ctx) {
+  frozen_kernel_ctx_ = ctx;
+}
+
 void Instruction::AddInplace(Variable* in, Variable* out) {
   vec_inplace_in_to_out_.emplace_back(in, out);
 }
@@ -288,6 +288,48 @@ struct OpFuncNode {
   OpFuncType type_;
 };
 
+// Caches the output metas set by the InferShape of an instruction, keyed by
+// the dims, dtype and LoD of its inputs, and the values of the small inputs
+// on CPU since InferShape may read them as shapes. It is disabled when any
+// input or output is not a LoDTensor, or a small integer input is not on CPU.
+// An instruction runs in one thread at a time, so there is no lock.
+class InferShapeCache {
+ public:
+  InferShapeCache() = default;
+
+  // Restore the output metas cached for the current inputs and return true,
+  // otherwise keep the key for Insert after InferShape.
+  bool Lookup(const RuntimeContext& ctx);
+
+  void Insert(const RuntimeContext& ctx);
+
+  bool Disabled() const { return disabled_; }
+
+ private:
+  struct OutputMeta {
+    bool is_null;
+    DDim dims;
+    phi::DataType dtype;
+    phi::DataLayout layout;
+    LoD lod;
+  };
+
+  struct Entry {
+    std::vector<int64_t> key;
+    std::vector<OutputMeta> metas;
+  };
+
+  static constexpr size_t kCapacity = 4;
+  static constexpr int64_t kMaxKeyedValueNumel = 8;
+
+  bool BuildKey(const RuntimeContext& ctx);
+
+  std::vector<Entry> entries_;
+  size_t next_replace_{0};
+  std::vector<int64_t> key_;
+  bool disabled_{false};
+};
+
 class Instruction {
  public:
   Instruction(size_t id,
@@ -340,6 +382,15 @@ class Instruction {
 
   void AddInplace(Variable* in, Variable* out);
 
+  // the phi kernel context bound by the frozen plan of InterpreterCore
+  phi::KernelContext* FrozenKernelContext() const;
+
+  void SetFrozenKernelContext(std::shared_ptr<phi::KernelContext> ctx);
+
+  InferShapeCache* GetInferShapeCache() const;
+
+  void SetInferShapeCache(std::shared_ptr<InferShapeCache> cache);
+
   const std::vector<EventInter>& InputEvents() const;
 
   const std::vector<EventInter>& OutputEvents() const;
@@ -368,6 +419,10 @@ class Instruction {
   std::vector<EventInter> output_events_;
 
   std::vector<std::pair<Variable*, Variable*>> vec_inplace_in_to_out_;
+
+  std::shared_ptr<phi::KernelContext> frozen_kernel_ctx_;
+
+  std::shared_ptr<InferShapeCache> infer_shape_cache_;
 };
 
 namespace interpreter {
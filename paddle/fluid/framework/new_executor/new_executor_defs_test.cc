@@ -0,0 +1,87 @@
+// Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/framework/new_executor/new_executor_defs.h"
+
+#include "gtest/gtest.h"
+#include "paddle/fluid/framework/new_executor/executor_statistics.h"
+
+namespace paddle {
+namespace framework {
+
+TEST(InferShapeCache, LookupAndInsert) {
+  platform::CPUPlace place;
+  Variable x, shape, out;
+  auto* x_tensor = x.GetMutable<LoDTensor>();
+  x_tensor->Resize(phi::make_ddim({2, 3}));
+  x_tensor->mutable_data<float>(place);
+  auto* shape_tensor = shape.GetMutable<LoDTensor>();
+  shape_tensor->Resize(phi::make_ddim({2}));
+  int64_t* shape_data = shape_tensor->mutable_data<int64_t>(place);
+  shape_data[0] = 3;
+  shape_data[1] = 2;
+  auto* out_tensor = out.GetMutable<LoDTensor>();
+  RuntimeContext ctx({{"X", {&x}}, {"Shape", {&shape}}},
+                     {{"Out", {&out}}, {"XShape", {nullptr}}});
+
+  InferShapeCache cache;
+  EXPECT_FALSE(cache.Lookup(ctx));
+  // what InferShape sets
+  out_tensor->Resize(phi::make_ddim({3, 2}));
+  out_tensor->set_lod({{0, 1, 3}});
+  cache.Insert(ctx);
+
+  out_tensor->Resize(phi::make_ddim({1}));
+  out_tensor->set_lod({});
+  EXPECT_TRUE(cache.Lookup(ctx));
+  EXPECT_EQ(out_tensor->dims(), phi::make_ddim({3, 2}));
+  EXPECT_EQ(out_tensor->lod(), LoD({{0, 1, 3}}));
+
+  // the values of small inputs on CPU are a part of the key
+  shape_data[0] = 6;
+  shape_data[1] = 1;
+  EXPECT_FALSE(cache.Lookup(ctx));
+  shape_data[0] = 3;
+  shape_data[1] = 2;
+  EXPECT_TRUE(cache.Lookup(ctx));
+
+  x_tensor->Resize(phi::make_ddim({4, 3}));
+  EXPECT_FALSE(cache.Lookup(ctx));
+  x_tensor->set_lod({{0, 4}});
+  EXPECT_FALSE(cache.Lookup(ctx));
+  EXPECT_FALSE(cache.Disabled());
+
+  // only LoDTensor is supported
+  Variable array;
+  array.GetMutable<LoDTensorArray>();
+  RuntimeContext array_ctx({{"X", {&array}}}, {{"Out", {&out}}});
+  InferShapeCache array_cache;
+  EXPECT_FALSE(array_cache.Lookup(array_ctx));
+  EXPECT_TRUE(array_cache.Disabled());
+}
+
+TEST(InferShapeCache, Statistics) {
+  ResetInferShapeCacheStatistics();
+  RecordInferShapeCacheLookup(true);
+  RecordInferShapeCacheLookup(true);
+  RecordInferShapeCacheLookup(false);
+  uint64_t hit_num = 0;
+  uint64_t miss_num = 0;
+  GetInferShapeCacheStatistics(&hit_num, &miss_num);
+  EXPECT_EQ(hit_num, 2u);
+  EXPECT_EQ(miss_num, 1u);
+}
+
+}  // namespace framework
+}  // namespace paddle
@@ -98,6 +98,10 @@ class WorkQueueGroupImpl : public WorkQueueGroup {
 
   void AddTask(size_t queue_idx, std::function<void()> fn) override;
 
+  void AddPriorityTask(size_t queue_idx,
+                       double priority,
+                       std::function<void()> fn) override;
+
   size_t QueueNumThreads(size_t queue_idx) const override;
 
   size_t QueueGroupNumThreads() const override;
@@ -107,6 +111,7 @@ class WorkQueueGroupImpl : public WorkQueueGroup {
  private:
   std::vector<NonblockingThreadPool*> queues_;
   NonblockingThreadPool* queues_storage_;
+  std::vector<std::unique_ptr<PriorityReadyQueue>> ready_queues_;
   TaskTracker* tracker_;
   std::shared_ptr<EventsWaiter::EventNotifier> empty_notifier_;
   std::shared_ptr<EventsWaiter::EventNotifier> destruct_notifier_;
@@ -119,6 +124,7 @@ WorkQueueGroupImpl::WorkQueueGroupImpl(
       tracker_(nullptr) {
   size_t num_queues = queues_options_.size();
   queues_.resize(num_queues);
+  ready_queues_.resize(num_queues);
   void* buffer = malloc(sizeof(NonblockingThreadPool) * num_queues);
   queues_storage_ = reinterpret_cast<NonblockingThreadPool*>(buffer);
   for (size_t idx = 0; idx < num_queues; ++idx) {
@@ -139,6 +145,7 @@ WorkQueueGroupImpl::WorkQueueGroupImpl(
                               options.num_threads,
                               options.allow_spinning,
                               options.always_spinning);
+    ready_queues_[idx].reset(new PriorityReadyQueue());
   }
 }
 
@@ -168,6 +175,23 @@ void WorkQueueGroupImpl::AddTask(size_t queue_idx, std::function<void()> fn) {
   queues_[queue_idx]->AddTask(std::move(fn));
 }
 
+void WorkQueueGroupImpl::AddPriorityTask(size_t queue_idx,
+                                         double priority,
+                                         std::function<void()> fn) {
+  assert(queue_idx < queues_.size());
+  PriorityReadyQueue* ready_queue = ready_queues_[queue_idx].get();
+  ready_queue->Push(priority, std::move(fn));
+  // The thread pool only schedules a placeholder for every ready task, so
+  // the work stealing still balances the threads while the placeholder runs
+  // whichever ready task has the highest priority.
+  AddTask(queue_idx, [ready_queue]() {
+    std::function<void()> task;
+    if (ready_queue->Pop(&task)) {
+      task();
+    }
+  });
+}
+
 size_t WorkQueueGroupImpl::QueueNumThreads(size_t queue_idx) const {
   assert(queue_idx < queues_.size());
   return queues_.at(queue_idx)->NumThreads();
@@ -188,6 +212,9 @@ void WorkQueueGroupImpl::Cancel() {
   for (auto queue : queues_) {
     queue->WaitThreadsExit();
   }
+  for (auto& ready_queue : ready_queues_) {
+    ready_queue->Clear();
+  }
 }
 
 }  // namespace
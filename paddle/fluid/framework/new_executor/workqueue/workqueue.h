@@ -155,6 +155,13 @@ class WorkQueueGroup {
 
   virtual void AddTask(size_t queue_idx, std::function<void()> fn) = 0;
 
+  // The task is held in a priority ready queue of queue_idx, every thread
+  // of the queue that picks up a task runs the ready one with the highest
+  // priority at that time.
+  virtual void AddPriorityTask(size_t queue_idx,
+                               double priority,
+                               std::function<void()> fn) = 0;
+
   // Higher cost than AddTask
   template <typename F, typename... Args>
   std::future<typename std::result_of<F(Args...)>::type> AddAwaitableTask(
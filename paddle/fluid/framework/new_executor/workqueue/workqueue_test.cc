@@ -16,6 +16,7 @@
 
 #include <atomic>
 #include <thread>
+#include <vector>
 
 #include "glog/logging.h"
 #include "gtest/gtest.h"
@@ -204,3 +205,69 @@ TEST(WorkQueue, TestWorkQueueGroup) {
   queue_group.reset();
   waiter_thread.join();
 }
+
+TEST(WorkQueueUtils, TestPriorityReadyQueue) {
+  using paddle::framework::PriorityReadyQueue;
+  PriorityReadyQueue ready_queue;
+  std::vector<int> order;
+  ready_queue.Push(1.0, [&order]() { order.push_back(0); });
+  ready_queue.Push(3.0, [&order]() { order.push_back(1); });
+  ready_queue.Push(1.0, [&order]() { order.push_back(2); });
+  ready_queue.Push(2.0, [&order]() { order.push_back(3); });
+  EXPECT_EQ(ready_queue.Size(), 4u);
+  std::function<void()> task;
+  while (ready_queue.Pop(&task)) {
+    task();
+  }
+  // the higher priority first, FIFO for the same priority
+  EXPECT_EQ(order, std::vector<int>({1, 3, 0, 2}));
+  ready_queue.Push(1.0, []() {});
+  ready_queue.Clear();
+  EXPECT_FALSE(ready_queue.Pop(&task));
+}
+
+TEST(WorkQueue, TestWorkQueueGroupPriorityTask) {
+  using paddle::framework::CreateWorkQueueGroup;
+  using paddle::framework::EventsWaiter;
+  using paddle::framework::WorkQueueOptions;
+  constexpr int kTaskNum = 16;
+  EventsWaiter events_waiter;
+  WorkQueueOptions sq_options(/*name*/ "SingleThreadedWorkQueueForTesting",
+                              /*num_threads*/ 1,
+                              /*allow_spinning*/ true,
+                              /*always_spinning*/ false,
+                              /*track_task*/ true,
+                              /*detached*/ true,
+                              &events_waiter);
+  WorkQueueOptions mq_options(/*name*/ "MultiThreadedWorkQueueForTesting",
+                              /*num_threads*/ 2,
+                              /*allow_spinning*/ true,
+                              /*always_spinning*/ false,
+                              /*track_task*/ false,
+                              /*detached*/ true,
+                              nullptr);
+  auto queue_group = CreateWorkQueueGroup({sq_options, mq_options});
+  // block the single thread until all the priority tasks are added
+  std::atomic<bool> started{false};
+  std::atomic<bool> released{false};
+  queue_group->AddTask(0, [&started, &released]() {
+    started = true;
+    while (!released) {
+      std::this_thread::yield();
+    }
+  });
+  while (!started) {
+    std::this_thread::yield();
+  }
+  std::vector<int> order;
+  for (int i = 0; i < kTaskNum; ++i) {
+    queue_group->AddPriorityTask(
+        0, (i * 7) % kTaskNum, [&order, i]() { order.push_back(i); });
+  }
+  released = true;
+  events_waiter.WaitEvent();
+  ASSERT_EQ(order.size(), static_cast<size_t>(kTaskNum));
+  for (int i = 1; i < kTaskNum; ++i) {
+    EXPECT_GT((order[i - 1] * 7) % kTaskNum, (order[i] * 7) % kTaskNum);
+  }
+}
@@ -14,6 +14,7 @@
 
 #include "paddle/fluid/framework/new_executor/workqueue/workqueue_utils.h"
 
+#include <algorithm>
 #include <cstdint>
 #include <cstdlib>
 
@@ -56,5 +57,32 @@ void AlignedFree(void* mem_ptr) {
 #endif
 }
 
+void PriorityReadyQueue::Push(double priority, std::function<void()> fn) {
+  std::lock_guard<std::mutex> guard(mutex_);
+  heap_.push_back(Item{priority, seq_++, std::move(fn)});
+  std::push_heap(heap_.begin(), heap_.end(), Less);
+}
+
+bool PriorityReadyQueue::Pop(std::function<void()>* fn) {
+  std::lock_guard<std::mutex> guard(mutex_);
+  if (heap_.empty()) {
+    return false;
+  }
+  std::pop_heap(heap_.begin(), heap_.end(), Less);
+  *fn = std::move(heap_.back().fn);
+  heap_.pop_back();
+  return true;
+}
+
+size_t PriorityReadyQueue::Size() {
+  std::lock_guard<std::mutex> guard(mutex_);
+  return heap_.size();
+}
+
+void PriorityReadyQueue::Clear() {
+  std::lock_guard<std::mutex> guard(mutex_);
+  heap_.clear();
+}
+
 }  // namespace framework
 }  // namespace paddle
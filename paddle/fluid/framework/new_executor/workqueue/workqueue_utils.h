@@ -18,9 +18,12 @@
 #include <cassert>
 #include <cstddef>
 #include <cstdlib>
+#include <functional>
 #include <memory>
+#include <mutex>  // NOLINT
 #include <set>
 #include <string>
+#include <vector>
 
 #include "paddle/fluid/framework/new_executor/workqueue/events_waiter.h"
 #include "paddle/fluid/platform/enforce.h"
@@ -105,5 +108,41 @@ class TaskTracker {
   Notifier* notifier_{nullptr};
 };
 
+// A ready queue ordered by priority, the task with the highest priority pops
+// first and the tasks with the same priority pop in FIFO order.
+class PriorityReadyQueue {
+ public:
+  PriorityReadyQueue() = default;
+
+  PriorityReadyQueue(const PriorityReadyQueue&) = delete;
+
+  PriorityReadyQueue& operator=(const PriorityReadyQueue&) = delete;
+
+  void Push(double priority, std::function<void()> fn);
+
+  // Return false when the queue is empty.
+  bool Pop(std::function<void()>* fn);
+
+  size_t Size();
+
+  void Clear();
+
+ private:
+  struct Item {
+    double priority;
+    uint64_t seq;
+    std::function<void()> fn;
+  };
+
+  static bool Less(const Item& a, const Item& b) {
+    return a.priority < b.priority ||
+           (a.priority == b.priority && a.seq > b.seq);
+  }
+
+  std::mutex mutex_;
+  std::vector<Item> heap_;
+  uint64_t seq_{0};
+};
+
 }  // namespace framework
 }  // namespace paddle
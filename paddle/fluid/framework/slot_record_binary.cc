@@ -0,0 +1,427 @@
+/* Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/fluid/framework/slot_record_binary.h"
+
+#include <algorithm>
+#include <cstring>
+#include <exception>
+
+#include "glog/logging.h"
+#include "paddle/fluid/platform/enforce.h"
+
+namespace paddle {
+namespace framework {
+
+namespace {
+
+inline void PutVarint(std::string* buf, uint64_t v) {
+  char tmp[10];
+  int len = 0;
+  while (v >= 0x80) {
+    tmp[len++] = static_cast<char>(v | 0x80);
+    v >>= 7;
+  }
+  tmp[len++] = static_cast<char>(v);
+  buf->append(tmp, len);
+}
+
+inline uint64_t GetVarint(const char** ptr, const char* end) {
+  const uint8_t* p = reinterpret_cast<const uint8_t*>(*ptr);
+  uint64_t v = 0;
+  for (int shift = 0; shift < 64; shift += 7) {
+    if (reinterpret_cast<const char*>(p) >= end) {
+      PADDLE_THROW(platform::errors::InvalidArgument(
+          "Truncated varint in slot record binary file."));
+    }
+    uint64_t byte = *p++;
+    v |= (byte & 0x7F) << shift;
+    if (byte < 0x80) {
+      break;
+    }
+  }
+  *ptr = reinterpret_cast<const char*>(p);
+  return v;
+}
+
+inline uint64_t ZigZagEncode(int64_t v) {
+  return (static_cast<uint64_t>(v) << 1) ^ static_cast<uint64_t>(v >> 63);
+}
+
+inline int64_t ZigZagDecode(uint64_t v) {
+  return static_cast<int64_t>(v >> 1) ^ -static_cast<int64_t>(v & 1);
+}
+
+inline void PutString(std::string* buf, const std::string& str) {
+  PutVarint(buf, str.size());
+  buf->append(str);
+}
+
+inline uint32_t SlotCount(const std::vector<uint32_t>& offsets, size_t slot) {
+  if (slot + 1 >= offsets.size()) {
+    return 0;
+  }
+  return offsets[slot + 1] - offsets[slot];
+}
+
+}  // namespace
+
+SlotRecordBinaryWriter::SlotRecordBinaryWriter(
+    std::shared_ptr<FILE> fp,
+    const SlotRecordBinaryHeader& header,
+    int block_size)
+    : fp_(fp), header_(header), block_size_(block_size) {
+  PADDLE_ENFORCE_NOT_NULL(
+      fp_.get(),
+      platform::errors::InvalidArgument(
+          "The file of SlotRecordBinaryWriter should not be null."));
+  PADDLE_ENFORCE_GT(block_size_,
+                    0,
+                    platform::errors::InvalidArgument(
+                        "The block size of slot record binary file should be "
+                        "greater than 0, but received %d.",
+                        block_size_));
+
+  std::string head;
+  head.append(reinterpret_cast<const char*>(&header_.version),
+              sizeof(uint32_t));
+  head.append(reinterpret_cast<const char*>(&header_.flags), sizeof(uint32_t));
+  PutVarint(&head, header_.uint64_slots.size());
+  for (auto& slot : header_.uint64_slots) {
+    PutString(&head, slot);
+  }
+  PutVarint(&head, header_.float_slots.size());
+  for (auto& slot : header_.float_slots) {
+    PutString(&head, slot);
+  }
+  uint32_t head_len = static_cast<uint32_t>(head.size());
+  WriteRaw(&kSlotRecordBinaryMagic, sizeof(kSlotRecordBinaryMagic));
+  WriteRaw(&head_len, sizeof(head_len));
+  WriteRaw(head.data(), head.size());
+}
+
+SlotRecordBinaryWriter::~SlotRecordBinaryWriter() {
+  if (finished_) {
+    return;
+  }
+  // never throw out of the destructor, a file without the index is still
+  // readable block by block
+  try {
+    Finish();
+  } catch (std::exception& e) {
+    LOG(ERROR) << "Failed to write the index of slot record binary file: "
+               << e.what();
+  }
+}
+
+void SlotRecordBinaryWriter::WriteRaw(const void* data, size_t len) {
+  PADDLE_ENFORCE_EQ(fwrite(data, 1, len, fp_.get()),
+                    len,
+                    platform::errors::Unavailable(
+                        "Failed to write %d bytes into slot record binary "
+                        "file.",
+                        len));
+  offset_ += len;
+}
+
+void SlotRecordBinaryWriter::Write(const SlotRecord* recs, size_t num) {
+  for (size_t i = 0; i < num; i += block_size_) {
+    size_t ins_num = std::min(num - i, static_cast<size_t>(block_size_));
+    WriteBlock(recs + i, ins_num);
+  }
+}
+
+void SlotRecordBinaryWriter::WriteBlock(const SlotRecord* recs,
+                                        size_t ins_num) {
+  const size_t uint64_slot_num = header_.uint64_slots.size();
+  const size_t float_slot_num = header_.float_slots.size();
+
+  buffer_.clear();
+  if (header_.has_ins_id()) {
+    for (size_t i = 0; i < ins_num; ++i) {
+      auto rec = recs[i];
+      PutString(&buffer_, rec->ins_id_);
+    }
+  }
+  if (header_.has_log_key()) {
+    for (size_t i = 0; i < ins_num; ++i) {
+      auto rec = recs[i];
+      PutVarint(&buffer_, rec->search_id);
+      PutVarint(&buffer_, rec->cmatch);
+      PutVarint(&buffer_, rec->rank);
+    }
+  }
+  for (size_t slot = 0; slot < uint64_slot_num; ++slot) {
+    for (size_t i = 0; i < ins_num; ++i) {
+      auto rec = recs[i];
+      PutVarint(&buffer_,
+                SlotCount(rec->slot_uint64_feasigns_.slot_offsets, slot));
+    }
+  }
+  for (size_t slot = 0; slot < float_slot_num; ++slot) {
+    for (size_t i = 0; i < ins_num; ++i) {
+      auto rec = recs[i];
+      PutVarint(&buffer_,
+                SlotCount(rec->slot_float_feasigns_.slot_offsets, slot));
+    }
+  }
+  // feasigns of one slot are usually generated by the same hash prefix, so
+  // the delta to the previous feasign in the column is much shorter than the
+  // feasign itself.
+  for (size_t slot = 0; slot < uint64_slot_num; ++slot) {
+    uint64_t prev = 0;
+    for (size_t i = 0; i < ins_num; ++i) {
+      auto rec = recs[i];
+      auto& values = rec->slot_uint64_feasigns_;
+      uint32_t num = SlotCount(values.slot_offsets, slot);
+      if (num == 0) {
+        continue;
+      }
+      const uint64_t* feas = &values.slot_values[values.slot_offsets[slot]];
+      for (uint32_t j = 0; j < num; ++j) {
+        PutVarint(&buffer_,
+                  ZigZagEncode(static_cast<int64_t>(feas[j] - prev)));
+        prev = feas[j];
+      }
+    }
+  }
+  for (size_t slot = 0; slot < float_slot_num; ++slot) {
+    for (size_t i = 0; i < ins_num; ++i) {
+      auto rec = recs[i];
+      auto& values = rec->slot_float_feasigns_;
+      uint32_t num = SlotCount(values.slot_offsets, slot);
+      if (num == 0) {
+        continue;
+      }
+      buffer_.append(reinterpret_cast<const char*>(
+                         &values.slot_values[values.slot_offsets[slot]]),
+                     num * sizeof(float));
+    }
+  }
+
+  index_.push_back({offset_, static_cast<uint32_t>(ins_num)});
+  uint32_t block_head[2] = {kSlotRecordBlockMagic,
+                            static_cast<uint32_t>(ins_num)};
+  uint64_t payload_bytes = buffer_.size();
+  WriteRaw(block_head, sizeof(block_head));
+  WriteRaw(&payload_bytes, sizeof(payload_bytes));
+  WriteRaw(buffer_.data(), buffer_.size());
+
+  ins_num_ += ins_num;
+}
+
+void SlotRecordBinaryWriter::Finish() {
+  uint64_t index_offset = offset_;
+  uint32_t index_head[2] = {kSlotRecordIndexMagic,
+                            static_cast<uint32_t>(index_.size())};
+  WriteRaw(index_head, sizeof(index_head));
+  for (auto& idx : index_) {
+    WriteRaw(&idx.offset, sizeof(idx.offset));
+    WriteRaw(&idx.ins_num, sizeof(idx.ins_num));
+  }
+  WriteRaw(&index_offset, sizeof(index_offset));
+  WriteRaw(&kSlotRecordIndexMagic, sizeof(kSlotRecordIndexMagic));
+  fflush(fp_.get());
+  finished_ = true;
+}
+
+SlotRecordBinaryReader::SlotRecordBinaryReader(std::shared_ptr<FILE> fp)
+    : fp_(fp) {
+  PADDLE_ENFORCE_NOT_NULL(
+      fp_.get(),
+      platform::errors::InvalidArgument(
+          "The file of SlotRecordBinaryReader should not be null."));
+  uint32_t magic = 0;
+  ReadRaw(&magic, sizeof(magic));
+  PADDLE_ENFORCE_EQ(magic,
+                    kSlotRecordBinaryMagic,
+                    platform::errors::InvalidArgument(
+                        "The file is not a slot record binary file, magic "
+                        "number is %x.",
+                        magic));
+  uint32_t head_len = 0;
+  ReadRaw(&head_len, sizeof(head_len));
+  PADDLE_ENFORCE_GE(head_len,
+                    2 * sizeof(uint32_t),
+                    platform::errors::InvalidArgument(
+                        "Invalid slot record binary file header."));
+  buffer_.resize(head_len);
+  ReadRaw(&buffer_[0], head_len);
+
+  const char* ptr = buffer_.data();
+  const char* end = ptr + buffer_.size();
+  memcpy(&header_.version, ptr, sizeof(uint32_t));
+  memcpy(&header_.flags, ptr + sizeof(uint32_t), sizeof(uint32_t));
+  ptr += 2 * sizeof(uint32_t);
+  PADDLE_ENFORCE_LE(header_.version,
+                    kSlotRecordBinaryVersion,
+                    platform::errors::Unimplemented(
+                        "Unsupported slot record binary version %d, the max "
+                        "supported version is %d.",
+                        header_.version,
+                        kSlotRecordBinaryVersion));
+  auto read_slots = [&ptr, end](std::vector<std::string>* slots) {
+    size_t num = GetVarint(&ptr, end);
+    slots->resize(num);
+    for (size_t i = 0; i < num; ++i) {
+      size_t len = GetVarint(&ptr, end);
+      PADDLE_ENFORCE_LE(len,
+                        static_cast<size_t>(end - ptr),
+                        platform::errors::InvalidArgument(
+                            "Invalid slot record binary file header."));
+      (*slots)[i].assign(ptr, len);
+      ptr += len;
+    }
+  };
+  read_slots(&header_.uint64_slots);
+  read_slots(&header_.float_slots);
+}
+
+void SlotRecordBinaryReader::ReadRaw(void* data, size_t len) {
+  PADDLE_ENFORCE_EQ(fread(data, 1, len, fp_.get()),
+                    len,
+                    platform::errors::InvalidArgument(
+                        "Unexpected end of slot record binary file."));
+  bytes_ += len;
+}
+
+int SlotRecordBinaryReader::NextBlock() {
+  uint32_t block_head[2] = {0, 0};
+  if (fread(block_head, sizeof(uint32_t), 1, fp_.get()) != 1) {
+    // tolerate the files whose index was lost, e.g. truncated by cat/split
+    return 0;
+  }
+  bytes_ += sizeof(uint32_t);
+  if (block_head[0] == kSlotRecordIndexMagic) {
+    return 0;
+  }
+  PADDLE_ENFORCE_EQ(block_head[0],
+                    kSlotRecordBlockMagic,
+                    platform::errors::InvalidArgument(
+                        "Invalid block magic %x in slot record binary file.",
+                        block_head[0]));
+  ReadRaw(&block_head[1], sizeof(uint32_t));
+  uint64_t payload_bytes = 0;
+  ReadRaw(&payload_bytes, sizeof(payload_bytes));
+  buffer_.resize(payload_bytes);
+  if (payload_bytes > 0) {
+    ReadRaw(&buffer_[0], payload_bytes);
+  }
+  block_ins_num_ = static_cast<int>(block_head[1]);
+  return block_ins_num_;
+}
+
+void SlotRecordBinaryReader::DecodeBlock(SlotRecord* recs, int num) {
+  PADDLE_ENFORCE_EQ(num,
+                    block_ins_num_,
+                    platform::errors::InvalidArgument(
+                        "The record num %d does not match the block ins "
+                        "num %d.",
+                        num,
+                        block_ins_num_));
+  const char* ptr = buffer_.data();
+  const char* end = ptr + buffer_.size();
+  const size_t uint64_slot_num = header_.uint64_slots.size();
+  const size_t float_slot_num = header_.float_slots.size();
+
+  if (header_.has_ins_id()) {
+    for (int i = 0; i < num; ++i) {
+      size_t len = GetVarint(&ptr, end);
+      PADDLE_ENFORCE_LE(len,
+                        static_cast<size_t>(end - ptr),
+                        platform::errors::InvalidArgument(
+                            "Truncated ins_id in slot record binary block."));
+      recs[i]->ins_id_.assign(ptr, len);
+      ptr += len;
+    }
+  }
+  if (header_.has_log_key()) {
+    for (int i = 0; i < num; ++i) {
+      recs[i]->search_id = GetVarint(&ptr, end);
+      recs[i]->cmatch = static_cast<uint32_t>(GetVarint(&ptr, end));
+      recs[i]->rank = static_cast<uint32_t>(GetVarint(&ptr, end));
+    }
+  }
+
+  // counts are stored column by column, convert them into the per record
+  // slot offsets which SlotValues expects.
+  uint64_counts_.resize(uint64_slot_num * num);
+  float_counts_.resize(float_slot_num * num);
+  for (size_t k = 0; k < uint64_counts_.size(); ++k) {
+    uint64_counts_[k] = static_cast<uint32_t>(GetVarint(&ptr, end));
+  }
+  for (size_t k = 0; k < float_counts_.size(); ++k) {
+    float_counts_[k] = static_cast<uint32_t>(GetVarint(&ptr, end));
+  }
+  for (int i = 0; i < num; ++i) {
+    auto& uint64_values = recs[i]->slot_uint64_feasigns_;
+    uint64_values.slot_offsets.resize(uint64_slot_num + 1);
+    uint32_t total = 0;
+    for (size_t slot = 0; slot < uint64_slot_num; ++slot) {
+      uint64_values.slot_offsets[slot] = total;
+      total += uint64_counts_[slot * num + i];
+    }
+    uint64_values.slot_offsets[uint64_slot_num] = total;
+    uint64_values.slot_values.resize(total);
+
+    auto& float_values = recs[i]->slot_float_feasigns_;
+    float_values.slot_offsets.resize(float_slot_num + 1);
+    total = 0;
+    for (size_t slot = 0; slot < float_slot_num; ++slot) {
+      float_values.slot_offsets[slot] = total;
+      total += float_counts_[slot * num + i];
+    }
+    float_values.slot_offsets[float_slot_num] = total;
+    float_values.slot_values.resize(total);
+  }
+
+  for (size_t slot = 0; slot < uint64_slot_num; ++slot) {
+    uint64_t prev = 0;
+    for (int i = 0; i < num; ++i) {
+      uint32_t cnt = uint64_counts_[slot * num + i];
+      auto& values = recs[i]->slot_uint64_feasigns_;
+      uint64_t* feas = values.slot_values.data() + values.slot_offsets[slot];
+      for (uint32_t j = 0; j < cnt; ++j) {
+        prev += static_cast<uint64_t>(ZigZagDecode(GetVarint(&ptr, end)));
+        feas[j] = prev;
+      }
+    }
+  }
+  for (size_t slot = 0; slot < float_slot_num; ++slot) {
+    for (int i = 0; i < num; ++i) {
+      uint32_t cnt = float_counts_[slot * num + i];
+      if (cnt == 0) {
+        continue;
+      }
+      size_t len = cnt * sizeof(float);
+      PADDLE_ENFORCE_LE(len,
+                        static_cast<size_t>(end - ptr),
+                        platform::errors::InvalidArgument(
+                            "Truncated float values in slot record binary "
+                            "block."));
+      auto& values = recs[i]->slot_float_feasigns_;
+      memcpy(values.slot_values.data() + values.slot_offsets[slot], ptr, len);
+      ptr += len;
+    }
+  }
+  PADDLE_ENFORCE_EQ(ptr == end,
+                    true,
+                    platform::errors::InvalidArgument(
+                        "The slot record binary block has %d bytes left "
+                        "after decoding.",
+                        end - ptr));
+}
+
+}  // namespace framework
+}  // namespace paddle
@@ -0,0 +1,130 @@
+/* Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#pragma once
+
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "paddle/fluid/framework/data_feed.h"
+
+namespace paddle {
+namespace framework {
+
+// Binary slot-columnar file format of SlotRecord instances, which can be
+// loaded by SlotRecordInMemoryDataFeed without any text parsing.
+//
+// File layout:
+//   FileHeader | Block 0 | Block 1 | ... | Block N-1 | BlockIndex | Footer
+//
+// FileHeader: magic, header length, version, flags, used uint64 and float
+//   slot names.
+// Block: BlockHeader(magic, ins_num, payload_bytes) followed by a payload
+//   which stores the instances column by column:
+//     [ins_id]          varint length + bytes        (kHasInsId)
+//     [log key]         varint search_id/cmatch/rank (kHasLogKey)
+//     uint64 counts     one varint column per uint64 slot
+//     float counts      one varint column per float slot
+//     uint64 values     zigzag delta varints, one column per uint64 slot
+//     float values      raw little-endian floats, one column per float slot
+// BlockIndex: (offset, ins_num) of every block, so that a local file can be
+//   split or inspected without decoding. Readers which stream the file (e.g.
+//   through a hdfs pipe) stop at the index magic and never need to seek.
+static const uint32_t kSlotRecordBinaryMagic = 0x52534450;  // "PDSR"
+static const uint32_t kSlotRecordBlockMagic = 0x4B4C4253;   // "SBLK"
+static const uint32_t kSlotRecordIndexMagic = 0x58444953;   // "SIDX"
+static const uint32_t kSlotRecordBinaryVersion = 1;
+static const int kSlotRecordDefaultBlockSize = OBJPOOL_BLOCK_SIZE;
+
+struct SlotRecordBinaryHeader {
+  enum Flags : uint32_t {
+    kHasInsId = 1,
+    kHasLogKey = 2,
+  };
+  uint32_t version = kSlotRecordBinaryVersion;
+  uint32_t flags = 0;
+  std::vector<std::string> uint64_slots;
+  std::vector<std::string> float_slots;
+
+  bool has_ins_id() const { return (flags & kHasInsId) != 0; }
+  bool has_log_key() const { return (flags & kHasLogKey) != 0; }
+};
+
+struct SlotRecordBlockIndex {
+  uint64_t offset;
+  uint32_t ins_num;
+};
+
+class SlotRecordBinaryWriter {
+ public:
+  SlotRecordBinaryWriter(std::shared_ptr<FILE> fp,
+                         const SlotRecordBinaryHeader& header,
+                         int block_size = kSlotRecordDefaultBlockSize);
+  ~SlotRecordBinaryWriter();
+
+  // Encode the records into blocks of at most block_size instances. The
+  // records are only read, the caller still owns them.
+  void Write(const SlotRecord* recs, size_t num);
+  // Write the block index and the footer. It is called by the destructor if
+  // the caller did not call it, where a failure is logged instead of thrown.
+  void Finish();
+
+  size_t ins_num() const { return ins_num_; }
+  size_t bytes() const { return offset_; }
+
+ private:
+  void WriteRaw(const void* data, size_t len);
+  void WriteBlock(const SlotRecord* recs, size_t ins_num);
+
+  std::shared_ptr<FILE> fp_;
+  SlotRecordBinaryHeader header_;
+  int block_size_;
+  bool finished_ = false;
+  size_t ins_num_ = 0;
+  uint64_t offset_ = 0;
+  std::string buffer_;
+  std::vector<SlotRecordBlockIndex> index_;
+};
+
+class SlotRecordBinaryReader {
+ public:
+  // Read and check the file header.
+  explicit SlotRecordBinaryReader(std::shared_ptr<FILE> fp);
+
+  const SlotRecordBinaryHeader& header() const { return header_; }
+  // Read the next block into the internal buffer and return its instance
+  // num, 0 means the end of the file.
+  int NextBlock();
+  // Decode the block read by NextBlock() into num reset SlotRecords, num
+  // must equal to the value returned by NextBlock().
+  void DecodeBlock(SlotRecord* recs, int num);
+
+  size_t bytes() const { return bytes_; }
+
+ private:
+  void ReadRaw(void* data, size_t len);
+
+  std::shared_ptr<FILE> fp_;
+  SlotRecordBinaryHeader header_;
+  int block_ins_num_ = 0;
+  size_t bytes_ = 0;
+  std::string buffer_;
+  std::vector<uint32_t> uint64_counts_;
+  std::vector<uint32_t> float_counts_;
+};
+
+}  // namespace framework
+}  // namespace paddle
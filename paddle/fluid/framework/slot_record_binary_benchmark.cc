@@ -0,0 +1,184 @@
+// Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Compare the LoadIntoMemory throughput of SlotRecordInMemoryDataFeed on the
+// text files and on the converted slot record binary files, e.g.
+//   slot_record_binary_benchmark --file_num=16 --ins_per_file=200000 \
+//       --thread_num=16
+
+#include <random>
+#include <thread>  // NOLINT
+
+#include "gflags/gflags.h"
+#include "glog/logging.h"
+#include "paddle/fluid/framework/data_feed.h"
+#include "paddle/fluid/framework/data_feed_factory.h"
+#include "paddle/fluid/framework/io/fs.h"
+#include "paddle/fluid/platform/timer.h"
+
+DEFINE_string(work_dir, "./slot_record_bench", "The directory of data files.");
+DEFINE_int32(file_num, 8, "The number of generated files.");
+DEFINE_int32(ins_per_file, 100000, "The number of instances per file.");
+DEFINE_int32(uint64_slot_num, 200, "The number of uint64 slots.");
+DEFINE_int32(float_slot_num, 2, "The number of float slots.");
+DEFINE_int32(max_fea_per_slot, 4, "The max number of feasigns per slot.");
+DEFINE_int32(thread_num, 8, "The number of loading threads.");
+DEFINE_int32(repeat, 3, "Repeat times of every load.");
+
+namespace paddle {
+namespace framework {
+
+static DataFeedDesc MakeDataFeedDesc() {
+  DataFeedDesc desc;
+  desc.set_name("SlotRecordInMemoryDataFeed");
+  desc.set_batch_size(512);
+  desc.set_pipe_command("cat");
+  auto* multi_slot = desc.mutable_multi_slot_desc();
+  for (int i = 0; i < FLAGS_float_slot_num; ++i) {
+    auto* slot = multi_slot->add_slots();
+    slot->set_name("float_" + std::to_string(i));
+    slot->set_type("float");
+    slot->set_is_dense(false);
+    slot->set_is_used(true);
+  }
+  for (int i = 0; i < FLAGS_uint64_slot_num; ++i) {
+    auto* slot = multi_slot->add_slots();
+    slot->set_name(std::to_string(6000 + i));
+    slot->set_type("uint64");
+    slot->set_is_dense(false);
+    slot->set_is_used(true);
+  }
+  return desc;
+}
+
+static void GenerateTextFile(const std::string& path, int seed) {
+  std::mt19937_64 rng(seed);
+  int err_no = 0;
+  auto fp = fs_open_write(path, &err_no, "");
+  std::string line;
+  for (int i = 0; i < FLAGS_ins_per_file; ++i) {
+    line.clear();
+    for (int s = 0; s < FLAGS_float_slot_num; ++s) {
+      line.append(" 1 " + std::to_string(rng() % 2));
+    }
+    for (int s = 0; s < FLAGS_uint64_slot_num; ++s) {
+      int num = 1 + rng() % FLAGS_max_fea_per_slot;
+      line.append(" " + std::to_string(num));
+      for (int k = 0; k < num; ++k) {
+        // feasigns of one slot share the slot prefix like the hashed logs
+        uint64_t sign =
+            (static_cast<uint64_t>(6000 + s) << 40) + rng() % 1000000;
+        line.append(" " + std::to_string(sign));
+      }
+    }
+    line.append("\n");
+    fwrite(line.data() + 1, 1, line.size() - 1, fp.get());
+  }
+}
+
+static double LoadFiles(const DataFeedDesc& desc,
+                        const std::vector<std::string>& files,
+                        size_t* ins_num) {
+  std::mutex file_mutex;
+  size_t file_idx = 0;
+  auto channel = MakeChannel<SlotRecord>();
+  std::vector<std::shared_ptr<DataFeed>> readers(FLAGS_thread_num);
+  for (int i = 0; i < FLAGS_thread_num; ++i) {
+    readers[i] = DataFeedFactory::CreateDataFeed("SlotRecordInMemoryDataFeed");
+    readers[i]->Init(desc);
+    readers[i]->SetThreadId(i);
+    readers[i]->SetThreadNum(FLAGS_thread_num);
+    readers[i]->SetFileListMutex(&file_mutex);
+    readers[i]->SetFileListIndex(&file_idx);
+    readers[i]->SetFileList(files);
+    readers[i]->SetInputChannel(channel.get());
+  }
+  platform::Timer timeline;
+  timeline.Start();
+  std::vector<std::thread> threads;
+  for (auto& reader : readers) {
+    threads.emplace_back([reader]() { reader->LoadIntoMemory(); });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+  timeline.Pause();
+
+  std::vector<SlotRecord> records;
+  channel->Close();
+  channel->ReadAll(records);
+  *ins_num = records.size();
+  SlotRecordPool().put(&records);
+  return timeline.ElapsedSec();
+}
+
+static int BenchmarkMain() {
+  DataFeedDesc text_desc = MakeDataFeedDesc();
+  DataFeedDesc binary_desc = text_desc;
+  binary_desc.set_binary_slot_record(true);
+
+  std::vector<std::string> text_files;
+  std::vector<std::string> binary_files;
+  for (int i = 0; i < FLAGS_file_num; ++i) {
+    text_files.push_back(FLAGS_work_dir + "/text/part-" + std::to_string(i));
+    binary_files.push_back(FLAGS_work_dir + "/binary/part-" +
+                           std::to_string(i));
+    GenerateTextFile(text_files.back(), i);
+  }
+
+  auto feed = DataFeedFactory::CreateDataFeed("SlotRecordInMemoryDataFeed");
+  feed->Init(text_desc);
+  auto* slot_feed = dynamic_cast<SlotRecordInMemoryDataFeed*>(feed.get());
+  platform::Timer timeline;
+  timeline.Start();
+  for (int i = 0; i < FLAGS_file_num; ++i) {
+    slot_feed->ConvertTextToBinary(text_files[i], binary_files[i]);
+  }
+  timeline.Pause();
+  int64_t text_bytes = 0;
+  int64_t binary_bytes = 0;
+  for (int i = 0; i < FLAGS_file_num; ++i) {
+    text_bytes += fs_file_size(text_files[i]);
+    binary_bytes += fs_file_size(binary_files[i]);
+  }
+  LOG(INFO) << "convert " << FLAGS_file_num << " files cost "
+            << timeline.ElapsedSec() << " seconds, text size "
+            << text_bytes / 1024.0 / 1024.0 << "MB, binary size "
+            << binary_bytes / 1024.0 / 1024.0 << "MB";
+
+  for (int r = 0; r < FLAGS_repeat; ++r) {
+    size_t text_ins = 0;
+    size_t binary_ins = 0;
+    double text_sec = LoadFiles(text_desc, text_files, &text_ins);
+    double binary_sec = LoadFiles(binary_desc, binary_files, &binary_ins);
+    PADDLE_ENFORCE_EQ(text_ins,
+                      binary_ins,
+                      platform::errors::PreconditionNotMet(
+                          "The text and binary files load different ins num."));
+    LOG(INFO) << "repeat " << r << ", ins num " << text_ins << ", text "
+              << text_sec << "s (" << text_ins / text_sec << " ins/s), binary "
+              << binary_sec << "s (" << binary_ins / binary_sec
+              << " ins/s), speedup " << text_sec / binary_sec;
+  }
+  return 0;
+}
+
+}  // namespace framework
+}  // namespace paddle
+
+int main(int argc, char* argv[]) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  google::InitGoogleLogging(argv[0]);
+  return paddle::framework::BenchmarkMain();
+}
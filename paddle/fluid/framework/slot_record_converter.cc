@@ -0,0 +1,115 @@
+// Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Convert the text files of SlotRecordInMemoryDataFeed into the slot record
+// binary format, e.g.
+//   slot_record_converter --data_feed_desc=data_feed.prototxt \
+//       --input_files=part-00000,part-00001 --output_dir=./binary \
+//       --thread_num=16
+// The converted files keep the same file names, and can be loaded by setting
+// binary_slot_record of DataFeedDesc (dataset._set_binary_slot_record(True)).
+
+#include <fcntl.h>
+
+#include <atomic>
+#include <thread>  // NOLINT
+
+#include "gflags/gflags.h"
+#include "glog/logging.h"
+#include "google/protobuf/io/zero_copy_stream_impl.h"
+#include "google/protobuf/text_format.h"
+#include "paddle/fluid/framework/data_feed.h"
+#include "paddle/fluid/framework/data_feed_factory.h"
+#include "paddle/fluid/framework/io/fs.h"
+#include "paddle/fluid/platform/timer.h"
+#include "paddle/fluid/string/string_helper.h"
+
+DEFINE_string(data_feed_desc, "", "The DataFeedDesc file in text format.");
+DEFINE_string(input_files, "", "Comma separated text files to convert.");
+DEFINE_string(output_dir, "", "The directory of the converted files.");
+DEFINE_int32(thread_num, 1, "The number of converting threads.");
+DEFINE_bool(parse_ins_id, false, "Whether the text files contain ins_id.");
+DEFINE_bool(parse_logkey, false, "Whether the text files contain log key.");
+
+namespace paddle {
+namespace framework {
+
+static DataFeedDesc LoadDataFeedDesc(const std::string& filename) {
+  DataFeedDesc desc;
+  int fd = open(filename.c_str(), O_RDONLY);
+  PADDLE_ENFORCE_NE(fd,
+                    -1,
+                    platform::errors::Unavailable(
+                        "Cannot open data feed desc file %s.", filename));
+  google::protobuf::io::FileInputStream input(fd);
+  PADDLE_ENFORCE_EQ(google::protobuf::TextFormat::Parse(&input, &desc),
+                    true,
+                    platform::errors::InvalidArgument(
+                        "Failed to parse data feed desc file %s.", filename));
+  close(fd);
+  return desc;
+}
+
+static int ConvertMain() {
+  PADDLE_ENFORCE_EQ(FLAGS_data_feed_desc.empty() || FLAGS_input_files.empty() ||
+                        FLAGS_output_dir.empty(),
+                    false,
+                    platform::errors::InvalidArgument(
+                        "--data_feed_desc, --input_files and --output_dir "
+                        "should be set."));
+  DataFeedDesc desc = LoadDataFeedDesc(FLAGS_data_feed_desc);
+  std::vector<std::string> files =
+      string::split_string<std::string>(FLAGS_input_files, ",");
+
+  std::atomic<size_t> file_idx(0);
+  std::atomic<size_t> total_ins(0);
+  platform::Timer timeline;
+  timeline.Start();
+  std::vector<std::thread> threads;
+  for (int i = 0; i < FLAGS_thread_num; ++i) {
+    threads.emplace_back([&desc, &files, &file_idx, &total_ins]() {
+      auto feed = DataFeedFactory::CreateDataFeed("SlotRecordInMemoryDataFeed");
+      feed->Init(desc);
+      feed->SetParseInsId(FLAGS_parse_ins_id);
+      feed->SetParseLogKey(FLAGS_parse_logkey);
+      auto* slot_feed = dynamic_cast<SlotRecordInMemoryDataFeed*>(feed.get());
+      size_t idx = 0;
+      while ((idx = file_idx++) < files.size()) {
+        const std::string& src = files[idx];
+        std::string dst =
+            FLAGS_output_dir + "/" + src.substr(src.find_last_of('/') + 1);
+        size_t ins_num = slot_feed->ConvertTextToBinary(src, dst);
+        total_ins += ins_num;
+        LOG(INFO) << "convert " << src << " -> " << dst << ", ins num "
+                  << ins_num;
+      }
+    });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+  timeline.Pause();
+  LOG(INFO) << "convert " << files.size() << " files, " << total_ins.load()
+            << " instances, cost " << timeline.ElapsedSec() << " seconds";
+  return 0;
+}
+
+}  // namespace framework
+}  // namespace paddle
+
+int main(int argc, char* argv[]) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  google::InitGoogleLogging(argv[0]);
+  return paddle::framework::ConvertMain();
+}
@@ -45,6 +45,7 @@
 #include "paddle/fluid/inference/api/paddle_inference_pass.h"
 #include "paddle/fluid/inference/api/resource_manager.h"
 #include "paddle/fluid/inference/utils/io_utils.h"
+#include "paddle/fluid/inference/utils/mmap_params.h"
 #include "paddle/fluid/inference/utils/model_utils.h"
 #include "paddle/fluid/inference/utils/singleton.h"
 #include "paddle/fluid/memory/memcpy.h"
@@ -1811,6 +1812,15 @@ bool AnalysisPredictor::LoadParameters() {
     }
   }
 
+  if (!config_.params_file().empty() && !config_.model_from_memory() &&
+      inference::IsMmapParamsFile(config_.params_file())) {
+    // the tensors point to the pages of the file, nothing is deserialized.
+    inference::LoadMmapParams(
+        config_.params_file(), params, scope_.get(), place_);
+    VLOG(3) << "get " << scope_->LocalVarNames().size() << " vars after mmap";
+    return true;
+  }
+
   if (!config_.params_file().empty()) {
     // sort paramlist to have consistent ordering
     std::sort(params.begin(), params.end());
@@ -20,10 +20,14 @@
 #include <glog/logging.h>
 #include <gtest/gtest.h>
 
+#include <fstream>
+#include <map>
 #include <thread>  // NOLINT
 
 #include "paddle/fluid/framework/ir/pass.h"
+#include "paddle/fluid/framework/program_desc.h"
 #include "paddle/fluid/framework/tensor.h"
+#include "paddle/fluid/inference/analysis/helper.h"
 #include "paddle/fluid/inference/api/helper.h"
 #include "paddle/fluid/inference/api/paddle_api.h"
 #include "paddle/fluid/inference/api/paddle_inference_api.h"
@@ -463,6 +467,273 @@ TEST(Tensor, CpuShareExternalData) {
   predictor->TryShrinkMemory();
 }
 
+static std::vector<paddle::PaddleTensor> Word2vecInputs(int batch_size,
+                                                         int seed) {
+  std::vector<paddle::PaddleTensor> inputs;
+  for (auto name : {"firstw", "secondw", "thirdw", "forthw"}) {
+    paddle::PaddleTensor input;
+    input.name = name;
+    input.dtype = paddle::PaddleDType::INT64;
+    input.shape = {batch_size, 1};
+    input.data.Resize(batch_size * sizeof(int64_t));
+    auto* data = static_cast<int64_t*>(input.data.data());
+    for (int i = 0; i < batch_size; ++i) {
+      data[i] = (seed * 7 + i * 13 + inputs.size()) % 1000;
+    }
+    inputs.push_back(std::move(input));
+  }
+  return inputs;
+}
+
+TEST(BatchingPredictor, Run) {
+  Config config;
+  config.SetModel(FLAGS_dirname);
+  auto predictor = CreatePredictor(config);
+
+  services::BatchingConfig batching_config;
+  batching_config.max_batch_size = 8;
+  batching_config.batch_timeout_us = 10000;
+  batching_config.num_predictors = 2;
+  services::BatchingPredictor batching_predictor(config, batching_config);
+
+  const int thread_num = 4, request_num = 10;
+  std::vector<std::vector<std::vector<paddle::PaddleTensor>>> inputs(
+      thread_num);
+  std::vector<std::vector<std::vector<paddle::PaddleTensor>>> outputs(
+      thread_num, std::vector<std::vector<paddle::PaddleTensor>>(request_num));
+  for (int t = 0; t < thread_num; ++t) {
+    for (int i = 0; i < request_num; ++i) {
+      inputs[t].push_back(Word2vecInputs(1 + (t + i) % 3, t * request_num + i));
+    }
+  }
+  std::vector<std::thread> threads;
+  for (int t = 0; t < thread_num; ++t) {
+    threads.emplace_back([&, t] {
+      for (int i = 0; i < request_num; ++i) {
+        ASSERT_TRUE(batching_predictor.Run(inputs[t][i], &outputs[t][i]));
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  // the same as running the requests alone
+  for (int t = 0; t < thread_num; ++t) {
+    for (int i = 0; i < request_num; ++i) {
+      for (auto& input : inputs[t][i]) {
+        auto tensor = predictor->GetInputHandle(input.name);
+        tensor->Reshape(input.shape);
+        tensor->CopyFromCpu(static_cast<int64_t*>(input.data.data()));
+      }
+      ASSERT_TRUE(predictor->Run());
+      auto out = predictor->GetOutputHandle("fc_1.tmp_2");
+      auto out_shape = out->shape();
+      std::vector<float> out_data(std::accumulate(
+          out_shape.begin(), out_shape.end(), 1, std::multiplies<int>()));
+      out->CopyToCpu(out_data.data());
+
+      ASSERT_EQ(outputs[t][i].size(), 1UL);
+      const auto& batched = outputs[t][i][0];
+      ASSERT_EQ(batched.shape, out_shape);
+      const float* batched_data = static_cast<float*>(batched.data.data());
+      for (size_t j = 0; j < out_data.size(); ++j) {
+        ASSERT_NEAR(batched_data[j], out_data[j], 1e-5);
+      }
+    }
+  }
+}
+
+// Saves the model of out = scale(x, 2), and mean_out = mean(x) which can not
+// be split by the requests if with_mean, x is a float tensor of [-1, -1].
+static std::string SaveScaleModel(const std::string& dir, bool with_mean) {
+  namespace framework = paddle::framework;
+  framework::ProgramDesc program;
+  auto* block = program.MutableBlock(0);
+  auto* feed = block->Var("feed");
+  feed->SetType(framework::proto::VarType::FEED_MINIBATCH);
+  feed->SetPersistable(true);
+  auto* fetch = block->Var("fetch");
+  fetch->SetType(framework::proto::VarType::FETCH_LIST);
+  fetch->SetPersistable(true);
+  for (auto* name : {"x", "out", "mean_out"}) {
+    auto* var = block->Var(name);
+    var->SetType(framework::proto::VarType::LOD_TENSOR);
+    var->SetDataType(framework::proto::VarType::FP32);
+    var->SetShape({-1, -1});
+  }
+  block->FindVar("mean_out")->SetShape({1});
+
+  auto* op = block->AppendOp();
+  op->SetType("feed");
+  op->SetInput("X", {"feed"});
+  op->SetOutput("Out", {"x"});
+  op->SetAttr("col", 0);
+  op = block->AppendOp();
+  op->SetType("scale");
+  op->SetInput("X", {"x"});
+  op->SetOutput("Out", {"out"});
+  op->SetAttr("scale", 2.0f);
+  op->SetAttr("bias", 0.0f);
+  op->SetAttr("bias_after_scale", true);
+  std::vector<std::string> outputs = {"out"};
+  if (with_mean) {
+    op = block->AppendOp();
+    op->SetType("mean");
+    op->SetInput("X", {"x"});
+    op->SetOutput("Out", {"mean_out"});
+    outputs.push_back("mean_out");
+  }
+  for (size_t i = 0; i < outputs.size(); ++i) {
+    op = block->AppendOp();
+    op->SetType("fetch");
+    op->SetInput("X", {outputs[i]});
+    op->SetOutput("Out", {"fetch"});
+    op->SetAttr("col", static_cast<int>(i));
+  }
+
+  paddle::inference::analysis::MakeDirIfNotExists(dir);
+  std::ofstream file(dir + "/__model__", std::ios::binary);
+  file << program.Proto()->SerializeAsString();
+  return dir;
+}
+
+static paddle::PaddleTensor FloatInput(int rows,
+                                       int cols,
+                                       const std::vector<size_t>& lod = {}) {
+  paddle::PaddleTensor input;
+  input.name = "x";
+  input.dtype = paddle::PaddleDType::FLOAT32;
+  input.shape = {rows, cols};
+  if (!lod.empty()) {
+    input.lod = {lod};
+  }
+  input.data.Resize(rows * cols * sizeof(float));
+  auto* data = static_cast<float*>(input.data.data());
+  for (int i = 0; i < rows * cols; ++i) {
+    data[i] = rows * 100 + cols * 10 + i;
+  }
+  return input;
+}
+
+// Runs every request on its own thread, all of them are in one batch as
+// max_batch_size is their total batch size.
+static void RunInOneBatch(
+    const std::string& model_dir,
+    bool pad_variable_length,
+    const std::vector<std::vector<paddle::PaddleTensor>>& inputs,
+    std::vector<std::vector<paddle::PaddleTensor>>* outputs,
+    const std::map<std::string, std::string>& sequence_outputs = {}) {
+  Config config;
+  config.SetModel(model_dir);
+  services::BatchingConfig batching_config;
+  batching_config.max_batch_size = 0;
+  for (auto& input : inputs) {
+    batching_config.max_batch_size += input[0].lod.empty()
+                                          ? input[0].shape[0]
+                                          : input[0].lod[0].size() - 1;
+  }
+  batching_config.batch_timeout_us = 2000000;
+  batching_config.pad_variable_length = pad_variable_length;
+  batching_config.sequence_outputs = sequence_outputs;
+  services::BatchingPredictor predictor(config, batching_config);
+
+  outputs->resize(inputs.size());
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < inputs.size(); ++i) {
+    threads.emplace_back([&, i] {
+      ASSERT_TRUE(predictor.Run(inputs[i], &(*outputs)[i]));
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+}
+
+static void ExpectScaled(const paddle::PaddleTensor& x,
+                         const paddle::PaddleTensor& out) {
+  ASSERT_EQ(out.name, "out");
+  ASSERT_EQ(out.shape, x.shape);
+  ASSERT_EQ(out.lod, x.lod);
+  const float* x_data = static_cast<const float*>(x.data.data());
+  const float* out_data = static_cast<const float*>(out.data.data());
+  for (int i = 0; i < x.shape[0] * x.shape[1]; ++i) {
+    ASSERT_EQ(out_data[i], 2 * x_data[i]);
+  }
+}
+
+TEST(BatchingPredictor, PadVariableLength) {
+  std::string model_dir =
+      SaveScaleModel("./batching_predictor_scale_model", false);
+  // the sequence outputs are cut back to the lengths of the requests
+  std::vector<std::vector<paddle::PaddleTensor>> inputs = {
+      {FloatInput(1, 3)}, {FloatInput(2, 5)}, {FloatInput(1, 4)}};
+  std::vector<std::vector<paddle::PaddleTensor>> outputs;
+  RunInOneBatch(model_dir, true, inputs, &outputs, {{"out", "x"}});
+  for (size_t i = 0; i < inputs.size(); ++i) {
+    ASSERT_EQ(outputs[i].size(), 1UL);
+    ExpectScaled(inputs[i][0], outputs[i][0]);
+  }
+
+  // an output of the padded dim 1 which is not named may be a sequence or
+  // not, the requests are run one by one
+  outputs.clear();
+  RunInOneBatch(model_dir, true, inputs, &outputs);
+  for (size_t i = 0; i < inputs.size(); ++i) {
+    ASSERT_EQ(outputs[i].size(), 1UL);
+    ExpectScaled(inputs[i][0], outputs[i][0]);
+  }
+}
+
+TEST(BatchingPredictor, LoDInput) {
+  std::string model_dir =
+      SaveScaleModel("./batching_predictor_scale_model", false);
+  // the batch size is the number of the sequences, the outputs are split by
+  // the merged lod
+  std::vector<std::vector<paddle::PaddleTensor>> inputs = {
+      {FloatInput(3, 4, {0, 2, 3})},
+      {FloatInput(1, 4, {0, 1})},
+      {FloatInput(4, 4, {0, 1, 4})}};
+  std::vector<std::vector<paddle::PaddleTensor>> outputs;
+  RunInOneBatch(model_dir, false, inputs, &outputs);
+  for (size_t i = 0; i < inputs.size(); ++i) {
+    ASSERT_EQ(outputs[i].size(), 1UL);
+    ExpectScaled(inputs[i][0], outputs[i][0]);
+  }
+}
+
+TEST(BatchingPredictor, Unsplittable) {
+  std::string model_dir =
+      SaveScaleModel("./batching_predictor_mean_model", true);
+  // the mean of the batch is not the mean of any request, which are run
+  // again one by one
+  std::vector<std::vector<paddle::PaddleTensor>> inputs = {
+      {FloatInput(2, 3)}, {FloatInput(1, 3)}, {FloatInput(3, 3)}};
+  std::vector<std::vector<paddle::PaddleTensor>> outputs;
+  RunInOneBatch(model_dir, false, inputs, &outputs);
+  for (size_t i = 0; i < inputs.size(); ++i) {
+    ASSERT_EQ(outputs[i].size(), 2UL);
+    ExpectScaled(inputs[i][0], outputs[i][0]);
+    const auto& x = inputs[i][0];
+    const float* x_data = static_cast<const float*>(x.data.data());
+    int numel = x.shape[0] * x.shape[1];
+    float mean = std::accumulate(x_data, x_data + numel, 0.0f) / numel;
+    ASSERT_EQ(outputs[i][1].name, "mean_out");
+    ASSERT_EQ(outputs[i][1].shape, std::vector<int>({1}));
+    ASSERT_NEAR(
+        static_cast<float*>(outputs[i][1].data.data())[0], mean, 1e-3);
+  }
+}
+
+TEST(BatchingPredictor, InvalidConfig) {
+  Config config;
+  config.SetModel(FLAGS_dirname);
+  services::BatchingConfig batching_config;
+  batching_config.num_predictors = 0;
+  ASSERT_THROW(services::BatchingPredictor(config, batching_config),
+               paddle::platform::EnforceNotMet);
+}
+
 #if defined(PADDLE_WITH_CUDA)
 TEST(Tensor, GpuShareExternalData) {
   Config config;
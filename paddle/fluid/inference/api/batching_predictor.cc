@@ -0,0 +1,575 @@
+// Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+#include "glog/logging.h"
+#include "paddle/fluid/inference/api/paddle_inference_api.h"
+#include "paddle/fluid/platform/enforce.h"
+#include "paddle/fluid/platform/float16.h"
+
+namespace paddle_infer {
+namespace services {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+using float16 = paddle::platform::float16;
+
+size_t DtypeSize(DataType dtype) {
+  switch (dtype) {
+    case DataType::FLOAT32:
+      return sizeof(float);
+    case DataType::INT64:
+      return sizeof(int64_t);
+    case DataType::INT32:
+      return sizeof(int32_t);
+    case DataType::UINT8:
+      return sizeof(uint8_t);
+    case DataType::INT8:
+      return sizeof(int8_t);
+    case DataType::FLOAT16:
+      return sizeof(float16);
+    default:
+      PADDLE_THROW(paddle::platform::errors::Unimplemented(
+          "Unsupported data type %d of BatchingPredictor.",
+          static_cast<int>(dtype)));
+  }
+}
+
+size_t Numel(const std::vector<int>& shape, size_t begin = 0) {
+  size_t numel = 1;
+  for (size_t i = begin; i < shape.size(); ++i) {
+    numel *= shape[i];
+  }
+  return numel;
+}
+
+template <typename T>
+void Fill(char* data, size_t num, float value) {
+  std::fill_n(reinterpret_cast<T*>(data), num, static_cast<T>(value));
+}
+
+void FillValue(char* data, size_t num, DataType dtype, float value) {
+  switch (dtype) {
+    case DataType::FLOAT32:
+      return Fill<float>(data, num, value);
+    case DataType::INT64:
+      return Fill<int64_t>(data, num, value);
+    case DataType::INT32:
+      return Fill<int32_t>(data, num, value);
+    case DataType::UINT8:
+      return Fill<uint8_t>(data, num, value);
+    case DataType::INT8:
+      return Fill<int8_t>(data, num, value);
+    case DataType::FLOAT16:
+      return Fill<float16>(data, num, value);
+    default:
+      PADDLE_THROW(paddle::platform::errors::Unimplemented(
+          "Unsupported data type %d of BatchingPredictor.",
+          static_cast<int>(dtype)));
+  }
+}
+
+// Copies the block at the origin of src to the origin of dst, the block is no
+// larger than src or dst in any dim.
+void CopyBlock(const char* src,
+               const std::vector<int>& src_shape,
+               char* dst,
+               const std::vector<int>& dst_shape,
+               const std::vector<int>& block,
+               size_t dim,
+               size_t elem_size) {
+  size_t src_stride = Numel(src_shape, dim + 1) * elem_size;
+  size_t dst_stride = Numel(dst_shape, dim + 1) * elem_size;
+  bool contiguous = true;
+  for (size_t i = dim + 1; i < block.size(); ++i) {
+    contiguous = contiguous && src_shape[i] == block[i] &&
+                 dst_shape[i] == block[i];
+  }
+  if (contiguous) {
+    std::memcpy(dst, src, block[dim] * src_stride);
+    return;
+  }
+  for (int i = 0; i < block[dim]; ++i) {
+    CopyBlock(src + i * src_stride,
+              src_shape,
+              dst + i * dst_stride,
+              dst_shape,
+              block,
+              dim + 1,
+              elem_size);
+  }
+}
+
+void CopyFromCpu(Tensor* tensor, const char* data, DataType dtype) {
+  switch (dtype) {
+    case DataType::FLOAT32:
+      return tensor->CopyFromCpu(reinterpret_cast<const float*>(data));
+    case DataType::INT64:
+      return tensor->CopyFromCpu(reinterpret_cast<const int64_t*>(data));
+    case DataType::INT32:
+      return tensor->CopyFromCpu(reinterpret_cast<const int32_t*>(data));
+    case DataType::UINT8:
+      return tensor->CopyFromCpu(reinterpret_cast<const uint8_t*>(data));
+    case DataType::INT8:
+      return tensor->CopyFromCpu(reinterpret_cast<const int8_t*>(data));
+    case DataType::FLOAT16:
+      return tensor->CopyFromCpu(reinterpret_cast<const float16*>(data));
+    default:
+      PADDLE_THROW(paddle::platform::errors::Unimplemented(
+          "Unsupported data type %d of BatchingPredictor.",
+          static_cast<int>(dtype)));
+  }
+}
+
+void CopyToCpu(const Tensor& tensor, char* data, DataType dtype) {
+  switch (dtype) {
+    case DataType::FLOAT32:
+      return tensor.CopyToCpu(reinterpret_cast<float*>(data));
+    case DataType::INT64:
+      return tensor.CopyToCpu(reinterpret_cast<int64_t*>(data));
+    case DataType::INT32:
+      return tensor.CopyToCpu(reinterpret_cast<int32_t*>(data));
+    case DataType::UINT8:
+      return tensor.CopyToCpu(reinterpret_cast<uint8_t*>(data));
+    case DataType::INT8:
+      return tensor.CopyToCpu(reinterpret_cast<int8_t*>(data));
+    case DataType::FLOAT16:
+      return tensor.CopyToCpu(reinterpret_cast<float16*>(data));
+    default:
+      PADDLE_THROW(paddle::platform::errors::Unimplemented(
+          "Unsupported data type %d of BatchingPredictor.",
+          static_cast<int>(dtype)));
+  }
+}
+
+struct Request {
+  const std::vector<paddle::PaddleTensor>* inputs;
+  std::vector<paddle::PaddleTensor>* outputs;
+  // the number of the samples, or -1 if the request has to run alone
+  int batch_size;
+  // the rows of the first LoD input, which may be more than the samples
+  int rows;
+  Clock::time_point arrival;
+  std::promise<bool> done;
+};
+
+enum class BatchStatus { kSuccess, kFailed, kUnsplittable };
+
+}  // namespace
+
+class BatchingPredictor::Impl {
+ public:
+  Impl(const Config& config, const BatchingConfig& batching_config)
+      : config_(batching_config),
+        pool_(config, NumPredictors(batching_config)) {
+    PADDLE_ENFORCE_GT(config_.max_batch_size,
+                      0,
+                      paddle::platform::errors::InvalidArgument(
+                          "The max_batch_size of BatchingPredictor should be "
+                          "greater than 0, but it's (%d)",
+                          config_.max_batch_size));
+    for (int i = 0; i < config_.num_predictors; ++i) {
+      workers_.emplace_back(&Impl::WorkerLoop, this, pool_.Retrive(i));
+    }
+  }
+
+  ~Impl() {
+    {
+      std::lock_guard<std::mutex> guard(mutex_);
+      stop_ = true;
+    }
+    cv_.notify_all();
+    for (auto& worker : workers_) {
+      worker.join();
+    }
+  }
+
+  bool Run(const std::vector<paddle::PaddleTensor>& inputs,
+           std::vector<paddle::PaddleTensor>* outputs) {
+    auto request = std::make_shared<Request>();
+    request->inputs = &inputs;
+    request->outputs = outputs;
+    request->arrival = Clock::now();
+    InitBatchSize(request.get());
+    auto done = request->done.get_future();
+    {
+      std::lock_guard<std::mutex> guard(mutex_);
+      queue_.push_back(std::move(request));
+    }
+    cv_.notify_all();
+    return done.get();
+  }
+
+ private:
+  // Checked before the predictors are created.
+  static size_t NumPredictors(const BatchingConfig& config) {
+    PADDLE_ENFORCE_GT(config.num_predictors,
+                      0,
+                      paddle::platform::errors::InvalidArgument(
+                          "The num_predictors of BatchingPredictor should be "
+                          "greater than 0, but it's (%d)",
+                          config.num_predictors));
+    return static_cast<size_t>(config.num_predictors);
+  }
+
+  // The inputs have to agree on the batch size to be batched.
+  static void InitBatchSize(Request* request) {
+    request->batch_size = -1;
+    request->rows = 0;
+    int batch_size = -1;
+    for (const auto& input : *request->inputs) {
+      if (input.shape.empty() || (!input.lod.empty() && input.lod[0].empty())) {
+        return;
+      }
+      int size = input.shape[0];
+      if (!input.lod.empty()) {
+        size = input.lod[0].size() - 1;
+        if (request->rows == 0) {
+          request->rows = input.shape[0];
+        }
+      }
+      if (size <= 0 || (batch_size != -1 && batch_size != size)) {
+        return;
+      }
+      batch_size = size;
+    }
+    request->batch_size = batch_size;
+    if (request->rows == 0) {
+      request->rows = batch_size;
+    }
+  }
+
+  bool Compatible(const Request& leader, const Request& request) const {
+    if (request.batch_size < 0 ||
+        leader.inputs->size() != request.inputs->size()) {
+      return false;
+    }
+    for (size_t i = 0; i < leader.inputs->size(); ++i) {
+      const auto& x = (*leader.inputs)[i];
+      const auto& y = (*request.inputs)[i];
+      if (x.name != y.name || x.dtype != y.dtype ||
+          x.lod.size() != y.lod.size() || x.shape.size() != y.shape.size()) {
+        return false;
+      }
+      bool can_pad = config_.pad_variable_length && x.lod.empty();
+      for (size_t d = 1; d < x.shape.size(); ++d) {
+        if (x.shape[d] != y.shape[d] && !can_pad) {
+          return false;
+        }
+      }
+    }
+    return true;
+  }
+
+  // Takes the requests of the next batch out of the queue, returns false
+  // when stopped.
+  bool NextBatch(std::vector<std::shared_ptr<Request>>* batch) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    cv_.wait(lock, [this] { return stop_ || !queue_.empty(); });
+    if (queue_.empty()) {
+      return false;
+    }
+    auto leader = queue_.front();
+    queue_.pop_front();
+    batch->push_back(leader);
+    if (leader->batch_size < 0 ||
+        leader->batch_size >= config_.max_batch_size) {
+      return true;
+    }
+    int total = leader->batch_size;
+    auto deadline =
+        leader->arrival + std::chrono::microseconds(config_.batch_timeout_us);
+    while (true) {
+      for (auto it = queue_.begin();
+           it != queue_.end() && total < config_.max_batch_size;) {
+        if (total + (*it)->batch_size <= config_.max_batch_size &&
+            Compatible(*leader, **it)) {
+          total += (*it)->batch_size;
+          batch->push_back(*it);
+          it = queue_.erase(it);
+        } else {
+          ++it;
+        }
+      }
+      if (total >= config_.max_batch_size || stop_ ||
+          Clock::now() >= deadline) {
+        return true;
+      }
+      cv_.wait_until(lock, deadline);
+    }
+  }
+
+  void WorkerLoop(Predictor* predictor) {
+    while (true) {
+      std::vector<std::shared_ptr<Request>> batch;
+      {
+        // one batch is collected at a time, so that the idle predictors do
+        // not split it.
+        std::lock_guard<std::mutex> guard(collect_mutex_);
+        if (!NextBatch(&batch)) {
+          return;
+        }
+      }
+      VLOG(3) << "BatchingPredictor runs " << batch.size() << " requests";
+      auto status = RunBatch(predictor, batch);
+      if (status == BatchStatus::kUnsplittable) {
+        VLOG(3) << "The outputs can not be split, run the requests one by one";
+        for (auto& request : batch) {
+          request->done.set_value(RunBatch(predictor, {request}) ==
+                                  BatchStatus::kSuccess);
+        }
+        continue;
+      }
+      for (auto& request : batch) {
+        request->done.set_value(status == BatchStatus::kSuccess);
+      }
+    }
+  }
+
+  BatchStatus RunBatch(Predictor* predictor,
+                       const std::vector<std::shared_ptr<Request>>& batch) {
+    try {
+      return TryRunBatch(predictor, batch);
+    } catch (const std::exception& e) {
+      LOG(ERROR) << "BatchingPredictor failed to run " << batch.size()
+                 << " requests: " << e.what();
+      return BatchStatus::kFailed;
+    }
+  }
+
+  BatchStatus TryRunBatch(Predictor* predictor,
+                          const std::vector<std::shared_ptr<Request>>& batch) {
+    const auto& first = *batch[0]->inputs;
+    bool has_lod_input = false;
+    // the dim 1 of every input after padding, -1 if it is not padded
+    std::vector<int> padded_dim1(first.size(), -1);
+    std::vector<char> buffer;
+    for (size_t k = 0; k < first.size(); ++k) {
+      auto tensor = predictor->GetInputHandle(first[k].name);
+      if (batch.size() == 1) {
+        tensor->Reshape(first[k].shape);
+        CopyFromCpu(tensor.get(),
+                    static_cast<const char*>(first[k].data.data()),
+                    first[k].dtype);
+        if (!first[k].lod.empty()) {
+          tensor->SetLoD(first[k].lod);
+        }
+        continue;
+      }
+
+      std::vector<int> shape = first[k].shape;
+      shape[0] = 0;
+      bool padded = false;
+      for (auto& request : batch) {
+        const auto& x = (*request->inputs)[k];
+        shape[0] += x.shape[0];
+        for (size_t d = 1; d < shape.size(); ++d) {
+          padded = padded || shape[d] != x.shape[d];
+          shape[d] = std::max(shape[d], x.shape[d]);
+        }
+      }
+      if (padded) {
+        padded_dim1[k] = shape[1];
+      }
+
+      auto dtype = first[k].dtype;
+      size_t elem_size = DtypeSize(dtype);
+      buffer.resize(Numel(shape) * elem_size);
+      if (padded) {
+        FillValue(buffer.data(), Numel(shape), dtype, config_.pad_value);
+      }
+      std::vector<std::vector<size_t>> lod(first[k].lod.size(), {0});
+      char* dst = buffer.data();
+      for (auto& request : batch) {
+        const auto& x = (*request->inputs)[k];
+        std::vector<int> dst_shape = shape;
+        dst_shape[0] = x.shape[0];
+        CopyBlock(static_cast<const char*>(x.data.data()),
+                  x.shape,
+                  dst,
+                  dst_shape,
+                  x.shape,
+                  0,
+                  elem_size);
+        dst += Numel(dst_shape) * elem_size;
+        for (size_t l = 0; l < lod.size(); ++l) {
+          size_t offset = lod[l].back();
+          for (size_t j = 1; j < x.lod[l].size(); ++j) {
+            lod[l].push_back(x.lod[l][j] - x.lod[l][0] + offset);
+          }
+        }
+      }
+      has_lod_input = has_lod_input || !lod.empty();
+
+      tensor->Reshape(shape);
+      CopyFromCpu(tensor.get(), buffer.data(), dtype);
+      if (!lod.empty()) {
+        tensor->SetLoD(lod);
+      }
+    }
+
+    if (!predictor->Run()) {
+      return BatchStatus::kFailed;
+    }
+
+    std::vector<std::vector<paddle::PaddleTensor>> results(batch.size());
+    for (const auto& name : predictor->GetOutputNames()) {
+      auto tensor = predictor->GetOutputHandle(name);
+      auto shape = tensor->shape();
+      auto lod = tensor->lod();
+      auto dtype = tensor->type();
+      size_t elem_size = DtypeSize(dtype);
+      buffer.resize(Numel(shape) * elem_size);
+      CopyToCpu(*tensor, buffer.data(), dtype);
+
+      // the first row of every request, and its lod
+      std::vector<size_t> rows(batch.size() + 1, 0);
+      std::vector<std::vector<std::vector<size_t>>> lods(batch.size());
+      if (batch.size() == 1) {
+        rows[1] = shape.empty() ? 1 : shape[0];
+        lods[0] = lod;
+      } else if (shape.empty()) {
+        return BatchStatus::kUnsplittable;
+      } else if (lod.size() == 1) {
+        size_t seq = 0;
+        for (size_t i = 0; i < batch.size(); ++i) {
+          size_t seq_end = seq + batch[i]->batch_size;
+          if (seq_end >= lod[0].size()) {
+            return BatchStatus::kUnsplittable;
+          }
+          rows[i + 1] = lod[0][seq_end];
+          lods[i].emplace_back();
+          for (size_t j = seq; j <= seq_end; ++j) {
+            lods[i][0].push_back(lod[0][j] - lod[0][seq]);
+          }
+          seq = seq_end;
+        }
+        if (seq + 1 != lod[0].size()) {
+          return BatchStatus::kUnsplittable;
+        }
+      } else if (!lod.empty()) {
+        return BatchStatus::kUnsplittable;
+      } else {
+        size_t batch_rows = 0, input_rows = 0;
+        for (auto& request : batch) {
+          batch_rows += request->batch_size;
+          input_rows += request->rows;
+        }
+        bool by_rows = has_lod_input &&
+                       static_cast<size_t>(shape[0]) != batch_rows &&
+                       static_cast<size_t>(shape[0]) == input_rows;
+        if (static_cast<size_t>(shape[0]) != batch_rows && !by_rows) {
+          return BatchStatus::kUnsplittable;
+        }
+        for (size_t i = 0; i < batch.size(); ++i) {
+          rows[i + 1] = rows[i] + (by_rows ? batch[i]->rows
+                                           : batch[i]->batch_size);
+        }
+      }
+
+      for (size_t i = 0; i < batch.size(); ++i) {
+        paddle::PaddleTensor out;
+        out.name = name;
+        out.dtype = dtype;
+        out.lod = std::move(lods[i]);
+        out.shape = shape;
+        if (!shape.empty()) {
+          out.shape[0] = rows[i + 1] - rows[i];
+        }
+        // cut the padding of dim 1 of a sequence output back to the length
+        // of the request in its input, the other outputs are not guessed
+        // from their shapes
+        if (batch.size() > 1 && shape.size() > 1) {
+          auto seq_itr = config_.sequence_outputs.find(name);
+          if (seq_itr != config_.sequence_outputs.end()) {
+            size_t k = 0;
+            while (k < first.size() && first[k].name != seq_itr->second) {
+              ++k;
+            }
+            if (k == first.size() || first[k].shape.size() < 2) {
+              return BatchStatus::kUnsplittable;
+            }
+            int batch_dim1 =
+                padded_dim1[k] == -1 ? first[k].shape[1] : padded_dim1[k];
+            if (batch_dim1 != shape[1]) {
+              return BatchStatus::kUnsplittable;
+            }
+            out.shape[1] = (*batch[i]->inputs)[k].shape[1];
+          } else if (std::find(padded_dim1.begin(),
+                               padded_dim1.end(),
+                               shape[1]) != padded_dim1.end()) {
+            // may be padded or not, run one by one
+            return BatchStatus::kUnsplittable;
+          }
+        }
+        std::vector<int> src_shape = shape;
+        if (!shape.empty()) {
+          src_shape[0] = out.shape[0];
+        }
+        out.data.Resize(Numel(out.shape) * elem_size);
+        if (shape.empty()) {
+          std::memcpy(out.data.data(), buffer.data(), elem_size);
+        } else if (Numel(out.shape) > 0) {
+          CopyBlock(buffer.data() + rows[i] * Numel(shape, 1) * elem_size,
+                    src_shape,
+                    static_cast<char*>(out.data.data()),
+                    out.shape,
+                    out.shape,
+                    0,
+                    elem_size);
+        }
+        results[i].push_back(std::move(out));
+      }
+    }
+
+    for (size_t i = 0; i < batch.size(); ++i) {
+      batch[i]->outputs->swap(results[i]);
+    }
+    return BatchStatus::kSuccess;
+  }
+
+  BatchingConfig config_;
+  PredictorPool pool_;
+  std::vector<std::thread> workers_;
+
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::deque<std::shared_ptr<Request>> queue_;
+  bool stop_{false};
+  std::mutex collect_mutex_;
+};
+
+BatchingPredictor::BatchingPredictor(const Config& config,
+                                     const BatchingConfig& batching_config)
+    : impl_(new Impl(config, batching_config)) {}
+
+BatchingPredictor::~BatchingPredictor() = default;
+
+bool BatchingPredictor::Run(const std::vector<paddle::PaddleTensor>& inputs,
+                            std::vector<paddle::PaddleTensor>* outputs) {
+  return impl_->Run(inputs, outputs);
+}
+
+}  // namespace services
+}  // namespace paddle_infer
@@ -0,0 +1,191 @@
+// Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Compare the latency and the throughput of --clients threads sending small
+// requests to a PredictorPool, one predictor per thread, and to a
+// BatchingPredictor, e.g. for the word2vec model of the unit tests
+//   batching_predictor_benchmark --dirname=word2vec.inference.model \
+//       --clients=32 --request_batch=1 --max_batch_size=32 --num_predictors=4
+// Every input of the model is fed with [request_batch] + sample_shape random
+// values in [0, max_value).
+
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <random>
+#include <sstream>
+#include <thread>  // NOLINT
+
+#include "gflags/gflags.h"
+#include "glog/logging.h"
+#include "paddle/fluid/inference/api/paddle_inference_api.h"
+
+DEFINE_string(dirname, "", "The model dir.");
+DEFINE_string(model_file, "", "The model file, with params_file.");
+DEFINE_string(params_file, "", "The params file, with model_file.");
+DEFINE_int32(clients, 32, "The number of client threads.");
+DEFINE_int32(requests, 200, "The number of requests of every client.");
+DEFINE_int32(request_batch, 1, "The batch size of every request.");
+DEFINE_string(sample_shape, "1", "The dims of a sample, split by comma.");
+DEFINE_bool(int64_inputs, true, "Whether the inputs are int64 or float32.");
+DEFINE_int32(max_value, 1000, "The max value of the inputs.");
+DEFINE_int32(max_batch_size, 32, "The max_batch_size of BatchingConfig.");
+DEFINE_int32(batch_timeout_us, 1000, "The batch_timeout_us of BatchingConfig.");
+DEFINE_int32(num_predictors, 4, "The num_predictors of BatchingConfig.");
+DEFINE_int32(cpu_math_library_num_threads, 1, "The math threads per run.");
+
+namespace paddle_infer {
+
+using Clock = std::chrono::steady_clock;
+
+static std::vector<paddle::PaddleTensor> MakeInputs(
+    const std::vector<std::string>& names, std::mt19937* rng) {
+  std::vector<int> shape = {FLAGS_request_batch};
+  std::stringstream ss(FLAGS_sample_shape);
+  std::string dim;
+  while (std::getline(ss, dim, ',')) {
+    shape.push_back(std::stoi(dim));
+  }
+  size_t numel = 1;
+  for (auto d : shape) {
+    numel *= d;
+  }
+  std::vector<paddle::PaddleTensor> inputs(names.size());
+  for (size_t i = 0; i < names.size(); ++i) {
+    auto& input = inputs[i];
+    input.name = names[i];
+    input.shape = shape;
+    if (FLAGS_int64_inputs) {
+      input.dtype = paddle::PaddleDType::INT64;
+      input.data.Resize(numel * sizeof(int64_t));
+      auto* data = static_cast<int64_t*>(input.data.data());
+      for (size_t j = 0; j < numel; ++j) {
+        data[j] = (*rng)() % FLAGS_max_value;
+      }
+    } else {
+      input.dtype = paddle::PaddleDType::FLOAT32;
+      input.data.Resize(numel * sizeof(float));
+      auto* data = static_cast<float*>(input.data.data());
+      for (size_t j = 0; j < numel; ++j) {
+        data[j] = static_cast<float>((*rng)() % FLAGS_max_value);
+      }
+    }
+  }
+  return inputs;
+}
+
+static bool RunAlone(Predictor* predictor,
+                     const std::vector<paddle::PaddleTensor>& inputs) {
+  for (auto& input : inputs) {
+    auto tensor = predictor->GetInputHandle(input.name);
+    tensor->Reshape(input.shape);
+    if (input.dtype == paddle::PaddleDType::INT64) {
+      tensor->CopyFromCpu(static_cast<const int64_t*>(input.data.data()));
+    } else {
+      tensor->CopyFromCpu(static_cast<const float*>(input.data.data()));
+    }
+  }
+  if (!predictor->Run()) {
+    return false;
+  }
+  // fetch the outputs as BatchingPredictor does
+  for (const auto& name : predictor->GetOutputNames()) {
+    auto tensor = predictor->GetOutputHandle(name);
+    auto shape = tensor->shape();
+    size_t numel = 1;
+    for (auto d : shape) {
+      numel *= d;
+    }
+    std::vector<int64_t> data(numel);
+    if (tensor->type() == DataType::INT64) {
+      tensor->CopyToCpu(data.data());
+    } else if (tensor->type() == DataType::INT32) {
+      tensor->CopyToCpu(reinterpret_cast<int32_t*>(data.data()));
+    } else {
+      tensor->CopyToCpu(reinterpret_cast<float*>(data.data()));
+    }
+  }
+  return true;
+}
+
+// Runs fn(client, request) on all the clients, and reports the latencies.
+template <typename Fn>
+static void Benchmark(const std::string& title, Fn fn) {
+  std::vector<std::vector<double>> latencies(FLAGS_clients);
+  auto start = Clock::now();
+  std::vector<std::thread> threads;
+  for (int c = 0; c < FLAGS_clients; ++c) {
+    threads.emplace_back([&, c] {
+      std::mt19937 rng(c);
+      for (int i = 0; i < FLAGS_requests; ++i) {
+        auto request_start = Clock::now();
+        CHECK(fn(c, &rng));
+        latencies[c].push_back(
+            std::chrono::duration<double, std::milli>(Clock::now() -
+                                                      request_start)
+                .count());
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+  std::vector<double> all;
+  for (auto& l : latencies) {
+    all.insert(all.end(), l.begin(), l.end());
+  }
+  std::sort(all.begin(), all.end());
+  LOG(INFO) << title << ": " << all.size() / seconds << " requests/s, "
+            << all.size() * FLAGS_request_batch / seconds
+            << " samples/s, latency p50 " << all[all.size() / 2]
+            << " ms, p99 " << all[all.size() * 99 / 100] << " ms";
+}
+
+static int BenchmarkMain() {
+  Config config;
+  if (!FLAGS_dirname.empty()) {
+    config.SetModel(FLAGS_dirname);
+  } else {
+    config.SetModel(FLAGS_model_file, FLAGS_params_file);
+  }
+  config.SetCpuMathLibraryNumThreads(FLAGS_cpu_math_library_num_threads);
+  auto input_names = CreatePredictor(config)->GetInputNames();
+
+  {
+    services::PredictorPool pool(config, FLAGS_clients);
+    Benchmark("predictor per client", [&](int client, std::mt19937* rng) {
+      return RunAlone(pool.Retrive(client), MakeInputs(input_names, rng));
+    });
+  }
+  {
+    services::BatchingConfig batching_config;
+    batching_config.max_batch_size = FLAGS_max_batch_size;
+    batching_config.batch_timeout_us = FLAGS_batch_timeout_us;
+    batching_config.num_predictors = FLAGS_num_predictors;
+    services::BatchingPredictor predictor(config, batching_config);
+    Benchmark("batching", [&](int client, std::mt19937* rng) {
+      std::vector<paddle::PaddleTensor> outputs;
+      return predictor.Run(MakeInputs(input_names, rng), &outputs);
+    });
+  }
+  return 0;
+}
+
+}  // namespace paddle_infer
+
+int main(int argc, char* argv[]) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  google::InitGoogleLogging(argv[0]);
+  return paddle_infer::BenchmarkMain();
+}
@@ -220,6 +220,76 @@ class PD_INFER_DECL PredictorPool {
   std::shared_ptr<Predictor> main_pred_;
   std::vector<std::unique_ptr<Predictor>> preds_;
 };
+
+///
+/// \brief The options of BatchingPredictor.
+///
+struct PD_INFER_DECL BatchingConfig {
+  /// The max sum of the batch sizes of the requests run together. A request
+  /// larger than it runs alone.
+  int max_batch_size{32};
+  /// The max time in microseconds the first request of a batch waits for the
+  /// others.
+  int batch_timeout_us{1000};
+  /// The number of predictors, i.e. the batches run at the same time.
+  int num_predictors{1};
+  /// Whether to pad the dims after the batch dim of the dense inputs to the
+  /// max of a batch with pad_value, e.g. the token ids of [1, seq_len], so
+  /// that the requests of different lengths run together. The model has to
+  /// mask the padding. The outputs in sequence_outputs are cut back to the
+  /// length of the request along their dim 1, the requests of a batch run
+  /// one by one if any other output has the padded dim 1 of an input.
+  /// Without padding only the requests of the same shapes run together.
+  bool pad_variable_length{false};
+  float pad_value{0.f};
+  /// The name of the input whose dim 1 is the dim 1 of an output, by the
+  /// name of the output, e.g. {"logits", "token_ids"}.
+  std::map<std::string, std::string> sequence_outputs;
+};
+
+///
+/// \class BatchingPredictor
+///
+/// \brief BatchingPredictor queues the requests of many threads and runs
+/// them together, concatenated along the batch dim, to use the GEMMs of the
+/// model with a larger batch under high QPS of small requests.
+///
+/// A batch is run when it reaches max_batch_size, or batch_timeout_us after
+/// its first request. The batch size of a request is the dim 0 of its dense
+/// inputs, or the number of the sequences of its LoD inputs, whose LoDs are
+/// merged. Every output is split back by the batch sizes, or by its LoD, or by
+/// the rows of the LoD inputs when it has as many rows. A batch whose outputs
+/// can not be split runs its requests one by one.
+///
+/// \code{cpp}
+/// paddle_infer::services::BatchingPredictor predictor(config, {});
+/// // on every server thread
+/// std::vector<paddle::PaddleTensor> outputs;
+/// predictor.Run(inputs, &outputs);
+/// \endcode
+///
+class PD_INFER_DECL BatchingPredictor {
+ public:
+  BatchingPredictor() = delete;
+  BatchingPredictor(const BatchingPredictor&) = delete;
+  BatchingPredictor& operator=(const BatchingPredictor&) = delete;
+
+  BatchingPredictor(const Config& config,
+                    const BatchingConfig& batching_config);
+  ~BatchingPredictor();
+
+  /// \brief Run a request, blocked until its batch is finished. Thread safe.
+  ///
+  /// \param[in] inputs The input tensors on CPU, named as the feed vars.
+  /// \param[out] outputs The output tensors of the request.
+  /// \return Whether the run succeeded.
+  bool Run(const std::vector<paddle::PaddleTensor>& inputs,
+           std::vector<paddle::PaddleTensor>* outputs);
+
+ private:
+  class Impl;
+  std::unique_ptr<Impl> impl_;
+};
 }  // namespace services
 
 }  // namespace paddle_infer
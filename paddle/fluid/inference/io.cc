@@ -22,6 +22,7 @@ limitations under the License. */
 #include "paddle/fluid/framework/feed_fetch_type.h"
 #include "paddle/fluid/framework/op_registry.h"
 #include "paddle/fluid/framework/version.h"
+#include "paddle/fluid/inference/utils/mmap_params.h"
 #include "paddle/fluid/platform/cpu_helper.h"
 #include "paddle/fluid/platform/enforce.h"
 #include "paddle/fluid/pybind/pybind.h"
@@ -117,6 +118,14 @@ void LoadPersistables(framework::Executor* executor,
     }
   }
 
+  if (!param_filename.empty() && !model_from_memory &&
+      IsMmapParamsFile(param_filename)) {
+    VLOG(3) << "mmap params from " << param_filename;
+    LoadMmapParams(param_filename, paramlist, scope, executor->GetPlace());
+    delete load_program;
+    return;
+  }
+
   if (!param_filename.empty()) {
     // sort paramlist to have consistent ordering
     std::sort(paramlist.begin(), paramlist.end());
@@ -207,6 +216,24 @@ std::unique_ptr<framework::ProgramDesc> LoadFromMemory(
   return main_program;
 }
 
+void ConvertToMmapParams(const std::string& prog_filename,
+                         const std::string& param_filename,
+                         const std::string& mmap_param_filename) {
+  platform::CPUPlace place;
+  framework::Executor executor(place);
+  framework::Scope scope;
+  auto program = Load(&executor, &scope, prog_filename, param_filename);
+
+  std::vector<std::string> paramlist;
+  for (auto* var : program->Block(0).AllVars()) {
+    if (IsPersistable(var)) {
+      paramlist.push_back(var->Name());
+    }
+  }
+  std::sort(paramlist.begin(), paramlist.end());
+  SaveMmapParams(scope, paramlist, mmap_param_filename);
+}
+
 void SaveVars(const framework::Scope& scope,
               const std::vector<std::string>& vars,
               const std::string& dirname,
@@ -50,6 +50,12 @@ std::unique_ptr<framework::ProgramDesc> LoadFromMemory(
     const std::string& prog_buffer,
     const std::string& param_buffer);
 
+// Convert the combined params of a model to the mmap params format, which
+// Load maps instead of running load_combine. See utils/mmap_params.h.
+void ConvertToMmapParams(const std::string& prog_filename,
+                         const std::string& param_filename,
+                         const std::string& mmap_param_filename);
+
 // Save the variables from a scope to disk.
 void SaveVars(const framework::Scope& scope,
               const std::vector<std::string>& vars,
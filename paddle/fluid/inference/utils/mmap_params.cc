@@ -0,0 +1,384 @@
+// Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/inference/utils/mmap_params.h"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <unordered_set>
+#include <utility>
+
+#include "paddle/fluid/framework/convert_utils.h"
+#include "paddle/fluid/framework/lod_tensor.h"
+#include "paddle/fluid/framework/tensor_util.h"
+#include "paddle/fluid/memory/allocation/allocator.h"
+#include "paddle/fluid/platform/enforce.h"
+
+namespace paddle {
+namespace inference {
+
+namespace {
+
+constexpr char kMmapParamsMagic[8] = {'P', 'D', 'M', 'M', 'A', 'P', 'P', 'S'};
+constexpr uint32_t kMmapParamsVersion = 1;
+constexpr size_t kMmapParamsHeaderSize = 24;
+constexpr size_t kMmapParamsPageSize = 4096;
+
+size_t AlignUp(size_t size, size_t alignment) {
+  return (size + alignment - 1) / alignment * alignment;
+}
+
+template <typename T>
+void Append(std::string* buf, T value) {
+  buf->append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+// Bound checked reads of the index.
+class IndexReader {
+ public:
+  IndexReader(const char* data, size_t size, const std::string& path)
+      : data_(data), size_(size), path_(path) {}
+
+  template <typename T>
+  T Read() {
+    T value;
+    std::memcpy(&value, Skip(sizeof(T)), sizeof(T));
+    return value;
+  }
+
+  // Reads the number of the elements that follow, which have to fit in the
+  // rest of the index.
+  template <typename T>
+  size_t ReadCount(size_t element_size) {
+    size_t count = Read<T>();
+    CheckRemaining(count, element_size);
+    return count;
+  }
+
+  const char* Skip(size_t bytes) {
+    CheckRemaining(bytes, 1);
+    const char* ptr = data_ + pos_;
+    pos_ += bytes;
+    return ptr;
+  }
+
+ private:
+  void CheckRemaining(size_t count, size_t element_size) {
+    PADDLE_ENFORCE_LE(
+        count,
+        (size_ - pos_) / element_size,
+        platform::errors::InvalidArgument(
+            "The index of the mmap params file %s is truncated, please check "
+            "whether the file is complete or damaged.",
+            path_));
+  }
+
+  const char* data_;
+  size_t size_;
+  size_t pos_ = 0;
+  const std::string& path_;
+};
+
+// Owns the mapping of a file, shared by all the tensors pointing to it.
+class MmapParamsMapping {
+ public:
+  explicit MmapParamsMapping(const std::string& path) {
+#ifndef _WIN32
+    int fd = open(path.c_str(), O_RDONLY);
+    PADDLE_ENFORCE_NE(fd,
+                      -1,
+                      platform::errors::Unavailable(
+                          "Failed to open the mmap params file %s.", path));
+    struct stat st;
+    PADDLE_ENFORCE_EQ(fstat(fd, &st),
+                      0,
+                      platform::errors::Unavailable(
+                          "Failed to stat the mmap params file %s.", path));
+    size_ = static_cast<size_t>(st.st_size);
+    if (size_ > 0) {
+      // private so that the weights rewritten by the passes are copied on
+      // write, the pages which are only read stay shared.
+      void* ptr =
+          mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+      PADDLE_ENFORCE_NE(ptr,
+                        MAP_FAILED,
+                        platform::errors::Unavailable(
+                            "Failed to mmap the params file %s.", path));
+      data_ = static_cast<char*>(ptr);
+    }
+    close(fd);
+#else
+    std::ifstream fin(path, std::ios::binary | std::ios::ate);
+    PADDLE_ENFORCE_EQ(static_cast<bool>(fin),
+                      true,
+                      platform::errors::Unavailable(
+                          "Failed to open the mmap params file %s.", path));
+    size_ = static_cast<size_t>(fin.tellg());
+    buffer_.reset(new char[size_ + kMmapParamsPageSize]);
+    data_ = reinterpret_cast<char*>(
+        AlignUp(reinterpret_cast<uintptr_t>(buffer_.get()),
+                kMmapParamsPageSize));
+    fin.seekg(0, std::ios::beg);
+    fin.read(data_, size_);
+#endif
+  }
+
+  ~MmapParamsMapping() {
+#ifndef _WIN32
+    if (data_ != nullptr) {
+      munmap(data_, size_);
+    }
+#endif
+  }
+
+  char* data() const { return data_; }
+  size_t size() const { return size_; }
+
+ private:
+  char* data_ = nullptr;
+  size_t size_ = 0;
+#ifdef _WIN32
+  std::unique_ptr<char[]> buffer_;
+#endif
+};
+
+class MmapParamsAllocation : public memory::allocation::Allocation {
+ public:
+  MmapParamsAllocation(void* ptr,
+                       size_t size,
+                       std::shared_ptr<MmapParamsMapping> mapping)
+      : Allocation(ptr, size, platform::CPUPlace()),
+        mapping_(std::move(mapping)) {}
+
+ private:
+  std::shared_ptr<MmapParamsMapping> mapping_;
+};
+
+}  // namespace
+
+bool IsMmapParamsFile(const std::string& path) {
+  std::ifstream fin(path, std::ios::binary);
+  char magic[sizeof(kMmapParamsMagic)];
+  if (!fin.read(magic, sizeof(magic))) {
+    return false;
+  }
+  return std::memcmp(magic, kMmapParamsMagic, sizeof(magic)) == 0;
+}
+
+void SaveMmapParams(const framework::Scope& scope,
+                    const std::vector<std::string>& var_names,
+                    const std::string& path) {
+  std::vector<framework::LoDTensor> tensors(var_names.size());
+  std::string index;
+  size_t data_size = 0;
+  for (size_t i = 0; i < var_names.size(); ++i) {
+    const auto& name = var_names[i];
+    auto* var = scope.FindVar(name);
+    PADDLE_ENFORCE_NOT_NULL(
+        var,
+        platform::errors::NotFound("The variable %s to be saved is not found.",
+                                   name));
+    PADDLE_ENFORCE_EQ(
+        var->IsType<framework::LoDTensor>(),
+        true,
+        platform::errors::InvalidArgument(
+            "The mmap params format only supports LoDTensor, but the "
+            "variable %s is %s.",
+            name,
+            framework::ToTypeName(var->Type())));
+    const auto& src = var->Get<framework::LoDTensor>();
+    auto& tensor = tensors[i];
+    if (platform::is_cpu_place(src.place())) {
+      tensor.ShareDataWith(src);
+    } else {
+      framework::TensorCopySync(src, platform::CPUPlace(), &tensor);
+    }
+    tensor.set_lod(src.lod());
+
+    Append<uint32_t>(&index, name.size());
+    index.append(name);
+    Append<int32_t>(&index, framework::TransToProtoVarType(tensor.dtype()));
+    auto dims = phi::vectorize(tensor.dims());
+    Append<uint32_t>(&index, dims.size());
+    for (auto dim : dims) {
+      Append<int64_t>(&index, dim);
+    }
+    const auto& lod = tensor.lod();
+    Append<uint32_t>(&index, lod.size());
+    for (const auto& level : lod) {
+      Append<uint64_t>(&index, level.size());
+      for (auto offset : level) {
+        Append<uint64_t>(&index, offset);
+      }
+    }
+    size_t bytes = tensor.numel() * phi::SizeOf(tensor.dtype());
+    data_size = AlignUp(data_size, kMmapParamsAlignment);
+    Append<uint64_t>(&index, data_size);
+    Append<uint64_t>(&index, bytes);
+    data_size += bytes;
+  }
+
+  std::string header(kMmapParamsMagic, sizeof(kMmapParamsMagic));
+  Append<uint32_t>(&header, kMmapParamsVersion);
+  Append<uint32_t>(&header, var_names.size());
+  size_t data_offset =
+      AlignUp(kMmapParamsHeaderSize + index.size(), kMmapParamsPageSize);
+  Append<uint64_t>(&header, data_offset);
+
+  std::ofstream fout(path, std::ios::binary);
+  PADDLE_ENFORCE_EQ(static_cast<bool>(fout),
+                    true,
+                    platform::errors::Unavailable(
+                        "Failed to open %s to save the mmap params.", path));
+  fout.write(header.data(), header.size());
+  fout.write(index.data(), index.size());
+  size_t pos = kMmapParamsHeaderSize + index.size();
+  std::string padding(kMmapParamsPageSize, '\0');
+  auto pad_to = [&](size_t target) {
+    fout.write(padding.data(), target - pos);
+    pos = target;
+  };
+  pad_to(data_offset);
+  for (auto& tensor : tensors) {
+    size_t bytes = tensor.numel() * phi::SizeOf(tensor.dtype());
+    pad_to(AlignUp(pos, kMmapParamsAlignment));
+    if (bytes > 0) {
+      fout.write(static_cast<const char*>(tensor.data()), bytes);
+    }
+    pos += bytes;
+  }
+  PADDLE_ENFORCE_EQ(static_cast<bool>(fout),
+                    true,
+                    platform::errors::Unavailable(
+                        "Failed to write the mmap params to %s.", path));
+}
+
+void LoadMmapParams(const std::string& path,
+                    const std::vector<std::string>& var_names,
+                    framework::Scope* scope,
+                    const platform::Place& place) {
+  auto mapping = std::make_shared<MmapParamsMapping>(path);
+  IndexReader header(mapping->data(), mapping->size(), path);
+  PADDLE_ENFORCE_EQ(
+      std::memcmp(header.Skip(sizeof(kMmapParamsMagic)),
+                  kMmapParamsMagic,
+                  sizeof(kMmapParamsMagic)),
+      0,
+      platform::errors::InvalidArgument(
+          "The file %s is not in the mmap params format.", path));
+  auto version = header.Read<uint32_t>();
+  PADDLE_ENFORCE_EQ(version,
+                    kMmapParamsVersion,
+                    platform::errors::Unimplemented(
+                        "The version %d of the mmap params file %s is not "
+                        "supported, expect %d.",
+                        version,
+                        path,
+                        kMmapParamsVersion));
+  auto var_num = header.Read<uint32_t>();
+  auto data_offset = header.Read<uint64_t>();
+  PADDLE_ENFORCE_EQ(
+      data_offset >= kMmapParamsHeaderSize && data_offset <= mapping->size(),
+      true,
+      platform::errors::InvalidArgument(
+          "The mmap params file %s is truncated, please check whether the "
+          "file is complete or damaged.",
+          path));
+  char* data = mapping->data() + data_offset;
+  size_t data_size = mapping->size() - data_offset;
+
+  IndexReader index(mapping->data() + kMmapParamsHeaderSize,
+                    data_offset - kMmapParamsHeaderSize,
+                    path);
+  std::unordered_set<std::string> wanted(var_names.begin(), var_names.end());
+  std::unordered_set<std::string> found;
+  for (uint32_t i = 0; i < var_num; ++i) {
+    auto name_len = index.ReadCount<uint32_t>(1);
+    std::string name(index.Skip(name_len), name_len);
+    auto dtype = framework::TransToPhiDataType(
+        static_cast<framework::proto::VarType::Type>(index.Read<int32_t>()));
+    std::vector<int64_t> dims(index.ReadCount<uint32_t>(sizeof(int64_t)));
+    for (auto& dim : dims) {
+      dim = index.Read<int64_t>();
+    }
+    phi::LoD lod(index.ReadCount<uint32_t>(sizeof(uint64_t)));
+    for (auto& level : lod) {
+      level.resize(index.ReadCount<uint64_t>(sizeof(uint64_t)));
+      for (auto& offset : level) {
+        offset = index.Read<uint64_t>();
+      }
+    }
+    auto offset = index.Read<uint64_t>();
+    auto bytes = index.Read<uint64_t>();
+    PADDLE_ENFORCE_EQ(
+        offset <= data_size && bytes <= data_size - offset,
+        true,
+        platform::errors::InvalidArgument(
+            "The payload of %s is out of the mmap params file %s, please "
+            "check whether the file is complete or damaged.",
+            name,
+            path));
+    found.insert(name);
+
+    // the vars in the file but not in the program are skipped, as
+    // load_combine does not know them either.
+    if (wanted.count(name) == 0) {
+      continue;
+    }
+    auto* var = scope->Var(name);
+    auto* tensor = var->GetMutable<framework::LoDTensor>();
+    tensor->clear();
+    tensor->Resize(phi::make_ddim(dims));
+    PADDLE_ENFORCE_EQ(
+        static_cast<uint64_t>(tensor->numel()) * phi::SizeOf(dtype),
+        bytes,
+        platform::errors::InvalidArgument(
+            "The payload of %s in the mmap params file %s has %d bytes, "
+            "which does not match its shape [%s].",
+            name,
+            path,
+            bytes,
+            tensor->dims()));
+    tensor->ResetHolderWithType(
+        std::make_shared<MmapParamsAllocation>(data + offset, bytes, mapping),
+        dtype);
+    tensor->set_lod(lod);
+    if (!platform::is_cpu_place(place)) {
+      framework::LoDTensor cpu_tensor;
+      cpu_tensor.ShareDataWith(*tensor);
+      framework::TensorCopySync(cpu_tensor, place, tensor);
+    }
+  }
+
+  for (const auto& name : var_names) {
+    PADDLE_ENFORCE_EQ(
+        found.count(name),
+        1UL,
+        platform::errors::NotFound(
+            "The variable %s is not found in the mmap params file %s.",
+            name,
+            path));
+  }
+}
+
+}  // namespace inference
+}  // namespace paddle
@@ -0,0 +1,65 @@
+// Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "paddle/fluid/framework/scope.h"
+#include "paddle/fluid/platform/place.h"
+
+namespace paddle {
+namespace inference {
+
+// A combined parameter file whose tensors can be used in place after mmap,
+// instead of being deserialized one by one by load_combine:
+//
+//   | magic 8B | version 4B | var_num 4B | data_offset 8B | index | padding |
+//   | tensor payloads, every one aligned to kMmapParamsAlignment |
+//
+// Every index entry is
+//   | name_len 4B | name | dtype 4B | rank 4B | dims 8B * rank |
+//   | lod_level 4B | per level: | size 8B | offsets 8B * size | |
+//   | offset 8B | bytes 8B |
+// where offset is relative to data_offset, which is page aligned. The tensors
+// of a loaded file share the pages of the file, so the processes loading the
+// same file share their weights through the page cache.
+constexpr size_t kMmapParamsAlignment = 64;
+
+// Whether the file starts with the magic of the mmap params format. The
+// combined files written by save_combine never do.
+bool IsMmapParamsFile(const std::string& path);
+
+// Writes the LoDTensors `var_names` of scope to path in the mmap params
+// format. The tensors may live on any place.
+void SaveMmapParams(const framework::Scope& scope,
+                    const std::vector<std::string>& var_names,
+                    const std::string& path);
+
+// Maps path and points the LoDTensors `var_names` of scope to their payloads
+// in the mapping, the variables are created if they do not exist. The
+// mapping is released with the last tensor referring to it.
+// The pages are mapped copy-on-write: a pass rewriting a weight in place
+// (e.g. conv_bn_fuse_pass) copies the pages it touches only, and never
+// modifies the file. For a place other than CPUPlace the tensors are copied
+// to place.
+void LoadMmapParams(const std::string& path,
+                    const std::vector<std::string>& var_names,
+                    framework::Scope* scope,
+                    const platform::Place& place);
+
+}  // namespace inference
+}  // namespace paddle
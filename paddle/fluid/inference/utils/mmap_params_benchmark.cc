@@ -0,0 +1,162 @@
+// Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Compare the start of a predictor loading its params with load_combine and
+// with the mmap params format: the load time, and the resident and shared
+// memory every process adds once all the weights are read. Every loader runs
+// in --procs forked processes at the same time, after the page cache of the
+// file is dropped, e.g.
+//   mmap_params_benchmark --param_num=400 --param_mb=1024 --procs=4
+
+#include <fcntl.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <fstream>
+#include <random>
+
+#include "gflags/gflags.h"
+#include "glog/logging.h"
+#include "paddle/fluid/framework/lod_tensor.h"
+#include "paddle/fluid/framework/op_registry.h"
+#include "paddle/fluid/inference/utils/mmap_params.h"
+#include "paddle/fluid/platform/timer.h"
+
+DEFINE_int32(param_num, 400, "The number of params.");
+DEFINE_int32(param_mb, 1024, "The total MB of the params.");
+DEFINE_int32(procs, 4, "The number of processes loading the params.");
+DEFINE_string(dir, "/tmp", "The directory to write the param files to.");
+
+USE_CPU_ONLY_OP(load_combine);
+
+namespace paddle {
+namespace inference {
+
+// resident and shared MB of the process
+static void ReadStatm(double* resident_mb, double* shared_mb) {
+  std::ifstream fin("/proc/self/statm");
+  size_t size = 0, resident = 0, shared = 0;
+  fin >> size >> resident >> shared;
+  double page_mb = static_cast<double>(getpagesize()) / (1 << 20);
+  *resident_mb = resident * page_mb;
+  *shared_mb = shared * page_mb;
+}
+
+static void DropPageCache(const std::string& path) {
+  sync();
+  int fd = open(path.c_str(), O_RDONLY);
+  posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+  close(fd);
+}
+
+static void LoadAndTouch(const std::string& loader,
+                         const std::string& path,
+                         const std::vector<std::string>& names) {
+  double resident_base = 0, shared_base = 0;
+  ReadStatm(&resident_base, &shared_base);
+  framework::Scope scope;
+  platform::Timer timer;
+  timer.Start();
+  if (loader == "load_combine") {
+    auto op = framework::OpRegistry::CreateOp(
+        "load_combine", {}, {{"Out", names}}, {{"file_path", path}});
+    op->Run(scope, platform::CPUPlace());
+  } else {
+    LoadMmapParams(path, names, &scope, platform::CPUPlace());
+  }
+  timer.Pause();
+  double load_ms = timer.ElapsedMS();
+
+  // the first inference reads all the weights
+  timer.Reset();
+  timer.Start();
+  double sum = 0;
+  for (const auto& name : names) {
+    const auto& tensor = scope.FindVar(name)->Get<framework::LoDTensor>();
+    const float* data = tensor.data<float>();
+    for (int64_t i = 0; i < tensor.numel(); i += 1024) {
+      sum += data[i];
+    }
+  }
+  timer.Pause();
+  double resident_mb = 0, shared_mb = 0;
+  ReadStatm(&resident_mb, &shared_mb);
+  LOG(INFO) << loader << " pid " << getpid() << ": load " << load_ms
+            << " ms, first read " << timer.ElapsedMS() << " ms, resident +"
+            << resident_mb - resident_base << " MB, shared +"
+            << shared_mb - shared_base << " MB"
+            << " (checksum " << sum << ")";
+}
+
+static int BenchmarkMain() {
+  framework::Scope scope;
+  std::vector<std::string> names;
+  int64_t numel = (static_cast<int64_t>(FLAGS_param_mb) << 20) /
+                  sizeof(float) / FLAGS_param_num;
+  std::mt19937 rng(0);
+  std::uniform_real_distribution<float> distrib(-1.0, 1.0);
+  for (int i = 0; i < FLAGS_param_num; ++i) {
+    names.push_back("param_" + std::to_string(i));
+    auto* tensor = scope.Var(names.back())->GetMutable<framework::LoDTensor>();
+    tensor->Resize({numel});
+    float* data = tensor->mutable_data<float>(platform::CPUPlace());
+    for (int64_t j = 0; j < numel; ++j) {
+      data[j] = distrib(rng);
+    }
+  }
+  std::sort(names.begin(), names.end());
+
+  // the same layout as save_combine
+  std::string combine_path = FLAGS_dir + "/mmap_params_benchmark.combined";
+  {
+    std::ofstream fout(combine_path, std::ios::binary);
+    for (const auto& name : names) {
+      framework::SerializeToStream(
+          fout, scope.FindVar(name)->Get<framework::LoDTensor>());
+    }
+  }
+  std::string mmap_path = FLAGS_dir + "/mmap_params_benchmark.pdiparams";
+  SaveMmapParams(scope, names, mmap_path);
+  for (const auto& name : names) {
+    scope.FindVar(name)->GetMutable<framework::LoDTensor>()->clear();
+  }
+
+  for (const std::string loader : {"load_combine", "mmap"}) {
+    const auto& path = loader == "mmap" ? mmap_path : combine_path;
+    DropPageCache(path);
+    std::vector<pid_t> pids;
+    for (int i = 0; i < FLAGS_procs; ++i) {
+      pid_t pid = fork();
+      if (pid == 0) {
+        LoadAndTouch(loader, path, names);
+        _exit(0);
+      }
+      pids.push_back(pid);
+    }
+    for (auto pid : pids) {
+      waitpid(pid, nullptr, 0);
+    }
+  }
+  return 0;
+}
+
+}  // namespace inference
+}  // namespace paddle
+
+int main(int argc, char* argv[]) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  google::InitGoogleLogging(argv[0]);
+  return paddle::inference::BenchmarkMain();
+}
@@ -0,0 +1,139 @@
+// Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/inference/utils/mmap_params.h"
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <fstream>
+
+#include "paddle/fluid/framework/lod_tensor.h"
+
+namespace paddle {
+namespace inference {
+namespace {
+
+template <typename T>
+void CreateTensor(framework::Scope* scope,
+                  const std::string& name,
+                  const std::vector<int64_t>& dims,
+                  const framework::LoD& lod = {}) {
+  auto* tensor = scope->Var(name)->GetMutable<framework::LoDTensor>();
+  tensor->Resize(phi::make_ddim(dims));
+  tensor->set_lod(lod);
+  T* data = tensor->mutable_data<T>(platform::CPUPlace());
+  for (int64_t i = 0; i < tensor->numel(); ++i) {
+    data[i] = static_cast<T>(i * 3 + name.size());
+  }
+}
+
+template <typename T>
+void ExpectTensorEqual(const framework::Scope& expect,
+                       const framework::Scope& actual,
+                       const std::string& name) {
+  const auto& t0 = expect.FindVar(name)->Get<framework::LoDTensor>();
+  const auto& t1 = actual.FindVar(name)->Get<framework::LoDTensor>();
+  ASSERT_EQ(t0.dims(), t1.dims());
+  ASSERT_EQ(t0.dtype(), t1.dtype());
+  ASSERT_EQ(t0.lod(), t1.lod());
+  ASSERT_TRUE(platform::is_cpu_place(t1.place()));
+  ASSERT_EQ(reinterpret_cast<uintptr_t>(t1.data()) % kMmapParamsAlignment,
+            0UL);
+  for (int64_t i = 0; i < t0.numel(); ++i) {
+    ASSERT_EQ(t0.data<T>()[i], t1.data<T>()[i]);
+  }
+}
+
+}  // namespace
+
+TEST(MmapParams, save_and_load) {
+  const std::string path = "./mmap_params_test.pdiparams";
+  framework::Scope scope;
+  CreateTensor<float>(&scope, "fc_0.w_0", {13, 7});
+  CreateTensor<float>(&scope, "fc_0.b_0", {7});
+  CreateTensor<int64_t>(&scope, "ids", {5, 1}, {{0, 2, 5}});
+  CreateTensor<int8_t>(&scope, "quant.w", {3, 3});
+  CreateTensor<float>(&scope, "empty", {0, 4});
+  std::vector<std::string> names = {
+      "empty", "fc_0.b_0", "fc_0.w_0", "ids", "quant.w"};
+  SaveMmapParams(scope, names, path);
+  ASSERT_TRUE(IsMmapParamsFile(path));
+
+  framework::Scope loaded;
+  // only a part of the file is loaded, as load_combine loads the vars of
+  // the program only
+  LoadMmapParams(path,
+                 {"fc_0.b_0", "fc_0.w_0", "ids", "quant.w"},
+                 &loaded,
+                 platform::CPUPlace());
+  ASSERT_EQ(loaded.FindVar("empty"), nullptr);
+  ExpectTensorEqual<float>(scope, loaded, "fc_0.w_0");
+  ExpectTensorEqual<float>(scope, loaded, "fc_0.b_0");
+  ExpectTensorEqual<int64_t>(scope, loaded, "ids");
+  ExpectTensorEqual<int8_t>(scope, loaded, "quant.w");
+
+  // the mapping is copy-on-write, the file is kept unchanged
+  auto* w = loaded.FindVar("fc_0.w_0")->GetMutable<framework::LoDTensor>();
+  w->mutable_data<float>(platform::CPUPlace())[0] = -1;
+  framework::Scope reloaded;
+  LoadMmapParams(path, {"fc_0.w_0"}, &reloaded, platform::CPUPlace());
+  ExpectTensorEqual<float>(scope, reloaded, "fc_0.w_0");
+}
+
+TEST(MmapParams, not_mmap_params) {
+  const std::string path = "./mmap_params_test.combined";
+  {
+    std::ofstream fout(path, std::ios::binary);
+    fout << "not a mmap params file";
+  }
+  ASSERT_FALSE(IsMmapParamsFile(path));
+  ASSERT_FALSE(IsMmapParamsFile("./mmap_params_test.not_exist"));
+  framework::Scope scope;
+  ASSERT_ANY_THROW(
+      LoadMmapParams(path, {"fc_0.w_0"}, &scope, platform::CPUPlace()));
+}
+
+TEST(MmapParams, missing_var) {
+  const std::string path = "./mmap_params_test.missing.pdiparams";
+  framework::Scope scope;
+  CreateTensor<float>(&scope, "fc_0.w_0", {4, 4});
+  SaveMmapParams(scope, {"fc_0.w_0"}, path);
+  framework::Scope loaded;
+  ASSERT_ANY_THROW(LoadMmapParams(
+      path, {"fc_0.w_0", "fc_1.w_0"}, &loaded, platform::CPUPlace()));
+}
+
+TEST(MmapParams, truncated) {
+  const std::string path = "./mmap_params_test.truncated.pdiparams";
+  framework::Scope scope;
+  CreateTensor<float>(&scope, "fc_0.w_0", {64, 64});
+  SaveMmapParams(scope, {"fc_0.w_0"}, path);
+  std::string content;
+  {
+    std::ifstream fin(path, std::ios::binary);
+    content.assign(std::istreambuf_iterator<char>(fin),
+                   std::istreambuf_iterator<char>());
+  }
+  {
+    std::ofstream fout(path, std::ios::binary);
+    fout.write(content.data(), content.size() / 2);
+  }
+  framework::Scope loaded;
+  ASSERT_ANY_THROW(
+      LoadMmapParams(path, {"fc_0.w_0"}, &loaded, platform::CPUPlace()));
+}
+
+}  // namespace inference
+}  // namespace paddle
@@ -23,6 +23,7 @@
 #include "paddle/fluid/memory/allocation/naive_best_fit_allocator.h"
 #include "paddle/fluid/memory/allocation/retry_allocator.h"
 #include "paddle/fluid/memory/allocation/stat_allocator.h"
+#include "paddle/fluid/memory/allocation/thread_cache_cpu_allocator.h"
 #include "paddle/fluid/platform/enforce.h"
 #include "paddle/fluid/platform/place.h"
 
@@ -221,8 +222,13 @@ class AllocatorFacadePrivate {
         break;
       }
 
-      case AllocatorStrategy::kAutoGrowth: {
-        InitNaiveBestFitCPUAllocator();
+      case AllocatorStrategy::kAutoGrowth:
+      case AllocatorStrategy::kThreadCache: {
+        if (strategy_ == AllocatorStrategy::kThreadCache) {
+          InitThreadCacheCPUAllocator();
+        } else {
+          InitNaiveBestFitCPUAllocator();
+        }
 #if defined(PADDLE_WITH_CUDA) || defined(PADDLE_WITH_HIP)
         allow_free_idle_chunk_ = allow_free_idle_chunk;
         for (int dev_id = 0; dev_id < platform::GetGPUDeviceCount(); ++dev_id) {
@@ -497,6 +503,11 @@ class AllocatorFacadePrivate {
         std::make_shared<NaiveBestFitAllocator>(platform::CPUPlace());
   }
 
+  void InitThreadCacheCPUAllocator() {
+    allocators_[platform::CPUPlace()] =
+        std::make_shared<ThreadCacheCPUAllocator>();
+  }
+
 #if defined(PADDLE_WITH_CUDA) || defined(PADDLE_WITH_HIP)
   void InitNaiveBestFitCUDAPinnedAllocator() {
     allocators_[platform::CUDAPinnedPlace()] =
@@ -511,8 +522,8 @@ class AllocatorFacadePrivate {
   std::shared_ptr<Allocator> CreateCUDAAllocator(platform::CUDAPlace p) {
     if (FLAGS_use_cuda_managed_memory) {
       PADDLE_ENFORCE_EQ(
-          strategy_,
-          AllocatorStrategy::kAutoGrowth,
+          IsAutoGrowthStrategy(strategy_),
+          true,
           platform::errors::InvalidArgument(
               "CUDA managed memory is only implemented for auto_growth "
               "strategy, not support %s strategy.\n"
@@ -538,8 +549,8 @@ class AllocatorFacadePrivate {
 
   void InitStreamSafeCUDAAllocator(platform::CUDAPlace p, gpuStream_t stream) {
     PADDLE_ENFORCE_EQ(
-        strategy_,
-        AllocatorStrategy::kAutoGrowth,
+        IsAutoGrowthStrategy(strategy_),
+        true,
         platform::errors::Unimplemented(
             "Only support auto-growth strategey for StreamSafeCUDAAllocator, "
             "the allocator strategy %d is unsupported for multi-stream",
@@ -1021,8 +1032,8 @@ const std::shared_ptr<Allocator>& AllocatorFacade::GetAllocator(
 
 void* AllocatorFacade::GetBasePtr(
     const std::shared_ptr<phi::Allocation>& allocation) {
-  PADDLE_ENFORCE_EQ(GetAllocatorStrategy(),
-                    AllocatorStrategy::kAutoGrowth,
+  PADDLE_ENFORCE_EQ(IsAutoGrowthStrategy(GetAllocatorStrategy()),
+                    true,
                     paddle::platform::errors::Unimplemented(
                         "GetBasePtr() is only implemented for auto_growth "
                         "strategy, not support allocator strategy: %d",
@@ -1151,8 +1162,8 @@ void AllocatorFacade::SetDefaultStream(const platform::CUDAPlace& place,
 
 #ifdef PADDLE_WITH_CUDA
 void AllocatorFacade::PrepareMemoryPoolForCUDAGraph(int64_t id) {
-  PADDLE_ENFORCE_EQ(GetAllocatorStrategy(),
-                    AllocatorStrategy::kAutoGrowth,
+  PADDLE_ENFORCE_EQ(IsAutoGrowthStrategy(GetAllocatorStrategy()),
+                    true,
                     platform::errors::InvalidArgument(
                         "CUDA Graph is only supported when the "
                         "FLAGS_allocator_strategy=\"auto_growth\", but got "
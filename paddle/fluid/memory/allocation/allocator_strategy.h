@@ -18,10 +18,22 @@ namespace paddle {
 namespace memory {
 namespace allocation {
 
-enum class AllocatorStrategy { kNaiveBestFit, kAutoGrowth, kThreadLocal };
+enum class AllocatorStrategy {
+  kNaiveBestFit,
+  kAutoGrowth,
+  kThreadLocal,
+  // kAutoGrowth on devices, ThreadCacheCPUAllocator on CPU
+  kThreadCache
+};
 
 extern AllocatorStrategy GetAllocatorStrategy();
 
+// Whether the devices use the auto-growth allocators.
+inline bool IsAutoGrowthStrategy(AllocatorStrategy strategy) {
+  return strategy == AllocatorStrategy::kAutoGrowth ||
+         strategy == AllocatorStrategy::kThreadCache;
+}
+
 // Do nothing, just make sure linker do not prune this file.
 extern void UseAllocatorStrategyGFlag();
 
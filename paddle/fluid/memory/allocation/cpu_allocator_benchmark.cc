@@ -0,0 +1,95 @@
+// Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Sweep the thread num of a tensor-like allocation pattern, and compare the
+// throughput of the NaiveBestFitAllocator used by the default strategies on
+// CPU with the ThreadCacheCPUAllocator of the thread_cache strategy, e.g.
+//   cpu_allocator_benchmark --max_threads=64 --max_size=65536
+
+#include <random>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "gflags/gflags.h"
+#include "glog/logging.h"
+#include "paddle/fluid/memory/allocation/naive_best_fit_allocator.h"
+#include "paddle/fluid/memory/allocation/thread_cache_cpu_allocator.h"
+#include "paddle/fluid/platform/timer.h"
+
+DEFINE_int32(max_threads, 64, "The max thread num to sweep.");
+DEFINE_int32(ops_per_thread, 1000000, "The allocations of every thread.");
+DEFINE_int32(live_num, 32, "The live allocations kept by every thread.");
+DEFINE_int32(max_size, 65536, "The max size of an allocation.");
+DEFINE_int32(large_per_mille,
+             1,
+             "The per mille of allocations in [max_size, 8 * max_size).");
+
+namespace paddle {
+namespace memory {
+namespace allocation {
+
+static double RunOnce(const std::shared_ptr<Allocator>& allocator,
+                      int thread_num) {
+  platform::Timer timeline;
+  timeline.Start();
+  std::vector<std::thread> threads;
+  for (int t = 0; t < thread_num; ++t) {
+    threads.emplace_back([&allocator, t]() {
+      std::mt19937 rng(t);
+      // the sizes of tensors are skewed to the small ones
+      std::uniform_real_distribution<double> distrib(0, 1.0);
+      std::vector<AllocationPtr> live(FLAGS_live_num);
+      for (int i = 0; i < FLAGS_ops_per_thread; ++i) {
+        double u = distrib(rng);
+        size_t size = static_cast<int>(rng() % 1000) < FLAGS_large_per_mille
+                          ? FLAGS_max_size * (1 + u * 7)
+                          : 8 + u * u * u * FLAGS_max_size;
+        auto& allocation = live[rng() % live.size()];
+        allocation = allocator->Allocate(size);
+        static_cast<char*>(allocation->ptr())[0] = 1;
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  timeline.Pause();
+  return timeline.ElapsedSec();
+}
+
+static int BenchmarkMain() {
+  auto naive_best_fit =
+      std::make_shared<NaiveBestFitAllocator>(platform::CPUPlace());
+  auto thread_cache = std::make_shared<ThreadCacheCPUAllocator>();
+  for (int thread_num = 1; thread_num <= FLAGS_max_threads; thread_num *= 2) {
+    double ops = static_cast<double>(thread_num) * FLAGS_ops_per_thread;
+    double naive_sec = RunOnce(naive_best_fit, thread_num);
+    double cached_sec = RunOnce(thread_cache, thread_num);
+    LOG(INFO) << "threads " << thread_num << ": naive_best_fit "
+              << ops / naive_sec / 1e6 << " M allocs/s, thread_cache "
+              << ops / cached_sec / 1e6 << " M allocs/s, speedup "
+              << naive_sec / cached_sec;
+  }
+  return 0;
+}
+
+}  // namespace allocation
+}  // namespace memory
+}  // namespace paddle
+
+int main(int argc, char* argv[]) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  google::InitGoogleLogging(argv[0]);
+  return paddle::memory::allocation::BenchmarkMain();
+}
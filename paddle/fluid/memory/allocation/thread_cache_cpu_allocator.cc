@@ -0,0 +1,444 @@
+// Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/memory/allocation/thread_cache_cpu_allocator.h"
+
+#ifdef _WIN32
+#include <malloc.h>
+#else
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <fstream>
+#include <mutex>  // NOLINT
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "paddle/fluid/memory/allocation/auto_growth_best_fit_allocator.h"
+#include "paddle/fluid/memory/stats.h"
+#include "paddle/fluid/platform/enforce.h"
+#include "paddle/fluid/platform/flags.h"
+#include "paddle/fluid/platform/profiler/mem_tracing.h"
+
+PADDLE_DEFINE_EXPORTED_bool(
+    cpu_thread_cache_numa_aware,
+    true,
+    "Whether the thread_cache allocator strategy binds the CPU pages to the "
+    "NUMA node of the allocating thread.");
+
+namespace paddle {
+namespace memory {
+namespace allocation {
+
+namespace {
+
+// 64 bytes steps up to kSmallClassMax, then 4 classes per power of two.
+constexpr size_t kSmallClassMax = 1024;
+constexpr size_t kSmallClassNum =
+    kSmallClassMax / ThreadCacheCPUAllocator::kAlignment;
+constexpr size_t kSmallClassLog = 10;
+constexpr size_t kLargeClassLog = 20;
+constexpr size_t kStepsPerDoubling = 4;
+
+// A thread fetches and flushes about kBatchBytes at a time, and caches at
+// most kThreadCacheBytesPerClass of a class.
+constexpr size_t kBatchBytes = 64 << 10;
+constexpr size_t kMaxBatchCount = 64;
+constexpr size_t kThreadCacheBytesPerClass = 2 << 20;
+
+constexpr size_t kLargeChunkSize = 32 << 20;
+
+static_assert((size_t{1} << kSmallClassLog) == kSmallClassMax,
+              "kSmallClassLog does not match kSmallClassMax");
+static_assert((size_t{1} << kLargeClassLog) ==
+                  ThreadCacheCPUAllocator::kMaxClassSize,
+              "kLargeClassLog does not match kMaxClassSize");
+
+size_t BatchCount(size_t index) {
+  size_t count = kBatchBytes / ThreadCacheCPUAllocator::ClassSize(index);
+  return std::min(std::max<size_t>(count, 1), kMaxBatchCount);
+}
+
+size_t CacheCapacity(size_t index) {
+  size_t count =
+      kThreadCacheBytesPerClass / ThreadCacheCPUAllocator::ClassSize(index);
+  return std::max<size_t>(std::min(4 * BatchCount(index), count), 2);
+}
+
+std::atomic<uint64_t> allocator_id{0};
+
+}  // namespace
+
+int NumaCPUAllocator::NodeNum() {
+  static int node_num = [] {
+    // The online nodes look like "0" or "0-1,3", the last one is the max.
+    std::ifstream fin("/sys/devices/system/node/online");
+    std::string nodes;
+    if (!(fin >> nodes)) {
+      return 1;
+    }
+    size_t pos = nodes.find_last_of(",-");
+    int max_node = std::atoi(
+        nodes.substr(pos == std::string::npos ? 0 : pos + 1).c_str());
+    return std::max(max_node + 1, 1);
+  }();
+  return node_num;
+}
+
+int NumaCPUAllocator::CurrentNode() {
+#if defined(__linux__) && defined(SYS_getcpu)
+  unsigned cpu = 0;
+  unsigned node = 0;
+  if (syscall(SYS_getcpu, &cpu, &node, nullptr) == 0 &&
+      static_cast<int>(node) < NodeNum()) {
+    return static_cast<int>(node);
+  }
+#endif
+  return 0;
+}
+
+void* NumaCPUAllocator::AllocPages(size_t size, int node) {
+#ifdef _WIN32
+  void* p = _aligned_malloc(size, 4096);
+  PADDLE_ENFORCE_NOT_NULL(
+      p,
+      platform::errors::ResourceExhausted("Fail to alloc memory of %ld size.",
+                                          size));
+#else
+  void* p = mmap(nullptr,
+                 size,
+                 PROT_READ | PROT_WRITE,
+                 MAP_PRIVATE | MAP_ANONYMOUS,
+                 -1,
+                 0);
+  PADDLE_ENFORCE_NE(
+      p,
+      MAP_FAILED,
+      platform::errors::ResourceExhausted(
+          "Fail to alloc memory of %ld size, error code is %d.", size, errno));
+#if defined(__linux__) && defined(SYS_mbind)
+  // MPOL_PREFERRED falls back to the other nodes when the node is full, it
+  // is set before the first touch so that the pages are faulted in there.
+  constexpr int kMpolPreferred = 1;
+  if (FLAGS_cpu_thread_cache_numa_aware && NodeNum() > 1 && node >= 0 &&
+      node < 63) {
+    unsigned long mask = 1UL << node;  // NOLINT
+    if (syscall(SYS_mbind, p, size, kMpolPreferred, &mask, 64, 0) != 0) {
+      VLOG(4) << "mbind " << size << " bytes to NUMA node " << node
+              << " failed, error code is " << errno;
+    }
+  }
+#endif
+#endif
+  HOST_MEMORY_STAT_UPDATE(Reserved, 0, size);
+  platform::RecordMemEvent(p,
+                           platform::CPUPlace(),
+                           size,
+                           platform::TracerMemEventType::ReservedAllocate);
+  return p;
+}
+
+void NumaCPUAllocator::FreePages(void* ptr, size_t size) {
+#ifdef _WIN32
+  _aligned_free(ptr);
+#else
+  munmap(ptr, size);
+#endif
+  HOST_MEMORY_STAT_UPDATE(Reserved, 0, -size);
+  platform::RecordMemEvent(ptr,
+                           platform::CPUPlace(),
+                           size,
+                           platform::TracerMemEventType::ReservedFree);
+}
+
+phi::Allocation* NumaCPUAllocator::AllocateImpl(size_t size) {
+  return new Allocation(
+      AllocPages(size, CurrentNode()), size, platform::CPUPlace());
+}
+
+void NumaCPUAllocator::FreeImpl(phi::Allocation* allocation) {
+  FreePages(allocation->ptr(), allocation->size());
+  delete allocation;
+}
+
+class ThreadCacheCPUAllocator::CentralArena {
+ public:
+  CentralArena()
+      : node_num_(NumaCPUAllocator::NodeNum()),
+        lists_(new FreeList[node_num_ * ClassNum()]) {}
+
+  ~CentralArena() {
+    for (auto& span : spans_) {
+      NumaCPUAllocator::FreePages(span.first, span.second);
+    }
+  }
+
+  int NodeNum() const { return node_num_; }
+
+  // Append num blocks of the class to blocks, the free blocks go first and
+  // the rest are carved from the span of the class on that node.
+  void Fetch(int node, size_t index, size_t num, std::vector<void*>* blocks) {
+    size_t size = ClassSize(index);
+    auto& list = lists_[node * ClassNum() + index];
+    std::lock_guard<std::mutex> guard(list.mutex);
+    size_t from_free = std::min(num, list.blocks.size());
+    blocks->insert(
+        blocks->end(), list.blocks.end() - from_free, list.blocks.end());
+    list.blocks.resize(list.blocks.size() - from_free);
+    for (size_t i = from_free; i < num; ++i) {
+      if (static_cast<size_t>(list.span_end - list.span_cur) < size) {
+        list.span_cur = static_cast<char*>(NewSpan(node));
+        list.span_end = list.span_cur + kSpanSize;
+      }
+      blocks->push_back(list.span_cur);
+      list.span_cur += size;
+    }
+  }
+
+  void Return(int node, size_t index, void* const* blocks, size_t num) {
+    auto& list = lists_[node * ClassNum() + index];
+    std::lock_guard<std::mutex> guard(list.mutex);
+    list.blocks.insert(list.blocks.end(), blocks, blocks + num);
+  }
+
+ private:
+  struct FreeList {
+    std::mutex mutex;
+    std::vector<void*> blocks;
+    char* span_cur{nullptr};
+    char* span_end{nullptr};
+  };
+
+  void* NewSpan(int node) {
+    void* span = NumaCPUAllocator::AllocPages(kSpanSize, node);
+    std::lock_guard<std::mutex> guard(spans_mutex_);
+    spans_.emplace_back(span, kSpanSize);
+    return span;
+  }
+
+  int node_num_;
+  std::unique_ptr<FreeList[]> lists_;
+  std::mutex spans_mutex_;
+  std::vector<std::pair<void*, size_t>> spans_;
+};
+
+class ThreadCacheCPUAllocator::ThreadCache {
+ public:
+  explicit ThreadCache(std::shared_ptr<CentralArena> arena)
+      : arena_(std::move(arena)),
+        node_(std::min(NumaCPUAllocator::CurrentNode(),
+                       arena_->NodeNum() - 1)),
+        lists_(ClassNum()) {}
+
+  ~ThreadCache() { Flush(); }
+
+  void* Allocate(size_t index) {
+    auto& list = lists_[index];
+    if (list.empty()) {
+      arena_->Fetch(node_, index, BatchCount(index), &list);
+    }
+    void* p = list.back();
+    list.pop_back();
+    return p;
+  }
+
+  void Free(size_t index, void* p) {
+    auto& list = lists_[index];
+    list.push_back(p);
+    if (list.size() > CacheCapacity(index)) {
+      // the front blocks are the coldest ones
+      size_t num = BatchCount(index);
+      arena_->Return(node_, index, list.data(), num);
+      list.erase(list.begin(), list.begin() + num);
+    }
+  }
+
+  void Flush() {
+    for (size_t index = 0; index < lists_.size(); ++index) {
+      auto& list = lists_[index];
+      if (!list.empty()) {
+        arena_->Return(node_, index, list.data(), list.size());
+        list.clear();
+      }
+    }
+  }
+
+ private:
+  std::shared_ptr<CentralArena> arena_;
+  int node_;
+  std::vector<std::vector<void*>> lists_;
+};
+
+namespace {
+
+// Set when the registry of the thread is destroyed, the static objects
+// destructed after it at exit go to the central arena directly.
+thread_local bool registry_destroyed = false;
+
+// The caches of a thread, one for every ThreadCacheCPUAllocator it uses.
+// They flush to the central arenas when the thread exits.
+struct ThreadCacheRegistry {
+  using ThreadCache = ThreadCacheCPUAllocator::ThreadCache;
+
+  ~ThreadCacheRegistry() {
+    registry_destroyed = true;
+    last = nullptr;
+    caches.clear();
+  }
+
+  void Erase(uint64_t id) {
+    if (last_id == id) {
+      last_id = 0;
+      last = nullptr;
+    }
+    caches.erase(std::remove_if(caches.begin(),
+                                caches.end(),
+                                [id](const auto& item) {
+                                  return item.first == id;
+                                }),
+                 caches.end());
+  }
+
+  std::vector<std::pair<uint64_t, std::unique_ptr<ThreadCache>>> caches;
+  uint64_t last_id{0};
+  ThreadCache* last{nullptr};
+};
+
+ThreadCacheRegistry* GetThreadCacheRegistry() {
+  if (UNLIKELY(registry_destroyed)) {
+    return nullptr;
+  }
+  static thread_local ThreadCacheRegistry registry;
+  return &registry;
+}
+
+}  // namespace
+
+ThreadCacheCPUAllocator::ThreadCacheCPUAllocator()
+    : id_(++allocator_id),
+      arena_(std::make_shared<CentralArena>()),
+      large_allocator_(std::make_shared<AutoGrowthBestFitAllocator>(
+          std::make_shared<NumaCPUAllocator>(), kAlignment, kLargeChunkSize)) {
+}
+
+ThreadCacheCPUAllocator::~ThreadCacheCPUAllocator() {
+  auto* registry = GetThreadCacheRegistry();
+  if (registry != nullptr) {
+    registry->Erase(id_);
+  }
+}
+
+size_t ThreadCacheCPUAllocator::ClassNum() {
+  return kSmallClassNum + (kLargeClassLog - kSmallClassLog) * kStepsPerDoubling;
+}
+
+size_t ThreadCacheCPUAllocator::ClassIndex(size_t size) {
+  if (size <= kSmallClassMax) {
+    return size == 0 ? 0 : (size + kAlignment - 1) / kAlignment - 1;
+  }
+  // size is in (2^log, 2^(log + 1)]
+  size_t log = kSmallClassLog;
+  while ((size_t{2} << log) < size) {
+    ++log;
+  }
+  size_t step = size_t{1} << (log - 2);
+  size_t offset = (size - (size_t{1} << log) + step - 1) / step - 1;
+  return kSmallClassNum + (log - kSmallClassLog) * kStepsPerDoubling + offset;
+}
+
+size_t ThreadCacheCPUAllocator::ClassSize(size_t index) {
+  if (index < kSmallClassNum) {
+    return (index + 1) * kAlignment;
+  }
+  size_t k = index - kSmallClassNum;
+  size_t log = kSmallClassLog + k / kStepsPerDoubling;
+  return (size_t{1} << log) +
+         (k % kStepsPerDoubling + 1) * (size_t{1} << (log - 2));
+}
+
+ThreadCacheCPUAllocator::ThreadCache*
+ThreadCacheCPUAllocator::GetThreadCache() {
+  auto* registry = GetThreadCacheRegistry();
+  if (UNLIKELY(registry == nullptr)) {
+    return nullptr;
+  }
+  if (LIKELY(registry->last_id == id_)) {
+    return registry->last;
+  }
+  ThreadCache* cache = nullptr;
+  for (auto& item : registry->caches) {
+    if (item.first == id_) {
+      cache = item.second.get();
+      break;
+    }
+  }
+  if (cache == nullptr) {
+    registry->caches.emplace_back(id_, std::make_unique<ThreadCache>(arena_));
+    cache = registry->caches.back().second.get();
+  }
+  registry->last_id = id_;
+  registry->last = cache;
+  return cache;
+}
+
+phi::Allocation* ThreadCacheCPUAllocator::AllocateImpl(size_t size) {
+  if (size > kMaxClassSize) {
+    return large_allocator_->Allocate(size).release();
+  }
+  size_t index = ClassIndex(size);
+  void* p = nullptr;
+  auto* cache = GetThreadCache();
+  if (LIKELY(cache != nullptr)) {
+    p = cache->Allocate(index);
+  } else {
+    std::vector<void*> blocks;
+    arena_->Fetch(0, index, 1, &blocks);
+    p = blocks[0];
+  }
+  return new Allocation(p, size, platform::CPUPlace());
+}
+
+void ThreadCacheCPUAllocator::FreeImpl(phi::Allocation* allocation) {
+  if (allocation->size() > kMaxClassSize) {
+    large_allocator_->Free(allocation);
+    return;
+  }
+  size_t index = ClassIndex(allocation->size());
+  void* p = allocation->ptr();
+  auto* cache = GetThreadCache();
+  if (LIKELY(cache != nullptr)) {
+    cache->Free(index, p);
+  } else {
+    arena_->Return(0, index, &p, 1);
+  }
+  delete allocation;
+}
+
+uint64_t ThreadCacheCPUAllocator::ReleaseImpl(const platform::Place& place) {
+  auto* cache = GetThreadCache();
+  if (cache != nullptr) {
+    cache->Flush();
+  }
+  return large_allocator_->Release(place);
+}
+
+}  // namespace allocation
+}  // namespace memory
+}  // namespace paddle
@@ -0,0 +1,90 @@
+// Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <memory>
+
+#include "paddle/fluid/memory/allocation/allocator.h"
+
+namespace paddle {
+namespace memory {
+namespace allocation {
+
+// Allocate CPU pages from the operating system. When there is more than one
+// NUMA node and FLAGS_cpu_thread_cache_numa_aware is set, the pages prefer
+// the node of the calling thread.
+class NumaCPUAllocator : public Allocator {
+ public:
+  bool IsAllocThreadSafe() const override { return true; }
+
+  // The number of NUMA nodes, 1 when it is unknown.
+  static int NodeNum();
+  // The NUMA node of the cpu the calling thread runs on.
+  static int CurrentNode();
+  static void* AllocPages(size_t size, int node);
+  static void FreePages(void* ptr, size_t size);
+
+ protected:
+  phi::Allocation* AllocateImpl(size_t size) override;
+  void FreeImpl(phi::Allocation* allocation) override;
+};
+
+// The CPU allocator of the thread_cache strategy, for many threads
+// allocating tensors concurrently. The requests up to kMaxClassSize are
+// rounded to size classes. Every thread keeps a bounded free list of every
+// class, refilled from and flushed to a central arena in batches, so most
+// Allocate and Free calls take no lock. The central arena has a free list
+// of every class for every NUMA node, carved from spans bound to that node.
+// The larger requests go to an AutoGrowthBestFitAllocator over
+// NumaCPUAllocator.
+//
+// The spans are never returned to the system, Release only flushes the
+// thread cache of the caller and frees the idle chunks of the large
+// requests.
+class ThreadCacheCPUAllocator : public Allocator {
+ public:
+  static constexpr size_t kAlignment = 64;
+  static constexpr size_t kMaxClassSize = 1 << 20;
+  static constexpr size_t kSpanSize = 2 << 20;
+
+  ThreadCacheCPUAllocator();
+  ~ThreadCacheCPUAllocator();
+
+  bool IsAllocThreadSafe() const override { return true; }
+
+  static size_t ClassNum();
+  // The class of a request, size must be in [1, kMaxClassSize].
+  static size_t ClassIndex(size_t size);
+  static size_t ClassSize(size_t index);
+
+  class CentralArena;
+  class ThreadCache;
+
+ protected:
+  phi::Allocation* AllocateImpl(size_t size) override;
+  void FreeImpl(phi::Allocation* allocation) override;
+  uint64_t ReleaseImpl(const platform::Place& place) override;
+
+ private:
+  ThreadCache* GetThreadCache();
+
+  uint64_t id_;
+  std::shared_ptr<CentralArena> arena_;
+  std::shared_ptr<Allocator> large_allocator_;
+};
+
+}  // namespace allocation
+}  // namespace memory
+}  // namespace paddle
@@ -0,0 +1,120 @@
+// Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/memory/allocation/thread_cache_cpu_allocator.h"
+
+#include <cstring>
+#include <random>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "paddle/fluid/memory/allocation/allocator_facade.h"
+#include "paddle/fluid/memory/stats.h"
+
+DECLARE_string(allocator_strategy);
+
+namespace paddle {
+namespace memory {
+namespace allocation {
+
+TEST(ThreadCacheCPUAllocator, SizeClass) {
+  size_t last_size = 0;
+  for (size_t index = 0; index < ThreadCacheCPUAllocator::ClassNum();
+       ++index) {
+    size_t size = ThreadCacheCPUAllocator::ClassSize(index);
+    ASSERT_GT(size, last_size);
+    ASSERT_EQ(size % ThreadCacheCPUAllocator::kAlignment, 0UL);
+    ASSERT_EQ(ThreadCacheCPUAllocator::ClassIndex(size), index);
+    ASSERT_EQ(ThreadCacheCPUAllocator::ClassIndex(last_size + 1), index);
+    last_size = size;
+  }
+  ASSERT_EQ(last_size, ThreadCacheCPUAllocator::kMaxClassSize);
+}
+
+TEST(ThreadCacheCPUAllocator, AllocateAndFree) {
+  auto allocator = std::make_shared<ThreadCacheCPUAllocator>();
+  std::vector<size_t> sizes = {1, 63, 64, 1000, 4097, 100000, 1 << 20,
+                               (1 << 20) + 1, 5 << 20};
+  std::vector<AllocationPtr> allocations;
+  for (size_t size : sizes) {
+    allocations.emplace_back(allocator->Allocate(size));
+    auto& allocation = allocations.back();
+    ASSERT_EQ(allocation->size(), size);
+    ASSERT_EQ(reinterpret_cast<uintptr_t>(allocation->ptr()) %
+                  ThreadCacheCPUAllocator::kAlignment,
+              0UL);
+    memset(allocation->ptr(), 0xff, size);
+  }
+  void* ptr = allocations[3]->ptr();
+  allocations[3].reset();
+  // the freed block is reused by the same thread
+  auto allocation = allocator->Allocate(sizes[3]);
+  ASSERT_EQ(allocation->ptr(), ptr);
+  allocations.clear();
+  allocator->Release(platform::CPUPlace());
+}
+
+TEST(ThreadCacheCPUAllocator, MultiThread) {
+  auto allocator = std::make_shared<ThreadCacheCPUAllocator>();
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 8; ++t) {
+    threads.emplace_back([&allocator, t]() {
+      std::mt19937 rng(t);
+      std::vector<AllocationPtr> allocations(64);
+      for (int i = 0; i < 20000; ++i) {
+        auto& allocation = allocations[rng() % allocations.size()];
+        size_t size = 1 + rng() % (i % 100 == 0 ? (2 << 20) : 8192);
+        allocation = allocator->Allocate(size);
+        // every thread writes the whole block, overlaps crash or corrupt
+        memset(allocation->ptr(), t, size);
+        ASSERT_EQ(static_cast<char*>(allocation->ptr())[size - 1],
+                  static_cast<char>(t));
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+}
+
+TEST(ThreadCacheCPUAllocator, FreeInAnotherThread) {
+  auto allocator = std::make_shared<ThreadCacheCPUAllocator>();
+  std::vector<AllocationPtr> allocations;
+  for (int i = 0; i < 1000; ++i) {
+    allocations.emplace_back(allocator->Allocate(256));
+  }
+  std::thread([&allocations]() { allocations.clear(); }).join();
+  // the blocks are flushed to the central arena when the thread exits
+  for (int i = 0; i < 1000; ++i) {
+    allocations.emplace_back(allocator->Allocate(256));
+  }
+}
+
+TEST(ThreadCacheCPUAllocator, Facade) {
+  FLAGS_allocator_strategy = "thread_cache";
+  auto& instance = AllocatorFacade::Instance();
+  int64_t allocated = HostMemoryStatCurrentValue("Allocated", 0);
+  {
+    auto allocation = instance.Alloc(platform::CPUPlace(), 1024);
+    ASSERT_NE(allocation, nullptr);
+    ASSERT_EQ(HostMemoryStatCurrentValue("Allocated", 0), allocated + 1024);
+    ASSERT_GE(HostMemoryStatCurrentValue("Reserved", 0), 1024);
+  }
+  ASSERT_EQ(HostMemoryStatCurrentValue("Allocated", 0), allocated);
+}
+
+}  // namespace allocation
+}  // namespace memory
+}  // namespace paddle
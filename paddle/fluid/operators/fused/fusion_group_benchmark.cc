@@ -0,0 +1,161 @@
+/* Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+// Compare the latency of an elementwise subgraph run by NaiveExecutor, as the
+// predictors do, before and after fusion_group_pass on CPU, e.g.
+//   fusion_group_benchmark --batch_size=64 --width=4096 --repeat=100
+// The subgraph is
+//   out = tanh(sigmoid(x + y) * z) + relu(x * y)
+// whose seven operators are fused into one fusion_group op.
+
+#include <cmath>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "gflags/gflags.h"
+#include "glog/logging.h"
+#include "paddle/fluid/framework/ir/graph_helper.h"
+#include "paddle/fluid/framework/ir/pass_tester_helper.h"
+#include "paddle/fluid/framework/naive_executor.h"
+#include "paddle/fluid/framework/op_registry.h"
+#include "paddle/fluid/platform/device_code.h"
+#include "paddle/fluid/platform/timer.h"
+#include "paddle/phi/core/kernel_registry.h"
+
+DEFINE_int32(batch_size, 64, "The rows of the inputs.");
+DEFINE_int32(width, 4096, "The columns of the inputs.");
+DEFINE_int32(repeat, 100, "The runs of each program.");
+
+USE_OP_ITSELF(elementwise_add);
+USE_OP_ITSELF(elementwise_mul);
+USE_OP_ITSELF(relu);
+USE_OP_ITSELF(sigmoid);
+USE_OP_ITSELF(tanh);
+USE_CPU_ONLY_OP(fusion_group);
+USE_PASS(fusion_group_pass);
+
+PD_DECLARE_KERNEL(add, CPU, ALL_LAYOUT);
+PD_DECLARE_KERNEL(multiply, CPU, ALL_LAYOUT);
+PD_DECLARE_KERNEL(relu, CPU, ALL_LAYOUT);
+PD_DECLARE_KERNEL(sigmoid, CPU, ALL_LAYOUT);
+PD_DECLARE_KERNEL(tanh, CPU, ALL_LAYOUT);
+
+namespace paddle {
+namespace framework {
+
+static ProgramDesc BuildProgram(std::string* out_name) {
+  ir::Layers layers;
+  auto* x = layers.data("x");
+  auto* y = layers.data("y");
+  auto* z = layers.data("z");
+  auto* tmp_0 = layers.sigmoid(layers.elementwise_add(x, y));
+  auto* tmp_1 = layers.tanh(layers.elementwise_mul(tmp_0, z));
+  auto* tmp_2 = layers.relu(layers.elementwise_mul(x, y));
+  auto* out = layers.elementwise_add(tmp_1, tmp_2);
+  *out_name = out->Name();
+
+  ProgramDesc program(layers.main_program());
+  for (auto* var : program.Block(0).AllVars()) {
+    var->SetShape({FLAGS_batch_size, FLAGS_width});
+    var->SetDataType(proto::VarType::FP32);
+  }
+  return program;
+}
+
+static ProgramDesc ApplyFusionGroup(const ProgramDesc& program) {
+  std::unique_ptr<ir::Graph> graph(new ir::Graph(program));
+  auto pass = ir::PassRegistry::Instance().Get("fusion_group_pass");
+  pass->Set("use_gpu", new bool(false));
+  graph.reset(pass->Apply(graph.release()));
+  CHECK_GT(ir::GetNumOpNodes(graph, "fusion_group"), 0)
+      << "the subgraph is not fused";
+
+  ProgramDesc fused_program;
+  ir::GraphToProgram(*graph, &fused_program);
+  return fused_program;
+}
+
+// the milliseconds of a run, and the output in *out
+static double Run(const ProgramDesc& program,
+                  const std::string& out_name,
+                  std::vector<float>* out) {
+  platform::CPUPlace place;
+  Scope root;
+  Scope* scope = &root.NewScope();
+  NaiveExecutor exe(place);
+  exe.CreateVariables(program, 0, false, scope);
+  std::mt19937 rng(0);
+  std::uniform_real_distribution<float> dist(-1, 1);
+  for (auto* name : {"x", "y", "z"}) {
+    auto* tensor = scope->FindVar(name)->GetMutable<LoDTensor>();
+    float* data = tensor->mutable_data<float>(
+        phi::make_ddim({FLAGS_batch_size, FLAGS_width}), place);
+    for (int64_t i = 0; i < tensor->numel(); ++i) {
+      data[i] = dist(rng);
+    }
+  }
+  exe.Prepare(scope, program, 0, false);
+
+  // a warmup run, which allocates the outputs
+  exe.Run();
+  platform::Timer timer;
+  timer.Start();
+  for (int i = 0; i < FLAGS_repeat; ++i) {
+    exe.Run();
+  }
+  timer.Pause();
+
+  auto* tensor = exe.FindTensor(out_name);
+  out->assign(tensor->data<float>(), tensor->data<float>() + tensor->numel());
+  return timer.ElapsedMS() / FLAGS_repeat;
+}
+
+static int BenchmarkMain() {
+  std::string out_name;
+  ProgramDesc program = BuildProgram(&out_name);
+  platform::DeviceCodePool::Init({platform::CPUPlace()});
+  if (!platform::CPUDeviceCode::IsAvailable()) {
+    LOG(ERROR) << "the compiler of fusion_group on CPU is not available";
+    return 1;
+  }
+
+  platform::Timer timer;
+  timer.Start();
+  ProgramDesc fused_program = ApplyFusionGroup(program);
+  timer.Pause();
+  LOG(INFO) << "fusion_group_pass: " << timer.ElapsedMS()
+            << " ms, including the compiling or the loading of the cache";
+
+  std::vector<float> out;
+  std::vector<float> fused_out;
+  LOG(INFO) << "operators: " << Run(program, out_name, &out) << " ms";
+  LOG(INFO) << "fusion_group: " << Run(fused_program, out_name, &fused_out)
+            << " ms";
+  CHECK_EQ(out.size(), fused_out.size());
+  for (size_t i = 0; i < out.size(); ++i) {
+    CHECK_LT(std::fabs(out[i] - fused_out[i]), 1e-5)
+        << "the outputs differ at " << i;
+  }
+  return 0;
+}
+
+}  // namespace framework
+}  // namespace paddle
+
+int main(int argc, char* argv[]) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  google::InitGoogleLogging(argv[0]);
+  return paddle::framework::BenchmarkMain();
+}
@@ -0,0 +1,189 @@
+/* Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+    http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+// Compare the tokens/s of the trie WordPiece of faster_tokenizer with the
+// substring lookups of the former WordPieceTokenizer, e.g.
+//   faster_tokenizer_benchmark --vocab_file=bert-base-uncased-vocab.txt \
+//       --text_file=texts.txt --batch_size=32
+// The vocab file has a token per line, whose id is the line number, and the
+// text file has a text per line. Random ones are used without the files.
+
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <fstream>
+#include <random>
+
+#include "gflags/gflags.h"
+#include "glog/logging.h"
+#include "paddle/fluid/operators/string/faster_tokenizer_op.h"
+
+DEFINE_string(vocab_file, "", "The vocab file, a token per line.");
+DEFINE_string(text_file, "", "The text file, a text per line.");
+DEFINE_int32(batch_size, 32, "The texts of every BatchEncode.");
+DEFINE_int32(rounds, 100, "The number of passes over the texts.");
+DEFINE_bool(do_lower_case, true, "Whether to lowercase the texts.");
+
+namespace paddle {
+namespace operators {
+
+using Clock = std::chrono::steady_clock;
+
+// the greedy longest-match-first of the former WordPieceTokenizer
+static void LegacyWordPiece(const framework::Vocab& vocab,
+                            const wstring& text,
+                            int64_t unk_token_id,
+                            vector<int64_t>* token_ids) {
+  size_t len = text.size();
+  if (len > 100) {
+    token_ids->push_back(unk_token_id);
+    return;
+  }
+  auto it = vocab.find(text);
+  if (it != vocab.end()) {
+    token_ids->push_back(it->second);
+    return;
+  }
+  size_t start = 0;
+  vector<int64_t> wordpiece_ids;
+  while (start < len) {
+    size_t end = len;
+    int64_t cur_substr_id = -1;
+    while (start < end) {
+      wstring sub = text.substr(start, end - start);
+      if (start > 0) {
+        sub = L"##" + sub;
+      }
+      auto it = vocab.find(sub);
+      if (it != vocab.end()) {
+        cur_substr_id = it->second;
+        break;
+      }
+      end -= 1;
+    }
+    if (cur_substr_id < 0) {
+      token_ids->push_back(unk_token_id);
+      return;
+    }
+    start = end;
+    wordpiece_ids.push_back(cur_substr_id);
+  }
+  token_ids->insert(
+      token_ids->end(), wordpiece_ids.begin(), wordpiece_ids.end());
+}
+
+static void LoadOrGenerate(framework::Vocab* vocab, vector<string>* texts) {
+  std::mt19937 rng(0);
+  if (!FLAGS_vocab_file.empty()) {
+    std::ifstream fin(FLAGS_vocab_file);
+    string line;
+    while (std::getline(fin, line)) {
+      wstring token;
+      CHECK(framework::ConvertStrToWstr(line, &token));
+      vocab->emplace(token, static_cast<int32_t>(vocab->size()));
+    }
+  } else {
+    for (auto& token : {L"[UNK]", L"[PAD]", L"[CLS]", L"[MASK]", L"[SEP]"}) {
+      vocab->emplace(token, static_cast<int32_t>(vocab->size()));
+    }
+    while (vocab->size() < 30000) {
+      wstring token = rng() % 2 ? L"##" : L"";
+      for (int i = 2 + rng() % 6; i > 0; --i) {
+        token += static_cast<wchar_t>(L'a' + rng() % 26);
+      }
+      vocab->emplace(token, static_cast<int32_t>(vocab->size()));
+    }
+  }
+  if (!FLAGS_text_file.empty()) {
+    std::ifstream fin(FLAGS_text_file);
+    string line;
+    while (std::getline(fin, line)) {
+      texts->push_back(line);
+    }
+  } else {
+    for (int i = 0; i < 1024; ++i) {
+      string text;
+      for (int word = 5 + rng() % 60; word > 0; --word) {
+        for (int c = 2 + rng() % 10; c > 0; --c) {
+          text += static_cast<char>('a' + rng() % 26);
+        }
+        text += rng() % 10 ? " " : ", ";
+      }
+      texts->push_back(text);
+    }
+  }
+}
+
+static int BenchmarkMain() {
+  framework::Vocab vocab;
+  vector<string> texts;
+  LoadOrGenerate(&vocab, &texts);
+  CHECK(!texts.empty());
+  int64_t unk_token_id = vocab.at(L"[UNK]");
+
+  // the former op: BasicTokenizer words, then the substring lookups
+  BasicTokenizer basic_tokenizer(FLAGS_do_lower_case);
+  vector<vector<int64_t>> legacy_ids(texts.size());
+  size_t tokens = 0;
+  auto start = Clock::now();
+  for (int round = 0; round < FLAGS_rounds; ++round) {
+    for (size_t i = 0; i < texts.size(); ++i) {
+      vector<wstring> words;
+      basic_tokenizer.Tokenize(texts[i], &words);
+      legacy_ids[i].clear();
+      for (auto& word : words) {
+        LegacyWordPiece(vocab, word, unk_token_id, &legacy_ids[i]);
+      }
+      tokens += legacy_ids[i].size();
+    }
+  }
+  double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+  LOG(INFO) << "substring lookups: " << tokens / seconds << " tokens/s";
+
+  // the trie compiled once, and the batches of BatchEncode
+  start = Clock::now();
+  auto tokenizer = GetBertTokenizer(&vocab, FLAGS_do_lower_case);
+  LOG(INFO) << "trie built in "
+            << std::chrono::duration<double, std::milli>(Clock::now() - start)
+                   .count()
+            << " ms";
+  for (size_t i = 0; i < texts.size(); ++i) {
+    vector<int64_t> ids;
+    tokenizer->Tokenize(texts[i], &ids);
+    CHECK(ids == legacy_ids[i]) << "the tokens differ at text " << i;
+  }
+  tokens = 0;
+  start = Clock::now();
+  for (int round = 0; round < FLAGS_rounds; ++round) {
+    for (size_t begin = 0; begin < texts.size(); begin += FLAGS_batch_size) {
+      size_t end = std::min(texts.size(), begin + FLAGS_batch_size);
+      vector<string> batch(texts.begin() + begin, texts.begin() + end);
+      vector<unordered_map<string, vector<int64_t>>> encoded(batch.size());
+      GetBertTokenizer(&vocab, FLAGS_do_lower_case)
+          ->BatchEncode(&encoded, batch);
+      for (auto& encoded_inputs : encoded) {
+        // without [CLS] and [SEP]
+        tokens += encoded_inputs["input_ids"].size() - 2;
+      }
+    }
+  }
+  seconds = std::chrono::duration<double>(Clock::now() - start).count();
+  LOG(INFO) << "trie BatchEncode: " << tokens / seconds << " tokens/s";
+  return 0;
+}
+
+}  // namespace operators
+}  // namespace paddle
+
+int main(int argc, char* argv[]) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  google::InitGoogleLogging(argv[0]);
+  return paddle::operators::BenchmarkMain();
+}
@@ -18,7 +18,11 @@ limitations under the License. */
 #include <codecvt>
 #include <fstream>
 #include <iostream>
+#include <list>
+#include <map>
+#include <mutex>  // NOLINT
 #include <numeric>
+#include <queue>
 #include <string>
 #include <unordered_map>
 #include <unordered_set>
@@ -93,19 +97,34 @@ wchar_t BasicTokenizer::do_lower_case(wchar_t ch) const {
 
 void BasicTokenizer::Tokenize(const string& text, vector<wstring>* res) const {
   std::wstring unicode_text;
-  bool status = framework::ConvertStrToWstr(text, &unicode_text);
+  vector<std::pair<size_t, size_t>> spans;
+  Tokenize(text, &unicode_text, &spans);
+  for (auto& span : spans) {
+    res->emplace_back(unicode_text, span.first, span.second);
+  }
+}
+
+void BasicTokenizer::Tokenize(const string& text,
+                              wstring* unicode_text,
+                              vector<std::pair<size_t, size_t>>* spans) const {
+  unicode_text->clear();
+  spans->clear();
+  bool status = framework::ConvertStrToWstr(text, unicode_text);
   if (!status) {
     // String is converted into wstring failedly.
     return;
   }
-  std::wstring cache_text = L"";
+  // the chars are compacted in place, the word being read is
+  // [cache_begin, out)
+  size_t out = 0;
+  size_t cache_begin = 0;
   auto PushCacheText = [&]() {
-    if (cache_text != L"") {
-      res->emplace_back(cache_text);
-      cache_text = L"";
+    if (out > cache_begin) {
+      spans->emplace_back(cache_begin, out - cache_begin);
     }
+    cache_begin = out;
   };
-  for (auto& ch : unicode_text) {
+  for (auto ch : *unicode_text) {
     if (ch == 0 || ch == 0xfffd || IsControl(ch)) {
       continue;
     }
@@ -114,14 +133,194 @@ void BasicTokenizer::Tokenize(const string& text, vector<wstring>* res) const {
     }
     if (IsChineseChar(ch) || IsPunctuation(ch)) {
       PushCacheText();
-      res->emplace_back(std::wstring{ch});
+      (*unicode_text)[out++] = ch;
+      PushCacheText();
     } else if (IsWhiteSpace(ch)) {
       PushCacheText();
     } else {
-      cache_text += ch;
+      (*unicode_text)[out++] = ch;
     }
   }
   PushCacheText();
+  unicode_text->resize(out);
+}
+
+WordPieceTrie::WordPieceTrie(const framework::Vocab& vocab) {
+  // builds the pointer trie of the tokens first
+  struct BuildNode {
+    std::map<int, int> children;
+    int token_id = -1;
+  };
+  vector<BuildNode> nodes(1);
+  // numbers the chars by their first appearance, the codes only need to be
+  // distinct and small
+  int next_code = 1;
+  auto Insert = [&](const wstring& token) {
+    int node = 0;
+    for (auto ch : token) {
+      size_t index = static_cast<size_t>(ch);
+      if (index >= char_codes_.size()) {
+        char_codes_.resize(index + 1, 0);
+      }
+      if (char_codes_[index] == 0) {
+        char_codes_[index] = next_code++;
+      }
+      int code = char_codes_[index];
+      auto it = nodes[node].children.find(code);
+      if (it == nodes[node].children.end()) {
+        nodes[node].children[code] = static_cast<int>(nodes.size());
+        node = static_cast<int>(nodes.size());
+        nodes.emplace_back();
+      } else {
+        node = it->second;
+      }
+    }
+    return node;
+  };
+  for (auto& item : vocab) {
+    nodes[Insert(item.first)].token_id = item.second;
+  }
+  int sharp_build_node = Insert(L"##");
+
+  // places the children of every node at base + code of the double array,
+  // in the BFS order so that the nodes of a level are close to each other
+  vector<int> slots(nodes.size(), -1);
+  slots[0] = kRoot;
+  check_.assign(1, -1);
+  base_.assign(1, 0);
+  vector<int> order;
+  order.reserve(nodes.size());
+  order.push_back(0);
+  size_t first_free = 1;
+  for (size_t i = 0; i < order.size(); ++i) {
+    auto& children = nodes[order[i]].children;
+    if (children.empty()) {
+      continue;
+    }
+    int min_code = children.begin()->first;
+    size_t pos = std::max(first_free, static_cast<size_t>(min_code));
+    size_t base = 0;
+    while (true) {
+      base = pos - min_code;
+      bool fit = true;
+      for (auto& child : children) {
+        size_t slot = base + child.first;
+        if (slot < check_.size() && check_[slot] != -1) {
+          fit = false;
+          break;
+        }
+      }
+      if (fit) break;
+      // the next free slot for the smallest code
+      do {
+        ++pos;
+      } while (pos < check_.size() && check_[pos] != -1);
+    }
+    int slot = slots[order[i]];
+    base_[slot] = static_cast<int>(base);
+    size_t max_slot = base + children.rbegin()->first;
+    if (max_slot >= check_.size()) {
+      check_.resize(max_slot + 1, -1);
+      base_.resize(max_slot + 1, 0);
+    }
+    for (auto& child : children) {
+      check_[base + child.first] = slot;
+      slots[child.second] = static_cast<int>(base + child.first);
+      order.push_back(child.second);
+    }
+    while (first_free < check_.size() && check_[first_free] != -1) {
+      ++first_free;
+    }
+  }
+  token_ids_.assign(check_.size(), -1);
+  for (size_t node = 0; node < nodes.size(); ++node) {
+    token_ids_[slots[node]] = nodes[node].token_id;
+  }
+  sharp_node_ = slots[sharp_build_node];
+
+  // the failure links in the BFS order from both the root and the node of
+  // "##", as the "##" of the wordpieces is not counted in their depth, see
+  // Algorithm 2 of LinMaxMatch
+  fail_.assign(check_.size(), -1);
+  pops_begin_.assign(check_.size(), 0);
+  pops_len_.assign(check_.size(), 0);
+  vector<int> pops;
+  std::queue<int> queue;
+  queue.push(0);
+  queue.push(sharp_build_node);
+  while (!queue.empty()) {
+    int node = queue.front();
+    queue.pop();
+    int u = slots[node];
+    for (auto& child : nodes[node].children) {
+      int v = slots[child.second];
+      if (v == sharp_node_) {
+        continue;
+      }
+      queue.push(child.second);
+      if (token_ids_[v] >= 0) {
+        fail_[v] = sharp_node_;
+        pops_begin_[v] = static_cast<int>(pops_.size());
+        pops_len_[v] = 1;
+        pops_.push_back(token_ids_[v]);
+        continue;
+      }
+      int z = fail_[u];
+      pops.assign(pops_.begin() + pops_begin_[u],
+                  pops_.begin() + pops_begin_[u] + pops_len_[u]);
+      while (z >= 0 && Child(z, child.first) < 0) {
+        pops.insert(pops.end(),
+                    pops_.begin() + pops_begin_[z],
+                    pops_.begin() + pops_begin_[z] + pops_len_[z]);
+        z = fail_[z];
+      }
+      if (z >= 0) {
+        fail_[v] = Child(z, child.first);
+        pops_begin_[v] = static_cast<int>(pops_.size());
+        pops_len_[v] = static_cast<int>(pops.size());
+        pops_.insert(pops_.end(), pops.begin(), pops.end());
+      }
+    }
+  }
+}
+
+bool WordPieceTrie::Tokenize(const wchar_t* word,
+                             size_t len,
+                             vector<int64_t>* ids) const {
+  size_t start = ids->size();
+  auto Fail = [&]() {
+    ids->resize(start);
+    return false;
+  };
+  int u = kRoot;
+  for (size_t i = 0; i < len; ++i) {
+    int code = Code(word[i]);
+    int v;
+    while ((v = Child(u, code)) < 0) {
+      if (fail_[u] < 0) return Fail();
+      ids->insert(ids->end(),
+                  pops_.begin() + pops_begin_[u],
+                  pops_.begin() + pops_begin_[u] + pops_len_[u]);
+      u = fail_[u];
+    }
+    u = v;
+  }
+  while (u != kRoot && u != sharp_node_) {
+    if (fail_[u] < 0) return Fail();
+    ids->insert(ids->end(),
+                pops_.begin() + pops_begin_[u],
+                pops_.begin() + pops_begin_[u] + pops_len_[u]);
+    u = fail_[u];
+  }
+  return true;
+}
+
+int64_t WordPieceTrie::Find(const wchar_t* token, size_t len) const {
+  int u = kRoot;
+  for (size_t i = 0; i < len && u >= 0; ++i) {
+    u = Child(u, Code(token[i]));
+  }
+  return u >= 0 ? token_ids_[u] : -1;
 }
 
 WordPieceTokenizer::WordPieceTokenizer(
@@ -130,54 +329,22 @@ WordPieceTokenizer::WordPieceTokenizer(
     const size_t max_input_chars_per_word /* = 100 */)
     : vocab_(vocab),
       unk_token_(unk_token),
-      max_input_chars_per_word_(max_input_chars_per_word) {
+      max_input_chars_per_word_(max_input_chars_per_word),
+      trie_(*vocab) {
   unk_token_id_ = vocab_->at(unk_token_);
 }
 
 void WordPieceTokenizer::Tokenize(const wstring& text,
                                   vector<int64_t>* token_ids) const {
-  size_t len = text.size();
-  if (len > max_input_chars_per_word_) {
-    token_ids->emplace_back(std::move(unk_token_id_));
-    return;
-  }
-
-  auto it = vocab_->find(text);
-  if (it != vocab_->end()) {
-    token_ids->emplace_back(std::move(it->second));
-    return;
-  }
-
-  size_t start = 0;
-  vector<int64_t> wordpiece_ids;
-  while (start < len) {
-    size_t end = len;
-    std::wstring cur_substr;
-    int64_t cur_substr_id;
-    while (start < end) {
-      std::wstring sub = text.substr(start, end - start);
-      if (start > 0) {
-        sub = L"##" + sub;
-      }
-      auto it = vocab_->find(sub);
-      if (it != vocab_->end()) {
-        cur_substr = sub;
-        cur_substr_id = it->second;
-        break;
-      }
-      end -= 1;
-    }
+  Tokenize(text.data(), text.size(), token_ids);
+}
 
-    if (cur_substr.empty()) {
-      token_ids->emplace_back(std::move(unk_token_id_));
-      return;
-    } else {
-      start = end;
-      wordpiece_ids.emplace_back(std::move(cur_substr_id));
-    }
-  }
-  for (auto& token_id : wordpiece_ids) {
-    token_ids->emplace_back(std::move(token_id));
+void WordPieceTokenizer::Tokenize(const wchar_t* text,
+                                  size_t len,
+                                  vector<int64_t>* token_ids) const {
+  if (len > max_input_chars_per_word_ ||
+      !trie_.Tokenize(text, len, token_ids)) {
+    token_ids->emplace_back(unk_token_id_);
   }
 }
 
@@ -216,27 +383,18 @@ BertTokenizer::BertTokenizer(const framework::Vocab* vocab,
 
 void BertTokenizer::Tokenize(const string& text,
                              vector<int64_t>* split_token_ids) const {
-  std::vector<std::wstring> tmp_tokens;
-  basic_tokenizer_.Tokenize(text, &tmp_tokens);
-  if (tmp_tokens.empty()) return;
-  split_token_ids->reserve(tmp_tokens.size());
-  for (auto& w_token : tmp_tokens) {
-    const auto& vec_size = w_token.size();
-    if (vec_size == 1) {
-      if (IsChineseChar(w_token[0])) {
-        auto vocab_it = vocab_->find(w_token);
-        if (vocab_it != vocab_->end()) {
-          split_token_ids->emplace_back(std::move(vocab_it->second));
-        } else {
-          split_token_ids->emplace_back(std::move(unk_token_id_));
-        }
-      } else {
-        word_piece_tokenizer_.Tokenize(w_token, split_token_ids);
-      }
-    } else if (vec_size > 1) {
-      word_piece_tokenizer_.Tokenize(w_token, split_token_ids);
+  std::wstring unicode_text;
+  vector<std::pair<size_t, size_t>> spans;
+  basic_tokenizer_.Tokenize(text, &unicode_text, &spans);
+  if (spans.empty()) return;
+  split_token_ids->reserve(spans.size());
+  for (auto& span : spans) {
+    const wchar_t* token = unicode_text.data() + span.first;
+    if (span.second == 1 && IsChineseChar(token[0])) {
+      auto token_id = word_piece_tokenizer_.trie().Find(token, 1);
+      split_token_ids->emplace_back(token_id >= 0 ? token_id : unk_token_id_);
     } else {
-      continue;
+      word_piece_tokenizer_.Tokenize(token, span.second, split_token_ids);
     }
   }
 }
@@ -337,13 +495,8 @@ int BertTokenizer::Encode(
       return 0;
     }
     for (size_t i = 0; i < unicode_text.size(); i++) {
-      wstring token = unicode_text.substr(i, 1);
-      auto it = vocab_->find(token);
-      if (it != vocab_->end()) {
-        ids.emplace_back(std::move(it->second));
-      } else {
-        ids.emplace_back(std::move(unk_token_id_));
-      }
+      auto token_id = word_piece_tokenizer_.trie().Find(&unicode_text[i], 1);
+      ids.emplace_back(token_id >= 0 ? token_id : unk_token_id_);
     }
   }
 
@@ -418,8 +571,9 @@ void BertTokenizer::BatchEncode(
   }
 
   size_t batch_size = batch_text.size();
+  // the texts differ in length, so the threads take them a few at a time
 #ifdef PADDLE_WITH_MKLML
-#pragma omp parallel for
+#pragma omp parallel for schedule(dynamic, 4)
 #endif
   for (size_t i = 0; i < batch_size; i++) {
     unordered_map<string, vector<int64_t>> res;
@@ -452,6 +606,60 @@ void BertTokenizer::BatchEncode(
   }
 }
 
+// A fingerprint of the content of the vocab, which is computed at every call:
+// the size and the entries of 64 buckets spread over the hash table. It only
+// narrows the cached tokenizers to compare, two vocabs differing in a few
+// entries may have the same fingerprint.
+static uint64_t VocabFingerprint(const framework::Vocab& vocab) {
+  const size_t kSampledBuckets = 64;
+  std::hash<wstring> hasher;
+  uint64_t fingerprint = vocab.size();
+  size_t stride = std::max<size_t>(vocab.bucket_count() / kSampledBuckets, 1);
+  for (size_t i = 0; i < vocab.bucket_count(); i += stride) {
+    for (auto iter = vocab.begin(i); iter != vocab.end(i); ++iter) {
+      fingerprint = fingerprint * 0x100000001b3ULL ^ hasher(iter->first) ^
+                    static_cast<uint64_t>(iter->second);
+    }
+  }
+  return fingerprint;
+}
+
+std::shared_ptr<const BertTokenizer> GetBertTokenizer(
+    const framework::Vocab* vocab, bool do_lower_case) {
+  // The tokenizer refers to a copy of the vocab, which lives as long as the
+  // tokenizer, as the vocab of the caller may be changed or freed.
+  struct CachedTokenizer {
+    CachedTokenizer(const framework::Vocab& vocab, bool do_lower_case)
+        : vocab(vocab), tokenizer(&this->vocab, do_lower_case) {}
+    framework::Vocab vocab;
+    BertTokenizer tokenizer;
+  };
+  using Key = std::pair<uint64_t, bool>;
+  // the most recently used first
+  static std::list<std::pair<Key, std::shared_ptr<CachedTokenizer>>> cache;
+  static std::mutex mutex;
+  const size_t kMaxCachedTokenizers = 8;
+
+  Key key(VocabFingerprint(*vocab), do_lower_case);
+  std::lock_guard<std::mutex> lock(mutex);
+  // a hit needs the same content, the cost of the comparison is linear in
+  // the vocab size, far less than building the tokenizer
+  auto iter = std::find_if(cache.begin(), cache.end(), [&](const auto& item) {
+    return item.first == key && item.second->vocab == *vocab;
+  });
+  if (iter != cache.end()) {
+    cache.splice(cache.begin(), cache, iter);
+  } else {
+    cache.emplace_front(
+        key, std::make_shared<CachedTokenizer>(*vocab, do_lower_case));
+    if (cache.size() > kMaxCachedTokenizers) {
+      cache.pop_back();
+    }
+  }
+  auto& cached = cache.front().second;
+  return std::shared_ptr<const BertTokenizer>(cached, &cached->tokenizer);
+}
+
 class FasterTokenizerOp : public framework::OperatorWithKernel {
  public:
   using framework::OperatorWithKernel::OperatorWithKernel;
@@ -13,9 +13,11 @@ limitations under the License. */
 
 #include <utf8proc.h>
 
+#include <memory>
 #include <string>
 #include <unordered_map>
 #include <unordered_set>
+#include <utility>
 #include <vector>
 
 #include "paddle/fluid/framework/op_registry.h"
@@ -46,6 +48,12 @@ class BasicTokenizer {
  public:
   explicit BasicTokenizer(bool do_lower_case = true);
   void Tokenize(const string& text, vector<wstring>* res) const;
+  // The same as above, but the tokens are the [begin, begin + len) spans of
+  // unicode_text, which holds the text without the control chars, lower cased
+  // if do_lower_case.
+  void Tokenize(const string& text,
+                wstring* unicode_text,
+                vector<std::pair<size_t, size_t>>* spans) const;
 
  private:
   wchar_t do_lower_case(wchar_t ch) const;
@@ -53,18 +61,68 @@ class BasicTokenizer {
   bool do_lower_case_;
 };
 
+// The vocab compiled into a double-array trie, with the failure links and the
+// failure pops of LinMaxMatch (Song et al., Fast WordPiece Tokenization), so
+// that the longest-match-first wordpieces of a word are found in one pass over
+// its chars. The wordpieces "##xxx" are the children of the node of "##".
+class WordPieceTrie {
+ public:
+  explicit WordPieceTrie(const framework::Vocab& vocab);
+
+  // Appends the wordpiece ids of word[0, len) to ids, returns false and
+  // appends nothing if the word can not be split into the wordpieces.
+  bool Tokenize(const wchar_t* word, size_t len, vector<int64_t>* ids) const;
+  // The id of the token token[0, len), or -1 if it is not in the vocab.
+  int64_t Find(const wchar_t* token, size_t len) const;
+
+ private:
+  int Code(wchar_t ch) const {
+    size_t index = static_cast<size_t>(ch);
+    return index < char_codes_.size() ? char_codes_[index] : 0;
+  }
+  int Child(int node, int code) const {
+    if (code == 0) return -1;
+    size_t next = static_cast<size_t>(base_[node]) + code;
+    if (next < check_.size() && check_[next] == node) {
+      return static_cast<int>(next);
+    }
+    return -1;
+  }
+
+  static constexpr int kRoot = 0;
+  // the codes of the chars of the vocab start from 1, 0 for the others
+  vector<int> char_codes_;
+  vector<int> base_;
+  vector<int> check_;
+  // the token id of every node, -1 if the node is not a token
+  vector<int> token_ids_;
+  // the failure link of every node, -1 if the word fails to be split
+  vector<int> fail_;
+  // the ids popped when the failure link is followed, which are the
+  // [pops_begin_, pops_begin_ + pops_len_) of pops_
+  vector<int> pops_begin_;
+  vector<int> pops_len_;
+  vector<int> pops_;
+  int sharp_node_;
+};
+
 class WordPieceTokenizer {
  public:
   explicit WordPieceTokenizer(const framework::Vocab* vocab,
                               const wstring& unk_token = L"[UNK]",
                               const size_t max_input_chars_per_word = 100);
   void Tokenize(const wstring& text, vector<int64_t>* output) const;
+  void Tokenize(const wchar_t* text,
+                size_t len,
+                vector<int64_t>* output) const;
+  const WordPieceTrie& trie() const { return trie_; }
 
  private:
   const framework::Vocab* vocab_;
   wstring unk_token_{L"[UNK]"};
   int64_t unk_token_id_;
   size_t max_input_chars_per_word_;
+  WordPieceTrie trie_;
 };
 
 class BertTokenizer {
@@ -122,6 +180,12 @@ class BertTokenizer {
   InvVocab inv_vocab_;
 };
 
+// The BertTokenizer of the vocab, which is built at the first call and shared
+// by the later calls with a vocab of the same content. The tokenizers of the
+// latest 8 vocabs are kept, each with its own copy of the vocab.
+std::shared_ptr<const BertTokenizer> GetBertTokenizer(
+    const framework::Vocab* vocab, bool do_lower_case);
+
 template <typename T>
 class FasterTokenizerKernel : public framework::OpKernel<T> {
  public:
@@ -146,7 +210,8 @@ class FasterTokenizerKernel : public framework::OpKernel<T> {
       return;
     }
 
-    BertTokenizer tokenizer(vocab, do_lower_case);
+    auto tokenizer_ptr = GetBertTokenizer(vocab, do_lower_case);
+    const BertTokenizer& tokenizer = *tokenizer_ptr;
     size_t batch_max_seq_len = 0;
     size_t batch_size = text->size();
 
@@ -0,0 +1,159 @@
+/* Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+    http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/fluid/operators/string/faster_tokenizer_op.h"
+
+#include <memory>
+#include <string>
+
+#include "gtest/gtest.h"
+
+namespace paddle {
+namespace operators {
+
+static framework::Vocab MakeVocab() {
+  framework::Vocab vocab;
+  for (auto& token : {L"[UNK]", L"[PAD]", L"[CLS]", L"[MASK]", L"[SEP]",
+                      L"a",     L"abcdx", L"##b",   L"##c",    L"##cdy",
+                      L"##dz",  L"c",     L"##a",   L"caab",   L"un",
+                      L"##aff", L"##able", L"!",    L"你"}) {
+    vocab.emplace(token, static_cast<int32_t>(vocab.size()));
+  }
+  return vocab;
+}
+
+static vector<int64_t> Ids(const framework::Vocab& vocab,
+                           const vector<wstring>& tokens) {
+  vector<int64_t> ids;
+  for (auto& token : tokens) {
+    ids.push_back(vocab.at(token));
+  }
+  return ids;
+}
+
+TEST(WordPieceTokenizer, LongestMatchFirst) {
+  auto vocab = MakeVocab();
+  WordPieceTokenizer tokenizer(&vocab);
+  auto Tokenize = [&](const wstring& word) {
+    vector<int64_t> ids;
+    tokenizer.Tokenize(word, &ids);
+    return ids;
+  };
+  EXPECT_EQ(Tokenize(L"abcdx"), Ids(vocab, {L"abcdx"}));
+  // the failure links skip back from the prefix of "abcdx"
+  EXPECT_EQ(Tokenize(L"abcdz"), Ids(vocab, {L"a", L"##b", L"##c", L"##dz"}));
+  EXPECT_EQ(Tokenize(L"abcdy"), Ids(vocab, {L"a", L"##b", L"##cdy"}));
+  EXPECT_EQ(Tokenize(L"caa"), Ids(vocab, {L"c", L"##a", L"##a"}));
+  EXPECT_EQ(Tokenize(L"unaffable"), Ids(vocab, {L"un", L"##aff", L"##able"}));
+  // the whole word is unknown if a part of it can not be matched
+  EXPECT_EQ(Tokenize(L"abcd"), Ids(vocab, {L"[UNK]"}));
+  EXPECT_EQ(Tokenize(L"xa"), Ids(vocab, {L"[UNK]"}));
+  EXPECT_EQ(Tokenize(wstring(101, L'a')), Ids(vocab, {L"[UNK]"}));
+  EXPECT_TRUE(Tokenize(L"").empty());
+
+  auto& trie = tokenizer.trie();
+  for (auto& item : vocab) {
+    EXPECT_EQ(trie.Find(item.first.data(), item.first.size()), item.second);
+  }
+  EXPECT_EQ(trie.Find(L"ab", 2), -1);
+  EXPECT_EQ(trie.Find(L"##", 2), -1);
+}
+
+TEST(BertTokenizer, Tokenize) {
+  auto vocab = MakeVocab();
+  BertTokenizer tokenizer(&vocab, true);
+  vector<int64_t> ids;
+  tokenizer.Tokenize("UnAffable abcdz!\t你好", &ids);
+  EXPECT_EQ(ids,
+            Ids(vocab,
+                {L"un",
+                 L"##aff",
+                 L"##able",
+                 L"a",
+                 L"##b",
+                 L"##c",
+                 L"##dz",
+                 L"!",
+                 L"你",
+                 L"[UNK]"}));
+
+  vector<wstring> tokens;
+  BasicTokenizer basic_tokenizer(true);
+  basic_tokenizer.Tokenize("UnAffable abcdz!\t你", &tokens);
+  EXPECT_EQ(tokens, vector<wstring>({L"unaffable", L"abcdz", L"!", L"你"}));
+}
+
+TEST(BertTokenizer, Cache) {
+  auto vocab = MakeVocab();
+  auto tokenizer = GetBertTokenizer(&vocab, true);
+  EXPECT_EQ(GetBertTokenizer(&vocab, true), tokenizer);
+  EXPECT_NE(GetBertTokenizer(&vocab, false), tokenizer);
+  // a changed vocab is compiled again
+  vocab.emplace(L"abcdz", static_cast<int32_t>(vocab.size()));
+  auto new_tokenizer = GetBertTokenizer(&vocab, true);
+  EXPECT_NE(new_tokenizer, tokenizer);
+  vector<int64_t> ids;
+  new_tokenizer->Tokenize("abcdz", &ids);
+  EXPECT_EQ(ids, Ids(vocab, {L"abcdz"}));
+
+
+  // the tokenizer keeps a copy of the vocab, so it is still valid after the
+  // vocab is freed, and another vocab at the same address is not mistaken
+  auto expected_ids = ids;
+  vocab = MakeVocab();
+  vocab.emplace(L"abcdy", static_cast<int32_t>(vocab.size()));
+  ids.clear();
+  new_tokenizer->Tokenize("abcdz", &ids);
+  EXPECT_EQ(ids, expected_ids);
+  ids.clear();
+  GetBertTokenizer(&vocab, true)->Tokenize("abcdz", &ids);
+  EXPECT_EQ(ids, Ids(vocab, {L"a", L"##b", L"##c", L"##dz"}));
+}
+
+TEST(BertTokenizer, CacheSameSizeVocab) {
+  // a fine-tuned vocab replaces a few tokens of a large one, which is not
+  // told apart by the size or a sample of the entries
+  auto vocab = MakeVocab();
+  for (int i = 0; i < 30000; ++i) {
+    vocab.emplace(L"word" + std::to_wstring(i),
+                  static_cast<int32_t>(vocab.size()));
+  }
+  auto tuned_vocab = vocab;
+  int32_t id = tuned_vocab.at(L"word12345");
+  tuned_vocab.erase(L"word12345");
+  tuned_vocab.emplace(L"domain", id);
+
+  vector<int64_t> ids;
+  GetBertTokenizer(&vocab, true)->Tokenize("word12345 domain", &ids);
+  EXPECT_EQ(ids, Ids(vocab, {L"word12345", L"[UNK]"}));
+  ids.clear();
+  GetBertTokenizer(&tuned_vocab, true)->Tokenize("word12345 domain", &ids);
+  EXPECT_EQ(ids, Ids(tuned_vocab, {L"[UNK]", L"domain"}));
+}
+
+TEST(BertTokenizer, CacheEviction) {
+  auto vocab = MakeVocab();
+  vocab.emplace(L"evicted", static_cast<int32_t>(vocab.size()));
+  std::weak_ptr<const BertTokenizer> tokenizer =
+      GetBertTokenizer(&vocab, true);
+  // the tokenizers of the 8 latest vocabs are kept
+  for (int i = 0; i < 8; ++i) {
+    EXPECT_FALSE(tokenizer.expired());
+    auto other_vocab = MakeVocab();
+    other_vocab.emplace(L"other" + std::to_wstring(i),
+                        static_cast<int32_t>(other_vocab.size()));
+    GetBertTokenizer(&other_vocab, true);
+  }
+  EXPECT_TRUE(tokenizer.expired());
+}
+
+}  // namespace operators
+}  // namespace paddle
@@ -14,15 +14,23 @@ limitations under the License. */
 
 #include "paddle/fluid/platform/device_code.h"
 
+#include <dlfcn.h>
+#include <errno.h>
+#include <stdlib.h>
 #include <sys/stat.h>
+#include <unistd.h>
 
 #include <algorithm>
-#include <set>
+#include <fstream>
+#include <functional>
+#include <sstream>
 #include <utility>
 
 #include "paddle/fluid/platform/enforce.h"
 
 DECLARE_string(cuda_dir);
+DECLARE_string(fusion_group_cpu_cache_dir);
+DECLARE_string(fusion_group_cpu_compiler);
 
 namespace paddle {
 namespace platform {
@@ -69,26 +77,251 @@ DeviceCodePool::DeviceCodePool(const std::vector<platform::Place>& places) {
                     errors::InvalidArgument(
                         "Expected the number of places >= 1. But received %d.",
                         places.size()));
-  // Remove the duplicated places
-  std::set<Place> set;
   for (auto& p : places) {
-    set.insert(p);
+    AddPlace(p);
   }
-  for (auto& p : set) {
-    if (is_gpu_place(p)) {
+}
+
+void DeviceCodePool::AddPlace(const platform::Place& place) {
+  if (device_codes_.find(place) != device_codes_.end()) {
+    return;
+  }
+  if (is_gpu_place(place)) {
 #if defined(PADDLE_WITH_CUDA) || defined(PADDLE_WITH_HIP)
-      device_codes_.emplace(p, DeviceCodeMap());
+    device_codes_.emplace(place, DeviceCodeMap());
+    CUDADeviceCode::CheckAvailableStatus();
 #else
-      PADDLE_THROW(platform::errors::PreconditionNotMet(
-          "CUDAPlace or HIPPlace is not supported, please re-compile with "
-          "WITH_GPU=ON or WITH_ROCM=ON."));
+    PADDLE_THROW(platform::errors::PreconditionNotMet(
+        "CUDAPlace or HIPPlace is not supported, please re-compile with "
+        "WITH_GPU=ON or WITH_ROCM=ON."));
 #endif
+  } else if (is_cpu_place(place)) {
+    device_codes_.emplace(place, DeviceCodeMap());
+    CPUDeviceCode::CheckAvailableStatus();
+  }
+}
+
+bool CPUDeviceCode::available_ = false;
+void CPUDeviceCode::CheckAvailableStatus() {
+  std::string command =
+      FLAGS_fusion_group_cpu_compiler + " --version > /dev/null 2>&1";
+  available_ = system(command.c_str()) == 0;
+  if (!available_) {
+    LOG_FIRST_N(WARNING, 1)
+        << "The compiler (" << FLAGS_fusion_group_cpu_compiler
+        << ") is needed for JIT compiling of CPU code.";
+  }
+}
+
+// The directory of the compiled code, which is
+// $TMPDIR/paddle_fusion_group_<uid> by default.
+static std::string CacheDir() {
+  if (!FLAGS_fusion_group_cpu_cache_dir.empty()) {
+    return FLAGS_fusion_group_cpu_cache_dir;
+  }
+  const char* tmp_dir = getenv("TMPDIR");
+  return std::string(tmp_dir && tmp_dir[0] ? tmp_dir : "/tmp") +
+         "/paddle_fusion_group_" + std::to_string(geteuid());
+}
+
+// The parent directories are created with mode 0755 and the last one 0700.
+static bool MakeDirs(const std::string& dir) {
+  for (size_t pos = dir.find('/', 1);; pos = dir.find('/', pos + 1)) {
+    std::string sub_dir = dir.substr(0, pos);
+    mode_t mode = pos == std::string::npos ? 0700 : 0755;
+    if (mkdir(sub_dir.c_str(), mode) != 0 && errno != EEXIST) {
+      return false;
+    }
+    if (pos == std::string::npos) {
+      return true;
     }
   }
+}
 
-#if defined(PADDLE_WITH_CUDA) || defined(PADDLE_WITH_HIP)
-  CUDADeviceCode::CheckAvailableStatus();
+// Whether the path, which is not a symbolic link, is of the type, owned by
+// the current user and not writable by the others. The shared objects are
+// loaded only from such a directory and of such files, so that they are never
+// planted by the others.
+static bool IsPrivate(const std::string& path, mode_t type) {
+  struct stat st;
+  return lstat(path.c_str(), &st) == 0 && (st.st_mode & S_IFMT) == type &&
+         st.st_uid == geteuid() && (st.st_mode & (S_IWGRP | S_IWOTH)) == 0;
+}
+
+static bool ReadFile(const std::string& path, std::string* content) {
+  std::ifstream fin(path);
+  if (!fin) {
+    return false;
+  }
+  std::stringstream buffer;
+  buffer << fin.rdbuf();
+  *content = buffer.str();
+  return true;
+}
+
+// The model and the flags of the host CPU, which are hashed with the code, so
+// that the objects compiled with -march=native are not loaded on the other
+// CPUs sharing the directory.
+static const std::string& HostCPUId() {
+  static const std::string cpu_id = [] {
+    std::ifstream fin("/proc/cpuinfo");
+    std::string line;
+    std::string id;
+    while (std::getline(fin, line)) {
+      if (line.compare(0, 10, "model name") == 0 ||
+          line.compare(0, 5, "flags") == 0) {
+        id += line + "\n";
+      }
+      if (line.empty() && !id.empty()) {
+        break;
+      }
+    }
+    return id;
+  }();
+  return cpu_id;
+}
+
+CPUDeviceCode::CPUDeviceCode(const Place& place,
+                             const std::string& name,
+                             const std::string& kernel) {
+  if (!is_cpu_place(place)) {
+    PADDLE_THROW(platform::errors::PermissionDenied(
+        "CPUDeviceCode can only launch on CPU place."));
+  }
+
+  place_ = place;
+  name_ = name;
+  kernel_ = kernel;
+}
+
+CPUDeviceCode::~CPUDeviceCode() {
+  if (handle_) {
+    dlclose(handle_);
+  }
+}
+
+bool CPUDeviceCode::Compile(bool include_path) {
+  if (handle_) {
+    dlclose(handle_);
+    handle_ = nullptr;
+  }
+  function_ = nullptr;
+
+  // The same code compiled by the same command is shared by the processes of
+  // the same user, whose shared object is used only if the cached source is
+  // the same.
+  std::string dir = CacheDir();
+  if (!MakeDirs(dir) || !IsPrivate(dir, S_IFDIR)) {
+    LOG_FIRST_N(WARNING, 1)
+        << "Cannot create the directory " << dir
+        << " for JIT compiling of CPU code, or it is not owned by the user "
+           "or is writable by the others.";
+    return false;
+  }
+  std::string hash = std::to_string(std::hash<std::string>()(
+      FLAGS_fusion_group_cpu_compiler + "\n" + HostCPUId() + kernel_));
+  std::string prefix = dir + "/" + name_ + "_" + hash;
+  std::string src_path = prefix + ".cc";
+  std::string lib_path = prefix + ".so";
+
+  std::string cached_kernel;
+  if (!IsPrivate(src_path, S_IFREG) || !IsPrivate(lib_path, S_IFREG) ||
+      !ReadFile(src_path, &cached_kernel) || cached_kernel != kernel_) {
+    // Compile into the temporary files of unique names, which are renamed at
+    // last, so that the other threads and processes never see a partial one.
+    std::string src_tmp = prefix + ".XXXXXX";
+    int fd = mkstemp(&src_tmp[0]);
+    if (fd < 0) {
+      LOG_FIRST_N(WARNING, 1) << "Cannot create a temporary file in " << dir
+                              << " for JIT compiling of CPU code.";
+      return false;
+    }
+    std::string lib_tmp = src_tmp + ".so";
+    ssize_t size = write(fd, kernel_.data(), kernel_.size());
+    close(fd);
+    if (size != static_cast<ssize_t>(kernel_.size())) {
+      LOG_FIRST_N(WARNING, 1) << "Cannot write " << src_tmp
+                              << " for JIT compiling of CPU code.";
+      unlink(src_tmp.c_str());
+      return false;
+    }
+    std::string command = FLAGS_fusion_group_cpu_compiler +
+                          " -shared -fPIC -x c++ -o " + lib_tmp + " " +
+                          src_tmp + " -lm 2>&1";
+    std::string log;
+    int status = -1;
+    FILE* pipe = popen(command.c_str(), "r");
+    if (pipe) {
+      char buf[4096];
+      size_t len = 0;
+      while ((len = fread(buf, 1, sizeof(buf), pipe)) > 0) {
+        log.append(buf, len);
+      }
+      status = pclose(pipe);
+    }
+    if (status != 0) {
+      LOG(WARNING) << "JIT compiling of CPU code failed:"
+                   << "\n  Kernel name: " << name_ << "\n  Kernel body:\n"
+                   << kernel_ << "\n  Compiling command: " << command
+                   << "\n  Compiling log: " << log;
+      unlink(src_tmp.c_str());
+      unlink(lib_tmp.c_str());
+      return false;
+    }
+    // The shared object is renamed before the source, so a matched source
+    // always comes with its shared object.
+    if (chmod(lib_tmp.c_str(), 0700) != 0 ||
+        rename(lib_tmp.c_str(), lib_path.c_str()) != 0 ||
+        rename(src_tmp.c_str(), src_path.c_str()) != 0) {
+      LOG_FIRST_N(WARNING, 1) << "Cannot rename the compiled " << lib_path
+                              << " of CPU code.";
+      unlink(src_tmp.c_str());
+      unlink(lib_tmp.c_str());
+      return false;
+    }
+  }
+
+  handle_ = dlopen(lib_path.c_str(), RTLD_NOW | RTLD_LOCAL);
+  if (!handle_) {
+    LOG(WARNING) << "Load " << lib_path << " for < " << name_
+                 << " > failed: " << dlerror();
+    return false;
+  }
+  function_ = reinterpret_cast<KernelFunc>(dlsym(handle_, name_.c_str()));
+  if (!function_) {
+    LOG(WARNING) << "Find < " << name_ << " > in " << lib_path
+                 << " failed: " << dlerror();
+    return false;
+  }
+  return true;
+}
+
+void CPUDeviceCode::Launch(const size_t n, std::vector<void*>* args) const {
+  PADDLE_ENFORCE_NOT_NULL(
+      function_,
+      errors::PreconditionNotMet(
+          "Please compile the code before launching the kernel."));
+
+  // args[0] is the address of n, and the others are the addresses of the
+  // data pointers.
+  std::vector<void*> data(args->size() - 1);
+  for (size_t i = 1; i < args->size(); ++i) {
+    data[i - 1] = *static_cast<void**>((*args)[i]);
+  }
+
+  // The chunks fit in L2 cache with several operands, and every one is
+  // vectorized in the kernel.
+  const int64_t kChunkSize = 16384;
+  int64_t numel = static_cast<int64_t>(n);
+  int64_t num_chunks = (numel + kChunkSize - 1) / kChunkSize;
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for if (num_chunks > 1)
 #endif
+  for (int64_t i = 0; i < num_chunks; ++i) {
+    function_(i * kChunkSize,
+              std::min(numel, (i + 1) * kChunkSize),
+              data.data());
+  }
 }
 
 #if defined(PADDLE_WITH_CUDA) || defined(PADDLE_WITH_HIP)
@@ -48,6 +48,37 @@ class DeviceCode {
   std::string kernel_;
 };
 
+// The C++ code compiled into a shared object by the command of
+// FLAGS_fusion_group_cpu_compiler, which is cached in
+// FLAGS_fusion_group_cpu_cache_dir by the hash of the code and the command.
+// Only the files owned by the user in a directory not writable by the others
+// are loaded.
+// The kernel is defined as
+//   extern "C" void name(int64_t begin, int64_t end, void** args)
+// which computes the elements in [begin, end) of the data in args. Launch
+// takes the arguments of CUDADeviceCode, i.e. the address of n followed by
+// the addresses of the data pointers, and splits [0, n) among the threads.
+class CPUDeviceCode : public DeviceCode {
+ public:
+  explicit CPUDeviceCode(const Place& place,
+                         const std::string& name,
+                         const std::string& kernel);
+  ~CPUDeviceCode();
+  bool Compile(bool include_path = false) override;
+  void Launch(const size_t n, std::vector<void*>* args) const override;
+
+  static void CheckAvailableStatus();
+  static bool IsAvailable() { return available_; }
+
+ private:
+  using KernelFunc = void (*)(int64_t, int64_t, void**);
+
+  static bool available_;
+
+  void* handle_{nullptr};
+  KernelFunc function_{nullptr};
+};
+
 #if defined(PADDLE_WITH_CUDA) || defined(PADDLE_WITH_HIP)
 class CUDADeviceCode : public DeviceCode {
  public:
@@ -104,9 +135,14 @@ class DeviceCodePool {
     return *pool;
   }
 
+  // The places missing in the pool are added if it has been created.
   static DeviceCodePool& Init(const std::vector<platform::Place>& places) {
     if (pool == nullptr) {
       pool = new DeviceCodePool(places);
+    } else {
+      for (auto& p : places) {
+        pool->AddPlace(p);
+      }
     }
     return *pool;
   }
@@ -125,6 +161,8 @@ class DeviceCodePool {
   }
 
  private:
+  void AddPlace(const platform::Place& place);
+
   static DeviceCodePool* pool;
   std::map<Place, DeviceCodeMap> device_codes_;
   DISABLE_COPY_AND_ASSIGN(DeviceCodePool);
@@ -14,12 +14,19 @@ limitations under the License. */
 
 #include "paddle/fluid/platform/device_code.h"
 
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
 #include <utility>
 
+#include "gflags/gflags.h"
 #include "gtest/gtest.h"
 #include "paddle/fluid/framework/lod_tensor.h"
 #include "paddle/fluid/platform/init.h"
 
+DECLARE_string(fusion_group_cpu_cache_dir);
+
 #ifdef PADDLE_WITH_CUDA
 constexpr auto saxpy_code = R"(
 extern "C" __global__
@@ -125,3 +132,86 @@ TEST(DeviceCodePool, cuda) {
   LOG(INFO) << "get ptr: " << code_get;
 }
 #endif
+
+constexpr auto saxpy_cpu_code = R"(
+#include <stdint.h>
+
+extern "C"
+void saxpy_kernel(int64_t begin, int64_t end, void** args) {
+  const float* x = static_cast<const float*>(args[0]);
+  const float* y = static_cast<const float*>(args[1]);
+  float* z = static_cast<float*>(args[2]);
+  for (int64_t idx = begin; idx < end; ++idx) {
+    z[idx] = 2 * x[idx] + y[idx];
+  }
+}
+)";
+
+TEST(DeviceCode, cpu) {
+  paddle::platform::CPUPlace place;
+  paddle::platform::DeviceCodePool& pool =
+      paddle::platform::DeviceCodePool::Init({place});
+  if (!paddle::platform::CPUDeviceCode::IsAvailable()) {
+    return;
+  }
+
+  std::unique_ptr<paddle::platform::DeviceCode> code(
+      new paddle::platform::CPUDeviceCode(
+          place, "saxpy_kernel", saxpy_cpu_code));
+  EXPECT_EQ(code->Compile(), true);
+
+  paddle::framework::Tensor x;
+  paddle::framework::Tensor y;
+  paddle::framework::Tensor z;
+  auto dims =
+      phi::make_ddim({static_cast<int64_t>(256), static_cast<int64_t>(1025)});
+  float* x_data = x.mutable_data<float>(dims, place);
+  float* y_data = y.mutable_data<float>(dims, place);
+  float* z_data = z.mutable_data<float>(dims, place);
+
+  size_t n = x.numel();
+  for (size_t i = 0; i < n; ++i) {
+    x_data[i] = static_cast<float>(i);
+    y_data[i] = static_cast<float>(0.5);
+  }
+
+  std::vector<void*> args = {&n, &x_data, &y_data, &z_data};
+  code->Launch(n, &args);
+  for (size_t i = 0; i < n; i++) {
+    EXPECT_EQ(z_data[i], static_cast<float>(i) * 2 + 0.5);
+  }
+
+  // The shared object compiled above is loaded from the cache.
+  paddle::platform::CPUDeviceCode cached_code(
+      place, "saxpy_kernel", saxpy_cpu_code);
+  EXPECT_EQ(cached_code.Compile(), true);
+
+  size_t num_device_codes_before = pool.size(place);
+  pool.Set(std::move(code));
+  EXPECT_EQ(pool.size(place), num_device_codes_before + 1);
+  EXPECT_NE(pool.Get(place, "saxpy_kernel"), nullptr);
+}
+
+TEST(DeviceCode, cpu_cache_dir_writable_by_others) {
+  paddle::platform::CPUPlace place;
+  paddle::platform::DeviceCodePool::Init({place});
+  if (!paddle::platform::CPUDeviceCode::IsAvailable()) {
+    return;
+  }
+
+  char dir[] = "/tmp/device_code_test_XXXXXX";
+  ASSERT_NE(mkdtemp(dir), nullptr);
+  std::string cache_dir = FLAGS_fusion_group_cpu_cache_dir;
+  FLAGS_fusion_group_cpu_cache_dir = dir;
+
+  // The shared objects in a directory writable by the others may be planted.
+  ASSERT_EQ(chmod(dir, 0777), 0);
+  paddle::platform::CPUDeviceCode code(place, "saxpy_kernel", saxpy_cpu_code);
+  EXPECT_EQ(code.Compile(), false);
+
+  ASSERT_EQ(chmod(dir, 0700), 0);
+  EXPECT_EQ(code.Compile(), true);
+
+  FLAGS_fusion_group_cpu_cache_dir = cache_dir;
+  ASSERT_EQ(system((std::string("rm -rf ") + dir).c_str()), 0);
+}
@@ -421,10 +421,12 @@ PADDLE_DEFINE_EXPORTED_double(
  * Allocator related FLAG
  * Name: FLAGS_allocator_strategy
  * Since Version: 1.2
- * Value Range: string, {naive_best_fit, auto_growth, thread_local},
- * default=auto_growth
+ * Value Range: string, {naive_best_fit, auto_growth, thread_local,
+ * thread_cache}, default=auto_growth
  * Example:
- * Note: For selecting allocator policy of PaddlePaddle.
+ * Note: For selecting allocator policy of PaddlePaddle. thread_cache is
+ * auto_growth on devices, with per-thread cached CPU allocation for the
+ * heavily multi-threaded CPU training and inference.
  */
 static constexpr char kDefaultAllocatorStrategy[] = "auto_growth";
 PADDLE_DEFINE_EXPORTED_string(
@@ -440,7 +442,9 @@ PADDLE_DEFINE_EXPORTED_string(
     "size of models may be larger). auto_growth strategy would allocate "
     "GPU memory on demand, which allows users to start several Paddle jobs "
     "on the same GPU card but may lead to more memory fragmentation "
-    "(i.e., maximum batch size of models may be smaller).");
+    "(i.e., maximum batch size of models may be smaller). thread_cache "
+    "strategy is auto_growth on devices, and allocates CPU memory from "
+    "per-thread caches of size classes backed by NUMA-node-aware pages.");
 
 /**
  * Memory related FLAG
@@ -881,6 +885,12 @@ DEFINE_bool(enable_slotrecord_reset_shrink,
 DEFINE_bool(enable_ins_parser_file,
             false,
             "enable parser ins file , default false");
+DEFINE_int32(dataset_channel_shard_num,
+             0,
+             "shard num of the dataset input channel written by all reader "
+             "threads, 0 or 1 means a single lock channel, default 0. A "
+             "sharded channel keeps the order within a shard only, so ReadAll "
+             "returns the data shard by shard instead of in write order");
 
 /**
  * ProcessGroupNCCL related FLAG
@@ -931,3 +941,36 @@ PADDLE_DEFINE_EXPORTED_bool(
 PADDLE_DEFINE_EXPORTED_string(jit_engine_type,
                               "PE",
                               "Choose default funciton type in JitLayer.");
+
+/**
+ * Fusion group related FLAG
+ * Name: FLAGS_fusion_group_cpu_cache_dir
+ * Since Version: 2.4.0
+ * Value Range: string, default=""
+ * Example: FLAGS_fusion_group_cpu_cache_dir=/home/work/fusion_group
+ * Note: The directory of the shared objects compiled for the CPU code of
+ * fusion_group, which are named by the hash of their code and reused by the
+ * later processes of the same user. It is $TMPDIR/paddle_fusion_group_<uid>
+ * by default. The directory must be owned by the user and not writable by the
+ * others, or the code is not compiled.
+ */
+PADDLE_DEFINE_EXPORTED_string(
+    fusion_group_cpu_cache_dir,
+    "",
+    "The directory of the shared objects compiled for fusion_group on CPU.");
+
+/**
+ * Fusion group related FLAG
+ * Name: FLAGS_fusion_group_cpu_compiler
+ * Since Version: 2.4.0
+ * Value Range: string,
+ *   default=c++ -O3 -fno-math-errno -fno-trapping-math -fopenmp-simd
+ * Example: FLAGS_fusion_group_cpu_compiler="g++ -O3 -mavx2 -mfma"
+ * Note: The compiler command, with the options, of the CPU code of
+ * fusion_group. Do not add -ffast-math, whose crtfastmath enables FTZ/DAZ
+ * in the thread loading the shared object.
+ */
+PADDLE_DEFINE_EXPORTED_string(
+    fusion_group_cpu_compiler,
+    "c++ -O3 -fno-math-errno -fno-trapping-math -fopenmp-simd",
+    "The compiler command with the options for fusion_group on CPU.");
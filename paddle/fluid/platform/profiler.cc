@@ -23,8 +23,10 @@ limitations under the License. */
 #include "paddle/fluid/platform/device_tracer.h"
 #include "paddle/fluid/platform/enforce.h"
 #include "paddle/fluid/platform/profiler/common_event.h"
+#include "paddle/fluid/platform/profiler/flight_recorder.h"
 #include "paddle/fluid/platform/profiler/host_event_recorder.h"
 #include "paddle/fluid/platform/profiler/host_tracer.h"
+#include "paddle/fluid/platform/profiler/perf_event_tracer.h"
 #include "paddle/fluid/platform/profiler/profiler.h"
 #include "paddle/fluid/platform/profiler_helper.h"
 #ifdef PADDLE_WITH_CUDA
@@ -107,6 +109,9 @@ RecordEvent::RecordEvent(const char *name,
   role_ = role;
   type_ = type;
   start_ns_ = PosixInNsec();
+  if (UNLIKELY(PerfEventTracer::IsTracing())) {
+    StartPerfCounters();
+  }
 }
 
 RecordEvent::RecordEvent(const std::string &name,
@@ -139,6 +144,9 @@ RecordEvent::RecordEvent(const std::string &name,
   role_ = role;
   type_ = type;
   start_ns_ = PosixInNsec();
+  if (UNLIKELY(PerfEventTracer::IsTracing())) {
+    StartPerfCounters();
+  }
 }
 
 RecordEvent::RecordEvent(const std::string &name,
@@ -173,6 +181,9 @@ RecordEvent::RecordEvent(const std::string &name,
   name_ = new std::string(name);
   start_ns_ = PosixInNsec();
   attr_ = new std::string(attr);
+  if (UNLIKELY(PerfEventTracer::IsTracing())) {
+    StartPerfCounters();
+  }
 }
 
 void RecordEvent::OriginalConstruct(const std::string &name,
@@ -193,6 +204,31 @@ void RecordEvent::OriginalConstruct(const std::string &name,
   *name_ = e->name();
 }
 
+void RecordEvent::StartPerfCounters() {
+  if (type_ != TracerEventType::Operator) {
+    return;
+  }
+  PerfEventTracer::ReadCounters(&perf_start_);
+}
+
+void RecordEvent::EndPerfCounters(uint64_t end_ns) {
+  PerfCounterValues end_values;
+  PerfEventTracer::ReadCounters(&end_values);
+  PerfCounterValues counters;
+  counters.mask = perf_start_.mask & end_values.mask;
+  for (size_t i = 0; i < kNumPerfCounters; ++i) {
+    // The scaled values of a multiplexed group may go backwards a little
+    if (end_values.values[i] > perf_start_.values[i]) {
+      counters.values[i] = end_values.values[i] - perf_start_.values[i];
+    }
+  }
+  if (counters.mask != 0) {
+    HostEventRecorder<CommonPerfEvent>::GetInstance().RecordEvent(
+        start_ns_, end_ns, counters);
+  }
+  perf_start_.mask = 0;
+}
+
 void RecordEvent::End() {
 #ifndef _WIN32
 #ifdef PADDLE_WITH_CUDA
@@ -204,6 +240,9 @@ void RecordEvent::End() {
 #endif
   if (LIKELY(FLAGS_enable_host_event_recorder_hook && is_enabled_)) {
     uint64_t end_ns = PosixInNsec();
+    if (UNLIKELY(perf_start_.mask != 0)) {
+      EndPerfCounters(end_ns);
+    }
     if (LIKELY(shallow_copy_name_ != nullptr)) {
       HostEventRecorder<CommonEvent>::GetInstance().RecordEvent(
           shallow_copy_name_, start_ns_, end_ns, role_, type_);
@@ -1042,6 +1081,18 @@ void NvprofDisableRecordEvent() { g_enable_nvprof_hook = false; }
 void EnableHostEventRecorder() { FLAGS_enable_host_event_recorder_hook = true; }
 
 void DisableHostEventRecorder() {
+  // The FlightRecorder goes on recording after a profiling
+  FLAGS_enable_host_event_recorder_hook =
+      FlightRecorder::GetInstance().IsEnabled();
+}
+
+void EnableFlightRecorder(const FlightRecorderOptions &options) {
+  FlightRecorder::GetInstance().Enable(options);
+  FLAGS_enable_host_event_recorder_hook = true;
+}
+
+void DisableFlightRecorder() {
+  FlightRecorder::GetInstance().Disable();
   FLAGS_enable_host_event_recorder_hook = false;
 }
 
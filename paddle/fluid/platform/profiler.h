@@ -248,6 +248,12 @@ void NvprofDisableRecordEvent();
 void EnableHostEventRecorder();
 void DisableHostEventRecorder();
 
+struct FlightRecorderOptions;
+// Keep the host events of the last moments for the FlightRecorder, see
+// profiler/flight_recorder.h
+void EnableFlightRecorder(const FlightRecorderOptions& options);
+void DisableFlightRecorder();
+
 // Defined for UT
 std::string PrintHostEvents();
 
@@ -32,6 +32,29 @@ static const char* kSchemaVersion = "1.0.1";
 static const char* kDefaultFilename = "pid_%s_time_%s.paddle_trace.json";
 static uint32_t span_indx = 0;
 
+// The hardware counters of an operator as extra args, e.g.
+//   , "cycles": 1024, "instructions": 2048, "ipc": 2.000
+static std::string PerfCounterArgs(const PerfCounterValues& counters) {
+  std::string args;
+  for (size_t i = 0; i < kNumPerfCounters; ++i) {
+    auto type = static_cast<PerfCounterType>(i);
+    if (counters.Has(type)) {
+      args += string_format(std::string(",\n      \"%s\": %llu"),
+                            StringPerfCounterType(type),
+                            counters.Get(type));
+    }
+  }
+  if (counters.Has(PerfCounterType::Cycles) &&
+      counters.Has(PerfCounterType::Instructions) &&
+      counters.Get(PerfCounterType::Cycles) > 0) {
+    args += string_format(
+        std::string(",\n      \"ipc\": %.3f"),
+        static_cast<double>(counters.Get(PerfCounterType::Instructions)) /
+            counters.Get(PerfCounterType::Cycles));
+  }
+  return args;
+}
+
 static std::string DefaultFileName() {
   auto pid = GetProcessId();
   return string_format(
@@ -231,7 +254,7 @@ void ChromeTracingLogger::LogHostTraceEventNode(
       "end_time": "%.3f us",
       "input_shapes": %s,
       "input_dtypes": %s,
-      "callstack": "%s"
+      "callstack": "%s"%s
     }
   },
   )JSON"),
@@ -246,7 +269,8 @@ void ChromeTracingLogger::LogHostTraceEventNode(
           nsToUsFloat(host_node.EndNs(), start_time_),
           json_dict(input_shapes).c_str(),
           json_dict(input_dtypes).c_str(),
-          callstack.c_str());
+          callstack.c_str(),
+          PerfCounterArgs(host_node.PerfCounters()).c_str());
       break;
     case TracerEventType::CudaRuntime:
     case TracerEventType::Kernel:
@@ -106,6 +106,20 @@ struct CommonMemEvent {
   uint64_t peak_reserved;
 };
 
+// Hardware counters of an operator span, recorded by RecordEvent when
+// PerfEventTracer is tracing and matched to the CommonEvent of the same
+// thread, start_ns and end_ns.
+struct CommonPerfEvent {
+ public:
+  CommonPerfEvent(uint64_t start_ns,
+                  uint64_t end_ns,
+                  const PerfCounterValues &counters)
+      : start_ns(start_ns), end_ns(end_ns), counters(counters) {}
+  uint64_t start_ns;
+  uint64_t end_ns;
+  PerfCounterValues counters;
+};
+
 struct OperatorSupplementOriginEvent {
  public:
   OperatorSupplementOriginEvent(
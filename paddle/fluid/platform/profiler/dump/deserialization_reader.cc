@@ -194,6 +194,15 @@ HostTraceEventNode* DeserializationReader::RestoreHostTraceEventNode(
   host_event.end_ns = host_event_proto.end_ns();
   host_event.process_id = host_event_proto.process_id();
   host_event.thread_id = host_event_proto.thread_id();
+  if (host_event_proto.has_perf_counter_mask()) {
+    host_event.perf_counters.mask = host_event_proto.perf_counter_mask();
+    for (int i = 0; i < host_event_proto.perf_counter_values_size() &&
+                    i < static_cast<int>(kNumPerfCounters);
+         i++) {
+      host_event.perf_counters.values[i] =
+          host_event_proto.perf_counter_values(i);
+    }
+  }
   return new HostTraceEventNode(host_event);
 }
 
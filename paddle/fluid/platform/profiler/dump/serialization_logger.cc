@@ -148,6 +148,13 @@ void SerializationLogger::LogHostTraceEventNode(
   host_trace_event->set_end_ns(host_node.EndNs());
   host_trace_event->set_process_id(host_node.ProcessId());
   host_trace_event->set_thread_id(host_node.ThreadId());
+  const PerfCounterValues& perf_counters = host_node.PerfCounters();
+  if (perf_counters.mask != 0) {
+    host_trace_event->set_perf_counter_mask(perf_counters.mask);
+    for (size_t i = 0; i < kNumPerfCounters; ++i) {
+      host_trace_event->add_perf_counter_values(perf_counters.values[i]);
+    }
+  }
   current_host_trace_event_node_proto_->set_allocated_host_trace_event(
       host_trace_event);
   OperatorSupplementEventNode* op_supplement_event_node =
@@ -15,6 +15,7 @@ limitations under the License. */
 #include "paddle/fluid/platform/profiler/dump/deserialization_reader.h"
 #include "paddle/fluid/platform/profiler/dump/serialization_logger.h"
 #include "paddle/fluid/platform/profiler/extra_info.h"
+#include "paddle/fluid/platform/profiler/utils.h"
 
 namespace paddle {
 namespace platform {
@@ -50,6 +51,14 @@ HostPythonNode* ProfilerResult::CopyTree(HostTraceEventNode* root) {
   host_python_node->end_ns = root->EndNs();
   host_python_node->process_id = root->ProcessId();
   host_python_node->thread_id = root->ThreadId();
+  const PerfCounterValues& perf_counters = root->PerfCounters();
+  for (size_t i = 0; i < kNumPerfCounters; ++i) {
+    auto type = static_cast<PerfCounterType>(i);
+    if (perf_counters.Has(type)) {
+      host_python_node->perf_counters[StringPerfCounterType(type)] =
+          perf_counters.Get(type);
+    }
+  }
   for (auto it = root->GetChildren().begin(); it != root->GetChildren().end();
        ++it) {
     host_python_node->children_node_ptrs.push_back(CopyTree(*it));
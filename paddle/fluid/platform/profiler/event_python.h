@@ -92,6 +92,9 @@ struct HostPythonNode {
   std::map<std::string, std::vector<std::string>> dtypes;
   // call stack
   std::string callstack;
+  // hardware counters by name, only for operators traced with
+  // PerfEventTracer
+  std::map<std::string, uint64_t> perf_counters;
   // children node
   std::vector<HostPythonNode*> children_node_ptrs;
   // runtime node
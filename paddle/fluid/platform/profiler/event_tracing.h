@@ -95,6 +95,10 @@ class RecordEvent {
                          const EventRole role,
                          const std::string& attr);
 
+  // Read the hardware counters around operators for PerfEventTracer
+  void StartPerfCounters();
+  void EndPerfCounters(uint64_t end_ns);
+
   bool is_enabled_{false};
   bool is_pushed_{false};
   // Event name
@@ -107,6 +111,8 @@ class RecordEvent {
   EventRole role_{EventRole::kOrdinary};
   TracerEventType type_{TracerEventType::UserDefined};
   std::string* attr_{nullptr};
+  // the counters at the start, mask is 0 if not read
+  PerfCounterValues perf_start_;
   bool finished_{false};
 };
 
@@ -0,0 +1,313 @@
+// Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/platform/profiler/flight_recorder.h"
+
+#include <chrono>  // NOLINT
+#include <csignal>
+#include <memory>
+#include <unordered_map>
+
+#include "glog/logging.h"
+#include "paddle/fluid/platform/enforce.h"
+#include "paddle/fluid/platform/os_info.h"
+#include "paddle/fluid/platform/profiler/common_event.h"
+#include "paddle/fluid/platform/profiler/event_python.h"
+#include "paddle/fluid/platform/profiler/extra_info.h"
+#include "paddle/fluid/platform/profiler/host_event_recorder.h"
+#include "paddle/fluid/platform/profiler/host_tracer.h"
+#include "paddle/fluid/platform/profiler/utils.h"
+
+namespace paddle {
+namespace platform {
+
+namespace {
+
+constexpr auto kDumpPollInterval = std::chrono::milliseconds(100);
+
+// Set by the signal handler and polled by the dump thread, as a signal
+// handler can not notify a condition variable.
+std::atomic<bool> signal_dump_requested{false};
+
+#ifndef _WIN32
+void FlightRecorderSignalHandler(int) { signal_dump_requested.store(true); }
+#endif
+
+}  // namespace
+
+FlightRecorder& FlightRecorder::GetInstance() {
+  // Never destroyed, the dump thread may still run at exit
+  static FlightRecorder* instance = new FlightRecorder();
+  return *instance;
+}
+
+void FlightRecorder::Enable(const FlightRecorderOptions& options) {
+  PADDLE_ENFORCE_GT(options.events_per_thread,
+                    0UL,
+                    platform::errors::InvalidArgument(
+                        "The events_per_thread of FlightRecorder must be "
+                        "larger than 0."));
+  PADDLE_ENFORCE_EQ(
+      options.format == "json" || options.format == "pb",
+      true,
+      platform::errors::InvalidArgument(
+          "The format of FlightRecorder must be json or pb, but got %s.",
+          options.format));
+  StopDumpThread();
+
+  std::lock_guard<std::mutex> guard(mutex_);
+  options_ = options;
+  step_threshold_ns_.store(options.step_threshold_ms * 1000000);
+  last_step_end_ns_.store(0);
+  enabled_.store(true);
+  if (!paused_) {
+    StartRecording();
+  }
+#ifndef _WIN32
+  if (options.dump_on_signal) {
+    std::signal(SIGUSR2, FlightRecorderSignalHandler);
+  }
+#endif
+  {
+    std::lock_guard<std::mutex> dump_guard(dump_mutex_);
+    stop_dump_thread_ = false;
+    dump_reason_ = nullptr;
+  }
+  dump_thread_ = std::thread([this] { DumpLoop(); });
+  VLOG(1) << "FlightRecorder keeps the latest " << options.events_per_thread
+          << " events per thread";
+}
+
+void FlightRecorder::Disable() {
+  StopDumpThread();
+
+  std::lock_guard<std::mutex> guard(mutex_);
+  if (!enabled_.load()) {
+    return;
+  }
+#ifndef _WIN32
+  if (options_.dump_on_signal) {
+    std::signal(SIGUSR2, SIG_DFL);
+  }
+#endif
+  if (!paused_) {
+    StopRecording();
+  }
+  enabled_.store(false);
+  HostEventRecorder<CommonEvent>::GetInstance().ClearRings();
+  HostEventRecorder<CommonMemEvent>::GetInstance().ClearRings();
+  HostEventRecorder<OperatorSupplementOriginEvent>::GetInstance().ClearRings();
+}
+
+void FlightRecorder::StepEnd() {
+  if (!enabled_.load(std::memory_order_relaxed)) {
+    return;
+  }
+  uint64_t now = PosixInNsec();
+  uint64_t last = last_step_end_ns_.exchange(now);
+  uint64_t threshold = step_threshold_ns_.load(std::memory_order_relaxed);
+  if (threshold > 0 && last > 0 && now - last > threshold) {
+    RequestDump("slow step");
+  }
+}
+
+std::string FlightRecorder::Dump(const std::string& file_name) {
+  FlightRecorderOptions options;
+  std::string output = file_name;
+  {
+    std::lock_guard<std::mutex> guard(mutex_);
+    PADDLE_ENFORCE_EQ(enabled_.load(),
+                      true,
+                      platform::errors::PreconditionNotMet(
+                          "FlightRecorder must be enabled before Dump."));
+    options = options_;
+    if (output.empty()) {
+      output = string_format(std::string("%s/flight_recorder_%u_%llu.%s"),
+                             options.dump_dir.c_str(),
+                             GetProcessId(),
+                             dump_count_,
+                             options.format.c_str());
+    }
+    dump_count_++;
+    last_dump_ns_ = PosixInNsec();
+  }
+
+  TraceEventCollector collector;
+  CollectWindow(options.window_ms, &collector);
+  std::unique_ptr<NodeTrees> tree(
+      new NodeTrees(collector.HostEvents(),
+                    collector.RuntimeEvents(),
+                    collector.DeviceEvents(),
+                    collector.MemEvents(),
+                    collector.OperatorSupplementEvents()));
+  ExtraInfo extrainfo;
+  extrainfo.AddExtraInfo(std::string("Flight Recorder Window"),
+                         std::string("%llu ms"),
+                         options.window_ms);
+  for (const auto& kv : collector.ThreadNames()) {
+    extrainfo.AddExtraInfo(string_format(std::string("%llu"), kv.first),
+                           std::string("%s"),
+                           kv.second.c_str());
+  }
+  ProfilerResult result(std::move(tree), extrainfo);
+  result.Save(output, options.format);
+  return output;
+}
+
+void FlightRecorder::Pause() {
+  std::lock_guard<std::mutex> guard(mutex_);
+  if (enabled_.load() && !paused_) {
+    StopRecording();
+  }
+  paused_ = true;
+}
+
+void FlightRecorder::Resume() {
+  std::lock_guard<std::mutex> guard(mutex_);
+  if (enabled_.load() && paused_) {
+    StartRecording();
+  }
+  paused_ = false;
+}
+
+void FlightRecorder::StartRecording() {
+  HostEventRecorder<CommonEvent>::GetInstance().SetRingCapacity(
+      options_.events_per_thread);
+  HostEventRecorder<CommonMemEvent>::GetInstance().SetRingCapacity(
+      options_.events_per_thread);
+  HostEventRecorder<OperatorSupplementOriginEvent>::GetInstance()
+      .SetRingCapacity(options_.events_per_thread);
+  HostTraceLevel::GetInstance().SetLevel(options_.trace_level);
+}
+
+void FlightRecorder::StopRecording() {
+  HostTraceLevel::GetInstance().SetLevel(HostTraceLevel::kDisabled);
+  HostEventRecorder<CommonEvent>::GetInstance().SetRingCapacity(0);
+  HostEventRecorder<CommonMemEvent>::GetInstance().SetRingCapacity(0);
+  HostEventRecorder<OperatorSupplementOriginEvent>::GetInstance()
+      .SetRingCapacity(0);
+}
+
+void FlightRecorder::CollectWindow(uint64_t window_ms,
+                                   TraceEventCollector* collector) {
+  uint64_t now = PosixInNsec();
+  uint64_t window_ns = window_ms * 1000000;
+  uint64_t begin_ns = now > window_ns ? now - window_ns : 0;
+  uint64_t process_id = GetProcessId();
+  auto add_thread_name = [collector](uint64_t thread_id,
+                                     const std::string& thread_name) {
+    if (thread_name != kDefaultThreadName) {
+      collector->AddThreadName(thread_id, thread_name);
+    }
+  };
+
+  HostEventRecorder<CommonEvent>::GetInstance().VisitRingEvents(
+      [&](uint64_t thread_id,
+          const std::string& thread_name,
+          const CommonEvent& evt) {
+        if (evt.end_ns >= begin_ns) {
+          add_thread_name(thread_id, thread_name);
+          collector->AddHostEvent(
+              ConvertHostEvent(evt, process_id, thread_id));
+        }
+      });
+  HostEventRecorder<CommonMemEvent>::GetInstance().VisitRingEvents(
+      [&](uint64_t thread_id,
+          const std::string& thread_name,
+          const CommonMemEvent& evt) {
+        if (evt.timestamp_ns >= begin_ns) {
+          add_thread_name(thread_id, thread_name);
+          collector->AddMemEvent(
+              ConvertHostMemEvent(evt, process_id, thread_id));
+        }
+      });
+  HostEventRecorder<OperatorSupplementOriginEvent>::GetInstance()
+      .VisitRingEvents([&](uint64_t thread_id,
+                           const std::string& thread_name,
+                           const OperatorSupplementOriginEvent& evt) {
+        if (evt.timestamp_ns >= begin_ns) {
+          add_thread_name(thread_id, thread_name);
+          collector->AddOperatorSupplementEvent(
+              ConvertOperatorSupplementEvent(evt, process_id, thread_id));
+        }
+      });
+}
+
+void FlightRecorder::RequestDump(const char* reason) {
+  std::lock_guard<std::mutex> guard(dump_mutex_);
+  if (dump_reason_ == nullptr) {
+    dump_reason_ = reason;
+    dump_cv_.notify_one();
+  }
+}
+
+void FlightRecorder::DumpLoop() {
+  SetCurrentThreadName("FlightRecorder");
+  while (true) {
+    const char* reason = nullptr;
+    {
+      std::unique_lock<std::mutex> lock(dump_mutex_);
+      dump_cv_.wait_for(lock, kDumpPollInterval, [this] {
+        return stop_dump_thread_ || dump_reason_ != nullptr ||
+               signal_dump_requested.load();
+      });
+      if (stop_dump_thread_) {
+        return;
+      }
+      if (signal_dump_requested.exchange(false)) {
+        reason = "signal";
+      }
+      if (dump_reason_ != nullptr) {
+        reason = dump_reason_;
+        dump_reason_ = nullptr;
+      }
+    }
+    if (reason == nullptr) {
+      continue;
+    }
+
+    uint64_t window_ms = 0;
+    {
+      std::lock_guard<std::mutex> guard(mutex_);
+      window_ms = options_.window_ms;
+      // A run of slow steps is covered by the window of the first dump
+      if (reason != std::string("signal") && last_dump_ns_ > 0 &&
+          PosixInNsec() - last_dump_ns_ < window_ms * 1000000) {
+        continue;
+      }
+    }
+    try {
+      std::string file_name = Dump();
+      LOG(INFO) << "FlightRecorder dumps the last " << window_ms
+                << " ms into " << file_name << " on " << reason;
+    } catch (const std::exception& e) {
+      LOG(WARNING) << "FlightRecorder fails to dump on " << reason << ": "
+                   << e.what();
+    }
+  }
+}
+
+void FlightRecorder::StopDumpThread() {
+  {
+    std::lock_guard<std::mutex> guard(dump_mutex_);
+    stop_dump_thread_ = true;
+    dump_cv_.notify_one();
+  }
+  if (dump_thread_.joinable()) {
+    dump_thread_.join();
+  }
+}
+
+}  // namespace platform
+}  // namespace paddle
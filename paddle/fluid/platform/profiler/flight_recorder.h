@@ -0,0 +1,110 @@
+// Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>  // NOLINT
+#include <cstdint>
+#include <mutex>  // NOLINT
+#include <string>
+#include <thread>  // NOLINT
+
+#include "paddle/fluid/platform/macros.h"
+#include "paddle/fluid/platform/profiler/trace_event_collector.h"
+
+namespace paddle {
+namespace platform {
+
+struct FlightRecorderOptions {
+  // The latest host events kept for every thread
+  uint64_t events_per_thread = 1 << 16;
+  uint32_t trace_level = 1;
+  // A dump covers the events that end within the window before the trigger
+  uint64_t window_ms = 10000;
+  // Dump if the time between two StepEnd is longer than the threshold, 0
+  // disables the trigger
+  uint64_t step_threshold_ms = 0;
+  // Dump on SIGUSR2
+  bool dump_on_signal = false;
+  std::string dump_dir = ".";
+  // "json" for ChromeTracingLogger, "pb" for SerializationLogger
+  std::string format = "json";
+};
+
+// FlightRecorder keeps the host events of the last moments in a fixed size
+// ring per thread while no Profiler is running, and dumps them when a step
+// is too slow, on a signal or on Dump, so the tail latency spikes of a long
+// running job can be traced without starting a Profiler in advance.
+// A Profiler takes over the host events between its Start and Stop.
+class FlightRecorder {
+ public:
+  static FlightRecorder& GetInstance();
+
+  void Enable(const FlightRecorderOptions& options);
+
+  void Disable();
+
+  bool IsEnabled() const { return enabled_.load(); }
+
+  // Mark the end of a step, a step longer than step_threshold_ms dumps the
+  // window on the dump thread.
+  void StepEnd();
+
+  // Dump the window into file_name, or into a new file of dump_dir if it is
+  // empty, and return the file name. It does not stop the recording.
+  std::string Dump(const std::string& file_name = "");
+
+  // Called by the Profiler around a profiling
+  void Pause();
+
+  void Resume();
+
+ private:
+  FlightRecorder() = default;
+
+  DISABLE_COPY_AND_ASSIGN(FlightRecorder);
+
+  void StartRecording();
+
+  void StopRecording();
+
+  void CollectWindow(uint64_t window_ms, TraceEventCollector* collector);
+
+  void DumpLoop();
+
+  void RequestDump(const char* reason);
+
+  void StopDumpThread();
+
+  std::mutex mutex_;
+  FlightRecorderOptions options_;
+  std::atomic<bool> enabled_{false};
+  bool paused_ = false;
+
+  std::atomic<uint64_t> step_threshold_ns_{0};
+  std::atomic<uint64_t> last_step_end_ns_{0};
+  uint64_t last_dump_ns_ = 0;
+  uint64_t dump_count_ = 0;
+
+  // The dump thread waits for the requests of StepEnd and the signal
+  std::thread dump_thread_;
+  std::mutex dump_mutex_;
+  std::condition_variable dump_cv_;
+  bool stop_dump_thread_ = false;
+  const char* dump_reason_ = nullptr;
+};
+
+}  // namespace platform
+}  // namespace paddle
@@ -14,11 +14,17 @@
 
 #pragma once
 
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>  // NOLINT
 #include <string>
 #include <type_traits>
 #include <vector>
 
 #include "paddle/fluid/framework/new_executor/workqueue/thread_data_registry.h"
+#include "paddle/fluid/platform/enforce.h"
 #include "paddle/fluid/platform/macros.h"
 #include "paddle/fluid/platform/os_info.h"
 
@@ -67,6 +73,8 @@ class EventContainer {
   // Get all events and clear the container
   std::vector<EventType> Reduce();
 
+  bool Empty() const { return event_blocks_->offset == 0; }
+
   // Return a buffer to store the string attribute of Event.
   // HostEventRecorder locates in the static data section.
   // So it's safe to use arena to avoid fragmented allocations.
@@ -183,6 +191,102 @@ char *EventContainer<EventType>::GetStringStorage(size_t sz) {
   return storage;
 }
 
+// A fixed size ring of the latest events of a thread. The string attributes
+// of an event live in the strings of its slot, which keep their capacity
+// when the slot is reused, so a full ring records without allocating.
+template <typename EventType>
+class EventRing {
+ public:
+  explicit EventRing(size_t capacity) : slots_(capacity) {}
+  ~EventRing() { Clear(); }
+  DISABLE_COPY_AND_ASSIGN(EventRing);
+
+ public:
+  template <typename... Args>
+  void Record(Args &&...args) {
+    DoRecord(ContainsStdString<Args...>(), std::forward<Args>(args)...);
+  }
+
+  // Visit the events from the oldest to the latest. The string attributes
+  // are only valid during the call.
+  template <typename Fn>
+  void Visit(Fn &&fn) const {
+    size_t num = std::min(recorded_, slots_.size());
+    for (size_t i = recorded_ - num; i < recorded_; ++i) {
+      fn(slots_[i % slots_.size()].storage.event);
+    }
+  }
+
+  void Clear() {
+    for (auto &slot : slots_) {
+      if (slot.occupied) {
+        slot.storage.event.~EventType();
+        slot.occupied = false;
+      }
+    }
+    recorded_ = 0;
+  }
+
+  size_t Capacity() const { return slots_.size(); }
+
+ private:
+  static constexpr size_t kMaxStringsPerEvent = 4;
+
+  struct Slot {
+    union InitDeferedEvent {
+      InitDeferedEvent() {}
+      ~InitDeferedEvent() {}
+
+      EventType event;
+    };
+
+    bool occupied = false;
+    size_t num_strs = 0;
+    std::string strs[kMaxStringsPerEvent];
+    InitDeferedEvent storage;
+  };
+
+  Slot *NextSlot() {
+    Slot *slot = &slots_[recorded_ % slots_.size()];
+    ++recorded_;
+    if (slot->occupied) {
+      slot->storage.event.~EventType();
+      slot->occupied = false;
+    }
+    slot->num_strs = 0;
+    return slot;
+  }
+
+  template <typename... Args>
+  void DoRecord(std::true_type, Args &&...args) {
+    Slot *slot = NextSlot();
+    std::function<void *(size_t)> allocator = [slot](size_t size) {
+      PADDLE_ENFORCE_LT(slot->num_strs,
+                        kMaxStringsPerEvent,
+                        platform::errors::OutOfRange(
+                            "An event in EventRing can have at most %d string "
+                            "attributes.",
+                            kMaxStringsPerEvent));
+      std::string &str = slot->strs[slot->num_strs++];
+      str.resize(size);
+      return static_cast<void *>(&str[0]);
+    };
+    new (&slot->storage.event) EventType(allocator, std::forward<Args>(args)...);
+    slot->occupied = true;
+  }
+
+  template <typename... Args>
+  void DoRecord(std::false_type, Args &&...args) {
+    Slot *slot = NextSlot();
+    new (&slot->storage.event) EventType(std::forward<Args>(args)...);
+    slot->occupied = true;
+  }
+
+  std::vector<Slot> slots_;
+  // The number of events recorded since the last Clear
+  size_t recorded_ = 0;
+};
+
 template <typename EventType>
 struct ThreadEventSection {
   std::string thread_name;
@@ -215,10 +319,43 @@ class ThreadEventRecorder {
     return thr_sec;
   }
 
+  // Record into a ring of the latest ring_capacity events, the lock is only
+  // contended by VisitRingEvents of the flight recorder.
+  template <typename... Args>
+  void RecordRingEvent(size_t ring_capacity, Args &&...args) {
+    std::lock_guard<std::mutex> guard(ring_mutex_);
+    if (UNLIKELY(ring_ == nullptr || ring_->Capacity() != ring_capacity)) {
+      ring_.reset(new EventRing<EventType>(ring_capacity));
+    }
+    ring_->Record(std::forward<Args>(args)...);
+  }
+
+  template <typename Fn>
+  void VisitRingEvents(Fn &&fn) {
+    std::lock_guard<std::mutex> guard(ring_mutex_);
+    if (ring_ != nullptr) {
+      ring_->Visit(std::forward<Fn>(fn));
+    }
+  }
+
+  void ClearRing() {
+    std::lock_guard<std::mutex> guard(ring_mutex_);
+    ring_.reset();
+  }
+
+  // true if all the events of the thread are recorded into the ring
+  bool RecordedOnlyRing() const { return base_evt_cntr_.Empty(); }
+
+  uint64_t ThreadId() const { return thread_id_; }
+
+  const std::string &ThreadName() const { return thread_name_; }
+
  private:
   uint64_t thread_id_;
   std::string thread_name_;
   EventContainer<EventType> base_evt_cntr_;
+  std::mutex ring_mutex_;
+  std::unique_ptr<EventRing<EventType>> ring_;
 };
 
 template <typename EventType>
@@ -255,9 +392,47 @@ class HostEventRecorder {
           thread_event_recorder_ptr =
               std::make_shared<ThreadEventRecorder<EventType>>();
       *(GetThreadLocalRecorder()) = thread_event_recorder_ptr;
+      std::lock_guard<std::mutex> guard(thr_recorders_mutex_);
       thr_recorders_.push_back(thread_event_recorder_ptr);
     }
-    (*GetThreadLocalRecorder())->RecordEvent(std::forward<Args>(args)...);
+    size_t ring_capacity = ring_capacity_.load(std::memory_order_relaxed);
+    if (ring_capacity > 0) {
+      (*GetThreadLocalRecorder())
+          ->RecordRingEvent(ring_capacity, std::forward<Args>(args)...);
+    } else {
+      (*GetThreadLocalRecorder())->RecordEvent(std::forward<Args>(args)...);
+    }
+  }
+
+  // Keep only the latest events_per_thread events of every thread in a
+  // ring, which is read by VisitRingEvents while the threads are recording.
+  // 0 records all the events for GatherEvents again, the rings are kept
+  // until ClearRings. The recorder of an exited thread which recorded only
+  // into its ring is released by the next VisitRingEvents or ClearRings.
+  void SetRingCapacity(size_t events_per_thread) {
+    ring_capacity_.store(events_per_thread);
+  }
+
+  // thread-safe
+  void ClearRings() {
+    for (auto &v : GetThreadRecorders()) {
+      v->ClearRing();
+    }
+    ReleaseExitedRecorders();
+  }
+
+  // thread-safe
+  // fn(thread_id, thread_name, event) is called for the events in the rings.
+  // The string attributes of the event are only valid during the call.
+  void VisitRingEvents(
+      const std::function<void(uint64_t, const std::string &, const EventType &)>
+          &fn) {
+    for (auto &v : GetThreadRecorders()) {
+      v->VisitRingEvents([&](const EventType &event) {
+        fn(v->ThreadId(), v->ThreadName(), event);
+      });
+    }
+    ReleaseExitedRecorders();
   }
 
   // thread-unsafe, make sure make sure there is no running tracing.
@@ -265,8 +440,9 @@ class HostEventRecorder {
   HostEventSection<EventType> GatherEvents() {
     HostEventSection<EventType> host_sec;
     host_sec.process_id = GetProcessId();
-    host_sec.thr_sections.reserve(thr_recorders_.size());
-    for (auto &v : thr_recorders_) {
+    auto thr_recorders = GetThreadRecorders();
+    host_sec.thr_sections.reserve(thr_recorders.size());
+    for (auto &v : thr_recorders) {
       host_sec.thr_sections.emplace_back(std::move(v->GatherEvents()));
     }
     return host_sec;
@@ -283,11 +459,35 @@ class HostEventRecorder {
     return ThreadEventRecorderRegistry::GetInstance()
         .GetMutableCurrentThreadData();
   }
+
+  std::vector<std::shared_ptr<ThreadEventRecorder<EventType>>>
+  GetThreadRecorders() {
+    std::lock_guard<std::mutex> guard(thr_recorders_mutex_);
+    return thr_recorders_;
+  }
+
+  // Drop the recorders only held by thr_recorders_, whose threads have
+  // exited, if there is nothing left for GatherEvents in them.
+  void ReleaseExitedRecorders() {
+    std::lock_guard<std::mutex> guard(thr_recorders_mutex_);
+    thr_recorders_.erase(
+        std::remove_if(
+            thr_recorders_.begin(),
+            thr_recorders_.end(),
+            [](const std::shared_ptr<ThreadEventRecorder<EventType>> &v) {
+              return v.use_count() == 1 && v->RecordedOnlyRing();
+            }),
+        thr_recorders_.end());
+  }
+
   // Hold all thread-local ThreadEventRecorders
   // ThreadEventRecorderRegistry and HostEventRecorder both take care of this
   // shared pointer. We add this to prevent ThreadEventRecorder being destroyed
   // by thread-local variable in ThreadEventRecorderRegistry and lose data.
   std::vector<std::shared_ptr<ThreadEventRecorder<EventType>>> thr_recorders_;
+  std::mutex thr_recorders_mutex_;
+  // The events per thread of the rings, 0 if the rings are not used
+  std::atomic<size_t> ring_capacity_{0};
 };
 
 }  // namespace platform
@@ -13,7 +13,10 @@
 // limitations under the License.
 #include "paddle/fluid/platform/profiler/host_tracer.h"
 
+#include <map>
 #include <sstream>
+#include <unordered_map>
+#include <utility>
 
 #include "glog/logging.h"
 #include "paddle/fluid/platform/flags.h"
@@ -30,23 +33,114 @@ PADDLE_DEFINE_EXPORTED_int64(host_trace_level,
 namespace paddle {
 namespace platform {
 
+HostTraceEvent ConvertHostEvent(const CommonEvent& evt,
+                                uint64_t process_id,
+                                uint64_t thread_id) {
+  HostTraceEvent event;
+  event.name = evt.name;
+  event.type = evt.type;
+  event.start_ns = evt.start_ns;
+  event.end_ns = evt.end_ns;
+  event.process_id = process_id;
+  event.thread_id = thread_id;
+  return event;
+}
+
+MemTraceEvent ConvertHostMemEvent(const CommonMemEvent& evt,
+                                  uint64_t process_id,
+                                  uint64_t thread_id) {
+  MemTraceEvent event;
+  event.timestamp_ns = evt.timestamp_ns;
+  event.addr = evt.addr;
+  event.type = evt.type;
+  event.increase_bytes = evt.increase_bytes;
+  event.place = evt.place.DebugString();
+  event.current_allocated = evt.current_allocated;
+  event.current_reserved = evt.current_reserved;
+  event.peak_allocated = evt.peak_allocated;
+  event.peak_reserved = evt.peak_reserved;
+  event.process_id = process_id;
+  event.thread_id = thread_id;
+  return event;
+}
+
+OperatorSupplementEvent ConvertOperatorSupplementEvent(
+    const OperatorSupplementOriginEvent& evt,
+    uint64_t process_id,
+    uint64_t thread_id) {
+  OperatorSupplementEvent event;
+  event.timestamp_ns = evt.timestamp_ns;
+  event.op_type = evt.op_type;
+  std::map<std::string, std::vector<std::vector<int64_t>>> input_shapes;
+  std::map<std::string, std::vector<std::string>> dtypes;
+  std::string callstack;
+  for (auto it = evt.input_shapes.begin(); it != evt.input_shapes.end();
+       it++) {
+    for (auto idx = 0lu; idx < it->second.size(); idx++) {
+      input_shapes[it->first].push_back(std::vector<int64_t>());
+      for (auto dim_idx = 0; dim_idx < it->second.at(idx).size(); dim_idx++) {
+        input_shapes[it->first][idx].push_back(it->second.at(idx).at(dim_idx));
+      }
+    }
+  }
+  for (auto it = evt.dtypes.begin(); it != evt.dtypes.end(); it++) {
+    for (auto idx = 0lu; idx < it->second.size(); idx++) {
+      dtypes[it->first].push_back(
+          framework::proto::VarType::Type_Name(it->second.at(idx)));
+    }
+  }
+
+  std::ostringstream result_string;
+  for (auto it = evt.callstack.begin(); it != evt.callstack.end(); it++) {
+    result_string << (*it) << std::endl;
+  }
+  event.input_shapes = input_shapes;
+  event.dtypes = dtypes;
+  event.callstack = result_string.str();
+  event.process_id = process_id;
+  event.thread_id = thread_id;
+  return event;
+}
+
 namespace {
 
+// The counters of every thread, keyed by the start_ns and end_ns of the
+// operator span which is unique in a thread.
+using PerfCounterMap = std::unordered_map<
+    uint64_t,
+    std::map<std::pair<uint64_t, uint64_t>, PerfCounterValues>>;
+
+PerfCounterMap GroupPerfEvents(
+    const HostEventSection<CommonPerfEvent>& perf_events) {
+  PerfCounterMap perf_counters;
+  for (const auto& thr_sec : perf_events.thr_sections) {
+    auto& thr_counters = perf_counters[thr_sec.thread_id];
+    for (const auto& evt : thr_sec.events) {
+      thr_counters[std::make_pair(evt.start_ns, evt.end_ns)] = evt.counters;
+    }
+  }
+  return perf_counters;
+}
+
 void ProcessHostEvents(const HostEventSection<CommonEvent>& host_events,
+                       const PerfCounterMap& perf_counters,
                        TraceEventCollector* collector) {
   for (const auto& thr_sec : host_events.thr_sections) {
     uint64_t tid = thr_sec.thread_id;
     if (thr_sec.thread_name != kDefaultThreadName) {
       collector->AddThreadName(tid, thr_sec.thread_name);
     }
+    auto thr_counters = perf_counters.find(tid);
     for (const auto& evt : thr_sec.events) {
-      HostTraceEvent event;
-      event.name = evt.name;
-      event.type = evt.type;
-      event.start_ns = evt.start_ns;
-      event.end_ns = evt.end_ns;
-      event.process_id = host_events.process_id;
-      event.thread_id = tid;
+      HostTraceEvent event = ConvertHostEvent(evt, host_events.process_id, tid);
+      if (thr_counters != perf_counters.end() &&
+          evt.type == TracerEventType::Operator) {
+        auto iter =
+            thr_counters->second.find(std::make_pair(evt.start_ns, evt.end_ns));
+        if (iter != thr_counters->second.end()) {
+          event.perf_counters = iter->second;
+        }
+      }
       collector->AddHostEvent(std::move(event));
     }
   }
@@ -61,19 +155,8 @@ void ProcessHostMemEvents(
       collector->AddThreadName(tid, thr_sec.thread_name);
     }
     for (const auto& evt : thr_sec.events) {
-      MemTraceEvent event;
-      event.timestamp_ns = evt.timestamp_ns;
-      event.addr = evt.addr;
-      event.type = evt.type;
-      event.increase_bytes = evt.increase_bytes;
-      event.place = evt.place.DebugString();
-      event.current_allocated = evt.current_allocated;
-      event.current_reserved = evt.current_reserved;
-      event.peak_allocated = evt.peak_allocated;
-      event.peak_reserved = evt.peak_reserved;
-      event.process_id = host_mem_events.process_id;
-      event.thread_id = tid;
-      collector->AddMemEvent(std::move(event));
+      collector->AddMemEvent(
+          ConvertHostMemEvent(evt, host_mem_events.process_id, tid));
     }
   }
 }
@@ -87,40 +170,8 @@ void ProcessOperatorSupplementEvents(
       collector->AddThreadName(tid, thr_sec.thread_name);
     }
     for (const auto& evt : thr_sec.events) {
-      OperatorSupplementEvent event;
-      event.timestamp_ns = evt.timestamp_ns;
-      event.op_type = evt.op_type;
-      std::map<std::string, std::vector<std::vector<int64_t>>> input_shapes;
-      std::map<std::string, std::vector<std::string>> dtypes;
-      std::string callstack;
-      for (auto it = evt.input_shapes.begin(); it != evt.input_shapes.end();
-           it++) {
-        for (auto idx = 0lu; idx < it->second.size(); idx++) {
-          input_shapes[it->first].push_back(std::vector<int64_t>());
-          for (auto dim_idx = 0; dim_idx < it->second.at(idx).size();
-               dim_idx++) {
-            input_shapes[it->first][idx].push_back(
-                it->second.at(idx).at(dim_idx));
-          }
-        }
-      }
-      for (auto it = evt.dtypes.begin(); it != evt.dtypes.end(); it++) {
-        for (auto idx = 0lu; idx < it->second.size(); idx++) {
-          dtypes[it->first].push_back(
-              framework::proto::VarType::Type_Name(it->second.at(idx)));
-        }
-      }
-
-      std::ostringstream result_string;
-      for (auto it = evt.callstack.begin(); it != evt.callstack.end(); it++) {
-        result_string << (*it) << std::endl;
-      }
-      event.input_shapes = input_shapes;
-      event.dtypes = dtypes;
-      event.callstack = result_string.str();
-      event.process_id = op_supplement_events.process_id;
-      event.thread_id = tid;
-      collector->AddOperatorSupplementEvent(std::move(event));
+      collector->AddOperatorSupplementEvent(ConvertOperatorSupplementEvent(
+          evt, op_supplement_events.process_id, tid));
     }
   }
 }
@@ -142,6 +193,7 @@ void HostTracer::StartTracing() {
   HostEventRecorder<CommonMemEvent>::GetInstance().GatherEvents();
   HostEventRecorder<OperatorSupplementOriginEvent>::GetInstance()
       .GatherEvents();
+  HostEventRecorder<CommonPerfEvent>::GetInstance().GatherEvents();
   HostTraceLevel::GetInstance().SetLevel(options_.trace_level);
   state_ = TracerState::STARTED;
 }
@@ -160,9 +212,11 @@ void HostTracer::CollectTraceData(TraceEventCollector* collector) {
       state_,
       TracerState::STOPED,
       platform::errors::PreconditionNotMet("TracerState must be STOPED"));
+  HostEventSection<CommonPerfEvent> perf_events =
+      HostEventRecorder<CommonPerfEvent>::GetInstance().GatherEvents();
   HostEventSection<CommonEvent> host_events =
       HostEventRecorder<CommonEvent>::GetInstance().GatherEvents();
-  ProcessHostEvents(host_events, collector);
+  ProcessHostEvents(host_events, GroupPerfEvents(perf_events), collector);
   HostEventSection<CommonMemEvent> host_mem_events =
       HostEventRecorder<CommonMemEvent>::GetInstance().GatherEvents();
   ProcessHostMemEvents(host_mem_events, collector);
@@ -39,6 +39,25 @@ class HostTraceLevel {
   int trace_level_ = kDisabled;
 };
 
+struct CommonEvent;
+struct CommonMemEvent;
+struct OperatorSupplementOriginEvent;
+
+// Convert the events of HostEventRecorder into the events of a
+// TraceEventCollector.
+HostTraceEvent ConvertHostEvent(const CommonEvent& evt,
+                                uint64_t process_id,
+                                uint64_t thread_id);
+
+MemTraceEvent ConvertHostMemEvent(const CommonMemEvent& evt,
+                                  uint64_t process_id,
+                                  uint64_t thread_id);
+
+OperatorSupplementEvent ConvertOperatorSupplementEvent(
+    const OperatorSupplementOriginEvent& evt,
+    uint64_t process_id,
+    uint64_t thread_id);
+
 struct HostTracerOptions {
   uint32_t trace_level = 0;
 };
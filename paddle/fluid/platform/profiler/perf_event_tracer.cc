@@ -0,0 +1,237 @@
+// Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/platform/profiler/perf_event_tracer.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include "glog/logging.h"
+#include "paddle/fluid/platform/enforce.h"
+
+namespace paddle {
+namespace platform {
+
+namespace {
+
+#ifdef __linux__
+uint64_t PerfCacheConfig(uint64_t cache) {
+  return cache | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+         (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+}
+
+// Open a counter of the calling thread on any cpu, user space only so that
+// it works under the default perf_event_paranoid.
+int OpenCounter(PerfCounterType type, int group_fd, bool disabled) {
+  struct perf_event_attr attr;
+  memset(&attr, 0, sizeof(attr));
+  attr.size = sizeof(attr);
+  switch (type) {
+    case PerfCounterType::Cycles:
+      attr.type = PERF_TYPE_HARDWARE;
+      attr.config = PERF_COUNT_HW_CPU_CYCLES;
+      break;
+    case PerfCounterType::Instructions:
+      attr.type = PERF_TYPE_HARDWARE;
+      attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+      break;
+    case PerfCounterType::LLCMisses:
+      attr.type = PERF_TYPE_HW_CACHE;
+      attr.config = PerfCacheConfig(PERF_COUNT_HW_CACHE_LL);
+      break;
+    case PerfCounterType::DTLBMisses:
+      attr.type = PERF_TYPE_HW_CACHE;
+      attr.config = PerfCacheConfig(PERF_COUNT_HW_CACHE_DTLB);
+      break;
+    default:
+      return -1;
+  }
+  attr.disabled = group_fd < 0 && disabled;
+  attr.exclude_kernel = 1;
+  attr.exclude_hv = 1;
+  attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED |
+                     PERF_FORMAT_TOTAL_TIME_RUNNING;
+  return static_cast<int>(syscall(__NR_perf_event_open,
+                                  &attr,
+                                  /*pid=*/0,
+                                  /*cpu=*/-1,
+                                  group_fd,
+                                  /*flags=*/0));
+}
+#endif
+
+}  // namespace
+
+std::atomic<bool> PerfEventTracer::tracing_{false};
+
+// The counters of a thread in one group, so they are read by one syscall
+// and scheduled on the PMU together.
+struct PerfEventTracer::ThreadCounters {
+  int group_fd = -1;
+  std::vector<int> fds;
+  std::vector<PerfCounterType> types;
+
+  ~ThreadCounters() {
+#ifdef __linux__
+    if (group_fd >= 0) {
+      PerfEventTracer::GetInstance().Unregister(group_fd);
+    }
+    for (auto it = fds.rbegin(); it != fds.rend(); ++it) {
+      close(*it);
+    }
+#endif
+  }
+};
+
+PerfEventTracer& PerfEventTracer::GetInstance() {
+  // Never destroyed, the counters of the threads unregister at thread exit
+  static PerfEventTracer* instance = new PerfEventTracer();
+  return *instance;
+}
+
+PerfEventTracer::ThreadCounters* PerfEventTracer::GetThreadCounters() {
+  static thread_local std::unique_ptr<ThreadCounters> counters;
+  if (counters != nullptr) {
+    return counters.get();
+  }
+  counters.reset(new ThreadCounters());
+#ifdef __linux__
+  // Hold the lock so that the group is not missed by Start/StopTracing
+  std::lock_guard<std::mutex> guard(groups_mutex_);
+  for (size_t i = 0; i < kNumPerfCounters; ++i) {
+    auto type = static_cast<PerfCounterType>(i);
+    int fd = OpenCounter(type, counters->group_fd, !IsTracing());
+    if (fd < 0) {
+      VLOG(3) << "perf counter " << i << " is unavailable: " << strerror(errno);
+      continue;
+    }
+    if (counters->group_fd < 0) {
+      counters->group_fd = fd;
+    }
+    counters->fds.push_back(fd);
+    counters->types.push_back(type);
+  }
+  if (counters->group_fd >= 0) {
+    group_fds_.insert(counters->group_fd);
+  }
+#endif
+  return counters.get();
+}
+
+void PerfEventTracer::Unregister(int group_fd) {
+  std::lock_guard<std::mutex> guard(groups_mutex_);
+  group_fds_.erase(group_fd);
+}
+
+void PerfEventTracer::ReadCounters(PerfCounterValues* values) {
+  values->mask = 0;
+#ifdef __linux__
+  ThreadCounters* counters = GetInstance().GetThreadCounters();
+  if (counters->group_fd < 0) {
+    return;
+  }
+  // nr, time_enabled, time_running, then the values in the opened order
+  uint64_t buf[3 + kNumPerfCounters];
+  ssize_t size = read(counters->group_fd, buf, sizeof(buf));
+  if (size < static_cast<ssize_t>(3 * sizeof(uint64_t)) || buf[2] == 0) {
+    return;
+  }
+  // Scale the values if the group was multiplexed with other events
+  double scale = buf[2] < buf[1] ? static_cast<double>(buf[1]) / buf[2] : 1.0;
+  size_t num = std::min<size_t>(buf[0], counters->types.size());
+  for (size_t i = 0; i < num; ++i) {
+    size_t index = static_cast<size_t>(counters->types[i]);
+    values->values[index] = static_cast<uint64_t>(buf[3 + i] * scale);
+    values->mask |= 1u << index;
+  }
+#endif
+}
+
+bool PerfEventTracer::IsSupported() {
+  std::call_once(probe_once_, [this] {
+#ifdef __linux__
+    int fd = OpenCounter(PerfCounterType::Cycles, -1, true);
+    if (fd >= 0) {
+      close(fd);
+      supported_ = true;
+      return;
+    }
+    LOG(WARNING) << "perf_event_open is unavailable (" << strerror(errno)
+                 << "), the hardware counters of operators are not "
+                    "collected. Check /proc/sys/kernel/perf_event_paranoid "
+                    "or whether the machine exposes a PMU.";
+#else
+    LOG(WARNING) << "The hardware counters of operators are only collected "
+                    "on Linux.";
+#endif
+  });
+  return supported_;
+}
+
+void PerfEventTracer::PrepareTracing() {
+  PADDLE_ENFORCE_EQ(
+      state_ == TracerState::UNINITED || state_ == TracerState::STOPED,
+      true,
+      platform::errors::PreconditionNotMet("PerfEventTracer must be "
+                                           "UNINITED or STOPED"));
+  IsSupported();
+  state_ = TracerState::READY;
+}
+
+void PerfEventTracer::StartTracing() {
+  PADDLE_ENFORCE_EQ(
+      state_ == TracerState::READY,
+      true,
+      platform::errors::PreconditionNotMet("Tracer must be READY"));
+  if (supported_) {
+    std::lock_guard<std::mutex> guard(groups_mutex_);
+#ifdef __linux__
+    for (int fd : group_fds_) {
+      ioctl(fd, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    }
+#endif
+    tracing_.store(true);
+  }
+  state_ = TracerState::STARTED;
+}
+
+void PerfEventTracer::StopTracing() {
+  PADDLE_ENFORCE_EQ(
+      state_,
+      TracerState::STARTED,
+      platform::errors::PreconditionNotMet("Tracer must be STARTED"));
+  if (supported_) {
+    std::lock_guard<std::mutex> guard(groups_mutex_);
+    tracing_.store(false);
+#ifdef __linux__
+    for (int fd : group_fds_) {
+      ioctl(fd, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+    }
+#endif
+  }
+  state_ = TracerState::STOPED;
+}
+
+}  // namespace platform
+}  // namespace paddle
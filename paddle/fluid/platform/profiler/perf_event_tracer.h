@@ -0,0 +1,77 @@
+// Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <atomic>
+#include <mutex>
+#include <unordered_set>
+
+#include "paddle/fluid/platform/macros.h"
+#include "paddle/fluid/platform/profiler/trace_event.h"
+#include "paddle/fluid/platform/profiler/tracer_base.h"
+
+namespace paddle {
+namespace platform {
+
+// Based on Linux perf_event_open. Counts cycles, instructions, LLC misses and
+// dTLB misses of the threads running operators, RecordEvent reads them around
+// every operator span and HostTracer attaches the deltas to the host events.
+// Counters which can not be opened (e.g. perf_event_paranoid, no PMU in a VM
+// or not Linux) are left out, and the tracer does nothing if none can.
+class PerfEventTracer : public TracerBase {
+ public:
+  // Singleton. The counters of a thread are shared by all the profilers.
+  static PerfEventTracer& GetInstance();
+
+  // Whether RecordEvent should read the counters around operators.
+  static bool IsTracing() { return tracing_.load(std::memory_order_relaxed); }
+
+  // Read the running counters of the calling thread, they are opened at the
+  // first call of a thread. values->mask is 0 if no counter is available.
+  static void ReadCounters(PerfCounterValues* values);
+
+  // Whether at least one counter can be opened.
+  bool IsSupported();
+
+  void PrepareTracing() override;
+
+  void StartTracing() override;
+
+  void StopTracing() override;
+
+  // The counters are attached to the host events by HostTracer.
+  void CollectTraceData(TraceEventCollector* collector) override {}
+
+ private:
+  struct ThreadCounters;
+
+  PerfEventTracer() = default;
+
+  DISABLE_COPY_AND_ASSIGN(PerfEventTracer);
+
+  ThreadCounters* GetThreadCounters();
+
+  void Unregister(int group_fd);
+
+  static std::atomic<bool> tracing_;
+  std::once_flag probe_once_;
+  bool supported_ = false;
+  // The group leaders of the opened threads, to enable and disable them
+  std::mutex groups_mutex_;
+  std::unordered_set<int> group_fds_;
+};
+
+}  // namespace platform
+}  // namespace paddle
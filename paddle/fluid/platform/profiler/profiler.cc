@@ -27,8 +27,10 @@
 #include "paddle/fluid/platform/enforce.h"
 #include "paddle/fluid/platform/profiler/cuda_tracer.h"
 #include "paddle/fluid/platform/profiler/extra_info.h"
+#include "paddle/fluid/platform/profiler/flight_recorder.h"
 #include "paddle/fluid/platform/profiler/host_tracer.h"
 #include "paddle/fluid/platform/profiler/mlu/mlu_tracer.h"
+#include "paddle/fluid/platform/profiler/perf_event_tracer.h"
 #include "paddle/fluid/platform/profiler/trace_event_collector.h"
 #include "paddle/fluid/platform/profiler/utils.h"
 
@@ -62,6 +64,10 @@ bool Profiler::IsCnpapiSupported() {
   return supported;
 }
 
+bool Profiler::IsPerfEventSupported() {
+  return PerfEventTracer::GetInstance().IsSupported();
+}
+
 Profiler::Profiler(const ProfilerOptions& options) {
   options_ = options;
   std::bitset<32> trace_switch(options_.trace_switch);
@@ -76,6 +82,9 @@ Profiler::Profiler(const ProfilerOptions& options) {
   if (trace_switch.test(kProfileMLUOptionBit)) {
     tracers_.emplace_back(&MluTracer::GetInstance(), false);
   }
+  if (trace_switch.test(kProfilePerfEventOptionBit)) {
+    tracers_.emplace_back(&PerfEventTracer::GetInstance(), false);
+  }
 }
 
 Profiler::~Profiler() { alive_.store(false); }
@@ -88,6 +97,8 @@ void Profiler::Prepare() {
 
 void Profiler::Start() {
   SynchronizeAllDevice();
+  // The host tracer records all the events until Stop
+  FlightRecorder::GetInstance().Pause();
   for (auto& tracer : tracers_) {
     tracer.Get().StartTracing();
   }
@@ -107,6 +118,7 @@ std::unique_ptr<ProfilerResult> Profiler::Stop() {
                     collector.DeviceEvents(),
                     collector.MemEvents(),
                     collector.OperatorSupplementEvents()));
+  FlightRecorder::GetInstance().Resume();
   cpu_utilization_.RecordEndTimeInfo();
   ExtraInfo extrainfo;
   extrainfo.AddExtraInfo(std::string("System Cpu Utilization"),
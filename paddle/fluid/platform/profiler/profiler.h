@@ -35,9 +35,11 @@ namespace platform {
 static constexpr uint32_t kProfileCPUOptionBit = 0;
 static constexpr uint32_t kProfileGPUOptionBit = 1;
 static constexpr uint32_t kProfileMLUOptionBit = 2;
+static constexpr uint32_t kProfilePerfEventOptionBit = 3;
 
 struct ProfilerOptions {
-  uint32_t trace_switch = 0;  // bit 0: cpu, bit 1: gpu, bit 2: mlu
+  // bit 0: cpu, bit 1: gpu, bit 2: mlu, bit 3: hardware counters of cpu
+  uint32_t trace_switch = 0;
   uint32_t trace_level = FLAGS_host_trace_level;
 };
 
@@ -49,6 +51,8 @@ class Profiler {
 
   static bool IsCnpapiSupported();
 
+  static bool IsPerfEventSupported();
+
   void Prepare();
 
   void Start();
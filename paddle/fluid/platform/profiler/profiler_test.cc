@@ -14,6 +14,7 @@
 
 #include <set>
 #include <string>
+#include <thread>
 
 #include "glog/logging.h"
 #include "gtest/gtest.h"
@@ -27,6 +28,7 @@
 #include "paddle/fluid/platform/profiler.h"
 #include "paddle/fluid/platform/profiler/event_python.h"
 #include "paddle/fluid/platform/profiler/event_tracing.h"
+#include "paddle/fluid/platform/profiler/flight_recorder.h"
 #include "paddle/fluid/platform/profiler/profiler.h"
 
 TEST(ProfilerTest, TestHostTracer) {
@@ -141,3 +143,142 @@ TEST(ProfilerTest, TestHostTracerForMem) {
   auto profiler_result = profiler->Stop();
   auto nodetree = profiler_result->GetNodeTrees();
 }
+
+TEST(ProfilerTest, TestFlightRecorder) {
+  using paddle::platform::FlightRecorder;
+  using paddle::platform::FlightRecorderOptions;
+  using paddle::platform::LoadProfilerResult;
+  using paddle::platform::Profiler;
+  using paddle::platform::ProfilerOptions;
+  using paddle::platform::RecordEvent;
+  using paddle::platform::TracerEventType;
+  auto dump_host_events = [](const std::string& file_name) {
+    FlightRecorder::GetInstance().Dump(file_name);
+    auto nodetree = LoadProfilerResult(file_name)->GetNodeTrees();
+    std::set<std::string> host_events;
+    for (const auto pair : nodetree->Traverse(true)) {
+      for (const auto evt : pair.second) {
+        host_events.insert(evt->Name());
+      }
+    }
+    return host_events;
+  };
+
+  FlightRecorderOptions options;
+  options.events_per_thread = 4;
+  options.format = "pb";
+  paddle::platform::EnableFlightRecorder(options);
+  for (int i = 0; i < 10; i++) {
+    RecordEvent event("TestFlightRecorder_record" + std::to_string(i),
+                      TracerEventType::UserDefined,
+                      1);
+  }
+  // Only the latest 4 events are kept
+  std::set<std::string> host_events =
+      dump_host_events("test_flight_recorder_1.pb");
+  EXPECT_EQ(host_events.count("TestFlightRecorder_record5"), 0u);
+  for (int i = 6; i < 10; i++) {
+    EXPECT_EQ(
+        host_events.count("TestFlightRecorder_record" + std::to_string(i)),
+        1u);
+  }
+
+  // A Profiler records all the events between Start and Stop
+  ProfilerOptions profiler_options;
+  profiler_options.trace_level = 1;
+  profiler_options.trace_switch = 1;
+  auto profiler = Profiler::Create(profiler_options);
+  EXPECT_TRUE(profiler);
+  profiler->Prepare();
+  profiler->Start();
+  for (int i = 0; i < 10; i++) {
+    RecordEvent event("TestFlightRecorder_profile" + std::to_string(i),
+                      TracerEventType::UserDefined,
+                      1);
+  }
+  auto profiler_result = profiler->Stop();
+  std::set<std::string> profiled_events;
+  for (const auto pair : profiler_result->GetNodeTrees()->Traverse(true)) {
+    for (const auto evt : pair.second) {
+      profiled_events.insert(evt->Name());
+    }
+  }
+  EXPECT_EQ(profiled_events.count("TestFlightRecorder_profile0"), 1u);
+  EXPECT_EQ(profiled_events.count("TestFlightRecorder_profile9"), 1u);
+
+  // and the FlightRecorder goes on after Stop
+  {
+    RecordEvent event(
+        "TestFlightRecorder_resumed", TracerEventType::UserDefined, 1);
+  }
+  host_events = dump_host_events("test_flight_recorder_2.pb");
+  EXPECT_EQ(host_events.count("TestFlightRecorder_resumed"), 1u);
+  EXPECT_EQ(host_events.count("TestFlightRecorder_profile0"), 0u);
+
+  // the ring of an exited thread is released after it is dumped
+  std::thread thread([] {
+    RecordEvent event(
+        "TestFlightRecorder_exited", TracerEventType::UserDefined, 1);
+  });
+  thread.join();
+  host_events = dump_host_events("test_flight_recorder_3.pb");
+  EXPECT_EQ(host_events.count("TestFlightRecorder_exited"), 1u);
+  host_events = dump_host_events("test_flight_recorder_4.pb");
+  EXPECT_EQ(host_events.count("TestFlightRecorder_exited"), 0u);
+  paddle::platform::DisableFlightRecorder();
+}
+
+TEST(ProfilerTest, TestPerfEventTracer) {
+  using paddle::platform::DisableHostEventRecorder;
+  using paddle::platform::EnableHostEventRecorder;
+  using paddle::platform::kProfilePerfEventOptionBit;
+  using paddle::platform::PerfCounterType;
+  using paddle::platform::PerfCounterValues;
+  using paddle::platform::Profiler;
+  using paddle::platform::ProfilerOptions;
+  using paddle::platform::RecordEvent;
+  using paddle::platform::TracerEventType;
+  ProfilerOptions options;
+  options.trace_level = 1;
+  options.trace_switch = 1 | (1 << kProfilePerfEventOptionBit);
+  auto profiler = Profiler::Create(options);
+  EXPECT_TRUE(profiler);
+  EnableHostEventRecorder();
+  profiler->Prepare();
+  profiler->Start();
+  volatile double sum = 0;
+  {
+    RecordEvent event(
+        "TestPerfEventTracer_op", TracerEventType::Operator, 1);
+    for (int i = 0; i < 100000; i++) {
+      sum += i * 0.5;
+    }
+  }
+  {
+    RecordEvent event(
+        "TestPerfEventTracer_user", TracerEventType::UserDefined, 1);
+  }
+  DisableHostEventRecorder();
+  auto profiler_result = profiler->Stop();
+  // The events are kept without the counters if perf_event is unavailable
+  bool supported = Profiler::IsPerfEventSupported();
+  int num_events = 0;
+  for (const auto pair : profiler_result->GetNodeTrees()->Traverse(true)) {
+    for (const auto evt : pair.second) {
+      const PerfCounterValues& counters = evt->PerfCounters();
+      if (evt->Name() == "TestPerfEventTracer_op") {
+        ++num_events;
+        if (!supported) {
+          EXPECT_EQ(counters.mask, 0u);
+        }
+        if (counters.Has(PerfCounterType::Instructions)) {
+          EXPECT_GT(counters.Get(PerfCounterType::Instructions), 100000u);
+        }
+      } else if (evt->Name() == "TestPerfEventTracer_user") {
+        ++num_events;
+        EXPECT_EQ(counters.mask, 0u);
+      }
+    }
+  }
+  EXPECT_EQ(num_events, 2);
+}
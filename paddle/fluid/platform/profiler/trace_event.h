@@ -71,6 +71,36 @@ enum class TracerMemEventType {
   NumTypes
 };
 
+enum class PerfCounterType {
+  // Used to mark cpu cycles of the thread
+  Cycles = 0,
+  // Used to mark retired instructions of the thread
+  Instructions = 1,
+  // Used to mark last level cache read misses
+  LLCMisses = 2,
+  // Used to mark data TLB read misses
+  DTLBMisses = 3,
+  // A flag to denote the number of current types
+  NumTypes
+};
+
+static constexpr size_t kNumPerfCounters =
+    static_cast<size_t>(PerfCounterType::NumTypes);
+
+// Hardware counter deltas of an event, only the counters whose bit is set
+// in mask are valid.
+struct PerfCounterValues {
+  uint32_t mask = 0;
+  uint64_t values[kNumPerfCounters] = {0};
+
+  bool Has(PerfCounterType type) const {
+    return mask & (1u << static_cast<uint32_t>(type));
+  }
+  uint64_t Get(PerfCounterType type) const {
+    return values[static_cast<size_t>(type)];
+  }
+};
+
 struct KernelEventInfo {
   // The X-dimension block size for the kernel.
   uint32_t block_x;
@@ -196,6 +226,9 @@ struct HostTraceEvent {
   uint64_t process_id;
   // thread id of the record
   uint64_t thread_id;
+  // hardware counters of the record, only for operators traced with
+  // PerfEventTracer
+  PerfCounterValues perf_counters;
 };
 
 struct RuntimeTraceEvent {
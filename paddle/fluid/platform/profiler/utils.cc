@@ -170,5 +170,11 @@ const char* StringTracerEventType(TracerEventType type) {
   return categary_name_[static_cast<int>(type)];
 }
 
+const char* StringPerfCounterType(PerfCounterType type) {
+  static const char* counter_name_[] = {
+      "cycles", "instructions", "llc_misses", "dtlb_misses"};
+  return counter_name_[static_cast<int>(type)];
+}
+
 }  // namespace platform
 }  // namespace paddle
@@ -117,6 +117,8 @@ const char* StringTracerMemEventType(TracerMemEventType type);
 
 const char* StringTracerEventType(TracerEventType type);
 
+const char* StringPerfCounterType(PerfCounterType type);
+
 static float nsToUsFloat(uint64_t end_ns, uint64_t start_ns = 0) {
   return static_cast<float>(end_ns - start_ns) / 1000;
 }
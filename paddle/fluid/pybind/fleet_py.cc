@@ -76,6 +76,9 @@ void BindDistFleetWrapper(py::module* m) {
       .def("get_cache_threshold", &FleetWrapper::GetCacheThreshold)
       .def("cache_shuffle", &FleetWrapper::CacheShuffle)
       .def("save_cache", &FleetWrapper::SaveCache)
+      .def("prefetch_sparse",
+           &FleetWrapper::PrefetchSparse,
+           py::call_guard<py::gil_scoped_release>())
       .def("init_fl_worker", &FleetWrapper::InitFlWorker)
       .def("push_fl_client_info_sync", &FleetWrapper::PushFLClientInfoSync)
       .def("pull_fl_strategy", &FleetWrapper::PullFlStrategy)
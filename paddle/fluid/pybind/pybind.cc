@@ -84,6 +84,7 @@ limitations under the License. */
 #include "paddle/fluid/platform/profiler.h"
 #include "paddle/fluid/platform/profiler/event_python.h"
 #include "paddle/fluid/platform/profiler/event_tracing.h"
+#include "paddle/fluid/platform/profiler/flight_recorder.h"
 #include "paddle/fluid/platform/profiler/profiler.h"
 #include "paddle/fluid/pybind/cuda_streams_py.h"
 #include "paddle/fluid/pybind/distributed_py.h"
@@ -2064,6 +2065,8 @@ All parameter, weight, gradient are variables in Paddle.
                      &paddle::platform::HostPythonNode::input_shapes)
       .def_readwrite("dtypes", &paddle::platform::HostPythonNode::dtypes)
       .def_readwrite("callstack", &paddle::platform::HostPythonNode::callstack)
+      .def_readwrite("perf_counters",
+                     &paddle::platform::HostPythonNode::perf_counters)
       .def_readwrite("children_node",
                      &paddle::platform::HostPythonNode::children_node_ptrs)
       .def_readwrite("runtime_node",
@@ -2080,6 +2083,8 @@ All parameter, weight, gradient are variables in Paddle.
       .def("is_cupti_supported", &paddle::platform::Profiler::IsCuptiSupported)
       .def("is_cnpapi_supported",
            &paddle::platform::Profiler::IsCnpapiSupported)
+      .def("is_perf_event_supported",
+           &paddle::platform::Profiler::IsPerfEventSupported)
       .def("prepare",
            [](paddle::platform::Profiler *profiler) {
              platform::EnableHostEventRecorder();
@@ -2102,6 +2107,35 @@ All parameter, weight, gradient are variables in Paddle.
       .def_readwrite("trace_switch",
                      &paddle::platform::ProfilerOptions::trace_switch);
 
+  py::class_<paddle::platform::FlightRecorderOptions>(m,
+                                                      "FlightRecorderOptions")
+      .def(py::init<>())
+      .def_readwrite("events_per_thread",
+                     &paddle::platform::FlightRecorderOptions::events_per_thread)
+      .def_readwrite("trace_level",
+                     &paddle::platform::FlightRecorderOptions::trace_level)
+      .def_readwrite("window_ms",
+                     &paddle::platform::FlightRecorderOptions::window_ms)
+      .def_readwrite("step_threshold_ms",
+                     &paddle::platform::FlightRecorderOptions::step_threshold_ms)
+      .def_readwrite("dump_on_signal",
+                     &paddle::platform::FlightRecorderOptions::dump_on_signal)
+      .def_readwrite("dump_dir",
+                     &paddle::platform::FlightRecorderOptions::dump_dir)
+      .def_readwrite("format",
+                     &paddle::platform::FlightRecorderOptions::format);
+
+  m.def("_enable_flight_recorder", platform::EnableFlightRecorder);
+  m.def("_disable_flight_recorder", platform::DisableFlightRecorder);
+  m.def("_flight_recorder_step_end",
+        [] { platform::FlightRecorder::GetInstance().StepEnd(); });
+  m.def(
+      "_dump_flight_recorder",
+      [](const std::string &file_name) {
+        return platform::FlightRecorder::GetInstance().Dump(file_name);
+      },
+      py::arg("file_name") = "");
+
   py::class_<platform::RecordEvent>(m, "_RecordEvent")
       .def(py::init([](std::string name, platform::TracerEventType type) {
         return std::make_unique<platform::RecordEvent>(
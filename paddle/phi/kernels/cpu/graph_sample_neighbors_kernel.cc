@@ -14,6 +14,9 @@
 
 #include "paddle/phi/kernels/graph_sample_neighbors_kernel.h"
 
+#include <algorithm>
+#include <random>
+#include <unordered_set>
 #include <vector>
 
 #include "paddle/phi/backends/cpu/cpu_context.h"
@@ -21,45 +24,22 @@
 
 namespace phi {
 
-template <class bidiiter>
-void SampleUniqueNeighbors(
-    bidiiter begin,
-    bidiiter end,
-    int num_samples,
-    std::mt19937& rng,
-    std::uniform_int_distribution<int>& dice_distribution) {
-  int left_num = std::distance(begin, end);
-  for (int i = 0; i < num_samples; i++) {
-    bidiiter r = begin;
-    int random_step = dice_distribution(rng) % left_num;
-    std::advance(r, random_step);
-    std::swap(*begin, *r);
-    ++begin;
-    --left_num;
-  }
-}
-
-template <class bidiiter>
-void SampleUniqueNeighborsWithEids(
-    bidiiter src_begin,
-    bidiiter src_end,
-    bidiiter eid_begin,
-    bidiiter eid_end,
-    int num_samples,
-    std::mt19937& rng,
-    std::uniform_int_distribution<int>& dice_distribution) {
-  int left_num = std::distance(src_begin, src_end);
-  for (int i = 0; i < num_samples; i++) {
-    bidiiter r1 = src_begin, r2 = eid_begin;
-    int random_step = dice_distribution(rng) % left_num;
-    std::advance(r1, random_step);
-    std::advance(r2, random_step);
-    std::swap(*src_begin, *r1);
-    std::swap(*eid_begin, *r2);
-    ++src_begin;
-    ++eid_begin;
-    --left_num;
+// Draw k distinct indexes of [0, n) into out by Floyd's algorithm, which
+// costs k random numbers and never touches the n candidates. The result is
+// shuffled so the order is random as well.
+inline void SampleUniqueIndexes(int n, int k, std::mt19937* rng, int* out) {
+  const int kLinearCheckLimit = 64;
+  std::unordered_set<int> chosen;
+  for (int i = 0, j = n - k; j < n; ++i, ++j) {
+    int r = std::uniform_int_distribution<int>(0, j)(*rng);
+    bool exist = k <= kLinearCheckLimit ? std::find(out, out + i, r) != out + i
+                                        : !chosen.insert(r).second;
+    if (exist && k > kLinearCheckLimit) {
+      chosen.insert(j);
+    }
+    out[i] = exist ? j : r;
   }
+  std::shuffle(out, out + k, *rng);
 }
 
 template <typename T>
@@ -73,90 +53,58 @@ void SampleNeighbors(const T* row,
                      int sample_size,
                      int bs,
                      bool return_eids) {
-  std::vector<std::vector<T>> out_src_vec;
-  std::vector<std::vector<T>> out_eids_vec;
   // `sample_cumsum_sizes` record the start position and end position
-  // after sampling.
-  std::vector<int> sample_cumsum_sizes(bs + 1);
-  // `total_neighbors` the size of output after sample.
-  int total_neighbors = 0;
-  sample_cumsum_sizes[0] = total_neighbors;
+  // after sampling, a negative sample_size keeps all the neighbors.
+  std::vector<int64_t> sample_cumsum_sizes(bs + 1);
+  sample_cumsum_sizes[0] = 0;
+  output_count->resize(bs);
   for (int i = 0; i < bs; i++) {
     T node = input[i];
     int cap = col_ptr[node + 1] - col_ptr[node];
-    int k = cap > sample_size ? sample_size : cap;
-    total_neighbors += k;
-    sample_cumsum_sizes[i + 1] = total_neighbors;
-    std::vector<T> out_src;
-    out_src.resize(cap);
-    out_src_vec.emplace_back(out_src);
-    if (return_eids) {
-      std::vector<T> out_eids;
-      out_eids.resize(cap);
-      out_eids_vec.emplace_back(out_eids);
-    }
+    int k = (sample_size >= 0 && cap > sample_size) ? sample_size : cap;
+    (*output_count)[i] = k;
+    sample_cumsum_sizes[i + 1] = sample_cumsum_sizes[i] + k;
   }
-
-  output_count->resize(bs);
-  output->resize(total_neighbors);
+  output->resize(sample_cumsum_sizes[bs]);
   if (return_eids) {
-    output_eids->resize(total_neighbors);
+    output_eids->resize(sample_cumsum_sizes[bs]);
   }
 
+  // Every block of nodes owns a random engine, so the sampling is free of
+  // data race and only the sampled neighbors are read and written.
+  const int kBlockSize = 256;
+  int block_num = (bs + kBlockSize - 1) / kBlockSize;
   std::random_device rd;
-  std::mt19937 rng{rd()};
-  std::uniform_int_distribution<int> dice_distribution(
-      0, std::numeric_limits<int>::max());
-
+  uint32_t seed = rd();
 #ifdef PADDLE_WITH_MKLML
 #pragma omp parallel for
 #endif
-  // Sample the neighbors in parallelism.
-  for (int i = 0; i < bs; i++) {
-    T node = input[i];
-    T begin = col_ptr[node], end = col_ptr[node + 1];
-    int cap = end - begin;
-    if (sample_size < cap) {
-      std::copy(row + begin, row + end, out_src_vec[i].begin());
-      if (return_eids) {
-        std::copy(eids + begin, eids + end, out_eids_vec[i].begin());
-        SampleUniqueNeighborsWithEids(out_src_vec[i].begin(),
-                                      out_src_vec[i].end(),
-                                      out_eids_vec[i].begin(),
-                                      out_eids_vec[i].end(),
-                                      sample_size,
-                                      rng,
-                                      dice_distribution);
-      } else {
-        SampleUniqueNeighbors(out_src_vec[i].begin(),
-                              out_src_vec[i].end(),
-                              sample_size,
-                              rng,
-                              dice_distribution);
+  for (int block = 0; block < block_num; block++) {
+    std::mt19937 rng(seed + block);
+    std::vector<int> sample_idx;
+    for (int i = block * kBlockSize; i < std::min(bs, (block + 1) * kBlockSize);
+         i++) {
+      T begin = col_ptr[input[i]];
+      int cap = col_ptr[input[i] + 1] - begin;
+      int k = (*output_count)[i];
+      T* out = output->data() + sample_cumsum_sizes[i];
+      T* out_eids = return_eids ? output_eids->data() + sample_cumsum_sizes[i]
+                                : nullptr;
+      if (k == cap) {
+        std::copy(row + begin, row + begin + cap, out);
+        if (return_eids) {
+          std::copy(eids + begin, eids + begin + cap, out_eids);
+        }
+        continue;
       }
-      *(output_count->data() + i) = sample_size;
-    } else {
-      std::copy(row + begin, row + end, out_src_vec[i].begin());
-      if (return_eids) {
-        std::copy(eids + begin, eids + end, out_eids_vec[i].begin());
+      sample_idx.resize(k);
+      SampleUniqueIndexes(cap, k, &rng, sample_idx.data());
+      for (int j = 0; j < k; j++) {
+        out[j] = row[begin + sample_idx[j]];
+        if (return_eids) {
+          out_eids[j] = eids[begin + sample_idx[j]];
+        }
       }
-      *(output_count->data() + i) = cap;
-    }
-  }
-
-#ifdef PADDLE_WITH_MKLML
-#pragma omp parallel for
-#endif
-  // Copy the results parallelism
-  for (int i = 0; i < bs; i++) {
-    int k = sample_cumsum_sizes[i + 1] - sample_cumsum_sizes[i];
-    std::copy(out_src_vec[i].begin(),
-              out_src_vec[i].begin() + k,
-              output->data() + sample_cumsum_sizes[i]);
-    if (return_eids) {
-      std::copy(out_eids_vec[i].begin(),
-                out_eids_vec[i].begin() + k,
-                output_eids->data() + sample_cumsum_sizes[i]);
     }
   }
 }
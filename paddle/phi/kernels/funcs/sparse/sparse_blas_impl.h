@@ -0,0 +1,511 @@
+// Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <algorithm>
+#include <vector>
+
+#ifdef PADDLE_WITH_MKLML
+#include <omp.h>
+#endif
+
+#include "paddle/phi/backends/cpu/cpu_context.h"
+#include "paddle/phi/core/ddim.h"
+#include "paddle/phi/core/dense_tensor.h"
+#include "paddle/phi/core/enforce.h"
+#include "paddle/phi/core/sparse_coo_tensor.h"
+#include "paddle/phi/core/sparse_csr_tensor.h"
+#include "paddle/phi/core/visit_type.h"
+
+namespace phi {
+namespace funcs {
+namespace sparse {
+
+/************* CSR VIEW OF SPARSE MATRIX (COO/CSR) ************/
+
+// The rows of a batched sparse matrix in CSR order. The rows of all the
+// batches are numbered one after another, so that the rows can be split
+// between threads regardless of the batches.
+template <typename T, typename IntT>
+struct CpuCsrView {
+  int64_t batch_size = 1;
+  int64_t rows = 0;
+  int64_t cols = 0;
+  // the first entry of every row, batch_size * rows + 1 in total
+  std::vector<int64_t> offsets;
+  const IntT* col_data = nullptr;
+  const T* value_data = nullptr;
+  // the index of every entry in the tensor, empty when they are the same
+  std::vector<int64_t> perm;
+
+  std::vector<IntT> col_buffer;
+  std::vector<T> value_buffer;
+
+  int64_t TotalRows() const { return batch_size * rows; }
+  int64_t Index(int64_t i) const { return perm.empty() ? i : perm[i]; }
+};
+
+inline void GetMatrixDims(const DDim& dims,
+                          int64_t* batch_size,
+                          int64_t* rows,
+                          int64_t* cols) {
+  std::vector<int64_t> dim_vec = phi::vectorize(dims);
+  size_t ndims = dim_vec.size();
+  PADDLE_ENFORCE_GE(
+      ndims,
+      2,
+      phi::errors::InvalidArgument("the dim size of the matrix must be "
+                                   "greater than or eaqual to 2."));
+  *batch_size = 1;
+  for (size_t i = 0; i < ndims - 2; ++i) {
+    *batch_size *= dim_vec[i];
+  }
+  *rows = dim_vec[ndims - 2];
+  *cols = dim_vec[ndims - 1];
+}
+
+inline DataType GetIndexType(const phi::SparseCsrTensor& x) {
+  return x.non_zero_crows().dtype();
+}
+
+inline DataType GetIndexType(const phi::SparseCooTensor& x) {
+  return x.non_zero_indices().dtype();
+}
+
+template <typename T, typename IntT>
+void MakeCpuCsrView(const phi::SparseCsrTensor& x,
+                    CpuCsrView<T, IntT>* view) {
+  GetMatrixDims(x.dims(), &view->batch_size, &view->rows, &view->cols);
+  PADDLE_ENFORCE_EQ(x.non_zero_crows().numel(),
+                    view->batch_size * (view->rows + 1),
+                    phi::errors::PreconditionNotMet(
+                        "the length of SparseCsrTensor crows is not right."));
+  // the crows of every batch start from 0
+  const IntT* crows_data = x.non_zero_crows().data<IntT>();
+  view->offsets.resize(view->TotalRows() + 1);
+  int64_t batch_offset = 0;
+  for (int64_t b = 0; b < view->batch_size; ++b) {
+    const IntT* batch_crows = crows_data + b * (view->rows + 1);
+    for (int64_t i = 0; i < view->rows; ++i) {
+      view->offsets[b * view->rows + i] = batch_offset + batch_crows[i];
+    }
+    batch_offset += batch_crows[view->rows];
+  }
+  view->offsets[view->TotalRows()] = batch_offset;
+  PADDLE_ENFORCE_EQ(batch_offset,
+                    x.nnz(),
+                    phi::errors::PreconditionNotMet(
+                        "the crows of SparseCsrTensor do not match its nnz."));
+  view->col_data = x.non_zero_cols().data<IntT>();
+  view->value_data = x.non_zero_elements().data<T>();
+}
+
+// The entries of a COO tensor are sorted into rows by a counting sort,
+// which is skipped when they are in order, e.g. coalesced.
+template <typename T, typename IntT>
+void MakeCpuCsrView(const phi::SparseCooTensor& x,
+                    CpuCsrView<T, IntT>* view) {
+  GetMatrixDims(x.dims(), &view->batch_size, &view->rows, &view->cols);
+  int64_t ndims = x.dims().size();
+  PADDLE_ENFORCE_EQ(
+      x.sparse_dim(),
+      ndims,
+      phi::errors::InvalidArgument("the sparse dim of SparseCooTensor must be "
+                                   "eaqual to its dim size in matmul."));
+  int64_t nnz = x.nnz();
+  const IntT* indices_data = x.non_zero_indices().data<IntT>();
+  const IntT* cols_data = indices_data + (ndims - 1) * nnz;
+
+  std::vector<int64_t> row_ids(nnz);
+  bool in_order = true;
+  for (int64_t i = 0; i < nnz; ++i) {
+    int64_t batch = 0;
+    for (int64_t d = 0; d < ndims - 2; ++d) {
+      batch = batch * x.dims()[d] + indices_data[d * nnz + i];
+    }
+    row_ids[i] = batch * view->rows + indices_data[(ndims - 2) * nnz + i];
+    in_order = in_order && (i == 0 || row_ids[i - 1] <= row_ids[i]);
+  }
+
+  view->offsets.assign(view->TotalRows() + 1, 0);
+  for (int64_t i = 0; i < nnz; ++i) {
+    ++view->offsets[row_ids[i] + 1];
+  }
+  for (int64_t r = 0; r < view->TotalRows(); ++r) {
+    view->offsets[r + 1] += view->offsets[r];
+  }
+  if (in_order) {
+    view->col_data = cols_data;
+    view->value_data = x.non_zero_elements().data<T>();
+    return;
+  }
+
+  std::vector<int64_t> next(view->offsets.begin(), view->offsets.end() - 1);
+  view->perm.resize(nnz);
+  for (int64_t i = 0; i < nnz; ++i) {
+    view->perm[next[row_ids[i]]++] = i;
+  }
+  const T* values_data = x.non_zero_elements().data<T>();
+  view->col_buffer.resize(nnz);
+  view->value_buffer.resize(nnz);
+  for (int64_t i = 0; i < nnz; ++i) {
+    view->col_buffer[i] = cols_data[view->perm[i]];
+    view->value_buffer[i] = values_data[view->perm[i]];
+  }
+  view->col_data = view->col_buffer.data();
+  view->value_data = view->value_buffer.data();
+}
+
+// The view of the transposed matrix, the product with the transposed matrix
+// becomes a product by rows without write conflicts between threads.
+template <typename T, typename IntT>
+void TransposeCpuCsrView(const CpuCsrView<T, IntT>& x,
+                         CpuCsrView<T, IntT>* out) {
+  out->batch_size = x.batch_size;
+  out->rows = x.cols;
+  out->cols = x.rows;
+  int64_t nnz = x.offsets.back();
+
+  out->offsets.assign(out->TotalRows() + 1, 0);
+  std::vector<int64_t> out_rows(nnz);
+  for (int64_t r = 0; r < x.TotalRows(); ++r) {
+    int64_t batch = r / x.rows;
+    for (int64_t i = x.offsets[r]; i < x.offsets[r + 1]; ++i) {
+      out_rows[i] = batch * out->rows + x.col_data[i];
+      ++out->offsets[out_rows[i] + 1];
+    }
+  }
+  for (int64_t r = 0; r < out->TotalRows(); ++r) {
+    out->offsets[r + 1] += out->offsets[r];
+  }
+
+  std::vector<int64_t> next(out->offsets.begin(), out->offsets.end() - 1);
+  out->perm.resize(nnz);
+  out->col_buffer.resize(nnz);
+  out->value_buffer.resize(nnz);
+  for (int64_t r = 0; r < x.TotalRows(); ++r) {
+    for (int64_t i = x.offsets[r]; i < x.offsets[r + 1]; ++i) {
+      int64_t pos = next[out_rows[i]]++;
+      out->perm[pos] = x.Index(i);
+      out->col_buffer[pos] = static_cast<IntT>(r % x.rows);
+      out->value_buffer[pos] = x.value_data[i];
+    }
+  }
+  out->col_data = out->col_buffer.data();
+  out->value_data = out->value_buffer.data();
+}
+
+/************* ROW PARTITION BALANCED BY NNZ ************/
+
+inline int GetSparseBlasThreadNum(int64_t work, int64_t min_work = 32768) {
+#ifdef PADDLE_WITH_MKLML
+  int64_t num = std::min<int64_t>(omp_get_max_threads(), work / min_work);
+  return static_cast<int>(std::max<int64_t>(num, 1));
+#else
+  return 1;
+#endif
+}
+
+// Split the rows into thread_num ranges of about the same cost, where the
+// cost of a row is its nnz plus one, so that a few long rows of a power law
+// matrix do not leave the other threads idle, and empty rows still count.
+inline std::vector<int64_t> PartitionRowsByNnz(
+    const std::vector<int64_t>& offsets, int thread_num) {
+  int64_t row_num = offsets.size() - 1;
+  int64_t total = offsets[row_num] + row_num;
+  std::vector<int64_t> bounds(thread_num + 1, row_num);
+  bounds[0] = 0;
+  for (int t = 1; t < thread_num; ++t) {
+    int64_t target = total * t / thread_num;
+    // the first row whose cost prefix reaches target
+    int64_t lo = bounds[t - 1], hi = row_num;
+    while (lo < hi) {
+      int64_t mid = lo + (hi - lo) / 2;
+      if (offsets[mid] + mid < target) {
+        lo = mid + 1;
+      } else {
+        hi = mid;
+      }
+    }
+    bounds[t] = lo;
+  }
+  return bounds;
+}
+
+template <typename Func>
+void ParallelForRows(const std::vector<int64_t>& offsets,
+                     int64_t row_width,
+                     Func func) {
+  int64_t row_num = offsets.size() - 1;
+  int thread_num = GetSparseBlasThreadNum(
+      (offsets[row_num] + row_num) * std::max<int64_t>(row_width, 1));
+  std::vector<int64_t> bounds = PartitionRowsByNnz(offsets, thread_num);
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for num_threads(thread_num) schedule(static, 1)
+#endif
+  for (int t = 0; t < thread_num; ++t) {
+    for (int64_t r = bounds[t]; r < bounds[t + 1]; ++r) {
+      func(r);
+    }
+  }
+}
+
+// Copy the transpose of every [rows, cols] matrix of the batch.
+template <typename T>
+void TransposeBatchMatrix(const T* in,
+                          int64_t batch_size,
+                          int64_t rows,
+                          int64_t cols,
+                          T* out) {
+  int64_t matrix_size = rows * cols;
+  int thread_num = GetSparseBlasThreadNum(batch_size * matrix_size);
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for num_threads(thread_num)
+#endif
+  for (int64_t r = 0; r < batch_size * rows; ++r) {
+    const T* in_batch = in + r / rows * matrix_size;
+    T* out_batch = out + r / rows * matrix_size;
+    int64_t i = r % rows;
+    for (int64_t j = 0; j < cols; ++j) {
+      out_batch[j * rows + i] = in_batch[i * cols + j];
+    }
+  }
+}
+
+template <typename T, typename IntT>
+void CpuSpmm(bool transb,
+             T alpha,
+             const CpuCsrView<T, IntT>& a,
+             const phi::DenseTensor& mat_b,
+             T beta,
+             phi::DenseTensor* mat_out) {
+  int64_t b_batch, b_rows, b_cols;
+  GetMatrixDims(mat_b.dims(), &b_batch, &b_rows, &b_cols);
+  int64_t k = transb ? b_cols : b_rows;
+  int64_t n = transb ? b_rows : b_cols;
+  PADDLE_ENFORCE_EQ(
+      k,
+      a.cols,
+      phi::errors::PreconditionNotMet(
+          "The shape of the sparse matrix and the dense matrix is not "
+          "suitable for SPMM, the inner dims %d and %d must be eaqual.",
+          a.cols,
+          k));
+  PADDLE_ENFORCE_EQ(mat_out->numel(),
+                    a.TotalRows() * n,
+                    phi::errors::PreconditionNotMet(
+                        "The numel of the output of SPMM is not right."));
+
+  // every entry of a adds a contiguous row of b to a row of out
+  const T* b_data = mat_b.data<T>();
+  std::vector<T> b_buffer;
+  if (transb) {
+    b_buffer.resize(mat_b.numel());
+    TransposeBatchMatrix(b_data, b_batch, b_rows, b_cols, b_buffer.data());
+    b_data = b_buffer.data();
+  }
+  int64_t b_stride = b_batch == 1 ? 0 : k * n;
+  T* out_data = mat_out->data<T>();
+
+  ParallelForRows(a.offsets, n, [&](int64_t r) {
+    const T* b_batch_data = b_data + r / a.rows * b_stride;
+    T* out_row = out_data + r * n;
+    if (beta == static_cast<T>(0)) {
+      std::fill(out_row, out_row + n, static_cast<T>(0));
+    } else if (beta != static_cast<T>(1)) {
+      for (int64_t j = 0; j < n; ++j) {
+        out_row[j] *= beta;
+      }
+    }
+    for (int64_t i = a.offsets[r]; i < a.offsets[r + 1]; ++i) {
+      T value = alpha * a.value_data[i];
+      const T* b_row = b_batch_data + a.col_data[i] * n;
+      for (int64_t j = 0; j < n; ++j) {
+        out_row[j] += value * b_row[j];
+      }
+    }
+  });
+}
+
+template <typename T, typename IntT>
+void CpuSpmv(T alpha,
+             const CpuCsrView<T, IntT>& a,
+             const phi::DenseTensor& vec_x,
+             T beta,
+             phi::DenseTensor* vec_out) {
+  PADDLE_ENFORCE_EQ(
+      vec_x.numel(),
+      a.batch_size * a.cols,
+      phi::errors::PreconditionNotMet(
+          "The numel of the vector is not suitable for SPMV, it must be "
+          "eaqual to %d.",
+          a.batch_size * a.cols));
+  PADDLE_ENFORCE_EQ(vec_out->numel(),
+                    a.TotalRows(),
+                    phi::errors::PreconditionNotMet(
+                        "The numel of the output of SPMV is not right."));
+  const T* x_data = vec_x.data<T>();
+  T* out_data = vec_out->data<T>();
+  ParallelForRows(a.offsets, 1, [&](int64_t r) {
+    const T* x_batch_data = x_data + r / a.rows * a.cols;
+    T sum = static_cast<T>(0);
+    for (int64_t i = a.offsets[r]; i < a.offsets[r + 1]; ++i) {
+      sum += a.value_data[i] * x_batch_data[a.col_data[i]];
+    }
+    out_data[r] = beta == static_cast<T>(0)
+                      ? alpha * sum
+                      : alpha * sum + beta * out_data[r];
+  });
+}
+
+template <typename T, typename IntT>
+void CpuSddmm(bool transa,
+              bool transb,
+              T alpha,
+              const phi::DenseTensor& mat_a,
+              const phi::DenseTensor& mat_b,
+              T beta,
+              const CpuCsrView<T, IntT>& out,
+              T* out_values) {
+  int64_t a_batch, a_rows, a_cols, b_batch, b_rows, b_cols;
+  GetMatrixDims(mat_a.dims(), &a_batch, &a_rows, &a_cols);
+  GetMatrixDims(mat_b.dims(), &b_batch, &b_rows, &b_cols);
+  int64_t m = transa ? a_cols : a_rows;
+  int64_t k = transa ? a_rows : a_cols;
+  int64_t n = transb ? b_rows : b_cols;
+  PADDLE_ENFORCE_EQ(
+      k,
+      transb ? b_cols : b_rows,
+      phi::errors::PreconditionNotMet(
+          "The shape of the dense matrices is not suitable for SDDMM, the "
+          "inner dims must be eaqual."));
+  PADDLE_ENFORCE_EQ(
+      m == out.rows && n == out.cols,
+      true,
+      phi::errors::PreconditionNotMet(
+          "The shape of the dense matrices is not suitable for SDDMM, the "
+          "product must be [%d, %d].",
+          out.rows,
+          out.cols));
+
+  // an entry is the dot of a row of a and a column of b, both are made
+  // contiguous, i.e. a in [m, k] and b in [n, k]
+  const T* a_data = mat_a.data<T>();
+  std::vector<T> a_buffer;
+  if (transa) {
+    a_buffer.resize(mat_a.numel());
+    TransposeBatchMatrix(a_data, a_batch, a_rows, a_cols, a_buffer.data());
+    a_data = a_buffer.data();
+  }
+  const T* b_data = mat_b.data<T>();
+  std::vector<T> b_buffer;
+  if (!transb) {
+    b_buffer.resize(mat_b.numel());
+    TransposeBatchMatrix(b_data, b_batch, b_rows, b_cols, b_buffer.data());
+    b_data = b_buffer.data();
+  }
+  int64_t a_stride = a_batch == 1 ? 0 : m * k;
+  int64_t b_stride = b_batch == 1 ? 0 : n * k;
+
+  ParallelForRows(out.offsets, k, [&](int64_t r) {
+    int64_t batch = r / out.rows;
+    const T* a_row = a_data + batch * a_stride + r % out.rows * k;
+    const T* b_batch_data = b_data + batch * b_stride;
+    for (int64_t i = out.offsets[r]; i < out.offsets[r + 1]; ++i) {
+      const T* b_row = b_batch_data + out.col_data[i] * k;
+      T sum = static_cast<T>(0);
+      for (int64_t j = 0; j < k; ++j) {
+        sum += a_row[j] * b_row[j];
+      }
+      T& value = out_values[out.Index(i)];
+      value = beta == static_cast<T>(0) ? alpha * sum
+                                        : alpha * sum + beta * value;
+    }
+  });
+}
+
+/************* SPARSE*DENSE->DENSE MATMUL ************/
+template <>
+template <typename T, typename TensorType>
+void SparseBlas<phi::CPUContext>::SPMM(bool transa,
+                                       bool transb,
+                                       T alpha,
+                                       const TensorType& mat_a,
+                                       const phi::DenseTensor& mat_b,
+                                       T beta,
+                                       phi::DenseTensor* mat_out) const {
+  PD_VISIT_INTEGRAL_TYPES(GetIndexType(mat_a), "CpuSpmm", ([&] {
+    CpuCsrView<T, data_t> a;
+    MakeCpuCsrView(mat_a, &a);
+    if (transa) {
+      CpuCsrView<T, data_t> a_trans;
+      TransposeCpuCsrView(a, &a_trans);
+      CpuSpmm(transb, alpha, a_trans, mat_b, beta, mat_out);
+    } else {
+      CpuSpmm(transb, alpha, a, mat_b, beta, mat_out);
+    }
+  }));
+}
+
+/************* SPARSE*DENSE->DENSE MV ************/
+template <>
+template <typename T, typename TensorType>
+void SparseBlas<phi::CPUContext>::SPMV(bool transa,
+                                       T alpha,
+                                       const TensorType& mat_a,
+                                       const phi::DenseTensor& vec_x,
+                                       T beta,
+                                       phi::DenseTensor* vec_out) const {
+  PD_VISIT_INTEGRAL_TYPES(GetIndexType(mat_a), "CpuSpmv", ([&] {
+    CpuCsrView<T, data_t> a;
+    MakeCpuCsrView(mat_a, &a);
+    if (transa) {
+      CpuCsrView<T, data_t> a_trans;
+      TransposeCpuCsrView(a, &a_trans);
+      CpuSpmv(alpha, a_trans, vec_x, beta, vec_out);
+    } else {
+      CpuSpmv(alpha, a, vec_x, beta, vec_out);
+    }
+  }));
+}
+
+/************* DENSE*DENSE->SPARSE MATMUL ************/
+template <>
+template <typename T, typename TensorType>
+void SparseBlas<phi::CPUContext>::SDDMM(bool transa,
+                                        bool transb,
+                                        T alpha,
+                                        const phi::DenseTensor& mat_a,
+                                        const phi::DenseTensor& mat_b,
+                                        T beta,
+                                        TensorType* mat_out) const {
+  PD_VISIT_INTEGRAL_TYPES(
+      GetIndexType(*mat_out), "CpuSddmm", ([&] {
+        CpuCsrView<T, data_t> out;
+        MakeCpuCsrView(*mat_out, &out);
+        CpuSddmm(transa,
+                 transb,
+                 alpha,
+                 mat_a,
+                 mat_b,
+                 beta,
+                 out,
+                 mat_out->mutable_non_zero_elements()->template data<T>());
+      }));
+}
+
+}  // namespace sparse
+}  // namespace funcs
+}  // namespace phi
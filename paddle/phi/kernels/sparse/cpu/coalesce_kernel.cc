@@ -14,6 +14,13 @@ limitations under the License. */
 
 #include "paddle/phi/kernels/sparse/coalesce_kernel.h"
 
+#include <algorithm>
+#include <vector>
+
+#ifdef PADDLE_WITH_MKLML
+#include <omp.h>
+#endif
+
 #include "paddle/phi/core/kernel_registry.h"
 #include "paddle/phi/core/visit_type.h"
 #include "paddle/phi/kernels/funcs/sparse/flatten_indices.h"
@@ -21,6 +28,92 @@ limitations under the License. */
 namespace phi {
 namespace sparse {
 
+inline int GetCoalesceThreadNum(int64_t work, int64_t min_work = 65536) {
+#ifdef PADDLE_WITH_MKLML
+  int64_t num = std::min<int64_t>(omp_get_max_threads(), work / min_work);
+  return static_cast<int>(std::max<int64_t>(num, 1));
+#else
+  return 1;
+#endif
+}
+
+// Sort the flattened indices with their positions by a LSD radix sort, one
+// byte per pass. Every thread counts the digits of its chunk, and then
+// scatters the chunk to the offsets of (digit, thread), so the sort is
+// stable and the duplicates keep the order of the input. The passes of the
+// bytes above max_key, or with one digit for all the keys, are skipped.
+template <typename IntT>
+void RadixSortByKey(int64_t num,
+                    IntT max_key,
+                    int thread_num,
+                    std::vector<IntT>* keys,
+                    std::vector<int64_t>* values) {
+  constexpr int kBits = 8;
+  constexpr int kBuckets = 1 << kBits;
+  std::vector<IntT> keys_buffer(num);
+  std::vector<int64_t> values_buffer(num);
+  std::vector<int64_t> counts(thread_num * kBuckets);
+  int64_t chunk = (num + thread_num - 1) / thread_num;
+
+  int passes = 0;
+  for (uint64_t key = static_cast<uint64_t>(max_key); key > 0;
+       key >>= kBits) {
+    passes++;
+  }
+  for (int pass = 0; pass < passes; pass++) {
+    const int shift = pass * kBits;
+    const IntT* in_keys = keys->data();
+    const int64_t* in_values = values->data();
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for num_threads(thread_num) schedule(static, 1)
+#endif
+    for (int t = 0; t < thread_num; t++) {
+      int64_t* count = counts.data() + t * kBuckets;
+      std::fill(count, count + kBuckets, 0);
+      int64_t end = std::min(num, (t + 1) * chunk);
+      for (int64_t i = t * chunk; i < end; i++) {
+        count[(static_cast<uint64_t>(in_keys[i]) >> shift) & (kBuckets - 1)]++;
+      }
+    }
+
+    // exclusive prefix sum in (digit, thread) order
+    int64_t offset = 0;
+    bool one_digit = false;
+    for (int d = 0; d < kBuckets; d++) {
+      int64_t digit_num = 0;
+      for (int t = 0; t < thread_num; t++) {
+        int64_t count = counts[t * kBuckets + d];
+        counts[t * kBuckets + d] = offset;
+        offset += count;
+        digit_num += count;
+      }
+      one_digit = one_digit || digit_num == num;
+    }
+    if (one_digit) {
+      continue;
+    }
+
+    IntT* out_keys = keys_buffer.data();
+    int64_t* out_values = values_buffer.data();
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for num_threads(thread_num) schedule(static, 1)
+#endif
+    for (int t = 0; t < thread_num; t++) {
+      int64_t* next = counts.data() + t * kBuckets;
+      int64_t end = std::min(num, (t + 1) * chunk);
+      for (int64_t i = t * chunk; i < end; i++) {
+        int64_t pos =
+            next[(static_cast<uint64_t>(in_keys[i]) >> shift) &
+                 (kBuckets - 1)]++;
+        out_keys[pos] = in_keys[i];
+        out_values[pos] = in_values[i];
+      }
+    }
+    keys->swap(keys_buffer);
+    values->swap(values_buffer);
+  }
+}
+
 template <typename T, typename IntT>
 void CoalesceCPUKernel(const CPUContext& dev_ctx,
                        const SparseCooTensor& x,
@@ -30,36 +123,49 @@ void CoalesceCPUKernel(const CPUContext& dev_ctx,
   DenseTensor out_indices = phi::EmptyLike<IntT>(dev_ctx, x_indices);
   DenseTensor out_values = phi::EmptyLike<T>(dev_ctx, x_values);
 
+  const int64_t nnz = x.nnz();
   const int64_t sparse_dim = x.non_zero_indices().dims()[0];
-  std::vector<IntT> sparse_offsets(sparse_dim), x_indexs(x.nnz());
+  std::vector<IntT> sparse_offsets(sparse_dim), x_indexs(nnz);
   phi::funcs::sparse::CalcOffsetsPerDim<IntT>(
       x.dims(), sparse_dim, sparse_offsets.data());
 
-  phi::funcs::sparse::FlattenIndices(x.non_zero_indices().data<IntT>(),
-                                     sparse_offsets.data(),
-                                     x.nnz(),
-                                     sparse_dim,
-                                     0,
-                                     1,
-                                     x_indexs.data());
-
-  const T* x_values_ptr = x_values.data<T>();
-  const int64_t stride =
-      x.dims().size() == sparse_dim ? 1 : x.non_zero_elements().dims()[1];
+  const IntT* x_indices_ptr = x.non_zero_indices().data<IntT>();
+  int thread_num = GetCoalesceThreadNum(nnz);
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for num_threads(thread_num)
+#endif
+  for (int64_t i = 0; i < nnz; i++) {
+    x_indexs[i] = phi::funcs::sparse::CoordinateToIndex(
+        x_indices_ptr, sparse_offsets.data(), nnz, sparse_dim, i);
+  }
 
-  std::map<IntT, std::vector<int64_t>> indices_to_index;
-  for (uint64_t i = 0; i < x_indexs.size(); i++) {
-    IntT index = x_indexs[i];
-    if (indices_to_index.find(index) == indices_to_index.end()) {
-      std::vector<int64_t> indexs;
-      indexs.push_back(i);
-      indices_to_index[index] = indexs;
-    } else {
-      indices_to_index[index].push_back(i);
+  // sort the positions by the flattened indices
+  std::vector<int64_t> positions(nnz);
+  for (int64_t i = 0; i < nnz; i++) {
+    positions[i] = i;
+  }
+  IntT max_index = sparse_dim == 0 ? 0 : sparse_offsets[0] * x.dims()[0] - 1;
+  RadixSortByKey<IntT>(nnz, max_index, thread_num, &x_indexs, &positions);
+
+  // the heads of the runs of equal indices, counted by chunks to get the
+  // output offset of every chunk
+  int64_t chunk = (nnz + thread_num - 1) / thread_num;
+  std::vector<int64_t> chunk_offsets(thread_num + 1, 0);
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for num_threads(thread_num) schedule(static, 1)
+#endif
+  for (int t = 0; t < thread_num; t++) {
+    int64_t end = std::min(nnz, (t + 1) * chunk);
+    for (int64_t i = t * chunk; i < end; i++) {
+      if (i == 0 || x_indexs[i] != x_indexs[i - 1]) {
+        chunk_offsets[t + 1]++;
+      }
     }
   }
-
-  const int64_t out_nnz = indices_to_index.size();
+  for (int t = 0; t < thread_num; t++) {
+    chunk_offsets[t + 1] += chunk_offsets[t];
+  }
+  const int64_t out_nnz = chunk_offsets[thread_num];
 
   out_indices.Resize({x_indices.dims()[0], out_nnz});
   if (out_values.dims().size() == 1) {
@@ -68,26 +174,44 @@ void CoalesceCPUKernel(const CPUContext& dev_ctx,
     out_values.Resize(phi::make_ddim({out_nnz, x_values.dims()[1]}));
   }
 
+  const T* x_values_ptr = x_values.data<T>();
+  const int64_t stride =
+      x.dims().size() == sparse_dim ? 1 : x.non_zero_elements().dims()[1];
   IntT* out_indices_ptr = out_indices.data<IntT>();
   T* out_values_ptr = out_values.data<T>();
-  auto iter = indices_to_index.begin();
 
   Dim<DDim::kMaxRank> const_dims;
   for (int i = 0; i < x.dims().size(); i++) {
     const_dims[i] = x.dims()[i];
   }
 
-  for (int i = 0; iter != indices_to_index.end(); iter++, i++) {
-    phi::funcs::sparse::IndexToCoordinate(
-        iter->first, const_dims, out_nnz, sparse_dim, i, out_indices_ptr);
-    memcpy(out_values_ptr + i * stride,
-           x_values_ptr + iter->second[0] * stride,
-           stride * sizeof(T));
-    for (uint64_t j = 1; j < iter->second.size(); j++) {
-      for (int k = 0; k < stride; k++) {
-        out_values_ptr[i * stride + k] +=
-            x_values_ptr[iter->second[j] * stride + k];
+  // every thread sums the runs starting in its chunk, a run may go on
+  // into the next chunk
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for num_threads(thread_num) schedule(static, 1)
+#endif
+  for (int t = 0; t < thread_num; t++) {
+    int64_t out_i = chunk_offsets[t];
+    int64_t end = std::min(nnz, (t + 1) * chunk);
+    int64_t i = t * chunk;
+    while (i < end && i > 0 && x_indexs[i] == x_indexs[i - 1]) {
+      i++;
+    }
+    while (i < end) {
+      phi::funcs::sparse::IndexToCoordinate(
+          x_indexs[i], const_dims, out_nnz, sparse_dim, out_i, out_indices_ptr);
+      T* out_value = out_values_ptr + out_i * stride;
+      memcpy(out_value,
+             x_values_ptr + positions[i] * stride,
+             stride * sizeof(T));
+      int64_t j = i + 1;
+      for (; j < nnz && x_indexs[j] == x_indexs[i]; j++) {
+        for (int64_t k = 0; k < stride; k++) {
+          out_value[k] += x_values_ptr[positions[j] * stride + k];
+        }
       }
+      i = j;
+      out_i++;
     }
   }
 
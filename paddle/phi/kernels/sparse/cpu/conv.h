@@ -14,7 +14,14 @@ limitations under the License. */
 
 #pragma once
 
-#include <set>
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#ifdef PADDLE_WITH_MKLML
+#include <omp.h>
+#endif
 
 #include "paddle/phi/core/dense_tensor.h"
 #include "paddle/phi/core/kernel_registry.h"
@@ -28,9 +35,97 @@ namespace sparse {
 
 using Dims4D = phi::funcs::sparse::Dims4D;
 
+// The thread num to split work items into chunks of at least min_work.
+inline int GetRulebookThreadNum(int64_t work, int64_t min_work = 4096) {
+#ifdef PADDLE_WITH_MKLML
+  int64_t num = std::min<int64_t>(omp_get_max_threads(), work / min_work);
+  return static_cast<int>(std::max<int64_t>(num, 1));
+#else
+  return 1;
+#endif
+}
+
+// An open addressing hash table from the linear index of a point to a value,
+// for building the rulebook. Insert can be called by many threads at the
+// same time, Find and SetValue after all the inserts are done.
+template <typename IntT>
+class CoordinateHashTable {
+ public:
+  explicit CoordinateHashTable(int64_t num) {
+    // keep the load factor at most 0.5
+    capacity_ = 1;
+    bits_ = 0;
+    while (capacity_ < 2 * std::max<int64_t>(num, 1)) {
+      capacity_ <<= 1;
+      ++bits_;
+    }
+    keys_.reset(new std::atomic<IntT>[capacity_]);
+    values_.reset(new IntT[capacity_]);
+    int thread_num = GetRulebookThreadNum(capacity_, 1 << 16);
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for num_threads(thread_num)
+#endif
+    for (int64_t i = 0; i < capacity_; ++i) {
+      keys_[i].store(kEmpty, std::memory_order_relaxed);
+    }
+  }
+
+  // Return false when the key exists, the value is kept.
+  bool Insert(IntT key, IntT value) {
+    for (int64_t slot = Hash(key);; slot = (slot + 1) & (capacity_ - 1)) {
+      IntT expected = keys_[slot].load(std::memory_order_relaxed);
+      if (expected == kEmpty &&
+          keys_[slot].compare_exchange_strong(expected, key)) {
+        values_[slot] = value;
+        return true;
+      }
+      if (expected == key) {
+        return false;
+      }
+    }
+  }
+
+  // Return the value of key, or -1 when key does not exist.
+  IntT Find(IntT key) const {
+    int64_t slot = FindSlot(key);
+    return slot < 0 ? -1 : values_[slot];
+  }
+
+  void SetValue(IntT key, IntT value) { values_[FindSlot(key)] = value; }
+
+ private:
+  static constexpr IntT kEmpty = -1;
+
+  int64_t Hash(IntT key) const {
+    // fibonacci hashing spreads the neighboring points
+    uint64_t hash = static_cast<uint64_t>(key) * 0x9E3779B97F4A7C15ULL;
+    return bits_ == 0 ? 0 : static_cast<int64_t>(hash >> (64 - bits_));
+  }
+
+  int64_t FindSlot(IntT key) const {
+    for (int64_t slot = Hash(key);; slot = (slot + 1) & (capacity_ - 1)) {
+      IntT cur = keys_[slot].load(std::memory_order_relaxed);
+      if (cur == key) {
+        return slot;
+      }
+      if (cur == kEmpty) {
+        return -1;
+      }
+    }
+  }
+
+  int64_t capacity_;
+  int bits_;
+  std::unique_ptr<std::atomic<IntT>[]> keys_;
+  std::unique_ptr<IntT[]> values_;
+};
+
 // such as: kernel(3, 3, 3), kernel_size = 27
 // counter_per_weight: (kernel_size)
-// TODO(zhangkaihuo): optimize performance with multithreading
+// The input points are split into one chunk per thread, every thread keeps
+// the rules of its chunk in a buffer per kernel, and the buffers are merged
+// in the (kernel, chunk) order with a prefix sum, so the rulebook is the
+// same as the serial one.
 template <typename T, typename Context, typename IntT = int>
 void ProductRuleBook(const Context& dev_ctx,
                      const SparseCooTensor& x,
@@ -48,82 +143,92 @@ void ProductRuleBook(const Context& dev_ctx,
   int kernel_size = kernel_sizes[0] * kernel_sizes[1] * kernel_sizes[2];
   memset(counter_per_kernel, 0, kernel_size * sizeof(int));
 
-  int rulebook_len = 0;
-  // calc the rulebook_len
   const auto& x_dims = x.dims();
   const Dims4D c_x_dims(x_dims[0], x_dims[3], x_dims[2], x_dims[1]);
   const Dims4D c_kernel_dims(
       1, kernel_sizes[2], kernel_sizes[1], kernel_sizes[0]);
-  const Dims4D c_out_dims(out_dims[0], out_dims[3], out_dims[2], out_dims[1]);
   const Dims4D c_paddings(1, paddings[2], paddings[1], paddings[0]);
   const Dims4D c_strides(1, strides[2], strides[1], strides[0]);
   const Dims4D c_dilations(1, dilations[2], dilations[1], dilations[0]);
 
-  std::set<IntT> hash_in;
+  const int thread_num = GetRulebookThreadNum(non_zero_num);
+  std::unique_ptr<CoordinateHashTable<IntT>> hash_in;
   if (subm) {
-    for (int i = 0; i < non_zero_num; i++) {
+    hash_in.reset(new CoordinateHashTable<IntT>(non_zero_num));
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for num_threads(thread_num)
+#endif
+    for (int64_t i = 0; i < non_zero_num; i++) {
       IntT batch = indices_ptr[i];
       IntT in_z = indices_ptr[i + non_zero_num];
       IntT in_y = indices_ptr[i + 2 * non_zero_num];
       IntT in_x = indices_ptr[i + 3 * non_zero_num];
       IntT index = phi::funcs::sparse::PointToIndex<DDim>(
           batch, in_x, in_y, in_z, x_dims);
-      hash_in.insert(index);
+      hash_in->Insert(index, i);
     }
   }
 
-  auto f_calc_rulebook = [&](IntT* rulebook_ptr) {
-    int kernel_index = 0, rulebook_index = 0;
-    for (int kz = 0; kz < kernel_sizes[0]; kz++) {
-      for (int ky = 0; ky < kernel_sizes[1]; ky++) {
-        for (int kx = 0; kx < kernel_sizes[2]; kx++) {
-          ++kernel_index;
-          for (int64_t i = 0; i < non_zero_num; i++) {
-            IntT batch = indices_ptr[i];
-            IntT in_z = indices_ptr[i + non_zero_num];
-            IntT in_y = indices_ptr[i + 2 * non_zero_num];
-            IntT in_x = indices_ptr[i + 3 * non_zero_num];
+  // buffers[t * kernel_size + k] keeps the (in_i, out_index) pairs
+  std::vector<std::vector<IntT>> buffers(thread_num * kernel_size);
+  const int64_t chunk = (non_zero_num + thread_num - 1) / thread_num;
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for num_threads(thread_num) schedule(static, 1)
+#endif
+  for (int t = 0; t < thread_num; t++) {
+    std::vector<IntT>* thread_buffers = &buffers[t * kernel_size];
+    const int64_t end = std::min(non_zero_num, (t + 1) * chunk);
+    for (int64_t i = t * chunk; i < end; i++) {
+      IntT batch = indices_ptr[i];
+      IntT in_z = indices_ptr[i + non_zero_num];
+      IntT in_y = indices_ptr[i + 2 * non_zero_num];
+      IntT in_x = indices_ptr[i + 3 * non_zero_num];
+      int kernel_index = 0;
+      for (int kz = 0; kz < kernel_sizes[0]; kz++) {
+        for (int ky = 0; ky < kernel_sizes[1]; ky++) {
+          for (int kx = 0; kx < kernel_sizes[2]; kx++, kernel_index++) {
+            if (!phi::funcs::sparse::Check(c_x_dims,
+                                           c_kernel_dims,
+                                           c_paddings,
+                                           c_dilations,
+                                           c_strides,
+                                           in_x,
+                                           in_y,
+                                           in_z,
+                                           kx,
+                                           ky,
+                                           kz)) {
+              continue;
+            }
             IntT out_z = (in_z + paddings[0] - kz * dilations[0]) / strides[0];
             IntT out_y = (in_y + paddings[1] - ky * dilations[1]) / strides[1];
             IntT out_x = (in_x + paddings[2] - kx * dilations[2]) / strides[2];
-            if (phi::funcs::sparse::Check(c_x_dims,
-                                          c_kernel_dims,
-                                          c_paddings,
-                                          c_dilations,
-                                          c_strides,
-                                          in_x,
-                                          in_y,
-                                          in_z,
-                                          kx,
-                                          ky,
-                                          kz)) {
-              if (subm) {
-                IntT out_index = phi::funcs::sparse::PointToIndex<DDim>(
-                    batch, out_x, out_y, out_z, out_dims);
-                if (hash_in.find(out_index) == hash_in.end()) {
-                  continue;
-                }
-              }
-
-              if (rulebook_ptr == nullptr) {
-                counter_per_kernel[kernel_index - 1] += 1;
-                ++rulebook_len;
-              } else {
-                rulebook_ptr[rulebook_index] = kernel_index - 1;
-                rulebook_ptr[rulebook_index + rulebook_len] = i;  // in_i
-                rulebook_ptr[rulebook_index + rulebook_len * 2] =
-                    phi::funcs::sparse::PointToIndex<DDim>(
-                        batch, out_x, out_y, out_z, out_dims);  // out_index
-                ++rulebook_index;
-              }
+            IntT out_index = phi::funcs::sparse::PointToIndex<DDim>(
+                batch, out_x, out_y, out_z, out_dims);
+            if (subm && hash_in->Find(out_index) < 0) {
+              continue;
             }
+            thread_buffers[kernel_index].push_back(i);
+            thread_buffers[kernel_index].push_back(out_index);
           }
         }
       }
     }
-  };
+  }
+
+  // the rules of kernel k from chunk t start at offsets[k * thread_num + t]
+  std::vector<int> offsets(kernel_size * thread_num + 1);
+  int rulebook_len = 0;
+  for (int k = 0; k < kernel_size; k++) {
+    for (int t = 0; t < thread_num; t++) {
+      int num = buffers[t * kernel_size + k].size() / 2;
+      offsets[k * thread_num + t] = rulebook_len;
+      counter_per_kernel[k] += num;
+      rulebook_len += num;
+    }
+  }
+  offsets[kernel_size * thread_num] = rulebook_len;
 
-  f_calc_rulebook(nullptr);
   // alloc the rulebook
   *rulebook = phi::Empty(
       dev_ctx,
@@ -131,9 +236,26 @@ void ProductRuleBook(const Context& dev_ctx,
                       {3, rulebook_len},
                       DataLayout::NCHW));
   IntT* rulebook_ptr = rulebook->data<IntT>();
-  f_calc_rulebook(rulebook_ptr);
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for num_threads(thread_num) schedule(dynamic)
+#endif
+  for (int item = 0; item < kernel_size * thread_num; item++) {
+    const int k = item / thread_num;
+    const int t = item % thread_num;
+    std::vector<IntT>* buffer = &buffers[t * kernel_size + k];
+    const int num = offsets[item + 1] - offsets[item];
+    IntT* kernel_ptr = rulebook_ptr + offsets[item];
+    for (int j = 0; j < num; j++) {
+      kernel_ptr[j] = k;
+      kernel_ptr[j + rulebook_len] = (*buffer)[2 * j];  // in_i
+      kernel_ptr[j + rulebook_len * 2] = (*buffer)[2 * j + 1];  // out_index
+    }
+    std::vector<IntT>().swap(*buffer);
+  }
 }
 
+// Replace the out index in the rulebook with the position of the point in
+// the sorted output points, and build the indices of out.
 template <typename T, typename Context, typename IntT = int>
 void UpdateRulebookAndOutIndex(const Context& dev_ctx,
                                const SparseCooTensor& x,
@@ -142,12 +264,32 @@ void UpdateRulebookAndOutIndex(const Context& dev_ctx,
                                const DDim& out_dims,
                                DenseTensor* rulebook,
                                SparseCooTensor* out) {
-  std::set<IntT> out_indexs;
   int n = rulebook->dims()[1];
   IntT* rulebook_ptr = rulebook->data<IntT>();
-  for (int i = 0; i < n; i++) {
-    out_indexs.insert(rulebook_ptr[i + n * 2]);
+  const int thread_num = GetRulebookThreadNum(n);
+
+  // every thread collects the points it inserts first
+  CoordinateHashTable<IntT> hash_out(n);
+  std::vector<std::vector<IntT>> thread_indexs(thread_num);
+  const int chunk = (n + thread_num - 1) / thread_num;
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for num_threads(thread_num) schedule(static, 1)
+#endif
+  for (int t = 0; t < thread_num; t++) {
+    const int end = std::min(n, (t + 1) * chunk);
+    for (int i = t * chunk; i < end; i++) {
+      IntT out_index = rulebook_ptr[i + n * 2];
+      if (hash_out.Insert(out_index, 0)) {
+        thread_indexs[t].push_back(out_index);
+      }
+    }
   }
+  std::vector<IntT> out_indexs;
+  for (auto& indexs : thread_indexs) {
+    out_indexs.insert(out_indexs.end(), indexs.begin(), indexs.end());
+    std::vector<IntT>().swap(indexs);
+  }
+  std::sort(out_indexs.begin(), out_indexs.end());
 
   int out_non_zero_num = out_indexs.size();
   const int64_t sparse_dim = 4;
@@ -161,9 +303,12 @@ void UpdateRulebookAndOutIndex(const Context& dev_ctx,
   phi::DenseTensor out_indices = phi::Empty(dev_ctx, std::move(indices_meta));
   phi::DenseTensor out_values = phi::Empty(dev_ctx, std::move(values_meta));
   IntT* out_indices_ptr = out_indices.data<IntT>();
-  int i = 0;
-  for (auto it = out_indexs.begin(); it != out_indexs.end(); it++, i++) {
-    const IntT index = *it;
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for num_threads(thread_num)
+#endif
+  for (int i = 0; i < out_non_zero_num; i++) {
+    const IntT index = out_indexs[i];
+    hash_out.SetValue(index, i);
     IntT batch, x, y, z;
     phi::funcs::sparse::IndexToPoint<DDim>(index, out_dims, &batch, &x, &y, &z);
     out_indices_ptr[i] = batch;
@@ -171,10 +316,11 @@ void UpdateRulebookAndOutIndex(const Context& dev_ctx,
     out_indices_ptr[i + out_non_zero_num * 2] = y;
     out_indices_ptr[i + out_non_zero_num * 3] = x;
   }
-  for (i = 0; i < n; i++) {
-    IntT out_index = rulebook_ptr[i + n * 2];
-    rulebook_ptr[i + n * 2] =
-        std::distance(out_indexs.begin(), out_indexs.find(out_index));
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for num_threads(thread_num)
+#endif
+  for (int i = 0; i < n; i++) {
+    rulebook_ptr[i + n * 2] = hash_out.Find(rulebook_ptr[i + n * 2]);
   }
 
   out->SetMember(out_indices, out_values, out_dims, true);
@@ -183,6 +329,10 @@ void UpdateRulebookAndOutIndex(const Context& dev_ctx,
 template <typename T, typename IntT = int>
 void Gather(
     const T* x, const IntT* indexs, const int n, const int channels, T* out) {
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for num_threads( \
+    GetRulebookThreadNum(static_cast<int64_t>(n) * channels, 1 << 16))
+#endif
   for (int i = 0; i < n; i++) {
     IntT real_i = indexs[i];
     memcpy(out + i * channels, x + real_i * channels, channels * sizeof(T));
@@ -16,10 +16,46 @@ limitations under the License. */
 
 #include "paddle/phi/backends/cpu/cpu_context.h"
 #include "paddle/phi/core/kernel_registry.h"
+#include "paddle/phi/kernels/funcs/sparse/sparse_blas.h"
+#include "paddle/phi/kernels/sparse/empty_kernel.h"
 
 namespace phi {
 namespace sparse {
 
+template <typename T, typename Context, typename TensorType>
+void MvGradKernelImpl(const Context& dev_ctx,
+                      const TensorType& x,
+                      const DenseTensor& vec,
+                      const DenseTensor& dout,
+                      TensorType* dx,
+                      DenseTensor* dvec) {
+  auto sparse_blas = phi::funcs::sparse::GetSparseBlas<Context, T>(dev_ctx);
+
+  // dx{Sparse} = dout{Dense} * vec'{Dense}, the product of a column and a row
+  if (dx) {
+    DenseTensor dout_mat = dout;
+    dout_mat.Resize({dout.numel(), 1});
+    DenseTensor vec_mat = vec;
+    vec_mat.Resize({1, vec.numel()});
+    sparse_blas.SDDMM(false,
+                      false,
+                      static_cast<T>(1),
+                      dout_mat,
+                      vec_mat,
+                      static_cast<T>(0),
+                      dx);
+  }
+
+  // dvec{Dense} = x'{Sparse} * dout{Dense}
+  if (dvec) {
+    // InferMeta of DenseTensor 'dvec'
+    dvec->Resize(vec.dims());
+    dev_ctx.template Alloc<T>(dvec);
+
+    sparse_blas.SPMV(true, static_cast<T>(1), x, dout, static_cast<T>(0), dvec);
+  }
+}
+
 template <typename T, typename Context>
 void MvCooGradKernel(const Context& dev_ctx,
                      const SparseCooTensor& x,
@@ -27,8 +63,11 @@ void MvCooGradKernel(const Context& dev_ctx,
                      const DenseTensor& dout,
                      SparseCooTensor* dx,
                      DenseTensor* dvec) {
-  PADDLE_THROW(phi::errors::Unimplemented(
-      "Not support CPU backward kernel of 'sparse.mv' now."));
+  if (dx) {
+    // InferMeta of SparseCooTensor 'dx', CreateLikeInferMeta
+    EmptyLikeCooKernel<T, Context>(dev_ctx, x, dx);
+  }
+  MvGradKernelImpl<T>(dev_ctx, x, vec, dout, dx, dvec);
 }
 
 template <typename T, typename Context>
@@ -38,8 +77,11 @@ void MvCsrGradKernel(const Context& dev_ctx,
                      const DenseTensor& dout,
                      SparseCsrTensor* dx,
                      DenseTensor* dvec) {
-  PADDLE_THROW(phi::errors::Unimplemented(
-      "Not support CPU backward kernel of 'sparse.mv' now."));
+  if (dx) {
+    // InferMeta of SparseCsrTensor 'dx', CreateLikeInferMeta
+    EmptyLikeCsrKernel<T, Context>(dev_ctx, x, dx);
+  }
+  MvGradKernelImpl<T>(dev_ctx, x, vec, dout, dx, dvec);
 }
 
 }  // namespace sparse
@@ -0,0 +1,139 @@
+/* Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+// Compare the throughput of the CPU coalesce with a std::map that groups
+// the duplicates, and sweep the thread num of the coalesce, e.g.
+//   sparse_coalesce_benchmark --nnz=10000000 --dup_ratio=0.5 \
+//       --max_threads=64
+
+#include <chrono>  // NOLINT
+#include <map>
+#include <random>
+
+#include "gflags/gflags.h"
+#include "glog/logging.h"
+#include "paddle/fluid/memory/allocation/allocator_facade.h"
+#include "paddle/phi/backends/cpu/cpu_context.h"
+#include "paddle/phi/kernels/empty_kernel.h"
+#include "paddle/phi/kernels/sparse/coalesce_kernel.h"
+
+#ifdef PADDLE_WITH_MKLML
+#include <omp.h>
+#endif
+
+DEFINE_int64(nnz, 10000000, "The nnz of the uncoalesced tensor.");
+DEFINE_double(dup_ratio, 0.5, "The ratio of the duplicated indices.");
+DEFINE_int32(channels, 1, "The values of every index.");
+DEFINE_int32(max_threads, 64, "The max thread num to sweep.");
+DEFINE_bool(run_map, true, "Whether to measure the std::map baseline.");
+
+namespace phi {
+namespace tests {
+
+// Indices of a [batch, 4096, 4096] tensor in random order, where about
+// dup_ratio of them repeat an earlier one.
+static SparseCooTensor GenerateCoo(const CPUContext& dev_ctx) {
+  const std::vector<int64_t> dims = {64, 4096, 4096};
+  std::mt19937_64 rng(0);
+  std::uniform_real_distribution<double> distrib(0, 1.0);
+  DenseTensor indices = phi::Empty<int64_t>(dev_ctx, {3, FLAGS_nnz});
+  int64_t* indices_ptr = indices.data<int64_t>();
+  for (int64_t i = 0; i < FLAGS_nnz; i++) {
+    int64_t src = i > 0 && distrib(rng) < FLAGS_dup_ratio ? rng() % i : i;
+    for (int d = 0; d < 3; d++) {
+      indices_ptr[d * FLAGS_nnz + i] = src == i
+                                           ? static_cast<int64_t>(rng() %
+                                                                  dims[d])
+                                           : indices_ptr[d * FLAGS_nnz + src];
+    }
+  }
+  std::vector<int64_t> values_dims = {FLAGS_nnz};
+  std::vector<int64_t> out_dims = dims;
+  if (FLAGS_channels > 1) {
+    values_dims.push_back(FLAGS_channels);
+    out_dims.push_back(FLAGS_channels);
+  }
+  DenseTensor values = phi::Empty<float>(dev_ctx, values_dims);
+  for (int64_t i = 0; i < values.numel(); i++) {
+    values.data<float>()[i] = distrib(rng);
+  }
+  return SparseCooTensor(indices, values, phi::make_ddim(out_dims));
+}
+
+// The grouping of the duplicates used by the coalesce before.
+static int64_t MapCoalesce(const SparseCooTensor& x) {
+  const int64_t nnz = x.nnz();
+  const int64_t* indices = x.non_zero_indices().data<int64_t>();
+  std::map<int64_t, std::vector<int64_t>> indices_to_index;
+  for (int64_t i = 0; i < nnz; i++) {
+    int64_t index = (indices[i] * x.dims()[1] + indices[nnz + i]) *
+                        x.dims()[2] +
+                    indices[2 * nnz + i];
+    indices_to_index[index].push_back(i);
+  }
+  return indices_to_index.size();
+}
+
+template <typename Func>
+static double Measure(Func func) {
+  auto start = std::chrono::steady_clock::now();
+  func();
+  auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double>(end - start).count();
+}
+
+static int BenchmarkMain() {
+  phi::CPUContext dev_ctx;
+  dev_ctx.SetAllocator(paddle::memory::allocation::AllocatorFacade::Instance()
+                           .GetAllocator(paddle::platform::CPUPlace())
+                           .get());
+  dev_ctx.SetHostAllocator(
+      paddle::memory::allocation::AllocatorFacade::Instance()
+          .GetAllocator(paddle::platform::CPUPlace())
+          .get());
+  SparseCooTensor x = GenerateCoo(dev_ctx);
+
+  if (FLAGS_run_map) {
+    int64_t out_nnz = 0;
+    double sec = Measure([&] { out_nnz = MapCoalesce(x); });
+    LOG(INFO) << "std::map: " << out_nnz << " unique in " << sec << " s, "
+              << FLAGS_nnz / sec / 1e6 << " M nnz/s";
+  }
+  for (int thread_num = 1; thread_num <= FLAGS_max_threads;
+       thread_num *= 2) {
+#ifdef PADDLE_WITH_MKLML
+    omp_set_num_threads(thread_num);
+#else
+    if (thread_num > 1) {
+      LOG(WARNING) << "the coalesce is serial without PADDLE_WITH_MKLML";
+      break;
+    }
+#endif
+    SparseCooTensor out;
+    double sec = Measure([&] { out = sparse::Coalesce<float>(dev_ctx, x); });
+    LOG(INFO) << "threads " << thread_num << ": " << out.nnz()
+              << " unique in " << sec << " s, " << FLAGS_nnz / sec / 1e6
+              << " M nnz/s";
+  }
+  return 0;
+}
+
+}  // namespace tests
+}  // namespace phi
+
+int main(int argc, char* argv[]) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  google::InitGoogleLogging(argv[0]);
+  return phi::tests::BenchmarkMain();
+}
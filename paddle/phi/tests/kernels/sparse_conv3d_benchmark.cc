@@ -0,0 +1,202 @@
+/* Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+// Sweep the thread num of the CPU sparse conv3d on a synthetic voxel grid,
+// and report the time of the rulebook and of the whole forward, e.g.
+//   sparse_conv3d_benchmark --voxel_num=1000000 --grid_size=1024 \
+//       --grid_depth=40 --max_threads=64
+
+#include <chrono>  // NOLINT
+#include <random>
+#include <unordered_set>
+
+#include "gflags/gflags.h"
+#include "glog/logging.h"
+#include "paddle/fluid/memory/allocation/allocator_facade.h"
+#include "paddle/phi/kernels/sparse/conv_kernel.h"
+#include "paddle/phi/kernels/sparse/cpu/conv.h"
+
+DEFINE_int32(batch_size, 1, "The batch size.");
+DEFINE_int32(voxel_num, 1000000, "The active voxel num of every sample.");
+DEFINE_int32(grid_size, 1024, "The x and y size of the voxel grid.");
+DEFINE_int32(grid_depth, 40, "The z size of the voxel grid.");
+DEFINE_int32(channels, 16, "The in and out channels of the conv.");
+DEFINE_int32(max_threads, 64, "The max thread num to sweep.");
+DEFINE_int32(repeat, 3, "The repeat times of every measure.");
+
+namespace phi {
+namespace tests {
+
+// The voxels of a lidar scan lie on surfaces, so the points are drawn on
+// random walls standing on the ground plane instead of uniformly.
+static SparseCooTensor GenerateVoxels(const CPUContext& dev_ctx) {
+  std::mt19937_64 rng(0);
+  std::vector<int> indices[4];
+  for (int b = 0; b < FLAGS_batch_size; b++) {
+    std::unordered_set<int64_t> voxels;
+    while (voxels.size() < static_cast<size_t>(FLAGS_voxel_num)) {
+      int x = rng() % FLAGS_grid_size;
+      int y = rng() % FLAGS_grid_size;
+      int len = 1 + rng() % 64;
+      bool along_x = rng() % 2;
+      for (int k = 0; k < len; k++) {
+        int px = along_x ? std::min(x + k, FLAGS_grid_size - 1) : x;
+        int py = along_x ? y : std::min(y + k, FLAGS_grid_size - 1);
+        for (int z = 0; z < FLAGS_grid_depth / 2; z++) {
+          int64_t key =
+              (static_cast<int64_t>(z) * FLAGS_grid_size + py) *
+                  FLAGS_grid_size +
+              px;
+          if (voxels.size() < static_cast<size_t>(FLAGS_voxel_num) &&
+              voxels.insert(key).second) {
+            indices[0].push_back(b);
+            indices[1].push_back(z);
+            indices[2].push_back(py);
+            indices[3].push_back(px);
+          }
+        }
+      }
+    }
+  }
+  const int non_zero_num = indices[0].size();
+  DenseTensor indices_tensor = phi::Empty(
+      dev_ctx,
+      DenseTensorMeta(DataType::INT32, {4, non_zero_num}, DataLayout::NCHW));
+  for (int d = 0; d < 4; d++) {
+    memcpy(indices_tensor.data<int>() + d * non_zero_num,
+           indices[d].data(),
+           non_zero_num * sizeof(int));
+  }
+  DenseTensor values_tensor =
+      phi::Empty(dev_ctx,
+                 DenseTensorMeta(DataType::FLOAT32,
+                                 {non_zero_num, FLAGS_channels},
+                                 DataLayout::NHWC));
+  std::uniform_real_distribution<float> distrib(-1.0, 1.0);
+  for (int64_t i = 0; i < values_tensor.numel(); i++) {
+    values_tensor.data<float>()[i] = distrib(rng);
+  }
+  return SparseCooTensor(indices_tensor,
+                         values_tensor,
+                         {FLAGS_batch_size,
+                          FLAGS_grid_depth,
+                          FLAGS_grid_size,
+                          FLAGS_grid_size,
+                          FLAGS_channels});
+}
+
+template <typename Func>
+static double Measure(Func func) {
+  double best = 0;
+  for (int r = 0; r < FLAGS_repeat; r++) {
+    auto start = std::chrono::steady_clock::now();
+    func();
+    auto end = std::chrono::steady_clock::now();
+    double sec = std::chrono::duration<double>(end - start).count();
+    best = r == 0 ? sec : std::min(best, sec);
+  }
+  return best;
+}
+
+static int BenchmarkMain() {
+  phi::CPUContext dev_ctx;
+  dev_ctx.SetAllocator(paddle::memory::allocation::AllocatorFacade::Instance()
+                           .GetAllocator(paddle::platform::CPUPlace())
+                           .get());
+  dev_ctx.SetHostAllocator(
+      paddle::memory::allocation::AllocatorFacade::Instance()
+          .GetAllocator(paddle::platform::CPUPlace())
+          .get());
+  SparseCooTensor x = GenerateVoxels(dev_ctx);
+  LOG(INFO) << "generate " << x.nnz() << " voxels in a " << FLAGS_grid_size
+            << "x" << FLAGS_grid_size << "x" << FLAGS_grid_depth << " grid";
+
+  DenseTensor kernel = phi::Empty(
+      dev_ctx,
+      DenseTensorMeta(DataType::FLOAT32,
+                      {3, 3, 3, FLAGS_channels, FLAGS_channels},
+                      DataLayout::NHWC));
+  memset(kernel.data<float>(), 0, kernel.numel() * sizeof(float));
+  const std::vector<int> kernel_sizes = {3, 3, 3, FLAGS_channels,
+                                         FLAGS_channels};
+  const std::vector<int> paddings = {1, 1, 1};
+  const std::vector<int> dilations = {1, 1, 1};
+
+  for (int thread_num = 1; thread_num <= FLAGS_max_threads;
+       thread_num *= 2) {
+#ifdef PADDLE_WITH_MKLML
+    omp_set_num_threads(thread_num);
+#else
+    if (thread_num > 1) {
+      LOG(WARNING) << "the rulebook is serial without PADDLE_WITH_MKLML";
+      break;
+    }
+#endif
+    for (bool subm : {true, false}) {
+      const std::vector<int> strides =
+          subm ? std::vector<int>{1, 1, 1} : std::vector<int>{2, 2, 2};
+      DDim out_dims = {1, 1, 1, 1, 1};
+      phi::funcs::sparse::GetOutShape(
+          x.dims(), kernel_sizes, paddings, dilations, strides, &out_dims);
+      std::vector<int> counter(27);
+      int rulebook_len = 0;
+      double rulebook_sec = Measure([&] {
+        DenseTensor rulebook;
+        SparseCooTensor out;
+        sparse::ProductRuleBook<float, CPUContext, int>(dev_ctx,
+                                                        x,
+                                                        kernel_sizes,
+                                                        paddings,
+                                                        dilations,
+                                                        strides,
+                                                        out_dims,
+                                                        subm,
+                                                        &rulebook,
+                                                        counter.data());
+        sparse::UpdateRulebookAndOutIndex<float, CPUContext, int>(
+            dev_ctx, x, 27, FLAGS_channels, out_dims, &rulebook, &out);
+        rulebook_len = rulebook.dims()[1];
+      });
+      double forward_sec = Measure([&] {
+        DenseTensor rulebook, counter_tensor;
+        sparse::Conv3dCoo<float>(dev_ctx,
+                                 x,
+                                 kernel,
+                                 paddings,
+                                 dilations,
+                                 strides,
+                                 1,
+                                 subm,
+                                 "",
+                                 &rulebook,
+                                 &counter_tensor);
+      });
+      LOG(INFO) << "threads " << thread_num
+                << (subm ? ", subm conv" : ", conv stride 2")
+                << ": rulebook " << rulebook_len << " rules in "
+                << rulebook_sec * 1e3 << " ms, forward " << forward_sec * 1e3
+                << " ms";
+    }
+  }
+  return 0;
+}
+
+}  // namespace tests
+}  // namespace phi
+
+int main(int argc, char* argv[]) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  google::InitGoogleLogging(argv[0]);
+  return phi::tests::BenchmarkMain();
+}
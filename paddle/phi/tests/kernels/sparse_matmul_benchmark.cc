@@ -0,0 +1,186 @@
+/* Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+// Sweep the thread num of the CPU sparse matmul, masked_matmul and mv on
+// matrices of uniform, power law and banded sparsity, e.g.
+//   sparse_matmul_benchmark --rows=100000 --cols=100000 --row_nnz=32 \
+//       --dense_cols=64 --max_threads=64
+
+#include <chrono>  // NOLINT
+#include <cmath>
+#include <random>
+#include <set>
+#include <string>
+
+#include "gflags/gflags.h"
+#include "glog/logging.h"
+#include "paddle/fluid/memory/allocation/allocator_facade.h"
+#include "paddle/phi/backends/cpu/cpu_context.h"
+#include "paddle/phi/kernels/empty_kernel.h"
+#include "paddle/phi/kernels/sparse/matmul_kernel.h"
+#include "paddle/phi/kernels/sparse/mv_kernel.h"
+
+#ifdef PADDLE_WITH_MKLML
+#include <omp.h>
+#endif
+
+DEFINE_int64(rows, 100000, "The rows of the sparse matrix.");
+DEFINE_int64(cols, 100000, "The cols of the sparse matrix.");
+DEFINE_int32(row_nnz, 32, "The average nnz of every row.");
+DEFINE_int64(dense_cols, 64, "The cols of the dense matrix.");
+DEFINE_int32(max_threads, 64, "The max thread num to sweep.");
+DEFINE_int32(repeat, 3, "The repeat times of every measure.");
+
+namespace phi {
+namespace tests {
+
+// The cols of every row of a sparsity pattern, sorted and unique.
+static std::vector<std::set<int64_t>> GeneratePattern(
+    const std::string& pattern) {
+  std::mt19937_64 rng(0);
+  std::vector<std::set<int64_t>> rows(FLAGS_rows);
+  std::uniform_real_distribution<double> distrib(0, 1.0);
+  for (int64_t i = 0; i < FLAGS_rows; i++) {
+    int64_t nnz = FLAGS_row_nnz;
+    if (pattern == "power_law") {
+      // zipf-like rows: a few rows take a large part of the nnz
+      nnz = static_cast<int64_t>(FLAGS_row_nnz * 0.1 /
+                                 std::pow(1.0 - distrib(rng), 0.9));
+    }
+    nnz = std::min(std::max<int64_t>(nnz, 0), FLAGS_cols);
+    while (static_cast<int64_t>(rows[i].size()) < nnz) {
+      int64_t col = 0;
+      if (pattern == "banded") {
+        int64_t offset = rng() % (2 * FLAGS_row_nnz) - FLAGS_row_nnz;
+        col = std::min(std::max<int64_t>(i * FLAGS_cols / FLAGS_rows + offset,
+                                         0),
+                       FLAGS_cols - 1);
+      } else {
+        col = rng() % FLAGS_cols;
+      }
+      rows[i].insert(col);
+    }
+  }
+  return rows;
+}
+
+static SparseCsrTensor GenerateCsr(
+    const CPUContext& dev_ctx, const std::vector<std::set<int64_t>>& rows) {
+  int64_t nnz = 0;
+  for (auto& row : rows) {
+    nnz += row.size();
+  }
+  DenseTensor crows = phi::Empty<int64_t>(dev_ctx, {FLAGS_rows + 1});
+  DenseTensor cols = phi::Empty<int64_t>(dev_ctx, {nnz});
+  DenseTensor values = phi::Empty<float>(dev_ctx, {nnz});
+  std::mt19937_64 rng(0);
+  std::uniform_real_distribution<float> distrib(-1.0, 1.0);
+  int64_t offset = 0;
+  for (int64_t i = 0; i < FLAGS_rows; i++) {
+    crows.data<int64_t>()[i] = offset;
+    for (int64_t col : rows[i]) {
+      cols.data<int64_t>()[offset] = col;
+      values.data<float>()[offset] = distrib(rng);
+      offset++;
+    }
+  }
+  crows.data<int64_t>()[FLAGS_rows] = offset;
+  return SparseCsrTensor(
+      crows, cols, values, phi::make_ddim({FLAGS_rows, FLAGS_cols}));
+}
+
+static DenseTensor GenerateDense(const CPUContext& dev_ctx,
+                                 const std::vector<int64_t>& dims) {
+  DenseTensor x = phi::Empty<float>(dev_ctx, dims);
+  std::mt19937_64 rng(1);
+  std::uniform_real_distribution<float> distrib(-1.0, 1.0);
+  for (int64_t i = 0; i < x.numel(); i++) {
+    x.data<float>()[i] = distrib(rng);
+  }
+  return x;
+}
+
+template <typename Func>
+static double Measure(Func func) {
+  double best = 0;
+  for (int r = 0; r < FLAGS_repeat; r++) {
+    auto start = std::chrono::steady_clock::now();
+    func();
+    auto end = std::chrono::steady_clock::now();
+    double sec = std::chrono::duration<double>(end - start).count();
+    best = r == 0 ? sec : std::min(best, sec);
+  }
+  return best;
+}
+
+static int BenchmarkMain() {
+  phi::CPUContext dev_ctx;
+  dev_ctx.SetAllocator(paddle::memory::allocation::AllocatorFacade::Instance()
+                           .GetAllocator(paddle::platform::CPUPlace())
+                           .get());
+  dev_ctx.SetHostAllocator(
+      paddle::memory::allocation::AllocatorFacade::Instance()
+          .GetAllocator(paddle::platform::CPUPlace())
+          .get());
+  DenseTensor y = GenerateDense(dev_ctx, {FLAGS_cols, FLAGS_dense_cols});
+  DenseTensor x = GenerateDense(dev_ctx, {FLAGS_rows, FLAGS_dense_cols});
+  DenseTensor y_trans = GenerateDense(dev_ctx, {FLAGS_dense_cols, FLAGS_cols});
+  DenseTensor vec = GenerateDense(dev_ctx, {FLAGS_cols});
+
+  for (const std::string pattern : {"uniform", "power_law", "banded"}) {
+    SparseCsrTensor csr = GenerateCsr(dev_ctx, GeneratePattern(pattern));
+    LOG(INFO) << pattern << ": " << FLAGS_rows << "x" << FLAGS_cols
+              << " matrix of " << csr.nnz() << " nnz";
+    for (int thread_num = 1; thread_num <= FLAGS_max_threads;
+         thread_num *= 2) {
+#ifdef PADDLE_WITH_MKLML
+      omp_set_num_threads(thread_num);
+#else
+      if (thread_num > 1) {
+        LOG(WARNING) << "the sparse matmul is serial without PADDLE_WITH_MKLML";
+        break;
+      }
+#endif
+      double matmul_sec = Measure([&] {
+        DenseTensor out;
+        sparse::MatmulCsrDenseKernel<float, CPUContext>(
+            dev_ctx, csr, y, &out);
+      });
+      double masked_sec = Measure([&] {
+        SparseCsrTensor out;
+        sparse::MaskedMatmulCsrKernel<float, CPUContext>(
+            dev_ctx, x, y_trans, csr, &out);
+      });
+      double mv_sec = Measure([&] {
+        DenseTensor out;
+        sparse::MvCsrKernel<float, CPUContext>(dev_ctx, csr, vec, &out);
+      });
+      double flops = 2.0 * csr.nnz() * FLAGS_dense_cols;
+      LOG(INFO) << "threads " << thread_num << ": matmul "
+                << flops / matmul_sec / 1e9 << " GFLOPS, masked_matmul "
+                << flops / masked_sec / 1e9 << " GFLOPS, mv "
+                << mv_sec * 1e3 << " ms";
+    }
+  }
+  return 0;
+}
+
+}  // namespace tests
+}  // namespace phi
+
+int main(int argc, char* argv[]) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  google::InitGoogleLogging(argv[0]);
+  return phi::tests::BenchmarkMain();
+}
@@ -14,7 +14,10 @@ limitations under the License. */
 
 #include <gtest/gtest.h>
 
+#include <map>
 #include <memory>
+#include <random>
+#include <set>
 
 #include "paddle/fluid/memory/allocation/allocator_facade.h"
 #include "paddle/phi/api/lib/utils/allocator.h"
@@ -25,6 +28,7 @@ limitations under the License. */
 #include "paddle/phi/kernels/sparse/coalesce_kernel.h"
 #include "paddle/phi/kernels/sparse/conv_grad_kernel.h"
 #include "paddle/phi/kernels/sparse/conv_kernel.h"
+#include "paddle/phi/kernels/sparse/cpu/conv.h"
 
 namespace phi {
 namespace tests {
@@ -830,5 +834,130 @@ TEST(DEV_API, sparse_conv3d_subm) {
              true);
 }
 
+
+// Compare the rulebook of random points with the one of brute force, in
+// which the rules are ordered by kernel and then by input.
+template <typename IntT>
+void TestRulebookRandom(const bool subm, const std::vector<int>& strides) {
+  phi::CPUContext dev_ctx_cpu;
+  dev_ctx_cpu.SetAllocator(
+      paddle::memory::allocation::AllocatorFacade::Instance()
+          .GetAllocator(paddle::platform::CPUPlace())
+          .get());
+
+  const int non_zero_num = 20000;
+  const DDim x_dims = {2, 40, 40, 40, 1};
+  std::mt19937 rng(0);
+  std::set<std::vector<IntT>> points;
+  while (points.size() < static_cast<size_t>(non_zero_num)) {
+    points.insert({static_cast<IntT>(rng() % x_dims[0]),
+                   static_cast<IntT>(rng() % x_dims[1]),
+                   static_cast<IntT>(rng() % x_dims[2]),
+                   static_cast<IntT>(rng() % x_dims[3])});
+  }
+  DenseTensor indices = phi::Empty(
+      dev_ctx_cpu,
+      DenseTensorMeta(paddle::experimental::CppTypeToDataType<IntT>::Type(),
+                      {4, non_zero_num},
+                      DataLayout::NCHW));
+  IntT* indices_ptr = indices.data<IntT>();
+  int i = 0;
+  for (auto& point : points) {
+    for (int d = 0; d < 4; d++) {
+      indices_ptr[i + d * non_zero_num] = point[d];
+    }
+    i++;
+  }
+  DenseTensor values = phi::Empty(
+      dev_ctx_cpu,
+      DenseTensorMeta(DataType::FLOAT32, {non_zero_num, 1}, DataLayout::NCHW));
+  SparseCooTensor x_tensor(indices, values, x_dims);
+
+  const std::vector<int> kernel_sizes = {3, 3, 3, 1, 1};
+  const std::vector<int> paddings = {1, 1, 1};
+  const std::vector<int> dilations = {1, 1, 1};
+  DDim out_dims = {1, 1, 1, 1, 1};
+  phi::funcs::sparse::GetOutShape(
+      x_dims, kernel_sizes, paddings, dilations, strides, &out_dims);
+  const int kernel_size = 27;
+  std::vector<int> counter(kernel_size);
+  DenseTensor rulebook;
+  SparseCooTensor out;
+  sparse::ProductRuleBook<float, CPUContext, IntT>(dev_ctx_cpu,
+                                                   x_tensor,
+                                                   kernel_sizes,
+                                                   paddings,
+                                                   dilations,
+                                                   strides,
+                                                   out_dims,
+                                                   subm,
+                                                   &rulebook,
+                                                   counter.data());
+  sparse::UpdateRulebookAndOutIndex<float, CPUContext, IntT>(
+      dev_ctx_cpu, x_tensor, kernel_size, 1, out_dims, &rulebook, &out);
+
+  std::set<IntT> in_indexs;
+  for (int i = 0; i < non_zero_num; i++) {
+    in_indexs.insert(phi::funcs::sparse::PointToIndex<DDim>(
+        indices_ptr[i],
+        indices_ptr[i + 3 * non_zero_num],
+        indices_ptr[i + 2 * non_zero_num],
+        indices_ptr[i + non_zero_num],
+        x_dims));
+  }
+  std::vector<std::vector<IntT>> rules;
+  std::map<IntT, IntT> out_indexs;
+  int kernel_index = 0;
+  for (int kz = 0; kz < 3; kz++) {
+    for (int ky = 0; ky < 3; ky++) {
+      for (int kx = 0; kx < 3; kx++, kernel_index++) {
+        for (int i = 0; i < non_zero_num; i++) {
+          IntT z = indices_ptr[i + non_zero_num] + paddings[0] - kz;
+          IntT y = indices_ptr[i + 2 * non_zero_num] + paddings[1] - ky;
+          IntT x = indices_ptr[i + 3 * non_zero_num] + paddings[2] - kx;
+          if (z < 0 || y < 0 || x < 0 || z % strides[0] != 0 ||
+              y % strides[1] != 0 || x % strides[2] != 0) {
+            continue;
+          }
+          IntT out_z = z / strides[0];
+          IntT out_y = y / strides[1];
+          IntT out_x = x / strides[2];
+          if (out_z >= out_dims[1] || out_y >= out_dims[2] ||
+              out_x >= out_dims[3]) {
+            continue;
+          }
+          IntT out_index = phi::funcs::sparse::PointToIndex<DDim>(
+              indices_ptr[i], out_x, out_y, out_z, out_dims);
+          if (subm && in_indexs.count(out_index) == 0) {
+            continue;
+          }
+          rules.push_back({kernel_index, i, out_index});
+          out_indexs[out_index] = 0;
+        }
+      }
+    }
+  }
+  IntT rank = 0;
+  for (auto& item : out_indexs) {
+    item.second = rank++;
+  }
+
+  const int n = rulebook.dims()[1];
+  ASSERT_EQ(n, static_cast<int>(rules.size()));
+  ASSERT_EQ(out.nnz(), static_cast<int64_t>(out_indexs.size()));
+  const IntT* rulebook_ptr = rulebook.data<IntT>();
+  for (int i = 0; i < n; i++) {
+    ASSERT_EQ(rulebook_ptr[i], rules[i][0]);
+    ASSERT_EQ(rulebook_ptr[i + n], rules[i][1]);
+    ASSERT_EQ(rulebook_ptr[i + n * 2], out_indexs[rules[i][2]]);
+  }
+}
+
+TEST(DEV_API, sparse_conv3d_rulebook_random) {
+  TestRulebookRandom<int>(false, {1, 1, 1});
+  TestRulebookRandom<int>(false, {2, 2, 2});
+  TestRulebookRandom<int64_t>(true, {1, 1, 1});
+}
+
 }  // namespace tests
 }  // namespace phi
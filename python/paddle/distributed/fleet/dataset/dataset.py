@@ -141,6 +141,25 @@ class DatasetBase(object):
     def _set_input_type(self, input_type):
         self.proto_desc.input_type = input_type
 
+    def _set_binary_slot_record(self, binary_slot_record):
+        """
+        Set whether the files are in slot record binary format, which are
+        converted from text files by the slot_record_converter tool and are
+        loaded by SlotRecordInMemoryDataFeed without text parsing.
+        The pipe command does not apply to the binary files.
+
+        Examples:
+            .. code-block:: python
+
+              import paddle
+              dataset = paddle.distributed.fleet.DatasetBase()
+              dataset._set_binary_slot_record(True)
+
+        Args:
+            binary_slot_record(bool): whether the files are binary
+        """
+        self.proto_desc.binary_slot_record = binary_slot_record
+
     def _set_uid_slot(self, uid_slot):
         """
         Set user slot name.
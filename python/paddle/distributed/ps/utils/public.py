@@ -124,6 +124,12 @@ class TrainerRuntimeConfig(object):
             "FLAGS_communicator_send_wait_times", "5")
         self.runtime_configs['communicator_is_sgd_optimizer'] = os.getenv(
             "FLAGS_communicator_is_sgd_optimizer", "1")
+        self.runtime_configs['communicator_fuse_dense'] = os.getenv(
+            "FLAGS_communicator_fuse_dense", "0")
+        self.runtime_configs['communicator_dense_compress_type'] = os.getenv(
+            "FLAGS_communicator_dense_compress_type", "fp32")
+        self.runtime_configs['communicator_fuse_dense_bytes'] = os.getenv(
+            "FLAGS_communicator_fuse_dense_bytes", str(64 << 20))
 
     def get_communicator_flags(self):
         need_keys = []
@@ -137,7 +143,9 @@ class TrainerRuntimeConfig(object):
             need_keys = [
                 'communicator_max_merge_var_num',
                 'communicator_send_wait_times', 'communicator_thread_pool_size',
-                'communicator_send_queue_size'
+                'communicator_send_queue_size', 'communicator_fuse_dense',
+                'communicator_dense_compress_type',
+                'communicator_fuse_dense_bytes'
             ]
         elif self.mode == DistributedMode.GEO:
             mode_str = "GEO"
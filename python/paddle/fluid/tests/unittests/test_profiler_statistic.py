@@ -32,6 +32,7 @@ class HostPythonNode:
         self.runtime_node = []
         self.device_node = []
         self.mem_node = []
+        self.perf_counters = {}
 
 
 class DevicePythonNode:
@@ -580,6 +581,66 @@ class TestProfilerStatistic(unittest.TestCase):
                                                          thread_sep=False,
                                                          time_unit='ms'))
 
+    def test_statistic_case4(self):
+        # operators traced with the hardware counters
+        root_node = HostPythonNode('Root Node',
+                                   profiler.TracerEventType.UserDefined, 0,
+                                   float('inf'), 1000, 1001)
+        profilerstep_node = HostPythonNode('ProfileStep#1',
+                                           profiler.TracerEventType.ProfileStep,
+                                           0, 400, 1000, 1001)
+        matmul_node1 = HostPythonNode('matmul',
+                                      profiler.TracerEventType.Operator, 10,
+                                      110, 1000, 1001)
+        matmul_node1.perf_counters = {
+            'cycles': 1000,
+            'instructions': 3000,
+            'llc_misses': 10,
+            'dtlb_misses': 2
+        }
+        matmul_node2 = HostPythonNode('matmul',
+                                      profiler.TracerEventType.Operator, 120,
+                                      220, 1000, 1001)
+        matmul_node2.perf_counters = {
+            'cycles': 3000,
+            'instructions': 5000,
+            'llc_misses': 30,
+            'dtlb_misses': 4
+        }
+        # counters are unavailable on this call
+        matmul_node3 = HostPythonNode('matmul',
+                                      profiler.TracerEventType.Operator, 230,
+                                      330, 1000, 1001)
+        matmul_compute = HostPythonNode('matmul::compute',
+                                        profiler.TracerEventType.OperatorInner,
+                                        20, 100, 1000, 1001)
+        root_node.children_node.append(profilerstep_node)
+        profilerstep_node.children_node.extend(
+            [matmul_node1, matmul_node2, matmul_node3])
+        matmul_node1.children_node.append(matmul_compute)
+        thread_tree = {'thread1001': root_node}
+        extra_info = {
+            'Process Cpu Utilization': '1.02',
+            'System Cpu Utilization': '0.68'
+        }
+        statistic_data = profiler.profiler_statistic.StatisticData(
+            thread_tree, extra_info)
+        event_summary = statistic_data.event_summary
+        matmul_item = event_summary.items['matmul']
+        self.assertEqual(matmul_item.call, 3)
+        self.assertEqual(matmul_item.perf_call, 2)
+        self.assertEqual(matmul_item.perf_counters['cycles'], 4000)
+        self.assertEqual(matmul_item.perf_counters['instructions'], 8000)
+        table = profiler.profiler_statistic._build_table(
+            statistic_data,
+            sorted_by=profiler.SortedKeys.CPUTotal,
+            op_detail=True,
+            thread_sep=False,
+            time_unit='ms')
+        self.assertIn('Cycles / IPC / LLC Miss / dTLB Miss (Avg)', table)
+        self.assertIn('2000 / 2.00 / 20 / 3', table)
+        print(table)
+
 
 if __name__ == '__main__':
     unittest.main()
@@ -67,7 +67,7 @@ class TestAddmm(unittest.TestCase):
         sp_out = paddle.incubate.sparse.addmm(sp_input, sp_x, sp_y, 3.0, 2.0)
 
         self.assertTrue(np.allclose(sp_out.numpy(), dense_out.numpy()))
-        if get_cuda_version() >= 11030:
+        if paddle.get_device() == 'cpu' or get_cuda_version() >= 11030:
             dense_out.backward()
             sp_out.backward()
             self.assertTrue(
@@ -90,6 +90,15 @@ class TestAddmm(unittest.TestCase):
         self.check_result([8, 16, 10], [8, 16, 12], [8, 12, 10], 'coo')
         self.check_result([8, 16, 10], [8, 16, 12], [8, 12, 10], 'csr')
 
+    def test_addmm_cpu(self):
+        device = paddle.get_device()
+        paddle.set_device('cpu')
+        self.check_result([16, 10], [16, 12], [12, 10], 'coo')
+        self.check_result([16, 10], [16, 12], [12, 10], 'csr')
+        self.check_result([8, 16, 10], [8, 16, 12], [8, 12, 10], 'coo')
+        self.check_result([8, 16, 10], [8, 16, 12], [8, 12, 10], 'csr')
+        paddle.set_device(device)
+
 
 if __name__ == "__main__":
     unittest.main()
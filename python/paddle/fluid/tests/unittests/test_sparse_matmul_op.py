@@ -61,7 +61,7 @@ class TestMatmul(unittest.TestCase):
         sp_out = paddle.incubate.sparse.matmul(sp_x, sp_y)
 
         self.assertTrue(np.allclose(sp_out.numpy(), dense_out.numpy()))
-        if get_cuda_version() >= 11030:
+        if paddle.get_device() == 'cpu' or get_cuda_version() >= 11030:
             dense_out.backward()
             sp_out.backward()
             self.assertTrue(
@@ -82,13 +82,21 @@ class TestMatmul(unittest.TestCase):
         self.check_result([8, 16, 12], [8, 12, 10], 'coo')
         self.check_result([8, 16, 12], [8, 12, 10], 'csr')
 
+    def test_matmul_cpu(self):
+        device = paddle.get_device()
+        paddle.set_device('cpu')
+        self.check_result([16, 12], [12, 10], 'coo')
+        self.check_result([16, 12], [12, 10], 'csr')
+        self.check_result([8, 16, 12], [8, 12, 10], 'coo')
+        self.check_result([8, 16, 12], [8, 12, 10], 'csr')
+        # large enough to split the rows between threads
+        self.check_result([512, 256], [256, 64], 'csr')
+        paddle.set_device(device)
+
 
 class TestMaskedMatmul(unittest.TestCase):
     # x: dense, y: dense, out: sparse_`csr
-    @unittest.skipIf(not paddle.is_compiled_with_cuda()
-                     or get_cuda_version() < 11030,
-                     "only support on cuda>=11.3")
-    def test_masked_matmul_2d(self):
+    def check_result_2d(self):
         np_mask = np.random.rand(10, 6) < 0.2
 
         np_x = np.random.rand(10, 12)
@@ -115,6 +123,18 @@ class TestMaskedMatmul(unittest.TestCase):
         self.assertTrue(np.allclose(np_x_grad, x.grad.numpy()))
         self.assertTrue(np.allclose(np_y_grad, y.grad.numpy()))
 
+    @unittest.skipIf(not paddle.is_compiled_with_cuda()
+                     or get_cuda_version() < 11030,
+                     "only support on cuda>=11.3")
+    def test_masked_matmul_2d(self):
+        self.check_result_2d()
+
+    def test_masked_matmul_cpu(self):
+        device = paddle.get_device()
+        paddle.set_device('cpu')
+        self.check_result_2d()
+        paddle.set_device(device)
+
     @unittest.skipIf(not paddle.is_compiled_with_cuda()
                      or get_cuda_version() < 11070,
                      "only support on cuda>=11.7")
@@ -107,5 +107,47 @@ class TestCooMv(unittest.TestCase):
                 np.allclose(sp_vec.grad.numpy(), dense_vec.grad.numpy()))
 
 
+class TestCpuMv(unittest.TestCase):
+    # x: sparse-matrix, y: dense-vec, out: dense-vec
+    def check_result(self, format):
+        with _test_eager_guard():
+            paddle.set_default_dtype('float64')
+            origin_x = paddle.rand([64, 32])
+            mask = paddle.randint(0, 2, [64, 32])
+            origin_x = origin_x * mask
+            origin_vec = paddle.rand([32])
+
+            dense_x = origin_x.detach()
+            dense_x.stop_gradient = False
+            dense_vec = origin_vec.detach()
+            dense_vec.stop_gradient = False
+            dense_out = paddle.mv(dense_x, dense_vec)
+            dense_out.backward()
+
+            if format == "coo":
+                sp_x = origin_x.detach().to_sparse_coo(sparse_dim=2)
+            else:
+                sp_x = origin_x.detach().to_sparse_csr()
+            sp_x.stop_gradient = False
+            sp_vec = origin_vec.detach()
+            sp_vec.stop_gradient = False
+            sp_out = paddle.incubate.sparse.mv(sp_x, sp_vec)
+            sp_out.backward()
+
+            self.assertTrue(np.allclose(sp_out.numpy(), dense_out.numpy()))
+            self.assertTrue(
+                np.allclose(sp_x.grad.to_dense().numpy(),
+                            (dense_x.grad * mask).numpy()))
+            self.assertTrue(
+                np.allclose(sp_vec.grad.numpy(), dense_vec.grad.numpy()))
+
+    def test_mv(self):
+        device = paddle.get_device()
+        paddle.set_device('cpu')
+        self.check_result('coo')
+        self.check_result('csr')
+        paddle.set_device(device)
+
+
 if __name__ == "__main__":
     unittest.main()
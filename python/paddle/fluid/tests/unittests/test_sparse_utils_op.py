@@ -318,6 +318,30 @@ class TestSparseConvert(unittest.TestCase):
                     assert np.array_equal(values_sorted,
                                           sparse_x.values().numpy())
 
+    def test_sparse_coo_tensor_coalesce_random(self):
+        with _test_eager_guard():
+            paddle.device.set_device('cpu')
+            # many duplicates in random order, larger than one chunk of a
+            # thread
+            shape = [8, 64, 64]
+            nnz = 200000
+            indices = np.stack(
+                [np.random.randint(0, d, [nnz]) for d in shape])
+            values = np.random.rand(nnz, 2).astype('float64')
+            sparse_x = paddle.incubate.sparse.sparse_coo_tensor(
+                paddle.to_tensor(indices),
+                paddle.to_tensor(values),
+                shape=shape + [2])
+            sparse_x = paddle.incubate.sparse.coalesce(sparse_x)
+
+            flatten = np.ravel_multi_index(indices, shape)
+            unique, inverse = np.unique(flatten, return_inverse=True)
+            expect_values = np.zeros([len(unique), 2])
+            np.add.at(expect_values, inverse, values)
+            expect_indices = np.stack(np.unravel_index(unique, shape))
+            assert np.array_equal(expect_indices, sparse_x.indices().numpy())
+            assert np.allclose(expect_values, sparse_x.values().numpy())
+
     def test_batch_csr(self):
         with _test_eager_guard():
 
@@ -281,6 +281,8 @@ class Profiler:
             This callable object will be called when ``scheduler`` returns ``ProfilerState.RECORD_AND_RETURN``. The default value is :ref:`export_chrome_tracing <api_paddle_profiler_export_chrome_tracing>` (./profiler_log/).
         timer_only (bool, optional): If it is True, the cost of Dataloader and every step of the model will be count without profiling. Otherwise, the model will
             be timed and profiled. Default: False.
+        with_perf_counters (bool, optional): If it is True, the cycles, instructions, LLC misses and dTLB misses of every operator on CPU are read from
+            Linux perf_event and shown in the summary and the chrome trace. It is ignored with a warning if the counters are unavailable. Default: False.
 
     Examples:
         1. profiling range [2, 5).
@@ -398,7 +400,8 @@ class Profiler:
                  scheduler: Union[Callable[[int], ProfilerState], tuple,
                                   None] = None,
                  on_trace_ready: Optional[Callable[..., Any]] = None,
-                 timer_only: Optional[bool] = False):
+                 timer_only: Optional[bool] = False,
+                 with_perf_counters: Optional[bool] = False):
         supported_targets = _get_supported_targets()
         if targets:
             self.targets = set(targets)
@@ -416,6 +419,12 @@ class Profiler:
             profileoption.trace_switch |= (1 << 1)
         if ProfilerTarget.MLU in self.targets:
             profileoption.trace_switch |= (1 << 2)
+        if with_perf_counters and ProfilerTarget.CPU in self.targets:
+            if _Profiler.is_perf_event_supported():
+                profileoption.trace_switch |= (1 << 3)
+            else:
+                warn("Hardware performance counters are unavailable, "
+                     "with_perf_counters is ignored.")
         wrap_optimizers()
         self.profiler = _Profiler.create(profileoption)
         if callable(scheduler):
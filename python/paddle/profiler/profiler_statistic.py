@@ -373,6 +373,9 @@ class EventSummary:
             self.general_gpu_time = 0
             self.min_general_gpu_time = float('inf')
             self.max_general_gpu_time = 0
+            # hardware counters summed over perf_call calls
+            self.perf_counters = {}
+            self.perf_call = 0
 
         @property
         def avg_cpu_time(self):
@@ -407,6 +410,14 @@ class EventSummary:
                 self.min_general_gpu_time = time
             self.general_gpu_time += time
 
+        def add_perf_counters(self, perf_counters):
+            if not perf_counters:
+                return
+            self.perf_call += 1
+            for name, value in perf_counters.items():
+                self.perf_counters[name] = self.perf_counters.get(name,
+                                                                  0) + value
+
         def add_call(self):
             self.call += 1
 
@@ -415,6 +426,7 @@ class EventSummary:
             self.add_cpu_time(node.cpu_time)
             self.add_gpu_time(node.gpu_time)
             self.add_general_gpu_time(node.general_gpu_time)
+            self.add_perf_counters(getattr(node, 'perf_counters', None))
             for child in node.children_node:
                 if child.type != TracerEventType.Operator:
                     if child.name not in self.operator_inners:
@@ -746,6 +758,27 @@ def _build_table(statistic_data,
         """
         return '{}{:.2f}'.format(' ' * indent, ratio * 100)
 
+    def format_perf_counters(item):
+        r"""
+        Average cycles, IPC, LLC misses and dTLB misses of an operator call.
+        """
+        counters = item.perf_counters
+        if not counters:
+            return '- / - / - / -'
+
+        def format_avg(name):
+            if name not in counters:
+                return '-'
+            return '{:.0f}'.format(float(counters[name]) / item.perf_call)
+
+        ipc = '-'
+        if counters.get('cycles', 0) > 0 and 'instructions' in counters:
+            ipc = '{:.2f}'.format(
+                float(counters['instructions']) / counters['cycles'])
+        return '{} / {} / {} / {}'.format(format_avg('cycles'), ipc,
+                                          format_avg('llc_misses'),
+                                          format_avg('dtlb_misses'))
+
     total_time = statistic_data.time_range_summary.get_cpu_range_sum(
         TracerEventType.ProfileStep)
     ###### Print Device Summary ######
@@ -1096,6 +1129,10 @@ def _build_table(statistic_data,
             thread_items = {
                 'All threads merged': statistic_data.event_summary.items
             }
+        # Show the hardware counters if the operators are traced with them
+        with_perf_counters = any(
+            item.perf_counters for items in thread_items.values()
+            for item in items.values())
         for thread_id, items in thread_items.items():
             all_row_values.append("Thread: {}".format(thread_id))
             if sorted_by == SortedKeys.CPUTotal:
@@ -1158,6 +1195,8 @@ def _build_table(statistic_data,
                         format_time(item.min_general_gpu_time, unit=time_unit),
                         format_ratio(gpu_ratio))
                 ]
+                if with_perf_counters:
+                    row_values.append(format_perf_counters(item))
                 all_row_values.append(row_values)
                 if op_detail:
                     for innerop_name, innerop_node in item.operator_inners.items(
@@ -1198,6 +1237,9 @@ def _build_table(statistic_data,
                                             unit=time_unit),
                                 format_ratio(gpu_ratio))
                         ]
+                        if with_perf_counters:
+                            row_values.append(
+                                format_perf_counters(innerop_node))
                         all_row_values.append(row_values)
                         for device_node_name, device_node in innerop_node.devices.items(
                         ):
@@ -1226,6 +1268,8 @@ def _build_table(statistic_data,
                                                 unit=time_unit),
                                     format_ratio(gpu_ratio))
                             ]
+                            if with_perf_counters:
+                                row_values.append('- / - / - / -')
                             all_row_values.append(row_values)
                     for device_node_name, device_node in item.devices.items():
                         if item.general_gpu_time == 0:
@@ -1252,11 +1296,14 @@ def _build_table(statistic_data,
                                             unit=time_unit),
                                 format_ratio(gpu_ratio))
                         ]
+                        if with_perf_counters:
+                            row_values.append('- / - / - / -')
                         all_row_values.append(row_values)
         # Calculate the column width
         calltime_width = 6
         cpu_data_description_width = 40
         gpu_data_description_width = 40
+        perf_data_description_width = 41
         for row_values in all_row_values:
             if isinstance(row_values, str):
                 continue
@@ -1267,10 +1314,15 @@ def _build_table(statistic_data,
                 cpu_data_description_width = len(row_values[2])
             if len(row_values[3]) > gpu_data_description_width:
                 gpu_data_description_width = len(row_values[3])
+            if with_perf_counters and len(
+                    row_values[4]) > perf_data_description_width:
+                perf_data_description_width = len(row_values[4])
         headers = [
             'Name', 'Calls', 'CPU Total / Avg / Max / Min / Ratio(%)',
             'GPU Total / Avg / Max / Min / Ratio(%)'
         ]
+        if with_perf_counters:
+            headers.append('Cycles / IPC / LLC Miss / dTLB Miss (Avg)')
         row_format_list = [""]
         header_sep_list = [""]
         line_length_list = [-SPACING_SIZE]
@@ -1278,6 +1330,8 @@ def _build_table(statistic_data,
         add_column(calltime_width)
         add_column(cpu_data_description_width)
         add_column(gpu_data_description_width)
+        if with_perf_counters:
+            add_column(perf_data_description_width)
 
         row_format = row_format_list[0]
         header_sep = header_sep_list[0]